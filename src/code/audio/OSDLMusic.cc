@@ -188,6 +188,8 @@ Music::Music( const std::string & musicFilename, bool preload ) :
 	Audible( /* nothing loaded yet, hence not converted */ false ),
 	Ceylan::LoadableWithContent<LowLevelMusic>( musicFilename ),
 	 _dataStream( 0 ),
+	_inMemoryContent( 0 ),
+	_inMemorySize( 0 ),
 	_isPlaying( false )
 {
 
@@ -524,6 +526,16 @@ bool Music::unload()
 
 	_dataStream = 0 ;
 
+	// Only to be deallocated once the music does not stream from it anymore:
+	if ( _inMemoryContent != 0 )
+	{
+
+		delete [] _inMemoryContent ;
+		_inMemoryContent = 0 ;
+		_inMemorySize = 0 ;
+
+	}
+
 #else // OSDL_USES_SDL_MIXER
 
 	throw Ceylan::LoadableException(
@@ -543,6 +555,63 @@ bool Music::unload()
 
 
 
+bool Music::adoptContent( Ceylan::Byte * content, Size size )
+{
+
+#if OSDL_USES_SDL_MIXER && ! OSDL_ARCH_NINTENDO_DS
+
+	if ( hasContent() )
+	{
+
+		delete [] content ;
+		return false ;
+
+	}
+
+	// SDL_mixer frees the memory stream, not the content it reads:
+	_content = ::Mix_LoadMUS_RW( ::SDL_RWFromConstMem( content,
+		static_cast<int>( size ) ) ) ;
+
+	if ( _content == 0 )
+	{
+
+		delete [] content ;
+
+		throw Ceylan::LoadableException( "Music::adoptContent failed for '"
+			+ _contentPath + "': " + string( ::Mix_GetError() ) ) ;
+
+	}
+
+	_inMemoryContent = content ;
+	_inMemorySize    = size ;
+
+	_convertedToOutputFormat = true ;
+
+	return true ;
+
+#else // OSDL_USES_SDL_MIXER && ! OSDL_ARCH_NINTENDO_DS
+
+	delete [] content ;
+
+	throw Ceylan::LoadableException( "Music::adoptContent failed: "
+		"not supported on this platform." ) ;
+
+#endif // OSDL_USES_SDL_MIXER && ! OSDL_ARCH_NINTENDO_DS
+
+}
+
+
+
+Size Music::getSizeInMemory() const
+{
+
+	return _inMemorySize ;
+
+}
+
+
+
+
 // Audible implementation.
 
 
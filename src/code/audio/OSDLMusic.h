@@ -439,6 +439,45 @@ namespace OSDL
 
 
 
+				/**
+				 * Loads this music from the specified in-memory copy of its
+				 * file, already read by other means (ex: by a prefetching
+				 * worker), instead of streaming it from that file.
+				 *
+				 * Only the opening of the music is performed here; the copy
+				 * is then kept, and streamed from, until the music is
+				 * unloaded.
+				 *
+				 * @param content the content of the music file, allocated
+				 * with new [], whose ownership is taken.
+				 *
+				 * @param size the size of this content, in bytes.
+				 *
+				 * @return true iff the content was adopted; if this music was
+				 * already loaded, it is kept, and the specified content is
+				 * deallocated.
+				 *
+				 * @throw Ceylan::LoadableException if the music could not be
+				 * opened from that content, or if not supported on this
+				 * platform.
+				 *
+				 */
+				virtual bool adoptContent( Ceylan::Byte * content,
+					Ceylan::System::Size size ) ;
+
+
+
+				/**
+				 * Returns the size in memory, in bytes, of the in-memory copy
+				 * of the file of this music, if it was loaded from one (see
+				 * adoptContent), otherwise zero, as streamed musics only
+				 * hold small buffers.
+				 *
+				 */
+				virtual Ceylan::System::Size getSizeInMemory() const ;
+
+
+
 
 				// Audible implementation.
 
@@ -831,6 +870,19 @@ namespace OSDL
 
 
 
+				/**
+				 * The in-memory copy of the music file this music is streamed
+				 * from, if it was loaded from one (owned), otherwise null.
+				 *
+				 */
+				Ceylan::Byte * _inMemoryContent ;
+
+
+				/// The size of the in-memory copy, in bytes.
+				Ceylan::System::Size _inMemorySize ;
+
+
+
 				/// Tells whether this music is being played.
 				bool _isPlaying ;
 
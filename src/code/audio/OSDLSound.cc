@@ -424,6 +424,36 @@ bool Sound::load()
 
 
 
+bool Sound::adoptContent( LowLevelSound & decodedSound )
+{
+
+#if OSDL_USES_SDL_MIXER && ! OSDL_ARCH_NINTENDO_DS
+
+	if ( hasContent() )
+	{
+
+		::Mix_FreeChunk( & decodedSound ) ;
+		return false ;
+
+	}
+
+	_content = & decodedSound ;
+
+	_convertedToOutputFormat = true ;
+
+	return true ;
+
+#else // OSDL_USES_SDL_MIXER && ! OSDL_ARCH_NINTENDO_DS
+
+	throw SoundException( "Sound::adoptContent failed: "
+		"not supported on this platform." ) ;
+
+#endif // OSDL_USES_SDL_MIXER && ! OSDL_ARCH_NINTENDO_DS
+
+}
+
+
+
 bool Sound::unload()
 {
 
@@ -496,6 +526,34 @@ bool Sound::unload()
 
 
 
+Ceylan::System::Size Sound::getSizeInMemory() const
+{
+
+	if ( ! hasContent() )
+		return 0 ;
+
+#if OSDL_ARCH_NINTENDO_DS
+
+	return _content->_size ;
+
+#else // OSDL_ARCH_NINTENDO_DS
+
+#if OSDL_USES_SDL_MIXER
+
+	return _content->alen ;
+
+#else // OSDL_USES_SDL_MIXER
+
+	return 0 ;
+
+#endif // OSDL_USES_SDL_MIXER
+
+#endif // OSDL_ARCH_NINTENDO_DS
+
+}
+
+
+
 
 
 // Audible implementation.
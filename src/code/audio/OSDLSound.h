@@ -225,6 +225,38 @@ namespace OSDL
 
 
 
+				/**
+				 * Sets the content of this sound to the specified one,
+				 * already decoded from the file of this sound by other means
+				 * (ex: by a prefetching worker), so that load has nothing left
+				 * to do.
+				 *
+				 * @param decodedSound the decoded sound, in the output format
+				 * of the mixer, whose ownership is taken.
+				 *
+				 * @return true iff the content was adopted; if this sound was
+				 * already loaded, its content is kept, and the specified one
+				 * is deallocated.
+				 *
+				 * @throw SoundException if not supported on this platform.
+				 *
+				 */
+				virtual bool adoptContent( LowLevelSound & decodedSound ) ;
+
+
+
+				/**
+				 * Returns the size in memory, in bytes, of the samples of
+				 * this sound, as decoded when loaded.
+				 *
+				 * @return the size of the samples, or zero if the sound is
+				 * not loaded.
+				 *
+				 */
+				virtual Ceylan::System::Size getSizeInMemory() const ;
+
+
+
 
 				// Audible implementation.
 
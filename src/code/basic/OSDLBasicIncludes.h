@@ -37,6 +37,7 @@
 
 #include "OSDLBasic.h"
 #include "OSDLCDROMDrive.h"
+#include "OSDLContentSpan.h"
 #include "OSDLEmbeddedDirectory.h"
 #include "OSDLEmbeddedFile.h"
 #include "OSDLEmbeddedFileSystemManager.h"
@@ -44,9 +45,12 @@
 #include "OSDLFileTags.h"
 #include "OSDLGUI.h"
 #include "OSDLHeaderVersion.h"
+#include "OSDLIndexedArchive.h"
+#include "OSDLPooledAllocator.h"
 #include "OSDLTestException.h"
 #include "OSDLTypes.h"
 #include "OSDLUtils.h"
+#include "OSDLWorkerPool.h"
 
 
 #endif // OSDL_BASIC_INCLUDES_H_
@@ -0,0 +1,578 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDLContentSpan.h"
+
+#include "OSDLEmbeddedFile.h"               // for EmbeddedFile
+#include "OSDLEmbeddedFileSystemManager.h"  // for getActualLocationFor
+#include "OSDLUtils.h"                      // for readLittleEndianUint32
+
+
+#ifdef OSDL_USES_CONFIG_H
+#include "OSDLConfig.h"              // for configure-time settings
+#endif // OSDL_USES_CONFIG_H
+
+#if OSDL_ARCH_NINTENDO_DS
+#include "OSDLConfigForNintendoDS.h" // for OSDL_USES_PHYSICSFS and al
+#endif // OSDL_ARCH_NINTENDO_DS
+
+
+#if OSDL_USES_PHYSICSFS
+#include "physfs.h"                  // for PHYSFS_getMountPoint
+#endif // OSDL_USES_PHYSICSFS
+
+
+#include <vector>
+
+
+// No mmap on Windows, nor on the DS:
+#if ! defined(OSDL_RUNS_ON_WINDOWS) && ! OSDL_ARCH_NINTENDO_DS
+
+#define OSDL_MAPS_CONTENT_SPANS 1
+
+#include <sys/mman.h>                // for mmap, munmap
+#include <sys/stat.h>                // for fstat, stat
+#include <fcntl.h>                   // for open
+#include <unistd.h>                  // for pread, close, sysconf
+
+#endif // ! defined(OSDL_RUNS_ON_WINDOWS) && ! OSDL_ARCH_NINTENDO_DS
+
+
+
+using namespace OSDL ;
+
+using namespace Ceylan::System ;
+
+using std::string ;
+
+using OSDL::Utils::readLittleEndianUint16 ;
+using OSDL::Utils::readLittleEndianUint32 ;
+
+
+
+/*
+ * Implementation notes:
+ *
+ * Members of zip archives are located thanks to the central directory of the
+ * archive, which is read each time a span is created: spans are meant for
+ * sizeable contents, for which this look-up is negligible compared to a
+ * decompression or a copy.
+ *
+ * ZIP64 archives are not supported (their members are read instead).
+ *
+ */
+
+
+
+#if OSDL_MAPS_CONTENT_SPANS
+
+
+/// Reads exactly the specified number of bytes at the specified offset.
+static bool ReadAt( int descriptor, Ceylan::Byte * buffer, Size length,
+	off_t offset )
+{
+
+	while ( length > 0 )
+	{
+
+		ssize_t count = ::pread( descriptor, buffer, length, offset ) ;
+
+		if ( count <= 0 )
+			return false ;
+
+		buffer += count ;
+		length -= count ;
+		offset += count ;
+
+	}
+
+	return true ;
+
+}
+
+
+
+/**
+ * Finds the specified member in the specified zip archive.
+ *
+ * @return true iff the member is stored uncompressed and unencrypted, with
+ * the expected size; then its offset in archive is set.
+ *
+ */
+static bool FindStoredZipMember( const string & archivePath,
+	const string & memberName, Size expectedSize, Size & offset )
+{
+
+	// Sizes of the fixed parts of the zip records:
+	const Size EndRecordSize     = 22 ;
+	const Size CentralHeaderSize = 46 ;
+	const Size LocalHeaderSize   = 30 ;
+
+	int descriptor = ::open( archivePath.c_str(), O_RDONLY ) ;
+
+	if ( descriptor == -1 )
+		return false ;
+
+	bool found = false ;
+
+	struct stat archiveStat ;
+
+	if ( ::fstat( descriptor, & archiveStat ) == 0
+		&& archiveStat.st_size >= static_cast<off_t>( EndRecordSize ) )
+	{
+
+		Size archiveSize = static_cast<Size>( archiveStat.st_size ) ;
+
+		// The end record is followed by a comment of up to 65535 bytes:
+		Size tailSize = EndRecordSize + 65535 ;
+
+		if ( tailSize > archiveSize )
+			tailSize = archiveSize ;
+
+		std::vector<Ceylan::Byte> tail( tailSize ) ;
+
+		Size endRecord = tailSize ;
+
+		if ( ReadAt( descriptor, & tail[0], tailSize,
+				archiveSize - tailSize ) )
+			for ( Size i = tailSize - EndRecordSize + 1; i > 0; i-- )
+				if ( readLittleEndianUint32( & tail[i-1] ) == 0x06054b50 )
+				{
+
+					endRecord = i - 1 ;
+					break ;
+
+				}
+
+		Size directorySize = 0 ;
+		Size directoryOffset = 0 ;
+		Size entryCount = 0 ;
+
+		if ( endRecord != tailSize )
+		{
+
+			entryCount      = readLittleEndianUint16( & tail[endRecord + 10] ) ;
+			directorySize   = readLittleEndianUint32( & tail[endRecord + 12] ) ;
+			directoryOffset = readLittleEndianUint32( & tail[endRecord + 16] ) ;
+
+		}
+
+		std::vector<Ceylan::Byte> directory( directorySize ) ;
+
+		if ( directorySize != 0 && directoryOffset <= archiveSize
+			&& directorySize <= archiveSize - directoryOffset
+			&& ReadAt( descriptor, & directory[0], directorySize,
+				directoryOffset ) )
+		{
+
+			Size current = 0 ;
+
+			for ( Size i = 0; i < entryCount
+					&& current + CentralHeaderSize <= directorySize; i++ )
+			{
+
+				const Ceylan::Byte * header = & directory[current] ;
+
+				if ( readLittleEndianUint32( header ) != 0x02014b50 )
+					break ;
+
+				Size nameLength    = readLittleEndianUint16( header + 28 ) ;
+				Size extraLength   = readLittleEndianUint16( header + 30 ) ;
+				Size commentLength = readLittleEndianUint16( header + 32 ) ;
+
+				if ( current + CentralHeaderSize + nameLength > directorySize )
+					break ;
+
+				if ( memberName.size() == nameLength
+					&& memberName.compare( 0, nameLength,
+						reinterpret_cast<const char *>(
+							header + CentralHeaderSize ), nameLength ) == 0 )
+				{
+
+					Ceylan::Uint16 flags = readLittleEndianUint16(
+						header + 8 ) ;
+
+					Ceylan::Uint16 method = readLittleEndianUint16(
+						header + 10 ) ;
+
+					Size storedSize = readLittleEndianUint32( header + 20 ) ;
+					Size fullSize   = readLittleEndianUint32( header + 24 ) ;
+
+					Size localOffset = readLittleEndianUint32( header + 42 ) ;
+
+					Ceylan::Byte local[ LocalHeaderSize ] ;
+
+					// Method 0 is 'stored', flag 1 tells it is encrypted:
+					if ( method == 0 && ( flags & 1 ) == 0
+						&& storedSize == expectedSize
+						&& fullSize == expectedSize
+						&& ReadAt( descriptor, local, LocalHeaderSize,
+							localOffset )
+						&& readLittleEndianUint32( local ) == 0x04034b50 )
+					{
+
+						// The local header has its own name and extra fields:
+						Size dataOffset = localOffset + LocalHeaderSize
+							+ readLittleEndianUint16( local + 26 )
+							+ readLittleEndianUint16( local + 28 ) ;
+
+						if ( dataOffset <= archiveSize
+							&& expectedSize <= archiveSize - dataOffset )
+						{
+
+							offset = dataOffset ;
+							found = true ;
+
+						}
+
+					}
+
+					break ;
+
+				}
+
+				current += CentralHeaderSize + nameLength + extraLength
+					+ commentLength ;
+
+			}
+
+		}
+
+	}
+
+	::close( descriptor ) ;
+
+	return found ;
+
+}
+
+
+
+/**
+ * Determines where the content of the specified file lies in the actual
+ * filesystem, if it can be mapped.
+ *
+ * @return true iff the content lies as is in the actual file whose path is
+ * set, at the set offset.
+ *
+ * @note Cyphered contents are never located, as decyphering them in a
+ * private mapping would copy all their pages: they are read instead.
+ *
+ */
+static bool LocateContent( const string & filename, File & file, Size size,
+	string & actualPath, Size & offset )
+{
+
+	EmbeddedFile * embeddedFile = dynamic_cast<EmbeddedFile *>( & file ) ;
+
+	if ( embeddedFile == 0 )
+	{
+
+		// A standard file, mapped as is:
+		actualPath = filename ;
+		offset     = 0 ;
+
+		return true ;
+
+	}
+
+#if OSDL_USES_PHYSICSFS
+
+	// As opened, without creating a manager: cyphered bytes are never mapped.
+	if ( embeddedFile->isCyphered() )
+		return false ;
+
+	string location ;
+
+	try
+	{
+
+		EmbeddedFileSystemManager & manager =
+			EmbeddedFileSystemManager::GetEmbeddedFileSystemManager() ;
+
+		location = manager.getActualLocationFor( filename ) ;
+
+	}
+	catch( const Ceylan::Exception & )
+	{
+
+		return false ;
+
+	}
+
+	// Names are always encoded in the embedded filesystem, even uncyphered:
+	string memberName = Ceylan::encodeToROT13( filename ) ;
+
+	const char * mountPoint = ::PHYSFS_getMountPoint( location.c_str() ) ;
+
+	if ( mountPoint != 0 )
+	{
+
+		string prefix( mountPoint ) ;
+
+		if ( ! prefix.empty() && prefix[0] == '/' )
+			prefix.erase( 0, 1 ) ;
+
+		if ( memberName.compare( 0, prefix.size(), prefix ) == 0 )
+			memberName.erase( 0, prefix.size() ) ;
+
+	}
+
+	struct stat locationStat ;
+
+	if ( ::stat( location.c_str(), & locationStat ) != 0 )
+		return false ;
+
+	if ( S_ISDIR( locationStat.st_mode ) )
+	{
+
+		// Mounted directory, the file is there as is:
+		actualPath = location + "/" + memberName ;
+		offset     = 0 ;
+
+		return true ;
+
+	}
+
+	actualPath = location ;
+
+	return FindStoredZipMember( location, memberName, size, offset ) ;
+
+#else // OSDL_USES_PHYSICSFS
+
+	return false ;
+
+#endif // OSDL_USES_PHYSICSFS
+
+}
+
+
+#endif // OSDL_MAPS_CONTENT_SPANS
+
+
+
+
+ContentSpanException::ContentSpanException( const string & reason ) :
+	OSDL::Exception( reason )
+{
+
+}
+
+
+
+ContentSpanException::~ContentSpanException() throw()
+{
+
+}
+
+
+
+
+
+ContentSpan::ContentSpan( const string & filename ) :
+	_filename( filename ),
+	_data( 0 ),
+	_size( 0 ),
+	_mapping( 0 ),
+	_mappingSize( 0 )
+{
+
+	Ceylan::Byte * buffer = 0 ;
+
+	try
+	{
+
+		File & file = File::Open( filename ) ;
+
+		try
+		{
+
+			_size = file.size() ;
+
+#if OSDL_MAPS_CONTENT_SPANS
+
+			string actualPath ;
+			Size offset = 0 ;
+
+			// Empty contents cannot be mapped:
+			if ( _size != 0 && LocateContent( filename, file, _size,
+					actualPath, offset ) )
+				mapRegion( actualPath, offset ) ;
+
+#endif // OSDL_MAPS_CONTENT_SPANS
+
+			if ( _mapping == 0 )
+			{
+
+				// Embedded files are decyphered when read:
+				buffer = new Ceylan::Byte[ _size ] ;
+				file.readExactLength( buffer, _size ) ;
+
+				_data = buffer ;
+
+			}
+
+		}
+		catch( ... )
+		{
+
+			delete & file ;
+			throw ;
+
+		}
+
+		delete & file ;
+
+	}
+	catch( const Ceylan::Exception & e )
+	{
+
+		delete [] buffer ;
+
+		throw ContentSpanException( "ContentSpan constructor failed for '"
+			+ filename + "': " + e.toString() ) ;
+
+	}
+
+}
+
+
+
+ContentSpan::~ContentSpan() throw()
+{
+
+#if OSDL_MAPS_CONTENT_SPANS
+
+	if ( _mapping != 0 )
+	{
+
+		::munmap( _mapping, _mappingSize ) ;
+		return ;
+
+	}
+
+#endif // OSDL_MAPS_CONTENT_SPANS
+
+	delete [] _data ;
+
+}
+
+
+
+const Ceylan::Byte * ContentSpan::getData() const
+{
+
+	return _data ;
+
+}
+
+
+
+Size ContentSpan::getSize() const
+{
+
+	return _size ;
+
+}
+
+
+
+bool ContentSpan::isMapped() const
+{
+
+	return ( _mapping != 0 ) ;
+
+}
+
+
+
+const string ContentSpan::toString( Ceylan::VerbosityLevels level ) const
+{
+
+	return "Span of the " + Ceylan::toString( _size ) + " bytes of '"
+		+ _filename + "', " + ( isMapped() ? "memory-mapped" : "read" ) ;
+
+}
+
+
+
+
+// Protected section.
+
+
+
+bool ContentSpan::mapRegion( const string & actualPath, Size offset )
+{
+
+#if OSDL_MAPS_CONTENT_SPANS
+
+	int descriptor = ::open( actualPath.c_str(), O_RDONLY ) ;
+
+	if ( descriptor == -1 )
+		return false ;
+
+	// Mapping past the end of the file would crash at the first access:
+	struct stat actualStat ;
+
+	if ( ::fstat( descriptor, & actualStat ) != 0
+		|| static_cast<Size>( actualStat.st_size ) < offset
+		|| static_cast<Size>( actualStat.st_size ) - offset < _size )
+	{
+
+		::close( descriptor ) ;
+		return false ;
+
+	}
+
+	// Mappings start on a page boundary:
+	Size pageSize = static_cast<Size>( ::sysconf( _SC_PAGESIZE ) ) ;
+
+	Size alignedOffset = offset - offset % pageSize ;
+
+	Size delta = offset - alignedOffset ;
+
+	void * mapping = ::mmap( 0, _size + delta, PROT_READ, MAP_PRIVATE,
+		descriptor, alignedOffset ) ;
+
+	// The mapping remains valid once the descriptor is closed:
+	::close( descriptor ) ;
+
+	if ( mapping == MAP_FAILED )
+		return false ;
+
+	_mapping     = mapping ;
+	_mappingSize = _size + delta ;
+	_data        = static_cast<const Ceylan::Byte *>( mapping ) + delta ;
+
+	return true ;
+
+#else // OSDL_MAPS_CONTENT_SPANS
+
+	return false ;
+
+#endif // OSDL_MAPS_CONTENT_SPANS
+
+}
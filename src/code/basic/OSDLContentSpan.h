@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#ifndef OSDL_CONTENT_SPAN_H_
+#define OSDL_CONTENT_SPAN_H_
+
+
+#include "OSDLException.h"   // for OSDL::Exception
+
+#include "Ceylan.h"          // for inheritance, Byte, Size
+
+#include <string>
+
+
+
+
+namespace OSDL
+{
+
+
+
+	/// Exception raised when the content of a file cannot be spanned.
+	class OSDL_DLL ContentSpanException : public OSDL::Exception
+	{
+
+		public:
+
+			explicit ContentSpanException( const std::string & reason ) ;
+
+			virtual ~ContentSpanException() throw() ;
+
+	} ;
+
+
+
+	/**
+	 * Read-only view on the whole content of a file, meant to be parsed in
+	 * place by the loaders of raw formats (sounds, palettes, frames, etc.).
+	 *
+	 * Whenever possible, the content is memory-mapped rather than read:
+	 *
+	 *  - a standard file is mapped as is, read-only (zero copy)
+	 *
+	 *  - an embedded file found in a mounted directory, or stored without
+	 * compression in a zip archive, is mapped directly from that file or
+	 * archive (zero copy as well), provided cyphering is disabled
+	 *
+	 * Otherwise (cyphered embedded files, compressed members, platforms
+	 * without mmap, such as Windows and the Nintendo DS), the content is read
+	 * once into a buffer owned by the span, which is as costly as a plain
+	 * read. Cyphered contents are never mapped: decyphering a private mapping
+	 * would have the kernel copy each of its pages, on top of the fault
+	 * handling, so only non-cyphered content is zero-copy.
+	 *
+	 * The file is referenced by its name, as given to File::Open, and is
+	 * looked-up by the current default filesystem manager.
+	 *
+	 * @note Spans do not share their mappings: a span is meant to be kept
+	 * only while its content is being parsed.
+	 *
+	 */
+	class OSDL_DLL ContentSpan : public Ceylan::TextDisplayable
+	{
+
+
+		public:
+
+
+
+			/**
+			 * Creates a view on the content of specified file.
+			 *
+			 * @param filename the name of the file, as given to File::Open.
+			 *
+			 * @throw ContentSpanException if the file could not be opened,
+			 * mapped nor read.
+			 *
+			 */
+			explicit ContentSpan( const std::string & filename ) ;
+
+
+
+			/// Virtual destructor, releasing the mapping or the buffer.
+			virtual ~ContentSpan() throw() ;
+
+
+
+			/**
+			 * Returns the first byte of the content.
+			 *
+			 * @note Valid as long as this span exists.
+			 *
+			 */
+			const Ceylan::Byte * getData() const ;
+
+
+
+			/// Returns the size of the content, in bytes.
+			Ceylan::System::Size getSize() const ;
+
+
+
+			/**
+			 * Tells whether the content is memory-mapped (true), or was read
+			 * into a buffer (false).
+			 *
+			 */
+			bool isMapped() const ;
+
+
+
+			/**
+			 * Returns an user-friendly description of the state of this object.
+			 *
+			 * @param level the requested verbosity level.
+			 *
+			 * @note Text output format is determined from overall settings.
+			 *
+			 * @see TextDisplayable
+			 *
+			 */
+			virtual const std::string toString(
+				Ceylan::VerbosityLevels level = Ceylan::high ) const ;
+
+
+
+
+		protected:
+
+
+
+			/**
+			 * Maps, read-only, specified region of specified actual file.
+			 *
+			 * @return true iff the region could be mapped.
+			 *
+			 */
+			bool mapRegion( const std::string & actualPath,
+				Ceylan::System::Size offset ) ;
+
+
+
+			/// The name of the spanned file.
+			std::string _filename ;
+
+
+			/// The first byte of the content.
+			const Ceylan::Byte * _data ;
+
+
+			/// The size of the content, in bytes.
+			Ceylan::System::Size _size ;
+
+
+			/**
+			 * The start of the mapping (page-aligned, hence possibly before
+			 * _data), or null if the content was read into a buffer.
+			 *
+			 */
+			void * _mapping ;
+
+
+			/// The size of the mapping, in bytes.
+			Ceylan::System::Size _mappingSize ;
+
+
+
+
+		private:
+
+
+
+			/**
+			 * Copy constructor made private to ensure that it will never be
+			 * called.
+			 *
+			 * The compiler should complain whenever this undefined constructor
+			 * is called, implicitly or not.
+			 *
+			 */
+			explicit ContentSpan( const ContentSpan & source ) ;
+
+
+
+			/**
+			 * Assignment operator made private to ensure that it will never be
+			 * called.
+			 *
+			 * The compiler should complain whenever this undefined operator is
+			 * called, implicitly or not.
+			 *
+			 */
+			ContentSpan & operator = ( const ContentSpan & source ) ;
+
+
+	} ;
+
+
+}
+
+
+
+#endif // OSDL_CONTENT_SPAN_H_
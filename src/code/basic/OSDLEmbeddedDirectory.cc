@@ -120,6 +120,15 @@ bool EmbeddedDirectory::hasDirectory( const string & subdirectoryName ) const
 
   string tmpPath = fsManager->joinPath( _path, subdirectoryName ) ;
 
+  const EmbeddedFileSystemManager & embeddedManager =
+	EmbeddedFileSystemManager::GetEmbeddedFileSystemManager() ;
+
+  EmbeddedFileSystemManager::IndexedEntryKind kind =
+	embeddedManager.lookupIndexedEntry( tmpPath ) ;
+
+  if ( kind != EmbeddedFileSystemManager::NotIndexed )
+	return ( kind == EmbeddedFileSystemManager::IndexedDirectory ) ;
+
   return ( PHYSFS_isDirectory( tmpPath.c_str() ) != 0 ) ;
 
 #else // OSDL_USES_PHYSICSFS
@@ -158,6 +167,15 @@ bool EmbeddedDirectory::hasFile( const string & fileName ) const
 
   string tmpPath = fsManager->joinPath( _path, fileName ) ;
 
+  const EmbeddedFileSystemManager & embeddedManager =
+	EmbeddedFileSystemManager::GetEmbeddedFileSystemManager() ;
+
+  EmbeddedFileSystemManager::IndexedEntryKind kind =
+	embeddedManager.lookupIndexedEntry( tmpPath ) ;
+
+  if ( kind != EmbeddedFileSystemManager::NotIndexed )
+	return ( kind == EmbeddedFileSystemManager::IndexedFile ) ;
+
   if ( PHYSFS_exists( tmpPath.c_str() ) == 0 )
 	return false ;
 
@@ -198,6 +216,15 @@ bool EmbeddedDirectory::hasEntry( const string & entryName ) const
 
   string tmpPath = fsManager->joinPath( _path, entryName ) ;
 
+  const EmbeddedFileSystemManager & embeddedManager =
+	EmbeddedFileSystemManager::GetEmbeddedFileSystemManager() ;
+
+  EmbeddedFileSystemManager::IndexedEntryKind kind =
+	embeddedManager.lookupIndexedEntry( tmpPath ) ;
+
+  if ( kind != EmbeddedFileSystemManager::NotIndexed )
+	return ( kind != EmbeddedFileSystemManager::NoEntry ) ;
+
   return ( PHYSFS_exists( tmpPath.c_str() ) != 0 ) ;
 
 #else // OSDL_USES_PHYSICSFS
@@ -231,6 +258,12 @@ void EmbeddedDirectory::getFiles( list<string> & files ) const
 
 #if OSDL_USES_PHYSICSFS
 
+  const EmbeddedFileSystemManager & embeddedManager =
+	EmbeddedFileSystemManager::GetEmbeddedFileSystemManager() ;
+
+  if ( embeddedManager.getIndexedEntries( _path, files ) )
+	return ;
+
   char **rc = PHYSFS_enumerateFiles( _path.c_str() ) ;
 
   char **i ;
@@ -257,6 +290,12 @@ void EmbeddedDirectory::getEntries( list<string> & entries ) const
 
 #if OSDL_USES_PHYSICSFS
 
+  const EmbeddedFileSystemManager & embeddedManager =
+	EmbeddedFileSystemManager::GetEmbeddedFileSystemManager() ;
+
+  if ( embeddedManager.getIndexedEntries( _path, entries ) )
+	return ;
+
   char **rc = PHYSFS_enumerateFiles( _path.c_str() ) ;
 
   char **i ;
@@ -350,6 +389,11 @@ EmbeddedDirectory::EmbeddedDirectory( const string & directoryName,
 		"EmbeddedDirectory constructor failed: "
 		+ EmbeddedFileSystemManager::GetBackendLastError() ) ;
 
+	EmbeddedFileSystemManager & embeddedManager =
+	  EmbeddedFileSystemManager::GetEmbeddedFileSystemManager() ;
+
+	embeddedManager.declareTreeModification() ;
+
   }
 
 #else // OSDL_USES_PHYSICSFS
@@ -50,9 +50,31 @@
 
 
 #include <cstring>                   // for ::memcpy
+#include <algorithm>                 // for std::min
 //#include <cstdint>                 // for uintptr_t
 
 
+/*
+ * The cyphering kernels process whole vectors when the target provides them
+ * (AVX2 only if enabled at compile-time, SSE2 is always there on x86-64), then
+ * native words, and finally the few remaining bytes.
+ *
+ */
+#if defined(__AVX2__)
+#define OSDL_CYPHERS_WITH_AVX2 1
+#include <immintrin.h>               // for _mm256_add_epi8 and al
+#endif // __AVX2__
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+  ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#define OSDL_CYPHERS_WITH_SSE2 1
+#include <emmintrin.h>               // for _mm_add_epi8 and al
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define OSDL_CYPHERS_WITH_NEON 1
+#include <arm_neon.h>                // for vaddq_u8 and al
+#endif // __SSE2__
+
+
 
 /*
  * Implementation notes.
@@ -82,6 +104,208 @@ using namespace OSDL ;
 
 
 
+/*
+ * Cyphering helpers.
+ *
+ * The transformation is byte-wise (cyphered = ( clear ^ XORByte ) + 117,
+ * modulo 256), hence a native word can be processed at once, provided that
+ * the carries of the additions (and the borrows of the subtractions) do not
+ * propagate from a byte to the next one.
+ *
+ */
+
+
+// A native register, 64-bit on most desktop platforms, 32-bit on the DS:
+typedef unsigned long CypherWord ;
+
+
+// The seven lowest bits of each byte of a word (ex: 0x7f7f7f7f):
+const CypherWord LowBitsOfBytes = ~ static_cast<CypherWord>( 0 ) / 0xff * 0x7f ;
+
+// The highest bit of each byte of a word (ex: 0x80808080):
+const CypherWord HighBitOfBytes = ~ static_cast<CypherWord>( 0 ) / 0xff * 0x80 ;
+
+
+// The offset added to each cyphered byte:
+const Ceylan::Byte CypherOffset = 117 ;
+
+
+
+/// Adds, byte per byte, the two specified words, without carry propagation.
+inline CypherWord AddBytesOf( CypherWord first, CypherWord second )
+{
+
+  return ( ( first & LowBitsOfBytes ) + ( second & LowBitsOfBytes ) )
+	^ ( ( first ^ second ) & HighBitOfBytes ) ;
+
+}
+
+
+
+/// Subtracts, byte per byte, the second word to the first one, without borrow.
+inline CypherWord SubtractBytesOf( CypherWord first, CypherWord second )
+{
+
+  return ( ( first | HighBitOfBytes ) - ( second & LowBitsOfBytes ) )
+	^ ( ( first ^ ~ second ) & HighBitOfBytes ) ;
+
+}
+
+
+
+/**
+ * Cyphers the specified bytes, returns the number of bytes left untouched at
+ * the end of the buffer (less than a word).
+ *
+ */
+static Size CypherWords( Ceylan::Byte * buffer, Size size,
+  Ceylan::Byte xorByte )
+{
+
+  Size i = 0 ;
+
+#if OSDL_CYPHERS_WITH_AVX2
+
+  const __m256i xorWide    = _mm256_set1_epi8( static_cast<char>( xorByte ) ) ;
+  const __m256i offsetWide = _mm256_set1_epi8(
+	static_cast<char>( CypherOffset ) ) ;
+
+  for ( ; i + 32 <= size; i += 32 )
+  {
+
+	__m256i * location = reinterpret_cast<__m256i *>( buffer + i ) ;
+
+	_mm256_storeu_si256( location, _mm256_add_epi8( _mm256_xor_si256(
+	  _mm256_loadu_si256( location ), xorWide ), offsetWide ) ) ;
+
+  }
+
+#endif // OSDL_CYPHERS_WITH_AVX2
+
+#if OSDL_CYPHERS_WITH_SSE2
+
+  const __m128i xorVector    = _mm_set1_epi8( static_cast<char>( xorByte ) ) ;
+  const __m128i offsetVector = _mm_set1_epi8(
+	static_cast<char>( CypherOffset ) ) ;
+
+  for ( ; i + 16 <= size; i += 16 )
+  {
+
+	__m128i * location = reinterpret_cast<__m128i *>( buffer + i ) ;
+
+	_mm_storeu_si128( location, _mm_add_epi8( _mm_xor_si128(
+	  _mm_loadu_si128( location ), xorVector ), offsetVector ) ) ;
+
+  }
+
+#elif OSDL_CYPHERS_WITH_NEON
+
+  const uint8x16_t xorVector    = vdupq_n_u8( xorByte ) ;
+  const uint8x16_t offsetVector = vdupq_n_u8( CypherOffset ) ;
+
+  for ( ; i + 16 <= size; i += 16 )
+	vst1q_u8( buffer + i, vaddq_u8( veorq_u8( vld1q_u8( buffer + i ),
+	  xorVector ), offsetVector ) ) ;
+
+#endif // OSDL_CYPHERS_WITH_SSE2
+
+  const CypherWord xorWord    = LowBitsOfBytes / 0x7f * xorByte ;
+  const CypherWord offsetWord = LowBitsOfBytes / 0x7f * CypherOffset ;
+
+  CypherWord word ;
+
+  // memcpy is used as buffers may not be aligned, it is inlined anyway:
+  for ( ; i + sizeof( CypherWord ) <= size; i += sizeof( CypherWord ) )
+  {
+
+	::memcpy( & word, buffer + i, sizeof( CypherWord ) ) ;
+	word = AddBytesOf( word ^ xorWord, offsetWord ) ;
+	::memcpy( buffer + i, & word, sizeof( CypherWord ) ) ;
+
+  }
+
+  return size - i ;
+
+}
+
+
+
+/**
+ * Decyphers the specified bytes, returns the number of bytes left untouched at
+ * the end of the buffer (less than a word).
+ *
+ */
+static Size DecypherWords( Ceylan::Byte * buffer, Size size,
+  Ceylan::Byte xorByte )
+{
+
+  Size i = 0 ;
+
+#if OSDL_CYPHERS_WITH_AVX2
+
+  const __m256i xorWide    = _mm256_set1_epi8( static_cast<char>( xorByte ) ) ;
+  const __m256i offsetWide = _mm256_set1_epi8(
+	static_cast<char>( CypherOffset ) ) ;
+
+  for ( ; i + 32 <= size; i += 32 )
+  {
+
+	__m256i * location = reinterpret_cast<__m256i *>( buffer + i ) ;
+
+	_mm256_storeu_si256( location, _mm256_xor_si256( _mm256_sub_epi8(
+	  _mm256_loadu_si256( location ), offsetWide ), xorWide ) ) ;
+
+  }
+
+#endif // OSDL_CYPHERS_WITH_AVX2
+
+#if OSDL_CYPHERS_WITH_SSE2
+
+  const __m128i xorVector    = _mm_set1_epi8( static_cast<char>( xorByte ) ) ;
+  const __m128i offsetVector = _mm_set1_epi8(
+	static_cast<char>( CypherOffset ) ) ;
+
+  for ( ; i + 16 <= size; i += 16 )
+  {
+
+	__m128i * location = reinterpret_cast<__m128i *>( buffer + i ) ;
+
+	_mm_storeu_si128( location, _mm_xor_si128( _mm_sub_epi8(
+	  _mm_loadu_si128( location ), offsetVector ), xorVector ) ) ;
+
+  }
+
+#elif OSDL_CYPHERS_WITH_NEON
+
+  const uint8x16_t xorVector    = vdupq_n_u8( xorByte ) ;
+  const uint8x16_t offsetVector = vdupq_n_u8( CypherOffset ) ;
+
+  for ( ; i + 16 <= size; i += 16 )
+	vst1q_u8( buffer + i, veorq_u8( vsubq_u8( vld1q_u8( buffer + i ),
+	  offsetVector ), xorVector ) ) ;
+
+#endif // OSDL_CYPHERS_WITH_SSE2
+
+  const CypherWord xorWord    = LowBitsOfBytes / 0x7f * xorByte ;
+  const CypherWord offsetWord = LowBitsOfBytes / 0x7f * CypherOffset ;
+
+  CypherWord word ;
+
+  for ( ; i + sizeof( CypherWord ) <= size; i += sizeof( CypherWord ) )
+  {
+
+	::memcpy( & word, buffer + i, sizeof( CypherWord ) ) ;
+	word = SubtractBytesOf( word, offsetWord ) ^ xorWord ;
+	::memcpy( buffer + i, & word, sizeof( CypherWord ) ) ;
+
+  }
+
+  return size - i ;
+
+}
+
+
+
 
 EmbeddedFileException::EmbeddedFileException( const string & reason ) :
   FileException( reason )
@@ -103,6 +327,30 @@ EmbeddedFileException::~EmbeddedFileException() throw()
 // EmbeddedFile implementation.
 
 
+/*
+ * Read-ahead defaults: the buffer of a file opened for reading starts at the
+ * initial size and may be doubled up to the maximum one.
+ *
+ */
+#if OSDL_ARCH_NINTENDO_DS
+
+Size EmbeddedFile::ReadAheadInitialSize = 2 * 1024 ;
+Size EmbeddedFile::ReadAheadMaximumSize = 8 * 1024 ;
+
+#else // OSDL_ARCH_NINTENDO_DS
+
+Size EmbeddedFile::ReadAheadInitialSize =  8 * 1024 ;
+Size EmbeddedFile::ReadAheadMaximumSize = 64 * 1024 ;
+
+#endif // OSDL_ARCH_NINTENDO_DS
+
+
+// Number of reads after which the read-ahead buffer is reconsidered:
+const Ceylan::Uint32 ReadAheadAdaptationWindow = 16 ;
+
+
+
+
 
 EmbeddedFile::~EmbeddedFile() throw()
 {
@@ -125,6 +373,9 @@ EmbeddedFile::~EmbeddedFile() throw()
 
   }
 
+  if ( _readAheadBuffer != 0 )
+	delete [] _readAheadBuffer ;
+
 }
 
 
@@ -187,6 +438,19 @@ bool EmbeddedFile::close()
 
   _physfsHandle = 0 ;
 
+  if ( _readAheadBuffer != 0 )
+  {
+
+	delete [] _readAheadBuffer ;
+	_readAheadBuffer = 0 ;
+
+  }
+
+  _readAheadSize  = 0 ;
+  _bufferFill     = 0 ;
+  _bufferPosition = 0 ;
+  _resizePending  = false ;
+
   return true ;
 
 #else // OSDL_USES_PHYSICSFS
@@ -318,8 +582,94 @@ Size EmbeddedFile::read( Ceylan::Byte * buffer, Size maxLength )
 
 #if OSDL_USES_PHYSICSFS
 
+  // Served first from the data buffered ahead:
+  Size readCount = std::min( _bufferFill - _bufferPosition, maxLength ) ;
+
+  if ( readCount != 0 )
+  {
+
+	::memcpy( buffer, _readAheadBuffer + _bufferPosition, readCount ) ;
+	_bufferPosition += readCount ;
+
+  }
+
+  if ( readCount < maxLength )
+  {
+
+	// Drained, hence a deferred resize cannot lose any data now:
+	if ( _resizePending )
+	  resizeReadAhead( _pendingReadAheadSize ) ;
+
+	Size remaining = maxLength - readCount ;
+
+	if ( remaining >= _readAheadSize )
+	{
+
+	  /*
+	   * Would be split into refills, better read directly, once the drained
+	   * buffer is forgotten, as seek locates it from the backend position:
+	   *
+	   */
+	  _bufferFill     = 0 ;
+	  _bufferPosition = 0 ;
+
+	  readCount += readFromBackend( buffer + readCount, remaining ) ;
+
+	}
+	else
+	{
+
+	  _bufferFill = readFromBackend( _readAheadBuffer, _readAheadSize ) ;
+
+	  _bufferPosition = std::min( _bufferFill, remaining ) ;
+
+	  ::memcpy( buffer + readCount, _readAheadBuffer, _bufferPosition ) ;
+
+	  readCount += _bufferPosition ;
+
+	}
+
+  }
+  else if ( _resizePending && _bufferPosition == _bufferFill )
+  {
+
+	resizeReadAhead( _pendingReadAheadSize ) ;
+
+  }
+
+  // No exception excepted to be raised:
+  if ( _cypher )
+	DecypherBuffer( buffer, readCount ) ;
+
+  _statistics.readCount++ ;
+  _statistics.bytesRead += readCount ;
+
+  if ( _adaptiveReadAhead )
+	adaptReadAhead( maxLength ) ;
+
+  return readCount ;
+
+#else // OSDL_USES_PHYSICSFS
+
+  throw InputStream::ReadFailedException(
+	"EmbeddedFile::read failed: "
+	"no PhysicsFS support available." ) ;
+
+#endif // OSDL_USES_PHYSICSFS
+
+}
+
+
+
+Size EmbeddedFile::readFromBackend( Ceylan::Byte * buffer, Size length )
+{
+
+#if OSDL_USES_PHYSICSFS
+
+  _statistics.backendReadCount++ ;
+
   PHYSFS_sint64 objectCount = PHYSFS_read( _physfsHandle,
-	static_cast<void *>( buffer ), /* object size */ 1, maxLength ) ;
+	static_cast<void *>( buffer ), /* object size */ 1, length ) ;
 
   if ( objectCount == -1 )
   {
@@ -346,7 +696,7 @@ Size EmbeddedFile::read( Ceylan::Byte * buffer, Size maxLength )
 
 #endif // OSDL_DEBUG
 
-  if ( unsignedObjectCount < maxLength )
+  if ( unsignedObjectCount < length )
   {
 
 	// Not EOF? Must be an error:
@@ -368,17 +718,12 @@ Size EmbeddedFile::read( Ceylan::Byte * buffer, Size maxLength )
 	*/
   }
 
-
-  // No exception excepted to be raised:
-  if ( _cypher )
-	DecypherBuffer( buffer, objectCount ) ;
-
   return unsignedObjectCount ;
 
 #else // OSDL_USES_PHYSICSFS
 
   throw InputStream::ReadFailedException(
-	"EmbeddedFile::read failed: "
+	"EmbeddedFile::readFromBackend failed: "
 	"no PhysicsFS support available." ) ;
 
 #endif // OSDL_USES_PHYSICSFS
@@ -467,6 +812,9 @@ Position EmbeddedFile::tell()
 	throw FileException( "EmbeddedFile::tell failed for '" + _name
 	  + "': " + EmbeddedFileSystemManager::GetBackendLastError() ) ;
 
+  // PhysicsFS is ahead by the bytes buffered yet not read:
+  returnedPos -= static_cast<PHYSFS_sint64>( _bufferFill - _bufferPosition ) ;
+
   Position pos = static_cast<Position>( returnedPos ) ;
 
   if ( pos != returnedPos )
@@ -501,12 +849,41 @@ void EmbeddedFile::seek( Position targetPosition )
 	+ Ceylan::toString( targetPosition ) ) ;
   */
 
+  _statistics.seekCount++ ;
+
+  if ( _bufferFill != 0 )
+  {
+
+	PHYSFS_sint64 bufferEnd = ::PHYSFS_tell( _physfsHandle ) ;
+
+	PHYSFS_sint64 bufferStart = bufferEnd
+	  - static_cast<PHYSFS_sint64>( _bufferFill ) ;
+
+	PHYSFS_sint64 target = static_cast<PHYSFS_sint64>( targetPosition ) ;
+
+	// Seeks within the read-ahead buffer need no backend access:
+	if ( bufferEnd >= 0 && target >= bufferStart && target <= bufferEnd )
+	{
+
+	  _bufferPosition = static_cast<Size>( target - bufferStart ) ;
+	  return ;
+
+	}
+
+  }
+
   int res = ::PHYSFS_seek( _physfsHandle, targetPosition ) ;
 
   if ( res == 0 )
 	throw FileException( "EmbeddedFile::seek failed for '" + _name
 	  + "': " + EmbeddedFileSystemManager::GetBackendLastError() ) ;
 
+  _bufferFill     = 0 ;
+  _bufferPosition = 0 ;
+
+  if ( _resizePending )
+	resizeReadAhead( _pendingReadAheadSize ) ;
+
 #else // OSDL_USES_PHYSICSFS
 
   throw Ceylan::System::FileException( "EmbeddedFile::seek failed: "
@@ -564,6 +941,9 @@ Size EmbeddedFile::size() const
 void EmbeddedFile::serialize( PHYSFS_File & handle )
 {
 
+  // The handle must be at the position of this file:
+  dropReadAhead() ;
+
   // Let EmbeddedFileException propagate:
   FromHandletoHandle( *_physfsHandle, handle, size() ) ;
 
@@ -593,6 +973,49 @@ PHYSFS_File & EmbeddedFile::getPhysicsFSHandle() const
 
 
 
+const EmbeddedFile::IOStatistics & EmbeddedFile::getIOStatistics() const
+{
+
+  return _statistics ;
+
+}
+
+
+
+bool EmbeddedFile::isCyphered() const
+{
+
+  return _cypher ;
+
+}
+
+
+
+Size EmbeddedFile::getReadAheadSize() const
+{
+
+  return _readAheadSize ;
+
+}
+
+
+
+void EmbeddedFile::setReadAheadSize( Size newSize )
+{
+
+  if ( ! isOpen() || ( _openFlag & ( Ceylan::System::File::Write
+		| Ceylan::System::File::AppendFile ) ) )
+	throw EmbeddedFileException( "EmbeddedFile::setReadAheadSize failed for '"
+	  + _name + "': file not open for reading." ) ;
+
+  _adaptiveReadAhead = false ;
+
+  resizeReadAhead( newSize ) ;
+
+}
+
+
+
 
 void EmbeddedFile::CypherBuffer( Ceylan::Byte * buffer,
   Ceylan::System::Size size )
@@ -600,8 +1023,9 @@ void EmbeddedFile::CypherBuffer( Ceylan::Byte * buffer,
 
   Ceylan::Byte XORByte = EmbeddedFileSystemManager::GetXORByte() ;
 
-  for ( Size i = 0; i < size; i++ )
-	buffer[i] = (buffer[i]^XORByte) + 117 ;
+  // Only the last bytes, if any, are processed one by one:
+  for ( Size i = size - CypherWords( buffer, size, XORByte ); i < size; i++ )
+	buffer[i] = (buffer[i]^XORByte) + CypherOffset ;
 
 }
 
@@ -612,15 +1036,24 @@ void EmbeddedFile::DecypherBuffer( Ceylan::Byte * buffer, Size size )
 
   Ceylan::Byte XORByte = EmbeddedFileSystemManager::GetXORByte() ;
 
-  for ( Size i = 0; i < size; i++ )
-  {
-	buffer[i] = (buffer[i]-117)^XORByte ;
+  for ( Size i = size - DecypherWords( buffer, size, XORByte ); i < size; i++ )
+	buffer[i] = (buffer[i]-CypherOffset)^XORByte ;
+
+}
+
 
-	/*
-	  LogPlug::trace( "DecypherBuffer: "
-	  + Ceylan::toHexString( buffer[i] ) ) ;
-	*/
-  }
+
+void EmbeddedFile::SetReadAheadSizes( Size initialSize, Size maximumSize )
+{
+
+  if ( maximumSize < initialSize )
+	throw EmbeddedFileException( "EmbeddedFile::SetReadAheadSizes failed: "
+	  "maximum size (" + Ceylan::toString( maximumSize )
+	  + " bytes) smaller than initial size ("
+	  + Ceylan::toString( initialSize ) + " bytes)." ) ;
+
+  ReadAheadInitialSize = initialSize ;
+  ReadAheadMaximumSize = maximumSize ;
 
 }
 
@@ -650,10 +1083,26 @@ StreamID EmbeddedFile::getStreamID() const
 const std::string EmbeddedFile::toString( Ceylan::VerbosityLevels level ) const
 {
 
-  return "Embedded file object for user-specified filename '"
+  string res = "Embedded file object for user-specified filename '"
 	+ Ceylan::encodeToROT13( _name )
 	+ "', corresponding to an actual name in archive '" + _name + "'" ;
 
+  if ( level == Ceylan::low )
+	return res ;
+
+  if ( _readAheadSize == 0 )
+	res += ", with no read-ahead" ;
+  else
+	res += ", with a " + string( _adaptiveReadAhead ? "adaptive " : "" )
+	  + "read-ahead of " + Ceylan::toString( _readAheadSize ) + " bytes" ;
+
+  return res + ". " + Ceylan::toString( _statistics.readCount )
+	+ " read(s) for " + Ceylan::toString( _statistics.bytesRead )
+	+ " bytes (" + Ceylan::toString( _statistics.backendReadCount )
+	+ " from PhysicsFS), " + Ceylan::toString( _statistics.seekCount )
+	+ " seek(s) and " + Ceylan::toString( _statistics.resizeCount )
+	+ " buffer resize(s) performed" ;
+
 }
 
 
@@ -691,9 +1140,24 @@ EmbeddedFile & EmbeddedFile::Open( const std::string & filename,
 EmbeddedFile::EmbeddedFile( const string & name, OpeningFlag openFlag,
   PermissionFlag permissions ) :
   File( Ceylan::encodeToROT13(name), openFlag, permissions ),
-  _physfsHandle( 0 )
+  _physfsHandle( 0 ),
+  _readAheadSize( 0 ),
+  _readAheadBuffer( 0 ),
+  _bufferFill( 0 ),
+  _bufferPosition( 0 ),
+  _pendingReadAheadSize( 0 ),
+  _resizePending( false ),
+  _adaptiveReadAhead( false ),
+  _windowReads( 0 ),
+  _windowBytes( 0 )
 {
 
+  _statistics.readCount        = 0 ;
+  _statistics.bytesRead        = 0 ;
+  _statistics.backendReadCount = 0 ;
+  _statistics.seekCount        = 0 ;
+  _statistics.resizeCount      = 0 ;
+
   // (File constructor may raise FileException)
 
 #if OSDL_USES_PHYSICSFS
@@ -810,12 +1274,40 @@ void EmbeddedFile::reopen()
 
   _physfsHandle = file ;
 
+  _bufferFill        = 0 ;
+  _bufferPosition    = 0 ;
+  _resizePending     = false ;
+  _adaptiveReadAhead = false ;
+  _windowReads       = 0 ;
+  _windowBytes       = 0 ;
+
+  // Only reads are buffered ahead, writes go straight to the backend:
+  if ( ! ( _openFlag & ( Ceylan::System::File::Write
+		| Ceylan::System::File::AppendFile ) ) )
+  {
+
+	resizeReadAhead( ReadAheadInitialSize ) ;
+	_adaptiveReadAhead = ( ReadAheadMaximumSize != ReadAheadInitialSize ) ;
+
+  }
+  else
+  {
+
+	resizeReadAhead( 0 ) ;
+
+  }
+
   // getCorrespondingFileSystemManager() would require a cast to embedded:
   EmbeddedFileSystemManager & manager =
 				EmbeddedFileSystemManager::GetEmbeddedFileSystemManager() ;
 
   manager.declareFileOpening( *this ) ;
 
+  // The write directory may be in the search path, hence in the virtual tree:
+  if ( _openFlag & ( Ceylan::System::File::Write
+		| Ceylan::System::File::AppendFile ) )
+	manager.declareTreeModification() ;
+
 #else // OSDL_USES_PHYSICSFS
 
   throw Ceylan::System::FileOpeningFailed( "EmbeddedFile::reopen failed: "
@@ -836,6 +1328,120 @@ std::string EmbeddedFile::interpretState() const
 
 
 
+void EmbeddedFile::adaptReadAhead( Size requestedSize )
+{
+
+  _windowReads++ ;
+  _windowBytes += requestedSize ;
+
+  if ( _windowReads < ReadAheadAdaptationWindow )
+	return ;
+
+  Size averageRead = _windowBytes / _windowReads ;
+  Size newSize = _readAheadSize ;
+
+  if ( _readAheadSize == 0 )
+  {
+
+	// Small reads are back, buffering them again:
+	if ( averageRead < ReadAheadInitialSize / 4 )
+	  newSize = ReadAheadInitialSize ;
+
+  }
+  else if ( averageRead >= _readAheadSize )
+  {
+
+	// Each read would be split into refills, better read directly:
+	newSize = 0 ;
+
+  }
+  else if ( _windowBytes >= _readAheadSize
+	&& averageRead < _readAheadSize / 8
+	&& _readAheadSize < ReadAheadMaximumSize )
+  {
+
+	// Small reads streamed through the buffer: fewer, larger refills.
+	newSize = _readAheadSize * 2 ;
+
+	if ( newSize > ReadAheadMaximumSize )
+	  newSize = ReadAheadMaximumSize ;
+
+  }
+
+  _windowReads = 0 ;
+  _windowBytes = 0 ;
+
+  if ( newSize != _readAheadSize )
+	resizeReadAhead( newSize ) ;
+
+}
+
+
+
+void EmbeddedFile::resizeReadAhead( Size newSize )
+{
+
+  Size unread = _bufferFill - _bufferPosition ;
+
+  if ( unread > newSize )
+  {
+
+	// Applied by the read or the seek that drains the buffer:
+	_pendingReadAheadSize = newSize ;
+	_resizePending = true ;
+	return ;
+
+  }
+
+  _resizePending = false ;
+
+  if ( newSize == _readAheadSize )
+	return ;
+
+  Ceylan::Byte * newBuffer = ( newSize != 0 ) ? new Ceylan::Byte[newSize] : 0 ;
+
+  // The unread bytes are kept, so that PhysicsFS stays where it is:
+  if ( unread != 0 )
+	::memcpy( newBuffer, _readAheadBuffer + _bufferPosition, unread ) ;
+
+  if ( _readAheadBuffer != 0 )
+	delete [] _readAheadBuffer ;
+
+  _readAheadBuffer = newBuffer ;
+  _readAheadSize   = newSize ;
+  _bufferFill      = unread ;
+  _bufferPosition  = 0 ;
+
+  _statistics.resizeCount++ ;
+
+}
+
+
+
+void EmbeddedFile::dropReadAhead()
+{
+
+#if OSDL_USES_PHYSICSFS
+
+  if ( _bufferFill != _bufferPosition )
+  {
+
+	// Seeking back, yet only when the handle itself is to be used:
+	if ( ::PHYSFS_seek( _physfsHandle, tell() ) == 0 )
+	  throw EmbeddedFileException( "EmbeddedFile::dropReadAhead failed for '"
+		+ _name + "': " + EmbeddedFileSystemManager::GetBackendLastError() ) ;
+
+  }
+
+  _bufferFill     = 0 ;
+  _bufferPosition = 0 ;
+
+#endif // OSDL_USES_PHYSICSFS
+
+}
+
+
+
 
 // Private section.
 
@@ -366,6 +366,85 @@ namespace OSDL
 
 
 
+			/**
+			 * Statistics about the reads and seeks performed on this file.
+			 *
+			 */
+			struct IOStatistics
+			{
+
+				/// Number of read calls.
+				Ceylan::Uint32 readCount ;
+
+				/// Number of bytes actually read.
+				Ceylan::System::Size bytesRead ;
+
+				/**
+				 * Number of reads performed on PhysicsFS, to refill the
+				 * read-ahead buffer or to serve large reads directly.
+				 *
+				 */
+				Ceylan::Uint32 backendReadCount ;
+
+				/// Number of seek calls.
+				Ceylan::Uint32 seekCount ;
+
+				/// Number of times the read-ahead buffer was (re)sized.
+				Ceylan::Uint32 resizeCount ;
+
+			} ;
+
+
+
+			/**
+			 * Returns the statistics about the reads and seeks performed on
+			 * this file since it was opened.
+			 *
+			 */
+			const IOStatistics & getIOStatistics() const ;
+
+
+
+			/**
+			 * Tells whether the content of this file is cyphered, i.e.
+			 * whether its bytes are stored as read from the backend.
+			 *
+			 */
+			bool isCyphered() const ;
+
+
+
+			/**
+			 * Returns the current size of the read-ahead buffer of this file,
+			 * in bytes (0 if reads are not buffered).
+			 *
+			 */
+			Ceylan::System::Size getReadAheadSize() const ;
+
+
+
+			/**
+			 * Sets the size of the read-ahead buffer of this file, which then
+			 * will not be adapted anymore.
+			 *
+			 * The file then reads (and PhysicsFS decompresses) that many bytes
+			 * at once, and serves the next reads from that buffer, which makes
+			 * a series of small reads (as done by most decoders) much cheaper.
+			 *
+			 * @param newSize the buffer size, in bytes; 0 disables buffering.
+			 *
+			 * @note The current position in file is kept, and PhysicsFS is
+			 * not accessed: if the data still buffered does not fit in the new
+			 * size, the resize is only applied once that data has been read.
+			 *
+			 * @throw EmbeddedFileException if the file is not open for
+			 * reading.
+			 *
+			 */
+			void setReadAheadSize( Ceylan::System::Size newSize ) ;
+
+
+
 			/**
 			 * Cyphers specified buffer.
 			 *
@@ -402,6 +481,32 @@ namespace OSDL
 
 
 
+			/**
+			 * Sets the read-ahead settings of the embedded files that will be
+			 * opened for reading afterwards.
+			 *
+			 * Each of these files starts with a buffer of the initial size,
+			 * then adapts it to the reads it receives: the buffer is doubled
+			 * (up to the maximum size) while small reads are streamed through
+			 * it, and dropped when reads are at least as large as the buffer
+			 * (as they would be split in as many refills), until small reads
+			 * come again.
+			 *
+			 * @param initialSize the initial buffer size, in bytes; 0
+			 * disables read-ahead.
+			 *
+			 * @param maximumSize the size the buffer may grow to, in bytes;
+			 * if equal to the initial size, buffers are not adapted.
+			 *
+			 * @throw EmbeddedFileException if the maximum size is smaller than
+			 * the initial one.
+			 *
+			 */
+			static void SetReadAheadSizes( Ceylan::System::Size initialSize,
+				Ceylan::System::Size maximumSize ) ;
+
+
+
 
 			// Interface implementation.
 
@@ -611,6 +716,49 @@ namespace OSDL
 
 
 
+			/**
+			 * Accounts for a read of specified size, and adapts the read-ahead
+			 * buffer accordingly.
+			 *
+			 */
+			void adaptReadAhead( Ceylan::System::Size requestedSize ) ;
+
+
+
+			/**
+			 * Resizes the read-ahead buffer of this file, keeping the data it
+			 * still buffers, or defers the resize until that data is read if
+			 * it would not fit.
+			 *
+			 * @note PhysicsFS is never accessed, as it would have to seek back
+			 * to the current position, i.e. to inflate again a compressed
+			 * archive member from its start.
+			 *
+			 */
+			void resizeReadAhead( Ceylan::System::Size newSize ) ;
+
+
+
+			/**
+			 * Reads up to the specified length directly from PhysicsFS.
+			 *
+			 * @throw InputStream::ReadFailedException if the read failed.
+			 *
+			 */
+			Ceylan::System::Size readFromBackend( Ceylan::Byte * buffer,
+				Ceylan::System::Size length ) ;
+
+
+
+			/**
+			 * Drops the data buffered ahead, so that the position of the
+			 * PhysicsFS handle is the one of this file again.
+			 *
+			 */
+			void dropReadAhead() ;
+
+
+
 
 		private:
 
@@ -630,6 +778,59 @@ namespace OSDL
 			bool _cypher ;
 
 
+			/// The size of the read-ahead buffer, in bytes.
+			Ceylan::System::Size _readAheadSize ;
+
+
+			/**
+			 * The read-ahead buffer, owned, if any, holding the bytes read
+			 * (still cyphered) from PhysicsFS just before its current
+			 * position.
+			 *
+			 */
+			Ceylan::Byte * _readAheadBuffer ;
+
+
+			/// The number of bytes held by the read-ahead buffer.
+			Ceylan::System::Size _bufferFill ;
+
+
+			/// The index in the read-ahead buffer of the next byte to read.
+			Ceylan::System::Size _bufferPosition ;
+
+
+			/// The size to resize the buffer to, once it is drained, if any.
+			Ceylan::System::Size _pendingReadAheadSize ;
+
+
+			/// Tells whether a resize is waiting for the buffer to be drained.
+			bool _resizePending ;
+
+
+			/// Tells whether the read-ahead buffer is adapted to the reads.
+			bool _adaptiveReadAhead ;
+
+
+			/// Number of reads since the buffer was last adapted.
+			Ceylan::Uint32 _windowReads ;
+
+
+			/// Number of bytes requested since the buffer was last adapted.
+			Ceylan::System::Size _windowBytes ;
+
+
+			/// The reads and seeks performed on this file.
+			IOStatistics _statistics ;
+
+
+			/// The read-ahead size files opened for reading start with.
+			static Ceylan::System::Size ReadAheadInitialSize ;
+
+
+			/// The read-ahead size files may grow to.
+			static Ceylan::System::Size ReadAheadMaximumSize ;
+
+
 
 			/**
 			 * Copy constructor made private to ensure that it will be never
@@ -29,6 +29,7 @@
 
 #include "OSDLEmbeddedFile.h"        // for EmbeddedFile
 #include "OSDLEmbeddedDirectory.h"   // for EmbeddedDirectory
+#include "OSDLIndexedArchive.h"      // for RegisterPhysicsFSArchiver
 
 
 #ifdef OSDL_USES_CONFIG_H
@@ -46,12 +47,23 @@
 #endif // OSDL_USES_PHYSICSFS
 
 
+#if OSDL_USES_SDL
+#include "SDL.h"                     // for SDL_GetError
+#include "SDL_thread.h"              // for SDL_CreateMutex and al
+#endif // OSDL_USES_SDL
+
+
 #include "Ceylan.h"                  // for all Ceylan services
 
 
+#include <map>
+
+
 
 using std::string ;
 using std::list ;
+using std::map ;
+using std::pair ;
 
 using namespace Ceylan::Log ;
 using namespace Ceylan::System ;
@@ -73,17 +85,27 @@ using namespace OSDL ;
  *  - PHYSFS_eof: not really needed for the moment
  *  - PHYSFS_tell: not really needed for the moment
  *  - PHYSFS_seek: not really needed for the moment
- *  - PHYSFS_setBuffer: not really needed for the moment
+ *  - PHYSFS_setBuffer: not used, as EmbeddedFile buffers its reads ahead by
+ * itself (resizing the PhysicsFS buffer may seek back, i.e. inflate again)
  *  - PHYSFS_flush: not really needed for the moment
  *  - PHYSFS_swap*: not really needed for the moment
  *  - PHYSFS_read*: not really needed for the moment
  *  - PHYSFS_write*: not really needed for the moment
  *  - PHYSFS_isInit: not needed
- *  - PHYSFS_symbolicLinksPermitted: not needed
- *  - PHYSFS_setAllocator: not needed
- *  - various callbacks: not needed
+ *  - PHYSFS_symbolicLinksPermitted: only to know whether to index the tree
+ *  - PHYSFS_setAllocator: used to pool allocations, see PoolAllocations
+ *  - various callbacks: not needed, except the archiver of indexed archives
  *  - string conversion: not needed
  *
+ * The virtual tree is indexed, as each PhysicsFS lookup scans the search path
+ * element by element: existence, location and listing queries are answered
+ * by walking down the path of the entry in the index instead.
+ *
+ * Mounting an element does not index the whole tree again: the element is
+ * first mounted alone on a temporary mount point, where its entries can be
+ * enumerated without the other elements being scanned, then on its actual
+ * mount point. Unmounting it looks up again only the entries it provided.
+ *
  */
 
 
@@ -105,6 +127,128 @@ EmbeddedFileSystemManager *
 
 
 
+/**
+ * The mount point on which elements are mounted alone, to enumerate their
+ * entries before being mounted on their actual mount point.
+ *
+ */
+const string TemporaryMountPoint = "OSDL-tree-index-listing" ;
+
+
+
+#if OSDL_USES_SDL
+
+/**
+ * Holds the mutex of the index of the virtual tree for the current scope, so
+ * that it is released even if an exception is raised.
+ *
+ */
+class TreeLock
+{
+
+	public:
+
+
+		explicit TreeLock( SDL_mutex * mutex ) :
+			_mutex( mutex )
+		{
+
+			SDL_mutexP( _mutex ) ;
+
+		}
+
+
+		~TreeLock() throw()
+		{
+
+			SDL_mutexV( _mutex ) ;
+
+		}
+
+
+	private:
+
+		SDL_mutex * _mutex ;
+
+} ;
+
+#endif // OSDL_USES_SDL
+
+
+
+/*
+ * An entry of the virtual tree, whose children (if it is a directory) are
+ * stored by name, and whose location is the rank in _treeLocations of the
+ * element it is read from.
+ *
+ */
+struct EmbeddedFileSystemManager::TreeNode
+{
+
+
+	/// Denotes an entry whose location is not known.
+	static const Ceylan::Uint32 NoLocation = 0xFFFFFFFF ;
+
+
+	explicit TreeNode( bool directory ) :
+		isDirectory( directory ),
+		location( NoLocation )
+	{
+
+	}
+
+
+	~TreeNode() throw()
+	{
+
+		clearChildren() ;
+
+	}
+
+
+	/// Returns the number of entries below this one.
+	Ceylan::Uint32 countEntries() const
+	{
+
+		Ceylan::Uint32 count = 0 ;
+
+		for ( map<string,TreeNode *>::const_iterator it = children.begin();
+				it != children.end(); it++ )
+			count += 1 + (*it).second->countEntries() ;
+
+		return count ;
+
+	}
+
+
+	/// Deletes the entries below this one, returns how many they were.
+	Ceylan::Uint32 clearChildren()
+	{
+
+		Ceylan::Uint32 count = countEntries() ;
+
+		for ( map<string,TreeNode *>::iterator it = children.begin();
+				it != children.end(); it++ )
+			delete (*it).second ;
+
+		children.clear() ;
+
+		return count ;
+
+	}
+
+
+	bool isDirectory ;
+
+	Ceylan::Uint32 location ;
+
+	map<string,TreeNode *> children ;
+
+
+} ;
+
+
+
 string EmbeddedFileSystemManager::ArchivePathEnvironmentVariable =
 	"ARCHIVE_PATH" ;
 
@@ -112,6 +256,136 @@ Ceylan::System::FileLocator EmbeddedFileSystemManager::ArchiveFileLocator(
 	ArchivePathEnvironmentVariable ) ;
 
 
+bool EmbeddedFileSystemManager::PoolAllocations = true ;
+
+
+
+#if OSDL_USES_PHYSICSFS
+
+
+/*
+ * Allocator callbacks for PhysicsFS, whose pool is created when PhysicsFS is
+ * initialized, and deleted once it is deinitialized.
+ *
+ */
+
+
+/// The pool serving the allocations of PhysicsFS, if any.
+static PooledAllocator * PhysicsFSPool = 0 ;
+
+
+
+static int InitPhysicsFSPool()
+{
+
+	try
+	{
+
+		PhysicsFSPool = new PooledAllocator() ;
+
+	}
+	catch( const PooledAllocatorException & e )
+	{
+
+		LogPlug::error( "Unable to create the pool for PhysicsFS: "
+			+ e.toString() ) ;
+
+		return 0 ;
+
+	}
+
+	return 1 ;
+
+}
+
+
+
+static void DeinitPhysicsFSPool()
+{
+
+	delete PhysicsFSPool ;
+	PhysicsFSPool = 0 ;
+
+}
+
+
+
+/**
+ * Tells whether a size requested by PhysicsFS can be represented as a Size.
+ *
+ * The bound is only checked if PHYSFS_uint64 is the wider type (ex: on
+ * 32-bit platforms), as the comparison would always be false otherwise.
+ *
+ */
+template <bool BackendIsWider>
+struct BackendSize
+{
+
+	static bool Fits( PHYSFS_uint64 size )
+	{
+
+		return ( size <= static_cast<PHYSFS_uint64>(
+			static_cast<Size>( -1 ) ) ) ;
+
+	}
+
+} ;
+
+
+template <>
+struct BackendSize<false>
+{
+
+	static bool Fits( PHYSFS_uint64 )
+	{
+
+		return true ;
+
+	}
+
+} ;
+
+
+typedef BackendSize< ( sizeof( PHYSFS_uint64 ) > sizeof( Size ) ) >
+	PhysicsFSSize ;
+
+
+
+static void * PhysicsFSMalloc( PHYSFS_uint64 size )
+{
+
+	if ( ! PhysicsFSSize::Fits( size ) )
+		return 0 ;
+
+	return PhysicsFSPool->allocate( static_cast<Size>( size ) ) ;
+
+}
+
+
+
+static void * PhysicsFSRealloc( void * block, PHYSFS_uint64 newSize )
+{
+
+	if ( ! PhysicsFSSize::Fits( newSize ) )
+		return 0 ;
+
+	return PhysicsFSPool->reallocate( block, static_cast<Size>( newSize ) ) ;
+
+}
+
+
+
+static void PhysicsFSFree( void * block )
+{
+
+	PhysicsFSPool->deallocate( block ) ;
+
+}
+
+
+#endif // OSDL_USES_PHYSICSFS
+
+
 
 
 
@@ -155,6 +429,8 @@ void EmbeddedFileSystemManager::chooseBasicSettings(
 			"EmbeddedFileSystemManager::chooseBasicSettings failed: "
 			+ GetBackendLastError() ) ;
 
+	refreshTreeIndex() ;
+
 #else // OSDL_USES_PHYSICSFS
 
 	throw EmbeddedFileSystemManagerException(
@@ -205,109 +481,772 @@ std::string EmbeddedFileSystemManager::getWriteDirectory() const
 
 #if OSDL_USES_PHYSICSFS
 
-	const char * res = PHYSFS_getWriteDir() ;
+	const char * res = PHYSFS_getWriteDir() ;
+
+	if ( res == 0 )
+		throw EmbeddedFileSystemManagerException(
+			"EmbeddedFileSystemManager::getWriteDirectory failed: "
+			"no write directory set." ) ;
+
+	return string( res ) ;
+
+#else // OSDL_USES_PHYSICSFS
+
+	throw EmbeddedFileSystemManagerException(
+		"EmbeddedFileSystemManager::getWriteDirectory failed: "
+		"no PhysicsFS support available." ) ;
+
+#endif // OSDL_USES_PHYSICSFS
+
+}
+
+
+
+void EmbeddedFileSystemManager::setWriteDirectory(
+	const std::string & newWriteDirectory )
+{
+
+	/*
+	 * This is a member method, the embedded filesystem has thus already been
+	 * initialized in the EmbeddedFileSystemManager constructor.
+	 *
+	 */
+
+#if OSDL_USES_PHYSICSFS
+
+	if ( PHYSFS_setWriteDir( newWriteDirectory.c_str() ) == 0 )
+		throw EmbeddedFileSystemManagerException(
+			"EmbeddedFileSystemManager::setWriteDirectory failed: "
+			+ GetBackendLastError() ) ;
+
+	send( "Write directory set to " + newWriteDirectory ) ;
+
+#else // OSDL_USES_PHYSICSFS
+
+	throw EmbeddedFileSystemManagerException(
+		"EmbeddedFileSystemManager::setWriteDirectory failed: "
+		"no PhysicsFS support available." ) ;
+
+#endif // OSDL_USES_PHYSICSFS
+
+}
+
+
+
+void EmbeddedFileSystemManager::mount(
+	const string & newActualFilesystemElement,
+	const string & mountPointInVirtualTree,
+	bool append )
+{
+
+	/*
+	 * This is a member method, the embedded filesystem has thus already been
+	 * initialized in the EmbeddedFileSystemManager constructor.
+	 *
+	 */
+
+#if OSDL_USES_PHYSICSFS
+
+	try
+	{
+
+		StandardFileSystemManager & standardManager =
+			StandardFileSystemManager::GetStandardFileSystemManager() ;
+
+		if ( ! standardManager.existsAsEntry( newActualFilesystemElement ) )
+			throw EmbeddedFileSystemManagerException(
+				"EmbeddedFileSystemManager::mount failed "
+				"for non-existing filesystem element '"
+				+ newActualFilesystemElement + "'." ) ;
+	}
+	catch( const Ceylan::Exception & e )
+	{
+
+		throw EmbeddedFileSystemManagerException(
+			"EmbeddedFileSystemManager::mount failed for filesystem element '"
+			+ newActualFilesystemElement + "': "
+			+ e.toString() ) ;
+	}
+
+
+	// Mounting an element already in the search path does nothing:
+	if ( PHYSFS_getMountPoint( newActualFilesystemElement.c_str() ) != 0 )
+	{
+
+		send( "Element '" + newActualFilesystemElement
+			+ "' already mounted." ) ;
+
+		return ;
+
+	}
+
+	bool indexUpdatable ;
+
+	{
+
+#if OSDL_USES_SDL
+		TreeLock lock( _treeMutex ) ;
+#endif // OSDL_USES_SDL
+
+		indexUpdatable = ( _treeIndex != 0 && ! _treeIndexStale ) ;
+
+	}
+
+	// Lists the entries of the element while it is alone on its mount point:
+	list< pair<string,bool> > elementEntries ;
+
+	bool listed = indexUpdatable && listElementEntries(
+		newActualFilesystemElement, elementEntries ) ;
+
+	if ( PHYSFS_mount(
+			newActualFilesystemElement.c_str(),
+			mountPointInVirtualTree.c_str(),
+			append ) == 0 )
+		throw EmbeddedFileSystemManagerException(
+			"EmbeddedFileSystemManager::mount failed: "
+			+ GetBackendLastError() ) ;
+
+	send( "Element '" + newActualFilesystemElement + "' mounted." ) ;
+
+#if OSDL_USES_SDL
+	TreeLock lock( _treeMutex ) ;
+#endif // OSDL_USES_SDL
+
+	if ( listed )
+		insertElementEntries( newActualFilesystemElement,
+			mountPointInVirtualTree, elementEntries, /* prepend */ ! append ) ;
+	else
+		rebuildTreeIndex() ;
+
+#else // OSDL_USES_PHYSICSFS
+
+	throw EmbeddedFileSystemManagerException(
+		"EmbeddedFileSystemManager::mount failed: "
+		"no PhysicsFS support available." ) ;
+
+#endif // OSDL_USES_PHYSICSFS
+
+}
+
+
+
+void EmbeddedFileSystemManager::umount(
+	const std::string & actualFilesystemElement )
+{
+
+	/*
+	 * This is a member method, the embedded filesystem has thus already been
+	 * initialized in the EmbeddedFileSystemManager constructor.
+	 *
+	 */
+
+#if OSDL_USES_PHYSICSFS
+
+  if ( _trackOpenFiles )
+  {
+
+	if ( hasOpenFiles() )
+	{
+
+	  LogPlug::error( "EmbeddedFileSystemManager umount called whereas "
+		"following files were still reported as open:"
+		+ Ceylan::formatStringList( Ceylan::encodeToROT13( _openFiles ) ) ) ;
+
+	}
+
+  }
+
+
+  if ( PHYSFS_removeFromSearchPath( actualFilesystemElement.c_str() ) == 0 )
+	throw EmbeddedFileSystemManagerException(
+	  "EmbeddedFileSystemManager::umount failed for '"
+	  + actualFilesystemElement + "': "
+	  + GetBackendLastError() ) ;
+
+  send( "Element '" + actualFilesystemElement + "' unmounted." ) ;
+
+#if OSDL_USES_SDL
+  TreeLock lock( _treeMutex ) ;
+#endif // OSDL_USES_SDL
+
+  if ( _treeIndex != 0 && ! _treeIndexStale )
+	removeElementEntries( actualFilesystemElement ) ;
+  else
+	rebuildTreeIndex() ;
+
+#else // OSDL_USES_PHYSICSFS
+
+	throw EmbeddedFileSystemManagerException(
+	  "EmbeddedFileSystemManager::umount failed: "
+	  "no PhysicsFS support available." ) ;
+
+#endif // OSDL_USES_PHYSICSFS
+
+}
+
+
+
+std::string EmbeddedFileSystemManager::getMountPointFor(
+	const string & actualFilesystemElement ) const
+{
+
+	/*
+	 * This is a member method, the embedded filesystem has thus already been
+	 * initialized in the EmbeddedFileSystemManager constructor.
+	 *
+	 */
+
+#if OSDL_USES_PHYSICSFS
+
+	const char * res = PHYSFS_getMountPoint( actualFilesystemElement.c_str() ) ;
+
+	if ( res == 0 )
+		throw EmbeddedFileSystemManagerException(
+			"EmbeddedFileSystemManager::getMountPointFor failed: "
+			+ GetBackendLastError() ) ;
+
+	return string( res ) ;
+
+#else // OSDL_USES_PHYSICSFS
+
+	throw EmbeddedFileSystemManagerException(
+		"EmbeddedFileSystemManager::getMountPointFor failed: "
+		"no PhysicsFS support available." ) ;
+
+#endif // OSDL_USES_PHYSICSFS
+
+}
+
+
+
+std::list<std::string> EmbeddedFileSystemManager::getSearchPath() const
+{
+
+	/*
+	 * This is a member method, the embedded filesystem has thus already been
+	 * initialized in the EmbeddedFileSystemManager constructor.
+	 *
+	 */
+
+#if OSDL_USES_PHYSICSFS
+
+	char ** paths = PHYSFS_getSearchPath() ;
+
+	if ( paths == 0 )
+		throw EmbeddedFileSystemManagerException(
+			"EmbeddedFileSystemManager::getSearchPath failed: "
+			+ GetBackendLastError() ) ;
+
+	list<string> res ;
+
+
+	for ( ; *paths != 0; paths++ )
+		res.push_back( string( *paths ) ) ;
+
+	/*
+	 * Cannot use:
+	 PHYSFS_freeList( paths ) ;
+
+	 * or, otherwise a core dump (invalide glib pointer) is
+	 * triggered, or, with Valgrind:
+	 *  Invalid free() / delete / delete[]
+	 *  at 0x4C282ED: free (vg_replace_malloc.c:366)
+	 *  by 0x6BC5EB1: mallocAllocatorFree (physfs.c:2171)
+	 *  by 0x6BC2FA6: PHYSFS_freeList (physfs.c:874)
+	 *
+	 * (sorry for the small memory leak thus induced!)
+	 *
+	 */
+
+	return res ;
+
+#else // OSDL_USES_PHYSICSFS
+
+	throw EmbeddedFileSystemManagerException(
+		"EmbeddedFileSystemManager::getSearchPath failed: "
+		"no PhysicsFS support available." ) ;
+
+#endif // OSDL_USES_PHYSICSFS
+
+}
+
+
+
+void EmbeddedFileSystemManager::refreshTreeIndex()
+{
+
+#if OSDL_USES_SDL
+	TreeLock lock( _treeMutex ) ;
+#endif // OSDL_USES_SDL
+
+	rebuildTreeIndex() ;
+
+}
+
+
+
+void EmbeddedFileSystemManager::setTreeIndexing( bool newStatus )
+{
+
+#if OSDL_USES_SDL
+	TreeLock lock( _treeMutex ) ;
+#endif // OSDL_USES_SDL
+
+	_treeIndexing = newStatus ;
+
+	rebuildTreeIndex() ;
+
+}
+
+
+
+void EmbeddedFileSystemManager::declareTreeModification()
+{
+
+#if OSDL_USES_SDL
+	TreeLock lock( _treeMutex ) ;
+#endif // OSDL_USES_SDL
+
+	if ( _treeIndex != 0 )
+		_treeIndexStale = true ;
+
+}
+
+
+
+void EmbeddedFileSystemManager::declareFileOpening(
+	Ceylan::System::File & opened )
+{
+
+#if OSDL_USES_SDL
+	TreeLock lock( _treeMutex ) ;
+#endif // OSDL_USES_SDL
+
+	Ceylan::System::FileSystemManager::declareFileOpening( opened ) ;
+
+}
+
+
+
+void EmbeddedFileSystemManager::declareFileClosing(
+	Ceylan::System::File & closed )
+{
+
+#if OSDL_USES_SDL
+	TreeLock lock( _treeMutex ) ;
+#endif // OSDL_USES_SDL
+
+	Ceylan::System::FileSystemManager::declareFileClosing( closed ) ;
+
+}
+
+
+
+EmbeddedFileSystemManager::IndexedEntryKind
+	EmbeddedFileSystemManager::lookupIndexedEntry(
+		const string & entryPath ) const
+{
+
+#if OSDL_USES_SDL
+	TreeLock lock( _treeMutex ) ;
+#endif // OSDL_USES_SDL
+
+	bool indexed ;
+
+	const TreeNode * node = findTreeNode( entryPath, indexed ) ;
+
+	if ( ! indexed )
+		return NotIndexed ;
+
+	if ( node == 0 )
+		return NoEntry ;
+
+	return ( node->isDirectory ? IndexedDirectory : IndexedFile ) ;
+
+}
+
+
+
+bool EmbeddedFileSystemManager::getIndexedEntries(
+	const string & directoryPath, list<string> & entries ) const
+{
+
+#if OSDL_USES_SDL
+	TreeLock lock( _treeMutex ) ;
+#endif // OSDL_USES_SDL
+
+	bool indexed ;
+
+	const TreeNode * node = findTreeNode( directoryPath, indexed ) ;
+
+	if ( ! indexed )
+		return false ;
+
+	// Like PHYSFS_enumerateFiles, lists nothing if not a directory:
+	if ( node == 0 || ! node->isDirectory )
+		return true ;
+
+	// Names are sorted the same way (byte-wise) as by PhysicsFS:
+	for ( map<string,TreeNode *>::const_iterator it = node->children.begin();
+			it != node->children.end(); it++ )
+		entries.push_back( (*it).first ) ;
+
+	return true ;
+
+}
+
+
+
+void EmbeddedFileSystemManager::rebuildTreeIndex()
+{
+
+	delete _treeIndex ;
+	_treeIndex = 0 ;
+
+	_treeLocations.clear() ;
+	_treeEntryCount = 0 ;
+	_treeIndexStale = false ;
+
+#if OSDL_USES_PHYSICSFS
+
+	if ( ! _treeIndexing || PHYSFS_symbolicLinksPermitted() != 0 )
+		return ;
+
+	TreeNode * root = new TreeNode( /* isDirectory */ true ) ;
+
+	// Not fatal, lookups will just be delegated to PhysicsFS:
+	if ( ! indexDirectory( /* root */ "", *root ) )
+	{
+
+		LogPlug::warning( "EmbeddedFileSystemManager::rebuildTreeIndex: "
+			"unable to index the virtual tree: " + GetBackendLastError() ) ;
+
+		delete root ;
+
+		_treeLocations.clear() ;
+		_treeEntryCount = 0 ;
+
+		return ;
+
+	}
+
+	_treeIndex = root ;
+
+	send( "Virtual tree indexed: " + Ceylan::toString( _treeEntryCount )
+		+ " entries, read from "
+		+ Ceylan::toString(
+			static_cast<Ceylan::Uint32>( _treeLocations.size() ) )
+		+ " element(s) of the search path." ) ;
+
+#endif // OSDL_USES_PHYSICSFS
+
+}
+
+
+
+bool EmbeddedFileSystemManager::indexDirectory( const string & directoryPath,
+	TreeNode & directoryNode )
+{
+
+#if OSDL_USES_PHYSICSFS
+
+	directoryNode.location = locateTreeEntry( directoryPath ) ;
+
+	char ** entries = PHYSFS_enumerateFiles( directoryPath.c_str() ) ;
+
+	if ( entries == 0 )
+		return false ;
+
+	bool success = true ;
+
+	for ( char ** i = entries; *i != 0 && success; i++ )
+	{
+
+		string entryPath = directoryPath.empty() ? string( *i ) :
+			directoryPath + Separator + *i ;
+
+		TreeNode * entryNode = new TreeNode(
+			PHYSFS_isDirectory( entryPath.c_str() ) != 0 ) ;
+
+		directoryNode.children[ *i ] = entryNode ;
+		_treeEntryCount++ ;
+
+		if ( entryNode->isDirectory )
+			success = indexDirectory( entryPath, *entryNode ) ;
+		else
+			entryNode->location = locateTreeEntry( entryPath ) ;
+
+	}
+
+	PHYSFS_freeList( entries ) ;
+
+	return success ;
+
+#else // OSDL_USES_PHYSICSFS
+
+	return false ;
+
+#endif // OSDL_USES_PHYSICSFS
+
+}
+
+
+
+Ceylan::Uint32 EmbeddedFileSystemManager::locateTreeEntry(
+	const string & entryPath )
+{
+
+#if OSDL_USES_PHYSICSFS
+
+	const char * element = PHYSFS_getRealDir( entryPath.c_str() ) ;
+
+	if ( element == 0 )
+		return TreeNode::NoLocation ;
+
+	return getLocationRank( element ) ;
+
+#else // OSDL_USES_PHYSICSFS
+
+	return TreeNode::NoLocation ;
+
+#endif // OSDL_USES_PHYSICSFS
+
+}
+
+
+
+Ceylan::Uint32 EmbeddedFileSystemManager::getLocationRank(
+	const string & element )
+{
+
+	// Very few elements are mounted, a linear search is fine:
+	Ceylan::Uint32 count = static_cast<Ceylan::Uint32>(
+		_treeLocations.size() ) ;
+
+	for ( Ceylan::Uint32 i = 0; i < count; i++ )
+		if ( _treeLocations[i] == element )
+			return i ;
+
+	_treeLocations.push_back( element ) ;
+
+	return count ;
+
+}
+
+
+
+bool EmbeddedFileSystemManager::listElementEntries(
+	const string & actualElement, list< pair<string,bool> > & entries )
+{
+
+#if OSDL_USES_PHYSICSFS
+
+	// No other element is mounted there, hence none is scanned:
+	if ( PHYSFS_mount( actualElement.c_str(), TemporaryMountPoint.c_str(),
+			/* append */ 1 ) == 0 )
+		return false ;
+
+	bool success = listDirectoryEntries( TemporaryMountPoint, "", entries ) ;
+
+	if ( PHYSFS_removeFromSearchPath( actualElement.c_str() ) == 0 )
+		throw EmbeddedFileSystemManagerException(
+			"EmbeddedFileSystemManager::listElementEntries failed: "
+			"unable to unmount '" + actualElement
+			+ "' from the temporary mount point: " + GetBackendLastError() ) ;
+
+	return success ;
+
+#else // OSDL_USES_PHYSICSFS
+
+	return false ;
+
+#endif // OSDL_USES_PHYSICSFS
+
+}
+
+
+
+bool EmbeddedFileSystemManager::listDirectoryEntries(
+	const string & directoryPath, const string & relativePath,
+	list< pair<string,bool> > & entries )
+{
+
+#if OSDL_USES_PHYSICSFS
+
+	char ** names = PHYSFS_enumerateFiles( directoryPath.c_str() ) ;
+
+	if ( names == 0 )
+		return false ;
+
+	bool success = true ;
+
+	for ( char ** i = names; *i != 0 && success; i++ )
+	{
+
+		string entryPath = directoryPath + Separator + *i ;
+
+		string entryRelativePath = relativePath.empty() ? string( *i ) :
+			relativePath + Separator + *i ;
+
+		bool isDirectory = ( PHYSFS_isDirectory( entryPath.c_str() ) != 0 ) ;
+
+		entries.push_back( std::make_pair( entryRelativePath, isDirectory ) ) ;
+
+		if ( isDirectory )
+			success = listDirectoryEntries( entryPath, entryRelativePath,
+				entries ) ;
+
+	}
+
+	PHYSFS_freeList( names ) ;
+
+	return success ;
+
+#else // OSDL_USES_PHYSICSFS
+
+	return false ;
+
+#endif // OSDL_USES_PHYSICSFS
+
+}
+
+
+
+void EmbeddedFileSystemManager::insertElementEntries(
+	const string & actualElement, const string & mountPoint,
+	const list< pair<string,bool> > & entries, bool prepend )
+{
+
+	Ceylan::Uint32 location = getLocationRank( actualElement ) ;
+
+	Ceylan::Uint32 previousCount = _treeEntryCount ;
+
+	/*
+	 * The directories leading to the mount point are provided by the element
+	 * as well; then its entries are listed parents first:
+	 *
+	 */
+	list< pair<string,bool> > paths ;
+
+	string::size_type length = mountPoint.size() ;
+	string::size_type start = 0 ;
+
+	string prefix ;
+
+	while ( start < length )
+	{
+
+		string::size_type end = mountPoint.find( Separator, start ) ;
+
+		if ( end == string::npos )
+			end = length ;
+
+		if ( end != start )
+		{
+
+			prefix += mountPoint.substr( start, end - start ) + Separator ;
+
+			paths.push_back( std::make_pair(
+				prefix.substr( 0, prefix.size() - 1 ), true ) ) ;
+
+		}
+
+		start = end + 1 ;
+
+	}
+
+	for ( list< pair<string,bool> >::const_iterator it = entries.begin();
+			it != entries.end(); it++ )
+		paths.push_back( std::make_pair( prefix + (*it).first, (*it).second ) ) ;
+
+	for ( list< pair<string,bool> >::const_iterator it = paths.begin();
+			it != paths.end(); it++ )
+	{
+
+		const string & path = (*it).first ;
 
-	if ( res == 0 )
-		throw EmbeddedFileSystemManagerException(
-			"EmbeddedFileSystemManager::getWriteDirectory failed: "
-			"no write directory set." ) ;
+		string::size_type nameStart = path.rfind( Separator ) ;
 
-	return string( res ) ;
+		// The parent is already indexed, as listed before its entries:
+		bool indexed ;
 
-#else // OSDL_USES_PHYSICSFS
+		TreeNode * parent = const_cast<TreeNode *>( findTreeNode(
+			( nameStart == string::npos ) ? string() :
+				path.substr( 0, nameStart ), indexed ) ) ;
 
-	throw EmbeddedFileSystemManagerException(
-		"EmbeddedFileSystemManager::getWriteDirectory failed: "
-		"no PhysicsFS support available." ) ;
+		// Entries below a file overriding a directory are not visible:
+		if ( parent == 0 || ! parent->isDirectory )
+			continue ;
 
-#endif // OSDL_USES_PHYSICSFS
+		string name = ( nameStart == string::npos ) ? path :
+			path.substr( nameStart + 1 ) ;
 
-}
+		map<string,TreeNode *>::iterator child = parent->children.find( name ) ;
 
+		if ( child == parent->children.end() )
+		{
 
+			TreeNode * entryNode = new TreeNode( (*it).second ) ;
+			entryNode->location = location ;
 
-void EmbeddedFileSystemManager::setWriteDirectory(
-	const std::string & newWriteDirectory )
-{
+			parent->children[ name ] = entryNode ;
+			_treeEntryCount++ ;
 
-	/*
-	 * This is a member method, the embedded filesystem has thus already been
-	 * initialized in the EmbeddedFileSystemManager constructor.
-	 *
-	 */
+		}
+		else if ( prepend )
+		{
 
-#if OSDL_USES_PHYSICSFS
+			// The first element of the search path determines the entry:
+			TreeNode & entryNode = * (*child).second ;
 
-	if ( PHYSFS_setWriteDir( newWriteDirectory.c_str() ) == 0 )
-		throw EmbeddedFileSystemManagerException(
-			"EmbeddedFileSystemManager::setWriteDirectory failed: "
-			+ GetBackendLastError() ) ;
+			if ( ! (*it).second )
+				_treeEntryCount -= entryNode.clearChildren() ;
 
-	send( "Write directory set to " + newWriteDirectory ) ;
+			entryNode.isDirectory = (*it).second ;
+			entryNode.location = location ;
 
-#else // OSDL_USES_PHYSICSFS
+		}
 
-	throw EmbeddedFileSystemManagerException(
-		"EmbeddedFileSystemManager::setWriteDirectory failed: "
-		"no PhysicsFS support available." ) ;
+	}
 
-#endif // OSDL_USES_PHYSICSFS
+	send( "Virtual tree index updated: "
+		+ Ceylan::toString( _treeEntryCount - previousCount )
+		+ " entries added by '" + actualElement + "', for a total of "
+		+ Ceylan::toString( _treeEntryCount ) + "." ) ;
 
 }
 
 
 
-void EmbeddedFileSystemManager::mount(
-	const string & newActualFilesystemElement,
-	const string & mountPointInVirtualTree,
-	bool append )
+void EmbeddedFileSystemManager::removeElementEntries(
+	const string & actualElement )
 {
 
-	/*
-	 * This is a member method, the embedded filesystem has thus already been
-	 * initialized in the EmbeddedFileSystemManager constructor.
-	 *
-	 */
-
 #if OSDL_USES_PHYSICSFS
 
-	try
-	{
-
-		StandardFileSystemManager & standardManager =
-			StandardFileSystemManager::GetStandardFileSystemManager() ;
+	Ceylan::Uint32 count = static_cast<Ceylan::Uint32>(
+		_treeLocations.size() ) ;
 
-		if ( ! standardManager.existsAsEntry( newActualFilesystemElement ) )
-			throw EmbeddedFileSystemManagerException(
-				"EmbeddedFileSystemManager::mount failed "
-				"for non-existing filesystem element '"
-				+ newActualFilesystemElement + "'." ) ;
-	}
-	catch( const Ceylan::Exception & e )
-	{
+	Ceylan::Uint32 location = 0 ;
 
-		throw EmbeddedFileSystemManagerException(
-			"EmbeddedFileSystemManager::mount failed for filesystem element '"
-			+ newActualFilesystemElement + "': "
-			+ e.toString() ) ;
-	}
+	while ( location < count && _treeLocations[location] != actualElement )
+		location++ ;
 
+	// No entry was read from that element:
+	if ( location == count )
+		return ;
 
-	if ( PHYSFS_mount(
-			newActualFilesystemElement.c_str(),
-			mountPointInVirtualTree.c_str(),
-			append ) == 0 )
-		throw EmbeddedFileSystemManagerException(
-			"EmbeddedFileSystemManager::mount failed: "
-			+ GetBackendLastError() ) ;
+	Ceylan::Uint32 previousCount = _treeEntryCount ;
 
-	send( "Element '" + newActualFilesystemElement + "' mounted." ) ;
+	if ( _treeIndex->location == location )
+		_treeIndex->location = locateTreeEntry( /* root */ "" ) ;
 
-#else // OSDL_USES_PHYSICSFS
+	pruneTreeNode( *_treeIndex, /* root */ "", location ) ;
 
-	throw EmbeddedFileSystemManagerException(
-		"EmbeddedFileSystemManager::mount failed: "
-		"no PhysicsFS support available." ) ;
+	send( "Virtual tree index updated: "
+		+ Ceylan::toString( previousCount - _treeEntryCount )
+		+ " entries removed with '" + actualElement + "', for a total of "
+		+ Ceylan::toString( _treeEntryCount ) + "." ) ;
 
 #endif // OSDL_USES_PHYSICSFS
 
@@ -315,134 +1254,123 @@ void EmbeddedFileSystemManager::mount(
 
 
 
-void EmbeddedFileSystemManager::umount(
-	const std::string & actualFilesystemElement )
+void EmbeddedFileSystemManager::pruneTreeNode( TreeNode & directoryNode,
+	const string & directoryPath, Ceylan::Uint32 location )
 {
 
-	/*
-	 * This is a member method, the embedded filesystem has thus already been
-	 * initialized in the EmbeddedFileSystemManager constructor.
-	 *
-	 */
-
 #if OSDL_USES_PHYSICSFS
 
-  if ( _trackOpenFiles )
-  {
+	map<string,TreeNode *>::iterator it = directoryNode.children.begin() ;
 
-	if ( hasOpenFiles() )
+	while ( it != directoryNode.children.end() )
 	{
 
-	  LogPlug::error( "EmbeddedFileSystemManager umount called whereas "
-		"following files were still reported as open:"
-		+ Ceylan::formatStringList( Ceylan::encodeToROT13( _openFiles ) ) ) ;
+		string entryPath = directoryPath.empty() ? (*it).first :
+			directoryPath + Separator + (*it).first ;
 
-	}
+		TreeNode * entryNode = (*it).second ;
 
-  }
+		// Only the entries read from the removed element are looked up again:
+		if ( entryNode->location == location )
+		{
 
+			const char * element = PHYSFS_getRealDir( entryPath.c_str() ) ;
 
-  if ( PHYSFS_removeFromSearchPath( actualFilesystemElement.c_str() ) == 0 )
-	throw EmbeddedFileSystemManagerException(
-	  "EmbeddedFileSystemManager::umount failed for '"
-	  + actualFilesystemElement + "': "
-	  + GetBackendLastError() ) ;
+			if ( element == 0 )
+			{
 
-  send( "Element '" + actualFilesystemElement + "' unmounted." ) ;
+				_treeEntryCount -= 1 + entryNode->countEntries() ;
 
-#else // OSDL_USES_PHYSICSFS
+				delete entryNode ;
+				directoryNode.children.erase( it++ ) ;
 
-	throw EmbeddedFileSystemManagerException(
-	  "EmbeddedFileSystemManager::umount failed: "
-	  "no PhysicsFS support available." ) ;
+				continue ;
 
-#endif // OSDL_USES_PHYSICSFS
+			}
 
-}
+			bool isDirectory =
+				( PHYSFS_isDirectory( entryPath.c_str() ) != 0 ) ;
 
+			if ( ! isDirectory )
+				_treeEntryCount -= entryNode->clearChildren() ;
 
+			entryNode->isDirectory = isDirectory ;
+			entryNode->location = getLocationRank( element ) ;
 
-std::string EmbeddedFileSystemManager::getMountPointFor(
-	const string & actualFilesystemElement ) const
-{
+		}
 
-	/*
-	 * This is a member method, the embedded filesystem has thus already been
-	 * initialized in the EmbeddedFileSystemManager constructor.
-	 *
-	 */
+		if ( entryNode->isDirectory )
+			pruneTreeNode( *entryNode, entryPath, location ) ;
 
-#if OSDL_USES_PHYSICSFS
+		it++ ;
 
-	const char * res = PHYSFS_getMountPoint( actualFilesystemElement.c_str() ) ;
+	}
 
-	if ( res == 0 )
-		throw EmbeddedFileSystemManagerException(
-			"EmbeddedFileSystemManager::getMountPointFor failed: "
-			+ GetBackendLastError() ) ;
+#endif // OSDL_USES_PHYSICSFS
 
-	return string( res ) ;
+}
 
-#else // OSDL_USES_PHYSICSFS
 
-	throw EmbeddedFileSystemManagerException(
-		"EmbeddedFileSystemManager::getMountPointFor failed: "
-		"no PhysicsFS support available." ) ;
 
-#endif // OSDL_USES_PHYSICSFS
+const EmbeddedFileSystemManager::TreeNode *
+	EmbeddedFileSystemManager::findTreeNode( const string & entryPath,
+		bool & indexed ) const
+{
 
-}
+	indexed = ( _treeIndex != 0 && ! _treeIndexStale ) ;
 
+	if ( ! indexed )
+		return 0 ;
 
+	const TreeNode * node = _treeIndex ;
 
-std::list<std::string> EmbeddedFileSystemManager::getSearchPath() const
-{
+	string name ;
 
-	/*
-	 * This is a member method, the embedded filesystem has thus already been
-	 * initialized in the EmbeddedFileSystemManager constructor.
-	 *
-	 */
+	string::size_type length = entryPath.size() ;
+	string::size_type start = 0 ;
 
-#if OSDL_USES_PHYSICSFS
+	while ( start < length )
+	{
 
-	char ** paths = PHYSFS_getSearchPath() ;
+		string::size_type end = entryPath.find( Separator, start ) ;
 
-	if ( paths == 0 )
-		throw EmbeddedFileSystemManagerException(
-			"EmbeddedFileSystemManager::getSearchPath failed: "
-			+ GetBackendLastError() ) ;
+		if ( end == string::npos )
+			end = length ;
 
-	list<string> res ;
+		// Like PhysicsFS, ignores leading, trailing and repeated separators:
+		if ( end != start )
+		{
 
+			name.assign( entryPath, start, end - start ) ;
 
-	for ( ; *paths != 0; paths++ )
-		res.push_back( string( *paths ) ) ;
+			// Leaves to PhysicsFS the paths it may deem insecure:
+			if ( name == "." || name == ".."
+				|| name.find_first_of( ":\\" ) != string::npos )
+			{
 
-	/*
-	 * Cannot use:
-	 PHYSFS_freeList( paths ) ;
+				indexed = false ;
+				return 0 ;
 
-	 * or, otherwise a core dump (invalide glib pointer) is
-	 * triggered, or, with Valgrind:
-	 *  Invalid free() / delete / delete[]
-	 *  at 0x4C282ED: free (vg_replace_malloc.c:366)
-	 *  by 0x6BC5EB1: mallocAllocatorFree (physfs.c:2171)
-	 *  by 0x6BC2FA6: PHYSFS_freeList (physfs.c:874)
-	 *
-	 * (sorry for the small memory leak thus induced!)
-	 *
-	 */
+			}
 
-	return res ;
+			if ( ! node->isDirectory )
+				return 0 ;
 
-#else // OSDL_USES_PHYSICSFS
+			map<string,TreeNode *>::const_iterator it =
+				node->children.find( name ) ;
 
-	throw EmbeddedFileSystemManagerException(
-		"EmbeddedFileSystemManager::getSearchPath failed: "
-		"no PhysicsFS support available." ) ;
+			if ( it == node->children.end() )
+				return 0 ;
 
-#endif // OSDL_USES_PHYSICSFS
+			node = (*it).second ;
+
+		}
+
+		start = end + 1 ;
+
+	}
+
+	return node ;
 
 }
 
@@ -463,8 +1391,15 @@ bool EmbeddedFileSystemManager::existsAsEntry( const string & entryPath ) const
 
 #if OSDL_USES_PHYSICSFS
 
+	string actualPath = Ceylan::encodeToROT13( entryPath ) ;
+
+	IndexedEntryKind kind = lookupIndexedEntry( actualPath ) ;
+
+	if ( kind != NotIndexed )
+		return ( kind != NoEntry ) ;
+
 	// Apparently will find files *or* directories, thus only entries:
-	return ( PHYSFS_exists( Ceylan::encodeToROT13(entryPath).c_str() ) != 0 ) ;
+	return ( PHYSFS_exists( actualPath.c_str() ) != 0 ) ;
 
 #else // OSDL_USES_PHYSICSFS
 
@@ -578,8 +1513,34 @@ string EmbeddedFileSystemManager::getActualLocationFor(
 
 #if OSDL_USES_PHYSICSFS
 
-	const char * res = PHYSFS_getRealDir(
-		Ceylan::encodeToROT13( filename ).c_str() ) ;
+	string actualPath = Ceylan::encodeToROT13( filename ) ;
+
+	{
+
+#if OSDL_USES_SDL
+		TreeLock lock( _treeMutex ) ;
+#endif // OSDL_USES_SDL
+
+		bool indexed ;
+
+		const TreeNode * node = findTreeNode( actualPath, indexed ) ;
+
+		if ( indexed )
+		{
+
+			if ( node == 0 )
+				throw Ceylan::System::FileLookupFailed(
+					"EmbeddedFileSystemManager::getActualLocationFor failed: "
+					"no entry '" + filename + "' in the virtual tree." ) ;
+
+			if ( node->location != TreeNode::NoLocation )
+				return _treeLocations[ node->location ] ;
+
+		}
+
+	}
+
+	const char * res = PHYSFS_getRealDir( actualPath.c_str() ) ;
 
 	if ( res == 0 )
 		throw Ceylan::System::FileLookupFailed(
@@ -624,6 +1585,11 @@ bool EmbeddedFileSystemManager::existsAsFileOrSymbolicLink(
 
 	string actualPath = Ceylan::encodeToROT13( filename ) ;
 
+	IndexedEntryKind kind = lookupIndexedEntry( actualPath ) ;
+
+	if ( kind != NotIndexed )
+		return ( kind == IndexedFile ) ;
+
 	return ( ( ::PHYSFS_exists( actualPath.c_str() ) != 0 )
 		&& ( ::PHYSFS_isDirectory( actualPath.c_str() ) == 0 ) ) ;
 
@@ -682,6 +1648,8 @@ void EmbeddedFileSystemManager::removeFile( const string & filename )
 			"EmbeddedFileSystemManager::removeFile failed: "
 			+ GetBackendLastError() ) ;
 
+	declareTreeModification() ;
+
 #else // OSDL_USES_PHYSICSFS
 
 	throw FileRemoveFailed( "EmbeddedFileSystemManager::removeFile failed: "
@@ -892,6 +1860,8 @@ void EmbeddedFileSystemManager::allowSymbolicFiles( bool newStatus )
 
 	PHYSFS_permitSymbolicLinks( ( newStatus ? 1 : 0 ) ) ;
 
+	refreshTreeIndex() ;
+
 #else // OSDL_USES_PHYSICSFS
 
 	throw FileRemoveFailed(
@@ -966,8 +1936,14 @@ bool EmbeddedFileSystemManager::existsAsDirectory(
 
 #if OSDL_USES_PHYSICSFS
 
-	return ( PHYSFS_isDirectory(
-		Ceylan::encodeToROT13( directoryPath ).c_str() ) != 0 ) ;
+	string actualPath = Ceylan::encodeToROT13( directoryPath ) ;
+
+	IndexedEntryKind kind = lookupIndexedEntry( actualPath ) ;
+
+	if ( kind != NotIndexed )
+		return ( kind == IndexedDirectory ) ;
+
+	return ( PHYSFS_isDirectory( actualPath.c_str() ) != 0 ) ;
 
 #else // OSDL_USES_PHYSICSFS
 
@@ -1008,6 +1984,8 @@ void EmbeddedFileSystemManager::removeDirectory( const string & directoryPath,
 			"EmbeddedFileSystemManager::removeDirectory failed in 'rmdir' for "
 			+ directoryPath + ": " + GetBackendLastError() ) ;
 
+	declareTreeModification() ;
+
 #else // OSDL_USES_PHYSICSFS
 
 	throw EmbeddedFileSystemManagerException(
@@ -1257,6 +2235,25 @@ std::string EmbeddedFileSystemManager::GetBackendLastError()
 
 
 
+PooledAllocator::Counters EmbeddedFileSystemManager::getAllocationCounters()
+	const
+{
+
+#if OSDL_USES_PHYSICSFS
+
+	if ( PhysicsFSPool != 0 )
+		return PhysicsFSPool->getCounters() ;
+
+#endif // OSDL_USES_PHYSICSFS
+
+	throw EmbeddedFileSystemManagerException(
+		"EmbeddedFileSystemManager::getAllocationCounters failed: "
+		"the allocations of PhysicsFS are not pooled." ) ;
+
+}
+
+
+
 Ceylan::Byte EmbeddedFileSystemManager::GetXORByte()
 {
 
@@ -1270,8 +2267,29 @@ const string EmbeddedFileSystemManager::toString(
 	Ceylan::VerbosityLevels level ) const
 {
 
+	// The index and the opened files may be changed by other threads:
+#if OSDL_USES_SDL
+	TreeLock lock( _treeMutex ) ;
+#endif // OSDL_USES_SDL
+
 	string mes = "Embedded filesystem manager, "
-	  "based on the PhysicsFS backend " ;
+	  "based on the PhysicsFS backend, " ;
+
+	if ( _treeIndex == 0 )
+	  mes += "not indexing its virtual tree, " ;
+	else if ( _treeIndexStale )
+	  mes += "whose index of the virtual tree is out of date, " ;
+	else
+	  mes += "indexing the " + Ceylan::toString( _treeEntryCount )
+		+ " entries of its virtual tree, " ;
+
+#if OSDL_USES_PHYSICSFS
+
+	if ( PhysicsFSPool != 0 )
+	  mes += "pooling the allocations of PhysicsFS ("
+		+ PhysicsFSPool->toString( Ceylan::low ) + "), " ;
+
+#endif // OSDL_USES_PHYSICSFS
 
 	if ( _trackOpenFiles )
 	  return mes + listOpenFiles() ;
@@ -1304,11 +2322,8 @@ EmbeddedFileSystemManager &
 bool EmbeddedFileSystemManager::SecureEmbeddedFileSystemManager()
 {
 
-	// Returned value ignored, only side-effect wanted:
-	GetEmbeddedFileSystemManager( /* use cypher */ true ) ;
-
-	// Cyphering activated by default:
-	return true ;
+	// Cyphering activated by default, if the manager is created here:
+	return GetEmbeddedFileSystemManager( /* use cypher */ true )._cypher ;
 
 }
 
@@ -1337,9 +2352,25 @@ void EmbeddedFileSystemManager::RemoveEmbeddedFileSystemManager()
 EmbeddedFileSystemManager::EmbeddedFileSystemManager( bool cypherWritings,
   bool trackOpenedFiles ) :
   Ceylan::System::FileSystemManager( trackOpenedFiles ),
-  _cypher( cypherWritings )
+  _cypher( cypherWritings ),
+  _treeIndex( 0 ),
+  _treeEntryCount( 0 ),
+  _treeIndexing( true ),
+  _treeIndexStale( false ),
+  _treeMutex( 0 )
 {
 
+#if OSDL_USES_SDL
+
+	_treeMutex = SDL_CreateMutex() ;
+
+	if ( _treeMutex == 0 )
+		throw EmbeddedFileSystemManagerException(
+			"EmbeddedFileSystemManager constructor failed: "
+			"unable to create mutex: " + string( SDL_GetError() ) ) ;
+
+#endif // OSDL_USES_SDL
+
 #if OSDL_USES_PHYSICSFS
 
 	PHYSFS_Version compileTimePhysicsFSVersion ;
@@ -1383,11 +2414,47 @@ EmbeddedFileSystemManager::EmbeddedFileSystemManager( bool cypherWritings,
 	}
 
 
+	if ( PoolAllocations )
+	{
+
+		PHYSFS_Allocator allocator ;
+
+		allocator.Init    = InitPhysicsFSPool ;
+		allocator.Deinit  = DeinitPhysicsFSPool ;
+		allocator.Malloc  = PhysicsFSMalloc ;
+		allocator.Realloc = PhysicsFSRealloc ;
+		allocator.Free    = PhysicsFSFree ;
+
+		// Copied by PhysicsFS, which must not be initialized yet:
+		if ( PHYSFS_setAllocator( &allocator ) == 0 )
+			throw EmbeddedFileSystemManagerException(
+				"EmbeddedFileSystemManager constructor failed: "
+				"unable to set the PhysicsFS allocator: "
+				+ GetBackendLastError() ) ;
+
+		send( "Allocations of PhysicsFS will be pooled." ) ;
+
+	}
+	else
+	{
+
+		// Restores the default allocator, should a previous manager be pooled:
+		PHYSFS_setAllocator( 0 ) ;
+
+	}
+
 	if ( PHYSFS_init( LogPlug::GetFullExecutablePath().c_str() ) == 0 )
 		throw EmbeddedFileSystemManagerException(
 			"EmbeddedFileSystemManager constructor failed: "
 			+ GetBackendLastError() ) ;
 
+	if ( IndexedArchive::RegisterPhysicsFSArchiver() )
+		send( "Indexed archives can be mounted directly." ) ;
+	else
+		send( "Indexed archives cannot be mounted with this PhysicsFS "
+			"version (at least 3.0 needed): they can only be read through "
+			"IndexedArchive." ) ;
+
 	list<string> archiveTypes ;
 
 	string res = "Supported archive types are: " ;
@@ -1419,6 +2486,9 @@ EmbeddedFileSystemManager::EmbeddedFileSystemManager( bool cypherWritings,
 
 	}
 
+	// The search path is still empty, yet lookups are answered from the start:
+	refreshTreeIndex() ;
+
 
 #else // OSDL_USES_PHYSICSFS
 
@@ -1445,6 +2515,14 @@ EmbeddedFileSystemManager::~EmbeddedFileSystemManager() throw()
 
 #endif // OSDL_USES_PHYSICSFS
 
+	delete _treeIndex ;
+
+#if OSDL_USES_SDL
+
+	SDL_DestroyMutex( _treeMutex ) ;
+
+#endif // OSDL_USES_SDL
+
 	if ( _EmbeddedFileSystemManager == this )
 		_EmbeddedFileSystemManager = 0 ;
 
@@ -29,10 +29,20 @@
 
 
 
+#include "OSDLPooledAllocator.h" // for PooledAllocator::Counters
+
 #include "Ceylan.h"  // for inheritance and FileSystemManagerException
 
 
 #include <string>
+#include <list>
+#include <vector>
+#include <utility>  // for pair
+
+
+
+// No need to include SDL header here (declared even without SDL, see below):
+struct SDL_mutex ;
 
 
 
@@ -315,6 +325,129 @@ namespace OSDL
 
 
 
+			/**
+			 * Rebuilds the index of the virtual tree, which answers the
+			 * existence, location and listing queries on entries by walking
+			 * down their path, rather than by scanning each element of the
+			 * search path in turn.
+			 *
+			 * The index is updated incrementally by mount and umount, which
+			 * insert or remove only the entries of their element, and is
+			 * rebuilt whenever this manager changes the search path otherwise
+			 * (basic settings, symbolic link permission).
+			 *
+			 * Writes (file creation, removal, etc.) invalidate it instead, as
+			 * the write directory may be in the search path: lookups are then
+			 * delegated to PhysicsFS again until the next rebuild, that may be
+			 * requested here.
+			 *
+			 * @note The virtual tree is not indexed while symbolic links are
+			 * permitted, as they may form cycles.
+			 *
+			 * @note The index is protected by a mutex, so that other threads
+			 * (ex: the workers prefetching resources) may look up the virtual
+			 * tree while it is updated.
+			 *
+			 */
+			virtual void refreshTreeIndex() ;
+
+
+
+			/**
+			 * Sets whether the virtual tree should be indexed (the default),
+			 * and rebuilds or frees the index accordingly.
+			 *
+			 * Disabling indexing while mounting a series of elements, then
+			 * enabling it again, results in a single rebuild.
+			 *
+			 */
+			virtual void setTreeIndexing( bool newStatus ) ;
+
+
+
+			/**
+			 * Declares that the virtual tree may have changed because of a
+			 * write, hence that its index cannot be trusted anymore.
+			 *
+			 * @note Called by embedded files and directories, not to be called
+			 * by the user.
+			 *
+			 */
+			void declareTreeModification() ;
+
+
+
+			/**
+			 * Declares that specified file has just been opened.
+			 *
+			 * Embedded files may be opened and closed from worker threads
+			 * (ex: by resource prefetching or asynchronous image decoding),
+			 * hence the list of opened files is updated under a lock here.
+			 *
+			 * @note Called by embedded files, not to be called by the user.
+			 *
+			 */
+			void declareFileOpening( Ceylan::System::File & opened ) ;
+
+
+
+			/**
+			 * Declares that specified file is about to be closed.
+			 *
+			 * @note Called by embedded files, not to be called by the user.
+			 *
+			 * @see declareFileOpening
+			 *
+			 */
+			void declareFileClosing( Ceylan::System::File & closed ) ;
+
+
+
+			/// Describes what the index of the virtual tree knows of an entry.
+			enum IndexedEntryKind
+			{
+				NotIndexed,
+				NoEntry,
+				IndexedFile,
+				IndexedDirectory
+			} ;
+
+
+
+			/**
+			 * Looks up the specified entry in the index of the virtual tree.
+			 *
+			 * @param entryPath the path of the entry, as seen by PhysicsFS
+			 * (i.e. already encoded).
+			 *
+			 * @return NotIndexed if the index cannot answer (none available,
+			 * out of date, or a path that PhysicsFS may reject), in which case
+			 * PhysicsFS shall be queried instead.
+			 *
+			 */
+			IndexedEntryKind lookupIndexedEntry(
+				const std::string & entryPath ) const ;
+
+
+
+			/**
+			 * Adds to the specified list the names of the entries of the
+			 * specified directory, as PHYSFS_enumerateFiles would, i.e. in
+			 * sorted order, and none if the directory does not exist.
+			 *
+			 * @param directoryPath the path of the directory, as seen by
+			 * PhysicsFS (i.e. already encoded).
+			 *
+			 * @return false if the index cannot answer, in which case
+			 * PhysicsFS shall be queried instead.
+			 *
+			 */
+			bool getIndexedEntries( const std::string & directoryPath,
+				std::list<std::string> & entries ) const ;
+
+
+
+
 
 			// FileSystemManager-specific section.
 
@@ -992,6 +1125,20 @@ namespace OSDL
 
 
 
+			/**
+			 * Returns the allocation counters of the pool serving the
+			 * allocations of PhysicsFS.
+			 *
+			 * @throw EmbeddedFileSystemManagerException if these allocations
+			 * are not pooled.
+			 *
+			 * @see PoolAllocations
+			 *
+			 */
+			PooledAllocator::Counters getAllocationCounters() const ;
+
+
+
 			/**
 			 * Returns a user-friendly description of the state of this object.
 			 *
@@ -1155,6 +1302,21 @@ namespace OSDL
 
 
 
+			/**
+			 * Tells whether the allocations of PhysicsFS (file handles,
+			 * decompression buffers, enumeration lists, etc.) should be served
+			 * by a PooledAllocator (the default), rather than directly by the
+			 * heap, so that opening and listing many small members does not
+			 * fragment it.
+			 *
+			 * @note Only taken into account when an embedded filesystem manager
+			 * is created, as PhysicsFS is then initialized.
+			 *
+			 */
+			static bool PoolAllocations ;
+
+
+
 
 		private:
 
@@ -1167,6 +1329,168 @@ namespace OSDL
 
 
 
+			/**
+			 * A node of the index of the virtual tree, i.e. an entry.
+			 *
+			 * Defined in the implementation file.
+			 *
+			 */
+			struct TreeNode ;
+
+
+			/// The root of the index of the virtual tree, if any.
+			TreeNode * _treeIndex ;
+
+
+			/**
+			 * The actual filesystem elements (directories or archives) the
+			 * indexed entries are read from, as reported by PHYSFS_getRealDir.
+			 *
+			 */
+			std::vector<std::string> _treeLocations ;
+
+
+			/// The number of indexed entries.
+			Ceylan::Uint32 _treeEntryCount ;
+
+
+			/// Tells whether the virtual tree should be indexed.
+			bool _treeIndexing ;
+
+
+			/// Tells whether a write may have made the index out of date.
+			bool _treeIndexStale ;
+
+
+			/**
+			 * Protects the index of the virtual tree and its locations, and
+			 * the list of opened files.
+			 *
+			 * Null without SDL, yet always declared, so that the layout of
+			 * this class does not depend on configuration settings.
+			 *
+			 */
+			SDL_mutex * _treeMutex ;
+
+
+
+			/**
+			 * Rebuilds the index of the virtual tree from the whole search
+			 * path.
+			 *
+			 * @note The tree mutex must be held.
+			 *
+			 */
+			void rebuildTreeIndex() ;
+
+
+			/**
+			 * Adds to the specified list the entries of the specified element
+			 * of the actual filesystem, with their path relative to its root
+			 * and whether they are directories, parents first.
+			 *
+			 * The element is mounted alone on a temporary mount point for
+			 * that, hence it must not be mounted yet.
+			 *
+			 * @return false if the element could not be listed.
+			 *
+			 * @throw EmbeddedFileSystemManagerException if the element could
+			 * not be unmounted from the temporary mount point.
+			 *
+			 */
+			bool listElementEntries( const std::string & actualElement,
+				std::list< std::pair<std::string,bool> > & entries ) ;
+
+
+			/**
+			 * Lists, recursively, the entries of the specified directory of
+			 * the virtual tree.
+			 *
+			 * @return false if PhysicsFS could not enumerate a directory.
+			 *
+			 */
+			bool listDirectoryEntries( const std::string & directoryPath,
+				const std::string & relativePath,
+				std::list< std::pair<std::string,bool> > & entries ) ;
+
+
+			/**
+			 * Inserts in the index the specified entries of the specified
+			 * element, just mounted on the specified mount point.
+			 *
+			 * @param prepend tells whether the element was put first in the
+			 * search path, hence whether it overrides the entries already
+			 * indexed.
+			 *
+			 * @note The tree mutex must be held.
+			 *
+			 */
+			void insertElementEntries( const std::string & actualElement,
+				const std::string & mountPoint,
+				const std::list< std::pair<std::string,bool> > & entries,
+				bool prepend ) ;
+
+
+			/**
+			 * Removes from the index the entries read from the specified
+			 * element, just unmounted: only these entries are looked up
+			 * again, as they may also be provided by other elements.
+			 *
+			 * @note The tree mutex must be held.
+			 *
+			 */
+			void removeElementEntries( const std::string & actualElement ) ;
+
+
+			/**
+			 * Looks up again the entries of the specified directory node which
+			 * were read from the element of specified location, recursively.
+			 *
+			 */
+			void pruneTreeNode( TreeNode & directoryNode,
+				const std::string & directoryPath, Ceylan::Uint32 location ) ;
+
+
+
+			/**
+			 * Adds to the specified node the entries of the specified directory
+			 * of the virtual tree, recursively.
+			 *
+			 * @return false if PhysicsFS could not enumerate a directory.
+			 *
+			 */
+			bool indexDirectory( const std::string & directoryPath,
+				TreeNode & directoryNode ) ;
+
+
+			/**
+			 * Returns the rank in _treeLocations of the element the specified
+			 * entry is read from, adding it if needed.
+			 *
+			 */
+			Ceylan::Uint32 locateTreeEntry( const std::string & entryPath ) ;
+
+
+			/**
+			 * Returns the rank in _treeLocations of the specified element,
+			 * adding it if needed.
+			 *
+			 */
+			Ceylan::Uint32 getLocationRank( const std::string & element ) ;
+
+
+			/**
+			 * Returns the indexed node of the specified entry, or null if there
+			 * is no such entry.
+			 *
+			 * @param indexed set to false if the index cannot answer.
+			 *
+			 */
+			const TreeNode * findTreeNode( const std::string & entryPath,
+				bool & indexed ) const ;
+
+
+
 			/**
 			 * The byte that would be used for one cypher-pass against read and
 			 * written bytes.
@@ -34,22 +34,30 @@ using namespace OSDL ;
 
 using std::string ;
 
-extern const FileTag OSDL::SoundTag      = 1 ;
-extern const FileTag OSDL::MusicTag      = 2 ;
-extern const FileTag OSDL::PaletteTag    = 3 ;
-extern const FileTag OSDL::FrameTag      = 4 ;
+extern const FileTag OSDL::SoundTag         = 1 ;
+extern const FileTag OSDL::MusicTag         = 2 ;
+extern const FileTag OSDL::PaletteTag       = 3 ;
+extern const FileTag OSDL::FrameTag         = 4 ;
+extern const FileTag OSDL::RawImageTag      = 5 ;
+extern const FileTag OSDL::AtlasIndexTag    = 6 ;
+extern const FileTag OSDL::ResourceIndexTag = 7 ;
+extern const FileTag OSDL::ArchiveTag       = 8 ;
 
 
-const FileTag              FirstFreeTag  = 5 ;
+const FileTag              FirstFreeTag     = 9 ;
 
 
 
-const std::string SoundTagDescription    = "sound (PCM or IMA ADPCM)" ;
-const std::string MusicTagDescription    = "music (MP3)" ;
-const std::string PaletteTagDescription  = "color palette" ;
-const std::string FrameTagDescription    = "animation frame" ;
+const std::string SoundTagDescription         = "sound (PCM or IMA ADPCM)" ;
+const std::string MusicTagDescription         = "music (MP3)" ;
+const std::string PaletteTagDescription       = "color palette" ;
+const std::string FrameTagDescription         = "animation frame" ;
+const std::string RawImageTagDescription      = "raw pre-converted image" ;
+const std::string AtlasIndexTagDescription    = "image atlas index" ;
+const std::string ResourceIndexTagDescription = "compiled resource map" ;
+const std::string ArchiveTagDescription       = "indexed archive" ;
 
-const std::string UnknownTagDescription  = "unknown file format" ;
+const std::string UnknownTagDescription       = "unknown file format" ;
 
 
 
@@ -85,6 +93,22 @@ const std::string & OSDL::DescribeFileTag( FileTag tag )
 			return FrameTagDescription ;
 			break ;
 
+		case RawImageTag:
+			return RawImageTagDescription ;
+			break ;
+
+		case AtlasIndexTag:
+			return AtlasIndexTagDescription ;
+			break ;
+
+		case ResourceIndexTag:
+			return ResourceIndexTagDescription ;
+			break ;
+
+		case ArchiveTag:
+			return ArchiveTagDescription ;
+			break ;
+
 		default:
 			return UnknownTagDescription ;
 			break ;
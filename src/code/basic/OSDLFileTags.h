@@ -168,6 +168,71 @@ namespace OSDL
 
 
 
+	/**
+	 * Tag corresponding to an OSDL raw image, i.e. to the pixels of a surface
+	 * already converted to the pixel format it is to be used with, so that
+	 * loading it involves no decoding nor conversion.
+	 *
+	 * It is a header describing the pixel format, then a pixel payload
+	 * starting at an offset multiple of 64 bytes, possibly LZ4-compressed.
+	 *
+	 * The corresponding header after this tag is defined in:
+	 * trunk/src/code/video/twoDimensional/OSDLImage.h, see Image::SaveRaw.
+	 *
+	 * @see trunk/tools/media/video/imageToOSDLRaw.cc for the offline
+	 * converter.
+	 *
+	 */
+	extern OSDL_DLL const FileTag RawImageTag ;
+
+
+
+	/**
+	 * Tag corresponding to the index of an OSDL image atlas, i.e. to the
+	 * list of the pages of that atlas and of the location of each packed
+	 * image in these pages.
+	 *
+	 * The corresponding header after this tag is defined in:
+	 * trunk/src/code/video/twoDimensional/OSDLImageAtlas.h, see
+	 * ImageAtlas::SaveIndex.
+	 *
+	 * @see trunk/tools/media/video/imagesToOSDLAtlas.cc for the packer.
+	 *
+	 */
+	extern OSDL_DLL const FileTag AtlasIndexTag ;
+
+
+
+	/**
+	 * Tag corresponding to a compiled resource map, i.e. to the binary
+	 * counterpart of an XML resource map, with a hash table of the resource
+	 * paths.
+	 *
+	 * The corresponding header after this tag is defined in:
+	 * trunk/src/code/data/OSDLResourceIndex.h, see ResourceIndex.
+	 *
+	 * @see trunk/tools/media/compileOSDLResourceMap.cc for the compiler.
+	 *
+	 */
+	extern OSDL_DLL const FileTag ResourceIndexTag ;
+
+
+
+	/**
+	 * Tag corresponding to an indexed archive, i.e. to an archive whose
+	 * members are compressed per chunk, with a seek table allowing random
+	 * access.
+	 *
+	 * The corresponding header after this tag is defined in:
+	 * trunk/src/code/basic/OSDLIndexedArchive.h, see IndexedArchive.
+	 *
+	 * @see trunk/tools/media/buildOSDLArchive.cc for the builder.
+	 *
+	 */
+	extern OSDL_DLL const FileTag ArchiveTag ;
+
+
+
 
 	/**
 	 * Tells whether specified tag is a valid OSDL one.
@@ -0,0 +1,1369 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDLIndexedArchive.h"
+
+#include "OSDLFileTags.h"            // for ArchiveTag
+#include "OSDLUtils.h"               // for readLittleEndianUint32
+
+
+#ifdef OSDL_USES_CONFIG_H
+#include "OSDLConfig.h"              // for configure-time settings
+#endif // OSDL_USES_CONFIG_H
+
+#if OSDL_ARCH_NINTENDO_DS
+#include "OSDLConfigForNintendoDS.h" // for OSDL_USES_PHYSICSFS and al
+#endif // OSDL_ARCH_NINTENDO_DS
+
+
+#if OSDL_USES_PHYSICSFS
+#include "physfs.h"                  // for PHYSFS_registerArchiver
+#endif // OSDL_USES_PHYSICSFS
+
+
+#if OSDL_USES_ZLIB
+#include <zlib.h>                    // for compress2, uncompress
+#endif // OSDL_USES_ZLIB
+
+
+#include <algorithm>                 // for std::min
+#include <set>
+
+#include <cstring>                   // for memcpy
+#include <exception>                 // for std::exception
+
+
+
+using namespace OSDL ;
+
+using namespace Ceylan::System ;
+
+using std::string ;
+using std::list ;
+using std::vector ;
+
+using OSDL::Utils::readLittleEndianUint16 ;
+using OSDL::Utils::readLittleEndianUint32 ;
+
+
+
+/*
+ * Implementation notes:
+ *
+ * The seek table is read in full when the archive is opened: with the default
+ * 64 KiB chunks, it takes 4 bytes for each 64 KiB of content.
+ *
+ * The PhysicsFS archiver relies on the archiver API introduced by PhysicsFS
+ * 3.0 (the former 2.1 development branch); with older versions, indexed
+ * archives can still be read directly thanks to IndexedArchive.
+ *
+ */
+
+
+
+/// The size of a directory record, name excluded.
+const Ceylan::Uint32 MemberRecordSize = 12 ;
+
+
+/// The highest level of zlib compression.
+const int CompressionLevel = 9 ;
+
+
+const Ceylan::Uint32 IndexedArchive::DefaultChunkSize = 64 * 1024 ;
+
+const Ceylan::Uint32 IndexedArchive::MaximumChunkSize = 16 * 1024 * 1024 ;
+
+const Ceylan::Uint8 IndexedArchive::FormatVersion = 1 ;
+
+const Ceylan::Uint32 IndexedArchive::HeaderSize = 32 ;
+
+
+
+/// Appends a little-endian integer of specified byte count.
+static void AppendLittleEndian( vector<Ceylan::Byte> & buffer,
+	Ceylan::Uint32 value, Ceylan::Uint8 byteCount )
+{
+
+	for ( Ceylan::Uint8 i = 0; i < byteCount; i++ )
+	{
+
+		buffer.push_back( static_cast<Ceylan::Byte>( value & 0xff ) ) ;
+		value >>= 8 ;
+
+	}
+
+}
+
+
+
+/// Returns the number of chunks needed to store specified size.
+static Ceylan::Uint32 GetChunkCountFor( Size size, Ceylan::Uint32 chunkSize )
+{
+
+	return static_cast<Ceylan::Uint32>( ( size + chunkSize - 1 ) / chunkSize ) ;
+
+}
+
+
+
+
+IndexedArchiveException::IndexedArchiveException( const string & reason ) :
+	OSDL::Exception( reason )
+{
+
+}
+
+
+
+IndexedArchiveException::~IndexedArchiveException() throw()
+{
+
+}
+
+
+
+
+ArchiveSource::~ArchiveSource() throw()
+{
+
+}
+
+
+
+
+FileArchiveSource::FileArchiveSource( const string & archivePath ) :
+	_file( 0 )
+{
+
+	try
+	{
+
+		_file = & File::Open( archivePath ) ;
+
+	}
+	catch( const Ceylan::Exception & e )
+	{
+
+		throw IndexedArchiveException( "FileArchiveSource constructor failed: "
+			"unable to open '" + archivePath + "': " + e.toString() ) ;
+
+	}
+
+}
+
+
+
+FileArchiveSource::~FileArchiveSource() throw()
+{
+
+	delete _file ;
+
+}
+
+
+
+void FileArchiveSource::readAt( Ceylan::Uint32 offset, Ceylan::Byte * buffer,
+	Size length )
+{
+
+	try
+	{
+
+		_file->seek( offset ) ;
+		_file->readExactLength( buffer, length ) ;
+
+	}
+	catch( const Ceylan::Exception & e )
+	{
+
+		throw IndexedArchiveException( "FileArchiveSource::readAt failed: "
+			+ e.toString() ) ;
+
+	}
+
+}
+
+
+
+
+IndexedArchive::IndexedArchive( ArchiveSource & source ) :
+	_chunkSize( 0 )
+{
+
+	Ceylan::Byte header[ HeaderSize ] ;
+
+	source.readAt( 0, header, HeaderSize ) ;
+
+	if ( readLittleEndianUint16( header ) != ArchiveTag )
+		throw IndexedArchiveException( "IndexedArchive constructor failed: "
+			"not an indexed archive (wrong tag)." ) ;
+
+	if ( header[2] != FormatVersion )
+		throw IndexedArchiveException( "IndexedArchive constructor failed: "
+			"unsupported format version ("
+			+ Ceylan::toNumericalString( header[2] ) + ")." ) ;
+
+	_chunkSize = readLittleEndianUint32( header + 4 ) ;
+
+	Ceylan::Uint32 memberCount     = readLittleEndianUint32( header + 8 ) ;
+	Ceylan::Uint32 chunkCount      = readLittleEndianUint32( header + 12 ) ;
+	Ceylan::Uint32 directoryOffset = readLittleEndianUint32( header + 16 ) ;
+	Ceylan::Uint32 directorySize   = readLittleEndianUint32( header + 20 ) ;
+
+	/*
+	 * Each member record and each seek table entry takes at least four bytes,
+	 * this bounds the allocations below even for a corrupted header:
+	 *
+	 */
+	if ( _chunkSize == 0 || _chunkSize > MaximumChunkSize
+			|| directoryOffset < HeaderSize
+			|| memberCount > directorySize / MemberRecordSize
+			|| chunkCount >= directorySize / 4 )
+		throw IndexedArchiveException( "IndexedArchive constructor failed: "
+			"corrupted header." ) ;
+
+	vector<Ceylan::Byte> directory( directorySize ) ;
+
+	source.readAt( directoryOffset, & directory[0], directorySize ) ;
+
+	const Ceylan::Byte * current = & directory[0] ;
+	Size remaining = directorySize ;
+
+	_members.resize( memberCount ) ;
+
+	for ( Ceylan::Uint32 i = 0; i < memberCount; i++ )
+	{
+
+		if ( remaining < MemberRecordSize )
+			throw IndexedArchiveException( "IndexedArchive constructor failed: "
+				"truncated directory." ) ;
+
+		Ceylan::Uint32 nameLength = readLittleEndianUint16( current ) ;
+
+		Member & member = _members[i] ;
+
+		member.size       = readLittleEndianUint32( current + 4 ) ;
+		member.firstChunk = readLittleEndianUint32( current + 8 ) ;
+
+		current   += MemberRecordSize ;
+		remaining -= MemberRecordSize ;
+
+		if ( remaining < nameLength )
+			throw IndexedArchiveException( "IndexedArchive constructor failed: "
+				"truncated directory." ) ;
+
+		member.name.assign( reinterpret_cast<const char *>( current ),
+			nameLength ) ;
+
+		current   += nameLength ;
+		remaining -= nameLength ;
+
+		if ( member.name.empty()
+				|| ( i > 0 && ! ( _members[i-1].name < member.name ) ) )
+			throw IndexedArchiveException( "IndexedArchive constructor failed: "
+				"directory not strictly sorted." ) ;
+
+		if ( member.firstChunk > chunkCount
+				|| GetChunkCountFor( member.size, _chunkSize )
+					> chunkCount - member.firstChunk )
+			throw IndexedArchiveException( "IndexedArchive constructor failed: "
+				"member '" + member.name + "' out of the seek table." ) ;
+
+	}
+
+	if ( remaining != ( chunkCount + 1 ) * 4 )
+		throw IndexedArchiveException( "IndexedArchive constructor failed: "
+			"inconsistent seek table size." ) ;
+
+	_chunkOffsets.resize( chunkCount + 1 ) ;
+
+	for ( Ceylan::Uint32 i = 0; i <= chunkCount; i++ )
+	{
+
+		_chunkOffsets[i] = readLittleEndianUint32( current ) ;
+		current += 4 ;
+
+		Ceylan::Uint32 previous = ( i == 0 ) ? HeaderSize : _chunkOffsets[i-1] ;
+
+		if ( _chunkOffsets[i] < previous )
+			throw IndexedArchiveException( "IndexedArchive constructor failed: "
+				"seek table not sorted." ) ;
+
+	}
+
+	if ( _chunkOffsets[chunkCount] != directoryOffset )
+		throw IndexedArchiveException( "IndexedArchive constructor failed: "
+			"seek table not ending at the directory." ) ;
+
+}
+
+
+
+IndexedArchive::~IndexedArchive() throw()
+{
+
+}
+
+
+
+Ceylan::Uint32 IndexedArchive::getMemberCount() const
+{
+
+	return static_cast<Ceylan::Uint32>( _members.size() ) ;
+
+}
+
+
+
+Ceylan::Uint32 IndexedArchive::getChunkSize() const
+{
+
+	return _chunkSize ;
+
+}
+
+
+
+const string & IndexedArchive::getMemberName( Ceylan::Uint32 index ) const
+{
+
+	if ( index >= _members.size() )
+		throw IndexedArchiveException( "IndexedArchive::getMemberName failed: "
+			"no member #" + Ceylan::toString( index ) + "." ) ;
+
+	return _members[index].name ;
+
+}
+
+
+
+Size IndexedArchive::getMemberSize( Ceylan::Uint32 index ) const
+{
+
+	if ( index >= _members.size() )
+		throw IndexedArchiveException( "IndexedArchive::getMemberSize failed: "
+			"no member #" + Ceylan::toString( index ) + "." ) ;
+
+	return _members[index].size ;
+
+}
+
+
+
+bool IndexedArchive::findMember( const string & name,
+	Ceylan::Uint32 & index ) const
+{
+
+	Ceylan::Uint32 low = 0 ;
+	Ceylan::Uint32 high = static_cast<Ceylan::Uint32>( _members.size() ) ;
+
+	while ( low < high )
+	{
+
+		Ceylan::Uint32 middle = low + ( high - low ) / 2 ;
+
+		if ( _members[middle].name < name )
+			low = middle + 1 ;
+		else
+			high = middle ;
+
+	}
+
+	if ( low < _members.size() && _members[low].name == name )
+	{
+
+		index = low ;
+		return true ;
+
+	}
+
+	return false ;
+
+}
+
+
+
+bool IndexedArchive::isDirectory( const string & path ) const
+{
+
+	if ( path.empty() )
+		return true ;
+
+	string prefix = path + "/" ;
+
+	// The first name not lower than the prefix tells:
+	Ceylan::Uint32 low = 0 ;
+	Ceylan::Uint32 high = static_cast<Ceylan::Uint32>( _members.size() ) ;
+
+	while ( low < high )
+	{
+
+		Ceylan::Uint32 middle = low + ( high - low ) / 2 ;
+
+		if ( _members[middle].name < prefix )
+			low = middle + 1 ;
+		else
+			high = middle ;
+
+	}
+
+	return ( low < _members.size()
+		&& _members[low].name.compare( 0, prefix.size(), prefix ) == 0 ) ;
+
+}
+
+
+
+void IndexedArchive::getEntries( const string & directory,
+	list<string> & entries ) const
+{
+
+	string prefix = directory.empty() ? string() : directory + "/" ;
+
+	std::set<string> found ;
+
+	for ( vector<Member>::const_iterator it = _members.begin();
+		it != _members.end(); it++ )
+	{
+
+		const string & name = (*it).name ;
+
+		if ( name.size() <= prefix.size()
+				|| name.compare( 0, prefix.size(), prefix ) != 0 )
+			continue ;
+
+		string::size_type end = name.find( '/', prefix.size() ) ;
+
+		string entry = name.substr( prefix.size(),
+			( end == string::npos ) ? string::npos : end - prefix.size() ) ;
+
+		if ( found.insert( entry ).second )
+			entries.push_back( entry ) ;
+
+	}
+
+}
+
+
+
+Size IndexedArchive::readChunk( Ceylan::Uint32 memberIndex,
+	Ceylan::Uint32 chunkIndex, Ceylan::Byte * target,
+	ArchiveSource & source ) const
+{
+
+	const Member & member = _members[memberIndex] ;
+
+	Size offsetInMember = static_cast<Size>( chunkIndex ) * _chunkSize ;
+
+	if ( offsetInMember >= member.size )
+		throw IndexedArchiveException( "IndexedArchive::readChunk failed: "
+			"no chunk #" + Ceylan::toString( chunkIndex ) + " in member '"
+			+ member.name + "'." ) ;
+
+	Size expected = std::min<Size>( _chunkSize, member.size - offsetInMember ) ;
+
+	Ceylan::Uint32 globalIndex = member.firstChunk + chunkIndex ;
+
+	Size storedLength = _chunkOffsets[globalIndex + 1]
+		- _chunkOffsets[globalIndex] ;
+
+	// Stored as is:
+	if ( storedLength == expected )
+	{
+
+		source.readAt( _chunkOffsets[globalIndex], target, expected ) ;
+		return expected ;
+
+	}
+
+#if OSDL_USES_ZLIB
+
+	// No compressed chunk may be larger, bounds the allocation below:
+	if ( storedLength > ::compressBound( static_cast<uLong>( expected ) ) )
+		throw IndexedArchiveException( "IndexedArchive::readChunk failed: "
+			"chunk #" + Ceylan::toString( chunkIndex ) + " of member '"
+			+ member.name + "' is too large to be a compressed one." ) ;
+
+	vector<Ceylan::Byte> stored( storedLength ) ;
+
+	source.readAt( _chunkOffsets[globalIndex], & stored[0], storedLength ) ;
+
+	uLongf decompressedLength = static_cast<uLongf>( expected ) ;
+
+	if ( ::uncompress( target, & decompressedLength, & stored[0],
+			static_cast<uLong>( storedLength ) ) != Z_OK
+			|| decompressedLength != expected )
+		throw IndexedArchiveException( "IndexedArchive::readChunk failed: "
+			"chunk #" + Ceylan::toString( chunkIndex ) + " of member '"
+			+ member.name + "' is corrupted." ) ;
+
+	return expected ;
+
+#else // OSDL_USES_ZLIB
+
+	throw IndexedArchiveException( "IndexedArchive::readChunk failed: "
+		"compressed chunks cannot be read, as OSDL was built without zlib." ) ;
+
+#endif // OSDL_USES_ZLIB
+
+}
+
+
+
+const string IndexedArchive::toString( Ceylan::VerbosityLevels level ) const
+{
+
+	string res = "Indexed archive of "
+		+ Ceylan::toString( static_cast<Ceylan::Uint32>( _members.size() ) )
+		+ " member(s), stored in "
+		+ Ceylan::toString( static_cast<Ceylan::Uint32>(
+			_chunkOffsets.size() - 1 ) )
+		+ " chunk(s) of up to " + Ceylan::toString( _chunkSize ) + " bytes" ;
+
+	if ( level != Ceylan::high || _members.empty() )
+		return res ;
+
+	list<string> members ;
+
+	for ( vector<Member>::const_iterator it = _members.begin();
+		it != _members.end(); it++ )
+		members.push_back( "'" + (*it).name + "' ("
+			+ Ceylan::toString( static_cast<Ceylan::Uint32>( (*it).size ) )
+			+ " bytes)" ) ;
+
+	return res + ": " + Ceylan::formatStringList( members ) ;
+
+}
+
+
+
+
+// Static section.
+
+
+
+void IndexedArchive::CompressChunks( const Ceylan::Byte * content, Size size,
+	Ceylan::Uint32 chunkSize, vector<Ceylan::Byte> & compressed,
+	vector<Ceylan::Uint32> & chunkLengths )
+{
+
+	if ( chunkSize == 0 )
+		throw IndexedArchiveException( "IndexedArchive::CompressChunks failed: "
+			"null chunk size." ) ;
+
+#if OSDL_USES_ZLIB
+
+	vector<Ceylan::Byte> buffer( ::compressBound( chunkSize ) ) ;
+
+#endif // OSDL_USES_ZLIB
+
+	for ( Size offset = 0; offset < size; offset += chunkSize )
+	{
+
+		Size length = std::min<Size>( chunkSize, size - offset ) ;
+
+		const Ceylan::Byte * source = content + offset ;
+		Size storedLength = length ;
+
+#if OSDL_USES_ZLIB
+
+		uLongf compressedLength = static_cast<uLongf>( buffer.size() ) ;
+
+		if ( ::compress2( & buffer[0], & compressedLength, source,
+				static_cast<uLong>( length ), CompressionLevel ) != Z_OK )
+			throw IndexedArchiveException(
+				"IndexedArchive::CompressChunks failed: zlib error." ) ;
+
+		// Otherwise stored as is, which tells the reader not to decompress:
+		if ( compressedLength < length )
+		{
+
+			source = & buffer[0] ;
+			storedLength = compressedLength ;
+
+		}
+
+#endif // OSDL_USES_ZLIB
+
+		compressed.insert( compressed.end(), source, source + storedLength ) ;
+		chunkLengths.push_back( static_cast<Ceylan::Uint32>( storedLength ) ) ;
+
+	}
+
+}
+
+
+
+void IndexedArchive::WriteDirectory( File & archiveFile,
+	Ceylan::Uint32 chunkSize, const vector<string> & names,
+	const vector<Size> & sizes, const vector< vector<Ceylan::Uint32> > &
+		chunkLengths, const vector<Ceylan::Uint32> & sharedWith )
+{
+
+	if ( names.size() != sizes.size() || names.size() != chunkLengths.size()
+			|| names.size() != sharedWith.size() )
+		throw IndexedArchiveException( "IndexedArchive::WriteDirectory failed: "
+			"inconsistent member descriptions." ) ;
+
+	vector<Ceylan::Byte> directory ;
+	vector<Ceylan::Uint32> offsets ;
+	vector<Ceylan::Uint32> firstChunks( names.size() ) ;
+
+	Ceylan::Uint32 offset = HeaderSize ;
+
+	for ( Ceylan::Uint32 i = 0; i < names.size(); i++ )
+	{
+
+		if ( names[i].empty() || names[i].size() > 0xffff
+				|| ( i > 0 && ! ( names[i-1] < names[i] ) ) )
+			throw IndexedArchiveException(
+				"IndexedArchive::WriteDirectory failed: member name '"
+				+ names[i] + "' is empty, too long or not sorted." ) ;
+
+		Ceylan::Uint32 owner = sharedWith[i] ;
+
+		if ( owner > i || sizes[owner] != sizes[i] )
+			throw IndexedArchiveException(
+				"IndexedArchive::WriteDirectory failed: '" + names[i]
+				+ "' cannot share the content of member #"
+				+ Ceylan::toString( owner ) + "." ) ;
+
+		if ( owner == i )
+		{
+
+			if ( chunkLengths[i].size()
+					!= GetChunkCountFor( sizes[i], chunkSize ) )
+				throw IndexedArchiveException(
+					"IndexedArchive::WriteDirectory failed: "
+					"wrong chunk count for '" + names[i] + "'." ) ;
+
+			firstChunks[i] = static_cast<Ceylan::Uint32>( offsets.size() ) ;
+
+			for ( vector<Ceylan::Uint32>::const_iterator it =
+				chunkLengths[i].begin(); it != chunkLengths[i].end(); it++ )
+			{
+
+				offsets.push_back( offset ) ;
+				offset += *it ;
+
+			}
+
+		}
+		else
+		{
+
+			firstChunks[i] = firstChunks[owner] ;
+
+		}
+
+		AppendLittleEndian( directory,
+			static_cast<Ceylan::Uint32>( names[i].size() ), 2 ) ;
+
+		// Reserved flags:
+		AppendLittleEndian( directory, 0, 2 ) ;
+
+		AppendLittleEndian( directory,
+			static_cast<Ceylan::Uint32>( sizes[i] ), 4 ) ;
+
+		AppendLittleEndian( directory, firstChunks[i], 4 ) ;
+
+		directory.insert( directory.end(), names[i].begin(), names[i].end() ) ;
+
+	}
+
+	// Then the directory offset:
+	offsets.push_back( offset ) ;
+
+	for ( vector<Ceylan::Uint32>::const_iterator it = offsets.begin();
+			it != offsets.end(); it++ )
+		AppendLittleEndian( directory, *it, 4 ) ;
+
+	vector<Ceylan::Byte> header ;
+
+	AppendLittleEndian( header, ArchiveTag, 2 ) ;
+	AppendLittleEndian( header, FormatVersion, 1 ) ;
+	AppendLittleEndian( header, 0, 1 ) ;
+	AppendLittleEndian( header, chunkSize, 4 ) ;
+	AppendLittleEndian( header, static_cast<Ceylan::Uint32>( names.size() ),
+		4 ) ;
+	AppendLittleEndian( header,
+		static_cast<Ceylan::Uint32>( offsets.size() - 1 ), 4 ) ;
+	AppendLittleEndian( header, offset, 4 ) ;
+	AppendLittleEndian( header, static_cast<Ceylan::Uint32>(
+		directory.size() ), 4 ) ;
+
+	header.resize( HeaderSize, 0 ) ;
+
+	try
+	{
+
+		archiveFile.write( & directory[0], directory.size() ) ;
+
+		archiveFile.seek( 0 ) ;
+		archiveFile.write( & header[0], header.size() ) ;
+
+	}
+	catch( const Ceylan::Exception & e )
+	{
+
+		throw IndexedArchiveException( "IndexedArchive::WriteDirectory failed: "
+			+ e.toString() ) ;
+
+	}
+
+}
+
+
+
+
+#if OSDL_USES_PHYSICSFS && PHYSFS_VER_MAJOR >= 3
+
+
+/*
+ * PhysicsFS archiver.
+ *
+ * An archive is read through the PhysicsFS I/O it is opened with, each opened
+ * member through a duplicate of that I/O, so that members can be read
+ * concurrently with no seek interference.
+ *
+ */
+
+
+
+/// Archive source reading through a PhysicsFS I/O, which it may own.
+class PhysicsFSArchiveSource : public ArchiveSource
+{
+
+	public:
+
+
+		PhysicsFSArchiveSource( PHYSFS_Io * io, bool owned ) :
+			_io( io ),
+			_owned( owned )
+		{
+
+		}
+
+
+		virtual ~PhysicsFSArchiveSource() throw()
+		{
+
+			if ( _owned )
+				_io->destroy( _io ) ;
+
+		}
+
+
+		virtual void readAt( Ceylan::Uint32 offset, Ceylan::Byte * buffer,
+			Size length )
+		{
+
+			if ( _io->seek( _io, offset ) == 0
+					|| _io->read( _io, buffer, length )
+						!= static_cast<PHYSFS_sint64>( length ) )
+				throw IndexedArchiveException(
+					"PhysicsFSArchiveSource::readAt failed." ) ;
+
+		}
+
+
+		PHYSFS_Io * getIo()
+		{
+
+			return _io ;
+
+		}
+
+
+	private:
+
+		PHYSFS_Io * _io ;
+
+		bool _owned ;
+
+} ;
+
+
+
+/// An opened archive: its source (owning the archive I/O) and directory.
+struct ArchiveState
+{
+
+	PhysicsFSArchiveSource * source ;
+
+	IndexedArchive * archive ;
+
+} ;
+
+
+
+/// An opened member: its own source, and its stream.
+struct MemberState
+{
+
+	const IndexedArchive * archive ;
+
+	PhysicsFSArchiveSource * source ;
+
+	ArchiveMemberStream * stream ;
+
+} ;
+
+
+
+static PHYSFS_Io * CreateMemberIo( const IndexedArchive & archive,
+	Ceylan::Uint32 memberIndex, PHYSFS_Io * archiveIo, Size position ) ;
+
+
+
+static PHYSFS_sint64 MemberRead( PHYSFS_Io * io, void * buffer,
+	PHYSFS_uint64 length )
+{
+
+	MemberState * state = static_cast<MemberState *>( io->opaque ) ;
+
+	try
+	{
+
+		return static_cast<PHYSFS_sint64>( state->stream->read(
+			static_cast<Ceylan::Byte *>( buffer ),
+			static_cast<Size>( length ) ) ) ;
+
+	}
+	catch( const IndexedArchiveException & )
+	{
+
+		PHYSFS_setErrorCode( PHYSFS_ERR_CORRUPT ) ;
+		return -1 ;
+
+	}
+	catch( const std::exception & )
+	{
+
+		PHYSFS_setErrorCode( PHYSFS_ERR_OUT_OF_MEMORY ) ;
+		return -1 ;
+
+	}
+
+}
+
+
+
+static PHYSFS_sint64 MemberWrite( PHYSFS_Io *, const void *, PHYSFS_uint64 )
+{
+
+	PHYSFS_setErrorCode( PHYSFS_ERR_READ_ONLY ) ;
+	return -1 ;
+
+}
+
+
+
+static int MemberSeek( PHYSFS_Io * io, PHYSFS_uint64 offset )
+{
+
+	MemberState * state = static_cast<MemberState *>( io->opaque ) ;
+
+	if ( ! state->stream->seek( static_cast<Size>( offset ) ) )
+	{
+
+		PHYSFS_setErrorCode( PHYSFS_ERR_PAST_EOF ) ;
+		return 0 ;
+
+	}
+
+	return 1 ;
+
+}
+
+
+
+static PHYSFS_sint64 MemberTell( PHYSFS_Io * io )
+{
+
+	return static_cast<PHYSFS_sint64>(
+		static_cast<MemberState *>( io->opaque )->stream->tell() ) ;
+
+}
+
+
+
+static PHYSFS_sint64 MemberLength( PHYSFS_Io * io )
+{
+
+	return static_cast<PHYSFS_sint64>(
+		static_cast<MemberState *>( io->opaque )->stream->size() ) ;
+
+}
+
+
+
+static PHYSFS_Io * MemberDuplicate( PHYSFS_Io * io )
+{
+
+	MemberState * state = static_cast<MemberState *>( io->opaque ) ;
+
+	return CreateMemberIo( * state->archive,
+		state->stream->getMemberIndex(), state->source->getIo(),
+		state->stream->tell() ) ;
+
+}
+
+
+
+static int MemberFlush( PHYSFS_Io * )
+{
+
+	return 1 ;
+
+}
+
+
+
+static void MemberDestroy( PHYSFS_Io * io )
+{
+
+	MemberState * state = static_cast<MemberState *>( io->opaque ) ;
+
+	delete state->stream ;
+	delete state->source ;
+	delete state ;
+
+	delete io ;
+
+}
+
+
+
+/**
+ * Returns a new I/O on specified member, reading through a duplicate of the
+ * specified archive I/O, or null on failure.
+ *
+ */
+static PHYSFS_Io * CreateMemberIo( const IndexedArchive & archive,
+	Ceylan::Uint32 memberIndex, PHYSFS_Io * archiveIo, Size position )
+{
+
+	PHYSFS_Io * duplicate = archiveIo->duplicate( archiveIo ) ;
+
+	if ( duplicate == 0 )
+		return 0 ;
+
+	MemberState * state = new MemberState ;
+
+	state->archive = & archive ;
+	state->source  = new PhysicsFSArchiveSource( duplicate,
+		/* owned */ true ) ;
+	state->stream  = new ArchiveMemberStream( archive, memberIndex,
+		* state->source ) ;
+
+	state->stream->seek( position ) ;
+
+	PHYSFS_Io * io = new PHYSFS_Io ;
+
+	io->version   = 0 ;
+	io->opaque    = state ;
+	io->read      = MemberRead ;
+	io->write     = MemberWrite ;
+	io->seek      = MemberSeek ;
+	io->tell      = MemberTell ;
+	io->length    = MemberLength ;
+	io->duplicate = MemberDuplicate ;
+	io->flush     = MemberFlush ;
+	io->destroy   = MemberDestroy ;
+
+	return io ;
+
+}
+
+
+
+/// Returns the archive-relative path corresponding to a PhysicsFS one.
+static string ToArchivePath( const char * path )
+{
+
+	string res( path ) ;
+
+	while ( ! res.empty() && res[ res.size() - 1 ] == '/' )
+		res.erase( res.size() - 1 ) ;
+
+	return res ;
+
+}
+
+
+
+static void * OpenArchive( PHYSFS_Io * io, const char *, int forWrite,
+	int * claimed )
+{
+
+	if ( forWrite )
+	{
+
+		PHYSFS_setErrorCode( PHYSFS_ERR_READ_ONLY ) ;
+		return 0 ;
+
+	}
+
+	Ceylan::Byte tag[2] ;
+
+	if ( io->seek( io, 0 ) == 0 || io->read( io, tag, 2 ) != 2
+			|| readLittleEndianUint16( tag ) != ArchiveTag )
+	{
+
+		// Left to the other archivers (ex: zip ones, also using '.oar'):
+		PHYSFS_setErrorCode( PHYSFS_ERR_UNSUPPORTED ) ;
+		return 0 ;
+
+	}
+
+	*claimed = 1 ;
+
+	ArchiveState * state = new ArchiveState ;
+
+	// Owns the I/O only once opened, as PhysicsFS destroys it on failure:
+	state->source = new PhysicsFSArchiveSource( io, /* owned */ false ) ;
+
+	try
+	{
+
+		state->archive = new IndexedArchive( * state->source ) ;
+
+	}
+	catch( const IndexedArchiveException & )
+	{
+
+		delete state->source ;
+		delete state ;
+
+		PHYSFS_setErrorCode( PHYSFS_ERR_CORRUPT ) ;
+		return 0 ;
+
+	}
+	catch( const std::exception & )
+	{
+
+		// Ex: std::bad_alloc, which must not cross PhysicsFS either:
+		delete state->source ;
+		delete state ;
+
+		PHYSFS_setErrorCode( PHYSFS_ERR_OUT_OF_MEMORY ) ;
+		return 0 ;
+
+	}
+
+	delete state->source ;
+	state->source = new PhysicsFSArchiveSource( io, /* owned */ true ) ;
+
+	return state ;
+
+}
+
+
+
+static PHYSFS_EnumerateCallbackResult Enumerate( void * opaque,
+	const char * directory, PHYSFS_EnumerateCallback callback,
+	const char * originalDirectory, void * callbackData )
+{
+
+	ArchiveState * state = static_cast<ArchiveState *>( opaque ) ;
+
+	list<string> entries ;
+
+	state->archive->getEntries( ToArchivePath( directory ), entries ) ;
+
+	for ( list<string>::const_iterator it = entries.begin();
+		it != entries.end(); it++ )
+	{
+
+		PHYSFS_EnumerateCallbackResult result = callback( callbackData,
+			originalDirectory, (*it).c_str() ) ;
+
+		if ( result != PHYSFS_ENUM_OK )
+			return result ;
+
+	}
+
+	return PHYSFS_ENUM_OK ;
+
+}
+
+
+
+static PHYSFS_Io * OpenRead( void * opaque, const char * filename )
+{
+
+	ArchiveState * state = static_cast<ArchiveState *>( opaque ) ;
+
+	Ceylan::Uint32 index ;
+
+	if ( ! state->archive->findMember( ToArchivePath( filename ), index ) )
+	{
+
+		PHYSFS_setErrorCode( PHYSFS_ERR_NOT_FOUND ) ;
+		return 0 ;
+
+	}
+
+	return CreateMemberIo( * state->archive, index, state->source->getIo(),
+		/* position */ 0 ) ;
+
+}
+
+
+
+static PHYSFS_Io * OpenWrite( void *, const char * )
+{
+
+	PHYSFS_setErrorCode( PHYSFS_ERR_READ_ONLY ) ;
+	return 0 ;
+
+}
+
+
+
+static int Remove( void *, const char * )
+{
+
+	PHYSFS_setErrorCode( PHYSFS_ERR_READ_ONLY ) ;
+	return 0 ;
+
+}
+
+
+
+static int Stat( void * opaque, const char * filename, PHYSFS_Stat * stat )
+{
+
+	ArchiveState * state = static_cast<ArchiveState *>( opaque ) ;
+
+	string path = ToArchivePath( filename ) ;
+
+	Ceylan::Uint32 index ;
+
+	stat->modtime    = -1 ;
+	stat->createtime = -1 ;
+	stat->accesstime = -1 ;
+	stat->readonly   = 1 ;
+
+	if ( state->archive->findMember( path, index ) )
+	{
+
+		stat->filesize = static_cast<PHYSFS_sint64>(
+			state->archive->getMemberSize( index ) ) ;
+		stat->filetype = PHYSFS_FILETYPE_REGULAR ;
+
+		return 1 ;
+
+	}
+
+	if ( state->archive->isDirectory( path ) )
+	{
+
+		stat->filesize = 0 ;
+		stat->filetype = PHYSFS_FILETYPE_DIRECTORY ;
+
+		return 1 ;
+
+	}
+
+	PHYSFS_setErrorCode( PHYSFS_ERR_NOT_FOUND ) ;
+	return 0 ;
+
+}
+
+
+
+static void CloseArchive( void * opaque )
+{
+
+	ArchiveState * state = static_cast<ArchiveState *>( opaque ) ;
+
+	delete state->archive ;
+	delete state->source ;
+	delete state ;
+
+}
+
+
+#endif // OSDL_USES_PHYSICSFS && PHYSFS_VER_MAJOR >= 3
+
+
+
+bool IndexedArchive::RegisterPhysicsFSArchiver()
+{
+
+#if OSDL_USES_PHYSICSFS && PHYSFS_VER_MAJOR >= 3
+
+	static PHYSFS_Archiver archiver ;
+
+	archiver.version                = 0 ;
+	archiver.info.extension         = "oar" ;
+	archiver.info.description       = "OSDL indexed archive" ;
+	archiver.info.author            = "OSDL" ;
+	archiver.info.url               = "http://osdl.sourceforge.net" ;
+	archiver.info.supportsSymlinks  = 0 ;
+	archiver.openArchive            = OpenArchive ;
+	archiver.enumerate              = Enumerate ;
+	archiver.openRead               = OpenRead ;
+	archiver.openWrite              = OpenWrite ;
+	archiver.openAppend             = OpenWrite ;
+	archiver.remove                 = Remove ;
+	archiver.mkdir                  = Remove ;
+	archiver.stat                   = Stat ;
+	archiver.closeArchive           = CloseArchive ;
+
+	return ( PHYSFS_registerArchiver( & archiver ) != 0 ) ;
+
+#else // OSDL_USES_PHYSICSFS && PHYSFS_VER_MAJOR >= 3
+
+	return false ;
+
+#endif // OSDL_USES_PHYSICSFS && PHYSFS_VER_MAJOR >= 3
+
+}
+
+
+
+bool IndexedArchive::IsMountable()
+{
+
+#if OSDL_USES_PHYSICSFS && PHYSFS_VER_MAJOR >= 3
+
+	return true ;
+
+#else // OSDL_USES_PHYSICSFS && PHYSFS_VER_MAJOR >= 3
+
+	return false ;
+
+#endif // OSDL_USES_PHYSICSFS && PHYSFS_VER_MAJOR >= 3
+
+}
+
+
+
+
+ArchiveMemberStream::ArchiveMemberStream( const IndexedArchive & archive,
+		Ceylan::Uint32 memberIndex, ArchiveSource & source ) :
+	_archive( archive ),
+	_memberIndex( memberIndex ),
+	_source( source ),
+	_position( 0 ),
+	_chunk( archive.getChunkSize() ),
+	_chunkIndex( 0 ),
+	_chunkLength( 0 ),
+	_chunkValid( false )
+{
+
+	// Checks the index:
+	archive.getMemberSize( memberIndex ) ;
+
+}
+
+
+
+Size ArchiveMemberStream::read( Ceylan::Byte * buffer, Size length )
+{
+
+	Size memberSize = size() ;
+	Ceylan::Uint32 chunkSize = _archive.getChunkSize() ;
+
+	Size done = 0 ;
+
+	while ( done < length && _position < memberSize )
+	{
+
+		Ceylan::Uint32 chunkIndex =
+			static_cast<Ceylan::Uint32>( _position / chunkSize ) ;
+
+		if ( ! _chunkValid || _chunkIndex != chunkIndex )
+		{
+
+			_chunkValid = false ;
+
+			_chunkLength = _archive.readChunk( _memberIndex, chunkIndex,
+				& _chunk[0], _source ) ;
+
+			_chunkIndex = chunkIndex ;
+			_chunkValid = true ;
+
+		}
+
+		Size inChunk = _position - static_cast<Size>( chunkIndex ) * chunkSize ;
+
+		Size count = std::min<Size>( length - done, _chunkLength - inChunk ) ;
+
+		::memcpy( buffer + done, & _chunk[inChunk], count ) ;
+
+		done      += count ;
+		_position += count ;
+
+	}
+
+	return done ;
+
+}
+
+
+
+bool ArchiveMemberStream::seek( Size position )
+{
+
+	if ( position > size() )
+		return false ;
+
+	_position = position ;
+
+	return true ;
+
+}
+
+
+
+Size ArchiveMemberStream::tell() const
+{
+
+	return _position ;
+
+}
+
+
+
+Size ArchiveMemberStream::size() const
+{
+
+	return _archive.getMemberSize( _memberIndex ) ;
+
+}
+
+
+
+Ceylan::Uint32 ArchiveMemberStream::getMemberIndex() const
+{
+
+	return _memberIndex ;
+
+}
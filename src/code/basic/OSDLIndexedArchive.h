@@ -0,0 +1,550 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#ifndef OSDL_INDEXED_ARCHIVE_H_
+#define OSDL_INDEXED_ARCHIVE_H_
+
+
+#include "OSDLException.h"   // for OSDL::Exception
+
+#include "Ceylan.h"          // for inheritance, Byte, Uint32, File
+
+#include <string>
+#include <list>
+#include <vector>
+
+
+
+
+namespace OSDL
+{
+
+
+
+	/// Exception raised when an indexed archive cannot be read or written.
+	class OSDL_DLL IndexedArchiveException : public OSDL::Exception
+	{
+
+		public:
+
+			explicit IndexedArchiveException( const std::string & reason ) ;
+
+			virtual ~IndexedArchiveException() throw() ;
+
+	} ;
+
+
+
+	/**
+	 * Random-access source of the bytes of an indexed archive.
+	 *
+	 * A source is used by one thread at a time; concurrent readers of the
+	 * same archive each use their own source.
+	 *
+	 */
+	class OSDL_DLL ArchiveSource
+	{
+
+		public:
+
+
+			/// Virtual destructor.
+			virtual ~ArchiveSource() throw() ;
+
+
+			/**
+			 * Reads exactly the specified number of bytes, from the specified
+			 * offset in archive.
+			 *
+			 * @throw IndexedArchiveException if the bytes could not be read.
+			 *
+			 */
+			virtual void readAt( Ceylan::Uint32 offset, Ceylan::Byte * buffer,
+				Ceylan::System::Size length ) = 0 ;
+
+	} ;
+
+
+
+	/**
+	 * Archive source reading an archive through a Ceylan file, which it owns.
+	 *
+	 */
+	class OSDL_DLL FileArchiveSource : public ArchiveSource
+	{
+
+		public:
+
+
+			/**
+			 * Opens the specified archive file.
+			 *
+			 * @throw IndexedArchiveException if the file could not be opened.
+			 *
+			 */
+			explicit FileArchiveSource( const std::string & archivePath ) ;
+
+
+			/// Virtual destructor, closing the file.
+			virtual ~FileArchiveSource() throw() ;
+
+
+			virtual void readAt( Ceylan::Uint32 offset, Ceylan::Byte * buffer,
+				Ceylan::System::Size length ) ;
+
+
+		private:
+
+
+			/// The archive file, owned.
+			Ceylan::System::File * _file ;
+
+
+			FileArchiveSource( const FileArchiveSource & source ) ;
+			FileArchiveSource & operator = (
+				const FileArchiveSource & source ) ;
+
+	} ;
+
+
+
+	/**
+	 * Reader of OSDL indexed archives.
+	 *
+	 * Unlike solid 7z archives, whose members have to be decompressed from the
+	 * start of their block, and unlike zip archives, whose compressed members
+	 * have to be inflated again from their start whenever seeking backward,
+	 * each member of an indexed archive is split into chunks compressed
+	 * independently, whose offsets are listed in a seek table: reaching any
+	 * position requires decompressing at most one chunk.
+	 *
+	 * Format (all integers are little-endian):
+	 *
+	 *  - header (32 bytes): ArchiveTag (Uint16), version (Uint8), reserved
+	 * (Uint8), chunk size (Uint32), member count (Uint32), chunk count
+	 * (Uint32), directory offset and size (Uint32 each), reserved (8 bytes)
+	 *
+	 *  - the chunks of all members, in directory order; a chunk is stored as
+	 * is if zlib could not make it smaller, otherwise it is a zlib stream
+	 *
+	 *  - the directory: for each member, sorted by name, the length of its
+	 * name (Uint16), reserved flags (Uint16), its size (Uint32), the index of
+	 * its first chunk (Uint32) and its name (in the embedded filesystem
+	 * notation, hence with '/' as separator, and ROT13-encoded as well); then
+	 * the seek table, i.e. the offsets in archive of all chunks, followed by
+	 * the offset of the directory
+	 *
+	 * Contents are stored as given, hence cyphered if the archive is meant to
+	 * be read through the (cyphering) embedded filesystem.
+	 *
+	 * Members of identical contents may share the same chunks, so that such a
+	 * content is stored only once.
+	 *
+	 * @see the buildOSDLArchive tool, in tools/media, which creates such
+	 * archives.
+	 *
+	 */
+	class OSDL_DLL IndexedArchive : public Ceylan::TextDisplayable
+	{
+
+
+		public:
+
+
+
+			/**
+			 * Reads the directory of the archive available from the
+			 * specified source, which is only used during this constructor.
+			 *
+			 * @throw IndexedArchiveException if the archive is not a valid
+			 * indexed archive.
+			 *
+			 */
+			explicit IndexedArchive( ArchiveSource & source ) ;
+
+
+
+			/// Virtual destructor.
+			virtual ~IndexedArchive() throw() ;
+
+
+
+			/// Returns the number of members (files) of this archive.
+			Ceylan::Uint32 getMemberCount() const ;
+
+
+
+			/// Returns the size of the chunks of this archive, in bytes.
+			Ceylan::Uint32 getChunkSize() const ;
+
+
+
+			/**
+			 * Returns the name of the specified member.
+			 *
+			 * @throw IndexedArchiveException if there is no such member.
+			 *
+			 */
+			const std::string & getMemberName( Ceylan::Uint32 index ) const ;
+
+
+
+			/**
+			 * Returns the (decompressed) size of the specified member.
+			 *
+			 * @throw IndexedArchiveException if there is no such member.
+			 *
+			 */
+			Ceylan::System::Size getMemberSize( Ceylan::Uint32 index ) const ;
+
+
+
+			/**
+			 * Looks-up the member of specified name (binary search).
+			 *
+			 * @return true iff found, then index is set.
+			 *
+			 */
+			bool findMember( const std::string & name,
+				Ceylan::Uint32 & index ) const ;
+
+
+
+			/**
+			 * Tells whether the specified path is a directory of this archive,
+			 * i.e. a prefix of at least a member; the empty path is the root.
+			 *
+			 */
+			bool isDirectory( const std::string & path ) const ;
+
+
+
+			/**
+			 * Adds to the specified list the names of the entries (files and
+			 * directories) directly in the specified directory.
+			 *
+			 */
+			void getEntries( const std::string & directory,
+				std::list<std::string> & entries ) const ;
+
+
+
+			/**
+			 * Decompresses the specified chunk of the specified member.
+			 *
+			 * @param target the buffer receiving the decompressed chunk, of
+			 * at least getChunkSize() bytes.
+			 *
+			 * @param source the source to read the chunk from.
+			 *
+			 * @return the size of the decompressed chunk (smaller than the
+			 * chunk size for the last chunk of a member).
+			 *
+			 * @throw IndexedArchiveException if the chunk could not be read or
+			 * is corrupted.
+			 *
+			 */
+			Ceylan::System::Size readChunk( Ceylan::Uint32 memberIndex,
+				Ceylan::Uint32 chunkIndex, Ceylan::Byte * target,
+				ArchiveSource & source ) const ;
+
+
+
+			/**
+			 * Returns an user-friendly description of the state of this object.
+			 *
+			 * @param level the requested verbosity level.
+			 *
+			 * @note Text output format is determined from overall settings.
+			 *
+			 * @see TextDisplayable
+			 *
+			 */
+			virtual const std::string toString(
+				Ceylan::VerbosityLevels level = Ceylan::high ) const ;
+
+
+
+
+			// Static section.
+
+
+
+			/**
+			 * Compresses the specified content, chunk per chunk.
+			 *
+			 * Meant to be called concurrently by archive writers: it relies
+			 * on no shared state.
+			 *
+			 * @param content the content to compress.
+			 *
+			 * @param size the size of that content, in bytes.
+			 *
+			 * @param chunkSize the size of the chunks to compress separately.
+			 *
+			 * @param compressed the buffer to which the chunks are appended.
+			 *
+			 * @param chunkLengths the list to which the stored size of each
+			 * chunk is appended.
+			 *
+			 * @throw IndexedArchiveException if compression failed.
+			 *
+			 */
+			static void CompressChunks( const Ceylan::Byte * content,
+				Ceylan::System::Size size, Ceylan::Uint32 chunkSize,
+				std::vector<Ceylan::Byte> & compressed,
+				std::vector<Ceylan::Uint32> & chunkLengths ) ;
+
+
+
+			/**
+			 * Writes the directory and then the header of an archive whose
+			 * chunks have already been written, starting at HeaderSize.
+			 *
+			 * @param archiveFile the archive being written, positioned right
+			 * after the last chunk.
+			 *
+			 * @param names the names of the members, sorted, as they are
+			 * to be found in the embedded filesystem.
+			 *
+			 * @param sizes the sizes of the members.
+			 *
+			 * @param chunkLengths, for each member, the stored size of each of
+			 * its chunks, as returned by CompressChunks.
+			 *
+			 * @param sharedWith, for each member, either its own index, if
+			 * its chunks have been written, or the index of a previous member
+			 * of identical content, whose chunks it shares (no chunk has been
+			 * written for it then).
+			 *
+			 * @throw IndexedArchiveException if the directory or the header
+			 * could not be written, or if names are not sorted.
+			 *
+			 */
+			static void WriteDirectory( Ceylan::System::File & archiveFile,
+				Ceylan::Uint32 chunkSize,
+				const std::vector<std::string> & names,
+				const std::vector<Ceylan::System::Size> & sizes,
+				const std::vector< std::vector<Ceylan::Uint32> > &
+					chunkLengths,
+				const std::vector<Ceylan::Uint32> & sharedWith ) ;
+
+
+
+			/**
+			 * Registers the PhysicsFS archiver for indexed archives, so that
+			 * they can be mounted as any other archive ('oar' extension).
+			 *
+			 * @return true iff the archiver could be registered, which
+			 * requires PhysicsFS 3.0 or later (older versions do not allow
+			 * external archivers).
+			 *
+			 * @note Called by the embedded filesystem manager once PhysicsFS
+			 * is initialized.
+			 *
+			 */
+			static bool RegisterPhysicsFSArchiver() ;
+
+
+
+			/**
+			 * Tells whether this OSDL build can mount indexed archives, i.e.
+			 * whether it was built against PhysicsFS 3.0 or later.
+			 *
+			 * @note Archive creation tools check it, as archives that cannot
+			 * be mounted are of no use.
+			 *
+			 */
+			static bool IsMountable() ;
+
+
+
+			/// The default size of chunks, in bytes.
+			static const Ceylan::Uint32 DefaultChunkSize ;
+
+
+			/**
+			 * The maximum size of chunks, in bytes, as each stream reading a
+			 * member allocates a whole chunk (archives of larger chunks are
+			 * deemed corrupted).
+			 *
+			 */
+			static const Ceylan::Uint32 MaximumChunkSize ;
+
+
+			/// The version of the format written and read.
+			static const Ceylan::Uint8 FormatVersion ;
+
+
+			/// The size of the archive header, in bytes.
+			static const Ceylan::Uint32 HeaderSize ;
+
+
+
+
+		protected:
+
+
+
+			/// Description of a member of this archive.
+			struct Member
+			{
+
+				/// The name of this member.
+				std::string name ;
+
+				/// The decompressed size of this member.
+				Ceylan::System::Size size ;
+
+				/// The index in the seek table of its first chunk.
+				Ceylan::Uint32 firstChunk ;
+
+			} ;
+
+
+			/// The members, sorted by name.
+			std::vector<Member> _members ;
+
+
+			/// The seek table: offsets of all chunks, then of the directory.
+			std::vector<Ceylan::Uint32> _chunkOffsets ;
+
+
+			/// The size of the chunks, in bytes.
+			Ceylan::Uint32 _chunkSize ;
+
+
+
+
+		private:
+
+
+
+			/**
+			 * Copy constructor made private to ensure that it will never be
+			 * called.
+			 *
+			 * The compiler should complain whenever this undefined constructor
+			 * is called, implicitly or not.
+			 *
+			 */
+			explicit IndexedArchive( const IndexedArchive & source ) ;
+
+
+
+			/**
+			 * Assignment operator made private to ensure that it will never be
+			 * called.
+			 *
+			 * The compiler should complain whenever this undefined operator is
+			 * called, implicitly or not.
+			 *
+			 */
+			IndexedArchive & operator = ( const IndexedArchive & source ) ;
+
+
+	} ;
+
+
+
+	/**
+	 * Stream on a member of an indexed archive: seeking is immediate, and
+	 * reading decompresses only the chunks covering the read bytes (the last
+	 * chunk being kept for the next reads).
+	 *
+	 */
+	class OSDL_DLL ArchiveMemberStream
+	{
+
+		public:
+
+
+			/**
+			 * Creates a stream on the specified member, read from the
+			 * specified source; both must outlive this stream.
+			 *
+			 */
+			ArchiveMemberStream( const IndexedArchive & archive,
+				Ceylan::Uint32 memberIndex, ArchiveSource & source ) ;
+
+
+			/**
+			 * Reads up to the specified length, returns the number of bytes
+			 * read (less only at the end of the member).
+			 *
+			 * @throw IndexedArchiveException if the read failed.
+			 *
+			 */
+			Ceylan::System::Size read( Ceylan::Byte * buffer,
+				Ceylan::System::Size length ) ;
+
+
+			/**
+			 * Sets the position of the next read.
+			 *
+			 * @return false if the position is past the end of the member.
+			 *
+			 */
+			bool seek( Ceylan::System::Size position ) ;
+
+
+			/// Returns the position of the next read.
+			Ceylan::System::Size tell() const ;
+
+
+			/// Returns the size of the member.
+			Ceylan::System::Size size() const ;
+
+
+			/// Returns the index of the member in its archive.
+			Ceylan::Uint32 getMemberIndex() const ;
+
+
+		private:
+
+
+			const IndexedArchive & _archive ;
+
+			Ceylan::Uint32 _memberIndex ;
+
+			ArchiveSource & _source ;
+
+			Ceylan::System::Size _position ;
+
+			/// The last decompressed chunk, and its index (if valid).
+			std::vector<Ceylan::Byte> _chunk ;
+			Ceylan::Uint32 _chunkIndex ;
+			Ceylan::System::Size _chunkLength ;
+			bool _chunkValid ;
+
+	} ;
+
+
+}
+
+
+
+#endif // OSDL_INDEXED_ARCHIVE_H_
@@ -0,0 +1,481 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDLPooledAllocator.h"
+
+
+#ifdef OSDL_USES_CONFIG_H
+#include "OSDLConfig.h"              // for configure-time settings (SDL)
+#endif // OSDL_USES_CONFIG_H
+
+#if OSDL_ARCH_NINTENDO_DS
+#include "OSDLConfigForNintendoDS.h" // for OSDL_USES_SDL and al
+#endif // OSDL_ARCH_NINTENDO_DS
+
+
+#if OSDL_USES_SDL
+#include "SDL.h"                     // for SDL_GetError
+#include "SDL_thread.h"              // for SDL_CreateMutex and al
+#endif // OSDL_USES_SDL
+
+
+#include <cstdlib>                   // for malloc, realloc, free
+#include <cstring>                   // for memcpy, memset
+
+
+
+using namespace OSDL ;
+
+using namespace Ceylan::System ;
+
+using std::string ;
+
+
+
+/*
+ * Implementation notes:
+ *
+ * Each block is preceded by a header telling its size class, and the size
+ * requested for it while it is allocated, or the next free block of its class
+ * while it is free. Headers take HeaderSize bytes, so that blocks keep the
+ * alignment of the slabs, i.e. the one of malloc.
+ *
+ * Slabs are preceded by a header as well, to chain them for their release.
+ *
+ */
+
+
+
+/// The size reserved for the header of blocks and slabs.
+static const Size HeaderSize = 16 ;
+
+
+const Size PooledAllocator::MinimumBlockSize = 16 ;
+const Size PooledAllocator::MaximumBlockSize = 4096 ;
+const Size PooledAllocator::SlabSize         = 64 * 1024 ;
+
+
+
+struct PooledAllocator::BlockHeader
+{
+
+	union
+	{
+
+		/// The size requested for the block, while allocated.
+		Size size ;
+
+		/// The next free block of the same class, while free.
+		BlockHeader * nextFree ;
+
+	} ;
+
+
+	/// The size class of the block, or SizeClassCount if not pooled.
+	Ceylan::Uint32 sizeClass ;
+
+} ;
+
+
+
+struct PooledAllocator::Slab
+{
+
+	/// The slab allocated before this one, if any.
+	Slab * next ;
+
+} ;
+
+
+
+
+PooledAllocatorException::PooledAllocatorException( const string & reason ) :
+	OSDL::Exception( reason )
+{
+
+}
+
+
+
+PooledAllocatorException::~PooledAllocatorException() throw()
+{
+
+}
+
+
+
+
+PooledAllocator::PooledAllocator() :
+	_slabs( 0 ),
+	_mutex( 0 )
+{
+
+	for ( Ceylan::Uint32 i = 0; i < SizeClassCount; i++ )
+		_freeBlocks[i] = 0 ;
+
+	::memset( &_counters, 0, sizeof( Counters ) ) ;
+
+#if OSDL_USES_SDL
+
+	_mutex = SDL_CreateMutex() ;
+
+	if ( _mutex == 0 )
+		throw PooledAllocatorException( "PooledAllocator constructor failed: "
+			"unable to create mutex: " + string( SDL_GetError() ) ) ;
+
+#endif // OSDL_USES_SDL
+
+}
+
+
+
+PooledAllocator::~PooledAllocator() throw()
+{
+
+	while ( _slabs != 0 )
+	{
+
+		Slab * next = _slabs->next ;
+		::free( _slabs ) ;
+		_slabs = next ;
+
+	}
+
+#if OSDL_USES_SDL
+
+	SDL_DestroyMutex( _mutex ) ;
+
+#endif // OSDL_USES_SDL
+
+}
+
+
+
+void * PooledAllocator::allocate( Size size )
+{
+
+	Ceylan::Uint32 sizeClass = GetSizeClassFor( size ) ;
+
+	BlockHeader * header = 0 ;
+
+	// Large blocks are allocated out of the lock:
+	if ( sizeClass == SizeClassCount )
+	{
+
+		if ( size > static_cast<Size>( -1 ) - HeaderSize )
+			return 0 ;
+
+		header = static_cast<BlockHeader *>( ::malloc( HeaderSize + size ) ) ;
+
+		if ( header == 0 )
+			return 0 ;
+
+	}
+
+#if OSDL_USES_SDL
+	SDL_mutexP( _mutex ) ;
+#endif // OSDL_USES_SDL
+
+	if ( sizeClass != SizeClassCount )
+	{
+
+		if ( _freeBlocks[sizeClass] == 0 && ! grow( sizeClass ) )
+		{
+
+#if OSDL_USES_SDL
+			SDL_mutexV( _mutex ) ;
+#endif // OSDL_USES_SDL
+
+			return 0 ;
+
+		}
+
+		header = _freeBlocks[sizeClass] ;
+		_freeBlocks[sizeClass] = header->nextFree ;
+
+		_counters.pooledAllocations++ ;
+
+	}
+
+	header->size      = size ;
+	header->sizeClass = sizeClass ;
+
+	countAllocation( size ) ;
+
+#if OSDL_USES_SDL
+	SDL_mutexV( _mutex ) ;
+#endif // OSDL_USES_SDL
+
+	return reinterpret_cast<Ceylan::Byte *>( header ) + HeaderSize ;
+
+}
+
+
+
+void * PooledAllocator::reallocate( void * block, Size newSize )
+{
+
+	if ( block == 0 )
+		return allocate( newSize ) ;
+
+	BlockHeader * header = reinterpret_cast<BlockHeader *>(
+		static_cast<Ceylan::Byte *>( block ) - HeaderSize ) ;
+
+	Ceylan::Uint32 sizeClass = header->sizeClass ;
+
+	Size oldSize = header->size ;
+
+	bool fitsInPlace = ( sizeClass != SizeClassCount
+		&& newSize <= ( MinimumBlockSize << sizeClass ) ) ;
+
+	// Large blocks that remain large are resized by the heap:
+	if ( sizeClass == SizeClassCount
+		&& GetSizeClassFor( newSize ) == SizeClassCount )
+	{
+
+		if ( newSize > static_cast<Size>( -1 ) - HeaderSize )
+			return 0 ;
+
+		BlockHeader * newHeader = static_cast<BlockHeader *>(
+			::realloc( header, HeaderSize + newSize ) ) ;
+
+		if ( newHeader == 0 )
+			return 0 ;
+
+		header = newHeader ;
+		header->size = newSize ;
+
+	}
+	else if ( fitsInPlace )
+	{
+
+		header->size = newSize ;
+
+	}
+	else
+	{
+
+		// Moves to another class, hence also counted as (de)allocations:
+		void * newBlock = allocate( newSize ) ;
+
+		if ( newBlock == 0 )
+			return 0 ;
+
+		::memcpy( newBlock, block, ( oldSize < newSize ) ? oldSize : newSize ) ;
+
+		deallocate( block ) ;
+
+		header = reinterpret_cast<BlockHeader *>(
+			static_cast<Ceylan::Byte *>( newBlock ) - HeaderSize ) ;
+
+		oldSize = 0 ;
+		newSize = 0 ;
+
+	}
+
+#if OSDL_USES_SDL
+	SDL_mutexP( _mutex ) ;
+#endif // OSDL_USES_SDL
+
+	_counters.reallocations++ ;
+
+	if ( fitsInPlace )
+		_counters.inPlaceReallocations++ ;
+
+	_counters.liveBytes = _counters.liveBytes - oldSize + newSize ;
+
+	if ( _counters.liveBytes > _counters.peakLiveBytes )
+		_counters.peakLiveBytes = _counters.liveBytes ;
+
+#if OSDL_USES_SDL
+	SDL_mutexV( _mutex ) ;
+#endif // OSDL_USES_SDL
+
+	return reinterpret_cast<Ceylan::Byte *>( header ) + HeaderSize ;
+
+}
+
+
+
+void PooledAllocator::deallocate( void * block )
+{
+
+	if ( block == 0 )
+		return ;
+
+	BlockHeader * header = reinterpret_cast<BlockHeader *>(
+		static_cast<Ceylan::Byte *>( block ) - HeaderSize ) ;
+
+	Ceylan::Uint32 sizeClass = header->sizeClass ;
+
+#if OSDL_USES_SDL
+	SDL_mutexP( _mutex ) ;
+#endif // OSDL_USES_SDL
+
+	_counters.deallocations++ ;
+	_counters.liveBlocks-- ;
+	_counters.liveBytes -= header->size ;
+
+	if ( sizeClass != SizeClassCount )
+	{
+
+		header->nextFree = _freeBlocks[sizeClass] ;
+		_freeBlocks[sizeClass] = header ;
+
+	}
+
+#if OSDL_USES_SDL
+	SDL_mutexV( _mutex ) ;
+#endif // OSDL_USES_SDL
+
+	if ( sizeClass == SizeClassCount )
+		::free( header ) ;
+
+}
+
+
+
+PooledAllocator::Counters PooledAllocator::getCounters() const
+{
+
+#if OSDL_USES_SDL
+	SDL_mutexP( _mutex ) ;
+#endif // OSDL_USES_SDL
+
+	Counters counters = _counters ;
+
+#if OSDL_USES_SDL
+	SDL_mutexV( _mutex ) ;
+#endif // OSDL_USES_SDL
+
+	return counters ;
+
+}
+
+
+
+const string PooledAllocator::toString( Ceylan::VerbosityLevels level ) const
+{
+
+	Counters counters = getCounters() ;
+
+	string res = "Pooled allocator having "
+		+ Ceylan::toString( counters.liveBlocks )
+		+ " block(s) currently allocated ("
+		+ Ceylan::toString( counters.liveBytes ) + " bytes, at most "
+		+ Ceylan::toString( counters.peakLiveBytes ) + " bytes so far), from "
+		+ Ceylan::toString( counters.slabs ) + " slab(s) of "
+		+ Ceylan::toString( SlabSize ) + " bytes" ;
+
+	if ( level == Ceylan::low )
+		return res ;
+
+	return res + ", after " + Ceylan::toString( counters.allocations )
+		+ " allocation(s), of which "
+		+ Ceylan::toString( counters.pooledAllocations ) + " from pools, "
+		+ Ceylan::toString( counters.reallocations )
+		+ " reallocation(s), of which "
+		+ Ceylan::toString( counters.inPlaceReallocations ) + " in place, and "
+		+ Ceylan::toString( counters.deallocations ) + " deallocation(s)" ;
+
+}
+
+
+
+
+// Private section.
+
+
+
+Ceylan::Uint32 PooledAllocator::GetSizeClassFor( Size size )
+{
+
+	if ( size > MaximumBlockSize )
+		return SizeClassCount ;
+
+	Ceylan::Uint32 sizeClass = 0 ;
+
+	while ( ( MinimumBlockSize << sizeClass ) < size )
+		sizeClass++ ;
+
+	return sizeClass ;
+
+}
+
+
+
+bool PooledAllocator::grow( Ceylan::Uint32 sizeClass )
+{
+
+	Slab * slab = static_cast<Slab *>( ::malloc( SlabSize ) ) ;
+
+	if ( slab == 0 )
+		return false ;
+
+	slab->next = _slabs ;
+	_slabs = slab ;
+
+	_counters.slabs++ ;
+
+	Size blockSize = HeaderSize + ( MinimumBlockSize << sizeClass ) ;
+
+	Size blockCount = ( SlabSize - HeaderSize ) / blockSize ;
+
+	Ceylan::Byte * firstBlock =
+		reinterpret_cast<Ceylan::Byte *>( slab ) + HeaderSize ;
+
+	// Chained so that blocks are handed out in address order:
+	for ( Size i = blockCount; i > 0; i-- )
+	{
+
+		BlockHeader * header = reinterpret_cast<BlockHeader *>(
+			firstBlock + ( i - 1 ) * blockSize ) ;
+
+		header->nextFree = _freeBlocks[sizeClass] ;
+		_freeBlocks[sizeClass] = header ;
+
+	}
+
+	return true ;
+
+}
+
+
+
+void PooledAllocator::countAllocation( Size size )
+{
+
+	_counters.allocations++ ;
+	_counters.liveBlocks++ ;
+	_counters.liveBytes += size ;
+
+	if ( _counters.liveBlocks > _counters.peakLiveBlocks )
+		_counters.peakLiveBlocks = _counters.liveBlocks ;
+
+	if ( _counters.liveBytes > _counters.peakLiveBytes )
+		_counters.peakLiveBytes = _counters.liveBytes ;
+
+}
@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#ifndef OSDL_POOLED_ALLOCATOR_H_
+#define OSDL_POOLED_ALLOCATOR_H_
+
+
+#include "OSDLException.h"   // for OSDL::Exception
+
+#include "Ceylan.h"          // for inheritance, Uint32, Size
+
+#include <string>
+
+
+
+/*
+ * No need to include SDL header here. Declared even without SDL support, as
+ * user code does not see the configuration settings: the layout of classes
+ * must not depend on them.
+ *
+ */
+struct SDL_mutex ;
+
+
+
+
+namespace OSDL
+{
+
+
+
+	/// Exception raised when a pooled allocator cannot be created.
+	class OSDL_DLL PooledAllocatorException : public OSDL::Exception
+	{
+
+		public:
+
+			explicit PooledAllocatorException( const std::string & reason ) ;
+
+			virtual ~PooledAllocatorException() throw() ;
+
+	} ;
+
+
+
+	/**
+	 * Allocator serving small blocks from pools of fixed-size blocks, one pool
+	 * per size class (powers of two, from MinimumBlockSize to
+	 * MaximumBlockSize bytes), larger blocks being directly allocated from the
+	 * heap.
+	 *
+	 * Pools grow by slabs of SlabSize bytes, carved into blocks that are kept
+	 * in the free list of their class once freed, so that repeatedly
+	 * allocating and freeing small blocks neither fragments the heap nor
+	 * calls malloc. Slabs are only returned to the heap when the allocator is
+	 * deleted.
+	 *
+	 * Meant to back PhysicsFS (file handles, decompression buffers,
+	 * enumeration lists, etc.), hence the malloc-like interface: failures are
+	 * reported by null pointers rather than by exceptions.
+	 *
+	 * @note Thread-safe, provided that SDL is available.
+	 *
+	 * @see EmbeddedFileSystemManager::getAllocationCounters
+	 *
+	 */
+	class OSDL_DLL PooledAllocator : public Ceylan::TextDisplayable
+	{
+
+
+		public:
+
+
+
+			/// The allocation counters of an allocator.
+			struct Counters
+			{
+
+				/// The number of blocks allocated, pooled or not.
+				Ceylan::Uint32 allocations ;
+
+				/// The number of blocks allocated from a pool.
+				Ceylan::Uint32 pooledAllocations ;
+
+				/**
+				 * The number of reallocations (those moving their block to
+				 * another class also count as an allocation and a
+				 * deallocation).
+				 *
+				 */
+				Ceylan::Uint32 reallocations ;
+
+				/// The number of reallocations that kept their block.
+				Ceylan::Uint32 inPlaceReallocations ;
+
+				/// The number of blocks freed.
+				Ceylan::Uint32 deallocations ;
+
+				/// The number of slabs allocated for the pools.
+				Ceylan::Uint32 slabs ;
+
+				/// The number of blocks currently allocated.
+				Ceylan::Uint32 liveBlocks ;
+
+				/// The maximum number of blocks allocated at the same time.
+				Ceylan::Uint32 peakLiveBlocks ;
+
+				/// The total size of the blocks currently allocated.
+				Ceylan::System::Size liveBytes ;
+
+				/// The maximum total size of the blocks allocated at once.
+				Ceylan::System::Size peakLiveBytes ;
+
+			} ;
+
+
+
+			/**
+			 * Creates an empty allocator, whose pools will grow on demand.
+			 *
+			 * @throw PooledAllocatorException if the allocator could not be
+			 * created.
+			 *
+			 */
+			PooledAllocator() ;
+
+
+
+			/**
+			 * Deletes this allocator, and returns its slabs to the heap.
+			 *
+			 * @note Any block still allocated from a pool becomes invalid.
+			 *
+			 */
+			virtual ~PooledAllocator() throw() ;
+
+
+
+			/**
+			 * Returns a block of at least the specified size, or null if it
+			 * could not be allocated.
+			 *
+			 * Blocks are aligned as the ones returned by malloc.
+			 *
+			 */
+			void * allocate( Ceylan::System::Size size ) ;
+
+
+
+			/**
+			 * Resizes the specified block (if any) like realloc, and returns
+			 * it, possibly moved, or null if it could not be resized (the
+			 * original block being then left untouched).
+			 *
+			 * Blocks are kept in place as long as they fit in their size
+			 * class.
+			 *
+			 */
+			void * reallocate( void * block, Ceylan::System::Size newSize ) ;
+
+
+
+			/**
+			 * Frees the specified block (if any), which must have been
+			 * allocated by this allocator.
+			 *
+			 */
+			void deallocate( void * block ) ;
+
+
+
+			/// Returns a snapshot of the allocation counters.
+			Counters getCounters() const ;
+
+
+
+			/**
+			 * Returns a user-friendly description of the state of this object.
+			 *
+			 * @param level the requested verbosity level.
+			 *
+			 * @note Text output format is determined from overall settings.
+			 *
+			 * @see TextDisplayable
+			 *
+			 */
+			virtual const std::string toString(
+				Ceylan::VerbosityLevels level = Ceylan::high ) const ;
+
+
+
+			/// The number of size classes, hence of pools.
+			static const Ceylan::Uint32 SizeClassCount = 9 ;
+
+
+			/// The size of the blocks of the smallest class.
+			static const Ceylan::System::Size MinimumBlockSize ;
+
+
+			/// The size of the blocks of the largest class.
+			static const Ceylan::System::Size MaximumBlockSize ;
+
+
+			/// The size of the slabs the pools are grown by.
+			static const Ceylan::System::Size SlabSize ;
+
+
+
+
+		private:
+
+
+
+			/**
+			 * Precedes each block, to know how to free it.
+			 *
+			 * Defined in the implementation file.
+			 *
+			 */
+			struct BlockHeader ;
+
+
+			/**
+			 * Precedes each slab, to chain the slabs together.
+			 *
+			 * Defined in the implementation file.
+			 *
+			 */
+			struct Slab ;
+
+
+			/**
+			 * Returns the size class of a block of the specified size, or
+			 * SizeClassCount if it is too large to be pooled.
+			 *
+			 */
+			static Ceylan::Uint32 GetSizeClassFor(
+				Ceylan::System::Size size ) ;
+
+
+			/**
+			 * Adds a slab of free blocks to the pool of the specified class.
+			 *
+			 * @return false if the slab could not be allocated.
+			 *
+			 * @note The mutex must be held.
+			 *
+			 */
+			bool grow( Ceylan::Uint32 sizeClass ) ;
+
+
+			/// Accounts for a block of the specified size being allocated.
+			void countAllocation( Ceylan::System::Size size ) ;
+
+
+
+			/// The first free block of each size class (if any).
+			BlockHeader * _freeBlocks[ SizeClassCount ] ;
+
+
+			/// The slabs allocated so far, chained.
+			Slab * _slabs ;
+
+
+			/// The allocation counters.
+			Counters _counters ;
+
+
+			/// Protects the pools and the counters (null without SDL).
+			SDL_mutex * _mutex ;
+
+
+
+			/**
+			 * Copy constructor made private to ensure that it will never be
+			 * called.
+			 *
+			 * The compiler should complain whenever this undefined constructor
+			 * is called, implicitly or not.
+			 *
+			 */
+			PooledAllocator( const PooledAllocator & source ) ;
+
+
+			/**
+			 * Assignment operator made private to ensure that it will never be
+			 * called.
+			 *
+			 * The compiler should complain whenever this undefined operator is
+			 * called, implicitly or not.
+			 *
+			 */
+			PooledAllocator & operator = ( const PooledAllocator & source ) ;
+
+
+	} ;
+
+
+}
+
+
+
+#endif // OSDL_POOLED_ALLOCATOR_H_
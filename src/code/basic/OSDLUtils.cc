@@ -53,6 +53,8 @@
 
 
 #include <cstdio>   // for SEEK_SET, SEEK_CUR, SEEK_END, etc.
+#include <cstring>  // for memcmp
+#include <vector>
 
 
 using namespace OSDL ;
@@ -166,6 +168,85 @@ std::string OSDL::Utils::getUserDirectory()
 
 
 
+// FNV-1a offset basis:
+extern const Ceylan::Uint64 OSDL::Utils::EmptyContentHash =
+	14695981039346656037ULL ;
+
+
+
+Ceylan::Uint64 OSDL::Utils::hashContent( const Ceylan::Byte * content,
+	Ceylan::System::Size size, Ceylan::Uint64 previousHash )
+{
+
+	Ceylan::Uint64 hash = previousHash ;
+
+	for ( Ceylan::System::Size i = 0; i < size; i++ )
+	{
+
+		hash ^= content[i] ;
+		hash *= 1099511628211ULL ;
+
+	}
+
+	// Null is reserved for unknown hashes:
+	return ( hash == 0 ) ? 1 : hash ;
+
+}
+
+
+
+bool OSDL::Utils::haveSameContent( const std::string & firstFilename,
+	const std::string & secondFilename )
+{
+
+	// Read block per block, as contents like musics may be large:
+	const Size BlockSize = 64 * 1024 ;
+
+	try
+	{
+
+		Ceylan::Holder<File> firstHolder( File::Open( firstFilename ) ) ;
+		Ceylan::Holder<File> secondHolder( File::Open( secondFilename ) ) ;
+
+		Size remaining = firstHolder->size() ;
+
+		if ( secondHolder->size() != remaining )
+			return false ;
+
+		std::vector<Ceylan::Byte> firstBlock( BlockSize ) ;
+		std::vector<Ceylan::Byte> secondBlock( BlockSize ) ;
+
+		while ( remaining > 0 )
+		{
+
+			Size count = ( remaining < BlockSize ) ? remaining : BlockSize ;
+
+			firstHolder->readExactLength( & firstBlock[0], count ) ;
+			secondHolder->readExactLength( & secondBlock[0], count ) ;
+
+			if ( ::memcmp( & firstBlock[0], & secondBlock[0], count ) != 0 )
+				return false ;
+
+			remaining -= count ;
+
+		}
+
+	}
+	catch( const Ceylan::Exception & e )
+	{
+
+		throw OSDL::Exception( "OSDL::Utils::haveSameContent failed for '"
+			+ firstFilename + "' and '" + secondFilename + "': "
+			+ e.toString() ) ;
+
+	}
+
+	return true ;
+
+}
+
+
+
 
 
 /**
@@ -133,6 +133,98 @@ namespace OSDL
 
 
 
+		/// The hash of an empty content, to start an incremental hashing.
+		extern OSDL_DLL const Ceylan::Uint64 EmptyContentHash ;
+
+
+
+		/**
+		 * Returns the hash of the specified content (64-bit FNV-1a), so that
+		 * byte-identical contents (ex: the same palette stored under two
+		 * names) can be detected.
+		 *
+		 * @param content the bytes to hash.
+		 *
+		 * @param size the number of these bytes.
+		 *
+		 * @param previousHash the hash of the content preceding these bytes,
+		 * so that a content can be hashed block per block.
+		 *
+		 * @note The returned hash is never null, so that null can be used to
+		 * denote an unknown hash.
+		 *
+		 */
+		OSDL_DLL Ceylan::Uint64 hashContent( const Ceylan::Byte * content,
+			Ceylan::System::Size size,
+			Ceylan::Uint64 previousHash = EmptyContentHash ) ;
+
+
+
+		/**
+		 * Tells whether the two specified files have the same content, by
+		 * comparing their bytes (block per block).
+		 *
+		 * Meant to confirm that contents of equal hashes are actually
+		 * identical, before sharing them, as different contents may collide.
+		 *
+		 * @note Files are opened through the default filesystem manager.
+		 *
+		 * @throw OSDL::Exception if a file could not be read.
+		 *
+		 */
+		OSDL_DLL bool haveSameContent( const std::string & firstFilename,
+			const std::string & secondFilename ) ;
+
+
+
+		/**
+		 * Decodes the little-endian 16-bit integer stored at the specified
+		 * location, as done by all the binary formats of OSDL.
+		 *
+		 * Integers are decoded byte per byte, so that neither the alignment
+		 * of the location nor the endianness of the platform matter.
+		 *
+		 */
+		inline Ceylan::Uint16 readLittleEndianUint16(
+			const Ceylan::Byte * location )
+		{
+
+			return static_cast<Ceylan::Uint16>(
+				static_cast<Ceylan::Uint16>( location[0] )
+				| ( static_cast<Ceylan::Uint16>( location[1] ) << 8 ) ) ;
+
+		}
+
+
+
+		/// Decodes the little-endian 32-bit integer stored at the location.
+		inline Ceylan::Uint32 readLittleEndianUint32(
+			const Ceylan::Byte * location )
+		{
+
+			return static_cast<Ceylan::Uint32>( location[0] )
+				| ( static_cast<Ceylan::Uint32>( location[1] ) << 8  )
+				| ( static_cast<Ceylan::Uint32>( location[2] ) << 16 )
+				| ( static_cast<Ceylan::Uint32>( location[3] ) << 24 ) ;
+
+		}
+
+
+
+		/// Decodes the little-endian 64-bit integer stored at the location.
+		inline Ceylan::Uint64 readLittleEndianUint64(
+			const Ceylan::Byte * location )
+		{
+
+			return static_cast<Ceylan::Uint64>(
+				readLittleEndianUint32( location ) )
+				| ( static_cast<Ceylan::Uint64>(
+					readLittleEndianUint32( location + 4 ) ) << 32 ) ;
+
+		}
+
+
+
 		/**
 		 * A DataStream is a way of writing and/or reading for an opaque data
 		 * storage, which can be actually a file, a buffer in memory, or
@@ -0,0 +1,672 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDLWorkerPool.h"
+
+
+#ifdef OSDL_USES_CONFIG_H
+#include "OSDLConfig.h"              // for configure-time settings (SDL)
+#endif // OSDL_USES_CONFIG_H
+
+#if OSDL_ARCH_NINTENDO_DS
+#include "OSDLConfigForNintendoDS.h" // for OSDL_USES_SDL and al
+#endif // OSDL_ARCH_NINTENDO_DS
+
+
+#if OSDL_USES_SDL
+#include "SDL.h"                     // for SDL_GetTicks
+#include "SDL_thread.h"              // for SDL_CreateThread and al
+#endif // OSDL_USES_SDL
+
+
+#include <exception>                 // for std::exception
+
+#ifndef OSDL_RUNS_ON_WINDOWS
+#include <unistd.h>                  // for sysconf
+#endif // OSDL_RUNS_ON_WINDOWS
+
+
+
+using namespace OSDL ;
+
+using std::string ;
+
+
+
+/*
+ * Implementation notes:
+ *
+ * All the state of a pool (its queue, its counters, and the state of the jobs
+ * submitted to it) is protected by its single mutex; a job is executed without
+ * the mutex being held.
+ *
+ * Two condition variables are used: one to wake up idle workers when a job is
+ * submitted, one (broadcast) to wake up the threads waiting for jobs to be
+ * executed.
+ *
+ */
+
+
+
+WorkerPoolException::WorkerPoolException( const string & reason ) :
+	OSDL::Exception( reason )
+{
+
+}
+
+
+
+WorkerPoolException::~WorkerPoolException() throw()
+{
+
+}
+
+
+
+
+// Job section.
+
+
+
+Job::Job( const string & name ) :
+	_name( name ),
+	_state( Created ),
+	_failureReason(),
+	_ownedByPool( false )
+{
+
+}
+
+
+
+Job::~Job() throw()
+{
+
+}
+
+
+
+const string & Job::getName() const
+{
+
+	return _name ;
+
+}
+
+
+
+const string Job::toString( Ceylan::VerbosityLevels level ) const
+{
+
+	return "Job '" + _name + "'" ;
+
+}
+
+
+
+string Job::DescribeState( JobState state )
+{
+
+	switch( state )
+	{
+
+		case Created:
+			return "created" ;
+
+		case Pending:
+			return "pending" ;
+
+		case Running:
+			return "running" ;
+
+		case Completed:
+			return "completed" ;
+
+		case Failed:
+			return "failed" ;
+
+		default:
+			return "unknown (abnormal)" ;
+
+	}
+
+}
+
+
+
+
+// WorkerPool section.
+
+
+
+const Ceylan::Uint32 WorkerPool::WaitIndefinitely = 0xFFFFFFFF ;
+
+
+
+WorkerPool::WorkerPool( Ceylan::Uint32 workerCount, const string & name ) :
+	_name( name ),
+	_workerCount( workerCount ),
+	_runningCount( 0 ),
+	_stopRequested( false ),
+	_mutex( 0 ),
+	_jobAvailable( 0 ),
+	_jobExecuted( 0 )
+{
+
+	if ( _workerCount == 0 )
+		_workerCount = GetDefaultWorkerCount() ;
+
+#if OSDL_USES_SDL
+
+	_mutex        = SDL_CreateMutex() ;
+	_jobAvailable = SDL_CreateCond() ;
+	_jobExecuted  = SDL_CreateCond() ;
+
+	if ( _mutex == 0 || _jobAvailable == 0 || _jobExecuted == 0 )
+	{
+
+		string reason = SDL_GetError() ;
+
+		destroySynchronizationPrimitives() ;
+
+		throw WorkerPoolException( "WorkerPool constructor failed: "
+			"unable to create synchronization primitives: " + reason ) ;
+
+	}
+
+	for ( Ceylan::Uint32 i = 0; i < _workerCount; i++ )
+	{
+
+		SDL_Thread * worker = SDL_CreateThread( RunWorker,
+			static_cast<void *>( this ) ) ;
+
+		if ( worker == 0 )
+		{
+
+			// Stops the workers already created:
+			SDL_mutexP( _mutex ) ;
+			_stopRequested = true ;
+			SDL_CondBroadcast( _jobAvailable ) ;
+			SDL_mutexV( _mutex ) ;
+
+			string reason = SDL_GetError() ;
+
+			for ( std::vector<SDL_Thread *>::iterator it = _workers.begin();
+					it != _workers.end(); it++ )
+				SDL_WaitThread( *it, /* status */ 0 ) ;
+
+			destroySynchronizationPrimitives() ;
+
+			throw WorkerPoolException( "WorkerPool constructor failed: "
+				"unable to create worker thread: " + reason ) ;
+
+		}
+
+		_workers.push_back( worker ) ;
+
+	}
+
+#endif // OSDL_USES_SDL
+
+}
+
+
+
+WorkerPool::~WorkerPool() throw()
+{
+
+#if OSDL_USES_SDL
+
+	// Workers drain the queue before stopping:
+	SDL_mutexP( _mutex ) ;
+	_stopRequested = true ;
+	SDL_CondBroadcast( _jobAvailable ) ;
+	SDL_mutexV( _mutex ) ;
+
+	for ( std::vector<SDL_Thread *>::iterator it = _workers.begin();
+			it != _workers.end(); it++ )
+		SDL_WaitThread( *it, /* status */ 0 ) ;
+
+	destroySynchronizationPrimitives() ;
+
+#endif // OSDL_USES_SDL
+
+}
+
+
+
+void WorkerPool::submit( Job & job, bool transferOwnership )
+{
+
+#if OSDL_USES_SDL
+
+	SDL_mutexP( _mutex ) ;
+
+	if ( job._state == Job::Pending || job._state == Job::Running )
+	{
+
+		SDL_mutexV( _mutex ) ;
+
+		throw WorkerPoolException( "WorkerPool::submit failed: "
+			+ job.toString() + " is already "
+			+ Job::DescribeState( job._state ) ) ;
+
+	}
+
+	if ( _stopRequested )
+	{
+
+		SDL_mutexV( _mutex ) ;
+
+		throw WorkerPoolException( "WorkerPool::submit failed: "
+			"pool is being stopped" ) ;
+
+	}
+
+	job._state = Job::Pending ;
+	job._failureReason.clear() ;
+	job._ownedByPool = transferOwnership ;
+
+	_pendingJobs.push_back( & job ) ;
+
+	SDL_CondSignal( _jobAvailable ) ;
+
+	SDL_mutexV( _mutex ) ;
+
+#else // OSDL_USES_SDL
+
+	// No thread available, thus synchronous execution:
+	job._state = Job::Pending ;
+	job._failureReason.clear() ;
+	job._ownedByPool = transferOwnership ;
+
+	if ( executeJob( job ) )
+		delete & job ;
+
+#endif // OSDL_USES_SDL
+
+}
+
+
+
+Job::JobState WorkerPool::getStateOf( const Job & job ) const
+{
+
+#if OSDL_USES_SDL
+
+	SDL_mutexP( _mutex ) ;
+	Job::JobState res = job._state ;
+	SDL_mutexV( _mutex ) ;
+
+	return res ;
+
+#else // OSDL_USES_SDL
+
+	return job._state ;
+
+#endif // OSDL_USES_SDL
+
+}
+
+
+
+bool WorkerPool::isCompleted( const Job & job ) const
+{
+
+	Job::JobState state = getStateOf( job ) ;
+
+	return ( state == Job::Completed || state == Job::Failed ) ;
+
+}
+
+
+
+string WorkerPool::getFailureReasonFor( const Job & job ) const
+{
+
+#if OSDL_USES_SDL
+
+	SDL_mutexP( _mutex ) ;
+	string res = job._failureReason ;
+	SDL_mutexV( _mutex ) ;
+
+	return res ;
+
+#else // OSDL_USES_SDL
+
+	return job._failureReason ;
+
+#endif // OSDL_USES_SDL
+
+}
+
+
+
+bool WorkerPool::waitFor( const Job & job, Ceylan::Uint32 timeout )
+{
+
+#if OSDL_USES_SDL
+
+	Ceylan::Uint32 start = SDL_GetTicks() ;
+
+	SDL_mutexP( _mutex ) ;
+
+	while ( job._state == Job::Pending || job._state == Job::Running )
+	{
+
+		if ( timeout == WaitIndefinitely )
+		{
+
+			SDL_CondWait( _jobExecuted, _mutex ) ;
+
+		}
+		else
+		{
+
+			Ceylan::Uint32 elapsed = SDL_GetTicks() - start ;
+
+			if ( elapsed >= timeout )
+				break ;
+
+			SDL_CondWaitTimeout( _jobExecuted, _mutex, timeout - elapsed ) ;
+
+		}
+
+	}
+
+	bool res = ( job._state == Job::Completed || job._state == Job::Failed ) ;
+
+	SDL_mutexV( _mutex ) ;
+
+	return res ;
+
+#else // OSDL_USES_SDL
+
+	// Jobs are executed synchronously:
+	return ( job._state == Job::Completed || job._state == Job::Failed ) ;
+
+#endif // OSDL_USES_SDL
+
+}
+
+
+
+bool WorkerPool::waitForAll( Ceylan::Uint32 timeout )
+{
+
+#if OSDL_USES_SDL
+
+	Ceylan::Uint32 start = SDL_GetTicks() ;
+
+	SDL_mutexP( _mutex ) ;
+
+	while ( ! _pendingJobs.empty() || _runningCount != 0 )
+	{
+
+		if ( timeout == WaitIndefinitely )
+		{
+
+			SDL_CondWait( _jobExecuted, _mutex ) ;
+
+		}
+		else
+		{
+
+			Ceylan::Uint32 elapsed = SDL_GetTicks() - start ;
+
+			if ( elapsed >= timeout )
+				break ;
+
+			SDL_CondWaitTimeout( _jobExecuted, _mutex, timeout - elapsed ) ;
+
+		}
+
+	}
+
+	bool res = ( _pendingJobs.empty() && _runningCount == 0 ) ;
+
+	SDL_mutexV( _mutex ) ;
+
+	return res ;
+
+#else // OSDL_USES_SDL
+
+	return true ;
+
+#endif // OSDL_USES_SDL
+
+}
+
+
+
+Ceylan::Uint32 WorkerPool::getPendingCount() const
+{
+
+#if OSDL_USES_SDL
+
+	SDL_mutexP( _mutex ) ;
+
+	Ceylan::Uint32 res =
+		static_cast<Ceylan::Uint32>( _pendingJobs.size() ) + _runningCount ;
+
+	SDL_mutexV( _mutex ) ;
+
+	return res ;
+
+#else // OSDL_USES_SDL
+
+	return 0 ;
+
+#endif // OSDL_USES_SDL
+
+}
+
+
+
+Ceylan::Uint32 WorkerPool::getWorkerCount() const
+{
+
+	return _workerCount ;
+
+}
+
+
+
+const string WorkerPool::toString( Ceylan::VerbosityLevels level ) const
+{
+
+#if OSDL_USES_SDL
+
+	return "Worker pool '" + _name + "' relying on "
+		+ Ceylan::toString( _workerCount ) + " worker thread(s), with "
+		+ Ceylan::toString( getPendingCount() )
+		+ " job(s) pending or running" ;
+
+#else // OSDL_USES_SDL
+
+	return "Worker pool '" + _name
+		+ "', executing jobs synchronously (no thread support available)" ;
+
+#endif // OSDL_USES_SDL
+
+}
+
+
+
+Ceylan::Uint32 WorkerPool::GetDefaultWorkerCount()
+{
+
+#if defined(_SC_NPROCESSORS_ONLN)
+
+	long processorCount = ::sysconf( _SC_NPROCESSORS_ONLN ) ;
+
+	if ( processorCount > 0 )
+		return static_cast<Ceylan::Uint32>( processorCount ) ;
+
+#endif // _SC_NPROCESSORS_ONLN
+
+	return 2 ;
+
+}
+
+
+
+int WorkerPool::RunWorker( void * pool )
+{
+
+#if OSDL_USES_SDL
+
+	WorkerPool & workerPool = * static_cast<WorkerPool *>( pool ) ;
+
+	SDL_mutexP( workerPool._mutex ) ;
+
+	while ( true )
+	{
+
+		while ( workerPool._pendingJobs.empty()
+				&& ! workerPool._stopRequested )
+			SDL_CondWait( workerPool._jobAvailable, workerPool._mutex ) ;
+
+		// Stops only once all submitted jobs have been executed:
+		if ( workerPool._pendingJobs.empty() )
+			break ;
+
+		Job * job = workerPool._pendingJobs.front() ;
+		workerPool._pendingJobs.pop_front() ;
+
+		job->_state = Job::Running ;
+		workerPool._runningCount++ ;
+
+		SDL_mutexV( workerPool._mutex ) ;
+
+		bool toDelete = workerPool.executeJob( *job ) ;
+
+		if ( toDelete )
+			delete job ;
+
+		SDL_mutexP( workerPool._mutex ) ;
+
+		workerPool._runningCount-- ;
+
+		SDL_CondBroadcast( workerPool._jobExecuted ) ;
+
+	}
+
+	SDL_mutexV( workerPool._mutex ) ;
+
+#endif // OSDL_USES_SDL
+
+	return 0 ;
+
+}
+
+
+
+bool WorkerPool::executeJob( Job & job )
+{
+
+	Job::JobState outcome = Job::Completed ;
+	string reason ;
+
+	try
+	{
+
+		job.execute() ;
+
+	}
+	catch( const Ceylan::Exception & e )
+	{
+
+		outcome = Job::Failed ;
+		reason = e.toString() ;
+
+	}
+	catch( const std::exception & e )
+	{
+
+		outcome = Job::Failed ;
+		reason = e.what() ;
+
+	}
+	catch( ... )
+	{
+
+		outcome = Job::Failed ;
+		reason = "unknown exception raised" ;
+
+	}
+
+#if OSDL_USES_SDL
+	SDL_mutexP( _mutex ) ;
+#endif // OSDL_USES_SDL
+
+	job._state = outcome ;
+	job._failureReason = reason ;
+
+	bool res = job._ownedByPool ;
+
+#if OSDL_USES_SDL
+	SDL_mutexV( _mutex ) ;
+#endif // OSDL_USES_SDL
+
+	return res ;
+
+}
+
+
+
+void WorkerPool::destroySynchronizationPrimitives()
+{
+
+#if OSDL_USES_SDL
+
+	if ( _jobExecuted != 0 )
+	{
+
+		SDL_DestroyCond( _jobExecuted ) ;
+		_jobExecuted = 0 ;
+
+	}
+
+	if ( _jobAvailable != 0 )
+	{
+
+		SDL_DestroyCond( _jobAvailable ) ;
+		_jobAvailable = 0 ;
+
+	}
+
+	if ( _mutex != 0 )
+	{
+
+		SDL_DestroyMutex( _mutex ) ;
+		_mutex = 0 ;
+
+	}
+
+#endif // OSDL_USES_SDL
+
+}
@@ -0,0 +1,523 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#ifndef OSDL_WORKER_POOL_H_
+#define OSDL_WORKER_POOL_H_
+
+
+#include "OSDLException.h"   // for OSDL::Exception
+
+#include "Ceylan.h"          // for inheritance, Uint32
+
+#include <string>
+#include <list>
+#include <vector>
+
+
+
+// No need to include SDL header here (always declared, for a stable layout):
+struct SDL_mutex ;
+struct SDL_cond ;
+struct SDL_Thread ;
+
+
+
+
+namespace OSDL
+{
+
+
+
+	/// Exception raised when a worker pool or one of its jobs fails.
+	class OSDL_DLL WorkerPoolException : public OSDL::Exception
+	{
+
+		public:
+
+			explicit WorkerPoolException( const std::string & reason ) ;
+
+			virtual ~WorkerPoolException() throw() ;
+
+	} ;
+
+
+
+	// Defined afterwards.
+	class WorkerPool ;
+
+
+
+	/**
+	 * Unit of work meant to be executed in the background by a WorkerPool.
+	 *
+	 * Child classes just have to define the execute method, which will be
+	 * called from one of the threads of the pool. Therefore it must not rely
+	 * on services that are not thread-safe (ex: the logging system, the
+	 * display surface, or any object that may be used meanwhile by the main
+	 * thread): the results are expected to be stored in the job itself, and
+	 * handed over to the rest of the application by the thread that submitted
+	 * it, once the job is completed.
+	 *
+	 * Any exception raised by execute is caught by the pool, and results in
+	 * the job being in the Failed state.
+	 *
+	 */
+	class OSDL_DLL Job : public Ceylan::TextDisplayable
+	{
+
+
+		friend class WorkerPool ;
+
+
+		public:
+
+
+			/// Describes the life-cycle of a job.
+			enum JobState
+			{
+
+				/// Not submitted to any pool yet.
+				Created,
+
+				/// Submitted, waiting for a worker to be available.
+				Pending,
+
+				/// Being executed by a worker.
+				Running,
+
+				/// Executed successfully.
+				Completed,
+
+				/// Executed, but its execution failed.
+				Failed
+
+			} ;
+
+
+
+			/**
+			 * Creates a new job.
+			 *
+			 * @param name the name of this job, for information purpose.
+			 *
+			 */
+			explicit Job( const std::string & name = "anonymous job" ) ;
+
+
+
+			/// Virtual destructor.
+			virtual ~Job() throw() ;
+
+
+
+			/**
+			 * Performs the actual work of this job, from a worker thread.
+			 *
+			 * @throw Ceylan::Exception (or any child class) if the
+			 * execution failed.
+			 *
+			 */
+			virtual void execute() = 0 ;
+
+
+
+			/// Returns the name of this job.
+			virtual const std::string & getName() const ;
+
+
+
+			/**
+			 * Returns an user-friendly description of the state of this
+			 * object.
+			 *
+			 * @param level the requested verbosity level.
+			 *
+			 * @note Text output format is determined from overall settings.
+			 *
+			 * @see Ceylan::TextDisplayable
+			 *
+			 */
+			virtual const std::string toString(
+				Ceylan::VerbosityLevels level = Ceylan::high ) const ;
+
+
+
+			/**
+			 * Returns a textual description of the specified job state.
+			 *
+			 */
+			static std::string DescribeState( JobState state ) ;
+
+
+
+		protected:
+
+
+			/// The name of this job.
+			std::string _name ;
+
+
+
+		private:
+
+
+			/*
+			 * The next members are managed by the pool this job has been
+			 * submitted to, and are only accessed while holding its mutex.
+			 *
+			 */
+
+
+			/// The current state of this job.
+			JobState _state ;
+
+
+			/// Describes why the execution failed, if it did.
+			std::string _failureReason ;
+
+
+			/// Tells whether the pool is to delete this job once executed.
+			bool _ownedByPool ;
+
+
+
+			/**
+			 * Copy constructor made private to ensure that it will never be
+			 * called.
+			 *
+			 * The compiler should complain whenever this undefined constructor
+			 * is called, implicitly or not.
+			 *
+			 */
+			Job( const Job & source ) ;
+
+
+			/**
+			 * Assignment operator made private to ensure that it will never be
+			 * called.
+			 *
+			 * The compiler should complain whenever this undefined operator is
+			 * called, implicitly or not.
+			 *
+			 */
+			Job & operator = ( const Job & source ) ;
+
+
+	} ;
+
+
+
+
+	/**
+	 * Pool of worker threads executing submitted jobs in the background, in
+	 * their submission order.
+	 *
+	 * The submitting thread can then either poll the state of its jobs, or
+	 * block until they are completed, with or without a timeout.
+	 *
+	 * Jobs are either owned by their submitter (which can then inspect them
+	 * once completed, and must deallocate them), or owned by the pool (which
+	 * deallocates them as soon as they have been executed).
+	 *
+	 * @note If no thread support is available (ex: on the Nintendo DS), jobs
+	 * are executed synchronously, directly when being submitted.
+	 *
+	 */
+	class OSDL_DLL WorkerPool : public Ceylan::TextDisplayable
+	{
+
+
+		public:
+
+
+
+			/**
+			 * Creates a new pool of worker threads, which are started
+			 * immediately.
+			 *
+			 * @param workerCount the number of worker threads; if null, the
+			 * number returned by GetDefaultWorkerCount will be used.
+			 *
+			 * @param name the name of this pool, for information purpose.
+			 *
+			 * @throw WorkerPoolException if the operation failed.
+			 *
+			 */
+			explicit WorkerPool( Ceylan::Uint32 workerCount = 0,
+				const std::string & name = "worker pool" ) ;
+
+
+
+			/**
+			 * Virtual destructor, waiting for all submitted jobs to be
+			 * executed, then stopping the worker threads.
+			 *
+			 * Jobs still owned by the pool are deallocated.
+			 *
+			 */
+			virtual ~WorkerPool() throw() ;
+
+
+
+			/**
+			 * Submits the specified job, so that it is executed as soon as a
+			 * worker is available.
+			 *
+			 * @param job the job to execute, which must not be already
+			 * pending or running.
+			 *
+			 * @param transferOwnership if true, the pool takes ownership of
+			 * the job, and will deallocate it once executed (hence it must not
+			 * be used by the caller anymore); otherwise the caller keeps
+			 * ownership, and must not deallocate the job before it is
+			 * completed.
+			 *
+			 * @throw WorkerPoolException if the job could not be submitted.
+			 *
+			 */
+			virtual void submit( Job & job, bool transferOwnership = false ) ;
+
+
+
+			/**
+			 * Returns the current state of the specified job, which must be
+			 * owned by the caller.
+			 *
+			 */
+			virtual Job::JobState getStateOf( const Job & job ) const ;
+
+
+
+			/**
+			 * Returns true iff the specified job, which must be owned by the
+			 * caller, has been executed, successfully or not (polling).
+			 *
+			 */
+			virtual bool isCompleted( const Job & job ) const ;
+
+
+
+			/**
+			 * Returns the reason why the execution of the specified job failed,
+			 * or an empty string if it did not fail.
+			 *
+			 */
+			virtual std::string getFailureReasonFor( const Job & job ) const ;
+
+
+
+			/**
+			 * Blocks until the specified job, which must be owned by the
+			 * caller, has been executed, or until the timeout expires.
+			 *
+			 * @param job the job to wait for.
+			 *
+			 * @param timeout the maximum duration to wait, in milliseconds.
+			 *
+			 * @return true iff the job has been executed (successfully or not)
+			 * before the timeout expired.
+			 *
+			 */
+			virtual bool waitFor( const Job & job,
+				Ceylan::Uint32 timeout = WaitIndefinitely ) ;
+
+
+
+			/**
+			 * Blocks until all jobs submitted so far have been executed, or
+			 * until the timeout expires.
+			 *
+			 * @param timeout the maximum duration to wait, in milliseconds.
+			 *
+			 * @return true iff no job remains pending or running.
+			 *
+			 */
+			virtual bool waitForAll(
+				Ceylan::Uint32 timeout = WaitIndefinitely ) ;
+
+
+
+			/**
+			 * Returns the number of jobs that are either pending or being
+			 * executed.
+			 *
+			 */
+			virtual Ceylan::Uint32 getPendingCount() const ;
+
+
+
+			/// Returns the number of worker threads of this pool.
+			virtual Ceylan::Uint32 getWorkerCount() const ;
+
+
+
+			/**
+			 * Returns an user-friendly description of the state of this
+			 * object.
+			 *
+			 * @param level the requested verbosity level.
+			 *
+			 * @note Text output format is determined from overall settings.
+			 *
+			 * @see Ceylan::TextDisplayable
+			 *
+			 */
+			virtual const std::string toString(
+				Ceylan::VerbosityLevels level = Ceylan::high ) const ;
+
+
+
+
+			// Static section.
+
+
+			/**
+			 * Returns the number of workers that should be used by default,
+			 * i.e. the number of online processors, if it can be determined,
+			 * otherwise two.
+			 *
+			 */
+			static Ceylan::Uint32 GetDefaultWorkerCount() ;
+
+
+			/// Timeout meaning that a wait should never expire.
+			static const Ceylan::Uint32 WaitIndefinitely ;
+
+
+
+		protected:
+
+
+
+			/**
+			 * The function run by each worker thread, whose argument is the
+			 * pool itself.
+			 *
+			 */
+			static int RunWorker( void * pool ) ;
+
+
+			/**
+			 * Executes the specified job, and records its outcome; the mutex
+			 * must not be held by the caller.
+			 *
+			 * @return true iff the job is to be deallocated by the pool.
+			 *
+			 */
+			bool executeJob( Job & job ) ;
+
+
+			/**
+			 * Destroys the mutex and condition variables of this pool, those
+			 * not created yet being null.
+			 *
+			 */
+			void destroySynchronizationPrimitives() ;
+
+
+
+			/// The name of this pool.
+			std::string _name ;
+
+
+			/// The number of worker threads.
+			Ceylan::Uint32 _workerCount ;
+
+
+			/// The number of jobs being currently executed.
+			Ceylan::Uint32 _runningCount ;
+
+
+			/// Tells whether the workers have been requested to stop.
+			bool _stopRequested ;
+
+
+			/*
+			 * Takes care of the awful issue of Windows DLL with templates.
+			 *
+			 * @see Ceylan's developer guide and README-build-for-windows.txt
+			 * to understand it, and to be aware of the associated risks.
+			 *
+			 */
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+
+			/// The jobs waiting for a worker, in submission order.
+			std::list<Job *> _pendingJobs ;
+
+			/// The worker threads (none without SDL).
+			std::vector<SDL_Thread *> _workers ;
+
+#pragma warning( pop )
+
+
+			/// Protects the jobs and the state of this pool (null without SDL).
+			SDL_mutex * _mutex ;
+
+
+			/// Signaled whenever a job is submitted, or a stop requested.
+			SDL_cond * _jobAvailable ;
+
+
+			/// Signaled (broadcast) whenever a job has been executed.
+			SDL_cond * _jobExecuted ;
+
+
+
+		private:
+
+
+
+			/**
+			 * Copy constructor made private to ensure that it will never be
+			 * called.
+			 *
+			 * The compiler should complain whenever this undefined constructor
+			 * is called, implicitly or not.
+			 *
+			 */
+			WorkerPool( const WorkerPool & source ) ;
+
+
+			/**
+			 * Assignment operator made private to ensure that it will never be
+			 * called.
+			 *
+			 * The compiler should complain whenever this undefined operator is
+			 * called, implicitly or not.
+			 *
+			 */
+			WorkerPool & operator = ( const WorkerPool & source ) ;
+
+
+	} ;
+
+
+}
+
+
+
+#endif // OSDL_WORKER_POOL_H_
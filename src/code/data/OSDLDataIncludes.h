@@ -36,6 +36,7 @@
 
 
 #include "OSDLDataCommon.h"
+#include "OSDLResourceIndex.h"
 #include "OSDLResourceManager.h"
 
 
@@ -0,0 +1,756 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDLResourceIndex.h"
+
+#include "OSDLFileTags.h"             // for ResourceIndexTag
+#include "OSDLContentSpan.h"          // for ContentSpan
+#include "OSDLUtils.h"                // for readLittleEndianUint32
+
+
+#include <vector>
+#include <algorithm>                  // for std::sort
+#include <cstring>                    // for memcmp, memcpy
+
+
+using namespace Ceylan::System ;
+
+using namespace OSDL ;
+using namespace OSDL::Data ;
+
+using std::string ;
+using std::list ;
+
+using OSDL::Utils::readLittleEndianUint16 ;
+using OSDL::Utils::readLittleEndianUint32 ;
+using OSDL::Utils::readLittleEndianUint64 ;
+
+
+
+#ifdef OSDL_USES_CONFIG_H
+#include <OSDLConfig.h>               // for OSDL_DEBUG and al
+#endif // OSDL_USES_CONFIG_H
+
+#if OSDL_ARCH_NINTENDO_DS
+#include "OSDLConfigForNintendoDS.h"  // for OSDL_USES_* and al
+#endif // OSDL_ARCH_NINTENDO_DS
+
+
+/*
+ * Implementation notes:
+ *
+ * The content of the index is never copied into other data structures: all
+ * look-ups decode the integers they need directly from it, byte per byte, so
+ * that neither the alignment nor the endianness of the platform matter.
+ *
+ */
+
+
+
+/// Sizes, in bytes, of the records of an index file.
+const Ceylan::Uint32 HeaderSize = 24 ;
+const Ceylan::Uint32 EntrySize  = 24 ;
+const Ceylan::Uint32 BucketSize =  8 ;
+const Ceylan::Uint32 GroupSize  = 12 ;
+const Ceylan::Uint32 MemberSize =  4 ;
+
+
+/// Size of the entries of the first format version, which had no hashes.
+const Ceylan::Uint32 FirstVersionEntrySize = 16 ;
+
+
+
+/// Encodes the specified 32-bit integer at specified location, little-endian.
+inline void WriteUint32At( Ceylan::Byte * location, Ceylan::Uint32 value )
+{
+
+  location[0] = static_cast<Ceylan::Byte>(   value         & 0xff ) ;
+  location[1] = static_cast<Ceylan::Byte>( ( value >> 8  ) & 0xff ) ;
+  location[2] = static_cast<Ceylan::Byte>( ( value >> 16 ) & 0xff ) ;
+  location[3] = static_cast<Ceylan::Byte>( ( value >> 24 ) & 0xff ) ;
+
+}
+
+
+
+/// Orders entries by increasing resource identifier.
+static bool CompareEntries( const ResourceIndex::Entry & first,
+  const ResourceIndex::Entry & second )
+{
+
+  return first.id < second.id ;
+
+}
+
+
+
+
+ResourceIndexException::ResourceIndexException( const string & reason ) :
+  DataException( reason )
+{
+
+}
+
+
+
+ResourceIndexException::~ResourceIndexException() throw()
+{
+
+}
+
+
+
+
+const string ResourceIndex::FileExtension = ".osdl.index" ;
+
+const Ceylan::Uint8 ResourceIndex::FormatVersion = 2 ;
+
+
+
+ResourceIndex::ResourceIndex( const string & indexFilename ):
+  _span( 0 ),
+  _content( 0 ),
+  _size( 0 ),
+  _entrySize( EntrySize ),
+  _entryCount( 0 ),
+  _bucketCount( 0 ),
+  _groupCount( 0 ),
+  _memberCount( 0 ),
+  _poolSize( 0 ),
+  _entries( 0 ),
+  _buckets( 0 ),
+  _groups( 0 ),
+  _members( 0 ),
+  _pool( 0 )
+{
+
+  try
+  {
+
+	_span = new ContentSpan( indexFilename ) ;
+
+  }
+  catch( const ContentSpanException & e )
+  {
+
+	throw ResourceIndexException( "ResourceIndex constructor failed: "
+	  "unable to read '" + indexFilename + "': " + e.toString() ) ;
+
+  }
+
+  _content = _span->getData() ;
+  _size    = _span->getSize() ;
+
+  string problem ;
+
+  Size remaining = _size ;
+
+  if ( _size < HeaderSize )
+  {
+
+	problem = "file too short" ;
+
+  }
+  else if ( readLittleEndianUint16( _content ) != ResourceIndexTag )
+  {
+
+	problem = "not a resource index (wrong tag)" ;
+
+  }
+  else if ( _content[2] != FormatVersion && _content[2] != 1 )
+  {
+
+	problem = "unsupported format version ("
+	  + Ceylan::toNumericalString( _content[2] ) + ")" ;
+
+  }
+  else
+  {
+
+	// Entries of the first version have no content hash:
+	if ( _content[2] == 1 )
+	  _entrySize = FirstVersionEntrySize ;
+
+	_entryCount  = readLittleEndianUint32( _content + 4  ) ;
+	_bucketCount = readLittleEndianUint32( _content + 8  ) ;
+	_groupCount  = readLittleEndianUint32( _content + 12 ) ;
+	_memberCount = readLittleEndianUint32( _content + 16 ) ;
+	_poolSize    = readLittleEndianUint32( _content + 20 ) ;
+
+	remaining -= HeaderSize ;
+
+	// Each count is checked before being multiplied, against overflows:
+	if ( _bucketCount == 0 || ( _bucketCount & ( _bucketCount - 1 ) ) != 0
+		|| _bucketCount <= _entryCount )
+	  problem = "invalid number of hash buckets" ;
+	else if ( _entryCount > remaining / _entrySize )
+	  problem = "truncated entries" ;
+	else
+	{
+
+	  remaining -= _entryCount * _entrySize ;
+
+	  if ( _bucketCount > remaining / BucketSize )
+		problem = "truncated hash buckets" ;
+	  else
+		remaining -= _bucketCount * BucketSize ;
+
+	}
+
+	if ( problem.empty() )
+	{
+
+	  if ( _groupCount > remaining / GroupSize )
+		problem = "truncated groups" ;
+	  else if ( _memberCount > ( remaining - _groupCount * GroupSize )
+		  / MemberSize )
+		problem = "truncated group members" ;
+	  else if ( _poolSize != remaining - _groupCount * GroupSize
+		  - _memberCount * MemberSize )
+		problem = "string pool size does not match file size" ;
+
+	}
+
+  }
+
+  if ( problem.empty() )
+  {
+
+	_entries = _content + HeaderSize ;
+	_buckets = _entries + _entryCount  * _entrySize ;
+	_groups  = _buckets + _bucketCount * BucketSize ;
+	_members = _groups  + _groupCount  * GroupSize ;
+	_pool    = _members + _memberCount * MemberSize ;
+
+	for ( Ceylan::Uint32 i = 0; i < _entryCount && problem.empty(); i++ )
+	{
+
+	  const Ceylan::Byte * entry = _entries + i * _entrySize ;
+
+	  Ceylan::Uint32 offset = readLittleEndianUint32( entry + 4 ) ;
+	  Ceylan::Uint32 length = readLittleEndianUint32( entry + 8 ) ;
+
+	  if ( length > _poolSize || offset > _poolSize - length )
+		problem = "path of entry #" + Ceylan::toString( i ) + " out of bounds" ;
+	  else if ( i > 0 && readLittleEndianUint32( entry )
+		  <= readLittleEndianUint32( entry - _entrySize ) )
+		problem = "entries not sorted by identifier" ;
+
+	}
+
+	for ( Ceylan::Uint32 i = 0; i < _bucketCount && problem.empty(); i++ )
+	  if ( readLittleEndianUint32( _buckets + i * BucketSize + 4 )
+		  > _entryCount )
+		problem = "hash bucket #" + Ceylan::toString( i ) + " out of bounds" ;
+
+	Ceylan::Uint32 previousFirst = 0 ;
+
+	for ( Ceylan::Uint32 i = 0; i < _groupCount && problem.empty(); i++ )
+	{
+
+	  const Ceylan::Byte * group = _groups + i * GroupSize ;
+
+	  Ceylan::Uint32 offset = readLittleEndianUint32( group ) ;
+	  Ceylan::Uint32 length = readLittleEndianUint32( group + 4 ) ;
+	  Ceylan::Uint32 first  = readLittleEndianUint32( group + 8 ) ;
+
+	  if ( length > _poolSize || offset > _poolSize - length
+		  || first < previousFirst || first > _memberCount )
+		problem = "group #" + Ceylan::toString( i ) + " out of bounds" ;
+
+	  previousFirst = first ;
+
+	}
+
+  }
+
+  if ( ! problem.empty() )
+  {
+
+	delete _span ;
+
+	throw ResourceIndexException( "ResourceIndex constructor failed: '"
+	  + indexFilename + "' is not a valid index: " + problem + "." ) ;
+
+  }
+
+}
+
+
+
+ResourceIndex::~ResourceIndex() throw()
+{
+
+  delete _span ;
+
+}
+
+
+
+Ceylan::Uint32 ResourceIndex::getEntryCount() const
+{
+
+  return _entryCount ;
+
+}
+
+
+
+ResourceIndex::Entry ResourceIndex::getEntryAt( Ceylan::Uint32 index ) const
+{
+
+  if ( index >= _entryCount )
+	throw ResourceIndexException( "ResourceIndex::getEntryAt failed: "
+	  "no entry #" + Ceylan::toString( index ) + " in an index of "
+	  + Ceylan::toString( _entryCount ) + " entries." ) ;
+
+  return decodeEntry( _entries + index * _entrySize ) ;
+
+}
+
+
+
+bool ResourceIndex::findEntryFor( Ceylan::ResourceID id, Entry & entry ) const
+{
+
+  const Ceylan::Byte * location = locateEntry( id ) ;
+
+  if ( location == 0 )
+	return false ;
+
+  entry = decodeEntry( location ) ;
+
+  return true ;
+
+}
+
+
+
+list<ResourceIndex::Entry> ResourceIndex::getEntriesOfType(
+  Ceylan::Uint8 contentType ) const
+{
+
+  list<Entry> res ;
+
+  for ( Ceylan::Uint32 i = 0; i < _entryCount; i++ )
+  {
+
+	const Ceylan::Byte * entry = _entries + i * _entrySize ;
+
+	if ( entry[12] == contentType )
+	  res.push_back( decodeEntry( entry ) ) ;
+
+  }
+
+  return res ;
+
+}
+
+
+
+Ceylan::ResourceID ResourceIndex::getMaxID() const
+{
+
+  // Entries are sorted by increasing identifier:
+  if ( _entryCount == 0 )
+	return 0 ;
+
+  return static_cast<Ceylan::ResourceID>(
+	readLittleEndianUint32( _entries + ( _entryCount - 1 ) * _entrySize ) ) ;
+
+}
+
+
+
+bool ResourceIndex::findIDFor( const string & path,
+  Ceylan::ResourceID & id ) const
+{
+
+  Ceylan::Uint32 hash = HashPath( path ) ;
+  Ceylan::Uint32 mask = _bucketCount - 1 ;
+
+  Ceylan::Uint32 bucketIndex = hash & mask ;
+
+  // There is always at least an empty bucket, yet a corrupted table is bounded:
+  for ( Ceylan::Uint32 probe = 0; probe < _bucketCount; probe++ )
+  {
+
+	const Ceylan::Byte * bucket = _buckets + bucketIndex * BucketSize ;
+
+	Ceylan::Uint32 entryRank = readLittleEndianUint32( bucket + 4 ) ;
+
+	if ( entryRank == 0 )
+	  return false ;
+
+	if ( readLittleEndianUint32( bucket ) == hash )
+	{
+
+	  const Ceylan::Byte * entry = _entries + ( entryRank - 1 ) * _entrySize ;
+
+	  Ceylan::Uint32 length = readLittleEndianUint32( entry + 8 ) ;
+
+	  if ( length == path.size()
+		  && ::memcmp( _pool + readLittleEndianUint32( entry + 4 ),
+			path.data(), length ) == 0 )
+	  {
+
+		id = static_cast<Ceylan::ResourceID>( readLittleEndianUint32( entry ) ) ;
+		return true ;
+
+	  }
+
+	}
+
+	bucketIndex = ( bucketIndex + 1 ) & mask ;
+
+  }
+
+  return false ;
+
+}
+
+
+
+bool ResourceIndex::findPathFor( Ceylan::ResourceID id, string & path ) const
+{
+
+  const Ceylan::Byte * entry = locateEntry( id ) ;
+
+  if ( entry == 0 )
+	return false ;
+
+  path = getStringAt( readLittleEndianUint32( entry + 4 ),
+	readLittleEndianUint32( entry + 8 ) ) ;
+
+  return true ;
+
+}
+
+
+
+ResourceIndex::GroupMap ResourceIndex::getGroups() const
+{
+
+  GroupMap res ;
+
+  for ( Ceylan::Uint32 i = 0; i < _groupCount; i++ )
+  {
+
+	const Ceylan::Byte * group = _groups + i * GroupSize ;
+
+	Ceylan::Uint32 first = readLittleEndianUint32( group + 8 ) ;
+
+	Ceylan::Uint32 last = ( i + 1 < _groupCount ) ?
+	  readLittleEndianUint32( group + GroupSize + 8 ) : _memberCount ;
+
+	list<Ceylan::ResourceID> & members = res[ getStringAt(
+	  readLittleEndianUint32( group ), readLittleEndianUint32( group + 4 ) ) ] ;
+
+	for ( Ceylan::Uint32 m = first; m < last; m++ )
+	  members.push_back( static_cast<Ceylan::ResourceID>(
+		readLittleEndianUint32( _members + m * MemberSize ) ) ) ;
+
+  }
+
+  return res ;
+
+}
+
+
+
+const string ResourceIndex::toString( Ceylan::VerbosityLevels level ) const
+{
+
+  string res = "Resource index of " + Ceylan::toString( _entryCount )
+	+ " resource(s) and " + Ceylan::toString( _groupCount )
+	+ " group(s), with " + Ceylan::toString( _bucketCount )
+	+ " hash buckets" ;
+
+  if ( _span->isMapped() )
+	res += ", memory-mapped" ;
+
+  if ( level == Ceylan::low )
+	return res ;
+
+  return res + ", taking " + Ceylan::toString(
+	static_cast<Ceylan::Uint32>( _size ) ) + " bytes" ;
+
+}
+
+
+
+
+// Static section.
+
+
+
+void ResourceIndex::Save( const list<Entry> & entries,
+  const GroupMap & groups, const string & indexFilename )
+{
+
+  std::vector<Entry> sorted( entries.begin(), entries.end() ) ;
+
+  std::sort( sorted.begin(), sorted.end(), CompareEntries ) ;
+
+  Ceylan::Uint32 entryCount = static_cast<Ceylan::Uint32>( sorted.size() ) ;
+
+  // At most half-full, so that probe sequences remain short:
+  Ceylan::Uint32 bucketCount = 2 ;
+
+  while ( bucketCount < 2 * entryCount )
+	bucketCount *= 2 ;
+
+  Ceylan::Uint32 memberCount = 0 ;
+
+  for ( GroupMap::const_iterator it = groups.begin(); it != groups.end();
+	  it++ )
+	memberCount += static_cast<Ceylan::Uint32>( (*it).second.size() ) ;
+
+  string pool ;
+
+  for ( std::vector<Entry>::const_iterator it = sorted.begin();
+	  it != sorted.end(); it++ )
+	pool += (*it).path ;
+
+  for ( GroupMap::const_iterator it = groups.begin(); it != groups.end();
+	  it++ )
+	pool += (*it).first ;
+
+  Ceylan::Uint32 groupCount = static_cast<Ceylan::Uint32>( groups.size() ) ;
+
+  std::vector<Ceylan::Byte> content( HeaderSize + entryCount * EntrySize
+	+ bucketCount * BucketSize + groupCount * GroupSize
+	+ memberCount * MemberSize + pool.size(), 0 ) ;
+
+  Ceylan::Byte * header = & content[0] ;
+
+  header[0] = static_cast<Ceylan::Byte>( ResourceIndexTag & 0xff ) ;
+  header[1] = static_cast<Ceylan::Byte>( ResourceIndexTag >> 8 ) ;
+  header[2] = FormatVersion ;
+
+  WriteUint32At( header + 4,  entryCount ) ;
+  WriteUint32At( header + 8,  bucketCount ) ;
+  WriteUint32At( header + 12, groupCount ) ;
+  WriteUint32At( header + 16, memberCount ) ;
+  WriteUint32At( header + 20, static_cast<Ceylan::Uint32>( pool.size() ) ) ;
+
+  Ceylan::Byte * entryRecords = header + HeaderSize ;
+  Ceylan::Byte * buckets = entryRecords + entryCount * EntrySize ;
+  Ceylan::Byte * groupRecords = buckets + bucketCount * BucketSize ;
+  Ceylan::Byte * members = groupRecords + groupCount * GroupSize ;
+
+  Ceylan::Uint32 poolOffset = 0 ;
+
+  for ( Ceylan::Uint32 i = 0; i < entryCount; i++ )
+  {
+
+	const Entry & current = sorted[i] ;
+
+	if ( i > 0 && current.id == sorted[i-1].id )
+	  throw ResourceIndexException( "ResourceIndex::Save failed: "
+		"resource identifier #" + Ceylan::toString( current.id )
+		+ " listed more than once." ) ;
+
+	Ceylan::Uint32 length = static_cast<Ceylan::Uint32>( current.path.size() ) ;
+
+	Ceylan::Byte * entry = entryRecords + i * EntrySize ;
+
+	WriteUint32At( entry, static_cast<Ceylan::Uint32>( current.id ) ) ;
+	WriteUint32At( entry + 4, poolOffset ) ;
+	WriteUint32At( entry + 8, length ) ;
+	entry[12] = current.contentType ;
+
+	WriteUint32At( entry + 16,
+	  static_cast<Ceylan::Uint32>( current.contentHash & 0xffffffff ) ) ;
+	WriteUint32At( entry + 20,
+	  static_cast<Ceylan::Uint32>( current.contentHash >> 32 ) ) ;
+
+	Ceylan::Uint32 hash = HashPath( current.path ) ;
+	Ceylan::Uint32 bucketIndex = hash & ( bucketCount - 1 ) ;
+
+	// Linear probing, checking that paths are unique on the way:
+	while ( readLittleEndianUint32( buckets + bucketIndex * BucketSize + 4 )
+		!= 0 )
+	{
+
+	  const Ceylan::Byte * bucket = buckets + bucketIndex * BucketSize ;
+
+	  if ( readLittleEndianUint32( bucket ) == hash
+		  && sorted[ readLittleEndianUint32( bucket + 4 ) - 1 ].path
+			== current.path )
+		throw ResourceIndexException( "ResourceIndex::Save failed: "
+		  "resource path '" + current.path + "' listed more than once." ) ;
+
+	  bucketIndex = ( bucketIndex + 1 ) & ( bucketCount - 1 ) ;
+
+	}
+
+	WriteUint32At( buckets + bucketIndex * BucketSize, hash ) ;
+	WriteUint32At( buckets + bucketIndex * BucketSize + 4, i + 1 ) ;
+
+	poolOffset += length ;
+
+  }
+
+  Ceylan::Uint32 memberRank = 0 ;
+  Ceylan::Uint32 groupRank = 0 ;
+
+  for ( GroupMap::const_iterator it = groups.begin(); it != groups.end();
+	  it++ )
+  {
+
+	Ceylan::Byte * group = groupRecords + groupRank * GroupSize ;
+
+	Ceylan::Uint32 length = static_cast<Ceylan::Uint32>( (*it).first.size() ) ;
+
+	WriteUint32At( group, poolOffset ) ;
+	WriteUint32At( group + 4, length ) ;
+	WriteUint32At( group + 8, memberRank ) ;
+
+	poolOffset += length ;
+
+	for ( list<Ceylan::ResourceID>::const_iterator member =
+		(*it).second.begin(); member != (*it).second.end(); member++ )
+	{
+
+	  WriteUint32At( members + memberRank * MemberSize,
+		static_cast<Ceylan::Uint32>( *member ) ) ;
+
+	  memberRank++ ;
+
+	}
+
+	groupRank++ ;
+
+  }
+
+  if ( ! pool.empty() )
+	::memcpy( members + memberCount * MemberSize, pool.data(), pool.size() ) ;
+
+  try
+  {
+
+	Ceylan::Holder<File> indexHolder( File::Create( indexFilename ) ) ;
+
+	indexHolder->write( & content[0], content.size() ) ;
+
+  }
+  catch( const Ceylan::Exception & e )
+  {
+
+	throw ResourceIndexException( "ResourceIndex::Save failed for '"
+	  + indexFilename + "': " + e.toString() ) ;
+
+  }
+
+}
+
+
+
+Ceylan::Uint32 ResourceIndex::HashPath( const string & path )
+{
+
+  // 32-bit FNV-1a:
+  Ceylan::Uint32 hash = 2166136261U ;
+
+  for ( string::const_iterator it = path.begin(); it != path.end(); it++ )
+  {
+
+	hash ^= static_cast<Ceylan::Uint8>( *it ) ;
+	hash *= 16777619U ;
+
+  }
+
+  return hash ;
+
+}
+
+
+
+
+// Protected section.
+
+
+
+const Ceylan::Byte * ResourceIndex::locateEntry( Ceylan::ResourceID id ) const
+{
+
+  Ceylan::Uint32 low = 0 ;
+  Ceylan::Uint32 high = _entryCount ;
+
+  while ( low < high )
+  {
+
+	Ceylan::Uint32 middle = low + ( high - low ) / 2 ;
+
+	const Ceylan::Byte * entry = _entries + middle * _entrySize ;
+
+	Ceylan::Uint32 middleID = readLittleEndianUint32( entry ) ;
+
+	if ( middleID == id )
+	  return entry ;
+
+	if ( middleID < id )
+	  low = middle + 1 ;
+	else
+	  high = middle ;
+
+  }
+
+  return 0 ;
+
+}
+
+
+
+ResourceIndex::Entry ResourceIndex::decodeEntry(
+  const Ceylan::Byte * entry ) const
+{
+
+  Entry res ;
+
+  res.id          = static_cast<Ceylan::ResourceID>(
+	readLittleEndianUint32( entry ) ) ;
+  res.path        = getStringAt( readLittleEndianUint32( entry + 4 ),
+	readLittleEndianUint32( entry + 8 ) ) ;
+  res.contentType = entry[12] ;
+
+  res.contentHash = ( _entrySize == EntrySize ) ?
+	readLittleEndianUint64( entry + 16 ) : 0 ;
+
+  return res ;
+
+}
+
+
+
+string ResourceIndex::getStringAt( Ceylan::Uint32 offset,
+  Ceylan::Uint32 length ) const
+{
+
+  return string( reinterpret_cast<const char *>( _pool + offset ), length ) ;
+
+}
@@ -0,0 +1,427 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#ifndef OSDL_RESOURCE_INDEX_H_
+#define OSDL_RESOURCE_INDEX_H_
+
+
+#include "OSDLDataCommon.h"     // for DataException, ResourceID
+
+
+#include "Ceylan.h"             // for TextDisplayable, Byte
+
+
+#include <string>
+#include <list>
+#include <map>
+
+
+
+namespace OSDL
+{
+
+
+  // The content of an index is spanned:
+  class ContentSpan ;
+
+
+  namespace Data
+  {
+
+
+
+	/// Exception to be thrown when a resource index cannot be used.
+	class OSDL_DLL ResourceIndexException : public DataException
+	{
+	public:
+
+	  explicit ResourceIndexException( const std::string & reason ) ;
+
+	  virtual ~ResourceIndexException() throw() ;
+
+	} ;
+
+
+
+
+	/**
+	 * A compiled resource map, i.e. the binary counterpart of an XML resource
+	 * map, that can be used directly from memory without any parsing.
+	 *
+	 * Its file is used as it is, through a ContentSpan: it is memory-mapped
+	 * whenever possible (ex: a file of the standard filesystem), otherwise
+	 * read in a single operation (ex: a cyphered embedded file).
+	 *
+	 * The format is (all integers being little-endian):
+	 *
+	 * - the ResourceIndexTag file tag (Uint16), the format version (Uint8),
+	 * a reserved byte
+	 *
+	 * - the number of entries, of hash buckets, of groups, of group members,
+	 * and the size in bytes of the string pool (five Uint32)
+	 *
+	 * - the entries, sorted by increasing resource identifier, each being
+	 * the identifier (Uint32), the offset and the length of the resource
+	 * path in the string pool (two Uint32), the content type (Uint8), three
+	 * reserved bytes, and the hash of the content of the resource (Uint64,
+	 * see Utils::hashContent), null if unknown
+	 *
+	 * - the hash buckets, a power of two of them, each being the hash of a
+	 * path (Uint32) and the index of the corresponding entry plus one, zero
+	 * denoting an empty bucket (Uint32); collisions are resolved by linear
+	 * probing
+	 *
+	 * - the groups, each being the offset and the length of its name in the
+	 * string pool, and the index of its first member (three Uint32)
+	 *
+	 * - the group members, each being a resource identifier (Uint32), stored
+	 * group after group
+	 *
+	 * - the string pool, storing the paths and the group names, with no
+	 * terminating null bytes
+	 *
+	 * Content types are stored as the values of the Data::ContentType
+	 * enumeration.
+	 *
+	 * Indexes of the first format version, whose entries have no content
+	 * hash, can still be read.
+	 *
+	 * @see ResourceManager::CompileResourceMap to generate such an index from
+	 * an XML resource map, as create-OSDL-archive.sh does.
+	 *
+	 */
+	class OSDL_DLL ResourceIndex : public Ceylan::TextDisplayable
+	{
+
+
+	public:
+
+
+
+	  /// Describes a resource listed in an index.
+	  struct Entry
+	  {
+
+		/// The identifier of the resource.
+		Ceylan::ResourceID id ;
+
+		/// The content type of the resource (a Data::ContentType value).
+		Ceylan::Uint8 contentType ;
+
+		/// The path of the resource, in the archive.
+		std::string path ;
+
+		/// The hash of the content of the resource, null if unknown.
+		Ceylan::Uint64 contentHash ;
+
+	  } ;
+
+
+
+	  /// The groups of an index: each name is associated to its resources.
+	  typedef std::map<std::string, std::list<Ceylan::ResourceID> >
+		GroupMap ;
+
+
+
+	  /**
+	   * Reads the specified index file, so that it can be used.
+	   *
+	   * @param indexFilename the name of the index file, either in the
+	   * standard filesystem or in an embedded one.
+	   *
+	   * @throw ResourceIndexException if the file could not be read, or is
+	   * not a valid index.
+	   *
+	   */
+	  explicit ResourceIndex( const std::string & indexFilename ) ;
+
+
+
+	  /// Virtual destructor, releasing the content of the index file.
+	  virtual ~ResourceIndex() throw() ;
+
+
+
+	  /// Returns the number of entries of this index.
+	  Ceylan::Uint32 getEntryCount() const ;
+
+
+
+	  /**
+	   * Returns the specified entry of this index, entries being sorted by
+	   * increasing resource identifier.
+	   *
+	   * @param index the index of the entry, in [0;getEntryCount()[.
+	   *
+	   * @throw ResourceIndexException if there is no such entry.
+	   *
+	   */
+	  Entry getEntryAt( Ceylan::Uint32 index ) const ;
+
+
+
+	  /**
+	   * Looks-up the identifier of the resource whose path is specified,
+	   * thanks to the hash table of this index.
+	   *
+	   * @param path the path of the resource.
+	   *
+	   * @param id set to the identifier of the resource, if found.
+	   *
+	   * @return true iff the path is listed in this index.
+	   *
+	   */
+	  bool findIDFor( const std::string & path, Ceylan::ResourceID & id )
+		const ;
+
+
+
+	  /**
+	   * Looks-up the entry of the resource whose identifier is specified, by
+	   * binary search.
+	   *
+	   * @param id the identifier of the resource.
+	   *
+	   * @param entry set to the entry of the resource, if found.
+	   *
+	   * @return true iff the identifier is listed in this index.
+	   *
+	   */
+	  bool findEntryFor( Ceylan::ResourceID id, Entry & entry ) const ;
+
+
+
+	  /**
+	   * Returns the entries of the resources of the specified content type,
+	   * the paths of the other ones not being read.
+	   *
+	   */
+	  std::list<Entry> getEntriesOfType( Ceylan::Uint8 contentType ) const ;
+
+
+
+	  /// Returns the greatest identifier listed, zero if there is no entry.
+	  Ceylan::ResourceID getMaxID() const ;
+
+
+
+	  /**
+	   * Looks-up the path of the resource whose identifier is specified, by
+	   * binary search.
+	   *
+	   * @param id the identifier of the resource.
+	   *
+	   * @param path set to the path of the resource, if found.
+	   *
+	   * @return true iff the identifier is listed in this index.
+	   *
+	   */
+	  bool findPathFor( Ceylan::ResourceID id, std::string & path ) const ;
+
+
+
+	  /// Returns the groups listed in this index.
+	  GroupMap getGroups() const ;
+
+
+
+	  /**
+	   * Returns an user-friendly description of the state of this object.
+	   *
+	   * @param level the requested verbosity level.
+	   *
+	   * @note Text output format is determined from overall settings.
+	   *
+	   * @see Ceylan::TextDisplayable
+	   *
+	   */
+	  virtual const std::string toString(
+		Ceylan::VerbosityLevels level = Ceylan::high ) const ;
+
+
+
+
+	  // Static section.
+
+
+
+	  /**
+	   * Writes an index file listing the specified resources and groups.
+	   *
+	   * @param entries the resources to list, in any order.
+	   *
+	   * @param groups the groups to list.
+	   *
+	   * @param indexFilename the name of the file to create.
+	   *
+	   * @throw ResourceIndexException if an identifier or a path is listed
+	   * more than once, or if the file could not be written.
+	   *
+	   */
+	  static void Save( const std::list<Entry> & entries,
+		const GroupMap & groups, const std::string & indexFilename ) ;
+
+
+
+	  /**
+	   * Returns the hash of the specified path, as used by indexes
+	   * (32-bit FNV-1a).
+	   *
+	   */
+	  static Ceylan::Uint32 HashPath( const std::string & path ) ;
+
+
+
+	  /// The extension of index files, ".osdl.index".
+	  static const std::string FileExtension ;
+
+
+
+	  /// The version of the index format written by Save.
+	  static const Ceylan::Uint8 FormatVersion ;
+
+
+
+
+	protected:
+
+
+
+	  /**
+	   * Returns the location of the entry of the specified resource, by binary
+	   * search, or null if it is not listed.
+	   *
+	   */
+	  const Ceylan::Byte * locateEntry( Ceylan::ResourceID id ) const ;
+
+
+
+	  /// Decodes the entry stored at the specified location.
+	  Entry decodeEntry( const Ceylan::Byte * entry ) const ;
+
+
+
+	  /// Returns the path stored at the specified location of the pool.
+	  std::string getStringAt( Ceylan::Uint32 offset, Ceylan::Uint32 length )
+		const ;
+
+
+
+	  /// The span of the index file, owned.
+	  ContentSpan * _span ;
+
+
+	  /// The content of the index file.
+	  const Ceylan::Byte * _content ;
+
+
+	  /// The size of this content, in bytes.
+	  Ceylan::System::Size _size ;
+
+
+	  /// The size of an entry, in bytes, which depends on the format version.
+	  Ceylan::Uint32 _entrySize ;
+
+
+	  /// The number of entries.
+	  Ceylan::Uint32 _entryCount ;
+
+
+	  /// The number of hash buckets, a power of two.
+	  Ceylan::Uint32 _bucketCount ;
+
+
+	  /// The number of groups.
+	  Ceylan::Uint32 _groupCount ;
+
+
+	  /// The total number of group members.
+	  Ceylan::Uint32 _memberCount ;
+
+
+	  /// The size of the string pool, in bytes.
+	  Ceylan::Uint32 _poolSize ;
+
+
+	  /// The start of the entries in the content.
+	  const Ceylan::Byte * _entries ;
+
+
+	  /// The start of the hash buckets in the content.
+	  const Ceylan::Byte * _buckets ;
+
+
+	  /// The start of the groups in the content.
+	  const Ceylan::Byte * _groups ;
+
+
+	  /// The start of the group members in the content.
+	  const Ceylan::Byte * _members ;
+
+
+	  /// The start of the string pool in the content.
+	  const Ceylan::Byte * _pool ;
+
+
+
+	private:
+
+
+
+	  /**
+	   * Copy constructor made private to ensure that it will never be called.
+	   *
+	   * The compiler should complain whenever this undefined constructor is
+	   * called, implicitly or not.
+	   *
+	   */
+	  explicit ResourceIndex( const ResourceIndex & source ) ;
+
+
+
+	  /**
+	   * Assignment operator made private to ensure that it will never be
+	   * called.
+	   *
+	   * The compiler should complain whenever this undefined operator is
+	   * called, implicitly or not.
+	   *
+	   */
+	  ResourceIndex & operator = ( const ResourceIndex & source ) ;
+
+
+
+	} ;
+
+
+  }
+
+}
+
+
+
+#endif // OSDL_RESOURCE_INDEX_H_
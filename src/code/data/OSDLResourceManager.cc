@@ -29,6 +29,13 @@
 #include "OSDLMusic.h"                // for Music constructor
 #include "OSDLSound.h"                // for Sound constructor
 #include "OSDLGLTexture.h"            // for GLTexture constructor
+#include "OSDLImageAtlas.h"           // for AtlasImage
+#include "OSDLUtils.h"                // for hashContent
+#include "OSDLVideo.h"                // for VideoModule
+#include "OSDLOpenGL.h"               // for RedMask and al
+
+#include <algorithm>                  // for std::find, std::min
+#include <vector>
 
 
 using namespace Ceylan ;              // for ResourceID
@@ -44,12 +51,33 @@ using std::list ;
 using std::pair ;
 using std::map ;
 
+using Ceylan::System::Second ;
+using Ceylan::System::Microsecond ;
+
 
 
 #ifdef OSDL_USES_CONFIG_H
 #include <OSDLConfig.h>               // for OSDL_DEBUG_RESOURCE_MANAGER and al
 #endif // OSDL_USES_CONFIG_H
 
+#if OSDL_ARCH_NINTENDO_DS
+#include "OSDLConfigForNintendoDS.h"  // for OSDL_USES_SDL_MIXER and al
+#endif // OSDL_ARCH_NINTENDO_DS
+
+
+#if OSDL_USES_SDL_MIXER && ! OSDL_ARCH_NINTENDO_DS
+
+#include "SDL_mixer.h"                // for Mix_LoadWAV_RW
+
+// Sounds are decoded, and musics streamed from memory, only with SDL_mixer:
+#define OSDL_PREFETCHES_AUDIO_IN_BACKGROUND 1
+
+#else // OSDL_USES_SDL_MIXER && ! OSDL_ARCH_NINTENDO_DS
+
+#define OSDL_PREFETCHES_AUDIO_IN_BACKGROUND 0
+
+#endif // OSDL_USES_SDL_MIXER && ! OSDL_ARCH_NINTENDO_DS
+
 
 
 #if OSDL_DEBUG_RESOURCE_MANAGER
@@ -84,7 +112,301 @@ using std::map ;
  * Splitting resources into a set of typed maps allows faster look-ups and
  * removes the need of casts.
  *
+ * Prefetched images and textures are read and decoded by the workers of a
+ * pool, but their surfaces are only handed to their instances by the main
+ * thread, since surfaces must not be created or deleted elsewhere. The files of
+ * the other prefetched resources are read by these workers as well, sounds
+ * being decoded there too (Mix_LoadWAV_RW only converts samples); only the
+ * opening of musics and fonts, and the uploading of textures, which rely on
+ * back-ends not meant to be used from other threads, are left to the main
+ * thread.
+ *
+ */
+
+
+
+namespace OSDL
+{
+
+
+  namespace Data
+  {
+
+
+
+	/**
+	 * Reads the file of a prefetched sound, music or font, from a worker
+	 * thread, and decodes it if it is a sound.
+	 *
+	 */
+	class ResourcePrefetchJob : public OSDL::Job
+	{
+
+
+	public:
+
+
+	  ResourcePrefetchJob( const string & filename, bool decodeAsSound ):
+		Job( "prefetching of " + filename ),
+		_filename( filename ),
+		_decodeAsSound( decodeAsSound ),
+		_content( 0 ),
+		_size( 0 ),
+		_sound( 0 ),
+		_ioDuration( 0 ),
+		_decodeDuration( 0 )
+	  {
+
+	  }
+
+
+	  virtual ~ResourcePrefetchJob() throw()
+	  {
+
+		// Set iff not delivered:
+		if ( _content != 0 )
+		  delete [] _content ;
+
+#if OSDL_PREFETCHES_AUDIO_IN_BACKGROUND
+
+		if ( _sound != 0 )
+		  ::Mix_FreeChunk( _sound ) ;
+
+#endif // OSDL_PREFETCHES_AUDIO_IN_BACKGROUND
+
+	  }
+
+
+	  virtual void execute()
+	  {
+
+		Second startSecond, stopSecond ;
+		Microsecond startMicrosecond, stopMicrosecond ;
+
+		Ceylan::System::getPreciseTime( startSecond, startMicrosecond ) ;
+
+		try
+		{
+
+		  Ceylan::Holder<Ceylan::System::File> file(
+			Ceylan::System::File::Open( _filename ) ) ;
+
+		  _size = file->size() ;
+		  _content = new Ceylan::Byte[ _size ] ;
+
+		  file->readExactLength( _content, _size ) ;
+
+		}
+		catch( const Ceylan::Exception & e )
+		{
+
+		  throw ResourceManagerException( "unable to read '" + _filename
+			+ "': " + e.toString() ) ;
+
+		}
+
+		Ceylan::System::getPreciseTime( stopSecond, stopMicrosecond ) ;
+
+		_ioDuration = Ceylan::System::getDurationBetween( startSecond,
+		  startMicrosecond, stopSecond, stopMicrosecond ) ;
+
+		if ( ! _decodeAsSound )
+		  return ;
+
+#if OSDL_PREFETCHES_AUDIO_IN_BACKGROUND
+
+		// Decoded and converted to the output format of the mixer:
+		_sound = ::Mix_LoadWAV_RW( ::SDL_RWFromConstMem( _content,
+			static_cast<int>( _size ) ), /* automatic free source */ true ) ;
+
+		// The chunk has its own copy of the samples:
+		delete [] _content ;
+		_content = 0 ;
+
+		if ( _sound == 0 )
+		  throw ResourceManagerException( "unable to decode the sound stored "
+			"in '" + _filename + "': " + string( ::Mix_GetError() ) ) ;
+
+		Ceylan::System::getPreciseTime( startSecond, startMicrosecond ) ;
+
+		_decodeDuration = Ceylan::System::getDurationBetween( stopSecond,
+		  stopMicrosecond, startSecond, startMicrosecond ) ;
+
+#else // OSDL_PREFETCHES_AUDIO_IN_BACKGROUND
+
+		throw ResourceManagerException( "no SDL_mixer support available" ) ;
+
+#endif // OSDL_PREFETCHES_AUDIO_IN_BACKGROUND
+
+	  }
+
+
+	  /// Hands over the content read, if any.
+	  Ceylan::Byte * takeContent()
+	  {
+
+		Ceylan::Byte * res = _content ;
+		_content = 0 ;
+
+		return res ;
+
+	  }
+
+
+	  /// Hands over the decoded sound, if any.
+	  Audio::LowLevelSound * takeSound()
+	  {
+
+		Audio::LowLevelSound * res = _sound ;
+		_sound = 0 ;
+
+		return res ;
+
+	  }
+
+
+	  string _filename ;
+
+	  bool _decodeAsSound ;
+
+	  Ceylan::Byte * _content ;
+
+	  Ceylan::System::Size _size ;
+
+	  Audio::LowLevelSound * _sound ;
+
+	  /// Time spent reading the file, in microseconds.
+	  Microsecond _ioDuration ;
+
+	  /// Time spent decoding the sound, if any, in microseconds.
+	  Microsecond _decodeDuration ;
+
+
+	} ;
+
+  }
+
+}
+
+
+
+/**
+ * Loads the specified resource if it has no content yet, measuring the
+ * duration of that loading.
+ *
+ * @return true iff a loading was performed, in which case duration is set.
+ *
+ */
+template <typename ResourcePtr>
+static bool LoadMeasured( ResourcePtr & resource, Microsecond & duration )
+{
+
+  if ( resource->hasContent() )
+	return false ;
+
+  Second startSecond, stopSecond ;
+  Microsecond startMicrosecond, stopMicrosecond ;
+
+  Ceylan::System::getPreciseTime( startSecond, startMicrosecond ) ;
+
+  resource->load() ;
+
+  Ceylan::System::getPreciseTime( stopSecond, stopMicrosecond ) ;
+
+  duration = Ceylan::System::getDurationBetween( startSecond,
+	startMicrosecond, stopSecond, stopMicrosecond ) ;
+
+  return true ;
+
+}
+
+
+
+
+/*
+ * Returns the memory taken by the specified loaded resource, as accounted
+ * against the memory budget.
+ *
+ */
+
+static Ceylan::System::Size SizeOf( const Audio::MusicCountedPtr & music )
+{
+
+  // Only the musics streamed from memory (once prefetched) are accounted:
+  return music->getSizeInMemory() ;
+
+}
+
+
+static Ceylan::System::Size SizeOf( const Audio::SoundCountedPtr & sound )
+{
+
+  return sound->getSizeInMemory() ;
+
+}
+
+
+static Ceylan::System::Size SizeOf(
+  const Video::TwoDimensional::ImageCountedPtr & image )
+{
+
+  return image->getExistingContentAsConst().getSizeInMemory() ;
+
+}
+
+
+static Ceylan::System::Size SizeOf(
+  const Video::OpenGL::TextureCountedPtr & texture )
+{
+
+  return texture->getExistingContentAsConst().getSizeInMemory() ;
+
+}
+
+
+static Ceylan::System::Size SizeOf(
+  const Video::TwoDimensional::Text::TrueTypeFontCountedPtr & font )
+{
+
+  return font->getCacheStatistics().bytes ;
+
+}
+
+
+
+/**
+ * Tells whether the specified resource is in the specified map: if yes, sets
+ * its type and tells whether it is loaded and, if loaded, returns its size and
+ * reference count.
+ *
  */
+template <typename ResourcePtr>
+static bool GetStateIn(
+  const map< ResourceID, pair<ResourcePtr,bool> > & resources, ResourceID id,
+  ContentType resourcesType, Ceylan::System::Size & size,
+  Ceylan::Uint32 & referenceCount, ContentType & type, bool & loaded )
+{
+
+  typename map< ResourceID, pair<ResourcePtr,bool> >::const_iterator it =
+	resources.find( id ) ;
+
+  if ( it == resources.end() )
+	return false ;
+
+  type = resourcesType ;
+  loaded = (*it).second.first->hasContent() ;
+
+  if ( loaded )
+  {
+
+	size = SizeOf( (*it).second.first ) ;
+	referenceCount = (*it).second.first.getReferenceCount() ;
+
+  }
+
+  return true ;
+
+}
 
 
 Data::ResourceManagerException::ResourceManagerException(
@@ -115,35 +437,118 @@ typedef std::list<Ceylan::XML::XMLParser::XMLTree * > XMLSubtreeList ;
 
 
 Data::ResourceManager::ResourceManager( const string & resourceMapFilename ):
-  _maxID( 0 )
+  _maxID( 0 ),
+  _prefetchPool( 0 ),
+  _prefetchLoader( 0 ),
+  _textureFormatHolder( 0 ),
+  _memoryBudget( 0 ),
+  _index( 0 )
 {
 
-  send( "Creating a ResourceManager based on the resource map in file '"
-	+ resourceMapFilename + "'." ) ;
+  _clockHand = _clock.end() ;
 
-  Ceylan::XML::XMLParser * resourceParser =
-	new Ceylan::XML::XMLParser( resourceMapFilename ) ;
+  _statistics.hits         = 0 ;
+  _statistics.misses       = 0 ;
+  _statistics.evictions    = 0 ;
+  _statistics.musicBytes   = 0 ;
+  _statistics.imageBytes   = 0 ;
+  _statistics.soundBytes   = 0 ;
+  _statistics.textureBytes = 0 ;
+  _statistics.fontBytes    = 0 ;
 
-  //send( resourceParser->toString() ) ;
+  const string & extension = ResourceIndex::FileExtension ;
 
-  resourceParser->loadFromFile() ;
+  if ( resourceMapFilename.size() > extension.size()
+	  && resourceMapFilename.compare( resourceMapFilename.size()
+		- extension.size(), extension.size(), extension ) == 0 )
+  {
 
-  //send( resourceParser->toString() ) ;
+	send( "Creating a ResourceManager based on the compiled resource map in "
+	  "file '" + resourceMapFilename + "'." ) ;
 
-  Ceylan::XML::XMLParser::XMLTree & root = resourceParser->getXMLTree() ;
+	try
+	{
 
-  //send( "Inserting resource defined in: " + root.toString() ) ;
+	  _index = new ResourceIndex( resourceMapFilename ) ;
 
-  // Sons are directly the resource entries:
-  const XMLSubtreeList & sons = root.getSons() ;
+	}
+	catch( const ResourceIndexException & e )
+	{
 
-  for ( XMLSubtreeList::const_iterator it = sons.begin();
-		it != sons.end(); it++ )
-	registerResource( *(*it) ) ;
+	  throw ResourceManagerException( "ResourceManager constructor failed: "
+		+ e.toString() ) ;
 
-  send( "All resources inserted, initial state is: " + toString() ) ;
+	}
+
+	/*
+	 * Paths are looked-up directly in the index, hence the reverse map is
+	 * left empty, and resources are only created when first used (see
+	 * resolveResource), except atlases, which register their packed images:
+	 *
+	 */
+	_maxID = _index->getMaxID() ;
+
+	list<ResourceIndex::Entry> atlasEntries = _index->getEntriesOfType(
+	  Data::image_atlas ) ;
+
+	for ( list<ResourceIndex::Entry>::const_iterator it =
+		  atlasEntries.begin(); it != atlasEntries.end(); it++ )
+	  _pendingAtlasPaths.push_back( (*it).path ) ;
+
+	_groups = _index->getGroups() ;
+
+  }
+  else
+  {
+
+	send( "Creating a ResourceManager based on the resource map in file '"
+	  + resourceMapFilename + "'." ) ;
+
+	Ceylan::XML::XMLParser * resourceParser =
+	  new Ceylan::XML::XMLParser( resourceMapFilename ) ;
+
+	//send( resourceParser->toString() ) ;
+
+	resourceParser->loadFromFile() ;
+
+	//send( resourceParser->toString() ) ;
+
+	Ceylan::XML::XMLParser::XMLTree & root = resourceParser->getXMLTree() ;
+
+	//send( "Inserting resource defined in: " + root.toString() ) ;
+
+	// Sons are directly the resource entries:
+	const XMLSubtreeList & sons = root.getSons() ;
+
+	for ( XMLSubtreeList::const_iterator it = sons.begin();
+		  it != sons.end(); it++ )
+	  registerResource( *(*it) ) ;
+
+	delete resourceParser ;
 
-  delete resourceParser ;
+  }
+
+  /*
+   * Atlases are registered last, so that the identifiers they allocate do not
+   * collide with the ones read from the map:
+   *
+   */
+  for ( list<string>::const_iterator it = _pendingAtlasPaths.begin();
+		it != _pendingAtlasPaths.end(); it++ )
+	registerImageAtlas( *it ) ;
+
+  _pendingAtlasPaths.clear() ;
+
+  // Still needed by the resources of an index, registered when first used:
+  if ( _index == 0 )
+	_contentOwners.clear() ;
+
+  if ( ! _sharedContents.empty() )
+	send( Ceylan::toString(
+	  static_cast<Ceylan::Uint32>( _sharedContents.size() ) )
+	  + " resource(s) share the instance of an identical one." ) ;
+
+  send( "All resources inserted, initial state is: " + toString() ) ;
 
   dropIdentifier() ;
 
@@ -163,6 +568,36 @@ Data::ResourceManager::~ResourceManager() throw()
 
   send( "Deleting ResourceManager, whose final state was: " + toString() ) ;
 
+  // Waits for the files still being read, and deletes the undelivered ones:
+  for ( map<ResourceID, ResourcePrefetchJob *>::iterator it =
+		_resourcePrefetches.begin(); it != _resourcePrefetches.end(); it++ )
+  {
+
+	// Jobs are not owned by the pool:
+	_prefetchPool->waitFor( *(*it).second ) ;
+
+	delete (*it).second ;
+
+  }
+
+  for ( map<ResourceID, string>::const_iterator it =
+		_heldFontContents.begin(); it != _heldFontContents.end(); it++ )
+	Text::TrueTypeFont::ReleaseFontContent( (*it).second ) ;
+
+  // Waits for the images still being decoded, and deletes the undelivered ones:
+  if ( _prefetchLoader != 0 )
+	delete _prefetchLoader ;
+
+  // Not before, as the loader may still be converting textures to it:
+  if ( _textureFormatHolder != 0 )
+	delete _textureFormatHolder ;
+
+  if ( _prefetchPool != 0 )
+	delete _prefetchPool ;
+
+  if ( _index != 0 )
+	delete _index ;
+
 }
 
 
@@ -173,6 +608,9 @@ Audio::MusicCountedPtr Data::ResourceManager::getMusic( Ceylan::ResourceID id,
 
   send( "Getting music whose ID is " + Ceylan::toString( id ) ) ;
 
+  // Resources of identical contents share a single instance:
+  id = resolveResource( id ) ;
+
   map<Ceylan::ResourceID, pair<Audio::MusicCountedPtr,bool> >::iterator it =
 	_musicMap.find( id ) ;
 
@@ -215,8 +653,18 @@ Audio::MusicCountedPtr Data::ResourceManager::getMusic( Ceylan::ResourceID id,
 
   }
 
+  // A prefetched music may just be waiting for its installation:
+  completeResourcePrefetch( id ) ;
+
   // Ensures a returned resource is always loaded:
-  res->load() ;
+  Ceylan::System::Microsecond loadDuration ;
+
+  bool hit = ! LoadMeasured( res, loadDuration ) ;
+
+  if ( ! hit )
+	recordLatency( id, loadDuration ) ;
+
+  recordAccess( id, hit ) ;
 
   return res ;
 
@@ -231,7 +679,9 @@ Audio::MusicCountedPtr Data::ResourceManager::getMusic(
   send( "Getting music whose path is '" + musicPath + "'." ) ;
 
   map<Ceylan::ResourceID, pair<Audio::MusicCountedPtr,bool> >::iterator it =
-	_musicMap.find( getIDForPath(musicPath) ) ;
+	_musicMap.find( resolveResource( getIDForPath(musicPath) ) ) ;
+
+  Ceylan::ResourceID id = (*it).first ;
 
   pair<Audio::MusicCountedPtr,bool> targetResPair = (*it).second ;
   Audio::MusicCountedPtr res = targetResPair.first ;
@@ -261,8 +711,6 @@ Audio::MusicCountedPtr Data::ResourceManager::getMusic(
 
 	  // Swaps previous and new entries (not at the same place, though):
 	  _musicMap.erase( it ) ;
-
-	  Ceylan::ResourceID id = (*it).first ;
 	  _musicMap.insert( std::make_pair( id, newResPair ) ) ;
 
 	}
@@ -270,8 +718,18 @@ Audio::MusicCountedPtr Data::ResourceManager::getMusic(
 
   }
 
+  // A prefetched music may just be waiting for its installation:
+  completeResourcePrefetch( id ) ;
+
   // Ensures a returned resource is always loaded:
-  res->load() ;
+  Ceylan::System::Microsecond loadDuration ;
+
+  bool hit = ! LoadMeasured( res, loadDuration ) ;
+
+  if ( ! hit )
+	recordLatency( id, loadDuration ) ;
+
+  recordAccess( id, hit ) ;
 
   return res ;
 
@@ -285,6 +743,9 @@ Audio::SoundCountedPtr Data::ResourceManager::getSound( Ceylan::ResourceID id,
 
   send( "Getting sound whose ID is " + Ceylan::toString( id ) ) ;
 
+  // Resources of identical contents share a single instance:
+  id = resolveResource( id ) ;
+
   map<Ceylan::ResourceID, pair<Audio::SoundCountedPtr,bool> >::iterator it =
 	_soundMap.find( id ) ;
 
@@ -327,8 +788,18 @@ Audio::SoundCountedPtr Data::ResourceManager::getSound( Ceylan::ResourceID id,
 
   }
 
+  // A prefetched sound may just be waiting for its installation:
+  completeResourcePrefetch( id ) ;
+
   // Ensures a returned resource is always loaded:
-  res->load() ;
+  Ceylan::System::Microsecond loadDuration ;
+
+  bool hit = ! LoadMeasured( res, loadDuration ) ;
+
+  if ( ! hit )
+	recordLatency( id, loadDuration ) ;
+
+  recordAccess( id, hit ) ;
 
   return res ;
 
@@ -344,13 +815,15 @@ Audio::SoundCountedPtr Data::ResourceManager::getSound(
   send( "Getting sound whose path is '" + soundPath + "'" ) ;
 
   map<Ceylan::ResourceID, pair<Audio::SoundCountedPtr,bool> >::iterator it =
-	_soundMap.find( getIDForPath(soundPath) ) ;
+	_soundMap.find( resolveResource( getIDForPath(soundPath) ) ) ;
 
   if ( it == _soundMap.end() )
 	throw ResourceManagerException(
 	  "ResourceManager::getSound: sound path '" + soundPath
 	  + "' could not be found." ) ;
 
+  Ceylan::ResourceID id = (*it).first ;
+
   pair<Audio::SoundCountedPtr,bool> targetResPair = (*it).second ;
   Audio::SoundCountedPtr res = targetResPair.first ;
 
@@ -379,8 +852,6 @@ Audio::SoundCountedPtr Data::ResourceManager::getSound(
 
 	  // Swaps previous and new entries (not at the same place, though):
 	  _soundMap.erase( it ) ;
-
-	  Ceylan::ResourceID id = (*it).first ;
 	  _soundMap.insert( std::make_pair( id, newResPair ) ) ;
 
 	}
@@ -388,8 +859,18 @@ Audio::SoundCountedPtr Data::ResourceManager::getSound(
 
   }
 
+  // A prefetched sound may just be waiting for its installation:
+  completeResourcePrefetch( id ) ;
+
   // Ensures a returned resource is always loaded:
-  res->load() ;
+  Ceylan::System::Microsecond loadDuration ;
+
+  bool hit = ! LoadMeasured( res, loadDuration ) ;
+
+  if ( ! hit )
+	recordLatency( id, loadDuration ) ;
+
+  recordAccess( id, hit ) ;
 
   return res ;
 
@@ -403,6 +884,9 @@ Video::TwoDimensional::ImageCountedPtr Data::ResourceManager::getImage(
 
   send( "Getting image whose ID is " + Ceylan::toString( id ) ) ;
 
+  // Resources of identical contents share a single instance:
+  id = resolveResource( id ) ;
+
   map<Ceylan::ResourceID,
 	  pair< Video::TwoDimensional::ImageCountedPtr, bool > >::iterator it =
 	_imageMap.find( id ) ;
@@ -447,8 +931,18 @@ Video::TwoDimensional::ImageCountedPtr Data::ResourceManager::getImage(
 
   }
 
+  // A prefetched image may just be waiting for its installation:
+  completeImagePrefetch( id ) ;
+
   // Ensures a returned resource is always loaded:
-  res->load() ;
+  Ceylan::System::Microsecond loadDuration ;
+
+  bool hit = ! LoadMeasured( res, loadDuration ) ;
+
+  if ( ! hit )
+	recordLatency( id, loadDuration ) ;
+
+  recordAccess( id, hit ) ;
 
   return res ;
 
@@ -464,12 +958,14 @@ Video::TwoDimensional::ImageCountedPtr Data::ResourceManager::getImage(
 
   map<Ceylan::ResourceID,
 	  pair< Video::TwoDimensional::ImageCountedPtr, bool > >::iterator it =
-	_imageMap.find( getIDForPath(imagePath) ) ;
+	_imageMap.find( resolveResource( getIDForPath(imagePath) ) ) ;
 
   if ( it == _imageMap.end() )
 	throw ResourceManagerException( "ResourceManager::getImage: image '"
 	  + imagePath + "' could not be found." ) ;
 
+  Ceylan::ResourceID id = (*it).first ;
+
   pair<Video::TwoDimensional::ImageCountedPtr,bool> targetResPair
 	= (*it).second ;
 
@@ -499,7 +995,6 @@ Video::TwoDimensional::ImageCountedPtr Data::ResourceManager::getImage(
 
 	  // Swaps previous and new entries (not at the same place, though):
 	  _imageMap.erase( it ) ;
-	  Ceylan::ResourceID id = (*it).first ;
 	  _imageMap.insert( std::make_pair( id, newResPair ) ) ;
 
 	}
@@ -507,8 +1002,18 @@ Video::TwoDimensional::ImageCountedPtr Data::ResourceManager::getImage(
 
   }
 
+  // A prefetched image may just be waiting for its installation:
+  completeImagePrefetch( id ) ;
+
   // Ensures a returned resource is always loaded:
-  res->load() ;
+  Ceylan::System::Microsecond loadDuration ;
+
+  bool hit = ! LoadMeasured( res, loadDuration ) ;
+
+  if ( ! hit )
+	recordLatency( id, loadDuration ) ;
+
+  recordAccess( id, hit ) ;
 
   return res ;
 
@@ -522,6 +1027,9 @@ Video::OpenGL::TextureCountedPtr Data::ResourceManager::getTexture(
 
   send( "Getting texture whose ID is " + Ceylan::toString( id ) ) ;
 
+  // Resources of identical contents share a single instance:
+  id = resolveResource( id ) ;
+
   map<Ceylan::ResourceID,
 	  pair< Video::OpenGL::TextureCountedPtr, bool > >::iterator it =
 	_textureMap.find( id ) ;
@@ -539,8 +1047,18 @@ Video::OpenGL::TextureCountedPtr Data::ResourceManager::getTexture(
 
   Video::OpenGL::TextureCountedPtr res = ((*it).second).first ;
 
+  // A prefetched texture may just be waiting for its installation:
+  completeImagePrefetch( id ) ;
+
   // Ensures a returned resource is always loaded:
-  res->load() ;
+  Ceylan::System::Microsecond loadDuration ;
+
+  bool hit = ! LoadMeasured( res, loadDuration ) ;
+
+  if ( ! hit )
+	recordLatency( id, loadDuration ) ;
+
+  recordAccess( id, hit ) ;
 
   // Maybe wanting to have it uploaded directly to the video card?
   if ( uploadWanted && ( ! res->wasUploaded() ) )
@@ -560,7 +1078,7 @@ Video::OpenGL::TextureCountedPtr Data::ResourceManager::getTexture(
 
   map<Ceylan::ResourceID,
 	  pair< Video::OpenGL::TextureCountedPtr, bool > >::iterator it =
-	_textureMap.find( getIDForPath(texturePath) ) ;
+	_textureMap.find( resolveResource( getIDForPath(texturePath) ) ) ;
 
   if ( it == _textureMap.end() )
   {
@@ -573,6 +1091,8 @@ Video::OpenGL::TextureCountedPtr Data::ResourceManager::getTexture(
 
   }
 
+  Ceylan::ResourceID id = (*it).first ;
+
   pair<Video::OpenGL::TextureCountedPtr,bool> targetResPair = (*it).second ;
   Video::OpenGL::TextureCountedPtr res = targetResPair.first ;
 
@@ -601,7 +1121,6 @@ Video::OpenGL::TextureCountedPtr Data::ResourceManager::getTexture(
 
 	  // Swaps previous and new entries (not at the same place, though):
 	  _textureMap.erase( it ) ;
-	  Ceylan::ResourceID id = (*it).first ;
 	  _textureMap.insert( std::make_pair( id, newResPair ) ) ;
 
 	}
@@ -609,8 +1128,18 @@ Video::OpenGL::TextureCountedPtr Data::ResourceManager::getTexture(
 
   }
 
+  // A prefetched texture may just be waiting for its installation:
+  completeImagePrefetch( id ) ;
+
   // Ensures a returned resource is always loaded:
-  res->load() ;
+  Ceylan::System::Microsecond loadDuration ;
+
+  bool hit = ! LoadMeasured( res, loadDuration ) ;
+
+  if ( ! hit )
+	recordLatency( id, loadDuration ) ;
+
+  recordAccess( id, hit ) ;
 
   // Maybe wanting to have it uploaded directly to the video card?
   if ( uploadWanted && ( ! res->wasUploaded() ) )
@@ -648,6 +1177,9 @@ Data::ResourceManager::getTextureFrom(
 	pair<Video::OpenGL::TextureCountedPtr,bool> >(
 	  resID, std::make_pair( resPtr, /* purgeable */ false ) ) ) ;
 
+  // No file to load it back from, hence never to be evicted:
+  _pinned.insert( resID ) ;
+
   return std::pair<Video::OpenGL::TextureCountedPtr,Ceylan::ResourceID>(
 	resPtr, resID ) ;
 
@@ -662,6 +1194,9 @@ Data::ResourceManager::getTrueTypeFont( Ceylan::ResourceID id,
 
   send( "Getting TrueTypeFont whose ID is " + Ceylan::toString( id ) ) ;
 
+  // Fonts are not shared, yet may have to be created from the index:
+  id = resolveResource( id ) ;
+
   map<ResourceID, pair< Text::TrueTypeFontCountedPtr, bool > >::iterator it =
 	_truetypeFontMap.find( id ) ;
 
@@ -706,7 +1241,7 @@ Data::ResourceManager::getTrueTypeFont( Ceylan::ResourceID id,
   }
 
   // Ensures a returned resource is always loaded:
-  res->load( pointSize ) ;
+  loadFont( id, res, pointSize ) ;
 
   return res ;
 
@@ -722,12 +1257,14 @@ Data::ResourceManager::getTrueTypeFont( const string & fontPath,
   send( "Getting TrueTypeFont whose path is '" + fontPath + "'" ) ;
 
   map<ResourceID, pair< Text::TrueTypeFontCountedPtr, bool > >::iterator it =
-	_truetypeFontMap.find( getIDForPath(fontPath) ) ;
+	_truetypeFontMap.find( resolveResource( getIDForPath(fontPath) ) ) ;
 
   if ( it == _truetypeFontMap.end() )
 	throw ResourceManagerException( "ResourceManager::getTrueTypeFont: "
 	  "font '" + fontPath + "' could not be found." ) ;
 
+  Ceylan::ResourceID id = (*it).first ;
+
   pair<Text::TrueTypeFontCountedPtr,bool> targetResPair = (*it).second ;
   Video::TwoDimensional::Text::TrueTypeFontCountedPtr res =
 	targetResPair.first ;
@@ -757,8 +1294,6 @@ Data::ResourceManager::getTrueTypeFont( const string & fontPath,
 
 	  // Swaps previous and new entries (not at the same place, though):
 	  _truetypeFontMap.erase( it ) ;
-
-	  Ceylan::ResourceID id = (*it).first ;
 	  _truetypeFontMap.insert( std::make_pair( id, newResPair ) ) ;
 
 	}
@@ -767,7 +1302,7 @@ Data::ResourceManager::getTrueTypeFont( const string & fontPath,
   }
 
   // Ensures a returned resource is always loaded:
-  res->load( pointSize ) ;
+  loadFont( id, res, pointSize ) ;
 
   return res ;
 
@@ -775,987 +1310,2651 @@ Data::ResourceManager::getTrueTypeFont( const string & fontPath,
 
 
 
-void Data::ResourceManager::discardTexture( Ceylan::ResourceID textureId )
+Ceylan::Uint32 Data::ResourceManager::registerImageAtlas(
+  const string & indexPath, bool convertToDisplayFormat, bool acceptTrimmed )
 {
 
-  send( "Discarding texture whose ID is " + Ceylan::toString( textureId ) ) ;
+  send( "Registering image atlas '" + indexPath + "'." ) ;
 
-  map< Ceylan::ResourceID, pair<Video::OpenGL::TextureCountedPtr,bool> >::
-	iterator it = _textureMap.find( textureId ) ;
+  Video::TwoDimensional::ImageAtlasCountedPtr atlas ;
 
-  if ( it == _textureMap.end() )
-	throw ResourceManagerException( "ResourceManager::discardTexture: "
-	  "no texture with ID #" + Ceylan::toString( textureId )
-	  + " found." ) ;
+  try
+  {
 
-  /*
-   * Ensures the texture is removed from video card and deleted (regardless of
-   * purgeable status):
-   *
-   */
-  _textureMap.erase( it ) ;
+	atlas = new Video::TwoDimensional::ImageAtlas( indexPath,
+	  convertToDisplayFormat ) ;
 
-}
+  }
+  catch( const Video::TwoDimensional::ImageException & e )
+  {
 
+	throw ResourceManagerException( "ResourceManager::registerImageAtlas "
+	  "failed: " + e.toString() ) ;
 
+  }
 
-void Data::ResourceManager::tidy()
-{
+  Ceylan::Uint32 entryCount = atlas->getEntryCount() ;
 
-  /*
-   * Unloads content from all entries which are referenced only by this manager
-   * and are marked as purgeable:
-   */
+  Ceylan::Uint32 registeredCount = 0 ;
 
-  for ( map< Ceylan::ResourceID, pair<Audio::MusicCountedPtr,bool> >::iterator
-		  it = _musicMap.begin(); it != _musicMap.end(); it++ )
+  for ( Ceylan::Uint32 i = 0; i < entryCount; i++ )
   {
 
-	Audio::MusicCountedPtr resPtr = ((*it).second).first ;
-	bool purgeable = ((*it).second).second ;
+	const Video::TwoDimensional::AtlasEntry & entry = atlas->getEntry( i ) ;
 
-	if ( ( resPtr.getReferenceCount() == 1 ) && purgeable )
-	  resPtr->unload() ;
+	const string & imagePath = entry.name ;
 
-  }
+	// A trimmed view would not have the dimensions of the original image:
+	if ( ! acceptTrimmed && ( entry.width != entry.originalWidth
+		|| entry.height != entry.originalHeight ) )
+	{
 
+	  send( "Image '" + imagePath + "' is trimmed in atlas '" + indexPath
+		+ "', thus not registered from it." ) ;
 
-  for ( map< Ceylan::ResourceID, pair<Audio::SoundCountedPtr,bool> >::iterator
-		  it = _soundMap.begin(); it != _soundMap.end(); it++ )
-  {
+	  continue ;
 
-	Audio::SoundCountedPtr resPtr = ((*it).second).first ;
-	bool purgeable = ((*it).second).second ;
+	}
 
-	if ( ( resPtr.getReferenceCount() == 1 ) && purgeable )
-	  resPtr->unload() ;
+	Video::TwoDimensional::ImageCountedPtr packedImagePtr =
+	  new Video::TwoDimensional::AtlasImage( atlas, i ) ;
 
-  }
+	Ceylan::ResourceID id ;
 
+	if ( findIDForPath( imagePath, id ) )
+	{
 
-  for ( map< Ceylan::ResourceID,
-		  pair<Video::TwoDimensional::ImageCountedPtr,bool> >::iterator it =
-		  _imageMap.begin(); it != _imageMap.end(); it++ )
-  {
+	  // The packed image supersedes the standalone one:
+	  discountSize( id ) ;
+	  _imageMap.erase( id ) ;
 
-	Video::TwoDimensional::ImageCountedPtr resPtr = ((*it).second).first ;
-	bool purgeable = ((*it).second).second ;
+	}
+	else
+	{
 
-	if ( ( resPtr.getReferenceCount() == 1 ) && purgeable )
-	  resPtr->unload() ;
+	  _maxID++ ;
+	  id = _maxID ;
+
+	  _reverseMap.insert( std::pair<std::string,Ceylan::ResourceID>(
+		  imagePath, id ) ) ;
+
+	}
+
+	_imageMap.insert( std::pair<Ceylan::ResourceID,
+	  std::pair< Video::TwoDimensional::ImageCountedPtr, bool > >(
+		id, std::make_pair( packedImagePtr, /* purgeable */ false ) ) ) ;
+
+	registeredCount++ ;
 
   }
 
+  _atlases.push_back( atlas ) ;
 
-  for ( map< Ceylan::ResourceID,
-		  pair<Video::OpenGL::TextureCountedPtr,bool> >::iterator it =
-		  _textureMap.begin(); it != _textureMap.end(); it++ )
-  {
+  return registeredCount ;
 
-	Video::OpenGL::TextureCountedPtr resPtr = ((*it).second).first ;
-	bool purgeable = ((*it).second).second ;
+}
 
-	if ( ( resPtr.getReferenceCount() == 1 ) && purgeable )
-	  resPtr->unload() ;
 
-  }
+Ceylan::Uint32 Data::ResourceManager::prefetch( const list<ResourceID> & ids )
+{
 
+  Ceylan::Uint32 count = 0 ;
 
-  for ( map< Ceylan::ResourceID,
-	  pair<Video::TwoDimensional::Text::TrueTypeFontCountedPtr,bool> >::iterator
-	  it = _truetypeFontMap.begin(); it != _truetypeFontMap.end(); it++ )
+  for ( list<ResourceID>::const_iterator it = ids.begin();
+		it != ids.end(); it++ )
   {
 
-	Video::TwoDimensional::Text::TrueTypeFontCountedPtr resPtr
-	  = ((*it).second).first ;
-	bool purgeable = ((*it).second).second ;
+	ResourceID id = resolveResource( *it ) ;
 
-	if ( ( resPtr.getReferenceCount() == 1 ) && purgeable )
-	  resPtr->unload() ;
+	// Throws if the identifier is not known at all:
+	if ( isReady( id ) || isPrefetching( id ) )
+	  continue ;
 
-  }
+	count++ ;
 
-  /*
-	Ceylan::checkpoint( "ResourceManager is now tidied, new state: " ) ;
-	displayLoadedResources() ;
-  */
+	map< ResourceID, pair<Video::TwoDimensional::ImageCountedPtr,bool> >::
+	  const_iterator imageIt = _imageMap.find( id ) ;
 
-}
+	bool isTexture = ( _textureMap.find( id ) != _textureMap.end() ) ;
 
+	if ( imageIt != _imageMap.end() || isTexture )
+	{
 
+	  Video::TwoDimensional::AsyncImageLoader * loader = getPrefetchLoader() ;
 
-void Data::ResourceManager::purge()
-{
+	  // Packed images are views on their atlas page, not files to decode:
+	  if ( loader == 0 || ( imageIt != _imageMap.end()
+		  && dynamic_cast<Video::TwoDimensional::AtlasImage *>(
+			& (*(*imageIt).second.first) ) != 0 ) )
+	  {
 
-  // Unloads everything which is not referenced by anyone else:
+		_mainThreadPrefetches.push_back( id ) ;
+		continue ;
 
-  for ( map< Ceylan::ResourceID, pair<Audio::MusicCountedPtr,bool> >::iterator
-		  it = _musicMap.begin(); it != _musicMap.end(); it++ )
-  {
+	  }
 
-	Audio::MusicCountedPtr resPtr = ((*it).second).first ;
+	  string imagePath ;
+	  findPathFor( id, imagePath ) ;
 
-	if ( resPtr.getReferenceCount() == 1 )
-	  resPtr->unload() ;
+	  Video::TwoDimensional::AsyncImageLoader::Handle handle ;
 
-  }
+	  try
+	  {
 
+		// Textures are decoded directly to their internal format:
+		if ( isTexture )
+		  handle = loader->requestLoad( imagePath, getTextureFormat() ) ;
+		else
+		  handle = loader->requestLoad( imagePath ) ;
 
-  for ( map< Ceylan::ResourceID, pair<Audio::SoundCountedPtr,bool> >::iterator
-		  it = _soundMap.begin(); it != _soundMap.end(); it++ )
-  {
+	  }
+	  catch( const Video::TwoDimensional::ImageException & e )
+	  {
 
-	Audio::SoundCountedPtr resPtr = ((*it).second).first ;
+		throw ResourceManagerException( "ResourceManager::prefetch failed "
+		  "for image #" + Ceylan::toString( id ) + ": " + e.toString() ) ;
 
-	if ( resPtr.getReferenceCount() == 1 )
-	  resPtr->unload() ;
+	  }
 
-  }
+	  _imagePrefetches[ handle ] = id ;
+	  _imagePrefetchHandles[ id ] = handle ;
 
+	  continue ;
 
-  for ( map< Ceylan::ResourceID,
-		  pair<Video::TwoDimensional::ImageCountedPtr,bool> >::iterator it =
-		  _imageMap.begin(); it != _imageMap.end(); it++ )
-  {
+	}
 
-	Video::TwoDimensional::ImageCountedPtr resPtr = ((*it).second).first ;
+	bool isSound = ( _soundMap.find( id ) != _soundMap.end() ) ;
 
-	if ( resPtr.getReferenceCount() == 1 )
-	  resPtr->unload() ;
+#if ! OSDL_PREFETCHES_AUDIO_IN_BACKGROUND
 
-  }
+	// Fonts only need their file to be read:
+	if ( _truetypeFontMap.find( id ) == _truetypeFontMap.end() )
+	{
 
+	  _mainThreadPrefetches.push_back( id ) ;
+	  continue ;
 
-  for ( map< Ceylan::ResourceID,
-		  pair<Video::OpenGL::TextureCountedPtr,bool> >::iterator it =
-		  _textureMap.begin(); it != _textureMap.end(); it++ )
-  {
+	}
 
-	Video::OpenGL::TextureCountedPtr resPtr = ((*it).second).first ;
+#endif // OSDL_PREFETCHES_AUDIO_IN_BACKGROUND
 
-	if ( resPtr.getReferenceCount() == 1 )
-	  resPtr->unload() ;
+	string resourcePath ;
+	findPathFor( id, resourcePath ) ;
 
-  }
+	ResourcePrefetchJob * job = new ResourcePrefetchJob( resourcePath,
+	  /* decodeAsSound */ isSound ) ;
 
+	try
+	{
 
-  for ( map< Ceylan::ResourceID,
-		  pair<Video::TwoDimensional::Text::TrueTypeFontCountedPtr,bool> >::iterator
-		  it = _truetypeFontMap.begin(); it != _truetypeFontMap.end(); it++ )
-  {
+	  getPrefetchPool().submit( *job ) ;
 
-	Video::TwoDimensional::Text::TrueTypeFontCountedPtr resPtr
-	  = ((*it).second).first ;
+	}
+	catch( const WorkerPoolException & e )
+	{
 
-	if ( resPtr.getReferenceCount() == 1 )
-	  resPtr->unload() ;
+	  delete job ;
+
+	  throw ResourceManagerException( "ResourceManager::prefetch failed "
+		"for resource #" + Ceylan::toString( id ) + ": " + e.toString() ) ;
+
+	}
+
+	_resourcePrefetches[ id ] = job ;
 
   }
 
-  /*
-	Ceylan::checkpoint( "ResourceManager is now purged, new state: " ) ;
-	displayLoadedResources() ;
-  */
+  return count ;
 
 }
 
 
 
-void Data::ResourceManager::displayLoadedResources()
+Ceylan::Uint32 Data::ResourceManager::prefetch( const list<string> & paths )
 {
 
-  Ceylan::VerbosityLevels level = Ceylan::high ;
-
-  list<string> loadedList ;
-
-  for ( map<Ceylan::ResourceID,
-		  pair< Audio::MusicCountedPtr, bool> >::const_iterator it =
-		  _musicMap.begin(); it != _musicMap.end(); it++ )
-  {
+  list<ResourceID> ids ;
 
-	Audio::MusicCountedPtr ptr = ((*it).second).first ;
-	if ( ptr->hasContent() )
-	{
+  for ( list<string>::const_iterator it = paths.begin();
+		it != paths.end(); it++ )
+	ids.push_back( getIDForPath( *it, /* emergencyStopInNotFound */ false ) ) ;
 
-	  bool purgeable = ((*it).second).second ;
+  return prefetch( ids ) ;
 
-	  string purgeText ;
+}
 
-	  if ( purgeable )
-		purgeText = "marked as purgeable" ;
-	  else
-		purgeText = "not marked as purgeable" ;
 
-	  loadedList.push_back( "ID #" + Ceylan::toString( (*it).first )
-		+ ": " + ptr->toString(level)
-		+ ", a resource which is " + purgeText
-		+ " and whose reference count is "
-		+ Ceylan::toString( ptr.getReferenceCount() ) ) ;
 
-	}
+Ceylan::Uint32 Data::ResourceManager::prefetchGroup( const string & groupName )
+{
 
-  }
+  map<string, list<ResourceID> >::const_iterator it =
+	_groups.find( groupName ) ;
 
+  if ( it == _groups.end() )
+	throw ResourceManagerException( "ResourceManager::prefetchGroup failed: "
+	  "no group named '" + groupName + "' in the resource map." ) ;
 
-  for ( map<Ceylan::ResourceID,
-		  pair< Audio::SoundCountedPtr, bool> >::const_iterator it =
-		  _soundMap.begin(); it != _soundMap.end(); it++ )
-  {
+  send( "Prefetching the " + Ceylan::toString( (*it).second.size() )
+	+ " resource(s) of group '" + groupName + "'." ) ;
 
-	Audio::SoundCountedPtr ptr = ((*it).second).first ;
-	if ( ptr->hasContent() )
-	{
+  return prefetch( (*it).second ) ;
 
-	  bool purgeable = ((*it).second).second ;
+}
 
-	  string purgeText ;
 
-	  if ( purgeable )
-		purgeText = "marked as purgeable" ;
-	  else
-		purgeText = "not marked as purgeable" ;
 
+Ceylan::Uint32 Data::ResourceManager::deliverPrefetched(
+  Ceylan::Uint32 maxCount )
+{
 
-	  loadedList.push_back( "ID #" + Ceylan::toString( (*it).first )
-		+ ": " + ptr->toString(level)
-		+ ", a resource which is " + purgeText
-		+ " and whose reference count is "
-		+ Ceylan::toString( ptr.getReferenceCount() ) ) ;
+  Ceylan::Uint32 count = deliverPrefetchedImages( maxCount ) ;
 
-	}
+  if ( maxCount == 0 || count < maxCount )
+	count += deliverPrefetchedResources(
+	  ( maxCount == 0 ) ? 0 : maxCount - count ) ;
 
-  }
+  while ( ! _mainThreadPrefetches.empty()
+	  && ( maxCount == 0 || count < maxCount ) )
+  {
 
+	ResourceID id = _mainThreadPrefetches.front() ;
+	_mainThreadPrefetches.pop_front() ;
 
-  for ( map<Ceylan::ResourceID,
-		  pair< Video::TwoDimensional::ImageCountedPtr, bool> >::const_iterator
-		  it = _imageMap.begin(); it != _imageMap.end(); it++ )
-  {
+	Microsecond loadDuration ;
+	bool loaded = false ;
 
-	Video::TwoDimensional::ImageCountedPtr ptr = ((*it).second).first ;
-	if ( ptr->hasContent() )
+	try
 	{
 
-	  bool purgeable = ((*it).second).second ;
+	  map< ResourceID, pair<Video::TwoDimensional::ImageCountedPtr,bool> >::
+		iterator imageIt = _imageMap.find( id ) ;
 
-	  string purgeText ;
+	  if ( imageIt != _imageMap.end() )
+	  {
 
-	  if ( purgeable )
-		purgeText = "marked as purgeable" ;
-	  else
-		purgeText = "not marked as purgeable" ;
+		loaded = LoadMeasured( (*imageIt).second.first, loadDuration ) ;
 
+	  }
+	  else
+	  {
 
-	  loadedList.push_back( "ID #" + Ceylan::toString( (*it).first )
-		+ ": " + ptr->toString(level)
-		+ ", a resource which is " + purgeText
-		+ " and whose reference count is "
-		+ Ceylan::toString( ptr.getReferenceCount() ) ) ;
+		map< ResourceID, pair<Audio::SoundCountedPtr,bool> >::iterator
+		  soundIt = _soundMap.find( id ) ;
 
-	}
+		map< ResourceID, pair<Audio::MusicCountedPtr,bool> >::iterator
+		  musicIt = _musicMap.find( id ) ;
 
-  }
+		map< ResourceID, pair<Video::OpenGL::TextureCountedPtr,bool> >::
+		  iterator textureIt = _textureMap.find( id ) ;
 
+		if ( soundIt != _soundMap.end() )
+		  loaded = LoadMeasured( (*soundIt).second.first, loadDuration ) ;
+		else if ( musicIt != _musicMap.end() )
+		  loaded = LoadMeasured( (*musicIt).second.first, loadDuration ) ;
+		else if ( textureIt != _textureMap.end() )
+		  loaded = LoadMeasured( (*textureIt).second.first, loadDuration ) ;
 
-  for ( map<Ceylan::ResourceID,
-		  pair< Video::OpenGL::TextureCountedPtr, bool> >::const_iterator it =
-		  _textureMap.begin(); it != _textureMap.end(); it++ )
-  {
+	  }
 
-	Video::OpenGL::TextureCountedPtr ptr = ((*it).second).first ;
-	if ( ptr->hasContent() )
+	}
+	catch( const Ceylan::Exception & e )
 	{
 
-	  bool purgeable = ((*it).second).second ;
-
-	  string purgeText ;
+	  // The getter will try again, and report the failure then:
+	  LogPlug::warning( "ResourceManager::deliverPrefetched: "
+		"prefetching of resource #" + Ceylan::toString( id )
+		+ " failed: " + e.toString() ) ;
 
-	  if ( purgeable )
-		purgeText = "marked as purgeable" ;
-	  else
-		purgeText = "not marked as purgeable" ;
+	}
 
+	if ( loaded )
+	{
 
-	  loadedList.push_back( "ID #" + Ceylan::toString( (*it).first )
-		+ ": " + ptr->toString(level)
-		+ ", a resource which is " + purgeText
-		+ " and whose reference count is "
-		+ Ceylan::toString( ptr.getReferenceCount() ) ) ;
+	  recordLatency( id, loadDuration ) ;
+	  trackLoaded( id ) ;
+	  count++ ;
 
 	}
 
   }
 
+  if ( count != 0 )
+	enforceMemoryBudget() ;
 
-  for ( map<Ceylan::ResourceID,
-		  pair< Text::TrueTypeFontCountedPtr, bool> >::const_iterator it =
-		  _truetypeFontMap.begin(); it != _truetypeFontMap.end(); it++ )
-  {
+  return count ;
 
-	Text::TrueTypeFontCountedPtr ptr = ((*it).second).first ;
-	if ( ptr->hasContent() )
-	{
+}
 
-	  bool purgeable = ((*it).second).second ;
 
-	  string purgeText ;
 
-	  if ( purgeable )
-		purgeText = "marked as purgeable" ;
-	  else
-		purgeText = "not marked as purgeable" ;
-
-	  loadedList.push_back( "ID #" + Ceylan::toString( (*it).first )
-		+ ": " + ptr->toString(level)
-		+ ", a resource which is " + purgeText
-		+ " and whose reference count is "
-		+ Ceylan::toString( ptr.getReferenceCount() ) ) ;
+bool Data::ResourceManager::waitForPrefetched( Ceylan::Uint32 timeout )
+{
 
-	}
+  // The pool is not shared, thus all its jobs are prefetches:
+  if ( _prefetchPool != 0 )
+	_prefetchPool->waitForAll( timeout ) ;
 
+  deliverPrefetched( /* maxCount */ 0 ) ;
 
-	if ( loadedList.empty() )
-	{
+  return ( getPrefetchingCount() == 0 ) ;
 
-	  Ceylan::checkpoint( "Resource manager: no resource loaded." ) ;
+}
 
-	}
-	else
-	{
 
-	  Ceylan::checkpoint( "Resource manager: "
-		+ Ceylan::formatStringList( loadedList,
-		  TextDisplayable::rawText ) ) ;
 
-	}
+Ceylan::Uint32 Data::ResourceManager::getPrefetchingCount() const
+{
 
-  }
+  return static_cast<Ceylan::Uint32>( _imagePrefetches.size()
+	+ _resourcePrefetches.size() + _mainThreadPrefetches.size() ) ;
 
 }
 
 
-const string Data::ResourceManager::toString(
-  Ceylan::VerbosityLevels level ) const
+
+bool Data::ResourceManager::isReady( ResourceID id ) const
 {
 
-  list<string> maps ;
+  id = getContentOwner( id ) ;
 
-  Ceylan::Uint32 size = _musicMap.size() ;
+  map< ResourceID, pair<Audio::MusicCountedPtr,bool> >::const_iterator
+	musicIt = _musicMap.find( id ) ;
 
-  string temp ;
+  if ( musicIt != _musicMap.end() )
+	return (*musicIt).second.first->hasContent() ;
 
-  if ( size != 0 )
-  {
+  map< ResourceID, pair<Audio::SoundCountedPtr,bool> >::const_iterator
+	soundIt = _soundMap.find( id ) ;
 
-	temp = "Number of musics managed: " + Ceylan::toString( size ) ;
+  if ( soundIt != _soundMap.end() )
+	return (*soundIt).second.first->hasContent() ;
 
-	if ( level != Ceylan::low )
-	{
+  map< ResourceID, pair<Video::TwoDimensional::ImageCountedPtr,bool> >::
+	const_iterator imageIt = _imageMap.find( id ) ;
 
-	  list<string> musics ;
+  if ( imageIt != _imageMap.end() )
+	return (*imageIt).second.first->hasContent() ;
 
-	  for ( map<Ceylan::ResourceID,
-			  pair< Audio::MusicCountedPtr, bool > >::const_iterator it
-			  = _musicMap.begin(); it != _musicMap.end(); it++ )
-	  {
+  map< ResourceID, pair<Video::OpenGL::TextureCountedPtr,bool> >::
+	const_iterator textureIt = _textureMap.find( id ) ;
 
-		Audio::MusicCountedPtr ptr = ((*it).second).first ;
+  if ( textureIt != _textureMap.end() )
+	return (*textureIt).second.first->hasContent() ;
 
-		bool purgeable = ((*it).second).second ;
+  map< ResourceID,
+	pair<Video::TwoDimensional::Text::TrueTypeFontCountedPtr,bool> >::
+	const_iterator fontIt = _truetypeFontMap.find( id ) ;
 
-		string purgeText ;
+  if ( fontIt != _truetypeFontMap.end() )
+	return (*fontIt).second.first->hasContent() ;
 
-		if ( purgeable )
-		  purgeText = "marked as purgeable" ;
-		else
-		  purgeText = "not marked as purgeable" ;
+  ResourceIndex::Entry entry ;
 
-		musics.push_back( ptr->toString(level)
-		  + " (ID #" + Ceylan::toString( (*it).first )
-		  + ", which is " + purgeText
-		  + " and whose reference count is "
-		  + Ceylan::toString( ptr.getReferenceCount() )
-		  + ")" ) ;
+  // Listed in the index, yet not used so far:
+  if ( _index != 0 && _index->findEntryFor( id, entry ) )
+	return false ;
 
-	  }
+  throw ResourceManagerException( "ResourceManager::isReady: ID #"
+	+ Ceylan::toString( id ) + " could not be found." ) ;
 
-	  temp += Ceylan::formatStringList( musics,
-		/* surroundByTicks */ false, /* indentationLevel */ 2 ) ;
+}
 
-	}
 
 
-	maps.push_back( temp ) ;
+bool Data::ResourceManager::getLoadLatency( ResourceID id,
+  LoadLatency & latency ) const
+{
 
-  }
-  else
-  {
+  map<ResourceID, LoadLatency>::const_iterator it = _latencies.find(
+	getContentOwner( id ) ) ;
 
-	maps.push_back( "No music is managed" ) ;
+  if ( it == _latencies.end() )
+	return false ;
 
-  }
+  latency = (*it).second ;
 
+  return true ;
 
-  size = _soundMap.size() ;
+}
 
-  if ( size != 0 )
-  {
 
-	temp = "Number of sounds managed: " + Ceylan::toString( size ) ;
 
-	if ( level != Ceylan::low )
-	{
+void Data::ResourceManager::setMemoryBudget( Ceylan::System::Size budget )
+{
 
-	  list<string> sounds ;
+  _memoryBudget = budget ;
 
-	  for ( map<Ceylan::ResourceID,
-			  pair<  Audio::SoundCountedPtr, bool> >::const_iterator it =
-			  _soundMap.begin(); it != _soundMap.end(); it++ )
-	  {
+  enforceMemoryBudget() ;
 
-		Audio::SoundCountedPtr ptr = ((*it).second).first ;
+}
 
-		bool purgeable = ((*it).second).second ;
 
-		string purgeText ;
 
-		if ( purgeable )
-		  purgeText = "marked as purgeable" ;
-		else
-		  purgeText = "not marked as purgeable" ;
+Ceylan::System::Size Data::ResourceManager::getMemoryBudget() const
+{
 
-		sounds.push_back( ptr->toString(level)
-		  + " (ID #" + Ceylan::toString( (*it).first )
-		  + ", which is " + purgeText
-		  + " and whose reference count is "
-		  + Ceylan::toString( ptr.getReferenceCount() )
-		  + ")" ) ;
+  return _memoryBudget ;
 
-	  }
+}
 
-	  temp += Ceylan::formatStringList( sounds,
-		/* surroundByTicks */ false, /* indentationLevel */ 2 ) ;
 
-	}
 
+Ceylan::System::Size Data::ResourceManager::getMemoryFootprint() const
+{
 
-	maps.push_back( temp ) ;
+  // Maintained on each load and unload, rather than walking all resources:
+  return _statistics.musicBytes + _statistics.soundBytes
+	+ _statistics.imageBytes + _statistics.textureBytes
+	+ _statistics.fontBytes ;
 
-  }
-  else
-  {
+}
 
-	maps.push_back( "No sound is managed" ) ;
 
-  }
 
+Ceylan::Uint32 Data::ResourceManager::enforceMemoryBudget()
+{
+
+  if ( _memoryBudget == 0 )
+	return 0 ;
 
-  size = _imageMap.size() ;
+  Ceylan::Uint32 evictedCount = 0 ;
 
-  if ( size != 0 )
+  /*
+   * Two full turns of the hand clear all reference bits, then a resource
+   * is evicted unless none can be:
+   *
+   */
+  Ceylan::Uint32 idleSteps = 0 ;
+
+  while ( getMemoryFootprint() > _memoryBudget && ! _clock.empty()
+	  && idleSteps < 2 * _clock.size() )
   {
 
-	temp = "Number of images managed: " + Ceylan::toString( size ) ;
+	if ( _clockHand == _clock.end() )
+	  _clockHand = _clock.begin() ;
 
-	if ( level != Ceylan::low )
+	ResourceID id = *_clockHand ;
+
+	Ceylan::System::Size size ;
+	Ceylan::Uint32 referenceCount ;
+	ContentType type ;
+
+	if ( ! getLoadedState( id, size, referenceCount, type ) )
 	{
 
-	  list<string> images ;
+	  // Unloaded or removed meanwhile (ex: by tidy, purge or a user):
+	  discountSize( id ) ;
+	  _clockReferences.erase( id ) ;
+	  _clockHand = _clock.erase( _clockHand ) ;
+	  continue ;
 
-	  for ( map<Ceylan::ResourceID,
-		pair< Video::TwoDimensional::ImageCountedPtr, bool> >::const_iterator it
-			  = _imageMap.begin(); it != _imageMap.end(); it++ )
-	  {
+	}
 
-		Video::TwoDimensional::ImageCountedPtr ptr = ((*it).second).first ;
+	// Font caches, notably, grow after their loading:
+	accountSize( id ) ;
 
-		bool purgeable = ((*it).second).second ;
+	bool & referenced = _clockReferences[ id ] ;
 
-		string purgeText ;
+	if ( referenceCount > 1 || size == 0
+		|| _pinned.find( id ) != _pinned.end() )
+	{
 
-		if ( purgeable )
-		  purgeText = "marked as purgeable" ;
-		else
-		  purgeText = "not marked as purgeable" ;
+	  // In use, pinned, or not worth it:
+	  _clockHand++ ;
+	  idleSteps++ ;
+	  continue ;
 
-		images.push_back( ptr->toString(level)
-		  + " (ID #" + Ceylan::toString( (*it).first )
-		  + ", which is " + purgeText
-		  + " and whose reference count is "
-		  + Ceylan::toString( ptr.getReferenceCount() )
-		  + ")" ) ;
+	}
 
-	  }
+	if ( referenced )
+	{
 
-	  temp += Ceylan::formatStringList( images,
-		/* surroundByTicks */ false, /* indentationLevel */ 2 ) ;
+	  // Second chance:
+	  referenced = false ;
+	  _clockHand++ ;
+	  idleSteps++ ;
+	  continue ;
 
 	}
 
+	OSDL_DATA_LOG( "Evicting resource #" + Ceylan::toString( id )
+	  + ", of " + Ceylan::toString( size ) + " bytes." ) ;
 
-	maps.push_back( temp ) ;
+	unloadResource( id ) ;
 
-  }
-  else
-  {
+	evictedCount++ ;
+	_statistics.evictions++ ;
+	idleSteps = 0 ;
 
-	maps.push_back( "No image is managed" ) ;
+	_clockReferences.erase( id ) ;
+	_clockHand = _clock.erase( _clockHand ) ;
 
   }
 
+  return evictedCount ;
 
-  size = _textureMap.size() ;
+}
 
-  if ( size != 0 )
-  {
 
-	temp = "Number of textures managed: " + Ceylan::toString( size ) ;
 
-	if ( level != Ceylan::low )
-	{
+void Data::ResourceManager::pin( ResourceID id )
+{
 
-	  list<string> textures ;
+  // Throws if the identifier is not known:
+  isReady( id ) ;
 
-	  for ( map<Ceylan::ResourceID,
-			  pair< Video::OpenGL::TextureCountedPtr, bool> >::const_iterator
-			  it = _textureMap.begin(); it != _textureMap.end(); it++ )
-	  {
+  _pinned.insert( resolveResource( id ) ) ;
 
-		Video::OpenGL::TextureCountedPtr ptr = ((*it).second).first ;
+}
 
-		bool purgeable = ((*it).second).second ;
 
-		string purgeText ;
 
-		if ( purgeable )
-		  purgeText = "marked as purgeable" ;
-		else
-		  purgeText = "not marked as purgeable" ;
+void Data::ResourceManager::unpin( ResourceID id )
+{
 
-		textures.push_back( ptr->toString(level)
-		  + " (ID #" + Ceylan::toString( (*it).first )
-		  + ", which is " + purgeText
-		  + " and whose reference count is "
-		  + Ceylan::toString( ptr.getReferenceCount() )
-		  + ")" ) ;
+  // Throws if the identifier is not known:
+  isReady( id ) ;
 
-	  }
+  _pinned.erase( resolveResource( id ) ) ;
 
-	  temp += Ceylan::formatStringList( textures,
-		/* surroundByTicks */ false, /* indentationLevel */ 2 ) ;
+}
 
-	}
 
 
-	maps.push_back( temp ) ;
+bool Data::ResourceManager::isPinned( ResourceID id ) const
+{
 
-  }
-  else
-  {
+  return ( _pinned.find( getContentOwner( id ) ) != _pinned.end() ) ;
 
-	maps.push_back( "No texture is managed" ) ;
+}
 
-  }
 
 
-  size = _truetypeFontMap.size() ;
+Data::ResourceManager::CacheStatistics
+  Data::ResourceManager::getCacheStatistics() const
+{
 
-  if ( size != 0 )
-  {
+  return _statistics ;
 
-	temp = "Number of TrueType font managed: " + Ceylan::toString( size ) ;
+}
 
-	if ( level != Ceylan::low )
-	{
 
-	  list<string> trueTypeFonts ;
 
-	  for ( map<Ceylan::ResourceID,
-			  pair< Text::TrueTypeFontCountedPtr, bool> >::const_iterator it =
-			  _truetypeFontMap.begin(); it != _truetypeFontMap.end();
-			it++ )
-	  {
+void Data::ResourceManager::discardTexture( Ceylan::ResourceID textureId )
+{
 
-		Text::TrueTypeFontCountedPtr ptr = ((*it).second).first ;
+  // Identifiers sharing the content of another one are discarded with it:
+  textureId = getContentOwner( textureId ) ;
 
-		bool purgeable = ((*it).second).second ;
+  send( "Discarding texture whose ID is " + Ceylan::toString( textureId ) ) ;
 
-		string purgeText ;
+  map< Ceylan::ResourceID, pair<Video::OpenGL::TextureCountedPtr,bool> >::
+	iterator it = _textureMap.find( textureId ) ;
 
-		if ( purgeable )
-		  purgeText = "marked as purgeable" ;
-		else
-		  purgeText = "not marked as purgeable" ;
+  if ( it == _textureMap.end() )
+	throw ResourceManagerException( "ResourceManager::discardTexture: "
+	  "no texture with ID #" + Ceylan::toString( textureId )
+	  + " found." ) ;
 
-		trueTypeFonts.push_back( ptr->toString(level)
-		  + " (ID #" + Ceylan::toString( (*it).first )
-		  + ", which is " + purgeText
-		  + " and whose reference count is "
-		  + Ceylan::toString( ptr.getReferenceCount() )
-		  + ")" ) ;
+  /*
+   * Ensures the texture is removed from video card and deleted (regardless of
+   * purgeable status):
+   *
+   */
+  discountSize( textureId ) ;
+  _textureMap.erase( it ) ;
 
-	  }
+}
 
-	  temp += Ceylan::formatStringList( trueTypeFonts,
-		/* surroundByTicks */ false, /* indentationLevel */ 2 ) ;
 
-	}
 
+void Data::ResourceManager::tidy()
+{
 
-	maps.push_back( temp ) ;
+  /*
+   * Unloads content from all entries which are referenced only by this manager
+   * and are marked as purgeable:
+   */
 
-  }
-  else
+  for ( map< Ceylan::ResourceID, pair<Audio::MusicCountedPtr,bool> >::iterator
+		  it = _musicMap.begin(); it != _musicMap.end(); it++ )
   {
 
-	maps.push_back( "No texture is managed" ) ;
+	Audio::MusicCountedPtr resPtr = ((*it).second).first ;
+	bool purgeable = ((*it).second).second ;
 
-  }
+	if ( ( resPtr.getReferenceCount() == 1 ) && purgeable )
+	{
 
+	  resPtr->unload() ;
+	  discountSize( (*it).first ) ;
 
-  size = _reverseMap.size() ;
+	}
+
+  }
+
+
+  for ( map< Ceylan::ResourceID, pair<Audio::SoundCountedPtr,bool> >::iterator
+		  it = _soundMap.begin(); it != _soundMap.end(); it++ )
+  {
+
+	Audio::SoundCountedPtr resPtr = ((*it).second).first ;
+	bool purgeable = ((*it).second).second ;
+
+	if ( ( resPtr.getReferenceCount() == 1 ) && purgeable )
+	{
+
+	  resPtr->unload() ;
+	  discountSize( (*it).first ) ;
+
+	}
+
+  }
+
+
+  for ( map< Ceylan::ResourceID,
+		  pair<Video::TwoDimensional::ImageCountedPtr,bool> >::iterator it =
+		  _imageMap.begin(); it != _imageMap.end(); it++ )
+  {
+
+	Video::TwoDimensional::ImageCountedPtr resPtr = ((*it).second).first ;
+	bool purgeable = ((*it).second).second ;
+
+	if ( ( resPtr.getReferenceCount() == 1 ) && purgeable )
+	{
+
+	  resPtr->unload() ;
+	  discountSize( (*it).first ) ;
+
+	}
+
+  }
+
+
+  for ( map< Ceylan::ResourceID,
+		  pair<Video::OpenGL::TextureCountedPtr,bool> >::iterator it =
+		  _textureMap.begin(); it != _textureMap.end(); it++ )
+  {
+
+	Video::OpenGL::TextureCountedPtr resPtr = ((*it).second).first ;
+	bool purgeable = ((*it).second).second ;
+
+	if ( ( resPtr.getReferenceCount() == 1 ) && purgeable )
+	{
+
+	  resPtr->unload() ;
+	  discountSize( (*it).first ) ;
+
+	}
+
+  }
+
+
+  for ( map< Ceylan::ResourceID,
+	  pair<Video::TwoDimensional::Text::TrueTypeFontCountedPtr,bool> >::iterator
+	  it = _truetypeFontMap.begin(); it != _truetypeFontMap.end(); it++ )
+  {
+
+	Video::TwoDimensional::Text::TrueTypeFontCountedPtr resPtr
+	  = ((*it).second).first ;
+	bool purgeable = ((*it).second).second ;
+
+	if ( ( resPtr.getReferenceCount() == 1 ) && purgeable )
+	{
+
+	  resPtr->unload() ;
+	  discountSize( (*it).first ) ;
+
+	}
+
+  }
+
+  /*
+	Ceylan::checkpoint( "ResourceManager is now tidied, new state: " ) ;
+	displayLoadedResources() ;
+  */
+
+}
+
+
+
+void Data::ResourceManager::purge()
+{
+
+  // Unloads everything which is not referenced by anyone else:
+
+  for ( map< Ceylan::ResourceID, pair<Audio::MusicCountedPtr,bool> >::iterator
+		  it = _musicMap.begin(); it != _musicMap.end(); it++ )
+  {
+
+	Audio::MusicCountedPtr resPtr = ((*it).second).first ;
+
+	if ( resPtr.getReferenceCount() == 1 )
+	{
+
+	  resPtr->unload() ;
+	  discountSize( (*it).first ) ;
+
+	}
+
+  }
+
+
+  for ( map< Ceylan::ResourceID, pair<Audio::SoundCountedPtr,bool> >::iterator
+		  it = _soundMap.begin(); it != _soundMap.end(); it++ )
+  {
+
+	Audio::SoundCountedPtr resPtr = ((*it).second).first ;
+
+	if ( resPtr.getReferenceCount() == 1 )
+	{
+
+	  resPtr->unload() ;
+	  discountSize( (*it).first ) ;
+
+	}
+
+  }
+
+
+  for ( map< Ceylan::ResourceID,
+		  pair<Video::TwoDimensional::ImageCountedPtr,bool> >::iterator it =
+		  _imageMap.begin(); it != _imageMap.end(); it++ )
+  {
+
+	Video::TwoDimensional::ImageCountedPtr resPtr = ((*it).second).first ;
+
+	if ( resPtr.getReferenceCount() == 1 )
+	{
+
+	  resPtr->unload() ;
+	  discountSize( (*it).first ) ;
+
+	}
+
+  }
+
+
+  for ( map< Ceylan::ResourceID,
+		  pair<Video::OpenGL::TextureCountedPtr,bool> >::iterator it =
+		  _textureMap.begin(); it != _textureMap.end(); it++ )
+  {
+
+	Video::OpenGL::TextureCountedPtr resPtr = ((*it).second).first ;
+
+	if ( resPtr.getReferenceCount() == 1 )
+	{
+
+	  resPtr->unload() ;
+	  discountSize( (*it).first ) ;
+
+	}
+
+  }
+
+
+  for ( map< Ceylan::ResourceID,
+		  pair<Video::TwoDimensional::Text::TrueTypeFontCountedPtr,bool> >::iterator
+		  it = _truetypeFontMap.begin(); it != _truetypeFontMap.end(); it++ )
+  {
+
+	Video::TwoDimensional::Text::TrueTypeFontCountedPtr resPtr
+	  = ((*it).second).first ;
+
+	if ( resPtr.getReferenceCount() == 1 )
+	{
+
+	  resPtr->unload() ;
+	  discountSize( (*it).first ) ;
+
+	}
+
+  }
+
+  /*
+	Ceylan::checkpoint( "ResourceManager is now purged, new state: " ) ;
+	displayLoadedResources() ;
+  */
+
+}
+
+
+
+void Data::ResourceManager::displayLoadedResources()
+{
+
+  Ceylan::VerbosityLevels level = Ceylan::high ;
+
+  list<string> loadedList ;
+
+  for ( map<Ceylan::ResourceID,
+		  pair< Audio::MusicCountedPtr, bool> >::const_iterator it =
+		  _musicMap.begin(); it != _musicMap.end(); it++ )
+  {
+
+	Audio::MusicCountedPtr ptr = ((*it).second).first ;
+	if ( ptr->hasContent() )
+	{
+
+	  bool purgeable = ((*it).second).second ;
+
+	  string purgeText ;
+
+	  if ( purgeable )
+		purgeText = "marked as purgeable" ;
+	  else
+		purgeText = "not marked as purgeable" ;
+
+	  loadedList.push_back( "ID #" + Ceylan::toString( (*it).first )
+		+ ": " + ptr->toString(level)
+		+ ", a resource which is " + purgeText
+		+ " and whose reference count is "
+		+ Ceylan::toString( ptr.getReferenceCount() ) ) ;
+
+	}
+
+  }
+
+
+  for ( map<Ceylan::ResourceID,
+		  pair< Audio::SoundCountedPtr, bool> >::const_iterator it =
+		  _soundMap.begin(); it != _soundMap.end(); it++ )
+  {
+
+	Audio::SoundCountedPtr ptr = ((*it).second).first ;
+	if ( ptr->hasContent() )
+	{
+
+	  bool purgeable = ((*it).second).second ;
+
+	  string purgeText ;
+
+	  if ( purgeable )
+		purgeText = "marked as purgeable" ;
+	  else
+		purgeText = "not marked as purgeable" ;
+
+
+	  loadedList.push_back( "ID #" + Ceylan::toString( (*it).first )
+		+ ": " + ptr->toString(level)
+		+ ", a resource which is " + purgeText
+		+ " and whose reference count is "
+		+ Ceylan::toString( ptr.getReferenceCount() ) ) ;
+
+	}
+
+  }
+
+
+  for ( map<Ceylan::ResourceID,
+		  pair< Video::TwoDimensional::ImageCountedPtr, bool> >::const_iterator
+		  it = _imageMap.begin(); it != _imageMap.end(); it++ )
+  {
+
+	Video::TwoDimensional::ImageCountedPtr ptr = ((*it).second).first ;
+	if ( ptr->hasContent() )
+	{
+
+	  bool purgeable = ((*it).second).second ;
+
+	  string purgeText ;
+
+	  if ( purgeable )
+		purgeText = "marked as purgeable" ;
+	  else
+		purgeText = "not marked as purgeable" ;
+
+
+	  loadedList.push_back( "ID #" + Ceylan::toString( (*it).first )
+		+ ": " + ptr->toString(level)
+		+ ", a resource which is " + purgeText
+		+ " and whose reference count is "
+		+ Ceylan::toString( ptr.getReferenceCount() ) ) ;
+
+	}
+
+  }
+
+
+  for ( map<Ceylan::ResourceID,
+		  pair< Video::OpenGL::TextureCountedPtr, bool> >::const_iterator it =
+		  _textureMap.begin(); it != _textureMap.end(); it++ )
+  {
+
+	Video::OpenGL::TextureCountedPtr ptr = ((*it).second).first ;
+	if ( ptr->hasContent() )
+	{
+
+	  bool purgeable = ((*it).second).second ;
+
+	  string purgeText ;
+
+	  if ( purgeable )
+		purgeText = "marked as purgeable" ;
+	  else
+		purgeText = "not marked as purgeable" ;
+
+
+	  loadedList.push_back( "ID #" + Ceylan::toString( (*it).first )
+		+ ": " + ptr->toString(level)
+		+ ", a resource which is " + purgeText
+		+ " and whose reference count is "
+		+ Ceylan::toString( ptr.getReferenceCount() ) ) ;
+
+	}
+
+  }
+
+
+  for ( map<Ceylan::ResourceID,
+		  pair< Text::TrueTypeFontCountedPtr, bool> >::const_iterator it =
+		  _truetypeFontMap.begin(); it != _truetypeFontMap.end(); it++ )
+  {
+
+	Text::TrueTypeFontCountedPtr ptr = ((*it).second).first ;
+	if ( ptr->hasContent() )
+	{
+
+	  bool purgeable = ((*it).second).second ;
+
+	  string purgeText ;
+
+	  if ( purgeable )
+		purgeText = "marked as purgeable" ;
+	  else
+		purgeText = "not marked as purgeable" ;
+
+	  loadedList.push_back( "ID #" + Ceylan::toString( (*it).first )
+		+ ": " + ptr->toString(level)
+		+ ", a resource which is " + purgeText
+		+ " and whose reference count is "
+		+ Ceylan::toString( ptr.getReferenceCount() ) ) ;
+
+	}
+
+
+	if ( loadedList.empty() )
+	{
+
+	  Ceylan::checkpoint( "Resource manager: no resource loaded." ) ;
+
+	}
+	else
+	{
+
+	  Ceylan::checkpoint( "Resource manager: "
+		+ Ceylan::formatStringList( loadedList,
+		  TextDisplayable::rawText ) ) ;
+
+	}
+
+  }
+
+}
+
+
+const string Data::ResourceManager::toString(
+  Ceylan::VerbosityLevels level ) const
+{
+
+  list<string> maps ;
+
+  Ceylan::Uint32 size = _musicMap.size() ;
+
+  string temp ;
+
+  if ( size != 0 )
+  {
+
+	temp = "Number of musics managed: " + Ceylan::toString( size ) ;
+
+	if ( level != Ceylan::low )
+	{
+
+	  list<string> musics ;
+
+	  for ( map<Ceylan::ResourceID,
+			  pair< Audio::MusicCountedPtr, bool > >::const_iterator it
+			  = _musicMap.begin(); it != _musicMap.end(); it++ )
+	  {
+
+		Audio::MusicCountedPtr ptr = ((*it).second).first ;
+
+		bool purgeable = ((*it).second).second ;
+
+		string purgeText ;
+
+		if ( purgeable )
+		  purgeText = "marked as purgeable" ;
+		else
+		  purgeText = "not marked as purgeable" ;
+
+		musics.push_back( ptr->toString(level)
+		  + " (ID #" + Ceylan::toString( (*it).first )
+		  + ", which is " + purgeText
+		  + " and whose reference count is "
+		  + Ceylan::toString( ptr.getReferenceCount() )
+		  + ")" ) ;
+
+	  }
+
+	  temp += Ceylan::formatStringList( musics,
+		/* surroundByTicks */ false, /* indentationLevel */ 2 ) ;
+
+	}
+
+
+	maps.push_back( temp ) ;
+
+  }
+  else
+  {
+
+	maps.push_back( "No music is managed" ) ;
+
+  }
+
+
+  size = _soundMap.size() ;
+
+  if ( size != 0 )
+  {
+
+	temp = "Number of sounds managed: " + Ceylan::toString( size ) ;
+
+	if ( level != Ceylan::low )
+	{
+
+	  list<string> sounds ;
+
+	  for ( map<Ceylan::ResourceID,
+			  pair<  Audio::SoundCountedPtr, bool> >::const_iterator it =
+			  _soundMap.begin(); it != _soundMap.end(); it++ )
+	  {
+
+		Audio::SoundCountedPtr ptr = ((*it).second).first ;
+
+		bool purgeable = ((*it).second).second ;
+
+		string purgeText ;
+
+		if ( purgeable )
+		  purgeText = "marked as purgeable" ;
+		else
+		  purgeText = "not marked as purgeable" ;
+
+		sounds.push_back( ptr->toString(level)
+		  + " (ID #" + Ceylan::toString( (*it).first )
+		  + ", which is " + purgeText
+		  + " and whose reference count is "
+		  + Ceylan::toString( ptr.getReferenceCount() )
+		  + ")" ) ;
+
+	  }
+
+	  temp += Ceylan::formatStringList( sounds,
+		/* surroundByTicks */ false, /* indentationLevel */ 2 ) ;
+
+	}
+
+
+	maps.push_back( temp ) ;
+
+  }
+  else
+  {
+
+	maps.push_back( "No sound is managed" ) ;
+
+  }
+
+
+  size = _imageMap.size() ;
+
+  if ( size != 0 )
+  {
+
+	temp = "Number of images managed: " + Ceylan::toString( size ) ;
+
+	if ( level != Ceylan::low )
+	{
+
+	  list<string> images ;
+
+	  for ( map<Ceylan::ResourceID,
+		pair< Video::TwoDimensional::ImageCountedPtr, bool> >::const_iterator it
+			  = _imageMap.begin(); it != _imageMap.end(); it++ )
+	  {
+
+		Video::TwoDimensional::ImageCountedPtr ptr = ((*it).second).first ;
+
+		bool purgeable = ((*it).second).second ;
+
+		string purgeText ;
+
+		if ( purgeable )
+		  purgeText = "marked as purgeable" ;
+		else
+		  purgeText = "not marked as purgeable" ;
+
+		images.push_back( ptr->toString(level)
+		  + " (ID #" + Ceylan::toString( (*it).first )
+		  + ", which is " + purgeText
+		  + " and whose reference count is "
+		  + Ceylan::toString( ptr.getReferenceCount() )
+		  + ")" ) ;
+
+	  }
+
+	  temp += Ceylan::formatStringList( images,
+		/* surroundByTicks */ false, /* indentationLevel */ 2 ) ;
+
+	}
+
+
+	maps.push_back( temp ) ;
+
+  }
+  else
+  {
+
+	maps.push_back( "No image is managed" ) ;
+
+  }
+
+
+  size = _textureMap.size() ;
+
+  if ( size != 0 )
+  {
+
+	temp = "Number of textures managed: " + Ceylan::toString( size ) ;
+
+	if ( level != Ceylan::low )
+	{
+
+	  list<string> textures ;
+
+	  for ( map<Ceylan::ResourceID,
+			  pair< Video::OpenGL::TextureCountedPtr, bool> >::const_iterator
+			  it = _textureMap.begin(); it != _textureMap.end(); it++ )
+	  {
+
+		Video::OpenGL::TextureCountedPtr ptr = ((*it).second).first ;
+
+		bool purgeable = ((*it).second).second ;
+
+		string purgeText ;
+
+		if ( purgeable )
+		  purgeText = "marked as purgeable" ;
+		else
+		  purgeText = "not marked as purgeable" ;
+
+		textures.push_back( ptr->toString(level)
+		  + " (ID #" + Ceylan::toString( (*it).first )
+		  + ", which is " + purgeText
+		  + " and whose reference count is "
+		  + Ceylan::toString( ptr.getReferenceCount() )
+		  + ")" ) ;
+
+	  }
+
+	  temp += Ceylan::formatStringList( textures,
+		/* surroundByTicks */ false, /* indentationLevel */ 2 ) ;
+
+	}
+
+
+	maps.push_back( temp ) ;
+
+  }
+  else
+  {
+
+	maps.push_back( "No texture is managed" ) ;
+
+  }
+
+
+  size = _truetypeFontMap.size() ;
+
+  if ( size != 0 )
+  {
+
+	temp = "Number of TrueType font managed: " + Ceylan::toString( size ) ;
+
+	if ( level != Ceylan::low )
+	{
+
+	  list<string> trueTypeFonts ;
+
+	  for ( map<Ceylan::ResourceID,
+			  pair< Text::TrueTypeFontCountedPtr, bool> >::const_iterator it =
+			  _truetypeFontMap.begin(); it != _truetypeFontMap.end();
+			it++ )
+	  {
+
+		Text::TrueTypeFontCountedPtr ptr = ((*it).second).first ;
+
+		bool purgeable = ((*it).second).second ;
+
+		string purgeText ;
+
+		if ( purgeable )
+		  purgeText = "marked as purgeable" ;
+		else
+		  purgeText = "not marked as purgeable" ;
+
+		trueTypeFonts.push_back( ptr->toString(level)
+		  + " (ID #" + Ceylan::toString( (*it).first )
+		  + ", which is " + purgeText
+		  + " and whose reference count is "
+		  + Ceylan::toString( ptr.getReferenceCount() )
+		  + ")" ) ;
+
+	  }
+
+	  temp += Ceylan::formatStringList( trueTypeFonts,
+		/* surroundByTicks */ false, /* indentationLevel */ 2 ) ;
+
+	}
+
+
+	maps.push_back( temp ) ;
+
+  }
+  else
+  {
+
+	maps.push_back( "No texture is managed" ) ;
+
+  }
+
+
+  size = _reverseMap.size() ;
+
+  if ( size != 0 )
+  {
+
+	temp = "Number of entries in reverse map: " + Ceylan::toString( size ) ;
+
+	if ( level != Ceylan::low )
+	{
+
+	  list<string> entries ;
+
+	  for ( map<std::string,Ceylan::ResourceID>::const_iterator it =
+			  _reverseMap.begin(); it != _reverseMap.end(); it++ )
+	  {
+
+		entries.push_back( "Resource path '" + (*it).first
+		  + "' corresponds to ID #"
+		  + Ceylan::toString( (*it).second ) ) ;
+
+	  }
+
+	  temp += Ceylan::formatStringList( entries,
+		/* surroundByTicks */ false, /* indentationLevel */ 2 ) ;
+
+	}
+
+
+	maps.push_back( temp ) ;
+
+  }
+  else
+  {
+
+	maps.push_back( "No entry in reverse resource map" ) ;
+
+  }
+
+  if ( ! _sharedContents.empty() )
+  {
+
+	temp = "Number of resources sharing the instance of an identical one: "
+	  + Ceylan::toString( _sharedContents.size() ) ;
+
+	if ( level != Ceylan::low )
+	{
+
+	  list<string> shared ;
+
+	  for ( map<ResourceID,ResourceID>::const_iterator it =
+			  _sharedContents.begin(); it != _sharedContents.end(); it++ )
+		shared.push_back( "ID #" + Ceylan::toString( (*it).first )
+		  + " shares the instance of ID #"
+		  + Ceylan::toString( (*it).second ) ) ;
+
+	  temp += Ceylan::formatStringList( shared,
+		/* surroundByTicks */ false, /* indentationLevel */ 2 ) ;
+
+	}
+
+	maps.push_back( temp ) ;
+
+  }
+
+  if ( ! _atlases.empty() )
+  {
+
+	temp = "Number of image atlases: " + Ceylan::toString( _atlases.size() ) ;
+
+	if ( level != Ceylan::low )
+	{
+
+	  list<string> atlases ;
+
+	  for ( list<Video::TwoDimensional::ImageAtlasCountedPtr>::const_iterator
+			  it = _atlases.begin(); it != _atlases.end(); it++ )
+		atlases.push_back( (*it)->toString( Ceylan::low ) ) ;
+
+	  temp += Ceylan::formatStringList( atlases,
+		/* surroundByTicks */ false, /* indentationLevel */ 2 ) ;
+
+	}
+
+	maps.push_back( temp ) ;
+
+  }
+
+  if ( ! _groups.empty() )
+  {
+
+	list<string> groups ;
+
+	for ( map<string, list<ResourceID> >::const_iterator it =
+			_groups.begin(); it != _groups.end(); it++ )
+	  groups.push_back( "group '" + (*it).first + "' with "
+		+ Ceylan::toString( (*it).second.size() ) + " resource(s)" ) ;
+
+	maps.push_back( "Resource groups: " + Ceylan::formatStringList( groups,
+	  /* surroundByTicks */ false, /* indentationLevel */ 2 ) ) ;
+
+  }
+
+  if ( getPrefetchingCount() != 0 )
+	maps.push_back( Ceylan::toString( _imagePrefetches.size() )
+	  + " image(s) being prefetched in the background, and "
+	  + Ceylan::toString( _mainThreadPrefetches.size() )
+	  + " resource(s) waiting to be prefetched by the main thread" ) ;
+
+  if ( _memoryBudget != 0 )
+	maps.push_back( "Memory budget: " + Ceylan::toString( _memoryBudget )
+	  + " bytes, of which " + Ceylan::toString( getMemoryFootprint() )
+	  + " are used, with " + Ceylan::toString( _pinned.size() )
+	  + " pinned resource(s)" ) ;
+
+  maps.push_back( "Cache statistics: " + Ceylan::toString( _statistics.hits )
+	+ " hit(s), " + Ceylan::toString( _statistics.misses ) + " miss(es), "
+	+ Ceylan::toString( _statistics.evictions ) + " eviction(s)" ) ;
+
+  if ( ! _latencies.empty() )
+	maps.push_back( "Loading durations known for "
+	  + Ceylan::toString( _latencies.size() ) + " resource(s)" ) ;
+
+  if ( _index != 0 )
+	maps.push_back( "Paths looked-up in " + _index->toString( level ) ) ;
+
+  maps.push_back( "Maximum resource ID currently allocated: "
+	+ Ceylan::toString( _maxID ) ) ;
+
+  return "ResourceManager state: " + Ceylan::formatStringList( maps ) ;
+
+}
+
+
+
+
+
+// Static section.
+
+
+
+Ceylan::Uint32 Data::ResourceManager::CompileResourceMap(
+  const string & resourceMapFilename, const string & indexFilename,
+  const string & contentDirectory )
+{
+
+  Ceylan::XML::XMLParser resourceParser( resourceMapFilename ) ;
+
+  resourceParser.loadFromFile() ;
+
+  const XMLSubtreeList & sons = resourceParser.getXMLTree().getSons() ;
+
+  list<ResourceIndex::Entry> entries ;
+  ResourceIndex::GroupMap groups ;
+
+  // The path of the first resource of each content hash and type:
+  map< pair<Ceylan::Uint64,Ceylan::Uint8>, string > hashedPaths ;
+
+  for ( XMLSubtreeList::const_iterator it = sons.begin();
+		it != sons.end(); it++ )
+  {
+
+	ResourceIndex::Entry entry ;
+	list<string> groupNames ;
+
+	ParseResourceEntry( *(*it), entry, groupNames ) ;
+
+	if ( ! contentDirectory.empty() )
+	{
+
+	  string contentPath = contentDirectory + "/" + entry.path ;
+
+	  entry.contentHash = HashResourceContent( contentPath ) ;
+
+	  /*
+	   * Managers share the instance of resources of equal hashes and types,
+	   * so hashes must imply equal contents: a content whose hash collides
+	   * with the one of a different content is given no hash, hence is never
+	   * shared.
+	   *
+	   */
+	  std::pair< map< pair<Ceylan::Uint64,Ceylan::Uint8>, string >::iterator,
+		bool > hashed = hashedPaths.insert( std::make_pair(
+		  std::make_pair( entry.contentHash, entry.contentType ),
+		  contentPath ) ) ;
+
+	  try
+	  {
+
+		if ( ! hashed.second && ! Utils::haveSameContent(
+			(*hashed.first).second, contentPath ) )
+		{
+
+		  LogPlug::warning( "ResourceManager::CompileResourceMap: "
+			"the content of '" + entry.path + "' has the same hash as "
+			"the one of '" + (*hashed.first).second
+			+ "', while being different; it will not be shared." ) ;
+
+		  entry.contentHash = 0 ;
+
+		}
+
+	  }
+	  catch( const OSDL::Exception & e )
+	  {
+
+		throw ResourceManagerException( "ResourceManager::CompileResourceMap "
+		  "failed for '" + resourceMapFilename + "': " + e.toString() ) ;
+
+	  }
+
+	}
+
+	entries.push_back( entry ) ;
+
+	for ( list<string>::const_iterator groupIt = groupNames.begin();
+		  groupIt != groupNames.end(); groupIt++ )
+	  groups[ *groupIt ].push_back( entry.id ) ;
+
+  }
+
+  try
+  {
+
+	ResourceIndex::Save( entries, groups, indexFilename ) ;
+
+  }
+  catch( const ResourceIndexException & e )
+  {
+
+	throw ResourceManagerException( "ResourceManager::CompileResourceMap "
+	  "failed for '" + resourceMapFilename + "': " + e.toString() ) ;
+
+  }
+
+  return static_cast<Ceylan::Uint32>( entries.size() ) ;
+
+}
+
+
+
+Ceylan::Uint64 Data::ResourceManager::HashResourceContent(
+  const string & resourceFilename )
+{
+
+  // Read block per block, as resources like musics may be large:
+  const Ceylan::System::Size BlockSize = 64 * 1024 ;
+
+  std::vector<Ceylan::Byte> block( BlockSize ) ;
+
+  Ceylan::Uint64 hash = Utils::EmptyContentHash ;
+
+  try
+  {
+
+	Ceylan::Holder<Ceylan::System::File> fileHolder(
+	  Ceylan::System::File::Open( resourceFilename ) ) ;
+
+	Ceylan::System::Size remaining = fileHolder->size() ;
+
+	while ( remaining > 0 )
+	{
+
+	  Ceylan::System::Size count = std::min( remaining, BlockSize ) ;
+
+	  fileHolder->readExactLength( & block[0], count ) ;
+
+	  hash = Utils::hashContent( & block[0], count, hash ) ;
+
+	  remaining -= count ;
+
+	}
+
+  }
+  catch( const Ceylan::Exception & e )
+  {
+
+	throw ResourceManagerException( "ResourceManager::HashResourceContent "
+	  "failed for '" + resourceFilename + "': " + e.toString() ) ;
+
+  }
+
+  return hash ;
+
+}
+
+
+
+
+// Protected members below:
+
+
+
+void Data::ResourceManager::registerResource(
+  const Ceylan::XML::XMLParser::XMLTree & resourceXMLEntry )
+{
+
+  ResourceIndex::Entry entry ;
+  list<string> groupNames ;
+
+  ParseResourceEntry( resourceXMLEntry, entry, groupNames ) ;
+
+  // First register that resource in reverse map:
+  _reverseMap.insert( std::pair<std::string,Ceylan::ResourceID>(
+	  entry.path, entry.id ) ) ;
+
+  for ( list<string>::const_iterator it = groupNames.begin();
+		it != groupNames.end(); it++ )
+	_groups[ *it ].push_back( entry.id ) ;
+
+  registerEntry( entry.id, entry.path,
+	static_cast<ContentType>( entry.contentType ), entry.contentHash ) ;
+
+}
+
+
+
+void Data::ResourceManager::registerEntry( Ceylan::ResourceID id,
+  const string & resourcePath, ContentType resourceType,
+  Ceylan::Uint64 contentHash )
+{
+
+  if ( id > _maxID )
+	_maxID = id ;
+
+  /*
+   * A resource whose content is identical to the one of an already registered
+   * resource of the same type shares its instance. Fonts are not shared, as
+   * each identifier may be used with its own point size:
+   *
+   */
+  if ( contentHash != 0 && resourceType != Data::ttf_font
+	  && resourceType != Data::image_atlas )
+  {
+
+	std::pair< map< pair<Ceylan::Uint64,ContentType>, ResourceID >::iterator,
+	  bool > inserted = _contentOwners.insert( std::make_pair(
+		std::make_pair( contentHash, resourceType ), id ) ) ;
+
+	// Re-registered (ex: once discarded) owners are not shared with themselves:
+	if ( ! inserted.second && (*inserted.first).second != id )
+	{
+
+	  _sharedContents[ id ] = (*inserted.first).second ;
+	  return ;
+
+	}
+
+  }
+
+  // By default, unloaded resources are not purgeable:
+  bool purgeable = false ;
+
+  if ( resourceType == Data::music )
+  {
+
+	Audio::MusicCountedPtr newMusicPtr =
+	  new Audio::Music( resourcePath, /* preload */ false ) ;
+
+	// Reference count is 1 here.
+
+	/*
+	  send( "Inserting into music dictionary: '" + newMusicPtr->toString()
+	  + "', with refcount = "
+	  + Ceylan::toString( newMusicPtr.getReferenceCount() ) + "." ) ;
+	*/
+
+	/*
+	 * Not kept as apparently induces useless reference counts changes:
+	 * (2->1->2 instead of staying at 2 with an insert)
+
+	 _musicMap[ id ] = newMusicPtr ;
+
+	*/
+
+	_musicMap.insert( std::pair<Ceylan::ResourceID,
+				std::pair< Audio::MusicCountedPtr, bool > >(
+				  id, std::make_pair( newMusicPtr, purgeable ) ) ) ;
+
+	// Reference count is 2 here.
+
+	/*
+	  send( "Inserted into music dictionary: '" + newMusicPtr->toString()
+	  + "', with refcount = "
+	  + Ceylan::toString( newMusicPtr.getReferenceCount() ) + "." ) ;
+	*/
+
+  }
+  else if ( resourceType == Data::sound )
+  {
+
+	Audio::SoundCountedPtr newSoundPtr =
+	  new Audio::Sound( resourcePath, /* preload */ false ) ;
+
+	_soundMap.insert( std::pair<Ceylan::ResourceID,
+				std::pair< Audio::SoundCountedPtr, bool > >(
+				  id, std::make_pair( newSoundPtr, purgeable ) ) ) ;
+
+  }
+  else if ( resourceType == Data::image )
+  {
+
+	// Defaults:
+	bool convertToDisplayFormat = false ;
+	bool convertWithAlpha = true ;
+
+	// Conversion to display to screen format could be managed here:
+
+	Video::TwoDimensional::ImageCountedPtr newImagePtr =
+	  new Video::TwoDimensional::Image( resourcePath,
+		/* preload */ false,
+		/* convertToDisplayFormat */ convertToDisplayFormat,
+		/* convertWithAlpha */ convertWithAlpha ) ;
+
+	_imageMap.insert( std::pair<Ceylan::ResourceID,
+				std::pair< Video::TwoDimensional::ImageCountedPtr, bool > >(
+				  id, std::make_pair( newImagePtr, purgeable ) ) ) ;
+
+  }
+  else if ( resourceType == Data::texture_2D )
+  {
+
+	Video::OpenGL::TextureCountedPtr newTexturePtr =
+	  new Video::OpenGL::GLTexture( resourcePath,
+		/* flavour */ Video::OpenGL::GLTexture::For2D,
+		/* preload */ false ) ;
+
+	_textureMap.insert( std::pair<Ceylan::ResourceID,
+				std::pair< Video::OpenGL::TextureCountedPtr, bool > >(
+				  id, std::make_pair( newTexturePtr, purgeable ) ) ) ;
+
+  }
+  else if ( resourceType == Data::texture_3D )
+  {
+
+	Video::OpenGL::TextureCountedPtr newTexturePtr =
+	  new Video::OpenGL::GLTexture( resourcePath,
+		/* flavour */ Video::OpenGL::GLTexture::For3D,
+		/* preload */ false ) ;
+
+	_textureMap.insert( std::pair<Ceylan::ResourceID,
+				std::pair< Video::OpenGL::TextureCountedPtr, bool > >(
+				  id, std::make_pair( newTexturePtr, purgeable ) ) ) ;
+
+  }
+  else if ( resourceType == Data::ttf_font )
+  {
+
+	/*
+	 * The user code will be able to change the point size later,
+	 * preferably at loading time:
+	 *
+	 */
+	Text::TrueTypeFontCountedPtr newTrueTypeFontPtr =
+	  new Video::TwoDimensional::Text::TrueTypeFont(
+		/* font filename */ resourcePath,
+		/* index */ 0,
+		/* convertToDisplay */ false,
+		/* cacheSettings */ Text::Font::GlyphCached,
+		/* preload */ false ) ;
+
+	_truetypeFontMap.insert( std::pair<Ceylan::ResourceID,
+				std::pair< Video::TwoDimensional::Text::TrueTypeFontCountedPtr,
+						   bool > >(
+				  id, std::make_pair( newTrueTypeFontPtr, purgeable ) ) ) ;
+
+  }
+  else if ( resourceType == Data::image_atlas )
+  {
+
+	// Registered once all other resources are:
+	_pendingAtlasPaths.push_back( resourcePath ) ;
+
+  }
+  else
+  {
+
+	string message = "Resource in '" + resourcePath
+	  + "' has for content type #" + Ceylan::toString( resourceType )
+	  + ", which is not managed." ;
+
+	send( message ) ;
+
+	LogPlug::warning( message ) ;
+
+	return ;
+
+  }
+
+
+  //send( "Resource inserted." ) ;
+
+  // Reference count is 1 here.
+
+}
+
+
+
+void Data::ResourceManager::ParseResourceEntry(
+  const Ceylan::XML::XMLParser::XMLTree & resourceXMLEntry,
+  ResourceIndex::Entry & entry, list<string> & groupNames )
+{
+
+  const Ceylan::XML::XMLMarkup * const resourceMarkup =
+	dynamic_cast<const Ceylan::XML::XMLMarkup*>(
+	  & resourceXMLEntry.getContentAsConst() ) ;
+
+  if ( resourceMarkup == 0 )
+	throw ResourceManagerException( "ResourceManager::ParseResourceEntry: "
+	  "expected resource mark-up not found." ) ;
+
+  Ceylan::ResourceID id = static_cast<Ceylan::ResourceID>(
+	Ceylan::stringToUnsignedLong(
+	  resourceMarkup->getExistingAttribute( "id" ) ) ) ;
+
+  //send( "id = " + Ceylan::toString( id ) ) ;
+
+  const XMLSubtreeList & resourceSettingEntries = resourceXMLEntry.getSons() ;
+
+  string resourcePath, resourceStringifiedType ;
+
+  const Ceylan::XML::XMLMarkup * currentMarkup ;
+
+
+  for ( XMLSubtreeList::const_iterator it = resourceSettingEntries.begin();
+		it != resourceSettingEntries.end(); it++ )
+  {
+
+	currentMarkup = dynamic_cast<const Ceylan::XML::XMLMarkup*>(
+	  & (*it)->getContentAsConst() ) ;
+
+	if ( currentMarkup == 0 )
+	  throw ResourceManagerException(
+		"ResourceManager::ParseResourceEntry: "
+		"expected setting mark-up not found." ) ;
+
+	if ( currentMarkup->getMarkupName() == "resource_path" )
+	{
+
+	  const Ceylan::XML::XMLText * resourceText =
+		dynamic_cast<const Ceylan::XML::XMLText*>(
+		  & (*it)->getSons().front()->getContent() ) ;
+
+	  if ( resourceText == 0 )
+		throw ResourceManagerException(
+		  "ResourceManager::ParseResourceEntry: "
+		  "expected resource path not found." ) ;
+
+	  resourcePath = resourceText->toString() ;
+
+	}
+	else if ( currentMarkup->getMarkupName() == "content_type" )
+	{
+
+	  const Ceylan::XML::XMLText * resourceContentType =
+		dynamic_cast<const Ceylan::XML::XMLText*>(
+		  & (*it)->getSons().front()->getContent() ) ;
+
+	  if ( resourceContentType == 0 )
+		throw ResourceManagerException(
+		  "ResourceManager::ParseResourceEntry: "
+		  "expected resource content type not found." ) ;
+
+	  resourceStringifiedType = resourceContentType->toString() ;
+
+	}
+	else if ( currentMarkup->getMarkupName() == "group" )
+	{
+
+	  const Ceylan::XML::XMLText * groupName =
+		dynamic_cast<const Ceylan::XML::XMLText*>(
+		  & (*it)->getSons().front()->getContent() ) ;
+
+	  if ( groupName == 0 )
+		throw ResourceManagerException(
+		  "ResourceManager::ParseResourceEntry: "
+		  "expected group name not found." ) ;
+
+	  groupNames.push_back( groupName->toString() ) ;
+
+	}
+	else
+	{
+
+	  LogPlug::warning( "ResourceManager::ParseResourceEntry: "
+		"mark-up setting '" + currentMarkup->getMarkupName()
+		+ "' ignored." ) ;
+	}
+
+
+  }
+
+  if ( resourcePath.empty() )
+	throw ResourceManagerException(
+	  "ResourceManager::ParseResourceEntry: "
+	  "no resource path could be found." ) ;
+
+  if ( resourceStringifiedType.empty() )
+	throw ResourceManagerException(
+	  "ResourceManager::ParseResourceEntry: "
+	  "no resource content type could be found." ) ;
+
+
+  ContentType resourceType = GetContentType( resourceStringifiedType,
+	/* throwIfNotMatched */ false ) ;
+
+  if ( resourceType == Data::unknown )
+	throw ResourceManagerException(
+	  "ResourceManager::ParseResourceEntry: the resource whose path is '"
+	  + resourcePath + "' is not of a known content type. "
+	  "Forgot to post-process it, or to remove this file?" ) ;
+
+  entry.id          = id ;
+  entry.contentType = static_cast<Ceylan::Uint8>( resourceType ) ;
+  entry.path        = resourcePath ;
+  entry.contentHash = 0 ;
+
+}
+
+
+
+Ceylan::ResourceID Data::ResourceManager::getIDForPath(
+  const string & resourcePath, bool emergencyStopInNotFound ) const
+{
+
+  Ceylan::ResourceID id ;
+
+  if ( ! findIDForPath( resourcePath, id ) )
+  {
+
+	/*
+	 * If just raising an exception, then this can lead to a segmentation fault:
+	 * the exception propation may make a view constructor be aborted, which in
+	 * turn may make its model constructor be aborted, which will try to
+	 * deallocate this view, which is not a proper view, causing the program to
+	 * crash.
+	 *
+	 * Ex: in ~SingleControllerSingleViewGenericModel, with
+	 * 'delete this->_view ;' and a view requesting an unknown ID at
+	 * construction-time.
+	 *
+	 */
 
-  if ( size != 0 )
+	string message = "getIDForPath: failed to look-up resource file '"
+	  + resourcePath + "'." ;
+
+	LogPlug::error( message ) ;
+
+	if ( emergencyStopInNotFound )
+	  Ceylan::emergencyShutdown( message ) ;
+	else
+	  throw ResourceManagerException( "ResourceManager::getIDForPath: "
+		"resource path '" + resourcePath
+		+ "' could not be found in archive." ) ;
+
+  }
+
+  return id ;
+
+}
+
+
+
+bool Data::ResourceManager::findIDForPath( const string & resourcePath,
+  ResourceID & id ) const
+{
+
+  if ( _index != 0 && _index->findIDFor( resourcePath, id ) )
   {
 
-	temp = "Number of entries in reverse map: " + Ceylan::toString( size ) ;
+	id = getContentOwner( id ) ;
+	return true ;
 
-	if ( level != Ceylan::low )
+  }
+
+  map<string,ResourceID>::const_iterator it =
+	_reverseMap.find( resourcePath ) ;
+
+  if ( it == _reverseMap.end() )
+	return false ;
+
+  id = getContentOwner( (*it).second ) ;
+
+  return true ;
+
+}
+
+
+
+bool Data::ResourceManager::findPathFor( ResourceID id,
+  string & resourcePath ) const
+{
+
+  if ( _index != 0 && _index->findPathFor( id, resourcePath ) )
+	return true ;
+
+  // Reverse look-up, hence linear:
+  for ( map<string,ResourceID>::const_iterator it = _reverseMap.begin();
+		it != _reverseMap.end(); it++ )
+	if ( (*it).second == id )
 	{
 
-	  list<string> entries ;
+	  resourcePath = (*it).first ;
+	  return true ;
 
-	  for ( map<std::string,Ceylan::ResourceID>::const_iterator it =
-			  _reverseMap.begin(); it != _reverseMap.end(); it++ )
+	}
+
+  return false ;
+
+}
+
+
+
+ResourceID Data::ResourceManager::getContentOwner( ResourceID id ) const
+{
+
+  map<ResourceID,ResourceID>::const_iterator it = _sharedContents.find( id ) ;
+
+  if ( it == _sharedContents.end() )
+	return id ;
+
+  return (*it).second ;
+
+}
+
+
+
+ResourceID Data::ResourceManager::resolveResource( ResourceID id )
+{
+
+  id = getContentOwner( id ) ;
+
+  if ( _index == 0 || isRegistered( id ) )
+	return id ;
+
+  ResourceIndex::Entry entry ;
+
+  // Atlases are registered by the constructor, as their packed images:
+  if ( ! _index->findEntryFor( id, entry )
+	  || entry.contentType == Data::image_atlas )
+	return id ;
+
+  if ( entry.contentType >= Data::unknown )
+	throw ResourceManagerException( "ResourceManager::resolveResource "
+	  "failed: the resource whose path is '" + entry.path
+	  + "' is not of a known content type." ) ;
+
+  registerEntry( entry.id, entry.path,
+	static_cast<ContentType>( entry.contentType ), entry.contentHash ) ;
+
+  // Its content may be shared with a resource already used:
+  return getContentOwner( id ) ;
+
+}
+
+
+
+bool Data::ResourceManager::isRegistered( ResourceID id ) const
+{
+
+  return _imageMap.find( id ) != _imageMap.end()
+	|| _soundMap.find( id ) != _soundMap.end()
+	|| _textureMap.find( id ) != _textureMap.end()
+	|| _musicMap.find( id ) != _musicMap.end()
+	|| _truetypeFontMap.find( id ) != _truetypeFontMap.end() ;
+
+}
+
+
+
+WorkerPool & Data::ResourceManager::getPrefetchPool()
+{
+
+  if ( _prefetchPool == 0 )
+	_prefetchPool = new WorkerPool( /* workerCount */ 0,
+	  "resource prefetchers" ) ;
+
+  return *_prefetchPool ;
+
+}
+
+
+
+Video::TwoDimensional::AsyncImageLoader *
+  Data::ResourceManager::getPrefetchLoader()
+{
+
+  if ( _prefetchLoader != 0 )
+	return _prefetchLoader ;
+
+  try
+  {
+
+	/*
+	 * Each Image converts the surface to the display format it was created
+	 * with, when adopting it:
+	 *
+	 */
+	_prefetchLoader = new Video::TwoDimensional::AsyncImageLoader(
+	  getPrefetchPool(), /* convertToDisplay */ false ) ;
+
+  }
+  catch( const Video::TwoDimensional::ImageException & e )
+  {
+
+	LogPlug::warning( "ResourceManager::getPrefetchLoader: "
+	  "images will be prefetched by the main thread: " + e.toString() ) ;
+
+	return 0 ;
+
+  }
+
+  return _prefetchLoader ;
+
+}
+
+
+
+Ceylan::Uint32 Data::ResourceManager::deliverPrefetchedImages(
+  Ceylan::Uint32 maxCount )
+{
+
+  if ( _prefetchLoader == 0 )
+	return 0 ;
+
+  list<Video::TwoDimensional::AsyncImageLoader::Handle> delivered =
+	_prefetchLoader->deliverCompletedLoads( maxCount ) ;
+
+  Ceylan::Uint32 count = 0 ;
+
+  for ( list<Video::TwoDimensional::AsyncImageLoader::Handle>::const_iterator
+		it = delivered.begin(); it != delivered.end(); it++ )
+  {
+
+	map<Video::TwoDimensional::AsyncImageLoader::Handle,ResourceID>::iterator
+	  prefetchIt = _imagePrefetches.find( *it ) ;
+
+	if ( prefetchIt == _imagePrefetches.end() )
+	  continue ;
+
+	ResourceID id = (*prefetchIt).second ;
+
+	_imagePrefetches.erase( prefetchIt ) ;
+	_imagePrefetchHandles.erase( id ) ;
+
+	LoadLatency latency ;
+	latency.inBackground = true ;
+
+	try
+	{
+
+	  // Durations are forgotten as soon as the surface is taken:
+	  _prefetchLoader->getDurationsOf( *it, latency.ioDuration,
+		latency.decodeDuration ) ;
+
+	  Video::Surface & loaded = _prefetchLoader->takeSurface( *it ) ;
+
+	  map< ResourceID, pair<Video::TwoDimensional::ImageCountedPtr,bool> >::
+		iterator imageIt = _imageMap.find( id ) ;
+
+	  map< ResourceID, pair<Video::OpenGL::TextureCountedPtr,bool> >::
+		iterator textureIt = _textureMap.find( id ) ;
+
+	  bool adopted = false ;
+
+	  if ( imageIt != _imageMap.end() )
+		adopted = (*imageIt).second.first->adoptContent( loaded ) ;
+	  else if ( textureIt != _textureMap.end() )
+		adopted = (*textureIt).second.first->adoptContent( loaded ) ;
+	  else
+		delete & loaded ;
+
+	  /*
+	   * Otherwise the resource was purged, or got loaded meanwhile (the
+	   * surface being then deleted):
+	   *
+	   */
+	  if ( adopted )
 	  {
 
-		entries.push_back( "Resource path '" + (*it).first
-		  + "' corresponds to ID #"
-		  + Ceylan::toString( (*it).second ) ) ;
+		_latencies[ id ] = latency ;
+		trackLoaded( id ) ;
+		count++ ;
+
+	  }
+
+	}
+	catch( const Ceylan::Exception & e )
+	{
+
+	  // The getter will try again, and report the failure then:
+	  LogPlug::warning( "ResourceManager::deliverPrefetchedImages: "
+		"prefetching of resource #" + Ceylan::toString( id ) + " failed: "
+		+ e.toString() ) ;
+
+	}
+
+  }
+
+  return count ;
+
+}
+
+
+
+const Video::Pixels::PixelFormat & Data::ResourceManager::getTextureFormat()
+{
+
+  // Same format as the internal surface of GLTexture instances:
+  if ( _textureFormatHolder == 0 )
+	_textureFormatHolder = new Video::Surface(
+	  Video::VideoModule::SoftwareSurface, /* width */ 1, /* height */ 1,
+	  /* bits per pixel */ 32, Video::OpenGL::RedMask,
+	  Video::OpenGL::GreenMask, Video::OpenGL::BlueMask,
+	  Video::OpenGL::AlphaMask ) ;
+
+  return _textureFormatHolder->getPixelFormat() ;
+
+}
+
+
+
+bool Data::ResourceManager::isPrefetching( ResourceID id ) const
+{
+
+  return ( _imagePrefetchHandles.find( id ) != _imagePrefetchHandles.end()
+	|| _resourcePrefetches.find( id ) != _resourcePrefetches.end()
+	|| _heldFontContents.find( id ) != _heldFontContents.end()
+	|| std::find( _mainThreadPrefetches.begin(), _mainThreadPrefetches.end(),
+	  id ) != _mainThreadPrefetches.end() ) ;
+
+}
+
+
+
+Ceylan::Uint32 Data::ResourceManager::deliverPrefetchedResources(
+  Ceylan::Uint32 maxCount )
+{
+
+  Ceylan::Uint32 count = 0 ;
+
+  map<ResourceID, ResourcePrefetchJob *>::iterator it =
+	_resourcePrefetches.begin() ;
+
+  while ( it != _resourcePrefetches.end()
+	  && ( maxCount == 0 || count < maxCount ) )
+  {
+
+	ResourceID id = (*it).first ;
+	ResourcePrefetchJob & job = *(*it).second ;
+
+	Job::JobState state = _prefetchPool->getStateOf( job ) ;
+
+	if ( state != Job::Completed && state != Job::Failed )
+	{
+
+	  it++ ;
+	  continue ;
+
+	}
+
+	_resourcePrefetches.erase( it++ ) ;
+
+	if ( state == Job::Failed )
+	{
+
+	  // The getter will try again, and report the failure then:
+	  LogPlug::warning( "ResourceManager::deliverPrefetchedResources: "
+		"prefetching of resource #" + Ceylan::toString( id ) + " failed: "
+		+ _prefetchPool->getFailureReasonFor( job ) ) ;
+
+	  delete & job ;
+	  continue ;
+
+	}
+
+	LoadLatency latency ;
+
+	latency.ioDuration     = job._ioDuration ;
+	latency.decodeDuration = job._decodeDuration ;
+	latency.inBackground   = true ;
+
+	map< ResourceID, pair<Audio::SoundCountedPtr,bool> >::iterator
+	  soundIt = _soundMap.find( id ) ;
+
+	map< ResourceID, pair<Audio::MusicCountedPtr,bool> >::iterator
+	  musicIt = _musicMap.find( id ) ;
+
+	map< ResourceID, pair<Text::TrueTypeFontCountedPtr,bool> >::iterator
+	  fontIt = _truetypeFontMap.find( id ) ;
+
+	bool installed = false ;
+
+	try
+	{
+
+	  if ( soundIt != _soundMap.end() )
+	  {
+
+		installed = (*soundIt).second.first->adoptContent(
+		  * job.takeSound() ) ;
+
+	  }
+	  else if ( musicIt != _musicMap.end() )
+	  {
+
+		Ceylan::System::Size size = job._size ;
+
+		Second startSecond, stopSecond ;
+		Microsecond startMicrosecond, stopMicrosecond ;
+
+		Ceylan::System::getPreciseTime( startSecond, startMicrosecond ) ;
+
+		installed = (*musicIt).second.first->adoptContent(
+		  job.takeContent(), size ) ;
+
+		Ceylan::System::getPreciseTime( stopSecond, stopMicrosecond ) ;
+
+		// Opening the music is all the decoding done before playing it:
+		latency.decodeDuration = Ceylan::System::getDurationBetween(
+		  startSecond, startMicrosecond, stopSecond, stopMicrosecond ) ;
+
+	  }
+	  else if ( fontIt != _truetypeFontMap.end()
+		&& ! (*fontIt).second.first->hasContent() )
+	  {
+
+		// Held until opened at the point size given to getTrueTypeFont:
+		Text::TrueTypeFont::AdoptFontContent( job._filename,
+		  job.takeContent(), job._size ) ;
+
+		_heldFontContents[ id ] = job._filename ;
+
+		installed = true ;
+
+	  }
+
+	  // Otherwise the resource was purged, or got loaded meanwhile.
+
+	}
+	catch( const Ceylan::Exception & e )
+	{
+
+	  // The getter will try again, and report the failure then:
+	  LogPlug::warning( "ResourceManager::deliverPrefetchedResources: "
+		"prefetching of resource #" + Ceylan::toString( id ) + " failed: "
+		+ e.toString() ) ;
+
+	}
+
+	delete & job ;
+
+	if ( installed )
+	{
+
+	  _latencies[ id ] = latency ;
+
+	  // Fonts are only loaded once opened, by getTrueTypeFont:
+	  if ( fontIt == _truetypeFontMap.end() )
+		trackLoaded( id ) ;
+
+	  count++ ;
+
+	}
+
+  }
+
+  return count ;
+
+}
+
+
+
+void Data::ResourceManager::completeImagePrefetch( ResourceID id )
+{
+
+  map<ResourceID,Video::TwoDimensional::AsyncImageLoader::Handle>::
+	const_iterator it = _imagePrefetchHandles.find( id ) ;
+
+  if ( it == _imagePrefetchHandles.end() )
+	return ;
+
+  // Cheaper than starting the same loading again from scratch:
+  _prefetchLoader->waitFor( (*it).second ) ;
+
+  deliverPrefetchedImages( /* maxCount */ 0 ) ;
+
+}
+
+
+
+void Data::ResourceManager::completeResourcePrefetch( ResourceID id )
+{
+
+  map<ResourceID, ResourcePrefetchJob *>::const_iterator it =
+	_resourcePrefetches.find( id ) ;
+
+  if ( it == _resourcePrefetches.end() )
+	return ;
+
+  // Cheaper than starting the same reading again from scratch:
+  _prefetchPool->waitFor( *(*it).second ) ;
+
+  deliverPrefetchedResources( /* maxCount */ 0 ) ;
+
+}
+
+
 
-	  }
+void Data::ResourceManager::loadFont( ResourceID id,
+  Text::TrueTypeFontCountedPtr & font, Text::PointSize pointSize )
+{
 
-	  temp += Ceylan::formatStringList( entries,
-		/* surroundByTicks */ false, /* indentationLevel */ 2 ) ;
+  // A prefetched font may just be waiting for its installation:
+  completeResourcePrefetch( id ) ;
 
-	}
+  Second startSecond, stopSecond ;
+  Microsecond startMicrosecond, stopMicrosecond ;
 
+  Ceylan::System::getPreciseTime( startSecond, startMicrosecond ) ;
 
-	maps.push_back( temp ) ;
+  bool loaded = font->load( pointSize ) ;
 
-  }
-  else
+  Ceylan::System::getPreciseTime( stopSecond, stopMicrosecond ) ;
+
+  if ( loaded )
   {
 
-	maps.push_back( "No entry in reverse resource map" ) ;
+	Microsecond duration = Ceylan::System::getDurationBetween( startSecond,
+	  startMicrosecond, stopSecond, stopMicrosecond ) ;
 
-  }
+	map<ResourceID, string>::iterator heldIt = _heldFontContents.find( id ) ;
 
-  maps.push_back( "Maximum resource ID currently allocated: "
-	+ Ceylan::toString( _maxID ) ) ;
+	if ( heldIt != _heldFontContents.end() )
+	{
 
-  return "ResourceManager state: " + Ceylan::formatStringList( maps ) ;
+	  // Its file was read in the background, only its opening remained:
+	  _latencies[ id ].decodeDuration = duration ;
 
-}
+	  // The opened font holds that content by itself from now on:
+	  Text::TrueTypeFont::ReleaseFontContent( (*heldIt).second ) ;
+	  _heldFontContents.erase( heldIt ) ;
 
+	}
+	else
+	{
+
+	  recordLatency( id, duration ) ;
 
+	}
 
+  }
 
+  recordAccess( id, /* hit */ ! loaded ) ;
 
-// Static section.
+}
 
 
 
+void Data::ResourceManager::recordLatency( ResourceID id,
+  Microsecond duration )
+{
 
+  LoadLatency & latency = _latencies[ id ] ;
 
-// Protected members below:
+  latency.ioDuration     = 0 ;
+  latency.decodeDuration = duration ;
+  latency.inBackground   = false ;
 
+}
 
 
-void Data::ResourceManager::registerResource(
-  const Ceylan::XML::XMLParser::XMLTree & resourceXMLEntry )
+
+void Data::ResourceManager::recordAccess( ResourceID id, bool hit )
 {
 
-  const Ceylan::XML::XMLMarkup * const resourceMarkup =
-	dynamic_cast<const Ceylan::XML::XMLMarkup*>(
-	  & resourceXMLEntry.getContentAsConst() ) ;
+  if ( hit )
+  {
 
-  if ( resourceMarkup == 0 )
-	throw ResourceManagerException( "ResourceManager::registerResource: "
-	  "expected resource mark-up not found." ) ;
+	_statistics.hits++ ;
 
-  Ceylan::ResourceID id = static_cast<Ceylan::ResourceID>(
-	Ceylan::stringToUnsignedLong(
-	  resourceMarkup->getExistingAttribute( "id" ) ) ) ;
+  }
+  else
+  {
 
-  //send( "id = " + Ceylan::toString( id ) ) ;
+	_statistics.misses++ ;
 
-  if ( id > _maxID )
-	_maxID = id ;
+  }
 
-  const XMLSubtreeList & resourceSettingEntries = resourceXMLEntry.getSons() ;
+  trackLoaded( id ) ;
 
-  string resourcePath, resourceStringifiedType ;
+  if ( ! hit )
+	enforceMemoryBudget() ;
 
-  const Ceylan::XML::XMLMarkup * currentMarkup ;
+}
 
 
-  for ( XMLSubtreeList::const_iterator it = resourceSettingEntries.begin();
-		it != resourceSettingEntries.end(); it++ )
-  {
 
-	currentMarkup = dynamic_cast<const Ceylan::XML::XMLMarkup*>(
-	  & (*it)->getContentAsConst() ) ;
+void Data::ResourceManager::trackLoaded( ResourceID id )
+{
 
-	if ( currentMarkup == 0 )
-	  throw ResourceManagerException(
-		"ResourceManager::registerResource: "
-		"expected setting mark-up not found." ) ;
+  accountSize( id ) ;
 
-	if ( currentMarkup->getMarkupName() == "resource_path" )
-	{
+  map<ResourceID, bool>::iterator it = _clockReferences.find( id ) ;
 
-	  const Ceylan::XML::XMLText * resourceText =
-		dynamic_cast<const Ceylan::XML::XMLText*>(
-		  & (*it)->getSons().front()->getContent() ) ;
+  if ( it != _clockReferences.end() )
+  {
 
-	  if ( resourceText == 0 )
-		throw ResourceManagerException(
-		  "ResourceManager::registerResource: "
-		  "expected resource path not found." ) ;
+	(*it).second = true ;
+	return ;
 
-	  resourcePath = resourceText->toString() ;
+  }
 
-	}
-	else if ( currentMarkup->getMarkupName() == "content_type" )
-	{
+  // Inserted just behind the hand, hence examined last:
+  _clock.insert( _clockHand, id ) ;
+  _clockReferences[ id ] = true ;
 
-	  const Ceylan::XML::XMLText * resourceContentType =
-		dynamic_cast<const Ceylan::XML::XMLText*>(
-		  & (*it)->getSons().front()->getContent() ) ;
+}
 
-	  if ( resourceContentType == 0 )
-		throw ResourceManagerException(
-		  "ResourceManager::registerResource: "
-		  "expected resource content type not found." ) ;
 
-	  resourceStringifiedType = resourceContentType->toString() ;
 
-	}
-	else
-	{
+void Data::ResourceManager::accountSize( ResourceID id )
+{
 
-	  LogPlug::warning( "ResourceManager::registerResource: "
-		"mark-up setting '" + currentMarkup->getMarkupName()
-		+ "' ignored." ) ;
-	}
+  Ceylan::System::Size size ;
+  Ceylan::Uint32 referenceCount ;
+  ContentType type ;
+
+  if ( ! getLoadedState( id, size, referenceCount, type ) )
+  {
 
+	discountSize( id ) ;
+	return ;
 
   }
 
-  if ( resourcePath.empty() )
-	throw ResourceManagerException(
-	  "ResourceManager::registerResource: "
-	  "no resource path could be found." ) ;
+  map< ResourceID, pair<ContentType, Ceylan::System::Size> >::iterator it =
+	_accountedSizes.find( id ) ;
 
-  if ( resourceStringifiedType.empty() )
-	throw ResourceManagerException(
-	  "ResourceManager::registerResource: "
-	  "no resource content type could be found." ) ;
+  if ( it == _accountedSizes.end() )
+  {
 
+	_accountedSizes[ id ] = std::make_pair( type, size ) ;
+	getAccountedBytesOf( type ) += size ;
+	return ;
 
-  // First register that resource in reverse map:
-  _reverseMap.insert( std::pair<std::string,Ceylan::ResourceID>(
-	  resourcePath, id ) ) ;
+  }
 
+  Ceylan::System::Size & total = getAccountedBytesOf( (*it).second.first ) ;
 
-  ContentType resourceType = GetContentType( resourceStringifiedType,
-	/* throwIfNotMatched */ false ) ;
+  total = total - (*it).second.second + size ;
+  (*it).second.second = size ;
 
-  if ( resourceType == Data::unknown )
-	throw ResourceManagerException(
-	  "ResourceManager::registerResource: the resource whose path is '"
-	  + resourcePath + "' is not of a known content type. "
-	  "Forgot to post-process it, or to remove this file?" ) ;
+}
 
-  // By default, unloaded resources are not purgeable:
-  bool purgeable = false ;
 
-  if ( resourceType == Data::music )
-  {
 
-	Audio::MusicCountedPtr newMusicPtr =
-	  new Audio::Music( resourcePath, /* preload */ false ) ;
+void Data::ResourceManager::discountSize( ResourceID id )
+{
 
-	// Reference count is 1 here.
+  map< ResourceID, pair<ContentType, Ceylan::System::Size> >::iterator it =
+	_accountedSizes.find( id ) ;
 
-	/*
-	  send( "Inserting into music dictionary: '" + newMusicPtr->toString()
-	  + "', with refcount = "
-	  + Ceylan::toString( newMusicPtr.getReferenceCount() ) + "." ) ;
-	*/
+  if ( it == _accountedSizes.end() )
+	return ;
 
-	/*
-	 * Not kept as apparently induces useless reference counts changes:
-	 * (2->1->2 instead of staying at 2 with an insert)
+  getAccountedBytesOf( (*it).second.first ) -= (*it).second.second ;
 
-	 _musicMap[ id ] = newMusicPtr ;
+  _accountedSizes.erase( it ) ;
 
-	*/
+}
 
-	_musicMap.insert( std::pair<Ceylan::ResourceID,
-				std::pair< Audio::MusicCountedPtr, bool > >(
-				  id, std::make_pair( newMusicPtr, purgeable ) ) ) ;
 
-	// Reference count is 2 here.
 
-	/*
-	  send( "Inserted into music dictionary: '" + newMusicPtr->toString()
-	  + "', with refcount = "
-	  + Ceylan::toString( newMusicPtr.getReferenceCount() ) + "." ) ;
-	*/
+Ceylan::System::Size & Data::ResourceManager::getAccountedBytesOf(
+  ContentType type )
+{
 
-  }
-  else if ( resourceType == Data::sound )
+  switch( type )
   {
 
-	Audio::SoundCountedPtr newSoundPtr =
-	  new Audio::Sound( resourcePath, /* preload */ false ) ;
+	case Data::music:
+	  return _statistics.musicBytes ;
 
-	_soundMap.insert( std::pair<Ceylan::ResourceID,
-				std::pair< Audio::SoundCountedPtr, bool > >(
-				  id, std::make_pair( newSoundPtr, purgeable ) ) ) ;
+	case Data::sound:
+	  return _statistics.soundBytes ;
 
-  }
-  else if ( resourceType == Data::image )
-  {
+	case Data::texture_2D:
+	case Data::texture_3D:
+	  return _statistics.textureBytes ;
 
-	// Defaults:
-	bool convertToDisplayFormat = false ;
-	bool convertWithAlpha = true ;
+	case Data::ttf_font:
+	  return _statistics.fontBytes ;
 
-	// Conversion to display to screen format could be managed here:
+	default:
+	  return _statistics.imageBytes ;
 
-	Video::TwoDimensional::ImageCountedPtr newImagePtr =
-	  new Video::TwoDimensional::Image( resourcePath,
-		/* preload */ false,
-		/* convertToDisplayFormat */ convertToDisplayFormat,
-		/* convertWithAlpha */ convertWithAlpha ) ;
+  }
 
-	_imageMap.insert( std::pair<Ceylan::ResourceID,
-				std::pair< Video::TwoDimensional::ImageCountedPtr, bool > >(
-				  id, std::make_pair( newImagePtr, purgeable ) ) ) ;
+}
 
-  }
-  else if ( resourceType == Data::texture_2D )
-  {
 
-	Video::OpenGL::TextureCountedPtr newTexturePtr =
-	  new Video::OpenGL::GLTexture( resourcePath,
-		/* flavour */ Video::OpenGL::GLTexture::For2D,
-		/* preload */ false ) ;
 
-	_textureMap.insert( std::pair<Ceylan::ResourceID,
-				std::pair< Video::OpenGL::TextureCountedPtr, bool > >(
-				  id, std::make_pair( newTexturePtr, purgeable ) ) ) ;
+bool Data::ResourceManager::getLoadedState( ResourceID id,
+  Ceylan::System::Size & size, Ceylan::Uint32 & referenceCount,
+  ContentType & type ) const
+{
 
-  }
-  else if ( resourceType == Data::texture_3D )
-  {
+  bool loaded = false ;
 
-	Video::OpenGL::TextureCountedPtr newTexturePtr =
-	  new Video::OpenGL::GLTexture( resourcePath,
-		/* flavour */ Video::OpenGL::GLTexture::For3D,
-		/* preload */ false ) ;
+  if ( GetStateIn( _musicMap, id, Data::music, size, referenceCount, type,
+		loaded )
+	  || GetStateIn( _soundMap, id, Data::sound, size, referenceCount, type,
+		loaded )
+	  || GetStateIn( _imageMap, id, Data::image, size, referenceCount, type,
+		loaded )
+	  || GetStateIn( _textureMap, id, Data::texture_2D, size,
+		referenceCount, type, loaded )
+	  || GetStateIn( _truetypeFontMap, id, Data::ttf_font, size,
+		referenceCount, type, loaded ) )
+	return loaded ;
 
-	_textureMap.insert( std::pair<Ceylan::ResourceID,
-				std::pair< Video::OpenGL::TextureCountedPtr, bool > >(
-				  id, std::make_pair( newTexturePtr, purgeable ) ) ) ;
+  return false ;
 
-  }
-  else if ( resourceType == Data::ttf_font )
-  {
+}
 
-	/*
-	 * The user code will be able to change the point size later,
-	 * preferably at loading time:
-	 *
-	 */
-	Text::TrueTypeFontCountedPtr newTrueTypeFontPtr =
-	  new Video::TwoDimensional::Text::TrueTypeFont(
-		/* font filename */ resourcePath,
-		/* index */ 0,
-		/* convertToDisplay */ false,
-		/* cacheSettings */ Text::Font::GlyphCached,
-		/* preload */ false ) ;
 
-	_truetypeFontMap.insert( std::pair<Ceylan::ResourceID,
-				std::pair< Video::TwoDimensional::Text::TrueTypeFontCountedPtr,
-						   bool > >(
-				  id, std::make_pair( newTrueTypeFontPtr, purgeable ) ) ) ;
 
-  }
-  else
-  {
+void Data::ResourceManager::unloadResource( ResourceID id )
+{
 
-	string message = "Resource in '" + resourcePath + "' has for type '"
-	  + resourceStringifiedType + "', which is not managed." ;
+  discountSize( id ) ;
 
-	send( message ) ;
+  map< ResourceID, pair<Audio::MusicCountedPtr,bool> >::iterator musicIt =
+	_musicMap.find( id ) ;
 
-	LogPlug::warning( message ) ;
+  if ( musicIt != _musicMap.end() )
+  {
 
+	(*musicIt).second.first->unload() ;
 	return ;
 
   }
 
+  map< ResourceID, pair<Audio::SoundCountedPtr,bool> >::iterator soundIt =
+	_soundMap.find( id ) ;
 
-  //send( "Resource inserted." ) ;
-
-  // Reference count is 1 here.
-
-}
-
+  if ( soundIt != _soundMap.end() )
+  {
 
+	(*soundIt).second.first->unload() ;
+	return ;
 
-Ceylan::ResourceID Data::ResourceManager::getIDForPath(
-  const string & resourcePath, bool emergencyStopInNotFound ) const
-{
+  }
 
-  map<string,Ceylan::ResourceID>::const_iterator it =
-	_reverseMap.find( resourcePath ) ;
+  map< ResourceID, pair<Video::TwoDimensional::ImageCountedPtr,bool> >::
+	iterator imageIt = _imageMap.find( id ) ;
 
-  if ( it == _reverseMap.end() )
+  if ( imageIt != _imageMap.end() )
   {
 
-	/*
-	 * If just raising an exception, then this can lead to a segmentation fault:
-	 * the exception propation may make a view constructor be aborted, which in
-	 * turn may make its model constructor be aborted, which will try to
-	 * deallocate this view, which is not a proper view, causing the program to
-	 * crash.
-	 *
-	 * Ex: in ~SingleControllerSingleViewGenericModel, with
-	 * 'delete this->_view ;' and a view requesting an unknown ID at
-	 * construction-time.
-	 *
-	 */
+	(*imageIt).second.first->unload() ;
+	return ;
 
-	string message = "getIDForPath: failed to look-up resource file '"
-	  + resourcePath + "'." ;
+  }
 
-	LogPlug::error( message ) ;
+  map< ResourceID, pair<Video::OpenGL::TextureCountedPtr,bool> >::iterator
+	textureIt = _textureMap.find( id ) ;
 
-	if ( emergencyStopInNotFound )
-	  Ceylan::emergencyShutdown( message ) ;
-	else
-	  throw ResourceManagerException( "ResourceManager::getIDForPath: "
-		"resource path '" + resourcePath
-		+ "' could not be found in archive." ) ;
+  if ( textureIt != _textureMap.end() )
+  {
+
+	(*textureIt).second.first->unload() ;
+	return ;
 
   }
 
-  return (*it).second ;
+  map< ResourceID,
+	pair<Video::TwoDimensional::Text::TrueTypeFontCountedPtr,bool> >::iterator
+	fontIt = _truetypeFontMap.find( id ) ;
+
+  if ( fontIt != _truetypeFontMap.end() )
+	(*fontIt).second.first->unload() ;
 
 }
 
@@ -1781,6 +3980,8 @@ ContentType Data::ResourceManager::GetContentType(
 	return Data::texture_3D ;
   else if ( stringifiedType == "ttf_font" )
 	return Data::ttf_font ;
+  else if ( stringifiedType == "image_atlas" )
+	return Data::image_atlas ;
   else
   {
 
@@ -34,8 +34,11 @@
 #include "OSDLMusic.h"          // for MusicCountedPtr
 #include "OSDLSound.h"          // for SoundCountedPtr
 #include "OSDLImage.h"          // for ImageCountedPtr
+#include "OSDLImageAtlas.h"     // for ImageAtlasCountedPtr
 #include "OSDLGLTexture.h"      // for TextureCountedPtr
 #include "OSDLTrueTypeFont.h"   // for TrueTypeFontCountedPtr
+#include "OSDLAsyncImageLoader.h" // for AsyncImageLoader, WorkerPool
+#include "OSDLResourceIndex.h"  // for ResourceIndex
 
 
 #include "Ceylan.h"             // for ResourceID
@@ -44,6 +47,7 @@
 #include <string>
 #include <list>
 #include <map>
+#include <set>
 #include <utility>              // for std::pair
 
 
@@ -65,6 +69,10 @@ namespace OSDL
 	class Resource ;
 
 
+	// Defined in the implementation file.
+	class ResourcePrefetchJob ;
+
+
 	/// Exception to be thrown when engine abnormal behaviour occurs.
 	class OSDL_DLL ResourceManagerException : public DataException
 	{
@@ -140,6 +148,14 @@ namespace OSDL
 	  ttf_font,
 
 
+	  /*
+	   * For the indexes of image atlases, whose packed images are registered
+	   * as images:
+	   *
+	   */
+	  image_atlas,
+
+
 	  // For data whose content type is not known:
 	  unknown
 
@@ -196,7 +212,13 @@ namespace OSDL
 	   *
 	   * @param resourceMapFilename the filename of the XML resource map to use;
 	   * typically "resource-map.xml" if using the create-OSDL-archive.sh script
-	   * with default settings.
+	   * with default settings. If this filename ends with
+	   * ResourceIndex::FileExtension, it is read as a resource map compiled by
+	   * CompileResourceMap: no XML is parsed then, paths are looked-up in
+	   * the hashed index rather than in a reverse map, and each resource is
+	   * only created when first used (only atlases are registered at once).
+	   *
+	   * @throw ResourceManagerException if the map could not be read.
 	   *
 	   */
 	  explicit ResourceManager(
@@ -295,6 +317,14 @@ namespace OSDL
 	   * be only punctual; in that case this manager will not let this resource
 	   * linger too long in the cache.
 	   *
+	   * @note If the image is packed in a registered image atlas, the returned
+	   * image is an AtlasImage, whose surface is a view into a page shared with
+	   * the other images of that atlas (see registerImageAtlas). By default
+	   * only untrimmed packed images are registered, thus such a surface has
+	   * the same dimensions as the original image; if trimmed images were
+	   * accepted, the surface may be smaller, and must be blitted at the
+	   * offset returned by AtlasImage::getTrimOffset.
+	   *
 	   * @throw ResourceManagerException if the image could not be found.
 	   *
 	   */
@@ -384,6 +414,8 @@ namespace OSDL
 	   * The texture can be used directly, whereas the ID is to be used later to
 	   * discard it, once become useless.
 	   *
+	   * Such a texture is pinned, as it could not be loaded back once evicted.
+	   *
 	   * @see discardTexture
 	   *
 	   * @param sourceSurface the surface, whose ownership is taken, from which
@@ -462,6 +494,338 @@ namespace OSDL
 
 
 
+	  /**
+	   * Registers the images packed in the specified image atlas, so that
+	   * getImage returns for them views into the shared pages of that atlas,
+	   * instead of separate surfaces.
+	   *
+	   * Each packed image is registered under its name in the atlas, which is
+	   * expected to be the path of its original file: if that path is already
+	   * known to this manager (i.e. the original image is still listed in the
+	   * resource map), its identifier is kept and now designates the packed
+	   * image; otherwise a new identifier is allocated, and the image can be
+	   * requested by path.
+	   *
+	   * Images whose transparent borders were trimmed when packed (see the
+	   * '-t' option of imagesToOSDLAtlas) would be returned as smaller
+	   * surfaces, shifted by the trimmed borders; as callers of getImage
+	   * expect the dimensions of the original image, such images are skipped
+	   * (hence left to their original files, if listed in the resource map),
+	   * unless explicitly accepted.
+	   *
+	   * @note Atlases whose indexes are listed in the resource map (with the
+	   * 'image_atlas' content type) are registered automatically, once all
+	   * other resources are, without accepting trimmed images.
+	   *
+	   * @param indexPath the path of the index file of the atlas.
+	   *
+	   * @param convertToDisplayFormat tells whether the pages of the atlas
+	   * should be converted to the display format when loaded.
+	   *
+	   * @param acceptTrimmed tells whether trimmed images should be
+	   * registered as well, their users taking care of their trim offset.
+	   *
+	   * @return the number of images registered.
+	   *
+	   * @throw ResourceManagerException if the atlas could not be read.
+	   *
+	   * @see Video::TwoDimensional::ImageAtlas
+	   *
+	   */
+	  virtual Ceylan::Uint32 registerImageAtlas( const std::string & indexPath,
+		bool convertToDisplayFormat = false, bool acceptTrimmed = false ) ;
+
+
+
+	  /**
+	   * Describes how long the loading of a resource took.
+	   *
+	   * Resources loaded by a worker thread have their file read as a whole
+	   * before being decoded, hence both durations are known; for resources
+	   * loaded by the main thread, reading and decoding are interleaved, and
+	   * the total is recorded as the decoding duration.
+	   *
+	   * For prefetched musics and TrueType fonts, whose file is read by a
+	   * worker but opened by the main thread (on delivery for musics, on the
+	   * first getTrueTypeFont for fonts), that opening is recorded as the
+	   * decoding duration.
+	   *
+	   */
+	  struct LoadLatency
+	  {
+
+		/// Time spent reading the resource file, in microseconds.
+		Ceylan::System::Microsecond ioDuration ;
+
+		/// Time spent decoding the resource, in microseconds.
+		Ceylan::System::Microsecond decodeDuration ;
+
+		/// Tells whether the resource was loaded by a worker thread.
+		bool inBackground ;
+
+	  } ;
+
+
+
+	  /**
+	   * Requests the specified resources to be loaded ahead of their use, so
+	   * that the getters find them already loaded and return without stalling.
+	   *
+	   * The files of all resources are read by worker threads, which also
+	   * decode images and sounds, and decode textures into their internal
+	   * format. Only what their back-ends require from the main thread is left
+	   * to deliverPrefetched, which may install a few resources at a time:
+	   * the opening of musics (then streamed from memory), and the adoption of
+	   * the decoded content by each resource. Textures are uploaded to the
+	   * video card by getTexture, and TrueType fonts, whose opening depends on
+	   * the point size given to getTrueTypeFont, are opened by it from the
+	   * prefetched content.
+	   *
+	   * Packed images of atlases, and all resources on platforms lacking the
+	   * needed back-ends, are loaded by the main thread on delivery instead.
+	   *
+	   * Resources already loaded or already being prefetched are skipped.
+	   *
+	   * @param ids the identifiers of the resources to load.
+	   *
+	   * @return the number of resources whose prefetching was requested.
+	   *
+	   * @throw ResourceManagerException if an identifier is not known.
+	   *
+	   * @see deliverPrefetched, isReady, waitForPrefetched
+	   *
+	   */
+	  virtual Ceylan::Uint32 prefetch(
+		const std::list<Ceylan::ResourceID> & ids ) ;
+
+
+
+	  /**
+	   * Requests the resources whose paths are specified to be loaded ahead of
+	   * their use.
+	   *
+	   * @see prefetch
+	   *
+	   * @throw ResourceManagerException if a path is not known.
+	   *
+	   */
+	  virtual Ceylan::Uint32 prefetch( const std::list<std::string> & paths ) ;
+
+
+
+	  /**
+	   * Requests all the resources of the specified group to be loaded ahead of
+	   * their use.
+	   *
+	   * A resource belongs to a group if its entry in the resource map has a
+	   * 'group' setting naming that group (ex: '<group>level-1</group>'); it
+	   * may belong to any number of groups.
+	   *
+	   * @see prefetch
+	   *
+	   * @throw ResourceManagerException if the group is not known.
+	   *
+	   */
+	  virtual Ceylan::Uint32 prefetchGroup( const std::string & groupName ) ;
+
+
+
+	  /**
+	   * Installs the resources prefetched so far, so that their getters return
+	   * them directly. Meant to be called from the main thread, at a frame
+	   * boundary.
+	   *
+	   * The images and textures decoded by the workers are handed to their
+	   * instances, then the sounds, musics and fonts read by the workers, then
+	   * the resources to be loaded by the main thread are loaded.
+	   *
+	   * @param maxCount the maximum number of resources to install, so that
+	   * the cost of a frame can be bounded; zero means no limit.
+	   *
+	   * @return the number of resources installed by this call.
+	   *
+	   */
+	  virtual Ceylan::Uint32 deliverPrefetched( Ceylan::Uint32 maxCount = 0 ) ;
+
+
+
+	  /**
+	   * Waits until all the prefetched resources are loaded, or until the
+	   * specified timeout expires, and installs them.
+	   *
+	   * @param timeout the maximum duration to wait for the workers, in
+	   * milliseconds; resources loaded by the main thread are loaded
+	   * regardless of it.
+	   *
+	   * @return true iff no prefetched resource remains to be installed.
+	   *
+	   */
+	  virtual bool waitForPrefetched(
+		Ceylan::Uint32 timeout = WorkerPool::WaitIndefinitely ) ;
+
+
+
+	  /// Returns the number of prefetched resources not installed yet.
+	  virtual Ceylan::Uint32 getPrefetchingCount() const ;
+
+
+
+	  /**
+	   * Tells whether the specified resource is loaded, i.e. whether its getter
+	   * would return without loading it.
+	   *
+	   * @throw ResourceManagerException if the identifier is not known.
+	   *
+	   */
+	  virtual bool isReady( Ceylan::ResourceID id ) const ;
+
+
+
+	  /**
+	   * Returns how long the loading of the specified resource took.
+	   *
+	   * @param id the identifier of the resource.
+	   *
+	   * @param latency set to the durations of its last loading, if any.
+	   *
+	   * @return true iff the resource was loaded through this manager, in which
+	   * case latency has been set.
+	   *
+	   */
+	  virtual bool getLoadLatency( Ceylan::ResourceID id,
+		LoadLatency & latency ) const ;
+
+
+
+	  /**
+	   * Statistics about the caching of resources by this manager.
+	   *
+	   * Musics, being streamed, are not accounted in memory, unless they were
+	   * prefetched, and thus are streamed from an in-memory copy of their file.
+	   *
+	   */
+	  struct CacheStatistics
+	  {
+
+		/// Number of gets returning a resource already loaded.
+		Ceylan::Uint32 hits ;
+
+		/// Number of gets having to load their resource.
+		Ceylan::Uint32 misses ;
+
+		/// Number of resources unloaded to respect the memory budget.
+		Ceylan::Uint32 evictions ;
+
+		/// Memory taken by the in-memory copies of the loaded musics, in bytes.
+		Ceylan::System::Size musicBytes ;
+
+		/// Memory taken by the surfaces of the loaded images, in bytes.
+		Ceylan::System::Size imageBytes ;
+
+		/// Memory taken by the decoded samples of the loaded sounds, in bytes.
+		Ceylan::System::Size soundBytes ;
+
+		/// Memory taken by the surfaces of the loaded textures, in bytes.
+		Ceylan::System::Size textureBytes ;
+
+		/// Memory taken by the renderings cached by the loaded fonts, in bytes.
+		Ceylan::System::Size fontBytes ;
+
+	  } ;
+
+
+
+	  /**
+	   * Sets the memory budget of the resources of this manager, and evicts
+	   * resources immediately if it is exceeded.
+	   *
+	   * Whenever a get has to load its resource and the budget is exceeded,
+	   * resources are unloaded until the total fits again. Only resources
+	   * that are referenced by this manager only, that are not pinned, and
+	   * that can be loaded again from their file are evicted; among them,
+	   * the least recently used ones go first (CLOCK approximation of LRU:
+	   * each resource used since the previous sweep is given a second
+	   * chance).
+	   *
+	   * Evicted resources stay registered: their next get loads them again.
+	   *
+	   * @param budget the maximum memory taken by the loaded resources, in
+	   * bytes; zero means no limit, which is the default.
+	   *
+	   * @note The budget may be exceeded if the resources in use, or pinned,
+	   * take more memory than it allows.
+	   *
+	   */
+	  virtual void setMemoryBudget( Ceylan::System::Size budget ) ;
+
+
+
+	  /// Returns the memory budget, in bytes, zero meaning no limit.
+	  virtual Ceylan::System::Size getMemoryBudget() const ;
+
+
+
+	  /**
+	   * Returns the memory currently taken by the loaded resources of this
+	   * manager, in bytes.
+	   *
+	   * The size of a resource is accounted whenever it is got or loaded
+	   * through this manager, and refreshed whenever the eviction sweep
+	   * examines it; a resource unloaded directly by a user is thus only
+	   * discounted once swept.
+	   *
+	   * @see CacheStatistics for the details of what is accounted.
+	   *
+	   */
+	  virtual Ceylan::System::Size getMemoryFootprint() const ;
+
+
+
+	  /**
+	   * Evicts resources until the memory budget is respected, or until no
+	   * resource can be evicted any more.
+	   *
+	   * Gets call it automatically; it may be called also once references
+	   * onto resources have been released.
+	   *
+	   * @return the number of resources evicted by this call.
+	   *
+	   */
+	  virtual Ceylan::Uint32 enforceMemoryBudget() ;
+
+
+
+	  /**
+	   * Pins the specified resource, so that it is never evicted to respect
+	   * the memory budget.
+	   *
+	   * @throw ResourceManagerException if the identifier is not known.
+	   *
+	   */
+	  virtual void pin( Ceylan::ResourceID id ) ;
+
+
+
+	  /**
+	   * Unpins the specified resource, so that it can be evicted again.
+	   *
+	   * @throw ResourceManagerException if the identifier is not known.
+	   *
+	   */
+	  virtual void unpin( Ceylan::ResourceID id ) ;
+
+
+
+	  /// Tells whether the specified resource is pinned.
+	  virtual bool isPinned( Ceylan::ResourceID id ) const ;
+
+
+
+	  /// Returns the current caching statistics of this manager.
+	  virtual CacheStatistics getCacheStatistics() const ;
+
+
+
 	  /**
 	   * Discards permanently the specified texture entry from this manager.
 	   *
@@ -470,6 +834,10 @@ namespace OSDL
 	   * reloaded from file) and that we want nevertheless to be able to get rid
 	   * of, when finished with them, so that their memory can be released.
 	   *
+	   * A texture listed in a compiled index will be created again, from its
+	   * file, if it is got afterwards. Identifiers sharing the content of
+	   * this texture are discarded with it.
+	   *
 	   * @throw ResourceManagerException if not such resource exists.
 	   *
 	   */
@@ -546,6 +914,36 @@ namespace OSDL
 
 
 
+	  /**
+	   * Compiles the specified XML resource map into a binary resource index,
+	   * which can be given afterwards to the ResourceManager constructor
+	   * instead of the XML map, for a faster start-up.
+	   *
+	   * @param resourceMapFilename the filename of the XML resource map.
+	   *
+	   * @param indexFilename the filename of the index to write, which should
+	   * end with ResourceIndex::FileExtension.
+	   *
+	   * @param contentDirectory if not empty, the directory from which the
+	   * paths of the resources are relative, so that their contents are
+	   * hashed: resources of identical contents and types will then share
+	   * the same instance in the managers using this index. Contents of
+	   * equal hashes are compared byte per byte, so that a colliding content
+	   * is never shared.
+	   *
+	   * @return the number of resources compiled.
+	   *
+	   * @throw ResourceManagerException if the map could not be parsed or the
+	   * index could not be written.
+	   *
+	   */
+	  static Ceylan::Uint32 CompileResourceMap(
+		const std::string & resourceMapFilename,
+		const std::string & indexFilename,
+		const std::string & contentDirectory = "" ) ;
+
+
+
 
 	protected:
 
@@ -560,6 +958,74 @@ namespace OSDL
 
 
 
+	  /**
+	   * Creates the (unloaded) resource of specified identifier, path and
+	   * type, whatever the map it was read from.
+	   *
+	   * If a resource of the same type and of the same (non-null) content
+	   * hash is already registered, no resource is created: the identifier
+	   * designates that resource instead. Such hashes come only from indexes
+	   * compiled by CompileResourceMap, which confirmed that the contents of
+	   * equal hashes are identical.
+	   *
+	   */
+	  void registerEntry( Ceylan::ResourceID id,
+		const std::string & resourcePath, ContentType resourceType,
+		Ceylan::Uint64 contentHash ) ;
+
+
+
+	  /**
+	   * Looks-up the resource identifier corresponding to specified path, in
+	   * the index if any, otherwise in the reverse map.
+	   *
+	   * @return true iff the path was found, then id is set.
+	   *
+	   */
+	  bool findIDForPath( const std::string & resourcePath,
+		Ceylan::ResourceID & id ) const ;
+
+
+
+	  /**
+	   * Looks-up the path of the resource of specified identifier.
+	   *
+	   * @return true iff the identifier was found, then resourcePath is set.
+	   *
+	   */
+	  bool findPathFor( Ceylan::ResourceID id,
+		std::string & resourcePath ) const ;
+
+
+
+	  /**
+	   * Returns the identifier of the resource whose instance is used for
+	   * the specified one, i.e. the identifier itself unless its content is
+	   * shared with another resource.
+	   *
+	   */
+	  Ceylan::ResourceID getContentOwner( Ceylan::ResourceID id ) const ;
+
+
+
+	  /**
+	   * Returns the identifier of the resource whose instance is to be used
+	   * for the specified one, creating first that resource if it is listed
+	   * in the compiled index yet was not used so far.
+	   *
+	   * @note Unknown identifiers are returned as they are, for the caller to
+	   * report them.
+	   *
+	   */
+	  Ceylan::ResourceID resolveResource( Ceylan::ResourceID id ) ;
+
+
+
+	  /// Tells whether a resource is registered with the specified identifier.
+	  bool isRegistered( Ceylan::ResourceID id ) const ;
+
+
+
 	  /**
 	   * Returns the resource identifier corresponding to specified path, based
 	   * on the reverse resource map.
@@ -580,6 +1046,193 @@ namespace OSDL
 
 
 
+	  /**
+	   * Reads the specified XML resource entry, shared by the constructor and
+	   * by CompileResourceMap.
+	   *
+	   * @param entry the entry to fill.
+	   *
+	   * @param groupNames the list to which the groups of this resource are
+	   * added.
+	   *
+	   * @throw ResourceManagerException if the entry is not valid.
+	   *
+	   */
+	  static void ParseResourceEntry(
+		const Ceylan::XML::XMLParser::XMLTree & resourceXMLEntry,
+		ResourceIndex::Entry & entry, std::list<std::string> & groupNames ) ;
+
+
+
+	  /**
+	   * Returns the hash of the content of the specified resource file.
+	   *
+	   * @throw ResourceManagerException if the file could not be read.
+	   *
+	   */
+	  static Ceylan::Uint64 HashResourceContent(
+		const std::string & resourceFilename ) ;
+
+
+
+	  /**
+	   * Creates, if not already done, the workers and the image loader used for
+	   * prefetching.
+	   *
+	   * @return the image loader, or null if images cannot be decoded in the
+	   * background on this platform.
+	   *
+	   */
+	  Video::TwoDimensional::AsyncImageLoader * getPrefetchLoader() ;
+
+
+
+	  /**
+	   * Creates, if not already done, the workers used for prefetching.
+	   *
+	   */
+	  WorkerPool & getPrefetchPool() ;
+
+
+
+	  /**
+	   * Returns the pixel format textures are decoded to by the prefetch
+	   * loader, i.e. their internal one.
+	   *
+	   */
+	  const Video::Pixels::PixelFormat & getTextureFormat() ;
+
+
+
+	  /**
+	   * Tells whether the specified resource is being prefetched, i.e. is
+	   * waiting to be installed by deliverPrefetched or, for a font whose
+	   * content is installed, to be opened by getTrueTypeFont.
+	   *
+	   */
+	  bool isPrefetching( Ceylan::ResourceID id ) const ;
+
+
+
+	  /**
+	   * Hands to their Image and GLTexture instances the prefetched images and
+	   * textures decoded so far.
+	   *
+	   * @return the number of images and textures installed.
+	   *
+	   */
+	  Ceylan::Uint32 deliverPrefetchedImages( Ceylan::Uint32 maxCount ) ;
+
+
+
+	  /**
+	   * Hands to their instances the prefetched sounds, musics and fonts read
+	   * (and, for sounds, decoded) so far.
+	   *
+	   * @return the number of resources installed.
+	   *
+	   */
+	  Ceylan::Uint32 deliverPrefetchedResources( Ceylan::Uint32 maxCount ) ;
+
+
+
+	  /**
+	   * Waits for the prefetching of the specified image or texture to be
+	   * over, if it is being prefetched, and installs it.
+	   *
+	   */
+	  void completeImagePrefetch( Ceylan::ResourceID id ) ;
+
+
+
+	  /**
+	   * Waits for the prefetching of the specified sound, music or font to be
+	   * over, if it is being prefetched, and installs it.
+	   *
+	   */
+	  void completeResourcePrefetch( Ceylan::ResourceID id ) ;
+
+
+
+	  /**
+	   * Ensures the specified font is loaded at the specified point size,
+	   * opening it from its prefetched content if any, and records that get.
+	   *
+	   */
+	  void loadFont( Ceylan::ResourceID id,
+		Video::TwoDimensional::Text::TrueTypeFontCountedPtr & font,
+		Video::TwoDimensional::Text::PointSize pointSize ) ;
+
+
+
+	  /// Records the durations of a loading performed by the main thread.
+	  void recordLatency( Ceylan::ResourceID id,
+		Ceylan::System::Microsecond duration ) ;
+
+
+
+	  /**
+	   * Records a get of the specified resource, and enforces the memory
+	   * budget if the resource had to be loaded.
+	   *
+	   * @param hit tells whether the resource was already loaded.
+	   *
+	   */
+	  void recordAccess( Ceylan::ResourceID id, bool hit ) ;
+
+
+
+	  /**
+	   * Makes the specified loaded resource a candidate for eviction, as a
+	   * recently used one, and accounts its current size.
+	   *
+	   */
+	  void trackLoaded( Ceylan::ResourceID id ) ;
+
+
+
+	  /**
+	   * Updates the memory accounted for the specified resource, and the
+	   * total of its type, to its current size (zero if not loaded).
+	   *
+	   */
+	  void accountSize( Ceylan::ResourceID id ) ;
+
+
+
+	  /**
+	   * Stops accounting the memory of the specified resource, which is
+	   * unloaded or about to be removed.
+	   *
+	   */
+	  void discountSize( Ceylan::ResourceID id ) ;
+
+
+
+	  /**
+	   * Returns the total memory, in the statistics, of the resources of the
+	   * specified type.
+	   *
+	   */
+	  Ceylan::System::Size & getAccountedBytesOf( ContentType type ) ;
+
+
+
+	  /**
+	   * Tells whether the specified resource is loaded and, if yes, returns
+	   * its size in memory, its reference count and its type.
+	   *
+	   */
+	  bool getLoadedState( Ceylan::ResourceID id, Ceylan::System::Size & size,
+		Ceylan::Uint32 & referenceCount, ContentType & type ) const ;
+
+
+
+	  /// Unloads the content of the specified resource, which stays registered.
+	  void unloadResource( Ceylan::ResourceID id ) ;
+
+
+
 	  // Variable section.
 
 
@@ -711,6 +1364,138 @@ namespace OSDL
 	  std::map<std::string,Ceylan::ResourceID> _reverseMap ;
 
 
+
+	  /// The image atlases registered, shared with their packed images.
+	  std::list<Video::TwoDimensional::ImageAtlasCountedPtr> _atlases ;
+
+
+
+	  /**
+	   * The paths of the atlas indexes listed in the resource map, to be
+	   * registered once all other resources are (only used while the manager
+	   * is being constructed).
+	   *
+	   */
+	  std::list<std::string> _pendingAtlasPaths ;
+
+
+
+	  /**
+	   * The groups defined in the resource map: each key is a group name,
+	   * each value lists the identifiers of its resources.
+	   *
+	   */
+	  std::map<std::string, std::list<Ceylan::ResourceID> > _groups ;
+
+
+
+	  /**
+	   * The resources sharing the instance of a resource of identical content:
+	   * each key is the identifier of such a resource, each value is the
+	   * identifier of the resource whose instance is used.
+	   *
+	   */
+	  std::map<Ceylan::ResourceID, Ceylan::ResourceID> _sharedContents ;
+
+
+	  /**
+	   * The first resource registered for each content hash and type (only
+	   * used while the manager is being constructed, unless it was created
+	   * from a compiled index, whose resources are registered when first
+	   * used).
+	   *
+	   */
+	  std::map< std::pair<Ceylan::Uint64, ContentType>, Ceylan::ResourceID >
+		_contentOwners ;
+
+
+
+	  /**
+	   * The images and textures being prefetched: each key is the handle of a
+	   * request of the prefetch loader, each value is the identifier of the
+	   * image or texture.
+	   *
+	   */
+	  std::map<Video::TwoDimensional::AsyncImageLoader::Handle,
+		Ceylan::ResourceID> _imagePrefetches ;
+
+
+	  /**
+	   * The prefetch loader handles of the images and textures being
+	   * prefetched, by resource.
+	   *
+	   */
+	  std::map<Ceylan::ResourceID,
+		Video::TwoDimensional::AsyncImageLoader::Handle> _imagePrefetchHandles ;
+
+
+	  /**
+	   * The jobs reading the sounds, musics and fonts being prefetched, owned,
+	   * by resource.
+	   *
+	   */
+	  std::map<Ceylan::ResourceID, ResourcePrefetchJob *> _resourcePrefetches ;
+
+
+	  /**
+	   * The fonts whose prefetched content is held, until their first opening
+	   * by getTrueTypeFont: each key is the identifier of the font, each value
+	   * the path its content is shared under.
+	   *
+	   */
+	  std::map<Ceylan::ResourceID, std::string> _heldFontContents ;
+
+
+
+	  /**
+	   * The resources to be loaded by the main thread on delivery, in request
+	   * order.
+	   *
+	   */
+	  std::list<Ceylan::ResourceID> _mainThreadPrefetches ;
+
+
+
+	  /// The durations of the last loading of each resource.
+	  std::map<Ceylan::ResourceID, LoadLatency> _latencies ;
+
+
+
+	  /**
+	   * The loaded resources that may be evicted, in the order the clock hand
+	   * sweeps them.
+	   *
+	   */
+	  std::list<Ceylan::ResourceID> _clock ;
+
+
+	  /// The next resource to be examined for eviction.
+	  std::list<Ceylan::ResourceID>::iterator _clockHand ;
+
+
+	  /**
+	   * The resources in the clock, each associated to its reference bit, set
+	   * whenever it is used, cleared when the hand passes over it.
+	   *
+	   */
+	  std::map<Ceylan::ResourceID, bool> _clockReferences ;
+
+
+	  /// The resources never to be evicted.
+	  std::set<Ceylan::ResourceID> _pinned ;
+
+
+	  /**
+	   * The loaded resources whose memory is accounted in the statistics,
+	   * each associated to its type and to its accounted size, so that the
+	   * totals are updated per resource rather than recomputed.
+	   *
+	   */
+	  std::map< Ceylan::ResourceID,
+		std::pair<ContentType, Ceylan::System::Size> > _accountedSizes ;
+
+
+
 #pragma warning( pop )
 
 
@@ -725,6 +1510,42 @@ namespace OSDL
 
 
 
+	  /**
+	   * The worker threads loading prefetched resources, owned, created on the
+	   * first prefetch.
+	   *
+	   */
+	  WorkerPool * _prefetchPool ;
+
+
+
+	  /// The loader decoding prefetched images, owned, if any.
+	  Video::TwoDimensional::AsyncImageLoader * _prefetchLoader ;
+
+
+	  /**
+	   * A surface, owned, just holding the pixel format prefetched textures are
+	   * decoded to, if any.
+	   *
+	   */
+	  Video::Surface * _textureFormatHolder ;
+
+
+
+	  /// The memory budget of the loaded resources, in bytes, if not null.
+	  Ceylan::System::Size _memoryBudget ;
+
+
+	  /// The caching counters, and the memory totals per resource type.
+	  CacheStatistics _statistics ;
+
+
+
+	  /// The compiled resource map this manager was created from, owned, if any.
+	  ResourceIndex * _index ;
+
+
+
 	private:
 
 
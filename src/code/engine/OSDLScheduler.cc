@@ -28,6 +28,8 @@
 
 #include "OSDLBasic.h"                  // for getExistingCommonModule
 #include "OSDLVideo.h"                  // for redraw
+#include "OSDLPaletteAnimator.h"        // for PaletteAnimator
+#include "OSDLFrameCapturer.h"          // for FrameCapturer
 #include "OSDLRenderer.h"               // for Renderer
 #include "OSDLActiveObject.h"           // for ActiveObject
 #include "OSDLPeriodicalActiveObject.h" // for PeriodicalActiveObject
@@ -189,6 +191,45 @@ void Scheduler::setRenderer( Rendering::Renderer & newRenderer )
 
 
 
+void Scheduler::registerPaletteAnimator( Video::PaletteAnimator & animator )
+{
+
+	for ( list<Video::PaletteAnimator *>::const_iterator it =
+			_paletteAnimators.begin(); it != _paletteAnimators.end(); it++ )
+		if ( *it == & animator )
+			throw SchedulingException( "Scheduler::registerPaletteAnimator "
+				"failed: animator already registered." ) ;
+
+	_paletteAnimators.push_back( & animator ) ;
+
+}
+
+
+
+void Scheduler::unregisterPaletteAnimator( Video::PaletteAnimator & animator )
+{
+
+	for ( list<Video::PaletteAnimator *>::iterator it =
+			_paletteAnimators.begin(); it != _paletteAnimators.end(); it++ )
+	{
+
+		if ( *it == & animator )
+		{
+
+			_paletteAnimators.erase( it ) ;
+			return ;
+
+		}
+
+	}
+
+	throw SchedulingException( "Scheduler::unregisterPaletteAnimator "
+		"failed: animator was not registered." ) ;
+
+}
+
+
+
 void Scheduler::setScreenshotMode( bool on, const string & frameFilenamePrefix,
 	Hertz frameFrequency )
 {
@@ -199,6 +240,53 @@ void Scheduler::setScreenshotMode( bool on, const string & frameFilenamePrefix,
 	_screenshotMode = on ;
 	_frameFilenamePrefix = frameFilenamePrefix ;
 
+	if ( on )
+	{
+
+		if ( _frameCapturer == 0 )
+		{
+
+			try
+			{
+
+				_frameCapturer = new Video::FrameCapturer(
+					Video::FrameCapturer::PNGFormat, /* maxQueuedFrames */ 4,
+					Video::FrameCapturer::WaitOnOverflow ) ;
+
+			}
+			catch( const Video::VideoException & e )
+			{
+
+				throw SchedulingException( "Scheduler::setScreenshotMode "
+					"failed: " + e.toString() ) ;
+
+			}
+
+		}
+
+		// One rendering per movie frame:
+		setScreenshotFrequency( frameFrequency ) ;
+		setRenderingFrequency( frameFrequency ) ;
+
+	}
+	else if ( _frameCapturer != 0 )
+	{
+
+		// Waits for the frames still being encoded:
+		delete _frameCapturer ;
+		_frameCapturer = 0 ;
+
+	}
+
+}
+
+
+
+Video::FrameCapturer * Scheduler::getFrameCapturer() const
+{
+
+	return _frameCapturer ;
+
 }
 
 
@@ -1080,6 +1168,9 @@ const string Scheduler::toString( Ceylan::VerbosityLevels level ) const
 				( _screenshotPeriod * _engineTickDuration ), /* precision */ 2 )
 			+ " frames per second" ;
 
+		if ( _frameCapturer != 0 )
+			buf << ". " + _frameCapturer->toString( level ) ;
+
 		// No simulation nor rendering tick can be missed in screenshot mode.
 		return buf.str() ;
 	}
@@ -1282,6 +1373,8 @@ void Scheduler::StopExistingScheduler()
 
 Scheduler::Scheduler():
 	_screenshotMode( false ),
+	_frameFilenamePrefix(),
+	_frameCapturer( 0 ),
 	_desiredScreenshotFrequency( DefaultMovieFrameFrequency ),
 	_screenshotPeriod( 0 ),
 	_periodicSlots(),
@@ -1320,7 +1413,8 @@ Scheduler::Scheduler():
 	_scheduleFailureCount( 0 ),
 	_eventsModule( 0 ),
 	_renderer( 0 ),
-	_videoModule( 0 )
+	_videoModule( 0 ),
+	_paletteAnimators()
 {
 
 	_subSecondSleepsAvailable = Ceylan::System::areSubSecondSleepsAvailable() ;
@@ -1361,6 +1455,10 @@ Scheduler::~Scheduler() throw()
 	if ( _renderer != 0 )
 		delete _renderer ;
 
+	// Waits for the last frames to be written:
+	if ( _frameCapturer != 0 )
+		delete _frameCapturer ;
+
 	send( "Scheduler deleted." ) ;
 
 }
@@ -3758,6 +3856,11 @@ void Scheduler::scheduleRendering( RenderingTick current )
 
 	OSDL_SCHEDULE_LOG( "--- rendering!" ) ;
 
+	// Palette updates involve no pixel write, they just precede rendering:
+	for ( list<Video::PaletteAnimator *>::iterator it =
+			_paletteAnimators.begin(); it != _paletteAnimators.end(); it++ )
+		(*it)->animate( current ) ;
+
 	if ( _renderer != 0 )
 		_renderer->render( current ) ;
 	else
@@ -3772,6 +3875,32 @@ void Scheduler::scheduleRendering( RenderingTick current )
 
 	}
 
+	/*
+	 * Only the copy of the screen is done here, the encoding is performed
+	 * while the next ticks are scheduled:
+	 *
+	 */
+	if ( _screenshotMode && _frameCapturer != 0 )
+	{
+
+		try
+		{
+
+			_frameCapturer->captureScreen( _frameFilenamePrefix + "-"
+				+ Ceylan::toString( current )
+				+ _frameCapturer->getFileExtension() ) ;
+
+		}
+		catch( const Video::VideoException & e )
+		{
+
+			throw SchedulingException( "Scheduler::scheduleRendering: "
+				"unable to capture frame: " + e.toString() ) ;
+
+		}
+
+	}
+
 	OSDL_SCHEDULE_LOG( "--- rendered!" ) ;
 
 }
@@ -86,6 +86,14 @@ namespace OSDL
 		 */
 		class VideoModule ;
 
+
+		// The scheduler may animate palettes on rendering ticks.
+		class PaletteAnimator ;
+
+
+		// The scheduler captures rendered frames in screenshot mode.
+		class FrameCapturer ;
+
 	}
 
 
@@ -344,6 +352,36 @@ namespace OSDL
 
 
 
+				/**
+				 * Registers specified palette animator, so that it is animated
+				 * on each rendering tick, just before the rendering itself.
+				 *
+				 * @param animator the palette animator to register. Ownership
+				 * is not taken, it must be unregistered before being
+				 * deallocated.
+				 *
+				 * @throw SchedulingException if the animator was already
+				 * registered.
+				 *
+				 */
+				virtual void registerPaletteAnimator(
+					Video::PaletteAnimator & animator ) ;
+
+
+
+				/**
+				 * Unregisters specified palette animator, which will not be
+				 * animated anymore.
+				 *
+				 * @throw SchedulingException if the animator was not
+				 * registered.
+				 *
+				 */
+				virtual void unregisterPaletteAnimator(
+					Video::PaletteAnimator & animator ) ;
+
+
+
 				/**
 				 * Tells whether the application should run interactively, in
 				 * real time (if <b>on</b> is false), or if it should run in
@@ -369,15 +407,24 @@ namespace OSDL
 				 * animation.
 				 *
 				 * @param frameFrequency tells how many frames should be
-				 * rendered each second.
+				 * rendered each second; the rendering frequency is set
+				 * accordingly.
 				 *
 				 * At least 25 frames per second is recommended to be able to
 				 * generate smooth animations.
 				 *
+				 * The screen is captured after each rendering, and the frames
+				 * are written by a background FrameCapturer (with a fast PNG
+				 * compression), so that the scheduling goes on while the
+				 * previous frames are being encoded. Turning the mode off waits
+				 * for all captured frames to be written.
+				 *
 				 * @see OSDL user's guide to know how to simply create a MPEG
 				 * video out of the set of image files that is produced in
 				 * screenshot mode.
 				 *
+				 * @see getFrameCapturer
+				 *
 				 */
 				virtual void setScreenshotMode( bool on,
 					const std::string & frameFilenamePrefix,
@@ -385,6 +432,16 @@ namespace OSDL
 
 
 
+				/**
+				 * Returns the frame capturer used in screenshot mode, so that
+				 * its settings (ex: PNG compression level) can be changed and
+				 * its statistics read, or null if screenshot mode is off.
+				 *
+				 */
+				virtual Video::FrameCapturer * getFrameCapturer() const ;
+
+
+
 				/**
 				 * Defines how many microseconds an engine tick should last, and
 				 * updates accordingly the simulation and rendering ticks.
@@ -1288,6 +1345,15 @@ namespace OSDL
 
 
 
+				/**
+				 * The capturer writing the frames in screenshot mode, owned,
+				 * if any.
+				 *
+				 */
+				Video::FrameCapturer * _frameCapturer ;
+
+
+
 				/**
 				 * Records the user-defined screenshot frequency, which is the
 				 * targeted number of frames per second.
@@ -1755,6 +1821,15 @@ namespace OSDL
 
 
 
+				/**
+				 * The palette animators to animate on each rendering tick,
+				 * not owned.
+				 *
+				 */
+				std::list<Video::PaletteAnimator *> _paletteAnimators ;
+
+
+
 				/**
 				 * Tells whether sub-second sleeps can be used, to avoid
 				 * monopolizing the CPU.
@@ -23,6 +23,16 @@ Ex: `basename $0` myArchive.oar content-directory [my-resource-map]"
 #use_lzma=0
 use_lzma=1
 
+# Set to 1 (here or in the environment) to produce instead an indexed archive,
+# whose members can be read from any position without being decompressed from
+# their start, and which is built in parallel by buildOSDLArchive.exe:
+use_indexed=${use_indexed:-0}
+
+# Indexed archives can only be mounted by an OSDL built against PhysicsFS 3.0
+# or later; set to 1 to build one nevertheless (ex: for a target platform whose
+# OSDL differs from the local one), with only a warning:
+force_indexed=${force_indexed:-0}
+
 
 # Returns a cyphered version (currently rot13) of specified name.
 # Source: http://www.miranda.org/~jkominek/rot13/sh/rot13-tr.sh
@@ -96,9 +106,27 @@ if [ ! -x "${cypher_exec}" ] ; then
 fi
 
 
+# Compiles the XML resource map into a binary index, in the same directory:
+compiler_tool="compileOSDLResourceMap.exe"
+
+compiler_exec=`PATH=$PWD/$cypher_dir:$PATH which $compiler_tool 2>/dev/null`
+
+
+if [ ! -x "${compiler_exec}" ] ; then
+
+	echo "Error, no executable resource map compiler ${compiler_tool} found (were the OSDL tools compiled?)." 1>&2
+	exit 14
+
+fi
+
+
 # zip might be used instead, for the purpose of testing/fixing LZMA (with 7zr):
 
-if [ $use_lzma -eq 0 ] ; then
+if [ $use_indexed -eq 1 ] ; then
+
+	archiver_name="buildOSDLArchive.exe"
+
+elif [ $use_lzma -eq 0 ] ; then
 
 	archiver_name="7zr"
 
@@ -109,7 +137,7 @@ else
 fi
 
 
-archiver=`which ${archiver_name}`
+archiver=`PATH=$PWD/$cypher_dir:$PATH which ${archiver_name}`
 
 if [ ! -x "${archiver}" ] ; then
 
@@ -118,6 +146,26 @@ if [ ! -x "${archiver}" ] ; then
 
 fi
 
+
+if [ $use_indexed -eq 1 ] ; then
+
+	if ! ${archiver} --nullPlug --check-mountable 1>/dev/null 2>&1 ; then
+
+		if [ $force_indexed -eq 1 ] ; then
+
+			echo "Warning: this OSDL is not built against PhysicsFS 3.0 or later, hence will not be able to mount the indexed archive ${archive_target}." 1>&2
+
+		else
+
+			echo "Error, this OSDL is not built against PhysicsFS 3.0 or later, hence could not mount an indexed archive; rebuild OSDL against PhysicsFS 3, unset use_indexed, or set force_indexed=1 to build it nevertheless." 1>&2
+			exit 31
+
+		fi
+
+	fi
+
+fi
+
 indexer_name="resource_indexer.sh"
 
 # Needed to locate the indexer:
@@ -201,77 +249,110 @@ fi
 ${CP} ../${index_basename}.xml .
 
 
+# Then compile it, so that ResourceManager does not have to parse XML, hashing
+# the (not cyphered yet) resources so that identical ones share an instance:
+${compiler_exec} --nullPlug --hash-from . ../${index_basename}.xml ../${index_basename}.osdl.index
 
-# Then obfuscate filenames as well:
-files=`${FIND} . -type f`
+if [ ! $? -eq 0	] ; then
 
-for f in $files; do
+	echo "Error, compilation of resource index failed." 1>&2
+	exit 16
 
-	# Now let's cypher the content of files in the temporary directory:
-	${cypher_exec} --nullPlug $f
-	if [ ! $? -eq 0 ] ; then
+fi
 
-		echo "Error, cyphering of file '$f' with tool '${cypher_exec}' failed." 1>&2
-		exit 20
+${CP} ../${index_basename}.osdl.index .
 
-	fi
 
-	base_dir=`dirname $f`
-	filename=`basename $f`
-	cypher_name $filename
-	new_path=$base_dir/$res
-	echo "  File $f renamed into $new_path"
-	/bin/mv $f $new_path
+if [ $use_indexed -eq 1 ] ; then
 
-done
+	# Cyphers names and contents by itself, with one worker per core:
+	${archiver} --nullPlug . ../${archive_target}
 
+else
 
-# Finally the directories
-# (depth first, as otherwise the cached entries would not match):
+	# Then obfuscate filenames as well:
+	files=`${FIND} . -type f`
 
-# Do not want to scramble the archive base directory:
-directories=`${FIND} . -depth -type d`
+	for f in $files; do
 
-for d in $directories; do
+		# Now let's cypher the content of files in the temporary directory:
+		${cypher_exec} --nullPlug $f
+		if [ ! $? -eq 0 ] ; then
 
-	if [ ! $d = "." ] ; then
+			echo "Error, cyphering of file '$f' with tool '${cypher_exec}' failed." 1>&2
+			exit 20
 
-		base_dir=`dirname $d`
-		dir_name=`basename $d`
-		cypher_name $dir_name
+		fi
+
+		base_dir=`dirname $f`
+		filename=`basename $f`
+		cypher_name $filename
 		new_path=$base_dir/$res
-		echo "  Directory $d renamed into $new_path"
-		/bin/mv $d $new_path
+		echo "  File $f renamed into $new_path"
+		/bin/mv $f $new_path
 
-	fi
+	done
 
-done
 
+	# Finally the directories
+	# (depth first, as otherwise the cached entries would not match):
 
-echo
+	# Do not want to scramble the archive base directory:
+	directories=`${FIND} . -depth -type d`
 
-# OAR archives are based on the Lempel-Ziv-Markov chain-Algorithm (LZMA).
-# See: http://en.wikipedia.org/wiki/Lempel-Ziv-Markov_chain_algorithm
-# On Debian-based distributions, use: 'apt-get install p7zip' to have the
-# archiver.
-# The lzma package is not enough, as it compresses only files, not filesystem
-# full trees.
+	for d in $directories; do
 
+		if [ ! $d = "." ] ; then
 
-# From ${archive_directory_name}:
+			base_dir=`dirname $d`
+			dir_name=`basename $d`
+			cypher_name $dir_name
+			new_path=$base_dir/$res
+			echo "  Directory $d renamed into $new_path"
+			/bin/mv $d $new_path
 
-if [ $use_lzma -eq 0 ] ; then
+		fi
 
-	# For 7zr:
-	#LANG= ${archiver} a ../${archive_target} * 1>/dev/null
+	done
 
-	# or (best compression):
-	LANG= ${archiver} a -t7z -mx=9 ../${archive_target} * 1>/dev/null
 
-else
+	echo
+
+	# OAR archives are based on the Lempel-Ziv-Markov chain-Algorithm (LZMA).
+	# See: http://en.wikipedia.org/wiki/Lempel-Ziv-Markov_chain_algorithm
+	# On Debian-based distributions, use: 'apt-get install p7zip' to have the
+	# archiver.
+	# The lzma package is not enough, as it compresses only files, not filesystem
+	# full trees.
+
 
-	# For zip:
-	LANG= ${archiver} -r ../${archive_target} *
+	# From ${archive_directory_name}:
+
+	if [ $use_lzma -eq 0 ] ; then
+
+		# For 7zr:
+		#LANG= ${archiver} a ../${archive_target} * 1>/dev/null
+
+		# or (best compression):
+		LANG= ${archiver} a -t7z -mx=9 ../${archive_target} * 1>/dev/null
+
+	else
+
+		# For zip, already compressed media, and raw images (meant to be
+		# memory-mapped by ContentSpan), are stored as they are; their names are
+		# cyphered by now:
+		stored_suffixes=""
+
+		for suffix in png jpg jpeg ogg mp3 raw; do
+
+			cypher_name $suffix
+			stored_suffixes="${stored_suffixes}:.${res}"
+
+		done
+
+		LANG= ${archiver} -r -n ${stored_suffixes#:} ../${archive_target} *
+
+	fi
 
 fi
 
@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDLColorHistogram.h"
+
+#include "OSDLSurface.h"             // for Surface
+
+
+#ifdef OSDL_USES_CONFIG_H
+#include <OSDLConfig.h>              // for OSDL_USES_SDL and al
+#endif // OSDL_USES_CONFIG_H
+
+
+#if OSDL_ARCH_NINTENDO_DS
+#include "OSDLConfigForNintendoDS.h" // for OSDL_USES_SDL and al
+#endif // OSDL_ARCH_NINTENDO_DS
+
+
+#if OSDL_USES_SDL_IMAGE
+#include "SDL_image.h"               // for IMG_Load and al
+#endif // OSDL_USES_SDL_IMAGE
+
+
+
+using std::string ;
+
+using namespace OSDL::Video ;
+using namespace OSDL::Video::Pixels ;
+
+
+
+// 5 bits for red and blue, 6 bits for green:
+const Ceylan::Uint32 ColorHistogram::BinCount = 32 * 64 * 32 ;
+
+
+
+/// Returns the index of the bin corresponding to specified color.
+static Ceylan::Uint32 GetBinFor( const ColorDefinition & color )
+{
+
+	return ( static_cast<Ceylan::Uint32>( color.r >> 3 ) << 11 )
+		| ( static_cast<Ceylan::Uint32>( color.g >> 2 ) << 5 )
+		| static_cast<Ceylan::Uint32>( color.b >> 3 ) ;
+
+}
+
+
+
+ColorHistogram::ColorHistogram() :
+	_bins( 0 ),
+	_pixelCount( 0 )
+{
+
+	_bins = new Bin[ BinCount ] ;
+
+	clear() ;
+
+}
+
+
+
+ColorHistogram::~ColorHistogram() throw()
+{
+
+	delete [] _bins ;
+
+}
+
+
+
+void ColorHistogram::addColor( const ColorDefinition & color,
+	Ceylan::Float64 weight )
+{
+
+	Bin & bin = _bins[ GetBinFor( color ) ] ;
+
+	bin.count    += weight ;
+	bin.redSum   += weight * color.r ;
+	bin.greenSum += weight * color.g ;
+	bin.blueSum  += weight * color.b ;
+
+	_pixelCount += weight ;
+
+}
+
+
+
+void ColorHistogram::addSurface( const Surface & surface, bool skipColorkey )
+{
+
+	PixelColor colorkey = 0 ;
+
+	if ( skipColorkey )
+	{
+
+		try
+		{
+
+			colorkey = surface.guessColorKey() ;
+
+		}
+		catch( const VideoException & e )
+		{
+
+			// No colorkey, nothing to skip:
+			skipColorkey = false ;
+
+		}
+
+	}
+
+	const PixelFormat & format = surface.getPixelFormat() ;
+
+	Length width  = surface.getWidth() ;
+	Length height = surface.getHeight() ;
+
+	PixelColor current ;
+
+	for ( Length y = 0; y < height; y++ )
+		for ( Length x = 0; x < width; x++ )
+		{
+
+			current = surface.getPixelColorAt( x, y ) ;
+
+			if ( skipColorkey && Pixels::areEqual( current, colorkey ) )
+				continue ;
+
+			ColorDefinition colorDef =
+				Pixels::convertPixelColorToColorDefinition( format, current ) ;
+
+			if ( colorDef.unused == AlphaTransparent )
+				continue ;
+
+			addColor( colorDef ) ;
+
+		}
+
+}
+
+
+
+void ColorHistogram::addImage( const string & imageFilename,
+	bool skipColorkey )
+{
+
+#if OSDL_USES_SDL_IMAGE
+
+	LowLevelSurface * image = IMG_Load( imageFilename.c_str() ) ;
+
+	if ( image == 0 )
+		throw VideoException( "ColorHistogram::addImage failed: "
+			"unable to load '" + imageFilename + "': "
+			+ string( IMG_GetError() ) ) ;
+
+	// The wrapper only reads the surface, and frees it when going out of scope:
+	Surface wrapper( * image ) ;
+
+	addSurface( wrapper, skipColorkey ) ;
+
+#else // OSDL_USES_SDL_IMAGE
+
+	throw VideoException( "ColorHistogram::addImage failed: "
+		"no SDL_image support available" ) ;
+
+#endif // OSDL_USES_SDL_IMAGE
+
+}
+
+
+
+void ColorHistogram::merge( const ColorHistogram & other )
+{
+
+	for ( Ceylan::Uint32 i = 0; i < BinCount; i++ )
+	{
+
+		_bins[i].count    += other._bins[i].count ;
+		_bins[i].redSum   += other._bins[i].redSum ;
+		_bins[i].greenSum += other._bins[i].greenSum ;
+		_bins[i].blueSum  += other._bins[i].blueSum ;
+
+	}
+
+	_pixelCount += other._pixelCount ;
+
+}
+
+
+
+void ColorHistogram::clear()
+{
+
+	for ( Ceylan::Uint32 i = 0; i < BinCount; i++ )
+	{
+
+		_bins[i].count    = 0 ;
+		_bins[i].redSum   = 0 ;
+		_bins[i].greenSum = 0 ;
+		_bins[i].blueSum  = 0 ;
+
+	}
+
+	_pixelCount = 0 ;
+
+}
+
+
+
+Ceylan::Float64 ColorHistogram::getPixelCount() const
+{
+
+	return _pixelCount ;
+
+}
+
+
+
+Ceylan::Uint32 ColorHistogram::getUsedBinCount() const
+{
+
+	Ceylan::Uint32 res = 0 ;
+
+	for ( Ceylan::Uint32 i = 0; i < BinCount; i++ )
+		if ( _bins[i].count > 0 )
+			res++ ;
+
+	return res ;
+
+}
+
+
+
+void ColorHistogram::getSamples( std::vector<ColorSample> & samples ) const
+{
+
+	samples.clear() ;
+
+	ColorSample sample ;
+	sample.color.unused = AlphaOpaque ;
+
+	for ( Ceylan::Uint32 i = 0; i < BinCount; i++ )
+	{
+
+		const Bin & bin = _bins[i] ;
+
+		if ( bin.count == 0 )
+			continue ;
+
+		// Rounded averages:
+		sample.color.r = static_cast<ColorElement>(
+			bin.redSum / bin.count + 0.5 ) ;
+
+		sample.color.g = static_cast<ColorElement>(
+			bin.greenSum / bin.count + 0.5 ) ;
+
+		sample.color.b = static_cast<ColorElement>(
+			bin.blueSum / bin.count + 0.5 ) ;
+
+		sample.weight = bin.count ;
+
+		samples.push_back( sample ) ;
+
+	}
+
+}
+
+
+
+const string ColorHistogram::toString( Ceylan::VerbosityLevels level ) const
+{
+
+	return "Color histogram having counted "
+		+ Ceylan::toString( _pixelCount, /* precision */ 0 )
+		+ " pixel(s), in " + Ceylan::toString( getUsedBinCount() )
+		+ " used bin(s) out of " + Ceylan::toString( BinCount ) ;
+
+}
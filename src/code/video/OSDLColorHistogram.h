@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#ifndef OSDL_COLOR_HISTOGRAM_H_
+#define OSDL_COLOR_HISTOGRAM_H_
+
+
+#include "OSDLPixel.h"           // for ColorDefinition
+
+#include "Ceylan.h"              // for inheritance, Float64
+
+#include <string>
+#include <vector>
+
+
+
+
+namespace OSDL
+{
+
+
+	namespace Video
+	{
+
+
+		// A histogram can be fed with surfaces.
+		class Surface ;
+
+
+
+		/// A color of an histogram, with its number of occurrences.
+		struct ColorSample
+		{
+
+			/// The average color of the pixels this sample stands for.
+			Pixels::ColorDefinition color ;
+
+			/// The number of pixels this sample stands for.
+			Ceylan::Float64 weight ;
+
+		} ;
+
+
+
+		/**
+		 * Counts the colors of any number of pixels, typically streamed from a
+		 * corpus of images, in a compact 3D histogram.
+		 *
+		 * Colors are reduced to 5 bits for red and blue and 6 bits for green
+		 * to select their bin, and each bin keeps the number of pixels it
+		 * received and the sum of their exact components, thus the memory
+		 * footprint is fixed (about 2 MB), regardless of the number of pixels
+		 * counted.
+		 *
+		 * Histograms can be fed separately (ex: one per thread) then merged.
+		 *
+		 * @see Palette::CreateOptimizedPalette
+		 *
+		 */
+		class OSDL_DLL ColorHistogram : public Ceylan::TextDisplayable
+		{
+
+
+			public:
+
+
+
+				/// Creates an empty histogram.
+				ColorHistogram() ;
+
+
+
+				/// Virtual destructor.
+				virtual ~ColorHistogram() throw() ;
+
+
+
+				/**
+				 * Counts specified color.
+				 *
+				 * @param color the color to count, whose alpha coordinate is
+				 * ignored.
+				 *
+				 * @param weight the number of times this color is counted.
+				 *
+				 */
+				void addColor( const Pixels::ColorDefinition & color,
+					Ceylan::Float64 weight = 1 ) ;
+
+
+
+				/**
+				 * Counts all the pixels of specified surface, except the
+				 * fully transparent ones.
+				 *
+				 * @param surface the surface whose pixels are to be counted. It
+				 * should be locked beforehand if necessary.
+				 *
+				 * @param skipColorkey if true, the pixels matching the colorkey
+				 * of the surface, as guessed by Surface::guessColorKey, are
+				 * not counted (if no colorkey can be guessed, all pixels are
+				 * counted).
+				 *
+				 */
+				virtual void addSurface( const Surface & surface,
+					bool skipColorkey = true ) ;
+
+
+
+				/**
+				 * Counts all the pixels of specified image file, except the
+				 * fully transparent ones.
+				 *
+				 * The file is read directly from the standard filesystem and
+				 * decoded into a plain SDL surface, with no embedded
+				 * filesystem, logging or conversion to the display format
+				 * involved: unlike Surface::LoadImage, this method can thus be
+				 * called from worker threads, as long as each histogram is fed
+				 * by a single thread.
+				 *
+				 * @param imageFilename the filename of the image to count.
+				 *
+				 * @param skipColorkey tells whether the pixels matching the
+				 * guessed colorkey are to be skipped, as for addSurface.
+				 *
+				 * @throw VideoException if the image could not be loaded.
+				 *
+				 */
+				virtual void addImage( const std::string & imageFilename,
+					bool skipColorkey = true ) ;
+
+
+
+				/**
+				 * Adds to this histogram all the colors counted by the
+				 * specified one.
+				 *
+				 */
+				virtual void merge( const ColorHistogram & other ) ;
+
+
+
+				/// Empties this histogram.
+				virtual void clear() ;
+
+
+
+				/// Returns the total number of pixels counted.
+				Ceylan::Float64 getPixelCount() const ;
+
+
+
+				/// Returns the number of bins that counted at least one pixel.
+				Ceylan::Uint32 getUsedBinCount() const ;
+
+
+
+				/**
+				 * Fills specified vector with one sample per used bin, whose
+				 * color is the average of the pixels it counted.
+				 *
+				 * @note The vector is cleared first.
+				 *
+				 */
+				virtual void getSamples(
+					std::vector<ColorSample> & samples ) const ;
+
+
+
+				/**
+				 * Returns an user-friendly description of the state of this
+				 * object.
+				 *
+				 * @param level the requested verbosity level.
+				 *
+				 * @note Text output format is determined from overall settings.
+				 *
+				 * @see Ceylan::TextDisplayable
+				 *
+				 */
+				virtual const std::string toString(
+					Ceylan::VerbosityLevels level = Ceylan::high ) const ;
+
+
+
+
+				// Static section.
+
+
+				/// The number of bins of a histogram (32*64*32).
+				static const Ceylan::Uint32 BinCount ;
+
+
+
+
+			protected:
+
+
+
+				/// The content of a bin.
+				struct Bin
+				{
+
+					/// Number of pixels counted.
+					Ceylan::Float64 count ;
+
+					/// Sums of the components of the pixels counted.
+					Ceylan::Float64 redSum ;
+					Ceylan::Float64 greenSum ;
+					Ceylan::Float64 blueSum ;
+
+				} ;
+
+
+
+				/// The BinCount bins of this histogram.
+				Bin * _bins ;
+
+
+				/// The total number of pixels counted.
+				Ceylan::Float64 _pixelCount ;
+
+
+
+			private:
+
+
+
+				/**
+				 * Copy constructor made private to ensure that it will never be
+				 * called.
+				 *
+				 * The compiler should complain whenever this undefined
+				 * constructor is called, implicitly or not.
+				 *
+				 */
+				ColorHistogram( const ColorHistogram & source ) ;
+
+
+
+				/**
+				 * Assignment operator made private to ensure that it will never
+				 * be called.
+				 *
+				 * The compiler should complain whenever this undefined operator
+				 * is called, implicitly or not.
+				 *
+				 */
+				ColorHistogram & operator = ( const ColorHistogram & source ) ;
+
+
+		} ;
+
+	}
+
+}
+
+
+
+#endif // OSDL_COLOR_HISTOGRAM_H_
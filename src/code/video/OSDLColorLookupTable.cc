@@ -0,0 +1,364 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDLColorLookupTable.h"
+
+
+#include "Ceylan.h"                  // for Round, Pow
+
+
+
+/*
+ * Vector kernels need table lookups on vectors: AVX2 provides gathers (if
+ * enabled at compile-time), and AArch64 NEON provides lookups in up to 64
+ * bytes of table, chained to cover the 256 entries. SSE2 (and the 16-entry
+ * lookups of SSSE3) would need one shuffle per group of 16 entries per
+ * vector, which is no faster than scalar lookups, hence is not used.
+ *
+ */
+#if defined(__AVX2__)
+#define OSDL_MAPS_PIXELS_WITH_AVX2 1
+#include <immintrin.h>               // for _mm256_i32gather_epi32 and al
+#elif defined(__aarch64__) && ( defined(__ARM_NEON) || defined(__ARM_NEON__) )
+#define OSDL_MAPS_PIXELS_WITH_NEON 1
+#include <arm_neon.h>                // for vqtbl4q_u8 and al
+#endif // __AVX2__
+
+
+using std::string ;
+
+using namespace OSDL::Video ;
+using namespace OSDL::Video::Pixels ;
+
+
+
+ColorLookupTable::ColorLookupTable()
+{
+
+	setIdentity() ;
+
+}
+
+
+
+ColorLookupTable::~ColorLookupTable() throw()
+{
+
+}
+
+
+
+ColorElement ColorLookupTable::getMappingOf( ColorElement component ) const
+{
+
+	return _table[ component ] ;
+
+}
+
+
+
+void ColorLookupTable::setMappingOf( ColorElement component,
+	ColorElement newValue )
+{
+
+	_table[ component ] = newValue ;
+
+}
+
+
+
+void ColorLookupTable::setIdentity()
+{
+
+	for ( Ceylan::Uint32 c = 0; c < 256; c++ )
+		_table[c] = static_cast<ColorElement>( c ) ;
+
+}
+
+
+
+void ColorLookupTable::setGammaCorrection( GammaFactor gamma )
+{
+
+	// Same computation as Palette::CorrectGammaComponent:
+	for ( Ceylan::Uint32 c = 0; c < 256; c++ )
+		_table[c] = static_cast<ColorElement>( Ceylan::Maths::Round(
+			Ceylan::Maths::Pow( c / 255.0f, 1 / gamma ) * 255.0f ) ) ;
+
+}
+
+
+
+void ColorLookupTable::setQuantization( ColorElement quantizeMaxCoordinate,
+	bool scaleUp )
+{
+
+	// Would be a division by zero when scaling up:
+	if ( quantizeMaxCoordinate == 0 )
+		throw VideoException( "ColorLookupTable::setQuantization failed: "
+			"null maximum coordinate." ) ;
+
+	// Same computation as Palette::QuantizeComponent:
+	for ( Ceylan::Uint32 c = 0; c < 256; c++ )
+	{
+
+		ColorElement quantized = static_cast<ColorElement>(
+			Ceylan::Maths::Round( c / 255.0f * quantizeMaxCoordinate ) ) ;
+
+		if ( scaleUp )
+			quantized = static_cast<ColorElement>( Ceylan::Maths::Round(
+				quantized * 255.0f / quantizeMaxCoordinate ) ) ;
+
+		_table[c] = quantized ;
+
+	}
+
+}
+
+
+
+void ColorLookupTable::setLevels( ColorElement inputBlack,
+	ColorElement inputWhite, GammaFactor gamma, ColorElement outputBlack,
+	ColorElement outputWhite )
+{
+
+	if ( inputBlack >= inputWhite )
+		throw VideoException( "ColorLookupTable::setLevels failed: "
+			"input black (" + Ceylan::toNumericalString( inputBlack )
+			+ ") is not lower than input white ("
+			+ Ceylan::toNumericalString( inputWhite ) + ")." ) ;
+
+	Ceylan::Float32 inputRange  = static_cast<Ceylan::Float32>(
+		inputWhite - inputBlack ) ;
+
+	// May be negative, to invert colors:
+	Ceylan::Float32 outputRange = static_cast<Ceylan::Float32>(
+		outputWhite - outputBlack ) ;
+
+	for ( Ceylan::Uint32 c = 0; c < 256; c++ )
+	{
+
+		Ceylan::Float32 normalized ;
+
+		if ( c <= inputBlack )
+			normalized = 0 ;
+		else if ( c >= inputWhite )
+			normalized = 1 ;
+		else
+			normalized = ( c - inputBlack ) / inputRange ;
+
+		if ( gamma != 1.0f )
+			normalized = Ceylan::Maths::Pow( normalized, 1 / gamma ) ;
+
+		_table[c] = static_cast<ColorElement>( Ceylan::Maths::Round(
+			outputBlack + normalized * outputRange ) ) ;
+
+	}
+
+}
+
+
+
+void ColorLookupTable::compose( const ColorLookupTable & then )
+{
+
+	for ( Ceylan::Uint32 c = 0; c < 256; c++ )
+		_table[c] = then._table[ _table[c] ] ;
+
+}
+
+
+
+void ColorLookupTable::applyTo( ColorDefinition & color ) const
+{
+
+	color.r = _table[ color.r ] ;
+	color.g = _table[ color.g ] ;
+	color.b = _table[ color.b ] ;
+
+	// Alpha left as is.
+
+}
+
+
+
+void ColorLookupTable::applyToPixels( Ceylan::Uint32 * pixels,
+	Ceylan::Uint32 count, Ceylan::Uint8 redShift, Ceylan::Uint8 greenShift,
+	Ceylan::Uint8 blueShift, bool skipColorkey, PixelColor colorkey ) const
+{
+
+	const PixelColor colorMask = ( 0xffU << redShift )
+		| ( 0xffU << greenShift ) | ( 0xffU << blueShift ) ;
+
+	Ceylan::Uint32 i = 0 ;
+
+#if OSDL_MAPS_PIXELS_WITH_AVX2
+
+	// Gathers read 32-bit elements:
+	Ceylan::Uint32 wideTable[ 256 ] ;
+
+	for ( Ceylan::Uint32 c = 0; c < 256; c++ )
+		wideTable[c] = _table[c] ;
+
+	const int * gatherBase = reinterpret_cast<const int *>( wideTable ) ;
+
+	const __m128i redCount   = _mm_cvtsi32_si128( redShift ) ;
+	const __m128i greenCount = _mm_cvtsi32_si128( greenShift ) ;
+	const __m128i blueCount  = _mm_cvtsi32_si128( blueShift ) ;
+
+	const __m256i byteMask  = _mm256_set1_epi32( 0xff ) ;
+	const __m256i keptMask  = _mm256_set1_epi32(
+		static_cast<int>( ~ colorMask ) ) ;
+	const __m256i keyVector = _mm256_set1_epi32(
+		static_cast<int>( colorkey ) ) ;
+
+	for ( ; i + 8 <= count; i += 8 )
+	{
+
+		__m256i * location = reinterpret_cast<__m256i *>( pixels + i ) ;
+
+		__m256i original = _mm256_loadu_si256( location ) ;
+
+		__m256i red = _mm256_i32gather_epi32( gatherBase, _mm256_and_si256(
+			_mm256_srl_epi32( original, redCount ), byteMask ), 4 ) ;
+
+		__m256i green = _mm256_i32gather_epi32( gatherBase, _mm256_and_si256(
+			_mm256_srl_epi32( original, greenCount ), byteMask ), 4 ) ;
+
+		__m256i blue = _mm256_i32gather_epi32( gatherBase, _mm256_and_si256(
+			_mm256_srl_epi32( original, blueCount ), byteMask ), 4 ) ;
+
+		__m256i mapped = _mm256_or_si256(
+			_mm256_and_si256( original, keptMask ),
+			_mm256_or_si256( _mm256_sll_epi32( red, redCount ),
+				_mm256_or_si256( _mm256_sll_epi32( green, greenCount ),
+					_mm256_sll_epi32( blue, blueCount ) ) ) ) ;
+
+		if ( skipColorkey )
+			mapped = _mm256_blendv_epi8( mapped, original,
+				_mm256_cmpeq_epi32( original, keyVector ) ) ;
+
+		_mm256_storeu_si256( location, mapped ) ;
+
+	}
+
+#elif OSDL_MAPS_PIXELS_WITH_NEON
+
+	// The table is looked up by quarters of 64 entries:
+	uint8x16x4_t quarters[4] ;
+
+	for ( Ceylan::Uint8 q = 0; q < 4; q++ )
+		for ( Ceylan::Uint8 v = 0; v < 4; v++ )
+			quarters[q].val[v] = vld1q_u8( _table + 64 * q + 16 * v ) ;
+
+	const uint8x16_t quarterSize = vdupq_n_u8( 64 ) ;
+
+	// Selects the component bytes, whatever the endianness:
+	const uint8x16_t componentBytes = vreinterpretq_u8_u32(
+		vdupq_n_u32( colorMask ) ) ;
+
+	const uint32x4_t keyVector = vdupq_n_u32( colorkey ) ;
+
+	for ( ; i + 4 <= count; i += 4 )
+	{
+
+		uint8x16_t original = vreinterpretq_u8_u32( vld1q_u32( pixels + i ) ) ;
+
+		// Out-of-range indexes leave their byte untouched with vqtbx4q:
+		uint8x16_t index = original ;
+		uint8x16_t mapped = vqtbl4q_u8( quarters[0], index ) ;
+
+		for ( Ceylan::Uint8 q = 1; q < 4; q++ )
+		{
+
+			index  = vsubq_u8( index, quarterSize ) ;
+			mapped = vqtbx4q_u8( mapped, quarters[q], index ) ;
+
+		}
+
+		mapped = vbslq_u8( componentBytes, mapped, original ) ;
+
+		if ( skipColorkey )
+			mapped = vbslq_u8( vreinterpretq_u8_u32( vceqq_u32(
+				vreinterpretq_u32_u8( original ), keyVector ) ), original,
+				mapped ) ;
+
+		vst1q_u32( pixels + i, vreinterpretq_u32_u8( mapped ) ) ;
+
+	}
+
+#endif // OSDL_MAPS_PIXELS_WITH_AVX2
+
+	for ( ; i < count; i++ )
+	{
+
+		PixelColor pixel = pixels[i] ;
+
+		if ( skipColorkey && pixel == colorkey )
+			continue ;
+
+		pixels[i] = ( pixel & ~ colorMask )
+			| ( static_cast<PixelColor>(
+				_table[ ( pixel >> redShift ) & 0xff ] ) << redShift )
+			| ( static_cast<PixelColor>(
+				_table[ ( pixel >> greenShift ) & 0xff ] ) << greenShift )
+			| ( static_cast<PixelColor>(
+				_table[ ( pixel >> blueShift ) & 0xff ] ) << blueShift ) ;
+
+	}
+
+}
+
+
+
+const string ColorLookupTable::toString( Ceylan::VerbosityLevels level ) const
+{
+
+	Ceylan::Uint32 changedCount = 0 ;
+
+	for ( Ceylan::Uint32 c = 0; c < 256; c++ )
+		if ( _table[c] != c )
+			changedCount++ ;
+
+	if ( changedCount == 0 )
+		return "Identity color lookup table" ;
+
+	string res = "Color lookup table changing "
+		+ Ceylan::toString( changedCount ) + " component value(s) out of 256" ;
+
+	if ( level != Ceylan::high )
+		return res ;
+
+	// Samples a few values:
+	res += ", mapping for example" ;
+
+	for ( Ceylan::Uint32 c = 0; c < 256; c += 51 )
+		res += " " + Ceylan::toNumericalString( static_cast<ColorElement>( c ) )
+			+ "->" + Ceylan::toNumericalString( _table[c] ) ;
+
+	return res ;
+
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#ifndef OSDL_COLOR_LOOKUP_TABLE_H_
+#define OSDL_COLOR_LOOKUP_TABLE_H_
+
+
+#include "OSDLPixel.h"           // for ColorElement, GammaFactor
+
+#include "Ceylan.h"              // for inheritance
+
+#include <string>
+
+
+
+
+namespace OSDL
+{
+
+
+	namespace Video
+	{
+
+
+
+		/**
+		 * Maps each possible value of a color component to a new one, so that
+		 * a color transformation (ex: gamma correction, quantization, levels)
+		 * is computed once for all for the 256 possible values, and then
+		 * applied to any number of pixels or palette entries by mere lookups.
+		 *
+		 * The same mapping applies to the red, green and blue components;
+		 * alpha coordinates are never modified.
+		 *
+		 * A table is built once per parameter set, thanks to one of the set*
+		 * methods, and transformations can be chained thanks to compose.
+		 *
+		 * @see Palette::applyLookupTable, Surface::applyLookupTable
+		 *
+		 */
+		class OSDL_DLL ColorLookupTable : public Ceylan::TextDisplayable
+		{
+
+
+			public:
+
+
+
+				/// Creates an identity table, which changes no color.
+				ColorLookupTable() ;
+
+
+
+				/// Virtual destructor.
+				virtual ~ColorLookupTable() throw() ;
+
+
+
+				/// Returns the value specified component is mapped to.
+				Pixels::ColorElement getMappingOf(
+					Pixels::ColorElement component ) const ;
+
+
+
+				/// Sets the value specified component is mapped to.
+				void setMappingOf( Pixels::ColorElement component,
+					Pixels::ColorElement newValue ) ;
+
+
+
+				/// Resets this table so that it changes no color.
+				void setIdentity() ;
+
+
+
+				/**
+				 * Sets this table so that it applies a gamma correction.
+				 *
+				 * @param gamma the factor that will be used on each normalized
+				 * color component Cn: Cn_new = Cn_old^(1/gamma), then the
+				 * component is denormalized.
+				 *
+				 * @see Palette::correctGamma
+				 *
+				 */
+				void setGammaCorrection( Pixels::GammaFactor gamma ) ;
+
+
+
+				/**
+				 * Sets this table so that it quantizes components.
+				 *
+				 * @param quantizeMaxCoordinate components (originally in
+				 * [0;255]) are mapped to [0;quantizeMaxCoordinate].
+				 *
+				 * @param scaleUp if true, quantized components are then mapped
+				 * back to [0;255].
+				 *
+				 * @throw VideoException if quantizeMaxCoordinate is null.
+				 *
+				 * @see Palette::quantize
+				 *
+				 */
+				void setQuantization(
+					Pixels::ColorElement quantizeMaxCoordinate,
+					bool scaleUp = false ) ;
+
+
+
+				/**
+				 * Sets this table so that it adjusts levels, like image
+				 * editors do: components are first clamped to
+				 * [inputBlack;inputWhite] and normalized, then gamma-corrected,
+				 * and finally scaled to [outputBlack;outputWhite].
+				 *
+				 * @throw VideoException if inputBlack is not strictly lower
+				 * than inputWhite.
+				 *
+				 */
+				void setLevels( Pixels::ColorElement inputBlack,
+					Pixels::ColorElement inputWhite,
+					Pixels::GammaFactor gamma = 1.0f,
+					Pixels::ColorElement outputBlack = 0,
+					Pixels::ColorElement outputWhite = 255 ) ;
+
+
+
+				/**
+				 * Chains specified table after this one: afterwards, this
+				 * table maps each component as this table then the specified
+				 * one would have.
+				 *
+				 */
+				void compose( const ColorLookupTable & then ) ;
+
+
+
+				/**
+				 * Maps the red, green and blue components of specified color
+				 * definition, its alpha coordinate being left as is.
+				 *
+				 */
+				void applyTo( Pixels::ColorDefinition & color ) const ;
+
+
+
+				/**
+				 * Maps the red, green and blue components of specified
+				 * 32-bit pixels, whose components are each stored in a whole
+				 * byte, the other bits (ex: alpha) being left as are.
+				 *
+				 * Pixels are processed by vectors when the target provides
+				 * table lookups on them (AVX2 gathers, or AArch64 NEON
+				 * table instructions), otherwise one at a time.
+				 *
+				 * @param pixels the first pixel to map.
+				 *
+				 * @param count the number of pixels to map.
+				 *
+				 * @param redShift the bit offset of the red byte in a pixel
+				 * (a multiple of 8), and so on for green and blue.
+				 *
+				 * @param skipColorkey tells whether the pixels equal to the
+				 * specified colorkey must be left as are.
+				 *
+				 * @param colorkey the colorkey, if any.
+				 *
+				 * @see Surface::applyLookupTable
+				 *
+				 */
+				void applyToPixels( Ceylan::Uint32 * pixels,
+					Ceylan::Uint32 count, Ceylan::Uint8 redShift,
+					Ceylan::Uint8 greenShift, Ceylan::Uint8 blueShift,
+					bool skipColorkey = false,
+					Pixels::PixelColor colorkey = 0 ) const ;
+
+
+
+				/**
+				 * Returns an user-friendly description of the state of this
+				 * object.
+				 *
+				 * @param level the requested verbosity level.
+				 *
+				 * @note Text output format is determined from overall settings.
+				 *
+				 * @see Ceylan::TextDisplayable
+				 *
+				 */
+				virtual const std::string toString(
+					Ceylan::VerbosityLevels level = Ceylan::high ) const ;
+
+
+
+			protected:
+
+
+				/// The 256 mapped values.
+				Pixels::ColorElement _table[ 256 ] ;
+
+
+		} ;
+
+	}
+
+}
+
+
+
+#endif // OSDL_COLOR_LOOKUP_TABLE_H_
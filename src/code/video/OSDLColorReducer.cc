@@ -0,0 +1,814 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDLColorReducer.h"
+
+#include "OSDLPalette.h"             // for Palette
+#include "OSDLSurface.h"             // for Surface
+#include "OSDLPixel.h"               // for PixelColor, ColorDefinition
+#include "OSDLWorkerPool.h"          // for WorkerPool, Job
+
+#include <vector>
+
+
+
+#ifdef OSDL_USES_CONFIG_H
+#include <OSDLConfig.h>              // for OSDL_USES_SDL and al
+#endif // OSDL_USES_CONFIG_H
+
+
+#if OSDL_ARCH_NINTENDO_DS
+#include "OSDLConfigForNintendoDS.h" // for OSDL_USES_SDL and al
+#endif // OSDL_ARCH_NINTENDO_DS
+
+
+#if OSDL_USES_SDL
+#include "SDL_thread.h"              // for SDL_mutex, SDL_cond
+#endif // OSDL_USES_SDL
+
+
+
+using std::string ;
+
+using namespace OSDL ;
+using namespace OSDL::Video ;
+using namespace OSDL::Video::Pixels ;
+
+
+
+/*
+ * Implementation notes:
+ *
+ * A reduction is split into jobs sharing a ReductionContext. Each job writes
+ * only its own rows of the target surface, which is a software surface whose
+ * pixels are directly accessed.
+ *
+ * With Floyd-Steinberg dithering, the errors diffused to a row are stored in
+ * a buffer written only by the job of the previous row, whereas the error
+ * diffused to the right neighbour is kept by each job in local variables.
+ * Before reducing the pixel at abscissa x, a row job waits for the previous
+ * row to have reduced its pixels up to x+1 included, as they are the last
+ * ones to diffuse their error to x. Progress is published every ProgressStep
+ * pixels, under a mutex which also ensures the diffused errors are visible.
+ *
+ * As a pool executes jobs in their submission order, and as rows are submitted
+ * from top to bottom, the job a row waits for is always already running or
+ * done, thus no deadlock can happen, even with a single worker.
+ *
+ */
+
+
+
+const Length ColorReducer::BandHeight = 16 ;
+
+const Ceylan::Sint32 ColorReducer::OrderedDitheringAmplitude = 32 ;
+
+
+
+/// The 4x4 Bayer matrix used for ordered dithering, values in [0;15].
+static const Ceylan::Sint32 BayerMatrix[4][4] =
+{
+	{  0,  8,  2, 10 },
+	{ 12,  4, 14,  6 },
+	{  3, 11,  1,  9 },
+	{ 15,  7, 13,  5 }
+} ;
+
+
+/// Number of pixels reduced by a row job between two progress publications.
+static const Length ProgressStep = 16 ;
+
+
+
+/// The state shared by all the jobs of a color reduction.
+struct ReductionContext
+{
+
+	const Surface * source ;
+	Surface * target ;
+	const Palette * palette ;
+	const PixelFormat * format ;
+
+	Length width ;
+	Length height ;
+
+	ColorReducer::DitheringMode dithering ;
+
+	bool manageColorkey ;
+	PixelColor sourceColorkey ;
+	ColorCount colorkeyIndex ;
+
+
+	/*
+	 * Floyd-Steinberg only: the errors (scaled by 16) diffused to each row by
+	 * the previous one, three components per pixel, with one padding pixel on
+	 * each side of each row.
+	 *
+	 */
+	Ceylan::Sint32 * errors ;
+
+	/// Floyd-Steinberg only: the number of pixels already reduced per row.
+	Length * progress ;
+
+#if OSDL_USES_SDL
+
+	/// Protects progress, if jobs run concurrently (otherwise null).
+	SDL_mutex * progressMutex ;
+
+	/// Broadcast whenever the progress of a row is published.
+	SDL_cond * progressChanged ;
+
+#endif // OSDL_USES_SDL
+
+} ;
+
+
+
+static ColorElement ClampComponent( Ceylan::Sint32 component )
+{
+
+	if ( component < 0 )
+		return 0 ;
+
+	if ( component > 255 )
+		return 255 ;
+
+	return static_cast<ColorElement>( component ) ;
+
+}
+
+
+
+static void PutIndexAt( ReductionContext & context, Length x, Length y,
+	ColorCount index )
+{
+
+	// The target is a 8-bit surface:
+	static_cast<Ceylan::Uint8 *>( context.target->getPixels() )[
+		y * context.target->getPitch() + x ] =
+			static_cast<Ceylan::Uint8>( index ) ;
+
+}
+
+
+
+static void PublishProgress( ReductionContext & context, Length row,
+	Length count )
+{
+
+#if OSDL_USES_SDL
+
+	if ( context.progressMutex != 0 )
+	{
+
+		SDL_mutexP( context.progressMutex ) ;
+		context.progress[row] = count ;
+		SDL_CondBroadcast( context.progressChanged ) ;
+		SDL_mutexV( context.progressMutex ) ;
+
+		return ;
+
+	}
+
+#endif // OSDL_USES_SDL
+
+	context.progress[row] = count ;
+
+}
+
+
+
+/**
+ * Blocks until the specified row has reduced at least the specified number
+ * of pixels, and returns its current progress.
+ *
+ */
+static Length WaitForProgress( ReductionContext & context, Length row,
+	Length count )
+{
+
+#if OSDL_USES_SDL
+
+	if ( context.progressMutex != 0 )
+	{
+
+		SDL_mutexP( context.progressMutex ) ;
+
+		while ( context.progress[row] < count )
+			SDL_CondWait( context.progressChanged, context.progressMutex ) ;
+
+		Length reached = context.progress[row] ;
+
+		SDL_mutexV( context.progressMutex ) ;
+
+		return reached ;
+
+	}
+
+#endif // OSDL_USES_SDL
+
+	// Executed sequentially, hence the previous row is already done:
+	return context.progress[row] ;
+
+}
+
+
+
+/**
+ * Reduces a band of rows, without dithering or with ordered dithering.
+ *
+ */
+class BandReductionJob : public Job
+{
+
+	public:
+
+
+		BandReductionJob( ReductionContext & context, Length firstRow,
+				Length endRow ) :
+			Job( "color reduction of rows " + Ceylan::toString( firstRow )
+				+ " to " + Ceylan::toString( endRow - 1 ) ),
+			_context( context ),
+			_firstRow( firstRow ),
+			_endRow( endRow )
+		{
+
+		}
+
+
+		virtual ~BandReductionJob() throw()
+		{
+
+		}
+
+
+		virtual void execute()
+		{
+
+			bool ordered =
+				( _context.dithering == ColorReducer::OrderedDithering ) ;
+
+			PixelColor current ;
+			ColorCount index ;
+
+			for ( Length y = _firstRow; y < _endRow; y++ )
+				for ( Length x = 0; x < _context.width; x++ )
+				{
+
+					current = _context.source->getPixelColorAt( x, y ) ;
+
+					if ( _context.manageColorkey
+						&& Pixels::areEqual( current, _context.sourceColorkey ) )
+					{
+
+						index = _context.colorkeyIndex ;
+
+					}
+					else
+					{
+
+						ColorDefinition colorDef =
+							Pixels::convertPixelColorToColorDefinition(
+								*_context.format, current ) ;
+
+						if ( ordered )
+						{
+
+							// Offset in ]-Amplitude/2;Amplitude/2[:
+							Ceylan::Sint32 offset =
+								( 2 * BayerMatrix[y % 4][x % 4] - 15 )
+								* ColorReducer::OrderedDitheringAmplitude / 32 ;
+
+							colorDef.r = ClampComponent( colorDef.r + offset ) ;
+							colorDef.g = ClampComponent( colorDef.g + offset ) ;
+							colorDef.b = ClampComponent( colorDef.b + offset ) ;
+
+						}
+
+						index = _context.palette->getClosestColorIndexTo(
+							colorDef ) ;
+
+					}
+
+					PutIndexAt( _context, x, y, index ) ;
+
+				}
+
+		}
+
+
+	protected:
+
+		ReductionContext & _context ;
+
+		Length _firstRow ;
+
+		Length _endRow ;
+
+} ;
+
+
+
+/**
+ * Reduces one row with Floyd-Steinberg dithering, following the job of the
+ * previous row.
+ *
+ */
+class RowDiffusionJob : public Job
+{
+
+	public:
+
+
+		RowDiffusionJob( ReductionContext & context, Length row ) :
+			Job( "color diffusion of row " + Ceylan::toString( row ) ),
+			_context( context ),
+			_row( row )
+		{
+
+		}
+
+
+		virtual ~RowDiffusionJob() throw()
+		{
+
+		}
+
+
+		virtual void execute()
+		{
+
+			try
+			{
+
+				reduceRow() ;
+
+			}
+			catch( ... )
+			{
+
+				// Otherwise the next rows would wait forever:
+				PublishProgress( _context, _row, _context.width ) ;
+				throw ;
+
+			}
+
+		}
+
+
+	protected:
+
+
+		void reduceRow()
+		{
+
+			const Length width = _context.width ;
+
+			// Three components per pixel, plus the padding pixels:
+			const Ceylan::Uint32 rowSize = 3 * ( width + 2 ) ;
+
+			const Ceylan::Sint32 * incoming = _context.errors + _row * rowSize ;
+
+			Ceylan::Sint32 * outgoing = 0 ;
+
+			if ( _row + 1 < _context.height )
+				outgoing = _context.errors + ( _row + 1 ) * rowSize ;
+
+			// The first row does not depend on any other:
+			Length previousProgress = ( _row == 0 ) ? width : 0 ;
+
+			// Error diffused to the right neighbour, scaled by 16:
+			Ceylan::Sint32 carry[3] = { 0, 0, 0 } ;
+
+			PixelColor current ;
+			ColorCount index ;
+
+			for ( Length x = 0; x < width; x++ )
+			{
+
+				Length needed = ( x + 2 < width ) ? x + 2 : width ;
+
+				if ( previousProgress < needed )
+					previousProgress = WaitForProgress( _context, _row - 1,
+						needed ) ;
+
+				current = _context.source->getPixelColorAt( x, _row ) ;
+
+				if ( _context.manageColorkey
+					&& Pixels::areEqual( current, _context.sourceColorkey ) )
+				{
+
+					// Colorkey pixels neither receive nor diffuse errors:
+					index = _context.colorkeyIndex ;
+
+					carry[0] = 0 ;
+					carry[1] = 0 ;
+					carry[2] = 0 ;
+
+				}
+				else
+				{
+
+					ColorDefinition colorDef =
+						Pixels::convertPixelColorToColorDefinition(
+							*_context.format, current ) ;
+
+					const Ceylan::Sint32 * received = incoming + 3 * ( x + 1 ) ;
+
+					colorDef.r = ClampComponent( colorDef.r
+						+ ( received[0] + carry[0] ) / 16 ) ;
+
+					colorDef.g = ClampComponent( colorDef.g
+						+ ( received[1] + carry[1] ) / 16 ) ;
+
+					colorDef.b = ClampComponent( colorDef.b
+						+ ( received[2] + carry[2] ) / 16 ) ;
+
+					index = _context.palette->getClosestColorIndexTo(
+						colorDef ) ;
+
+					const ColorDefinition & chosen =
+						_context.palette->getColorDefinitionAt( index ) ;
+
+					Ceylan::Sint32 error[3] ;
+
+					error[0] = static_cast<Ceylan::Sint32>( colorDef.r )
+						- chosen.r ;
+
+					error[1] = static_cast<Ceylan::Sint32>( colorDef.g )
+						- chosen.g ;
+
+					error[2] = static_cast<Ceylan::Sint32>( colorDef.b )
+						- chosen.b ;
+
+					for ( Ceylan::Uint8 c = 0; c < 3; c++ )
+					{
+
+						carry[c] = 7 * error[c] ;
+
+						if ( outgoing != 0 )
+						{
+
+							// Below left, below, below right (padded):
+							outgoing[ 3 * x + c ]         += 3 * error[c] ;
+							outgoing[ 3 * ( x + 1 ) + c ] += 5 * error[c] ;
+							outgoing[ 3 * ( x + 2 ) + c ] += error[c] ;
+
+						}
+
+					}
+
+				}
+
+				PutIndexAt( _context, x, _row, index ) ;
+
+				if ( ( x + 1 ) % ProgressStep == 0 )
+					PublishProgress( _context, _row, x + 1 ) ;
+
+			}
+
+			PublishProgress( _context, _row, width ) ;
+
+		}
+
+
+		ReductionContext & _context ;
+
+		Length _row ;
+
+} ;
+
+
+
+
+ColorReducerException::ColorReducerException( const string & message ) :
+	VideoException( "ColorReducer exception: " + message )
+{
+
+}
+
+
+
+ColorReducerException::~ColorReducerException() throw()
+{
+
+}
+
+
+
+
+ColorReducer::ColorReducer( const Palette & palette,
+		DitheringMode dithering, WorkerPool * pool ) :
+	_palette( palette ),
+	_dithering( dithering ),
+	_pool( pool )
+{
+
+}
+
+
+
+ColorReducer::~ColorReducer() throw()
+{
+
+	// Neither the palette nor the pool are owned.
+
+}
+
+
+
+ColorReducer::DitheringMode ColorReducer::getDitheringMode() const
+{
+
+	return _dithering ;
+
+}
+
+
+
+void ColorReducer::setDitheringMode( DitheringMode newMode )
+{
+
+	_dithering = newMode ;
+
+}
+
+
+
+Surface & ColorReducer::reduce( const Surface & source,
+	bool manageColorkey ) const
+{
+
+	ReductionContext context ;
+
+	context.source         = & source ;
+	context.palette        = & _palette ;
+	context.width          = source.getWidth() ;
+	context.height         = source.getHeight() ;
+	context.dithering      = _dithering ;
+	context.manageColorkey = manageColorkey ;
+	context.sourceColorkey = 0 ;
+	context.colorkeyIndex  = 0 ;
+	context.errors         = 0 ;
+	context.progress       = 0 ;
+
+#if OSDL_USES_SDL
+	context.progressMutex   = 0 ;
+	context.progressChanged = 0 ;
+#endif // OSDL_USES_SDL
+
+	try
+	{
+
+		context.format = & source.getPixelFormat() ;
+
+		if ( manageColorkey )
+		{
+
+			context.sourceColorkey = source.guessColorKey() ;
+			context.colorkeyIndex  = _palette.getColorKeyIndex() ;
+
+		}
+
+		/*
+		 * Workers must only read the palette, whereas a sequential
+		 * reduction just computes the cells it needs:
+		 *
+		 */
+		if ( _pool != 0 )
+			_palette.computeInverseColormap() ;
+
+	}
+	catch( const VideoException & e )
+	{
+
+		throw ColorReducerException( "ColorReducer::reduce failed: "
+			+ e.toString() ) ;
+
+	}
+
+	// Creates a 8-bit software surface of the same size as the source one:
+	Surface * res = new Surface( Surface::Software, /* width */ context.width,
+		/* height */ context.height, /* BitsPerPixel */ 8 ) ;
+
+	res->setPalette( _palette ) ;
+
+	context.target = res ;
+
+
+	std::vector<Job *> jobs ;
+
+	if ( _dithering == FloydSteinbergDithering )
+	{
+
+		Ceylan::Uint32 errorCount =
+			3 * ( context.width + 2 ) * context.height ;
+
+		context.errors = new Ceylan::Sint32[ errorCount ] ;
+
+		for ( Ceylan::Uint32 i = 0; i < errorCount; i++ )
+			context.errors[i] = 0 ;
+
+		context.progress = new Length[ context.height ] ;
+
+		for ( Length row = 0; row < context.height; row++ )
+		{
+
+			context.progress[row] = 0 ;
+			jobs.push_back( new RowDiffusionJob( context, row ) ) ;
+
+		}
+
+#if OSDL_USES_SDL
+
+		if ( _pool != 0 )
+		{
+
+			context.progressMutex   = SDL_CreateMutex() ;
+			context.progressChanged = SDL_CreateCond() ;
+
+		}
+
+#endif // OSDL_USES_SDL
+
+	}
+	else
+	{
+
+		for ( Length first = 0; first < context.height; first += BandHeight )
+		{
+
+			Length end = ( context.height - first > BandHeight ) ?
+				first + BandHeight : context.height ;
+
+			jobs.push_back( new BandReductionJob( context, first, end ) ) ;
+
+		}
+
+	}
+
+
+	string failureReason ;
+
+	if ( _pool != 0 )
+	{
+
+		std::vector<Job *>::size_type submitted = 0 ;
+
+		try
+		{
+
+			for ( ; submitted < jobs.size(); submitted++ )
+				_pool->submit( * jobs[submitted] ) ;
+
+		}
+		catch( const WorkerPoolException & e )
+		{
+
+			failureReason = e.toString() ;
+
+		}
+
+		// Jobs are waited for even on failure, as they use the context:
+		for ( std::vector<Job *>::size_type i = 0; i < submitted; i++ )
+		{
+
+			_pool->waitFor( * jobs[i] ) ;
+
+			if ( failureReason.empty()
+					&& _pool->getStateOf( * jobs[i] ) == Job::Failed )
+				failureReason = jobs[i]->getName() + ": "
+					+ _pool->getFailureReasonFor( * jobs[i] ) ;
+
+		}
+
+	}
+	else
+	{
+
+		for ( std::vector<Job *>::const_iterator it = jobs.begin();
+			it != jobs.end(); it++ )
+		{
+
+			try
+			{
+
+				(*it)->execute() ;
+
+			}
+			catch( const Ceylan::Exception & e )
+			{
+
+				failureReason = (*it)->getName() + ": " + e.toString() ;
+				break ;
+
+			}
+
+		}
+
+	}
+
+
+	for ( std::vector<Job *>::iterator it = jobs.begin(); it != jobs.end();
+			it++ )
+		delete *it ;
+
+	if ( context.errors != 0 )
+		delete [] context.errors ;
+
+	if ( context.progress != 0 )
+		delete [] context.progress ;
+
+#if OSDL_USES_SDL
+
+	if ( context.progressChanged != 0 )
+		SDL_DestroyCond( context.progressChanged ) ;
+
+	if ( context.progressMutex != 0 )
+		SDL_DestroyMutex( context.progressMutex ) ;
+
+#endif // OSDL_USES_SDL
+
+	if ( ! failureReason.empty() )
+	{
+
+		delete res ;
+
+		throw ColorReducerException( "ColorReducer::reduce failed: "
+			+ failureReason ) ;
+
+	}
+
+	return *res ;
+
+}
+
+
+
+const string ColorReducer::toString( Ceylan::VerbosityLevels level ) const
+{
+
+	string res = "Color reducer to a palette of "
+		+ Ceylan::toString( static_cast<Ceylan::Uint32>(
+			_palette.getNumberOfColors() ) )
+		+ " colors, using " + DescribeDitheringMode( _dithering ) ;
+
+	if ( _pool != 0 )
+		return res + ", spreading its work over "
+			+ Ceylan::toString( _pool->getWorkerCount() ) + " worker(s)" ;
+	else
+		return res + ", working sequentially" ;
+
+}
+
+
+
+
+// Static section.
+
+
+
+string ColorReducer::DescribeDitheringMode( DitheringMode mode )
+{
+
+	switch( mode )
+	{
+
+		case NoDithering:
+			return "no dithering" ;
+
+		case FloydSteinbergDithering:
+			return "Floyd-Steinberg dithering" ;
+
+		case OrderedDithering:
+			return "ordered dithering" ;
+
+		default:
+			return "unknown dithering mode (abnormal)" ;
+
+	}
+
+}
@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#ifndef OSDL_COLOR_REDUCER_H_
+#define OSDL_COLOR_REDUCER_H_
+
+
+#include "OSDLVideoTypes.h"      // for VideoException, Length
+
+#include "Ceylan.h"              // for inheritance
+
+#include <string>
+
+
+
+
+namespace OSDL
+{
+
+
+	// A reducer may use a pool of worker threads.
+	class WorkerPool ;
+
+
+	namespace Video
+	{
+
+
+		// A color reducer targets a palette.
+		class Palette ;
+
+		// A color reducer converts surfaces.
+		class Surface ;
+
+
+
+		/// Exception raised when a color reduction failed.
+		class OSDL_DLL ColorReducerException : public VideoException
+		{
+
+			public:
+
+				explicit ColorReducerException( const std::string & message ) ;
+
+				virtual ~ColorReducerException() throw() ;
+
+		} ;
+
+
+
+		/**
+		 * Color-reduces surfaces, i.e. creates 8-bit (indexed) surfaces whose
+		 * pixels are chosen in a target palette to match best the pixels of
+		 * source surfaces, possibly with dithering.
+		 *
+		 * The work can be spread over the threads of a WorkerPool:
+		 *
+		 *  - without dithering and with ordered dithering, each pixel is
+		 * reduced independently, thus the surface is split into bands of rows,
+		 * each band being reduced by a separate job
+		 *
+		 *  - with Floyd-Steinberg dithering, the error of each pixel is
+		 * diffused to its right neighbour and to three neighbours of the next
+		 * row; each row is then reduced by a separate job, which lags behind
+		 * the job of the previous row by two pixels (row wavefront), so that
+		 * all rows can progress concurrently while producing exactly the same
+		 * result as a sequential reduction
+		 *
+		 * If no pool is specified, the same jobs are executed sequentially by
+		 * the calling thread.
+		 *
+		 * @note The inverse colormap of the target palette is fully computed
+		 * beforehand, so that the palette is only read by the workers.
+		 *
+		 * @see Palette::getClosestColorIndexTo
+		 *
+		 */
+		class OSDL_DLL ColorReducer : public Ceylan::TextDisplayable
+		{
+
+
+			public:
+
+
+
+				/// Describes how the reduction error is spread.
+				enum DitheringMode
+				{
+
+					/// Each pixel is replaced by its closest palette color.
+					NoDithering,
+
+					/**
+					 * The reduction error of each pixel is diffused to its
+					 * neighbours (7/16 right, 3/16 below left, 5/16 below,
+					 * 1/16 below right).
+					 *
+					 */
+					FloydSteinbergDithering,
+
+					/**
+					 * Each pixel is offset according to its position in a 4x4
+					 * Bayer matrix, before being matched.
+					 *
+					 */
+					OrderedDithering
+
+				} ;
+
+
+
+				/**
+				 * Creates a color reducer.
+				 *
+				 * @param palette the target palette, which must not be
+				 * changed or deallocated while this reducer uses it. No
+				 * ownership is taken.
+				 *
+				 * @param dithering the dithering mode to use.
+				 *
+				 * @param pool the pool of worker threads to reduce surfaces
+				 * with, if any. No ownership is taken. If null, reductions will
+				 * be performed by the calling thread.
+				 *
+				 */
+				explicit ColorReducer( const Palette & palette,
+					DitheringMode dithering = NoDithering,
+					WorkerPool * pool = 0 ) ;
+
+
+
+				/// Virtual destructor.
+				virtual ~ColorReducer() throw() ;
+
+
+
+				/// Returns the dithering mode currently used.
+				DitheringMode getDitheringMode() const ;
+
+
+				/// Sets the dithering mode to use for next reductions.
+				void setDitheringMode( DitheringMode newMode ) ;
+
+
+
+				/**
+				 * Returns a newly created 8-bit (indexed) color surface, whose
+				 * pixels have been chosen in the target palette to match best
+				 * with the pixels of the specified surface.
+				 *
+				 * @param source the surface to color-reduce. It should be
+				 * locked beforehand if necessary.
+				 *
+				 * @param manageColorkey tells whether a colorkey should be
+				 * taken care of, as Surface::createColorReducedSurfaceFor does.
+				 * The colorkey pixels neither receive nor diffuse any dithering
+				 * error.
+				 *
+				 * @return the color-reduced surface, which is owned by the
+				 * caller.
+				 *
+				 * @throw ColorReducerException if the operation failed,
+				 * including if manageColorkey is true but no colorkey could be
+				 * guessed or if there is no colorkey registered in target
+				 * palette.
+				 *
+				 * @see Surface::createColorReducedSurfaceFor
+				 *
+				 */
+				virtual Surface & reduce( const Surface & source,
+					bool manageColorkey = true ) const ;
+
+
+
+				/**
+				 * Returns an user-friendly description of the state of this
+				 * object.
+				 *
+				 * @param level the requested verbosity level.
+				 *
+				 * @note Text output format is determined from overall settings.
+				 *
+				 * @see Ceylan::TextDisplayable
+				 *
+				 */
+				virtual const std::string toString(
+					Ceylan::VerbosityLevels level = Ceylan::high ) const ;
+
+
+
+
+				// Static section.
+
+
+				/// Returns a textual description of specified dithering mode.
+				static std::string DescribeDitheringMode( DitheringMode mode ) ;
+
+
+
+				/**
+				 * The number of rows reduced by each job, when not using
+				 * Floyd-Steinberg dithering.
+				 *
+				 */
+				static const Length BandHeight ;
+
+
+
+				/**
+				 * The amplitude, in color component units, of the offsets
+				 * applied by ordered dithering.
+				 *
+				 */
+				static const Ceylan::Sint32 OrderedDitheringAmplitude ;
+
+
+
+
+			protected:
+
+
+
+				/// The palette surfaces are reduced to.
+				const Palette & _palette ;
+
+
+				/// The current dithering mode.
+				DitheringMode _dithering ;
+
+
+				/// The pool of workers used for reductions, if any.
+				WorkerPool * _pool ;
+
+
+
+			private:
+
+
+
+				/**
+				 * Copy constructor made private to ensure that it will never be
+				 * called.
+				 *
+				 * The compiler should complain whenever this undefined
+				 * constructor is called, implicitly or not.
+				 *
+				 */
+				ColorReducer( const ColorReducer & source ) ;
+
+
+
+				/**
+				 * Assignment operator made private to ensure that it will never
+				 * be called.
+				 *
+				 * The compiler should complain whenever this undefined operator
+				 * is called, implicitly or not.
+				 *
+				 */
+				ColorReducer & operator = ( const ColorReducer & source ) ;
+
+
+		} ;
+
+	}
+
+}
+
+
+
+#endif // OSDL_COLOR_REDUCER_H_
@@ -0,0 +1,661 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDLFrameCapturer.h"
+
+#include "OSDLSurface.h"             // for Surface
+#include "OSDLImage.h"               // for SavePNG, SaveRaw
+#include "OSDLVideo.h"               // for VideoModule
+#include "OSDLBasic.h"               // for getExistingCommonModule
+#include "OSDLUtils.h"               // for getBackendLastError
+
+
+#ifdef OSDL_USES_CONFIG_H
+#include <OSDLConfig.h>              // for OSDL_USES_SDL and al
+#endif // OSDL_USES_CONFIG_H
+
+
+#if OSDL_ARCH_NINTENDO_DS
+#include "OSDLConfigForNintendoDS.h" // for OSDL_USES_SDL and al
+#endif // OSDL_ARCH_NINTENDO_DS
+
+
+#if OSDL_USES_SDL
+#include "SDL.h"                     // for SDL_CreateRGBSurfaceFrom and al
+#endif // OSDL_USES_SDL
+
+
+#include <cstring>                   // for memcpy
+
+
+
+using std::string ;
+using std::list ;
+
+using namespace OSDL ;
+using namespace OSDL::Video ;
+using namespace OSDL::Video::Pixels ;
+
+
+
+/*
+ * Implementation notes:
+ *
+ * Each job owns a frame buffer, and a Surface wrapping it (thanks to
+ * SDL_CreateRGBSurfaceFrom, hence freeing the surface leaves the buffer
+ * untouched). Both are created, filled and deleted by the main thread only;
+ * encoders just read them, through the same Image::Save* functions as the
+ * synchronous screenshots.
+ *
+ * A job is reused for a later frame once its encoding is over; its surface is
+ * kept as long as the captured frames have the same dimensions and pixel
+ * format, which is the usual case of screen captures.
+ *
+ */
+
+
+
+namespace OSDL
+{
+
+
+	namespace Video
+	{
+
+
+
+		/// Copies a frame, then writes it to file from an encoder thread.
+		class FrameEncodingJob : public OSDL::Job
+		{
+
+
+			public:
+
+
+				FrameEncodingJob():
+					Job( "frame encoding" ),
+					_buffer( 0 ),
+					_capacity( 0 ),
+					_frame( 0 ),
+					_filename(),
+					_format( FrameCapturer::PNGFormat ),
+					_compressionLevel(
+						TwoDimensional::Image::FastPNGCompressionLevel )
+				{
+
+				}
+
+
+				virtual ~FrameEncodingJob() throw()
+				{
+
+					// Frees the SDL surface, but not the buffer it wraps:
+					if ( _frame != 0 )
+						delete _frame ;
+
+					if ( _buffer != 0 )
+						delete [] _buffer ;
+
+				}
+
+
+				/**
+				 * Copies the pixels (and the palette) of the source surface in
+				 * the frame buffer; to be called from the main thread.
+				 *
+				 */
+				void prepare( Surface & source, const string & filename,
+					FrameCapturer::CaptureFormat format,
+					Ceylan::Uint8 compressionLevel )
+				{
+
+#if OSDL_USES_SDL
+
+					const PixelFormat & sourceFormat = source.getPixelFormat() ;
+
+					const Length width  = source.getWidth() ;
+					const Length height = source.getHeight() ;
+
+					// Frame rows are packed, whatever the source pitch is:
+					const Ceylan::Uint32 rowSize =
+						width * sourceFormat.BytesPerPixel ;
+
+					if ( _frame != 0 )
+					{
+
+						const PixelFormat & frameFormat =
+							_frame->getPixelFormat() ;
+
+						if ( _frame->getWidth() != width
+							|| _frame->getHeight() != height
+							|| frameFormat.BitsPerPixel
+								!= sourceFormat.BitsPerPixel
+							|| frameFormat.Rmask != sourceFormat.Rmask
+							|| frameFormat.Gmask != sourceFormat.Gmask
+							|| frameFormat.Bmask != sourceFormat.Bmask
+							|| frameFormat.Amask != sourceFormat.Amask )
+						{
+
+							delete _frame ;
+							_frame = 0 ;
+
+						}
+
+					}
+
+					if ( _frame == 0 )
+					{
+
+						const Ceylan::Uint32 needed = rowSize * height ;
+
+						if ( needed > _capacity )
+						{
+
+							if ( _buffer != 0 )
+								delete [] _buffer ;
+
+							_buffer = new Ceylan::Uint8[ needed ] ;
+							_capacity = needed ;
+
+						}
+
+						LowLevelSurface * view = SDL_CreateRGBSurfaceFrom(
+							_buffer, width, height, sourceFormat.BitsPerPixel,
+							rowSize, sourceFormat.Rmask, sourceFormat.Gmask,
+							sourceFormat.Bmask, sourceFormat.Amask ) ;
+
+						if ( view == 0 )
+							throw VideoException( "FrameCapturer::capture "
+								"failed: unable to create frame surface: "
+								+ Utils::getBackendLastError() ) ;
+
+						_frame = new Surface( *view ) ;
+
+					}
+
+					source.lock() ;
+
+					const Ceylan::Uint8 * sourceRow =
+						static_cast<const Ceylan::Uint8 *>(
+							source.getPixels() ) ;
+
+					const Pitch sourcePitch = source.getPitch() ;
+
+					for ( Length y = 0; y < height; y++ )
+					{
+
+						::memcpy( _buffer + y * rowSize, sourceRow, rowSize ) ;
+						sourceRow += sourcePitch ;
+
+					}
+
+					source.unlock() ;
+
+					LowLevelSurface & frameSurface = _frame->getSDLSurface() ;
+
+					if ( sourceFormat.palette != 0 )
+						SDL_SetColors( & frameSurface,
+							sourceFormat.palette->colors, 0,
+							sourceFormat.palette->ncolors ) ;
+
+					if ( source.getFlags() & SDL_SRCCOLORKEY )
+						SDL_SetColorKey( & frameSurface, SDL_SRCCOLORKEY,
+							sourceFormat.colorkey ) ;
+					else
+						SDL_SetColorKey( & frameSurface, 0, 0 ) ;
+
+					_filename = filename ;
+					_format = format ;
+					_compressionLevel = compressionLevel ;
+
+					_name = "encoding of " + filename ;
+
+#else // OSDL_USES_SDL
+
+					throw VideoException( "FrameCapturer::capture failed: "
+						"no SDL support available" ) ;
+
+#endif // OSDL_USES_SDL
+
+				}
+
+
+				virtual void execute()
+				{
+
+					switch( _format )
+					{
+
+						case FrameCapturer::PNGFormat:
+							TwoDimensional::Image::SavePNG( *_frame, _filename,
+								/* overwrite */ true, _compressionLevel ) ;
+							break ;
+
+						case FrameCapturer::BMPFormat:
+							_frame->saveBMP( _filename ) ;
+							break ;
+
+						case FrameCapturer::RawFormat:
+							TwoDimensional::Image::SaveRaw( *_frame, _filename,
+								/* compress */ false ) ;
+							break ;
+
+						default:
+							throw VideoException( "unexpected capture format" ) ;
+
+					}
+
+				}
+
+
+			private:
+
+
+				/// The frame pixels, owned.
+				Ceylan::Uint8 * _buffer ;
+
+				/// The size of the frame buffer, in bytes.
+				Ceylan::Uint32 _capacity ;
+
+				/// The surface wrapping the frame buffer, owned.
+				Surface * _frame ;
+
+				string _filename ;
+
+				FrameCapturer::CaptureFormat _format ;
+
+				Ceylan::Uint8 _compressionLevel ;
+
+
+		} ;
+
+	}
+
+}
+
+
+
+FrameCapturer::FrameCapturer( CaptureFormat format,
+		Ceylan::Uint32 maxQueuedFrames, OverflowPolicy policy,
+		Ceylan::Uint32 encoderCount ):
+	_format( format ),
+	_maxQueuedFrames( maxQueuedFrames ),
+	_policy( policy ),
+	_pngCompressionLevel( TwoDimensional::Image::FastPNGCompressionLevel ),
+	_encoders( 0 ),
+	_queuedJobs(),
+	_idleJobs(),
+	_capturedCount( 0 ),
+	_encodedCount( 0 ),
+	_droppedCount( 0 ),
+	_failedCount( 0 ),
+	_lastFailureReason()
+{
+
+	if ( maxQueuedFrames == 0 )
+		throw VideoException( "FrameCapturer constructor failed: "
+			"the maximum number of queued frames must not be null." ) ;
+
+	if ( encoderCount == 0 )
+		throw VideoException( "FrameCapturer constructor failed: "
+			"at least one encoder is needed." ) ;
+
+	try
+	{
+
+		_encoders = new WorkerPool( encoderCount, "frame encoders" ) ;
+
+	}
+	catch( const WorkerPoolException & e )
+	{
+
+		throw VideoException( "FrameCapturer constructor failed: "
+			+ e.toString() ) ;
+
+	}
+
+}
+
+
+
+FrameCapturer::~FrameCapturer() throw()
+{
+
+	// Jobs are not owned by the pool, hence must outlive their execution:
+	flush() ;
+
+	delete _encoders ;
+
+	for ( list<FrameEncodingJob *>::iterator it = _queuedJobs.begin();
+		it != _queuedJobs.end(); it++ )
+		delete *it ;
+
+	for ( list<FrameEncodingJob *>::iterator it = _idleJobs.begin();
+		it != _idleJobs.end(); it++ )
+		delete *it ;
+
+}
+
+
+
+FrameCapturer::CaptureFormat FrameCapturer::getFormat() const
+{
+
+	return _format ;
+
+}
+
+
+
+string FrameCapturer::getFileExtension() const
+{
+
+	switch( _format )
+	{
+
+		case PNGFormat:
+			return ".png" ;
+
+		case BMPFormat:
+			return ".bmp" ;
+
+		case RawFormat:
+			return ".osdl.raw" ;
+
+		default:
+			return ".unknown" ;
+
+	}
+
+}
+
+
+
+void FrameCapturer::setPNGCompressionLevel( Ceylan::Uint8 level )
+{
+
+	if ( level > 9 )
+		throw VideoException( "FrameCapturer::setPNGCompressionLevel failed: "
+			"level " + Ceylan::toNumericalString( level )
+			+ " is not in [0;9]." ) ;
+
+	_pngCompressionLevel = level ;
+
+}
+
+
+
+bool FrameCapturer::capture( Surface & source, const string & filename )
+{
+
+	collectEncodedFrames() ;
+
+	if ( _queuedJobs.size() >= _maxQueuedFrames )
+	{
+
+		if ( _policy == DropOnOverflow )
+		{
+
+			_droppedCount++ ;
+			return false ;
+
+		}
+
+		// Backpressure: the oldest frame is the first to be written.
+		_encoders->waitFor( *_queuedJobs.front() ) ;
+
+		collectEncodedFrames() ;
+
+	}
+
+	FrameEncodingJob * job ;
+
+	if ( _idleJobs.empty() )
+	{
+
+		job = new FrameEncodingJob() ;
+
+	}
+	else
+	{
+
+		job = _idleJobs.front() ;
+		_idleJobs.pop_front() ;
+
+	}
+
+	try
+	{
+
+		job->prepare( source, filename, _format, _pngCompressionLevel ) ;
+
+		_encoders->submit( *job ) ;
+
+	}
+	catch( const Ceylan::Exception & e )
+	{
+
+		_idleJobs.push_back( job ) ;
+
+		throw VideoException( "FrameCapturer::capture failed for '"
+			+ filename + "': " + e.toString() ) ;
+
+	}
+
+	_queuedJobs.push_back( job ) ;
+	_capturedCount++ ;
+
+	return true ;
+
+}
+
+
+
+bool FrameCapturer::captureScreen( const string & filename )
+{
+
+	if ( ! VideoModule::IsDisplayInitialized() )
+		throw VideoException( "FrameCapturer::captureScreen failed: "
+			"display not initialized (VideoModule::setMode never called)." ) ;
+
+	VideoModule & video = OSDL::getExistingCommonModule().getVideoModule() ;
+
+	if ( video.isUsingOpenGL() )
+		throw VideoException( "FrameCapturer::captureScreen failed: "
+			"the screen is rendered through OpenGL, its surface cannot be "
+			"captured." ) ;
+
+	return capture( video.getScreenSurface(), filename ) ;
+
+}
+
+
+
+Ceylan::Uint32 FrameCapturer::collectEncodedFrames()
+{
+
+	Ceylan::Uint32 count = 0 ;
+
+	list<FrameEncodingJob *>::iterator it = _queuedJobs.begin() ;
+
+	while ( it != _queuedJobs.end() )
+	{
+
+		if ( ! _encoders->isCompleted( **it ) )
+		{
+
+			it++ ;
+			continue ;
+
+		}
+
+		if ( _encoders->getStateOf( **it ) == Job::Failed )
+		{
+
+			_failedCount++ ;
+			_lastFailureReason = _encoders->getFailureReasonFor( **it ) ;
+
+		}
+		else
+		{
+
+			_encodedCount++ ;
+
+		}
+
+		_idleJobs.push_back( *it ) ;
+		it = _queuedJobs.erase( it ) ;
+
+		count++ ;
+
+	}
+
+	return count ;
+
+}
+
+
+
+bool FrameCapturer::flush( Ceylan::Uint32 timeout )
+{
+
+	_encoders->waitForAll( timeout ) ;
+
+	collectEncodedFrames() ;
+
+	return _queuedJobs.empty() ;
+
+}
+
+
+
+Ceylan::Uint32 FrameCapturer::getQueuedCount() const
+{
+
+	return static_cast<Ceylan::Uint32>( _queuedJobs.size() ) ;
+
+}
+
+
+
+Ceylan::Uint32 FrameCapturer::getCapturedCount() const
+{
+
+	return _capturedCount ;
+
+}
+
+
+
+Ceylan::Uint32 FrameCapturer::getEncodedCount() const
+{
+
+	return _encodedCount ;
+
+}
+
+
+
+Ceylan::Uint32 FrameCapturer::getDroppedCount() const
+{
+
+	return _droppedCount ;
+
+}
+
+
+
+Ceylan::Uint32 FrameCapturer::getFailedCount() const
+{
+
+	return _failedCount ;
+
+}
+
+
+
+string FrameCapturer::getLastFailureReason() const
+{
+
+	return _lastFailureReason ;
+
+}
+
+
+
+const string FrameCapturer::toString( Ceylan::VerbosityLevels level ) const
+{
+
+	string res = "Frame capturer saving " + DescribeFormat( _format )
+		+ " frames with " + Ceylan::toString( _encoders->getWorkerCount() )
+		+ " encoder(s), up to " + Ceylan::toString( _maxQueuedFrames )
+		+ " queued frame(s), "
+		+ ( ( _policy == WaitOnOverflow ) ?
+			"waiting" : "dropping frames" ) + " on overflow" ;
+
+	if ( _format == PNGFormat )
+		res += ", with compression level "
+			+ Ceylan::toNumericalString( _pngCompressionLevel ) ;
+
+	if ( level == Ceylan::low )
+		return res ;
+
+	res += ". " + Ceylan::toString( _capturedCount ) + " frame(s) captured, "
+		+ Ceylan::toString( _encodedCount ) + " written, "
+		+ Ceylan::toString( getQueuedCount() ) + " queued, "
+		+ Ceylan::toString( _droppedCount ) + " dropped, "
+		+ Ceylan::toString( _failedCount ) + " failed" ;
+
+	if ( ! _lastFailureReason.empty() )
+		res += " (last failure: " + _lastFailureReason + ")" ;
+
+	return res ;
+
+}
+
+
+
+string FrameCapturer::DescribeFormat( CaptureFormat format )
+{
+
+	switch( format )
+	{
+
+		case PNGFormat:
+			return "PNG" ;
+
+		case BMPFormat:
+			return "BMP" ;
+
+		case RawFormat:
+			return "uncompressed raw" ;
+
+		default:
+			return "unknown (abnormal)" ;
+
+	}
+
+}
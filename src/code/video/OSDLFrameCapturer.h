@@ -0,0 +1,413 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#ifndef OSDL_FRAME_CAPTURER_H_
+#define OSDL_FRAME_CAPTURER_H_
+
+
+#include "OSDLVideoTypes.h"      // for VideoException
+#include "OSDLWorkerPool.h"      // for WorkerPool
+
+#include "Ceylan.h"              // for inheritance, Uint32
+
+#include <string>
+#include <list>
+
+
+
+
+namespace OSDL
+{
+
+
+	namespace Video
+	{
+
+
+		// Frames are captured from surfaces.
+		class Surface ;
+
+
+		// Defined in the implementation file.
+		class FrameEncodingJob ;
+
+
+
+		/**
+		 * Captures frames (ex: successive screen contents, for a video or a
+		 * series of screenshots) without blocking the caller for their
+		 * encoding.
+		 *
+		 * Capturing a frame only copies its pixels into a buffer, on the
+		 * calling (main) thread; the buffer is then encoded and written to
+		 * file by a background encoder thread, while the application renders
+		 * the next frames.
+		 *
+		 * Buffers are reused from one frame to the next, so that a steady
+		 * capture allocates no memory once the first frames are queued.
+		 *
+		 * At most a given number of frames may be waiting for their encoding:
+		 * when this bound is reached (the encoders being slower than the
+		 * capture rate), the capturer either waits for the oldest frame to be
+		 * written (hence no frame is lost, but rendering is slowed down), or
+		 * drops the new frame (rendering is not affected, but the sequence has
+		 * gaps), depending on its overflow policy. Dropped frames are counted.
+		 *
+		 * Frames may be saved as PNG (with a compression level trading file
+		 * size for speed, the fastest one being used by default), as BMP, or
+		 * as uncompressed OSDL raw images (see Image::SaveRaw), whose writing
+		 * is little more than a memory copy, to be converted afterwards
+		 * whenever capture speed matters most.
+		 *
+		 * @note Meant to be used from the main thread only.
+		 *
+		 * @see Engine::Scheduler::setScreenshotMode, which relies on a
+		 * capturer.
+		 *
+		 */
+		class OSDL_DLL FrameCapturer : public Ceylan::TextDisplayable
+		{
+
+
+			public:
+
+
+
+				/// The file formats frames can be saved in.
+				enum CaptureFormat
+				{
+
+					/// PNG files, with a settable compression level.
+					PNGFormat,
+
+					/// BMP files.
+					BMPFormat,
+
+					/// Uncompressed OSDL raw images.
+					RawFormat
+
+				} ;
+
+
+
+				/// Tells what to do when too many frames are being encoded.
+				enum OverflowPolicy
+				{
+
+					/// Wait for the oldest frame to be written.
+					WaitOnOverflow,
+
+					/// Drop the newly captured frame.
+					DropOnOverflow
+
+				} ;
+
+
+
+				/**
+				 * Creates a frame capturer, and starts its encoders.
+				 *
+				 * @param format the file format of the captured frames.
+				 *
+				 * @param maxQueuedFrames the maximum number of frames that can
+				 * be waiting for their encoding (or being encoded); this is
+				 * also the number of frame buffers that may be allocated. Must
+				 * not be null.
+				 *
+				 * @param policy tells what to do when a frame is captured
+				 * whereas maxQueuedFrames frames are already queued.
+				 *
+				 * @param encoderCount the number of encoder threads. Frames
+				 * are written in capture order only if there is a single
+				 * encoder.
+				 *
+				 * @throw VideoException if the capturer could not be created.
+				 *
+				 */
+				explicit FrameCapturer( CaptureFormat format = PNGFormat,
+					Ceylan::Uint32 maxQueuedFrames = 4,
+					OverflowPolicy policy = WaitOnOverflow,
+					Ceylan::Uint32 encoderCount = 1 ) ;
+
+
+
+				/**
+				 * Virtual destructor, waiting for all captured frames to be
+				 * written.
+				 *
+				 */
+				virtual ~FrameCapturer() throw() ;
+
+
+
+				/// Returns the file format of the captured frames.
+				virtual CaptureFormat getFormat() const ;
+
+
+
+				/**
+				 * Returns the extension, including its dot, of the files
+				 * written by this capturer (ex: '.png').
+				 *
+				 */
+				virtual std::string getFileExtension() const ;
+
+
+
+				/**
+				 * Sets the zlib compression level used for the next PNG frames,
+				 * in [0;9].
+				 *
+				 * By default, TwoDimensional::Image::FastPNGCompressionLevel is
+				 * used.
+				 *
+				 * @throw VideoException if the level is out of bounds.
+				 *
+				 */
+				virtual void setPNGCompressionLevel( Ceylan::Uint8 level ) ;
+
+
+
+				/**
+				 * Captures the current content of the specified surface, to be
+				 * written in the background to the specified file.
+				 *
+				 * The surface can be modified as soon as this method returns.
+				 *
+				 * @param source the surface to capture; if it has a palette,
+				 * the frame keeps a copy of it.
+				 *
+				 * @param filename the name of the file to write; an existing
+				 * file is overwritten.
+				 *
+				 * @return true iff the frame was captured, false if it was
+				 * dropped due to the overflow policy.
+				 *
+				 * @throw VideoException if the frame could not be captured.
+				 *
+				 */
+				virtual bool capture( Surface & source,
+					const std::string & filename ) ;
+
+
+
+				/**
+				 * Captures the current content of the screen surface.
+				 *
+				 * @see capture
+				 *
+				 * @throw VideoException if the frame could not be captured, for
+				 * example if no display is available, or if the screen is
+				 * rendered through OpenGL.
+				 *
+				 */
+				virtual bool captureScreen( const std::string & filename ) ;
+
+
+
+				/**
+				 * Takes into account the frames whose encoding is over, so
+				 * that their buffers can be reused and their outcome counted.
+				 *
+				 * Called automatically on each capture; does not block.
+				 *
+				 * @return the number of frames whose encoding was found over.
+				 *
+				 */
+				virtual Ceylan::Uint32 collectEncodedFrames() ;
+
+
+
+				/**
+				 * Waits until all captured frames have been written, or until
+				 * the specified timeout expires.
+				 *
+				 * @param timeout the maximum duration to wait, in milliseconds.
+				 *
+				 * @return true iff no frame remains to be written.
+				 *
+				 */
+				virtual bool flush(
+					Ceylan::Uint32 timeout = WorkerPool::WaitIndefinitely ) ;
+
+
+
+				/// Returns the number of frames waiting for their encoding.
+				virtual Ceylan::Uint32 getQueuedCount() const ;
+
+
+				/// Returns the number of frames captured so far.
+				virtual Ceylan::Uint32 getCapturedCount() const ;
+
+
+				/// Returns the number of frames successfully written so far.
+				virtual Ceylan::Uint32 getEncodedCount() const ;
+
+
+				/// Returns the number of frames dropped due to overflow.
+				virtual Ceylan::Uint32 getDroppedCount() const ;
+
+
+				/// Returns the number of frames whose writing failed.
+				virtual Ceylan::Uint32 getFailedCount() const ;
+
+
+
+				/**
+				 * Returns the reason why the writing of a frame failed most
+				 * recently, or an empty string if none failed.
+				 *
+				 */
+				virtual std::string getLastFailureReason() const ;
+
+
+
+				/**
+				 * Returns an user-friendly description of the state of this
+				 * object.
+				 *
+				 * @param level the requested verbosity level.
+				 *
+				 * @note Text output format is determined from overall settings.
+				 *
+				 * @see Ceylan::TextDisplayable
+				 *
+				 */
+				virtual const std::string toString(
+					Ceylan::VerbosityLevels level = Ceylan::high ) const ;
+
+
+
+				/// Returns a textual description of specified format.
+				static std::string DescribeFormat( CaptureFormat format ) ;
+
+
+
+			protected:
+
+
+
+				/// The file format of the captured frames.
+				CaptureFormat _format ;
+
+
+				/// The maximum number of queued frames.
+				Ceylan::Uint32 _maxQueuedFrames ;
+
+
+				/// Tells what to do on overflow.
+				OverflowPolicy _policy ;
+
+
+				/// The compression level of PNG frames.
+				Ceylan::Uint8 _pngCompressionLevel ;
+
+
+				/// The pool of encoder threads, owned.
+				WorkerPool * _encoders ;
+
+
+/*
+ * Takes care of the awful issue of Windows DLL with templates.
+ *
+ * @see Ceylan's developer guide and README-build-for-windows.txt to understand
+ * it, and to be aware of the associated risks.
+ *
+ */
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+
+				/**
+				 * The jobs of the frames being encoded, or waiting for it, in
+				 * capture order.
+				 *
+				 */
+				std::list<FrameEncodingJob *> _queuedJobs ;
+
+
+				/// The jobs whose frame buffer can be reused.
+				std::list<FrameEncodingJob *> _idleJobs ;
+
+#pragma warning( pop )
+
+
+				/// The number of captured frames.
+				Ceylan::Uint32 _capturedCount ;
+
+
+				/// The number of successfully written frames.
+				Ceylan::Uint32 _encodedCount ;
+
+
+				/// The number of dropped frames.
+				Ceylan::Uint32 _droppedCount ;
+
+
+				/// The number of frames whose writing failed.
+				Ceylan::Uint32 _failedCount ;
+
+
+				/// The reason of the most recent failure, if any.
+				std::string _lastFailureReason ;
+
+
+
+			private:
+
+
+
+				/**
+				 * Copy constructor made private to ensure that it will be never
+				 * called.
+				 *
+				 * The compiler should complain whenever this undefined
+				 * constructor is called, implicitly or not.
+				 *
+				 */
+				explicit FrameCapturer( const FrameCapturer & source ) ;
+
+
+
+				/**
+				 * Assignment operator made private to ensure that it will be
+				 * never called.
+				 *
+				 * The compiler should complain whenever this undefined operator
+				 * is called, implicitly or not.
+				 *
+				 */
+				FrameCapturer & operator = ( const FrameCapturer & source ) ;
+
+
+		} ;
+
+	}
+
+}
+
+
+
+#endif // OSDL_FRAME_CAPTURER_H_
@@ -0,0 +1,473 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDLIndexedBlitTable.h"
+
+#include "OSDLSurface.h"             // for Surface
+
+
+#ifdef OSDL_USES_CONFIG_H
+#include <OSDLConfig.h>              // for OSDL_USES_SDL and al
+#endif // OSDL_USES_CONFIG_H
+
+
+#if OSDL_ARCH_NINTENDO_DS
+#include "OSDLConfigForNintendoDS.h" // for OSDL_USES_SDL and al
+#endif // OSDL_ARCH_NINTENDO_DS
+
+
+#if OSDL_USES_SDL
+#include "SDL.h"                     // for SDL_Surface
+#endif // OSDL_USES_SDL
+
+
+#if defined(__AVX2__)
+#define OSDL_BLITS_WITH_AVX2 1
+#include <immintrin.h>               // for _mm256_i32gather_epi32 and al
+#endif // __AVX2__
+
+
+
+using std::string ;
+
+using namespace OSDL::Video ;
+using namespace OSDL::Video::Pixels ;
+
+
+
+/*
+ * Implementation notes:
+ *
+ * A row is converted by one lookup per pixel, the inner loops being
+ * specialized for each target pixel size, and unrolled when no index is
+ * transparent.
+ *
+ * When AVX2 is enabled at compile-time, 16-bit and 32-bit rows are converted
+ * 8 pixels at a time thanks to gathers, transparent indexes being blended
+ * with the target pixels; the scalar loops then convert the remaining pixels.
+ * Other vector units have no gather: with SSE2 or NEON, a lookup in a table
+ * of 256 colors would need several shuffles per byte plane of the colors,
+ * whose tables do not fit in the vector registers, which is no faster than
+ * scalar lookups. 24-bit rows are always converted by the scalar loop.
+ *
+ */
+
+
+
+/// Converts one row towards a 16-bit target.
+static void BlitRowTo16Bits( const Ceylan::Uint8 * source,
+	Ceylan::Uint16 * target, Ceylan::Sint32 width, const PixelColor * colors,
+	bool useKey, Ceylan::Uint8 key )
+{
+
+	Ceylan::Sint32 x = 0 ;
+
+#if OSDL_BLITS_WITH_AVX2
+
+	const int * gatherBase = reinterpret_cast<const int *>( colors ) ;
+
+	const __m128i keyVector = _mm_set1_epi16( key ) ;
+
+	for ( ; x + 8 <= width; x += 8 )
+	{
+
+		__m128i indexes = _mm_loadl_epi64(
+			reinterpret_cast<const __m128i *>( source + x ) ) ;
+
+		__m256i gathered = _mm256_i32gather_epi32( gatherBase,
+			_mm256_cvtepu8_epi32( indexes ), 4 ) ;
+
+		// 16-bit colors are not saturated by this packing:
+		__m128i packed = _mm_packus_epi32(
+			_mm256_castsi256_si128( gathered ),
+			_mm256_extracti128_si256( gathered, 1 ) ) ;
+
+		__m128i * location = reinterpret_cast<__m128i *>( target + x ) ;
+
+		if ( useKey )
+			packed = _mm_blendv_epi8( packed, _mm_loadu_si128( location ),
+				_mm_cmpeq_epi16( _mm_cvtepu8_epi16( indexes ), keyVector ) ) ;
+
+		_mm_storeu_si128( location, packed ) ;
+
+	}
+
+#endif // OSDL_BLITS_WITH_AVX2
+
+	if ( useKey )
+	{
+
+		for ( ; x < width; x++ )
+			if ( source[x] != key )
+				target[x] = static_cast<Ceylan::Uint16>( colors[ source[x] ] ) ;
+
+		return ;
+
+	}
+
+	for ( ; x + 4 <= width; x += 4 )
+	{
+
+		target[x]   = static_cast<Ceylan::Uint16>( colors[ source[x] ] ) ;
+		target[x+1] = static_cast<Ceylan::Uint16>( colors[ source[x+1] ] ) ;
+		target[x+2] = static_cast<Ceylan::Uint16>( colors[ source[x+2] ] ) ;
+		target[x+3] = static_cast<Ceylan::Uint16>( colors[ source[x+3] ] ) ;
+
+	}
+
+	for ( ; x < width; x++ )
+		target[x] = static_cast<Ceylan::Uint16>( colors[ source[x] ] ) ;
+
+}
+
+
+
+/// Converts one row towards a 24-bit target.
+static void BlitRowTo24Bits( const Ceylan::Uint8 * source,
+	Ceylan::Uint8 * target, Ceylan::Sint32 width, const PixelColor * colors,
+	bool useKey, Ceylan::Uint8 key )
+{
+
+	for ( Ceylan::Sint32 x = 0; x < width; x++, target += 3 )
+	{
+
+		if ( useKey && source[x] == key )
+			continue ;
+
+		PixelColor color = colors[ source[x] ] ;
+
+#if CEYLAN_DETECTED_LITTLE_ENDIAN
+		target[0] = static_cast<Ceylan::Uint8>( color ) ;
+		target[1] = static_cast<Ceylan::Uint8>( color >> 8 ) ;
+		target[2] = static_cast<Ceylan::Uint8>( color >> 16 ) ;
+#else // CEYLAN_DETECTED_LITTLE_ENDIAN
+		target[0] = static_cast<Ceylan::Uint8>( color >> 16 ) ;
+		target[1] = static_cast<Ceylan::Uint8>( color >> 8 ) ;
+		target[2] = static_cast<Ceylan::Uint8>( color ) ;
+#endif // CEYLAN_DETECTED_LITTLE_ENDIAN
+
+	}
+
+}
+
+
+
+/// Converts one row towards a 32-bit target.
+static void BlitRowTo32Bits( const Ceylan::Uint8 * source,
+	Ceylan::Uint32 * target, Ceylan::Sint32 width, const PixelColor * colors,
+	bool useKey, Ceylan::Uint8 key )
+{
+
+	Ceylan::Sint32 x = 0 ;
+
+#if OSDL_BLITS_WITH_AVX2
+
+	const int * gatherBase = reinterpret_cast<const int *>( colors ) ;
+
+	const __m256i keyVector = _mm256_set1_epi32( key ) ;
+
+	for ( ; x + 8 <= width; x += 8 )
+	{
+
+		__m256i indexes = _mm256_cvtepu8_epi32( _mm_loadl_epi64(
+			reinterpret_cast<const __m128i *>( source + x ) ) ) ;
+
+		__m256i gathered = _mm256_i32gather_epi32( gatherBase, indexes, 4 ) ;
+
+		__m256i * location = reinterpret_cast<__m256i *>( target + x ) ;
+
+		if ( useKey )
+			gathered = _mm256_blendv_epi8( gathered,
+				_mm256_loadu_si256( location ),
+				_mm256_cmpeq_epi32( indexes, keyVector ) ) ;
+
+		_mm256_storeu_si256( location, gathered ) ;
+
+	}
+
+#endif // OSDL_BLITS_WITH_AVX2
+
+	if ( useKey )
+	{
+
+		for ( ; x < width; x++ )
+			if ( source[x] != key )
+				target[x] = colors[ source[x] ] ;
+
+		return ;
+
+	}
+
+	for ( ; x + 4 <= width; x += 4 )
+	{
+
+		target[x]   = colors[ source[x] ] ;
+		target[x+1] = colors[ source[x+1] ] ;
+		target[x+2] = colors[ source[x+2] ] ;
+		target[x+3] = colors[ source[x+3] ] ;
+
+	}
+
+	for ( ; x < width; x++ )
+		target[x] = colors[ source[x] ] ;
+
+}
+
+
+
+IndexedBlitTable::IndexedBlitTable( const Palette & palette,
+		const PixelFormat & targetFormat, bool useColorkey ):
+	_hasColorKey( false ),
+	_colorKeyIndex( 0 ),
+	_targetFormat( targetFormat )
+{
+
+	if ( targetFormat.BytesPerPixel < 2 )
+		throw VideoException( "IndexedBlitTable constructor failed: "
+			"target pixel format is not a true color one." ) ;
+
+	// Not owned, and possibly deallocated with the target:
+	_targetFormat.palette = 0 ;
+
+	update( palette, useColorkey ) ;
+
+}
+
+
+
+IndexedBlitTable::~IndexedBlitTable() throw()
+{
+
+}
+
+
+
+void IndexedBlitTable::update( const Palette & palette, bool useColorkey )
+{
+
+	ColorCount count = palette.getNumberOfColors() ;
+
+	if ( count > 256 )
+		count = 256 ;
+
+	const ColorDefinition * definitions = palette.getColorDefinitions() ;
+
+	// Palette colors are considered opaque, whatever their unused field:
+	for ( ColorCount i = 0; i < count; i++ )
+		_colors[i] = convertRGBAToPixelColor( _targetFormat,
+			definitions[i].r, definitions[i].g, definitions[i].b ) ;
+
+	for ( Ceylan::Uint32 i = count; i < 256; i++ )
+		_colors[i] = 0 ;
+
+	_hasColorKey = useColorkey && palette.hasColorKey() ;
+
+	_colorKeyIndex = _hasColorKey ? palette.getColorKeyIndex() : 0 ;
+
+}
+
+
+
+PixelColor IndexedBlitTable::getPixelColorFor( Ceylan::Uint8 colorIndex ) const
+{
+
+	return _colors[ colorIndex ] ;
+
+}
+
+
+
+bool IndexedBlitTable::isCompatibleWith( const PixelFormat & format ) const
+{
+
+	return ( format.BytesPerPixel == _targetFormat.BytesPerPixel
+		&& format.Rmask == _targetFormat.Rmask
+		&& format.Gmask == _targetFormat.Gmask
+		&& format.Bmask == _targetFormat.Bmask ) ;
+
+}
+
+
+
+bool IndexedBlitTable::blit( const Surface & source,
+	Coordinate sourceX, Coordinate sourceY, Length width, Length height,
+	Surface & target, Coordinate x, Coordinate y ) const
+{
+
+#if OSDL_USES_SDL
+
+	if ( source.getBytesPerPixel() != 1 )
+		throw VideoException( "IndexedBlitTable::blit failed: "
+			"source surface is not an 8-bit one." ) ;
+
+	if ( ! isCompatibleWith( target.getPixelFormat() ) )
+		throw VideoException( "IndexedBlitTable::blit failed: "
+			"target surface has not the pixel format this table was built "
+			"for." ) ;
+
+	Ceylan::Sint32 sx = sourceX ;
+	Ceylan::Sint32 sy = sourceY ;
+	Ceylan::Sint32 w  = width ;
+	Ceylan::Sint32 h  = height ;
+	Ceylan::Sint32 dx = x ;
+	Ceylan::Sint32 dy = y ;
+
+	// Clips first against the source bounds:
+	if ( sx < 0 )
+	{
+		w  += sx ;
+		dx -= sx ;
+		sx  = 0 ;
+	}
+
+	if ( sy < 0 )
+	{
+		h  += sy ;
+		dy -= sy ;
+		sy  = 0 ;
+	}
+
+	if ( sx + w > source.getWidth() )
+		w = source.getWidth() - sx ;
+
+	if ( sy + h > source.getHeight() )
+		h = source.getHeight() - sy ;
+
+	// Then against the clipping area of the target:
+	const SDL_Rect & clip = target.getSDLSurface().clip_rect ;
+
+	if ( dx < clip.x )
+	{
+		w  -= clip.x - dx ;
+		sx += clip.x - dx ;
+		dx  = clip.x ;
+	}
+
+	if ( dy < clip.y )
+	{
+		h  -= clip.y - dy ;
+		sy += clip.y - dy ;
+		dy  = clip.y ;
+	}
+
+	if ( dx + w > clip.x + clip.w )
+		w = clip.x + clip.w - dx ;
+
+	if ( dy + h > clip.y + clip.h )
+		h = clip.y + clip.h - dy ;
+
+	if ( w <= 0 || h <= 0 )
+		return false ;
+
+	// The colorkey of the source prevails over the one of the palette:
+	bool useKey = _hasColorKey ;
+	Ceylan::Uint8 key = static_cast<Ceylan::Uint8>( _colorKeyIndex ) ;
+
+	if ( ( source.getFlags() & Surface::ColorkeyBlit ) != 0 )
+	{
+
+		useKey = true ;
+		key = static_cast<Ceylan::Uint8>( source.getPixelFormat().colorkey ) ;
+
+	}
+
+	// Locking does not modify the pixels:
+	Surface & lockedSource = const_cast<Surface &>( source ) ;
+
+	lockedSource.lock() ;
+	target.lock() ;
+
+	const Ceylan::Uint8 * sourceRow =
+		static_cast<const Ceylan::Uint8 *>( source.getPixels() )
+			+ sy * source.getPitch() + sx ;
+
+	BytesPerPixel bpp = _targetFormat.BytesPerPixel ;
+
+	Ceylan::Uint8 * targetRow = static_cast<Ceylan::Uint8 *>(
+		target.getPixels() ) + dy * target.getPitch() + dx * bpp ;
+
+	for ( Ceylan::Sint32 row = 0; row < h; row++ )
+	{
+
+		switch( bpp )
+		{
+
+			case 2:
+				BlitRowTo16Bits( sourceRow,
+					reinterpret_cast<Ceylan::Uint16 *>( targetRow ), w, _colors,
+					useKey, key ) ;
+				break ;
+
+			case 3:
+				BlitRowTo24Bits( sourceRow, targetRow, w, _colors, useKey,
+					key ) ;
+				break ;
+
+			default:
+				BlitRowTo32Bits( sourceRow,
+					reinterpret_cast<Ceylan::Uint32 *>( targetRow ), w, _colors,
+					useKey, key ) ;
+				break ;
+
+		}
+
+		sourceRow += source.getPitch() ;
+		targetRow += target.getPitch() ;
+
+	}
+
+	target.unlock() ;
+	lockedSource.unlock() ;
+
+	return true ;
+
+#else // OSDL_USES_SDL
+
+	throw VideoException( "IndexedBlitTable::blit failed: "
+		"no SDL support available" ) ;
+
+#endif // OSDL_USES_SDL
+
+}
+
+
+
+const string IndexedBlitTable::toString( Ceylan::VerbosityLevels level ) const
+{
+
+	string res = "Indexed blit table towards "
+		+ Ceylan::toNumericalString( _targetFormat.BytesPerPixel )
+		+ "-byte pixels" ;
+
+	if ( _hasColorKey )
+		res += ", with color index " + Ceylan::toString( _colorKeyIndex )
+			+ " being transparent" ;
+	else
+		res += ", with no transparent color index" ;
+
+	return res ;
+
+}
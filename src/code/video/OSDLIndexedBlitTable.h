@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#ifndef OSDL_INDEXED_BLIT_TABLE_H_
+#define OSDL_INDEXED_BLIT_TABLE_H_
+
+
+#include "OSDLPalette.h"         // for ColorCount
+#include "OSDLPixel.h"           // for PixelColor, PixelFormat
+#include "OSDLVideoTypes.h"      // for Coordinate, Length
+
+#include "Ceylan.h"              // for inheritance
+
+#include <string>
+
+
+
+
+namespace OSDL
+{
+
+
+	namespace Video
+	{
+
+
+		// Indexed blits read 8-bit surfaces and write to any other surface.
+		class Surface ;
+
+
+
+		/**
+		 * Precomputes, for a given palette and a given target pixel format,
+		 * the target pixel color of each of the 256 color indexes, so that an
+		 * 8-bit (indexed) surface can be blitted to a surface of that format
+		 * with a mere table lookup per pixel.
+		 *
+		 * Sprites can then be kept as 8-bit surfaces in memory (typically
+		 * loaded without display conversion), which divides their footprint by
+		 * up to four compared to 32-bit surfaces, and a palette swap (ex: team
+		 * colors) just means blitting through another table, with no
+		 * conversion of the sprite pixels.
+		 *
+		 * Indexed blits are opaque copies, except for the transparent index:
+		 * the colorkey of the source surface, if it has one, otherwise the
+		 * colorkey of the palette the table was built from, if requested.
+		 *
+		 * @see Surface::blitTo
+		 *
+		 */
+		class OSDL_DLL IndexedBlitTable : public Ceylan::TextDisplayable
+		{
+
+
+			public:
+
+
+
+				/**
+				 * Creates a table mapping the colors of specified palette to
+				 * specified pixel format.
+				 *
+				 * @param palette the palette whose colors are mapped. Its colors
+				 * are copied, it can be deallocated afterwards.
+				 *
+				 * @param targetFormat the pixel format of the surfaces that
+				 * will be blitted to, typically the one of the screen.
+				 *
+				 * @param useColorkey if true and if the palette has a colorkey,
+				 * this color index will be transparent when blitting a surface
+				 * with no colorkey of its own.
+				 *
+				 * @throw VideoException if the target format is an indexed
+				 * one.
+				 *
+				 */
+				IndexedBlitTable( const Palette & palette,
+					const Pixels::PixelFormat & targetFormat,
+					bool useColorkey = true ) ;
+
+
+
+				/// Virtual destructor.
+				virtual ~IndexedBlitTable() throw() ;
+
+
+
+				/**
+				 * Recomputes this table from the colors of specified palette,
+				 * for the same target pixel format, for example after this
+				 * palette has been modified.
+				 *
+				 * @param palette the palette whose colors are mapped.
+				 *
+				 * @param useColorkey tells whether the colorkey of the palette,
+				 * if any, should be taken into account.
+				 *
+				 */
+				virtual void update( const Palette & palette,
+					bool useColorkey = true ) ;
+
+
+
+				/**
+				 * Returns the target pixel color corresponding to specified
+				 * color index.
+				 *
+				 */
+				virtual Pixels::PixelColor getPixelColorFor(
+					Ceylan::Uint8 colorIndex ) const ;
+
+
+
+				/**
+				 * Tells whether this table can be used to blit to surfaces of
+				 * specified pixel format.
+				 *
+				 */
+				virtual bool isCompatibleWith(
+					const Pixels::PixelFormat & format ) const ;
+
+
+
+				/**
+				 * Blits the specified area of an 8-bit source surface onto the
+				 * specified target surface, through this table.
+				 *
+				 * Both surfaces are clipped (the target one according to its
+				 * clipping area), and locked if necessary.
+				 *
+				 * @param source the 8-bit surface to blit.
+				 *
+				 * @param sourceX the abscissa of the upper-left corner of the
+				 * area of the source to blit.
+				 *
+				 * @param sourceY the ordinate of the upper-left corner of the
+				 * area of the source to blit.
+				 *
+				 * @param width the width of the area to blit.
+				 *
+				 * @param height the height of the area to blit.
+				 *
+				 * @param target the surface to blit to, whose pixel format
+				 * must be compatible with this table.
+				 *
+				 * @param x the abscissa in the target surface where the area
+				 * is to be blitted.
+				 *
+				 * @param y the ordinate in the target surface where the area
+				 * is to be blitted.
+				 *
+				 * @return true if at least one pixel was written.
+				 *
+				 * @throw VideoException if the source is not an 8-bit surface,
+				 * or if the target format is not compatible with this table.
+				 *
+				 */
+				virtual bool blit( const Surface & source,
+					Coordinate sourceX, Coordinate sourceY,
+					Length width, Length height,
+					Surface & target, Coordinate x, Coordinate y ) const ;
+
+
+
+				/**
+				 * Returns an user-friendly description of the state of this
+				 * object.
+				 *
+				 * @param level the requested verbosity level.
+				 *
+				 * @note Text output format is determined from overall settings.
+				 *
+				 * @see Ceylan::TextDisplayable
+				 *
+				 */
+				virtual const std::string toString(
+					Ceylan::VerbosityLevels level = Ceylan::high ) const ;
+
+
+
+			protected:
+
+
+
+				/// The target pixel color of each color index.
+				Pixels::PixelColor _colors[ 256 ] ;
+
+
+				/// Tells whether the palette colorkey is to be used.
+				bool _hasColorKey ;
+
+
+				/// The color index of the palette colorkey, if used.
+				ColorCount _colorKeyIndex ;
+
+
+				/// A copy of the target pixel format, with no palette.
+				Pixels::PixelFormat _targetFormat ;
+
+
+		} ;
+
+	}
+
+}
+
+
+
+#endif // OSDL_INDEXED_BLIT_TABLE_H_
@@ -26,14 +26,20 @@
 
 #include "OSDLPalette.h"
 
-#include "OSDLSurface.h"  // for Surface
-#include "OSDLFileTags.h" // for PaletteTag
+#include "OSDLSurface.h"        // for Surface
+#include "OSDLFileTags.h"       // for PaletteTag
+#include "OSDLColorHistogram.h" // for ColorHistogram, ColorSample
+#include "OSDLColorLookupTable.h" // for ColorLookupTable
+#include "OSDLWorkerPool.h"     // for WorkerPool, Job
+#include "OSDLContentSpan.h"    // for ContentSpan
 
 #include "Ceylan.h"       // for Ceil, File, etc.
 
 
 
 #include <list>
+#include <vector>
+#include <algorithm>      // for std::sort
 
 
 using std::string ;
@@ -77,6 +83,293 @@ const Ceylan::Flags Palette::Physical = 0x02 ;
 
 
 
+// 5 bits for red and blue, 6 bits for green:
+const Ceylan::Uint32 Palette::InverseColormapSize = 32 * 64 * 32 ;
+
+// No palette may have that many colors:
+const ColorCount Palette::UnsetColormapCell = 0xffff ;
+
+
+
+/*
+ * Helpers for the generation of optimized palettes.
+ *
+ * Components are designated by an axis: 0 for red, 1 for green, 2 for blue.
+ *
+ */
+
+
+/// A box of samples, as partitioned by median-cut.
+struct SampleBox
+{
+
+	/// Index of the first sample of this box.
+	Ceylan::Uint32 first ;
+
+	/// Index of the sample just after the last one of this box.
+	Ceylan::Uint32 end ;
+
+	/// The component along which this box would be split.
+	Ceylan::Uint8 axis ;
+
+	/// The weighted variance along that component.
+	Ceylan::Float64 score ;
+
+} ;
+
+
+
+static ColorElement GetComponent( const ColorDefinition & color,
+	Ceylan::Uint8 axis )
+{
+
+	switch( axis )
+	{
+
+		case 0:
+			return color.r ;
+
+		case 1:
+			return color.g ;
+
+		default:
+			return color.b ;
+
+	}
+
+}
+
+
+
+/// Orders samples according to one of their components.
+struct ComponentComparator
+{
+
+	Ceylan::Uint8 axis ;
+
+	bool operator() ( const ColorSample & first,
+		const ColorSample & second ) const
+	{
+
+		return GetComponent( first.color, axis )
+			< GetComponent( second.color, axis ) ;
+
+	}
+
+} ;
+
+
+
+/// Determines the component along which specified box should be split.
+static void AnalyzeBox( const std::vector<ColorSample> & samples,
+	SampleBox & box )
+{
+
+	box.axis  = 0 ;
+	box.score = 0 ;
+
+	if ( box.end - box.first < 2 )
+		return ;
+
+	for ( Ceylan::Uint8 axis = 0; axis < 3; axis++ )
+	{
+
+		Ceylan::Float64 weight = 0, sum = 0, squareSum = 0 ;
+
+		ColorElement min = 255, max = 0 ;
+
+		for ( Ceylan::Uint32 i = box.first; i < box.end; i++ )
+		{
+
+			ColorElement element = GetComponent( samples[i].color, axis ) ;
+
+			if ( element < min )
+				min = element ;
+
+			if ( element > max )
+				max = element ;
+
+			Ceylan::Float64 component = element ;
+
+			weight    += samples[i].weight ;
+			sum       += samples[i].weight * component ;
+			squareSum += samples[i].weight * component * component ;
+
+		}
+
+		// Nothing to split along this component:
+		if ( min == max )
+			continue ;
+
+		// Total (not normalized) variance, so that big boxes are split first:
+		Ceylan::Float64 variance = squareSum - sum * sum / weight ;
+
+		if ( variance > box.score )
+		{
+
+			box.axis  = axis ;
+			box.score = variance ;
+
+		}
+
+	}
+
+}
+
+
+
+/// Returns the weighted average color of the specified samples.
+static ColorDefinition GetAverageOf( const std::vector<ColorSample> & samples,
+	Ceylan::Uint32 first, Ceylan::Uint32 end )
+{
+
+	Ceylan::Float64 weight = 0, red = 0, green = 0, blue = 0 ;
+
+	for ( Ceylan::Uint32 i = first; i < end; i++ )
+	{
+
+		weight += samples[i].weight ;
+		red    += samples[i].weight * samples[i].color.r ;
+		green  += samples[i].weight * samples[i].color.g ;
+		blue   += samples[i].weight * samples[i].color.b ;
+
+	}
+
+	ColorDefinition res ;
+
+	res.r      = static_cast<ColorElement>( red   / weight + 0.5 ) ;
+	res.g      = static_cast<ColorElement>( green / weight + 0.5 ) ;
+	res.b      = static_cast<ColorElement>( blue  / weight + 0.5 ) ;
+	res.unused = Pixels::AlphaOpaque ;
+
+	return res ;
+
+}
+
+
+
+/**
+ * Assigns a range of samples to their closest center, and sums them per
+ * center, for one k-means iteration.
+ *
+ */
+class KMeansAssignmentJob : public OSDL::Job
+{
+
+	public:
+
+
+		KMeansAssignmentJob( const std::vector<ColorSample> & samples,
+				const std::vector<ColorDefinition> & centers,
+				std::vector<ColorCount> & assignments,
+				Ceylan::Uint32 first, Ceylan::Uint32 end ) :
+			OSDL::Job( "k-means assignment of samples "
+				+ Ceylan::toString( first ) + " to "
+				+ Ceylan::toString( end - 1 ) ),
+			_samples( samples ),
+			_centers( centers ),
+			_assignments( assignments ),
+			_first( first ),
+			_end( end ),
+			_reassignedCount( 0 )
+		{
+
+		}
+
+
+		virtual ~KMeansAssignmentJob() throw()
+		{
+
+		}
+
+
+		virtual void execute()
+		{
+
+			// Weight, then red, green and blue sums, for each center:
+			_sums.assign( 4 * _centers.size(), 0 ) ;
+
+			_reassignedCount = 0 ;
+
+			for ( Ceylan::Uint32 i = _first; i < _end; i++ )
+			{
+
+				const ColorSample & sample = _samples[i] ;
+
+				ColorCount best = 0 ;
+				ColorDistance smallest = Palette::GetDistance( sample.color,
+					_centers[0] ) ;
+
+				for ( ColorCount c = 1; c < _centers.size(); c++ )
+				{
+
+					ColorDistance current = Palette::GetDistance(
+						sample.color, _centers[c] ) ;
+
+					if ( current < smallest )
+					{
+
+						smallest = current ;
+						best = c ;
+
+					}
+
+				}
+
+				if ( _assignments[i] != best )
+				{
+
+					_assignments[i] = best ;
+					_reassignedCount++ ;
+
+				}
+
+				_sums[ 4 * best ]     += sample.weight ;
+				_sums[ 4 * best + 1 ] += sample.weight * sample.color.r ;
+				_sums[ 4 * best + 2 ] += sample.weight * sample.color.g ;
+				_sums[ 4 * best + 3 ] += sample.weight * sample.color.b ;
+
+			}
+
+		}
+
+
+		const std::vector<Ceylan::Float64> & getSums() const
+		{
+
+			return _sums ;
+
+		}
+
+
+		Ceylan::Uint32 getReassignedCount() const
+		{
+
+			return _reassignedCount ;
+
+		}
+
+
+	protected:
+
+		const std::vector<ColorSample> & _samples ;
+
+		const std::vector<ColorDefinition> & _centers ;
+
+		std::vector<ColorCount> & _assignments ;
+
+		Ceylan::Uint32 _first ;
+
+		Ceylan::Uint32 _end ;
+
+		Ceylan::Uint32 _reassignedCount ;
+
+		std::vector<Ceylan::Float64> _sums ;
+
+} ;
+
+
+
 
 PaletteException::PaletteException( const string & message ) :
 	VideoException( "Palette exception: " + message )
@@ -101,6 +394,8 @@ Palette::Palette( ColorCount numberOfColors, ColorDefinition * colors,
 	_pixelColors( 0 ),
 	_converted( false ),
 	_ownsColorDefinition( true ),
+	_inverseColormap( 0 ),
+	_inverseColormapChecksum( 0 ),
 	_hasColorkey( false ),
 	_colorKeyIndex( 0 )
 {
@@ -131,6 +426,8 @@ Palette::Palette( const LowLevelPalette & palette ) :
 	_pixelColors( 0 ),
 	_converted( false ),
 	_ownsColorDefinition( false ),
+	_inverseColormap( 0 ),
+	_inverseColormapChecksum( 0 ),
 	_hasColorkey( false ),
 	_colorKeyIndex( 0 )
 {
@@ -158,6 +455,8 @@ Palette::Palette( const string & paletteFilename ) :
 	_pixelColors( 0 ),
 	_converted( false ),
 	_ownsColorDefinition( true ),
+	_inverseColormap( 0 ),
+	_inverseColormapChecksum( 0 ),
 	_hasColorkey( false ),
 	_colorKeyIndex( 0 )
 {
@@ -165,13 +464,21 @@ Palette::Palette( const string & paletteFilename ) :
 	try
 	{
 
-		Size fileSize = File::GetSize( paletteFilename ) ;
+		// Parsed in place, rather than read byte per byte:
+		ContentSpan paletteSpan( paletteFilename ) ;
 
-		Ceylan::Holder<File> paletteHolder( File::Open( paletteFilename ) ) ;
+		const Ceylan::Byte * content = paletteSpan.getData() ;
+		Size fileSize = paletteSpan.getSize() ;
 
+		// Tag and colorkey flag:
+		if ( fileSize < 3 )
+			throw PaletteException( "Palette constructor from file failed: "
+				"palette file '" + paletteFilename + "' is too short." ) ;
 
-		// First check the OSDL palette tag:
-		FileTag readTag = paletteHolder->readUint16() ;
+		// First check the OSDL palette tag (little-endian, as all tags):
+		FileTag readTag = static_cast<FileTag>(
+			content[0] | ( content[1] << 8 ) ) ;
+		content  += sizeof( PaletteTag ) ;
 		fileSize -= sizeof( PaletteTag ) ;
 
 		if ( readTag != PaletteTag )
@@ -182,13 +489,24 @@ Palette::Palette( const string & paletteFilename ) :
 				+ DescribeFileTag( readTag ) ) ;
 
 
-		bool hasColorkey = ( paletteHolder->readUint8() != 0 ) ;
+		bool hasColorkey = ( *content != 0 ) ;
+		content++ ;
 		fileSize-- ;
 
 		if ( hasColorkey )
 		{
-			setColorKeyIndex( paletteHolder->readUint16() ) ;
+
+			if ( fileSize < 2 )
+				throw PaletteException( "Palette constructor from file failed: "
+					"truncated colorkey in palette file '" + paletteFilename
+					+ "'." ) ;
+
+			setColorKeyIndex( static_cast<ColorCount>(
+				content[0] | ( content[1] << 8 ) ) ) ;
+
+			content  += 2 ;
 			fileSize -= 2 ;
+
 		}
 
 		// Header read, now reading colors:
@@ -217,14 +535,11 @@ Palette::Palette( const string & paletteFilename ) :
 		for ( ColorCount i = 0; i < colorCount; i++ )
 		{
 
-			colorDefs[i].r = static_cast<ColorElement>(
-				paletteHolder->readUint8() ) ;
+			colorDefs[i].r = static_cast<ColorElement>( content[ 3 * i ] ) ;
 
-			colorDefs[i].g = static_cast<ColorElement>(
-				paletteHolder->readUint8() ) ;
+			colorDefs[i].g = static_cast<ColorElement>( content[ 3 * i + 1 ] ) ;
 
-			colorDefs[i].b = static_cast<ColorElement>(
-				paletteHolder->readUint8() ) ;
+			colorDefs[i].b = static_cast<ColorElement>( content[ 3 * i + 2 ] ) ;
 
 			colorDefs[i].unused = Pixels::AlphaOpaque ;
 
@@ -373,6 +688,8 @@ void Palette::setColorDefinitionAt(	ColorCount targetIndex,
 
 	_colorDefs[ targetIndex ] = newColorDefinition ;
 
+	invalidateInverseColormap() ;
+
 }
 
 
@@ -395,6 +712,8 @@ void Palette::setColorDefinitionAt(	ColorCount targetIndex,
 	_colorDefs[ targetIndex ].b      = blue ;
 	_colorDefs[ targetIndex ].unused = alpha ;
 
+	invalidateInverseColormap() ;
+
 }
 
 
@@ -439,6 +758,9 @@ void Palette::setColorKeyIndex( ColorCount colorkeyIndex )
 
 	_colorKeyIndex = colorkeyIndex ;
 
+	// The colorkey is not a candidate anymore:
+	invalidateInverseColormap() ;
+
 }
 
 
@@ -479,39 +801,39 @@ void Palette::quantize( Pixels::ColorElement quantizeMaxCoordinate,
 	bool scaleUp )
 {
 
-	for ( ColorCount index = 0; index < _numberOfColors; index++ )
-	{
+	ColorLookupTable table ;
+	table.setQuantization( quantizeMaxCoordinate, scaleUp ) ;
 
-		_colorDefs[index].r = QuantizeComponent( _colorDefs[index].r,
-			quantizeMaxCoordinate ) ;
+	applyLookupTable( table, /* includeColorkey */ true ) ;
 
-		_colorDefs[index].g = QuantizeComponent( _colorDefs[index].g,
-			quantizeMaxCoordinate ) ;
+}
 
-		_colorDefs[index].b = QuantizeComponent( _colorDefs[index].b,
-			quantizeMaxCoordinate ) ;
 
-		// Alpha left as is.
 
+void Palette::correctGamma( GammaFactor gamma )
+{
 
-		if ( scaleUp )
-		{
+	ColorLookupTable table ;
+	table.setGammaCorrection( gamma ) ;
 
-			_colorDefs[index].r = static_cast<ColorElement>(
-				Ceylan::Maths::Round(
-					_colorDefs[index].r * 255.0f / quantizeMaxCoordinate ) ) ;
+	applyLookupTable( table, /* includeColorkey */ false ) ;
 
-			_colorDefs[index].g = static_cast<ColorElement>(
-				Ceylan::Maths::Round(
-					_colorDefs[index].g * 255.0f / quantizeMaxCoordinate ) ) ;
+}
 
-			_colorDefs[index].b = static_cast<ColorElement>(
-				Ceylan::Maths::Round(
-					_colorDefs[index].b * 255.0f / quantizeMaxCoordinate ) ) ;
 
-			// Alpha left as is.
 
-		}
+void Palette::applyLookupTable( const ColorLookupTable & table,
+	bool includeColorkey )
+{
+
+	for ( ColorCount index = 0; index < _numberOfColors; index++ )
+	{
+
+		if ( ! includeColorkey && _hasColorkey && ( index == _colorKeyIndex ) )
+			continue ;
+
+		// Alpha left as is:
+		table.applyTo( _colorDefs[index] ) ;
 
 	}
 
@@ -521,40 +843,85 @@ void Palette::quantize( Pixels::ColorElement quantizeMaxCoordinate,
 
 
 
-void Palette::correctGamma( GammaFactor gamma )
+ColorCount Palette::getClosestColorIndexTo(	const ColorDefinition & color )
+	const
 {
 
-	for ( ColorCount index = 0; index < _numberOfColors; index++ )
-	{
+	if ( _numberOfColors == 0 )
+		throw PaletteException( "Palette::getClosestColorIndexTo failed: "
+			"no color in palette." ) ;
 
-		if ( _hasColorkey && ( index == _colorKeyIndex ) )
-			continue ;
+	prepareInverseColormap() ;
+
+	return getInverseColormapIndexFor( color ) ;
+
+}
+
+
+
+void Palette::computeInverseColormap() const
+{
+
+	if ( _numberOfColors == 0 )
+		throw PaletteException( "Palette::computeInverseColormap failed: "
+			"no color in palette." ) ;
+
+	prepareInverseColormap() ;
 
-		_colorDefs[index].r = CorrectGammaComponent( _colorDefs[index].r,
-			gamma ) ;
+	ColorDefinition color ;
+	color.unused = Pixels::AlphaOpaque ;
 
-		_colorDefs[index].g = CorrectGammaComponent( _colorDefs[index].g,
-			gamma ) ;
+	// Iterates on cell centers, already known cells are skipped:
+	for ( Ceylan::Uint32 red = 0; red < 32; red++ )
+		for ( Ceylan::Uint32 green = 0; green < 64; green++ )
+			for ( Ceylan::Uint32 blue = 0; blue < 32; blue++ )
+			{
+
+				color.r = static_cast<ColorElement>( ( red << 3 ) | 0x04 ) ;
+				color.g = static_cast<ColorElement>( ( green << 2 ) | 0x02 ) ;
+				color.b = static_cast<ColorElement>( ( blue << 3 ) | 0x04 ) ;
 
-		_colorDefs[index].b = CorrectGammaComponent( _colorDefs[index].b,
-			gamma ) ;
+				getInverseColormapIndexFor( color ) ;
 
-		// Alpha left as is.
+			}
+
+}
+
+
+
+ColorCount Palette::getInverseColormapIndexFor(
+	const ColorDefinition & color ) const
+{
+
+	Ceylan::Uint32 cell = GetInverseColormapCellFor( color ) ;
+
+	if ( _inverseColormap[cell] == UnsetColormapCell )
+	{
+
+		// Computes this cell once for all, from its center:
+		ColorDefinition center ;
+
+		center.r = static_cast<ColorElement>( ( color.r & 0xf8 ) | 0x04 ) ;
+		center.g = static_cast<ColorElement>( ( color.g & 0xfc ) | 0x02 ) ;
+		center.b = static_cast<ColorElement>( ( color.b & 0xf8 ) | 0x04 ) ;
+		center.unused = Pixels::AlphaOpaque ;
+
+		_inverseColormap[cell] = getExactClosestColorIndexTo( center ) ;
 
 	}
 
-	invalidatePixelColors() ;
+	return _inverseColormap[cell] ;
 
 }
 
 
 
-ColorCount Palette::getClosestColorIndexTo(	const ColorDefinition & color )
-	const
+ColorCount Palette::getExactClosestColorIndexTo(
+	const ColorDefinition & color ) const
 {
 
 	if ( _numberOfColors == 0 )
-		throw PaletteException( "Palette::getClosestColorIndexTo failed: "
+		throw PaletteException( "Palette::getExactClosestColorIndexTo failed: "
 			"no color in palette." ) ;
 
 	bool initialized = false ;
@@ -996,6 +1363,267 @@ Palette & Palette::CreateMasterPalette( bool addColorkey )
 
 
 
+Palette & Palette::CreateOptimizedPalette( const ColorHistogram & histogram,
+	ColorCount numberOfColors, GenerationMethod method, bool addColorkey,
+	WorkerPool * pool, Ceylan::Uint32 maxIterations )
+{
+
+	std::vector<ColorSample> samples ;
+	histogram.getSamples( samples ) ;
+
+	if ( samples.empty() )
+		throw PaletteException( "Palette::CreateOptimizedPalette failed: "
+			"empty histogram." ) ;
+
+	ColorCount targetCount = numberOfColors ;
+
+	if ( addColorkey )
+	{
+
+		if ( targetCount < 2 )
+			throw PaletteException( "Palette::CreateOptimizedPalette failed: "
+				"at least two colors are needed, one being the colorkey." ) ;
+
+		targetCount-- ;
+
+	}
+
+
+	// Median-cut partitioning:
+
+	std::vector<SampleBox> boxes ;
+
+	SampleBox box ;
+	box.first = 0 ;
+	box.end   = static_cast<Ceylan::Uint32>( samples.size() ) ;
+	AnalyzeBox( samples, box ) ;
+
+	boxes.push_back( box ) ;
+
+	while ( boxes.size() < targetCount )
+	{
+
+		// Selects the box whose split should decrease the most the error:
+		std::vector<SampleBox>::size_type selected = 0 ;
+
+		for ( std::vector<SampleBox>::size_type i = 1; i < boxes.size(); i++ )
+			if ( boxes[i].score > boxes[selected].score )
+				selected = i ;
+
+		SampleBox & toSplit = boxes[selected] ;
+
+		// Only boxes of a single color, or of identical ones, remain:
+		if ( toSplit.score == 0 )
+			break ;
+
+		ComponentComparator comparator ;
+		comparator.axis = toSplit.axis ;
+
+		std::sort( samples.begin() + toSplit.first,
+			samples.begin() + toSplit.end, comparator ) ;
+
+		Ceylan::Float64 totalWeight = 0 ;
+
+		for ( Ceylan::Uint32 i = toSplit.first; i < toSplit.end; i++ )
+			totalWeight += samples[i].weight ;
+
+		// Weighted median, each half keeping at least one sample:
+		Ceylan::Uint32 median = toSplit.first + 1 ;
+		Ceylan::Float64 lowerWeight = samples[toSplit.first].weight ;
+
+		while ( median < toSplit.end - 1 && lowerWeight < totalWeight / 2 )
+		{
+
+			lowerWeight += samples[median].weight ;
+			median++ ;
+
+		}
+
+		SampleBox upper ;
+		upper.first = median ;
+		upper.end   = toSplit.end ;
+		AnalyzeBox( samples, upper ) ;
+
+		toSplit.end = median ;
+		AnalyzeBox( samples, toSplit ) ;
+
+		// Invalidates the toSplit reference:
+		boxes.push_back( upper ) ;
+
+	}
+
+	std::vector<ColorDefinition> centers ;
+
+	for ( std::vector<SampleBox>::const_iterator it = boxes.begin();
+			it != boxes.end(); it++ )
+		centers.push_back( GetAverageOf( samples, (*it).first, (*it).end ) ) ;
+
+
+	// Optional k-means refinement:
+
+	if ( method == KMeans )
+	{
+
+		// No valid index, so that all samples are counted as reassigned:
+		std::vector<ColorCount> assignments( samples.size(),
+			UnsetColormapCell ) ;
+
+		Ceylan::Uint32 jobCount = 1 ;
+
+		if ( pool != 0 )
+			jobCount = 4 * pool->getWorkerCount() ;
+
+		Ceylan::Uint32 sampleCount = static_cast<Ceylan::Uint32>(
+			samples.size() ) ;
+
+		if ( jobCount > sampleCount )
+			jobCount = sampleCount ;
+
+		std::vector<KMeansAssignmentJob *> jobs ;
+
+		for ( Ceylan::Uint32 j = 0; j < jobCount; j++ )
+			jobs.push_back( new KMeansAssignmentJob( samples, centers,
+				assignments, /* first */ ( sampleCount * j ) / jobCount,
+				/* end */ ( sampleCount * ( j + 1 ) ) / jobCount ) ) ;
+
+		string failureReason ;
+
+		for ( Ceylan::Uint32 iteration = 0; iteration < maxIterations;
+			iteration++ )
+		{
+
+			if ( pool != 0 )
+			{
+
+				std::vector<KMeansAssignmentJob *>::size_type submitted = 0 ;
+
+				try
+				{
+
+					for ( ; submitted < jobs.size(); submitted++ )
+						pool->submit( * jobs[submitted] ) ;
+
+				}
+				catch( const WorkerPoolException & e )
+				{
+
+					failureReason = e.toString() ;
+
+				}
+
+				for ( std::vector<KMeansAssignmentJob *>::size_type i = 0;
+					i < submitted; i++ )
+				{
+
+					pool->waitFor( * jobs[i] ) ;
+
+					if ( failureReason.empty()
+							&& pool->getStateOf( * jobs[i] ) == Job::Failed )
+						failureReason = jobs[i]->getName() + ": "
+							+ pool->getFailureReasonFor( * jobs[i] ) ;
+
+				}
+
+			}
+			else
+			{
+
+				for ( std::vector<KMeansAssignmentJob *>::iterator it =
+						jobs.begin(); it != jobs.end(); it++ )
+					(*it)->execute() ;
+
+			}
+
+			if ( ! failureReason.empty() )
+				break ;
+
+			Ceylan::Uint32 reassignedCount = 0 ;
+
+			std::vector<Ceylan::Float64> sums( 4 * centers.size(), 0 ) ;
+
+			for ( std::vector<KMeansAssignmentJob *>::const_iterator it =
+				jobs.begin(); it != jobs.end(); it++ )
+			{
+
+				reassignedCount += (*it)->getReassignedCount() ;
+
+				const std::vector<Ceylan::Float64> & jobSums =
+					(*it)->getSums() ;
+
+				for ( std::vector<Ceylan::Float64>::size_type i = 0;
+						i < sums.size(); i++ )
+					sums[i] += jobSums[i] ;
+
+			}
+
+			if ( reassignedCount == 0 )
+				break ;
+
+			// Empty clusters keep their center:
+			for ( std::vector<ColorDefinition>::size_type c = 0;
+				c < centers.size(); c++ )
+			{
+
+				Ceylan::Float64 weight = sums[ 4 * c ] ;
+
+				if ( weight == 0 )
+					continue ;
+
+				centers[c].r = static_cast<ColorElement>(
+					sums[ 4 * c + 1 ] / weight + 0.5 ) ;
+
+				centers[c].g = static_cast<ColorElement>(
+					sums[ 4 * c + 2 ] / weight + 0.5 ) ;
+
+				centers[c].b = static_cast<ColorElement>(
+					sums[ 4 * c + 3 ] / weight + 0.5 ) ;
+
+			}
+
+		}
+
+		for ( std::vector<KMeansAssignmentJob *>::iterator it = jobs.begin();
+				it != jobs.end(); it++ )
+			delete *it ;
+
+		if ( ! failureReason.empty() )
+			throw PaletteException( "Palette::CreateOptimizedPalette failed: "
+				+ failureReason ) ;
+
+	}
+
+
+	ColorCount colorCount = static_cast<ColorCount>( centers.size() ) ;
+
+	if ( addColorkey )
+		colorCount++ ;
+
+	Palette & palette = * new Palette( colorCount ) ;
+
+	colorCount = 0 ;
+
+	if ( addColorkey )
+	{
+
+		// Same convention as for the DS and CreateMasterPalette:
+		const ColorCount colorKeyIndex = 0 ;
+
+		palette.setColorDefinitionAt( colorKeyIndex, Pixels::DefaultColorkey ) ;
+		palette.setColorKeyIndex( colorKeyIndex ) ;
+		colorCount++ ;
+
+	}
+
+	for ( std::vector<ColorDefinition>::const_iterator it = centers.begin();
+			it != centers.end(); it++ )
+		palette.setColorDefinitionAt( colorCount++, *it ) ;
+
+	return palette ;
+
+}
+
+
+
 
 
 // Protected section.
@@ -1015,6 +1643,79 @@ void Palette::invalidatePixelColors()
 
 	// Will have to be recomputed when needed.
 
+	invalidateInverseColormap() ;
+
+}
+
+
+
+void Palette::invalidateInverseColormap()
+{
+
+	if ( _inverseColormap != 0 )
+	{
+
+		delete [] _inverseColormap ;
+		_inverseColormap = 0 ;
+
+	}
+
+}
+
+
+
+void Palette::prepareInverseColormap() const
+{
+
+	/*
+	 * Borrowed color definitions (ex: the ones of a surface palette) may be
+	 * changed behind our back, for example by a PaletteAnimator, whereas
+	 * owned ones are only changed by methods invalidating the colormap:
+	 *
+	 */
+	if ( _inverseColormap != 0 && ! _ownsColorDefinition
+			&& getColorChecksum() != _inverseColormapChecksum )
+	{
+
+		delete [] _inverseColormap ;
+		_inverseColormap = 0 ;
+
+	}
+
+	if ( _inverseColormap == 0 )
+	{
+
+		_inverseColormap = new ColorCount[ InverseColormapSize ] ;
+
+		for ( Ceylan::Uint32 i = 0; i < InverseColormapSize; i++ )
+			_inverseColormap[i] = UnsetColormapCell ;
+
+		if ( ! _ownsColorDefinition )
+			_inverseColormapChecksum = getColorChecksum() ;
+
+	}
+
+}
+
+
+
+Ceylan::Uint32 Palette::getColorChecksum() const
+{
+
+	// FNV-1a over the color components, alpha being ignored:
+	Ceylan::Uint32 checksum = 2166136261U ;
+
+	for ( ColorCount i = 0; i < _numberOfColors; i++ )
+	{
+
+		checksum = ( checksum ^ _colorDefs[i].r ) * 16777619U ;
+		checksum = ( checksum ^ _colorDefs[i].g ) * 16777619U ;
+		checksum = ( checksum ^ _colorDefs[i].b ) * 16777619U ;
+
+	}
+
+	return checksum ;
+
 }
 
 
@@ -1070,3 +1771,16 @@ ColorDistance Palette::GetDistance(
 	return ( ((512+rmean)*rs)>>8 ) + 4*gs + ( ((767-rmean)*bs)>>8 ) ;
 
 }
+
+
+
+Ceylan::Uint32 Palette::GetInverseColormapCellFor(
+	const Pixels::ColorDefinition & color )
+{
+
+	// 5 bits of red, then 6 bits of green, then 5 bits of blue:
+	return ( static_cast<Ceylan::Uint32>( color.r >> 3 ) << 11 )
+		| ( static_cast<Ceylan::Uint32>( color.g >> 2 ) << 5 )
+		| static_cast<Ceylan::Uint32>( color.b >> 3 ) ;
+
+}
@@ -54,11 +54,22 @@ namespace OSDL
 {
 
 
+	// Optimized palettes can be generated thanks to a pool of workers.
+	class WorkerPool ;
+
+
 
 	namespace Video
 	{
 
 
+		// Optimized palettes are generated from histograms.
+		class ColorHistogram ;
+
+		// Palettes can be mapped thanks to lookup tables.
+		class ColorLookupTable ;
+
+
 
 		/**
 		 * Number of colors.
@@ -167,6 +178,20 @@ namespace OSDL
 
 
 
+				/// Describes how optimized palettes are generated.
+				enum GenerationMethod
+				{
+
+					/// Median-cut partitioning only.
+					MedianCut,
+
+					/// Median-cut partitioning, refined by k-means.
+					KMeans
+
+				} ;
+
+
+
 				/// The flag used to designate logical palette.
 				static const Ceylan::Flags Logical ;
 
@@ -422,6 +447,8 @@ namespace OSDL
 				 * to 15. With scaleUp set to true, it will be scaled back,
 				 * which leads, due to the roundings, to 123.
 				 *
+				 * @throw VideoException if quantizeMaxCoordinate is null.
+				 *
 				 */
 				virtual void quantize(
 					Pixels::ColorElement quantizeMaxCoordinate,
@@ -448,10 +475,34 @@ namespace OSDL
 
 
 
+				/**
+				 * Maps the color definitions of this palette thanks to
+				 * specified lookup table.
+				 *
+				 * @param table the table to apply to the red, green and blue
+				 * components, alpha being left as is.
+				 *
+				 * @param includeColorkey tells whether the colorkey, if any,
+				 * is to be mapped as well.
+				 *
+				 */
+				virtual void applyLookupTable( const ColorLookupTable & table,
+					bool includeColorkey = false ) ;
+
+
+
 				/**
 				 * Returns the index of the color definition in the palette that
 				 * matches the most closely to specified color.
 				 *
+				 * The search is made through the inverse colormap of this
+				 * palette: the color is first reduced to 5 bits for red and
+				 * blue and 6 bits for green, and the corresponding cell of the
+				 * colormap tells directly which palette index is the closest
+				 * to the center of that cell. Cells are computed lazily, the
+				 * first time a color falling into them is requested, thus
+				 * reducing a whole surface ends up being mostly table lookups.
+				 *
 				 * @throw PaletteException if the palette does not have at least
 				 * one color.
 				 *
@@ -460,12 +511,58 @@ namespace OSDL
 				 * @note If a colorkey is defined, it will not be taken into
 				 * account as a possible color match.
 				 *
+				 * @note As colors are reduced to 5/6/5 bits first, the result
+				 * is the one getExactClosestColorIndexTo returns for the center
+				 * of the cell of the specified color; it may thus differ for
+				 * colors lying near the boundary between two palette colors.
+				 *
+				 * @see getExactClosestColorIndexTo
+				 *
 				 */
 				virtual ColorCount getClosestColorIndexTo(
 					const Pixels::ColorDefinition & color ) const ;
 
 
 
+				/**
+				 * Returns the index of the color definition in the palette that
+				 * matches the most closely to specified color, by scanning all
+				 * the color definitions of the palette at full precision.
+				 *
+				 * @throw PaletteException if the palette does not have at least
+				 * one color.
+				 *
+				 * @note Uses GetDistance as a metric.
+				 *
+				 * @note If a colorkey is defined, it will not be taken into
+				 * account as a possible color match.
+				 *
+				 * @note Far slower than getClosestColorIndexTo when many
+				 * colors are to be matched.
+				 *
+				 */
+				virtual ColorCount getExactClosestColorIndexTo(
+					const Pixels::ColorDefinition & color ) const ;
+
+
+
+				/**
+				 * Computes all the cells of the inverse colormap of this
+				 * palette that were not computed yet.
+				 *
+				 * Once done, getClosestColorIndexTo does not modify this
+				 * palette anymore, and thus can be called concurrently from
+				 * multiple threads, as long as the palette is not changed
+				 * meanwhile.
+				 *
+				 * @throw PaletteException if the palette does not have at least
+				 * one color.
+				 *
+				 */
+				virtual void computeInverseColormap() const ;
+
+
+
 				/**
 				 * Draws in specified surface a series of horizontal lines
 				 * taking its full width, each line being drawn with the color
@@ -626,6 +723,69 @@ namespace OSDL
 
 
 
+				/**
+				 * Palette factory, creating a palette best suited to the
+				 * colors counted by specified histogram, typically fed with
+				 * the pixels of a whole corpus of images.
+				 *
+				 * The colors of the histogram are first partitioned by
+				 * median-cut: starting from a single box enclosing them all,
+				 * the box with the highest weighted variance along one of its
+				 * components is split at the weighted median of that
+				 * component, until there are as many boxes as colors to
+				 * generate; each color is then the weighted average of its
+				 * box. With the KMeans method, these colors are then refined
+				 * by k-means (Lloyd) iterations, using GetDistance as metric.
+				 *
+				 * @param histogram the colors to represent.
+				 *
+				 * @param numberOfColors the total number of colors of the
+				 * palette, including the colorkey if any. Less colors are
+				 * generated if the histogram has less used bins.
+				 *
+				 * @param method the generation method to use.
+				 *
+				 * @param addColorkey if true, the default colorkey will be
+				 * inserted at palette index #0, and registered as such.
+				 *
+				 * @param pool if non-null, the k-means iterations are spread
+				 * over the workers of this pool. No ownership is taken.
+				 *
+				 * @param maxIterations the maximum number of k-means
+				 * iterations, which stop as soon as no color is reassigned.
+				 *
+				 * @throw PaletteException if the operation failed, notably if
+				 * the histogram is empty.
+				 *
+				 */
+				static Palette & CreateOptimizedPalette(
+					const ColorHistogram & histogram,
+					ColorCount numberOfColors = 256,
+					GenerationMethod method = KMeans,
+					bool addColorkey = true,
+					WorkerPool * pool = 0,
+					Ceylan::Uint32 maxIterations = 20 ) ;
+
+
+
+				/**
+				 * Returns the perceived distance of the human eye between the
+				 * two specified color definitions.
+				 *
+				 * An advanced weighted Euclidean distance is used, see the
+				 * lost-cost approximation in
+				 * http://www.compuphase.com/cmetric.htm.
+				 *
+				 * @note The alpha coordinate is ignored for the distance
+				 * computation.
+				 *
+				 */
+				static ColorDistance GetDistance(
+					const Pixels::ColorDefinition & firstColor,
+					const Pixels::ColorDefinition & secondColor ) ;
+
+
+
 
 			protected:
 
@@ -634,11 +794,25 @@ namespace OSDL
 				/**
 				 * Invalidates any already computed pixel colors.
 				 *
+				 * @note The inverse colormap is invalidated as well.
+				 *
 				 */
 				virtual void invalidatePixelColors() ;
 
 
 
+				/**
+				 * Invalidates the inverse colormap, if any, so that it is
+				 * recomputed on the next closest color search.
+				 *
+				 * To be called whenever a color definition or the colorkey
+				 * changes.
+				 *
+				 */
+				virtual void invalidateInverseColormap() ;
+
+
+
 
 				// Static section.
 
@@ -679,20 +853,24 @@ namespace OSDL
 
 
 				/**
-				 * Returns the perceived distance of the human eye between the
-				 * two specified color definitions.
+				 * Returns the index of the cell of the inverse colormap
+				 * corresponding to specified color, once reduced to 5 bits
+				 * for red and blue and 6 bits for green.
 				 *
-				 * An advanced weighted Euclidean distance is used, see the
-				 * lost-cost approximation in
-				 * http://www.compuphase.com/cmetric.htm.
-				 *
-				 * @note The alpha coordinate is ignored for the distance
-				 * computation.
+				 * @note The alpha coordinate is ignored.
 				 *
 				 */
-				static ColorDistance GetDistance(
-					const Pixels::ColorDefinition & firstColor,
-					const Pixels::ColorDefinition & secondColor ) ;
+				static Ceylan::Uint32 GetInverseColormapCellFor(
+					const Pixels::ColorDefinition & color ) ;
+
+
+
+				/// The number of cells of an inverse colormap (32*64*32).
+				static const Ceylan::Uint32 InverseColormapSize ;
+
+
+				/// The value of an inverse colormap cell not computed yet.
+				static const ColorCount UnsetColormapCell ;
 
 
 
@@ -737,6 +915,28 @@ namespace OSDL
 
 
 
+				/**
+				 * The inverse colormap, pointing to an array of
+				 * InverseColormapSize palette indexes, one for each 5/6/5-bit
+				 * cell of the RGB cube, or null if not computed yet.
+				 *
+				 * Cells not computed yet hold UnsetColormapCell.
+				 *
+				 */
+				mutable ColorCount * _inverseColormap ;
+
+
+
+				/**
+				 * The checksum of the color definitions the inverse colormap
+				 * was created from, used to detect changes made to borrowed
+				 * color definitions.
+				 *
+				 */
+				mutable Ceylan::Uint32 _inverseColormapChecksum ;
+
+
+
 
 			private:
 
@@ -752,6 +952,32 @@ namespace OSDL
 
 
 
+				/**
+				 * Ensures the inverse colormap is allocated and up to date
+				 * with the color definitions, even borrowed ones.
+				 *
+				 */
+				void prepareInverseColormap() const ;
+
+
+
+				/**
+				 * Returns the inverse colormap index for specified color,
+				 * computing its cell if needed.
+				 *
+				 * @note The inverse colormap must already be prepared.
+				 *
+				 */
+				ColorCount getInverseColormapIndexFor(
+					const Pixels::ColorDefinition & color ) const ;
+
+
+
+				/// Returns a checksum of the RGB coordinates of all colors.
+				Ceylan::Uint32 getColorChecksum() const ;
+
+
+
 				/**
 				 * Copy constructor made private to ensure that it will never be
 				 * called.
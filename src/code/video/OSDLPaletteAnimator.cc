@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDLPaletteAnimator.h"
+
+#include "OSDLSurface.h"             // for Surface
+
+
+#ifdef OSDL_USES_CONFIG_H
+#include <OSDLConfig.h>              // for OSDL_USES_SDL and al
+#endif // OSDL_USES_CONFIG_H
+
+
+#if OSDL_ARCH_NINTENDO_DS
+#include "OSDLConfigForNintendoDS.h" // for OSDL_USES_SDL and al
+#endif // OSDL_ARCH_NINTENDO_DS
+
+
+#if OSDL_USES_SDL
+#include "SDL.h"                     // for SDL_SetColors
+#endif // OSDL_USES_SDL
+
+
+
+using std::string ;
+using std::list ;
+
+using namespace OSDL::Video ;
+using namespace OSDL::Video::Pixels ;
+
+using OSDL::Events::Period ;
+using OSDL::Events::RenderingTick ;
+
+
+
+PaletteAnimator::PaletteAnimator( Surface & targetSurface ):
+	_target( & targetSurface ),
+	_colorCount( 0 ),
+	_originalColors( 0 ),
+	_animatedColors( 0 ),
+	_ranges()
+{
+
+	readOriginalColors() ;
+
+}
+
+
+
+PaletteAnimator::~PaletteAnimator() throw()
+{
+
+	if ( _originalColors != 0 )
+		delete [] _originalColors ;
+
+	if ( _animatedColors != 0 )
+		delete [] _animatedColors ;
+
+}
+
+
+
+void PaletteAnimator::addCyclingRange( ColorCount firstIndex,
+	ColorCount lastIndex, Period period, bool reverse )
+{
+
+	if ( lastIndex <= firstIndex || lastIndex >= _colorCount )
+		throw PaletteException( "PaletteAnimator::addCyclingRange failed: "
+			"invalid range [" + Ceylan::toString( firstIndex ) + ";"
+			+ Ceylan::toString( lastIndex ) + "] for a palette of "
+			+ Ceylan::toString( _colorCount ) + " colors." ) ;
+
+	if ( period == 0 )
+		throw PaletteException( "PaletteAnimator::addCyclingRange failed: "
+			"null period." ) ;
+
+	for ( list<CyclingRange>::const_iterator it = _ranges.begin();
+		it != _ranges.end(); it++ )
+	{
+
+		if ( firstIndex <= (*it).last && (*it).first <= lastIndex )
+			throw PaletteException( "PaletteAnimator::addCyclingRange failed: "
+				"range [" + Ceylan::toString( firstIndex ) + ";"
+				+ Ceylan::toString( lastIndex )
+				+ "] overlaps already declared range ["
+				+ Ceylan::toString( (*it).first ) + ";"
+				+ Ceylan::toString( (*it).last ) + "]." ) ;
+
+	}
+
+	CyclingRange range ;
+
+	range.first   = firstIndex ;
+	range.last    = lastIndex ;
+	range.period  = period ;
+	range.reverse = reverse ;
+	range.started = false ;
+	range.origin  = 0 ;
+	range.offset  = 0 ;
+
+	_ranges.push_back( range ) ;
+
+}
+
+
+
+void PaletteAnimator::removeAllCyclingRanges()
+{
+
+	reset() ;
+
+	_ranges.clear() ;
+
+}
+
+
+
+Ceylan::Uint32 PaletteAnimator::getCyclingRangeCount() const
+{
+
+	return static_cast<Ceylan::Uint32>( _ranges.size() ) ;
+
+}
+
+
+
+ColorCount PaletteAnimator::animate( RenderingTick currentTick )
+{
+
+	ColorCount pushedCount = 0 ;
+
+	for ( list<CyclingRange>::iterator it = _ranges.begin();
+		it != _ranges.end(); it++ )
+	{
+
+		CyclingRange & range = *it ;
+
+		if ( ! range.started )
+		{
+
+			// Original position is already the one of the surface:
+			range.started = true ;
+			range.origin  = currentTick ;
+
+			continue ;
+
+		}
+
+		ColorCount length = range.last - range.first + 1 ;
+
+		// Unsigned arithmetic copes with a wrapping tick counter:
+		ColorCount newOffset = static_cast<ColorCount>(
+			( ( currentTick - range.origin ) / range.period ) % length ) ;
+
+		if ( newOffset == range.offset )
+			continue ;
+
+		range.offset = newOffset ;
+
+		pushRange( range ) ;
+
+		pushedCount += length ;
+
+	}
+
+	return pushedCount ;
+
+}
+
+
+
+void PaletteAnimator::reset()
+{
+
+	for ( list<CyclingRange>::iterator it = _ranges.begin();
+		it != _ranges.end(); it++ )
+	{
+
+		(*it).started = false ;
+
+		if ( (*it).offset != 0 )
+		{
+
+			(*it).offset = 0 ;
+			pushRange( *it ) ;
+
+		}
+
+	}
+
+}
+
+
+
+const string PaletteAnimator::toString( Ceylan::VerbosityLevels level ) const
+{
+
+	if ( _ranges.empty() )
+		return "Palette animator for a palette of "
+			+ Ceylan::toString( _colorCount ) + " colors, with no cycling range" ;
+
+	string res = "Palette animator for a palette of "
+		+ Ceylan::toString( _colorCount ) + " colors, with "
+		+ Ceylan::toString( static_cast<Ceylan::Uint32>( _ranges.size() ) )
+		+ " cycling range(s)" ;
+
+	if ( level == Ceylan::low )
+		return res ;
+
+	for ( list<CyclingRange>::const_iterator it = _ranges.begin();
+		it != _ranges.end(); it++ )
+	{
+
+		res += ( it == _ranges.begin() ) ? ": " : ", " ;
+
+		res += "[" + Ceylan::toString( (*it).first ) + ";"
+			+ Ceylan::toString( (*it).last ) + "] every "
+			+ Ceylan::toString( (*it).period ) + " rendering tick(s)"
+			+ ( (*it).reverse ? " backward" : "" )
+			+ " (offset: " + Ceylan::toString( (*it).offset ) + ")" ;
+
+	}
+
+	return res ;
+
+}
+
+
+
+// Protected section.
+
+
+
+void PaletteAnimator::readOriginalColors()
+{
+
+	Palette * palette ;
+
+	try
+	{
+
+		palette = & _target->getPalette() ;
+
+	}
+	catch( const VideoException & e )
+	{
+
+		throw PaletteException( "PaletteAnimator::readOriginalColors failed: "
+			+ e.toString() ) ;
+
+	}
+
+	_colorCount = palette->getNumberOfColors() ;
+
+	_originalColors = new ColorDefinition[ _colorCount ] ;
+	_animatedColors = new ColorDefinition[ _colorCount ] ;
+
+	const ColorDefinition * colors = palette->getColorDefinitions() ;
+
+	for ( ColorCount i = 0; i < _colorCount; i++ )
+	{
+
+		_originalColors[i] = colors[i] ;
+		_animatedColors[i] = colors[i] ;
+
+	}
+
+	delete palette ;
+
+}
+
+
+
+void PaletteAnimator::pushRange( const CyclingRange & range )
+{
+
+	ColorCount length = range.last - range.first + 1 ;
+
+	/*
+	 * Going forward, the color originally at index first+k is found after n
+	 * steps at index first+(k+n)%length.
+	 *
+	 */
+	ColorCount shift = range.reverse ? range.offset : length - range.offset ;
+
+	for ( ColorCount k = 0; k < length; k++ )
+		_animatedColors[ range.first + k ] =
+			_originalColors[ range.first + ( k + shift ) % length ] ;
+
+#if OSDL_USES_SDL
+
+	// Only the entries of this range are uploaded:
+	SDL_SetColors( & _target->getSDLSurface(),
+		_animatedColors + range.first, range.first, length ) ;
+
+#else // OSDL_USES_SDL
+
+	throw PaletteException( "PaletteAnimator::pushRange failed: "
+		"no SDL support available" ) ;
+
+#endif // OSDL_USES_SDL
+
+}
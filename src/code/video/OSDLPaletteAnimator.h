@@ -0,0 +1,297 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#ifndef OSDL_PALETTE_ANIMATOR_H_
+#define OSDL_PALETTE_ANIMATOR_H_
+
+
+#include "OSDLPalette.h"         // for ColorCount, PaletteException
+#include "OSDLPixel.h"           // for ColorDefinition
+#include "OSDLEvents.h"          // for RenderingTick, Period
+
+#include "Ceylan.h"              // for inheritance
+
+#include <string>
+#include <list>
+
+
+
+
+namespace OSDL
+{
+
+
+	namespace Video
+	{
+
+
+		// Animators update the palette of a surface.
+		class Surface ;
+
+
+
+		/**
+		 * Animates the palette of an 8-bit (indexed) surface thanks to color
+		 * cycling: in each declared range of color indexes, the color
+		 * definitions are rotated by one entry every period, so that moving
+		 * effects (water, fire, pulsing user interface elements, etc.) are
+		 * obtained without a single pixel write.
+		 *
+		 * An animator is meant to be driven by the rendering ticks, for example
+		 * by registering it to the scheduler (see
+		 * Engine::Scheduler::registerPaletteAnimator), which calls its animate
+		 * method on each rendering tick, just before rendering.
+		 *
+		 * The position of each range is computed from the number of rendering
+		 * ticks elapsed since its first animation, hence skipped rendering
+		 * ticks do not slow down the cycling.
+		 *
+		 * Only the ranges whose position changed are pushed to the surface,
+		 * each as one SDL_SetColors call covering just its entries: the rest
+		 * of the palette is not uploaded again.
+		 *
+		 * Ranges must not overlap, and their colors are rotated from the color
+		 * definitions the surface palette had when the animator was created:
+		 * if this palette is changed by other means, a new animator should be
+		 * created.
+		 *
+		 */
+		class OSDL_DLL PaletteAnimator : public Ceylan::TextDisplayable
+		{
+
+
+			public:
+
+
+
+				/**
+				 * Creates an animator for the palette of specified surface.
+				 *
+				 * @param targetSurface the 8-bit surface whose palette will be
+				 * animated. It must exist as long as this animator is used.
+				 *
+				 * @throw PaletteException if the surface has no palette.
+				 *
+				 */
+				explicit PaletteAnimator( Surface & targetSurface ) ;
+
+
+
+				/// Virtual destructor.
+				virtual ~PaletteAnimator() throw() ;
+
+
+
+				/**
+				 * Declares a new cycling range.
+				 *
+				 * @param firstIndex the index of the first color of the range.
+				 *
+				 * @param lastIndex the index of the last color of the range,
+				 * which must be strictly greater than firstIndex.
+				 *
+				 * @param period the number of rendering ticks between two
+				 * rotations of the range by one entry. Must not be null.
+				 * Engine::Scheduler::getNumberOfRenderingTicksFor allows to
+				 * convert a duration into a number of rendering ticks.
+				 *
+				 * @param reverse if false, the colors move towards higher
+				 * indexes, otherwise towards lower ones.
+				 *
+				 * @throw PaletteException if the range is invalid, or if it
+				 * overlaps an already declared range.
+				 *
+				 */
+				virtual void addCyclingRange( ColorCount firstIndex,
+					ColorCount lastIndex, Events::Period period,
+					bool reverse = false ) ;
+
+
+
+				/**
+				 * Removes all declared cycling ranges, and restores the
+				 * original colors of the palette.
+				 *
+				 */
+				virtual void removeAllCyclingRanges() ;
+
+
+
+				/// Returns the number of declared cycling ranges.
+				virtual Ceylan::Uint32 getCyclingRangeCount() const ;
+
+
+
+				/**
+				 * Updates the cycling ranges according to the specified
+				 * rendering tick, and pushes the entries of the ranges that
+				 * moved to the surface.
+				 *
+				 * @param currentTick the current rendering tick.
+				 *
+				 * @return the number of palette entries that were pushed, zero
+				 * if no range moved.
+				 *
+				 */
+				virtual ColorCount animate( Events::RenderingTick currentTick ) ;
+
+
+
+				/**
+				 * Puts back all ranges at their original position, and pushes
+				 * them to the surface. Their cycling restarts from the next
+				 * animation.
+				 *
+				 */
+				virtual void reset() ;
+
+
+
+				/**
+				 * Returns an user-friendly description of the state of this
+				 * object.
+				 *
+				 * @param level the requested verbosity level.
+				 *
+				 * @note Text output format is determined from overall settings.
+				 *
+				 * @see Ceylan::TextDisplayable
+				 *
+				 */
+				virtual const std::string toString(
+					Ceylan::VerbosityLevels level = Ceylan::high ) const ;
+
+
+
+			protected:
+
+
+
+				/// Describes a cycling range.
+				struct CyclingRange
+				{
+
+					/// Index of the first color of the range.
+					ColorCount first ;
+
+					/// Index of the last color of the range.
+					ColorCount last ;
+
+					/// Number of rendering ticks per rotation step.
+					Events::Period period ;
+
+					/// Tells whether the colors move towards lower indexes.
+					bool reverse ;
+
+					/// Tells whether the origin tick has been set.
+					bool started ;
+
+					/// The rendering tick of the first animation.
+					Events::RenderingTick origin ;
+
+					/// The current rotation offset, in [0;last-first].
+					ColorCount offset ;
+
+				} ;
+
+
+
+				/**
+				 * Reads the original colors from the surface palette.
+				 *
+				 * @throw PaletteException if the surface has no palette.
+				 *
+				 */
+				virtual void readOriginalColors() ;
+
+
+
+				/**
+				 * Writes the colors of specified range, rotated by its current
+				 * offset, and pushes them to the surface.
+				 *
+				 */
+				virtual void pushRange( const CyclingRange & range ) ;
+
+
+
+				/// The surface whose palette is animated.
+				Surface * _target ;
+
+
+				/// The number of colors of the palette.
+				ColorCount _colorCount ;
+
+
+				/// The original colors, owned.
+				Pixels::ColorDefinition * _originalColors ;
+
+
+				/// Buffer for the rotated colors, owned.
+				Pixels::ColorDefinition * _animatedColors ;
+
+
+				/// The declared cycling ranges.
+				std::list<CyclingRange> _ranges ;
+
+
+
+			private:
+
+
+
+				/**
+				 * Copy constructor made private to ensure that it will be never
+				 * called.
+				 *
+				 * The compiler should complain whenever this undefined
+				 * constructor is called, implicitly or not.
+				 *
+				 */
+				explicit PaletteAnimator( const PaletteAnimator & source ) ;
+
+
+
+				/**
+				 * Assignment operator made private to ensure that it will be
+				 * never called.
+				 *
+				 * The compiler should complain whenever this undefined operator
+				 * is called, implicitly or not.
+				 *
+				 */
+				PaletteAnimator & operator = ( const PaletteAnimator & source ) ;
+
+
+		} ;
+
+	}
+
+}
+
+
+
+#endif // OSDL_PALETTE_ANIMATOR_H_
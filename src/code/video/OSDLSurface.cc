@@ -41,6 +41,9 @@
 #include "OSDLWidget.h"              // for Widget
 #include "OSDLUtils.h"               // for getBackendLastError
 #include "OSDLGLTexture.h"           // for GLTexture
+#include "OSDLColorReducer.h"        // for ColorReducer
+#include "OSDLColorLookupTable.h"    // for ColorLookupTable
+#include "OSDLIndexedBlitTable.h"    // for IndexedBlitTable
 
 
 #include "Ceylan.h"                  // for Ceylan::Uint8, etc.
@@ -827,12 +830,15 @@ bool Surface::setPalette( const Palette & newPalette,
 
 	/*
 	 * In video/SDL_video.c, SDL_SetPalette seems to copy palette, not taking
-	 * ownership of it:
+	 * ownership of it.
+	 *
+	 * The first color passed is the one set at startingColorIndex, so that
+	 * only the specified entries are uploaded:
 	 *
 	 */
 	return ( SDL_SetPalette( _surface, targetedPalettes,
-		/* const */ newPalette.getColorDefinitions(), startingColorIndex,
-		numberOfColors ) == 1 ) ;
+		/* const */ newPalette.getColorDefinitions() + startingColorIndex,
+		startingColorIndex, numberOfColors ) == 1 ) ;
 
 #else // OSDL_USES_SDL
 
@@ -849,59 +855,162 @@ Surface & Surface::createColorReducedSurfaceFor( const Palette & palette,
 	bool manageColorkey ) const
 {
 
+	// Sequential reduction, without dithering:
+	ColorReducer reducer( palette ) ;
 
-	PixelColor sourceColorkey ;
+	return reducer.reduce( *this, manageColorkey ) ;
 
-	if ( manageColorkey )
-		sourceColorkey = guessColorKey() ;
+}
 
-	// Creates a 8-bit software surface of the same size as this surface:
-	Length targetWidth  = getWidth() ;
-	Length targetHeight = getHeight() ;
 
-	Surface * res = new Surface( Software, /* width */ targetWidth,
-		/* height */ targetHeight, /* BitsPerPixel */ 8 ) ;
 
-	res->setPalette( palette ) ;
+void Surface::applyLookupTable( const ColorLookupTable & table )
+{
 
-	PixelColor current ;
-	ColorCount index ;
+#if OSDL_USES_SDL
+
+	BytesPerPixel bpp = getBytesPerPixel() ;
+
+	if ( bpp == 1 )
+	{
+
+		// Colorkey is an index here, thus is not affected:
+		Palette & palette = getPalette() ;
+
+		palette.applyLookupTable( table, /* includeColorkey */ true ) ;
+
+		setPalette( palette ) ;
+
+		delete & palette ;
+
+		return ;
+
+	}
+
+	const PixelFormat & format = getPixelFormat() ;
+
+	bool hasColorkey = ( ( getFlags() & ColorkeyBlit ) != 0 ) ;
+
+	ColorMask colorMask = format.Rmask | format.Gmask | format.Bmask ;
+
+	lock() ;
+
+	Length height = getHeight() ;
+	Length width  = getWidth() ;
+
+	Ceylan::Uint8 * row = reinterpret_cast<Ceylan::Uint8 *>( getPixels() ) ;
+
+	// Components stored each in a whole byte can be mapped by vectors:
+	if ( bpp == 4 && format.Rloss == 0 && format.Gloss == 0
+		&& format.Bloss == 0 && format.Rshift % 8 == 0
+		&& format.Gshift % 8 == 0 && format.Bshift % 8 == 0 )
+	{
+
+		for ( Length y = 0; y < height; y++, row += getPitch() )
+			table.applyToPixels( reinterpret_cast<Ceylan::Uint32 *>( row ),
+				width, format.Rshift, format.Gshift, format.Bshift,
+				hasColorkey, format.colorkey ) ;
+
+		unlock() ;
+
+		setRedrawState( true ) ;
+
+		return ;
+
+	}
+
+	for ( Length y = 0; y < height; y++, row += getPitch() )
+	{
+
+		Ceylan::Uint8 * p = row ;
 
-	// Scans source surface and chooses best index to put in target surface:
-	for ( Length y = 0; y < targetHeight; y++ )
-		for ( Length x = 0; x < targetWidth; x++ )
+		for ( Length x = 0; x < width; x++, p += bpp )
 		{
 
-			current = getPixelColorAt( x, y ) ;
+			PixelColor pixel ;
 
-			if ( manageColorkey && Pixels::areEqual( current, sourceColorkey ) )
+			switch( bpp )
 			{
 
-				index = palette.getColorKeyIndex() ;
+				case 2:
+					pixel = *( Ceylan::Uint16 * ) p ;
+					break ;
+
+				case 3:
+#if CEYLAN_DETECTED_LITTLE_ENDIAN
+					pixel = p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) ;
+#else // CEYLAN_DETECTED_LITTLE_ENDIAN
+					pixel = ( p[0] << 16 ) | ( p[1] << 8 ) | p[2] ;
+#endif // CEYLAN_DETECTED_LITTLE_ENDIAN
+					break ;
+
+				default:
+					pixel = *( Ceylan::Uint32 * ) p ;
+					break ;
 
 			}
-			else
-			{
 
-				// First retrieves the color definition from this surface:
-				ColorDefinition colorDef =
-							Pixels::convertPixelColorToColorDefinition(
-						getPixelFormat(), current ) ;
+			if ( hasColorkey && pixel == format.colorkey )
+				continue ;
+
+			/*
+			 * Each component is expanded to 8 bits, mapped, then packed
+			 * back, the other bits (alpha) being kept:
+			 *
+			 */
+			PixelColor mapped = ( pixel & ~colorMask )
+				| ( ( static_cast<PixelColor>( table.getMappingOf(
+					static_cast<ColorElement>( ( ( pixel & format.Rmask )
+						>> format.Rshift ) << format.Rloss ) ) )
+					>> format.Rloss ) << format.Rshift )
+				| ( ( static_cast<PixelColor>( table.getMappingOf(
+					static_cast<ColorElement>( ( ( pixel & format.Gmask )
+						>> format.Gshift ) << format.Gloss ) ) )
+					>> format.Gloss ) << format.Gshift )
+				| ( ( static_cast<PixelColor>( table.getMappingOf(
+					static_cast<ColorElement>( ( ( pixel & format.Bmask )
+						>> format.Bshift ) << format.Bloss ) ) )
+					>> format.Bloss ) << format.Bshift ) ;
+
+			switch( bpp )
+			{
 
-				// Then finds in palette the closest index:
-				index = palette.getClosestColorIndexTo( colorDef ) ;
+				case 2:
+					*( Ceylan::Uint16 * ) p = static_cast<Ceylan::Uint16>( mapped ) ;
+					break ;
+
+				case 3:
+#if CEYLAN_DETECTED_LITTLE_ENDIAN
+					p[0] = static_cast<Ceylan::Uint8>( mapped ) ;
+					p[1] = static_cast<Ceylan::Uint8>( mapped >> 8 ) ;
+					p[2] = static_cast<Ceylan::Uint8>( mapped >> 16 ) ;
+#else // CEYLAN_DETECTED_LITTLE_ENDIAN
+					p[0] = static_cast<Ceylan::Uint8>( mapped >> 16 ) ;
+					p[1] = static_cast<Ceylan::Uint8>( mapped >> 8 ) ;
+					p[2] = static_cast<Ceylan::Uint8>( mapped ) ;
+#endif // CEYLAN_DETECTED_LITTLE_ENDIAN
+					break ;
+
+				default:
+					*( Ceylan::Uint32 * ) p = mapped ;
+					break ;
 
 			}
 
+		}
 
-			// Finally puts the chosen index on the current pixel:
-			res->putPixelColorAt( x, y, static_cast<PixelColor>( index ),
-				/* alpha */ AlphaOpaque, /* blending */ false,
-				/* clipping */ false, /* locking */ false ) ;
+	}
 
-		}
+	unlock() ;
 
-	return *res ;
+	setRedrawState( true ) ;
+
+#else // OSDL_USES_SDL
+
+	throw VideoException( "Surface::applyLookupTable failed: "
+		"no SDL support available" ) ;
+
+#endif // OSDL_USES_SDL
 
 }
 
@@ -2100,6 +2209,31 @@ bool Surface::blitTo( Surface & targetSurface,
 
 
 
+bool Surface::blitTo( Surface & targetSurface, const IndexedBlitTable & table,
+	Coordinate x, Coordinate y ) const
+{
+
+	return table.blit( *this, 0, 0, getWidth(), getHeight(), targetSurface,
+		x, y ) ;
+
+}
+
+
+
+bool Surface::blitTo( Surface & targetSurface, const IndexedBlitTable & table,
+	const TwoDimensional::UprightRectangle & sourceRectangle,
+	const TwoDimensional::Point2D & destinationLocation ) const
+{
+
+	return table.blit( *this, sourceRectangle.getUpperLeftAbscissa(),
+		sourceRectangle.getUpperLeftOrdinate(), sourceRectangle.getWidth(),
+		sourceRectangle.getHeight(), targetSurface, destinationLocation.getX(),
+		destinationLocation.getY() ) ;
+
+}
+
+
+
 void Surface::displayAt( const OpenGL::GLTexture & texture,
 	Coordinate x, Coordinate y ) const
 {
@@ -3099,10 +3233,12 @@ void Surface::loadXPM( const string & filename, bool blitOnly,
 
 
 
-void Surface::savePNG( const std::string & filename, bool overwrite )
+void Surface::savePNG( const std::string & filename, bool overwrite,
+	Ceylan::Uint8 compressionLevel )
 {
 
-	TwoDimensional::Image::SavePNG( *this, filename, overwrite ) ;
+	TwoDimensional::Image::SavePNG( *this, filename, overwrite,
+		compressionLevel ) ;
 
 }
 
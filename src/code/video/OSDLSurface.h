@@ -116,6 +116,14 @@ namespace OSDL
 		class Palette ;
 
 
+		// Surfaces can be mapped thanks to lookup tables.
+		class ColorLookupTable ;
+
+
+		// 8-bit surfaces can be blitted through precomputed color tables.
+		class IndexedBlitTable ;
+
+
 
 		/**
 		 * Mother class of all events sent by a Surface (event source) to its
@@ -843,6 +851,10 @@ namespace OSDL
 				 * @note No ownership is taken for the specified palette, the
 				 * created surface will have its own one.
 				 *
+				 * @note The reduction is performed sequentially, without
+				 * dithering; use directly a ColorReducer to spread it over
+				 * worker threads and/or to dither.
+				 *
 				 */
 				Surface & createColorReducedSurfaceFor(
 						const Palette & palette, bool manageColorkey = true )
@@ -850,6 +862,29 @@ namespace OSDL
 
 
 
+				/**
+				 * Maps the red, green and blue components of all the pixels of
+				 * this surface thanks to specified lookup table, alpha being
+				 * left as is.
+				 *
+				 * This allows for example to gamma-correct, quantize or adjust
+				 * the levels of whole surfaces, the corresponding computations
+				 * being done only once per table, not once per pixel.
+				 *
+				 * For palettized surfaces, the palette is mapped instead of
+				 * the pixels. Otherwise the pixels matching the colorkey, if
+				 * any, are left as are, so that they remain transparent.
+				 *
+				 * @throw VideoException if the operation failed.
+				 *
+				 * @see ColorLookupTable
+				 *
+				 */
+				virtual void applyLookupTable(
+					const ColorLookupTable & table ) ;
+
+
+
 				/**
 				 * Returns this surface's pixel format.
 				 *
@@ -2217,6 +2252,67 @@ namespace OSDL
 
 
 
+				/**
+				 * Blits this 8-bit (indexed) surface onto specified true color
+				 * surface, each color index being converted by a lookup in the
+				 * specified table.
+				 *
+				 * Blitting the same surface through tables built from different
+				 * palettes allows palette swaps at no cost.
+				 *
+				 * @param targetSurface the destination surface, whose pixel
+				 * format must be the one the table was built for.
+				 *
+				 * @param table the table converting color indexes.
+				 *
+				 * @param x abscissa of the destination surface where this
+				 * surface will be blitted.
+				 *
+				 * @param y ordinate of the destination surface where this
+				 * surface will be blitted
+				 *
+				 * @throw VideoException if this surface is not an 8-bit one,
+				 * or if the table does not match the target format.
+				 *
+				 * @see IndexedBlitTable
+				 *
+				 */
+				virtual bool blitTo( Surface & targetSurface,
+					const IndexedBlitTable & table,
+					Coordinate x, Coordinate y ) const ;
+
+
+
+				/**
+				 * Blits the specified part of this 8-bit (indexed) surface
+				 * onto specified true color surface, through the specified
+				 * table.
+				 *
+				 * @param targetSurface the destination surface, whose pixel
+				 * format must be the one the table was built for.
+				 *
+				 * @param table the table converting color indexes.
+				 *
+				 * @param sourceRectangle a clipping rectangle defining which
+				 * part of this surface is to be blitted.
+				 *
+				 * @param destinationLocation the point of the destination
+				 * surface where this surface will be blitted.
+				 *
+				 * @throw VideoException if this surface is not an 8-bit one,
+				 * or if the table does not match the target format.
+				 *
+				 * @see IndexedBlitTable
+				 *
+				 */
+				virtual bool blitTo( Surface & targetSurface,
+					const IndexedBlitTable & table,
+					const TwoDimensional::UprightRectangle & sourceRectangle,
+					const TwoDimensional::Point2D & destinationLocation )
+						const ;
+
+
+
 				/**
 				 * Displays the specified texture at the specified location on
 				 * that surface, supposed to be the screen surface, at natural
@@ -3150,7 +3246,12 @@ namespace OSDL
 				 * <b>filename</b> should be overwritten, or if an exception
 				 * should be raised.
 				 *
+				 * @param compressionLevel the zlib compression level, in
+				 * [0;9], lower levels being faster.
+				 *
 				 * @note This method is especially useful for screenshots.
+				 * For frame sequences, see FrameCapturer, which encodes them
+				 * in the background.
 				 *
 				 * @see saveBMP, Video::makeScreenshot, loadPNG.
 				 *
@@ -3159,7 +3260,9 @@ namespace OSDL
 				 *
 				 */
 				virtual void savePNG( const std::string & filename,
-					bool overwrite = true ) ;
+					bool overwrite = true,
+					Ceylan::Uint8 compressionLevel =
+						TwoDimensional::Image::DefaultPNGCompressionLevel ) ;
 
 
 
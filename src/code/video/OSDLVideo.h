@@ -416,7 +416,8 @@ namespace OSDL
 				 * Surface-enabled platforms (in this case it will operate on
 				 * the screen surface, if any).
 				 *
-				 * @see Surface::savePNG, Surface::saveBMP.
+				 * @see Surface::savePNG, Surface::saveBMP, and FrameCapturer
+				 * to capture successive screens without blocking.
 				 *
 				 */
 				virtual void makeBMPScreenshot(
@@ -31,9 +31,15 @@
 /// This include repository keeps track of headers for the 'video' module.
 
 
+#include "OSDLColorHistogram.h"
+#include "OSDLColorLookupTable.h"
+#include "OSDLColorReducer.h"
+#include "OSDLFrameCapturer.h"
+#include "OSDLIndexedBlitTable.h"
 #include "OSDLOpenGL.h"
 #include "OSDLOverlay.h"
 #include "OSDLPalette.h"
+#include "OSDLPaletteAnimator.h"
 #include "OSDLPixel.h"
 #include "OSDLSurface.h"
 #include "OSDLVideo.h"
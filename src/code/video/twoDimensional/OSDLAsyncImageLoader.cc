@@ -0,0 +1,707 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDLAsyncImageLoader.h"
+
+#include "OSDLBasic.h"               // for getExistingCommonModule
+#include "OSDLVideo.h"               // for VideoModule
+#include "OSDLUtils.h"               // for createDataStreamFrom
+
+
+
+#ifdef OSDL_USES_CONFIG_H
+#include <OSDLConfig.h>              // for OSDL_USES_SDL_IMAGE and al
+#endif // OSDL_USES_CONFIG_H
+
+#if OSDL_ARCH_NINTENDO_DS
+#include "OSDLConfigForNintendoDS.h" // for OSDL_USES_* and al
+#endif // OSDL_ARCH_NINTENDO_DS
+
+
+
+#if OSDL_USES_SDL_IMAGE
+#include "SDL_image.h"               // for IMG_Load_RW and al
+#endif // OSDL_USES_SDL_IMAGE
+
+#if OSDL_USES_SDL
+#include "SDL.h"                     // for SDL_GetTicks
+#endif // OSDL_USES_SDL
+
+
+
+using std::string ;
+using std::list ;
+using std::map ;
+
+using namespace Ceylan::System ;
+
+using namespace OSDL ;
+using namespace OSDL::Video ;
+using namespace OSDL::Video::Pixels ;
+using namespace OSDL::Video::TwoDimensional ;
+
+
+
+/*
+ * Implementation notes:
+ *
+ * Workers only deal with SDL surfaces they created themselves, and with pixel
+ * formats that are only read: the format of the screen, or the one of a
+ * surface allocated by the loader on the main thread. OSDL Surface instances
+ * are only created by the main thread, at delivery.
+ *
+ */
+
+
+
+namespace OSDL
+{
+
+
+	namespace Video
+	{
+
+
+		namespace TwoDimensional
+		{
+
+
+
+			/// Reads, decodes and converts an image, from a worker thread.
+			class ImageDecodingJob : public OSDL::Job
+			{
+
+
+				public:
+
+
+					ImageDecodingJob( AsyncImageLoader::Handle handle,
+							const string & filename,
+							const PixelFormat * targetFormat,
+							bool withAlpha ):
+						Job( "decoding of " + filename ),
+						_handle( handle ),
+						_filename( filename ),
+						_targetFormat( targetFormat ),
+						_withAlpha( withAlpha ),
+						_result( 0 ),
+						_ioDuration( 0 ),
+						_decodeDuration( 0 )
+					{
+
+					}
+
+
+					virtual ~ImageDecodingJob() throw()
+					{
+
+#if OSDL_USES_SDL
+
+						// Set iff not delivered:
+						if ( _result != 0 )
+							SDL_FreeSurface( _result ) ;
+
+#endif // OSDL_USES_SDL
+
+					}
+
+
+					virtual void execute()
+					{
+
+#if OSDL_USES_SDL_IMAGE
+
+						Second startSecond, stopSecond ;
+						Microsecond startMicrosecond, stopMicrosecond ;
+
+						getPreciseTime( startSecond, startMicrosecond ) ;
+
+						/*
+						 * The file is read as a whole before being decoded, so
+						 * that the time spent in I/O (including archive
+						 * decompression) and in decoding can be told apart:
+						 *
+						 */
+						Ceylan::Byte * content ;
+						Size size ;
+
+						try
+						{
+
+							Ceylan::Holder<File> imageFile(
+								File::Open( _filename ) ) ;
+
+							size = imageFile->size() ;
+
+							content = new Ceylan::Byte[ size ] ;
+
+							try
+							{
+
+								imageFile->readExactLength( content, size ) ;
+
+							}
+							catch( const Ceylan::Exception & )
+							{
+
+								delete [] content ;
+								throw ;
+
+							}
+
+						}
+						catch( const Ceylan::Exception & e )
+						{
+
+							throw ImageException( "unable to load from '"
+								+ _filename + "': " + e.toString() ) ;
+
+						}
+
+						getPreciseTime( stopSecond, stopMicrosecond ) ;
+
+						_ioDuration = getDurationBetween( startSecond,
+							startMicrosecond, stopSecond, stopMicrosecond ) ;
+
+						LowLevelSurface * image = IMG_Load_RW(
+							SDL_RWFromConstMem( content, size ),
+							/* automatic free source */ true ) ;
+
+						delete [] content ;
+
+						if ( image == 0 )
+							throw ImageException( "unable to decode image "
+								"stored in '" + _filename + "': "
+								+ string( IMG_GetError() ) ) ;
+
+						if ( _targetFormat != 0 )
+						{
+
+							// Same flags as the ones SDL_DisplayFormat* uses:
+							Ceylan::Flags flags = SDL_SWSURFACE ;
+
+							if ( _withAlpha )
+								flags |= ( image->flags
+									& ( SDL_SRCALPHA | SDL_RLEACCELOK ) ) ;
+
+							LowLevelSurface * converted = SDL_ConvertSurface(
+								image,
+								const_cast<PixelFormat *>( _targetFormat ),
+								flags ) ;
+
+							SDL_FreeSurface( image ) ;
+
+							if ( converted == 0 )
+								throw ImageException( "unable to convert to "
+									"display the image loaded from '"
+									+ _filename + "'." ) ;
+
+							image = converted ;
+
+						}
+
+						_result = image ;
+
+						getPreciseTime( startSecond, startMicrosecond ) ;
+
+						_decodeDuration = getDurationBetween( stopSecond,
+							stopMicrosecond, startSecond, startMicrosecond ) ;
+
+#else // OSDL_USES_SDL_IMAGE
+
+						throw ImageException( "no SDL_image support "
+							"available" ) ;
+
+#endif // OSDL_USES_SDL_IMAGE
+
+					}
+
+
+					/// Hands over the decoded image, if any.
+					LowLevelSurface * takeResult()
+					{
+
+						LowLevelSurface * res = _result ;
+						_result = 0 ;
+
+						return res ;
+
+					}
+
+
+					AsyncImageLoader::Handle _handle ;
+
+					string _filename ;
+
+					const PixelFormat * _targetFormat ;
+
+					bool _withAlpha ;
+
+					LowLevelSurface * _result ;
+
+					/// Time spent reading the file, in microseconds.
+					Microsecond _ioDuration ;
+
+					/// Time spent decoding (and converting) the image.
+					Microsecond _decodeDuration ;
+
+
+			} ;
+
+		}
+
+	}
+
+}
+
+
+
+AsyncImageLoader::AsyncImageLoader( WorkerPool & pool, bool convertToDisplay,
+		bool convertWithAlpha ):
+	_pool( & pool ),
+	_targetFormat( 0 ),
+	_alphaFormatHolder( 0 ),
+	_nextHandle( 1 ),
+	_undelivered(),
+	_delivered()
+{
+
+#if OSDL_USES_SDL_IMAGE
+
+	if ( ! convertToDisplay )
+		return ;
+
+	if ( ! VideoModule::IsDisplayInitialized() )
+		throw ImageException( "AsyncImageLoader constructor failed: "
+			"conversion to display requested whereas display not initialized "
+			"(VideoModule::setMode never called)." ) ;
+
+	const PixelFormat & screenFormat =
+		OSDL::getExistingCommonModule().getVideoModule().getScreenSurface(
+			).getPixelFormat() ;
+
+	if ( ! convertWithAlpha )
+	{
+
+		_targetFormat = & screenFormat ;
+		return ;
+
+	}
+
+	// Same format as the one SDL_DisplayFormatAlpha would choose:
+	ColorMask redMask  = 0x00ff0000 ;
+	ColorMask blueMask = 0x000000ff ;
+
+	if ( ( screenFormat.BytesPerPixel == 2 && screenFormat.Rmask == 0x1f
+			&& ( screenFormat.Bmask == 0xf800 || screenFormat.Bmask == 0x7c00 ) )
+		|| ( screenFormat.BytesPerPixel > 2 && screenFormat.Rmask == 0xff
+			&& screenFormat.Bmask == 0xff0000 ) )
+	{
+
+		redMask  = 0x000000ff ;
+		blueMask = 0x00ff0000 ;
+
+	}
+
+	_alphaFormatHolder = SDL_CreateRGBSurface( SDL_SWSURFACE, 1, 1, 32,
+		redMask, 0x0000ff00, blueMask, 0xff000000 ) ;
+
+	if ( _alphaFormatHolder == 0 )
+		throw ImageException( "AsyncImageLoader constructor failed: "
+			+ Utils::getBackendLastError() ) ;
+
+	_targetFormat = _alphaFormatHolder->format ;
+
+#else // OSDL_USES_SDL_IMAGE
+
+	throw ImageException( "AsyncImageLoader constructor failed: "
+		"no SDL_image support available" ) ;
+
+#endif // OSDL_USES_SDL_IMAGE
+
+}
+
+
+
+AsyncImageLoader::~AsyncImageLoader() throw()
+{
+
+	for ( map<Handle, ImageDecodingJob *>::iterator it = _undelivered.begin();
+		it != _undelivered.end(); it++ )
+	{
+
+		// Jobs are not owned by the pool:
+		_pool->waitFor( *(*it).second ) ;
+
+		delete (*it).second ;
+
+	}
+
+	for ( map<Handle, DeliveredLoad>::iterator it = _delivered.begin();
+		it != _delivered.end(); it++ )
+		if ( (*it).second.surface != 0 )
+			delete (*it).second.surface ;
+
+#if OSDL_USES_SDL
+
+	if ( _alphaFormatHolder != 0 )
+		SDL_FreeSurface( _alphaFormatHolder ) ;
+
+#endif // OSDL_USES_SDL
+
+}
+
+
+
+AsyncImageLoader::Handle AsyncImageLoader::requestLoad(
+	const string & filename )
+{
+
+	return submitLoad( filename, _targetFormat,
+		/* withAlpha */ _alphaFormatHolder != 0 ) ;
+
+}
+
+
+
+AsyncImageLoader::Handle AsyncImageLoader::requestLoad(
+	const string & filename, const PixelFormat & targetFormat )
+{
+
+	return submitLoad( filename, & targetFormat, /* withAlpha */ false ) ;
+
+}
+
+
+
+AsyncImageLoader::Handle AsyncImageLoader::submitLoad( const string & filename,
+	const PixelFormat * targetFormat, bool withAlpha )
+{
+
+	Handle handle = _nextHandle++ ;
+
+	ImageDecodingJob * job = new ImageDecodingJob( handle, filename,
+		targetFormat, withAlpha ) ;
+
+	try
+	{
+
+		_pool->submit( *job ) ;
+
+	}
+	catch( const WorkerPoolException & e )
+	{
+
+		delete job ;
+
+		throw ImageException( "AsyncImageLoader::requestLoad failed for '"
+			+ filename + "': " + e.toString() ) ;
+
+	}
+
+	_undelivered[ handle ] = job ;
+
+	return handle ;
+
+}
+
+
+
+AsyncImageLoader::LoadState AsyncImageLoader::getStateOf( Handle handle )
+	const
+{
+
+	map<Handle, ImageDecodingJob *>::const_iterator pending =
+		_undelivered.find( handle ) ;
+
+	if ( pending != _undelivered.end() )
+	{
+
+		switch( _pool->getStateOf( *(*pending).second ) )
+		{
+
+			case Job::Completed:
+			case Job::Failed:
+				return Decoded ;
+
+			default:
+				return Decoding ;
+
+		}
+
+	}
+
+	map<Handle, DeliveredLoad>::const_iterator delivered =
+		_delivered.find( handle ) ;
+
+	if ( delivered == _delivered.end() )
+		throw ImageException( "AsyncImageLoader::getStateOf failed: "
+			"unknown handle " + Ceylan::toString( handle ) + "." ) ;
+
+	return ( (*delivered).second.surface != 0 ) ? Delivered : Failed ;
+
+}
+
+
+
+list<AsyncImageLoader::Handle> AsyncImageLoader::deliverCompletedLoads(
+	Ceylan::Uint32 maxCount )
+{
+
+	list<Handle> res ;
+
+	map<Handle, ImageDecodingJob *>::iterator it = _undelivered.begin() ;
+
+	while ( it != _undelivered.end()
+		&& ( maxCount == 0 || res.size() < maxCount ) )
+	{
+
+		ImageDecodingJob & job = *(*it).second ;
+
+		Job::JobState state = _pool->getStateOf( job ) ;
+
+		if ( state != Job::Completed && state != Job::Failed )
+		{
+
+			it++ ;
+			continue ;
+
+		}
+
+		DeliveredLoad load ;
+
+		load.ioDuration     = job._ioDuration ;
+		load.decodeDuration = job._decodeDuration ;
+
+		if ( state == Job::Completed )
+		{
+
+			load.surface = new Surface( * job.takeResult() ) ;
+
+		}
+		else
+		{
+
+			load.surface = 0 ;
+			load.failureReason = _pool->getFailureReasonFor( job ) ;
+
+		}
+
+		_delivered[ job._handle ] = load ;
+		res.push_back( job._handle ) ;
+
+		delete & job ;
+		_undelivered.erase( it++ ) ;
+
+	}
+
+	return res ;
+
+}
+
+
+
+Surface & AsyncImageLoader::takeSurface( Handle handle )
+{
+
+	map<Handle, DeliveredLoad>::iterator it = _delivered.find( handle ) ;
+
+	if ( it == _delivered.end() )
+	{
+
+		if ( _undelivered.find( handle ) != _undelivered.end() )
+			throw ImageException( "AsyncImageLoader::takeSurface failed: "
+				"request " + Ceylan::toString( handle )
+				+ " not delivered yet." ) ;
+
+		throw ImageException( "AsyncImageLoader::takeSurface failed: "
+			"unknown handle " + Ceylan::toString( handle ) + "." ) ;
+
+	}
+
+	DeliveredLoad load = (*it).second ;
+
+	_delivered.erase( it ) ;
+
+	if ( load.surface == 0 )
+		throw ImageException( "AsyncImageLoader::takeSurface failed: "
+			"loading of request " + Ceylan::toString( handle ) + " failed: "
+			+ load.failureReason ) ;
+
+	return * load.surface ;
+
+}
+
+
+
+void AsyncImageLoader::getDurationsOf( Handle handle,
+	Microsecond & ioDuration, Microsecond & decodeDuration ) const
+{
+
+	map<Handle, DeliveredLoad>::const_iterator it = _delivered.find( handle ) ;
+
+	if ( it == _delivered.end() )
+		throw ImageException( "AsyncImageLoader::getDurationsOf failed: "
+			"request " + Ceylan::toString( handle )
+			+ " is not delivered, or is unknown." ) ;
+
+	ioDuration     = (*it).second.ioDuration ;
+	decodeDuration = (*it).second.decodeDuration ;
+
+}
+
+
+
+Ceylan::Uint32 AsyncImageLoader::getUndeliveredCount() const
+{
+
+	return static_cast<Ceylan::Uint32>( _undelivered.size() ) ;
+
+}
+
+
+
+bool AsyncImageLoader::waitFor( Handle handle, Ceylan::Uint32 timeout )
+{
+
+	map<Handle, ImageDecodingJob *>::const_iterator it =
+		_undelivered.find( handle ) ;
+
+	if ( it != _undelivered.end() )
+		return _pool->waitFor( *(*it).second, timeout ) ;
+
+	if ( _delivered.find( handle ) == _delivered.end() )
+		throw ImageException( "AsyncImageLoader::waitFor failed: "
+			"unknown handle " + Ceylan::toString( handle ) + "." ) ;
+
+	return true ;
+
+}
+
+
+
+bool AsyncImageLoader::waitForAll( Ceylan::Uint32 timeout )
+{
+
+	/*
+	 * Not WorkerPool::waitForAll, as the pool may be shared with other
+	 * clients:
+	 *
+	 */
+
+	if ( timeout == WorkerPool::WaitIndefinitely )
+	{
+
+		for ( map<Handle, ImageDecodingJob *>::const_iterator it =
+				_undelivered.begin(); it != _undelivered.end(); it++ )
+			_pool->waitFor( *(*it).second ) ;
+
+		return true ;
+
+	}
+
+#if OSDL_USES_SDL
+
+	// The timeout applies to the whole wait, not to each request:
+	Ceylan::Uint32 start = SDL_GetTicks() ;
+
+	for ( map<Handle, ImageDecodingJob *>::const_iterator it =
+			_undelivered.begin(); it != _undelivered.end(); it++ )
+	{
+
+		Ceylan::Uint32 elapsed = SDL_GetTicks() - start ;
+
+		// Already decoded requests are still detected once time is up:
+		Ceylan::Uint32 remaining = ( elapsed < timeout ) ?
+			timeout - elapsed : 0 ;
+
+		if ( ! _pool->waitFor( *(*it).second, remaining ) )
+			return false ;
+
+	}
+
+	return true ;
+
+#else // OSDL_USES_SDL
+
+	// Jobs are executed synchronously:
+	return true ;
+
+#endif // OSDL_USES_SDL
+
+}
+
+
+
+const string AsyncImageLoader::toString( Ceylan::VerbosityLevels level ) const
+{
+
+	string res = "Asynchronous image loader with "
+		+ Ceylan::toString( static_cast<Ceylan::Uint32>( _undelivered.size() ) )
+		+ " undelivered request(s) and "
+		+ Ceylan::toString( static_cast<Ceylan::Uint32>( _delivered.size() ) )
+		+ " delivered one(s) not taken yet" ;
+
+	if ( _targetFormat == 0 )
+		res += ", with no conversion to display" ;
+	else if ( _alphaFormatHolder != 0 )
+		res += ", converting to display with alpha" ;
+	else
+		res += ", converting to display" ;
+
+	if ( level == Ceylan::low )
+		return res ;
+
+	return res + ", using " + _pool->toString( Ceylan::low ) ;
+
+}
+
+
+
+string AsyncImageLoader::DescribeState( LoadState state )
+{
+
+	switch( state )
+	{
+
+		case Decoding:
+			return "decoding" ;
+
+		case Decoded:
+			return "decoded" ;
+
+		case Delivered:
+			return "delivered" ;
+
+		case Failed:
+			return "failed" ;
+
+		default:
+			return "unknown state" ;
+
+	}
+
+}
@@ -0,0 +1,454 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#ifndef OSDL_ASYNC_IMAGE_LOADER_H_
+#define OSDL_ASYNC_IMAGE_LOADER_H_
+
+
+#include "OSDLImage.h"           // for ImageException
+#include "OSDLSurface.h"         // for Surface, LowLevelSurface
+#include "OSDLWorkerPool.h"      // for WorkerPool
+
+#include "Ceylan.h"              // for TextDisplayable
+
+#include <string>
+#include <list>
+#include <map>
+
+
+
+
+namespace OSDL
+{
+
+
+
+	namespace Video
+	{
+
+
+
+		namespace TwoDimensional
+		{
+
+
+
+			// Defined in the implementation file.
+			class ImageDecodingJob ;
+
+
+
+			/**
+			 * Loads images in the background, thanks to a pool of worker
+			 * threads, instead of blocking the caller as Image::Load and
+			 * Surface::loadImage do.
+			 *
+			 * Each worker reads an image file (through the current filesystem
+			 * manager, hence possibly from an archive), decodes it and, if
+			 * requested, converts it to the display format, all off the main
+			 * thread. The file is read as a whole before being decoded, and
+			 * both durations are recorded (see getDurationsOf).
+			 *
+			 * Finished images are not handed back as soon as they are decoded:
+			 * the application calls deliverCompletedLoads at a frame boundary
+			 * (ex: at the beginning of a rendering), which wraps in Surface
+			 * instances all the images decoded since the previous call, so
+			 * that they appear all at once between two frames. Each image is
+			 * then retrieved thanks to the handle returned when its loading
+			 * was requested.
+			 *
+			 * The display must have been initialized before creating a loader
+			 * converting to the display format, and its video mode must not
+			 * change while the loader is in use.
+			 *
+			 */
+			class OSDL_DLL AsyncImageLoader : public Ceylan::TextDisplayable
+			{
+
+
+				public:
+
+
+
+					/// Identifies a loading request.
+					typedef Ceylan::Uint32 Handle ;
+
+
+
+					/// Describes the progress of a loading request.
+					enum LoadState
+					{
+
+						/// Being decoded, or waiting for a worker.
+						Decoding,
+
+						/// Decoded, waiting for the next delivery.
+						Decoded,
+
+						/// Delivered, its surface can be taken.
+						Delivered,
+
+						/// Delivered, but its loading failed.
+						Failed
+
+					} ;
+
+
+
+					/**
+					 * Creates an asynchronous image loader.
+					 *
+					 * @param pool the worker pool in charge of the decoding.
+					 * It must exist as long as this loader does, and is not
+					 * owned.
+					 *
+					 * @param convertToDisplay tells whether loaded images
+					 * should have their pixel format converted to the one of
+					 * the screen (see Image::Load).
+					 *
+					 * @param convertWithAlpha if images are converted to the
+					 * display format, tells whether they should have an alpha
+					 * channel as well.
+					 *
+					 * @throw ImageException if the conversion to display is
+					 * requested whereas the display is not initialized, or if
+					 * no image support is available.
+					 *
+					 */
+					explicit AsyncImageLoader( WorkerPool & pool,
+						bool convertToDisplay = true,
+						bool convertWithAlpha = true ) ;
+
+
+
+					/**
+					 * Virtual destructor, waiting for the images still being
+					 * decoded, and deallocating all the images that were not
+					 * taken.
+					 *
+					 */
+					virtual ~AsyncImageLoader() throw() ;
+
+
+
+					/**
+					 * Requests the specified image file to be loaded in the
+					 * background.
+					 *
+					 * @param filename the name of the image file, whose format
+					 * will be auto-detected.
+					 *
+					 * @return the handle identifying this request.
+					 *
+					 * @throw ImageException if the request could not be
+					 * submitted.
+					 *
+					 */
+					virtual Handle requestLoad( const std::string & filename ) ;
+
+
+
+					/**
+					 * Requests the specified image file to be loaded in the
+					 * background, and converted to the specified pixel format,
+					 * with no alpha blending, whatever the conversion settings
+					 * of this loader (ex: for the internal surface of OpenGL
+					 * textures).
+					 *
+					 * @param filename the name of the image file, whose format
+					 * will be auto-detected.
+					 *
+					 * @param targetFormat the pixel format of the loaded
+					 * surface, which must remain valid until the request is
+					 * delivered.
+					 *
+					 * @return the handle identifying this request.
+					 *
+					 * @throw ImageException if the request could not be
+					 * submitted.
+					 *
+					 */
+					virtual Handle requestLoad( const std::string & filename,
+						const Pixels::PixelFormat & targetFormat ) ;
+
+
+
+					/**
+					 * Returns the current state of the specified request.
+					 *
+					 * @throw ImageException if the handle is not known, for
+					 * example if its surface has already been taken.
+					 *
+					 */
+					virtual LoadState getStateOf( Handle handle ) const ;
+
+
+
+					/**
+					 * Hands back, as surfaces, all the images decoded since the
+					 * last delivery. Meant to be called from the main thread,
+					 * at a frame boundary.
+					 *
+					 * @param maxCount the maximum number of images to deliver,
+					 * so that the cost of a batch can be bounded; zero means
+					 * no limit.
+					 *
+					 * @return the handles of the requests delivered by this
+					 * call, including the failed ones, in request order.
+					 *
+					 */
+					virtual std::list<Handle> deliverCompletedLoads(
+						Ceylan::Uint32 maxCount = 0 ) ;
+
+
+
+					/**
+					 * Returns the surface loaded by the specified delivered
+					 * request, and forgets this request.
+					 *
+					 * @return the loaded surface, whose ownership is
+					 * transferred to the caller.
+					 *
+					 * @throw ImageException if the request has not been
+					 * delivered yet, or if its loading failed (the request
+					 * being forgotten as well then), or if the handle is not
+					 * known.
+					 *
+					 */
+					virtual Surface & takeSurface( Handle handle ) ;
+
+
+
+					/**
+					 * Returns the number of requests not delivered yet,
+					 * whether they are being decoded or already decoded.
+					 *
+					 */
+					virtual Ceylan::Uint32 getUndeliveredCount() const ;
+
+
+
+					/**
+					 * Returns how long the worker spent on the specified
+					 * delivered request, whose surface was not taken yet.
+					 *
+					 * @param ioDuration set to the time spent reading the
+					 * image file, in microseconds.
+					 *
+					 * @param decodeDuration set to the time spent decoding
+					 * (and converting, if requested) the image, in
+					 * microseconds.
+					 *
+					 * @throw ImageException if the request is not delivered,
+					 * or if the handle is not known.
+					 *
+					 */
+					virtual void getDurationsOf( Handle handle,
+						Ceylan::System::Microsecond & ioDuration,
+						Ceylan::System::Microsecond & decodeDuration ) const ;
+
+
+
+					/**
+					 * Waits until the specified request has been decoded, or
+					 * until the specified timeout expires. It will still have
+					 * to be delivered.
+					 *
+					 * @param timeout the maximum duration of the wait, in
+					 * milliseconds.
+					 *
+					 * @return true iff the image was decoded in time (or was
+					 * already delivered).
+					 *
+					 * @throw ImageException if the handle is not known.
+					 *
+					 */
+					virtual bool waitFor( Handle handle,
+						Ceylan::Uint32 timeout = WorkerPool::WaitIndefinitely ) ;
+
+
+
+					/**
+					 * Waits until all the requested images have been decoded,
+					 * or until the specified timeout expires. They will still
+					 * have to be delivered.
+					 *
+					 * @param timeout the maximum duration of the whole wait,
+					 * in milliseconds.
+					 *
+					 * @return true iff all images were decoded in time.
+					 *
+					 */
+					virtual bool waitForAll(
+						Ceylan::Uint32 timeout = WorkerPool::WaitIndefinitely ) ;
+
+
+
+					/**
+					 * Returns an user-friendly description of the state of
+					 * this object.
+					 *
+					 * @param level the requested verbosity level.
+					 *
+					 * @note Text output format is determined from overall
+					 * settings.
+					 *
+					 * @see Ceylan::TextDisplayable
+					 *
+					 */
+					virtual const std::string toString(
+						Ceylan::VerbosityLevels level = Ceylan::high ) const ;
+
+
+
+					/// Returns a textual description of specified state.
+					static std::string DescribeState( LoadState state ) ;
+
+
+
+				protected:
+
+
+
+					/**
+					 * Submits the loading of the specified image file, to be
+					 * converted to the specified format, if not null.
+					 *
+					 */
+					Handle submitLoad( const std::string & filename,
+						const Pixels::PixelFormat * targetFormat,
+						bool withAlpha ) ;
+
+
+
+					/// A delivered request.
+					struct DeliveredLoad
+					{
+
+						/// The loaded surface, null if the loading failed.
+						Surface * surface ;
+
+						/// Describes why the loading failed, if it did.
+						std::string failureReason ;
+
+						/// Time spent reading the file, in microseconds.
+						Ceylan::System::Microsecond ioDuration ;
+
+						/// Time spent decoding the image, in microseconds.
+						Ceylan::System::Microsecond decodeDuration ;
+
+					} ;
+
+
+
+					/// The pool decoding the images, not owned.
+					WorkerPool * _pool ;
+
+
+					/**
+					 * The pixel format images are to be converted to, if any.
+					 *
+					 * @note Not owned.
+					 *
+					 */
+					const Pixels::PixelFormat * _targetFormat ;
+
+
+					/**
+					 * A surface, owned, just holding the pixel format of the
+					 * images converted with an alpha channel, if any.
+					 *
+					 */
+					LowLevelSurface * _alphaFormatHolder ;
+
+
+					/// The handle of the next request.
+					Handle _nextHandle ;
+
+
+/*
+ * Takes care of the awful issue of Windows DLL with templates.
+ *
+ * @see Ceylan's developer guide and README-build-for-windows.txt to understand
+ * it, and to be aware of the associated risks.
+ *
+ */
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+
+					/**
+					 * The requests not delivered yet, by handle, hence in
+					 * request order.
+					 *
+					 */
+					std::map<Handle, ImageDecodingJob *> _undelivered ;
+
+					/// The delivered requests whose surface was not taken.
+					std::map<Handle, DeliveredLoad> _delivered ;
+
+#pragma warning( pop )
+
+
+
+				private:
+
+
+
+					/**
+					 * Copy constructor made private to ensure that it will be
+					 * never called.
+					 *
+					 * The compiler should complain whenever this undefined
+					 * constructor is called, implicitly or not.
+					 *
+					 */
+					AsyncImageLoader( const AsyncImageLoader & source ) ;
+
+
+
+					/**
+					 * Assignment operator made private to ensure that it will
+					 * be never called.
+					 *
+					 * The compiler should complain whenever this undefined
+					 * operator is called, implicitly or not.
+					 *
+					 */
+					AsyncImageLoader & operator = (
+						const AsyncImageLoader & source ) ;
+
+
+			} ;
+
+		}
+
+	}
+
+}
+
+
+
+#endif // OSDL_ASYNC_IMAGE_LOADER_H_
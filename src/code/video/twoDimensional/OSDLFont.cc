@@ -155,23 +155,37 @@ Font::Font(
    *
    */
 
-  switch( _cacheSettings )
+  /*
+   * All renderings are stored in the render cache shared by all fonts, so that
+   * a single budget applies to them. Renderings of fonts that must never drop
+   * them are pinned, their quota bounding their footprint instead.
+   *
+   */
+  bool pinned = false ;
+
+  switch( cachePolicy )
   {
 
+  case NeverDrop:
+	pinned = true ;
+	break ;
+
+  case DropLessRequestedFirst:
+	pinned = false ;
+	break ;
+
+  default:
+	Ceylan::emergencyShutdown(
+	  "OSDL::Video::TwoDimensional::Font constructor: "
+	  "forbidden cache policy" ) ;
+	break ;
+
+  }
+
+
+  switch( _cacheSettings )
+  {
 
-	/*
-	 * The several sub-switches allow to get rid of following parameter in
-	 * signature:
-	 *
-	 * 'Ceylan::SmartResourceManager<CharColorQualityKey>::CachePolicy
-	 * cachePolicy = Ceylan::SmartResourceManager<CharColorQualityKey>::
-	 * DropLessRequestedFirst' which would not be compliant with a
-	 * SmartResourceManager<StringColorQualityKey>, which is also needed.
-	 *
-	 * The abstract AllowedCachePolicy is therefore to be converted to its
-	 * templated version.
-	 *
-	 */
 
   case None:
 
@@ -192,38 +206,8 @@ Font::Font(
 	if ( quota == 0 )
 	  quota = DefaultGlyphCachedQuota ;
 
-	SmartResourceManager<CharColorQualityKey>::CachePolicy
-	  actualGlyphPolicy ;
-
-	/*
-	 * Let's convert our allowed cache policy into a templated-ready cache
-	 * policy:
-	 *
-	 */
-	switch( cachePolicy )
-	{
-
-	case NeverDrop:
-	  actualGlyphPolicy =
-		SmartResourceManager<CharColorQualityKey>::NeverDrop ;
-	  break ;
-
-	case DropLessRequestedFirst:
-	  actualGlyphPolicy =
-		SmartResourceManager<CharColorQualityKey>::DropLessRequestedFirst ;
-	  break ;
-
-	default:
-	  Ceylan::emergencyShutdown(
-		"OSDL::Video::TwoDimensional::Font constructor "
-		"with glych cache: forbidden cache settings" ) ;
-
-	  break ;
-
-	}
-
-	_glyphCache = new SmartResourceManager<CharColorQualityKey>( quota,
-	  actualGlyphPolicy ) ;
+	_glyphCache = new FontRenderCacheView<CharColorQualityKey>(
+	  FontRenderCache::GetSharedCache(), pinned, quota ) ;
 	break ;
 
 
@@ -236,37 +220,8 @@ Font::Font(
 	if ( quota == 0 )
 	  quota = DefaultWordCachedQuota ;
 
-	SmartResourceManager<StringColorQualityKey>::CachePolicy
-	  actualWordPolicy ;
-
-	/*
-	 * Let's convert our allowed cache policy into a templated-ready cache
-	 * policy:
-	 *
-	 */
-	switch( cachePolicy )
-	{
-
-	case NeverDrop:
-	  actualWordPolicy =
-		SmartResourceManager<StringColorQualityKey>::NeverDrop ;
-	  break ;
-
-	case DropLessRequestedFirst:
-	  actualWordPolicy =
-		SmartResourceManager<StringColorQualityKey>::DropLessRequestedFirst ;
-	  break ;
-
-	default:
-	  Ceylan::emergencyShutdown(
-		"OSDL::Video::TwoDimensional::Font constructor "
-		"with word cache: forbidden cache settings" ) ;
-
-	  break ;
-	}
-
-	_textCache = new SmartResourceManager<StringColorQualityKey>(
-	  quota, actualWordPolicy ) ;
+	_textCache = new FontRenderCacheView<StringColorQualityKey>(
+	  FontRenderCache::GetSharedCache(), pinned, quota ) ;
 	break ;
 
 
@@ -279,37 +234,8 @@ Font::Font(
 	if ( quota == 0 )
 	  quota = DefaultTextCachedQuota ;
 
-	SmartResourceManager<StringColorQualityKey>::CachePolicy
-	  actualTextPolicy ;
-
-	/*
-	 * Let's convert our allowed cache policy into a templated-ready cache
-	 * policy:
-	 *
-	 */
-	switch( cachePolicy )
-	{
-
-	case NeverDrop:
-	  actualTextPolicy =
-		SmartResourceManager<StringColorQualityKey>::NeverDrop ;
-	  break ;
-
-	case DropLessRequestedFirst:
-	  actualTextPolicy =
-		SmartResourceManager<StringColorQualityKey>::DropLessRequestedFirst ;
-	  break ;
-
-	default:
-	  Ceylan::emergencyShutdown(
-		"OSDL::Video::TwoDimensional::Font constructor "
-		"with text cache: forbidden cache settings" ) ;
-	  break ;
-
-	}
-
-	_textCache = new SmartResourceManager<StringColorQualityKey>(
-	  quota, actualTextPolicy ) ;
+	_textCache = new FontRenderCacheView<StringColorQualityKey>(
+	  FontRenderCache::GetSharedCache(), pinned, quota ) ;
 	break ;
 
 
@@ -377,6 +303,42 @@ OSDL::Video::Pixels::ColorDefinition Font::getBackgroundColor() const
 
 
 
+FontRenderCacheStatistics Font::getCacheStatistics() const
+{
+
+  FontRenderCacheStatistics res ;
+
+  res.hits       = 0 ;
+  res.misses     = 0 ;
+  res.evictions  = 0 ;
+  res.entryCount = 0 ;
+  res.bytes      = 0 ;
+
+  // Glyphs and texts are cached separately, both count:
+  const FontRenderCacheClient * caches[2] = { _glyphCache, _textCache } ;
+
+  for ( Ceylan::Uint8 i = 0; i < 2; i++ )
+  {
+
+	if ( caches[i] == 0 )
+	  continue ;
+
+	const FontRenderCacheStatistics & stats = caches[i]->getStatistics() ;
+
+	res.hits       += stats.hits ;
+	res.misses     += stats.misses ;
+	res.evictions  += stats.evictions ;
+	res.entryCount += stats.entryCount ;
+	res.bytes      += stats.bytes ;
+
+  }
+
+  return res ;
+
+}
+
+
+
 Width Font::getAlineaWidth() const
 {
   return _alineaWidth ;
@@ -684,9 +646,9 @@ OSDL::Video::Surface & Font::renderLatin1MultiLineText(
 
 #endif // OSDL_DEBUG_FONT
 
-	_textCache = new SmartResourceManager<StringColorQualityKey>(
-	  DefaultTextCachedQuota,
-	  SmartResourceManager<StringColorQualityKey>::DropLessRequestedFirst ) ;
+	_textCache = new FontRenderCacheView<StringColorQualityKey>(
+	  FontRenderCache::GetSharedCache(), /* pinned */ false,
+	  DefaultTextCachedQuota ) ;
 
   }
 
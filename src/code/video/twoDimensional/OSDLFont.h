@@ -33,6 +33,7 @@
 #include "OSDLVideoTypes.h"   // for Length, SignedLength, etc.
 #include "OSDLPixel.h"        // for ColorElement, ColorDefinition
 #include "OSDLSurface.h"      // for Surface
+#include "OSDLFontRenderCache.h"  // for FontRenderCacheView
 
 #include "Ceylan.h"           // for inheritance, Uint32, CountedPointer, etc.
 
@@ -536,24 +537,18 @@ namespace OSDL
 
 
 						/**
-						 * Describes which of the cache policies made available
-						 * by the Smart Resource manager are allowed for fonts.
-						 *
-						 * @see Ceylan::SmartResourceManager for the description
-						 * of the various allowed policies.
-						 *
-						 * This enum is a convenient way too of overcoming the
-						 * impossibility of specifying a cache policy
-						 * independently of the key chosen to instantiate the
-						 * manager: this is an additional level of indirection,
-						 * so that in the font constructor the cache policy can
-						 * be specified directly, and not as:
-						 * Ceylan::SmartResourceManager
-						 * <StringColorQualityKey>::CachePolicy
-						 * for example, which would prevent to be able to
-						 * specify a Ceylan::SmartResourceManager
-						 * <CharColorQualityKey>::CachePolicy needed
-						 * for the glyph cache.
+						 * Describes how the renderings of a font are managed
+						 * by the render cache shared by all fonts:
+						 *
+						 * - NeverDrop: renderings are never evicted; they
+						 * count in the shared budget, but are bounded by the
+						 * quota of the font
+						 *
+						 * - DropLessRequestedFirst: renderings may be evicted
+						 * by the shared cache, according to its eviction
+						 * policy (LRU or ARC) and its overall budget
+						 *
+						 * @see FontRenderCache
 						 *
 						 */
 						enum AllowedCachePolicy {
@@ -582,23 +577,27 @@ namespace OSDL
 						 * texts, etc.)
 						 *
 						 * @param cachePolicy determines how the cache should
-						 * behave regarding renderings being put in cache (store
-						 * everything, enforce a maximum size in memory, etc.)
+						 * behave regarding renderings being put in cache:
+						 * either they are never dropped, or they may be
+						 * evicted by the render cache shared by all fonts,
+						 * according to its budget and eviction policy.
 						 *
-						 * @param quota Should an upper-bound to the memory size
-						 * of cached renderings apply (depending on the chosen
-						 * cache policy), determines its actual value.
+						 * @param quota the upper-bound to the memory size of
+						 * the cached renderings of this font, when they are
+						 * never dropped; otherwise the budget of the shared
+						 * render cache applies instead.
 						 *
 						 * If a null (0) quota is passed, then the default value
 						 * of the quota for the selected cache settings will be
 						 * chosen.
 						 *
 						 * For example, if cacheSettings is 'WordCached' and
-						 * cachePolicy is 'DropLessRequestedFirst' (this policy
-						 * uses a quota), and if a null quota is specified, then
-						 * the actual quota being used will be
+						 * cachePolicy is 'NeverDrop', and if a null quota is
+						 * specified, then the actual quota being used will be
 						 * 'DefaultWordCachedQuota'.
 						 *
+						 * @see FontRenderCache::GetSharedCache
+						 *
 						 */
 						explicit Font(
 							bool convertToDisplay = true,
@@ -671,6 +670,22 @@ namespace OSDL
 
 
 
+						/**
+						 * Returns the statistics of the use of the render
+						 * cache by this font: hits, misses, evictions and
+						 * memory taken by its renderings, glyphs and texts
+						 * (words or whole texts) alike.
+						 *
+						 * All counters are null if no render cache is used.
+						 *
+						 * @see FontRenderCache::GetSharedCache to set the
+						 * overall budget and eviction policy.
+						 *
+						 */
+						FontRenderCacheStatistics getCacheStatistics() const ;
+
+
+
 						/**
 						 * Returns the width of the specified glyph, rendered
 						 * with this font.
@@ -1351,7 +1366,8 @@ namespace OSDL
 
 						/**
 						 * Defines the default quota value (maximum size of
-						 * cached surfaces in memory, in bytes) if the cache is
+						 * cached surfaces in memory, in bytes, for fonts whose
+						 * renderings are never dropped) if the cache is
 						 * glyph-based.
 						 *
 						 * This default quota is equal to 4 megabytes.
@@ -1364,7 +1380,8 @@ namespace OSDL
 
 						/**
 						 * Defines the default quota value (maximum size of
-						 * cached surfaces in memory, in bytes) if the cache is
+						 * cached surfaces in memory, in bytes, for fonts whose
+						 * renderings are never dropped) if the cache is
 						 * word-based.
 						 *
 						 * This default quota is equal to 6 megabytes.
@@ -1377,7 +1394,8 @@ namespace OSDL
 
 						/**
 						 * Defines the default quota value (maximum size of
-						 * cached surfaces in memory, in bytes) if the cache is
+						 * cached surfaces in memory, in bytes, for fonts whose
+						 * renderings are never dropped) if the cache is
 						 * text-based.
 						 *
 						 * This default quota is equal to 8 megabytes.
@@ -1599,29 +1617,29 @@ namespace OSDL
 
 
 						/**
-						 * The smart resource manager that would cache rendered
-						 * glyphs, should the GlyphCached render cache be
-						 * selected.
+						 * The view onto the shared render cache that would
+						 * cache rendered glyphs, should the GlyphCached render
+						 * cache be selected.
 						 *
 						 * The keys used to specify a glyph are made of a
 						 * Latin-1 character and a color specification.
 						 *
 						 */
-						Ceylan::SmartResourceManager<CharColorQualityKey> *
+						FontRenderCacheView<CharColorQualityKey> *
 							_glyphCache ;
 
 
 
 						/**
-						 * The smart resource manager that would cache rendered
-						 * words and/or text, should the WordCached or
-						 * TextCached render cache be selected.
+						 * The view onto the shared render cache that would
+						 * cache rendered words and/or text, should the
+						 * WordCached or TextCached render cache be selected.
 						 *
 						 * The keys used to specify a glyph are made of a
 						 * Latin-1 encoded string and a color specification.
 						 *
 						 */
-						Ceylan::SmartResourceManager<StringColorQualityKey> *
+						FontRenderCacheView<StringColorQualityKey> *
 							_textCache ;
 
 
@@ -0,0 +1,809 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDLFontRenderCache.h"
+
+#include "OSDLSurface.h"         // for Surface
+
+
+#ifdef OSDL_USES_CONFIG_H
+#include <OSDLConfig.h>              // for OSDL_DEBUG_FONT and al
+#endif // OSDL_USES_CONFIG_H
+
+
+#if OSDL_ARCH_NINTENDO_DS
+#include "OSDLConfigForNintendoDS.h" // for OSDL_USES_SDL and al
+#endif // OSDL_ARCH_NINTENDO_DS
+
+
+
+using std::string ;
+
+using namespace Ceylan ;
+using namespace Ceylan::Log ;
+
+using namespace OSDL::Video ;
+using namespace OSDL::Video::TwoDimensional::Text ;
+
+
+
+/*
+ * Implementation notes:
+ *
+ * The ARC implementation is weighted by the size of the renderings: the target
+ * of the list of renderings used only once, and the bounds of the ghost lists,
+ * are expressed in bytes rather than in entry counts, as renderings of very
+ * different sizes (glyphs, words, full texts) share the same budget.
+ *
+ * Pinned renderings are stored in the same lists but are skipped when
+ * looking for a victim.
+ *
+ */
+
+
+
+const FontRenderCache::EntryId FontRenderCache::NoEntry = 0 ;
+
+const Ceylan::System::Size FontRenderCache::DefaultQuota = 16 * 1024 * 1024 ;
+
+
+
+/// Returns a blank statistics record.
+static FontRenderCacheStatistics getBlankStatistics()
+{
+
+	FontRenderCacheStatistics blank ;
+
+	blank.hits       = 0 ;
+	blank.misses     = 0 ;
+	blank.evictions  = 0 ;
+	blank.entryCount = 0 ;
+	blank.bytes      = 0 ;
+
+	return blank ;
+
+}
+
+
+
+/// Returns a textual description of specified statistics.
+static string describe( const FontRenderCacheStatistics & stats )
+{
+
+	string res = Ceylan::toString( stats.hits ) + " hit(s), "
+		+ Ceylan::toString( stats.misses ) + " miss(es)" ;
+
+	Ceylan::Uint32 requests = stats.hits + stats.misses ;
+
+	if ( requests != 0 )
+		res += " (hit ratio: " + Ceylan::toString(
+			static_cast<Ceylan::Uint32>( ( 100.0 * stats.hits ) / requests ) )
+			+ "%)" ;
+
+	return res + ", " + Ceylan::toString( stats.evictions )
+		+ " eviction(s), " + Ceylan::toString( stats.entryCount )
+		+ " rendering(s) in cache taking "
+		+ Ceylan::toString( static_cast<Ceylan::Uint32>( stats.bytes ) )
+		+ " bytes" ;
+
+}
+
+
+
+
+// FontRenderCacheException section.
+
+
+FontRenderCacheException::FontRenderCacheException( const string & reason ) :
+	Ceylan::ResourceManagerException( "FontRenderCacheException: " + reason )
+{
+
+}
+
+
+
+FontRenderCacheException::~FontRenderCacheException() throw()
+{
+
+}
+
+
+
+
+// FontRenderCacheClient section.
+
+
+FontRenderCacheClient::FontRenderCacheClient( FontRenderCache & cache,
+		bool pinned, Ceylan::System::Size quota ) :
+	_cache( & cache ),
+	_pinned( pinned ),
+	_quota( quota ),
+	_statistics( getBlankStatistics() )
+{
+
+	cache.registerClient( * this ) ;
+
+}
+
+
+
+FontRenderCacheClient::~FontRenderCacheClient() throw()
+{
+
+	if ( _cache != 0 )
+		_cache->unregisterClient( * this ) ;
+
+}
+
+
+
+const FontRenderCacheStatistics & FontRenderCacheClient::getStatistics() const
+{
+
+	return _statistics ;
+
+}
+
+
+
+bool FontRenderCacheClient::isPinned() const
+{
+
+	return _pinned ;
+
+}
+
+
+
+Ceylan::System::Size FontRenderCacheClient::getQuota() const
+{
+
+	return _quota ;
+
+}
+
+
+
+const string FontRenderCacheClient::describeStatistics() const
+{
+
+	string res = "Cache usage: " + describe( _statistics ) ;
+
+	if ( _pinned )
+		res += ", renderings never dropped, with a quota of "
+			+ Ceylan::toString( static_cast<Ceylan::Uint32>( _quota ) )
+			+ " bytes" ;
+
+	return res ;
+
+}
+
+
+
+void FontRenderCacheClient::onCacheDeleted()
+{
+
+	_cache = 0 ;
+
+	_statistics.entryCount = 0 ;
+	_statistics.bytes      = 0 ;
+
+}
+
+
+
+
+// FontRenderCache section.
+
+
+FontRenderCache::FontRenderCache( Ceylan::System::Size quota,
+		EvictionPolicy policy ) :
+	_entries(),
+	_clients(),
+	_quota( quota ),
+	_pinnedSize( 0 ),
+	_policy( policy ),
+	_recentTarget( 0 ),
+	_nextId( NoEntry + 1 ),
+	_statistics( getBlankStatistics() )
+{
+
+	for ( Ceylan::Uint8 i = 0; i < ListCount; i++ )
+		_listSizes[i] = 0 ;
+
+}
+
+
+
+FontRenderCache::~FontRenderCache() throw()
+{
+
+	for ( std::set<FontRenderCacheClient *>::iterator it = _clients.begin();
+			it != _clients.end(); it++ )
+		(*it)->onCacheDeleted() ;
+
+	for ( std::map<EntryId,Entry>::iterator it = _entries.begin();
+			it != _entries.end(); it++ )
+		if ( (*it).second.surface != 0 )
+			delete (*it).second.surface ;
+
+}
+
+
+
+Ceylan::System::Size FontRenderCache::getQuota() const
+{
+
+	return _quota ;
+
+}
+
+
+
+void FontRenderCache::setQuota( Ceylan::System::Size newQuota )
+{
+
+	_quota = newQuota ;
+
+	if ( _recentTarget > _quota )
+		_recentTarget = _quota ;
+
+	while ( getResidentSize() > _quota )
+		if ( ! evictOne( /* preferRecent */ false ) )
+			break ;
+
+	trimGhosts() ;
+
+}
+
+
+
+FontRenderCache::EvictionPolicy FontRenderCache::getEvictionPolicy() const
+{
+
+	return _policy ;
+
+}
+
+
+
+void FontRenderCache::setEvictionPolicy( EvictionPolicy newPolicy )
+{
+
+	if ( newPolicy == _policy )
+		return ;
+
+	// Ghosts are meaningful only to ARC, and are forgotten in all cases:
+	while ( ! _lists[RecentGhostList].empty() )
+		dropGhostFrom( RecentGhostList ) ;
+
+	while ( ! _lists[FrequentGhostList].empty() )
+		dropGhostFrom( FrequentGhostList ) ;
+
+	// LRU uses a single list, frequently used renderings being the most recent:
+	for ( std::list<EntryId>::iterator it = _lists[FrequentList].begin();
+			it != _lists[FrequentList].end(); it++ )
+		_entries[*it].list = RecentList ;
+
+	_lists[RecentList].splice( _lists[RecentList].begin(),
+		_lists[FrequentList] ) ;
+
+	_listSizes[RecentList] += _listSizes[FrequentList] ;
+	_listSizes[FrequentList] = 0 ;
+
+	_recentTarget = 0 ;
+
+	_policy = newPolicy ;
+
+}
+
+
+
+const FontRenderCacheStatistics & FontRenderCache::getStatistics() const
+{
+
+	return _statistics ;
+
+}
+
+
+
+void FontRenderCache::flush()
+{
+
+	std::list<EntryId> toRemove ;
+
+	for ( std::map<EntryId,Entry>::const_iterator it = _entries.begin();
+			it != _entries.end(); it++ )
+		if ( (*it).second.surface == 0 || ! (*it).second.client->_pinned )
+			toRemove.push_back( (*it).first ) ;
+
+	for ( std::list<EntryId>::const_iterator it = toRemove.begin();
+			it != toRemove.end(); it++ )
+		removeEntry( *it, /* notifyClient */ true ) ;
+
+	_recentTarget = 0 ;
+
+}
+
+
+
+const string FontRenderCache::toString( Ceylan::VerbosityLevels level ) const
+{
+
+	string res = "Font render cache using the "
+		+ DescribePolicy( _policy ) + " policy, with a budget of "
+		+ Ceylan::toString( static_cast<Ceylan::Uint32>( _quota ) )
+		+ " bytes, of which "
+		+ Ceylan::toString( static_cast<Ceylan::Uint32>( _pinnedSize ) )
+		+ " are taken by renderings never dropped. "
+		+ Ceylan::toString( static_cast<Ceylan::Uint32>( _clients.size() ) )
+		+ " client(s) registered. Overall usage: " + describe( _statistics ) ;
+
+	if ( _policy == AdaptiveReplacement )
+		res += ". "
+			+ Ceylan::toString( static_cast<Ceylan::Uint32>(
+				_lists[RecentGhostList].size()
+					+ _lists[FrequentGhostList].size() ) )
+			+ " evicted entries remembered, target for renderings used once: "
+			+ Ceylan::toString( static_cast<Ceylan::Uint32>( _recentTarget ) )
+			+ " bytes" ;
+
+	if ( level == Ceylan::low || _clients.empty() )
+		return res ;
+
+	std::list<string> clients ;
+
+	for ( std::set<FontRenderCacheClient *>::const_iterator it =
+			_clients.begin(); it != _clients.end(); it++ )
+		clients.push_back( (*it)->describeStatistics() ) ;
+
+	return res + ". Per-client statistics: "
+		+ Ceylan::formatStringList( clients ) ;
+
+}
+
+
+
+void FontRenderCache::registerClient( FontRenderCacheClient & client )
+{
+
+	_clients.insert( & client ) ;
+
+}
+
+
+
+void FontRenderCache::unregisterClient( FontRenderCacheClient & client )
+{
+
+	_clients.erase( & client ) ;
+
+}
+
+
+
+const Surface * FontRenderCache::access( FontRenderCacheClient & client,
+	EntryId id )
+{
+
+	std::map<EntryId,Entry>::iterator it = _entries.find( id ) ;
+
+	if ( it == _entries.end() )
+		throw FontRenderCacheException( "FontRenderCache::access failed: "
+			"unknown entry #" + Ceylan::toString( id ) ) ;
+
+	Entry & entry = (*it).second ;
+
+	if ( entry.surface == 0 )
+	{
+		recordMiss( client ) ;
+		return 0 ;
+	}
+
+	client._statistics.hits++ ;
+	_statistics.hits++ ;
+
+	moveTo( entry, id,
+		( _policy == AdaptiveReplacement ) ? FrequentList : RecentList ) ;
+
+	return entry.surface ;
+
+}
+
+
+
+bool FontRenderCache::isResident( EntryId id ) const
+{
+
+	std::map<EntryId,Entry>::const_iterator it = _entries.find( id ) ;
+
+	return ( it != _entries.end() && (*it).second.surface != 0 ) ;
+
+}
+
+
+
+void FontRenderCache::recordMiss( FontRenderCacheClient & client )
+{
+
+	client._statistics.misses++ ;
+	_statistics.misses++ ;
+
+}
+
+
+
+FontRenderCache::EntryId FontRenderCache::store(
+	FontRenderCacheClient & client, Surface & surface, EntryId id, bool force )
+{
+
+	Ceylan::System::Size size = surface.getSizeInMemory() ;
+
+	/*
+	 * Checks first whether room can be made, so that no rendering is evicted
+	 * for nothing:
+	 *
+	 */
+	if ( ! force )
+	{
+
+		if ( client._pinned && client._statistics.bytes + size > client._quota )
+			return NoEntry ;
+
+		Ceylan::System::Size unevictable = _pinnedSize ;
+
+		if ( client._pinned )
+			unevictable += size ;
+
+		if ( unevictable > _quota
+				|| ( ! client._pinned && size > _quota - unevictable ) )
+			return NoEntry ;
+
+	}
+
+	ListIndex targetList = RecentList ;
+	bool preferRecent = false ;
+
+	Entry * entry ;
+
+	if ( id != NoEntry )
+	{
+
+		std::map<EntryId,Entry>::iterator it = _entries.find( id ) ;
+
+		if ( it == _entries.end() || (*it).second.surface != 0 )
+			throw FontRenderCacheException( "FontRenderCache::store failed: "
+				"entry #" + Ceylan::toString( id ) + " is not an evicted one" ) ;
+
+		entry = & (*it).second ;
+
+		/*
+		 * ARC adaptation: a hit in a ghost list means the corresponding list
+		 * of renderings should have been larger.
+		 *
+		 */
+		if ( entry->list == RecentGhostList )
+		{
+
+			Ceylan::System::Size ratio = ( _listSizes[RecentGhostList] != 0 ) ?
+				_listSizes[FrequentGhostList] / _listSizes[RecentGhostList] : 1 ;
+
+			Ceylan::System::Size delta = ( ratio > 1 ? ratio : 1 ) * size ;
+
+			_recentTarget = ( _recentTarget + delta > _quota ) ?
+				_quota : _recentTarget + delta ;
+
+		}
+		else
+		{
+
+			Ceylan::System::Size ratio = ( _listSizes[FrequentGhostList] != 0 ) ?
+				_listSizes[RecentGhostList] / _listSizes[FrequentGhostList] : 1 ;
+
+			Ceylan::System::Size delta = ( ratio > 1 ? ratio : 1 ) * size ;
+
+			_recentTarget = ( delta > _recentTarget ) ?
+				0 : _recentTarget - delta ;
+
+			preferRecent = true ;
+
+		}
+
+		// Detached from its list, so that it cannot be trimmed meanwhile:
+		_lists[entry->list].erase( entry->position ) ;
+		_listSizes[entry->list] -= entry->size ;
+
+		targetList = FrequentList ;
+
+	}
+	else
+	{
+
+		id = _nextId++ ;
+
+		// Avoids NoEntry, should identifiers wrap around:
+		if ( _nextId == NoEntry )
+			_nextId++ ;
+
+		Entry & newEntry = _entries[id] ;
+
+		newEntry.client = & client ;
+		entry = & newEntry ;
+
+	}
+
+	// Makes room for the new rendering:
+	while ( getResidentSize() + size > _quota )
+		if ( ! evictOne( preferRecent ) )
+			break ;
+
+	entry->surface = & surface ;
+	entry->size    = size ;
+	entry->list    = targetList ;
+
+	// A forced rendering exceeding the budget will be the first to go:
+	if ( getResidentSize() + size > _quota )
+	{
+		_lists[targetList].push_back( id ) ;
+		entry->position = -- _lists[targetList].end() ;
+	}
+	else
+	{
+		_lists[targetList].push_front( id ) ;
+		entry->position = _lists[targetList].begin() ;
+	}
+
+	_listSizes[targetList] += size ;
+
+	if ( client._pinned )
+		_pinnedSize += size ;
+
+	client._statistics.entryCount++ ;
+	client._statistics.bytes += size ;
+
+	_statistics.entryCount++ ;
+	_statistics.bytes += size ;
+
+	trimGhosts() ;
+
+	return id ;
+
+}
+
+
+
+void FontRenderCache::discard( EntryId id )
+{
+
+	if ( _entries.find( id ) != _entries.end() )
+		removeEntry( id, /* notifyClient */ false ) ;
+
+}
+
+
+
+FontRenderCache & FontRenderCache::GetSharedCache()
+{
+
+	// Created on first use, deleted at exit (detaching any remaining font):
+	static FontRenderCache sharedCache ;
+
+	return sharedCache ;
+
+}
+
+
+
+string FontRenderCache::DescribePolicy( EvictionPolicy policy )
+{
+
+	switch( policy )
+	{
+
+		case LeastRecentlyUsed:
+			return "least recently used (LRU)" ;
+
+		case AdaptiveReplacement:
+			return "adaptive replacement (ARC)" ;
+
+		default:
+			return "unknown (abnormal)" ;
+
+	}
+
+}
+
+
+
+void FontRenderCache::moveTo( Entry & entry, EntryId id, ListIndex list )
+{
+
+	_lists[entry.list].erase( entry.position ) ;
+	_listSizes[entry.list] -= entry.size ;
+
+	_lists[list].push_front( id ) ;
+	entry.position = _lists[list].begin() ;
+	entry.list = list ;
+
+	_listSizes[list] += entry.size ;
+
+}
+
+
+
+bool FontRenderCache::evictOne( bool preferRecent )
+{
+
+	if ( _policy == LeastRecentlyUsed )
+		return evictFrom( RecentList ) ;
+
+	// ARC replacement rule:
+	Ceylan::System::Size recentSize = _listSizes[RecentList] ;
+
+	if ( recentSize != 0 && ( recentSize > _recentTarget
+			|| ( preferRecent && recentSize == _recentTarget ) ) )
+		return evictFrom( RecentList ) || evictFrom( FrequentList ) ;
+	else
+		return evictFrom( FrequentList ) || evictFrom( RecentList ) ;
+
+}
+
+
+
+bool FontRenderCache::evictFrom( ListIndex list )
+{
+
+	std::list<EntryId> & candidates = _lists[list] ;
+
+	std::list<EntryId>::iterator it = candidates.end() ;
+
+	while ( it != candidates.begin() )
+	{
+
+		it-- ;
+
+		Entry & entry = _entries[*it] ;
+
+		if ( entry.client->_pinned )
+			continue ;
+
+		EntryId id = *it ;
+
+		delete entry.surface ;
+		entry.surface = 0 ;
+
+		entry.client->_statistics.evictions++ ;
+		entry.client->_statistics.entryCount-- ;
+		entry.client->_statistics.bytes -= entry.size ;
+
+		_statistics.evictions++ ;
+		_statistics.entryCount-- ;
+		_statistics.bytes -= entry.size ;
+
+		if ( _policy == AdaptiveReplacement )
+		{
+
+			// Remembered as a ghost:
+			moveTo( entry, id,
+				( list == RecentList ) ? RecentGhostList : FrequentGhostList ) ;
+
+		}
+		else
+		{
+
+			candidates.erase( it ) ;
+			_listSizes[list] -= entry.size ;
+
+			FontRenderCacheClient * client = entry.client ;
+			_entries.erase( id ) ;
+
+			client->onEntryDropped( id ) ;
+
+		}
+
+		return true ;
+
+	}
+
+	return false ;
+
+}
+
+
+
+void FontRenderCache::trimGhosts()
+{
+
+	if ( _policy != AdaptiveReplacement )
+		return ;
+
+	while ( _listSizes[RecentList] + _listSizes[RecentGhostList] > _quota
+			&& ! _lists[RecentGhostList].empty() )
+		dropGhostFrom( RecentGhostList ) ;
+
+	while ( _listSizes[RecentList] + _listSizes[FrequentList]
+			+ _listSizes[RecentGhostList] + _listSizes[FrequentGhostList]
+				> 2 * _quota
+			&& ! _lists[FrequentGhostList].empty() )
+		dropGhostFrom( FrequentGhostList ) ;
+
+}
+
+
+
+void FontRenderCache::dropGhostFrom( ListIndex list )
+{
+
+	removeEntry( _lists[list].back(), /* notifyClient */ true ) ;
+
+}
+
+
+
+void FontRenderCache::removeEntry( EntryId id, bool notifyClient )
+{
+
+	std::map<EntryId,Entry>::iterator it = _entries.find( id ) ;
+
+	Entry & entry = (*it).second ;
+
+	_lists[entry.list].erase( entry.position ) ;
+	_listSizes[entry.list] -= entry.size ;
+
+	FontRenderCacheClient * client = entry.client ;
+
+	if ( entry.surface != 0 )
+	{
+
+		delete entry.surface ;
+
+		if ( client->_pinned )
+			_pinnedSize -= entry.size ;
+
+		client->_statistics.entryCount-- ;
+		client->_statistics.bytes -= entry.size ;
+
+		_statistics.entryCount-- ;
+		_statistics.bytes -= entry.size ;
+
+	}
+
+	_entries.erase( it ) ;
+
+	if ( notifyClient )
+		client->onEntryDropped( id ) ;
+
+}
+
+
+
+Ceylan::System::Size FontRenderCache::getResidentSize() const
+{
+
+	return _listSizes[RecentList] + _listSizes[FrequentList] ;
+
+}
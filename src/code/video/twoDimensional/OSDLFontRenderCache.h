@@ -0,0 +1,956 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#ifndef OSDL_FONT_RENDER_CACHE_H_
+#define OSDL_FONT_RENDER_CACHE_H_
+
+
+#include "OSDLSurface.h"      // for Surface
+
+#include "Ceylan.h"           // for TextDisplayable, ResourceManagerException
+
+
+#include <string>
+#include <list>
+#include <map>
+#include <set>
+
+
+
+namespace OSDL
+{
+
+
+
+	namespace Video
+	{
+
+
+
+		namespace TwoDimensional
+		{
+
+
+
+			namespace Text
+			{
+
+
+
+				/**
+				 * Exception raised when the font render cache is misused.
+				 *
+				 * It is a Ceylan resource manager exception, so that the
+				 * callers used to the Ceylan smart resource managers can
+				 * keep on catching the same exception.
+				 *
+				 */
+				class OSDL_DLL FontRenderCacheException :
+					public Ceylan::ResourceManagerException
+				{
+
+					public:
+
+						explicit FontRenderCacheException(
+							const std::string & reason ) ;
+
+						virtual ~FontRenderCacheException() throw() ;
+
+				} ;
+
+
+
+				/**
+				 * Statistics about the use of the render cache by a given
+				 * client (typically a font), or by all clients.
+				 *
+				 */
+				struct OSDL_DLL FontRenderCacheStatistics
+				{
+
+					/// Number of requests answered from the cache.
+					Ceylan::Uint32 hits ;
+
+					/// Number of requests the cache could not answer.
+					Ceylan::Uint32 misses ;
+
+					/// Number of renderings dropped to respect the budget.
+					Ceylan::Uint32 evictions ;
+
+					/// Number of renderings currently in cache.
+					Ceylan::Uint32 entryCount ;
+
+					/// Memory currently taken by these renderings, in bytes.
+					Ceylan::System::Size bytes ;
+
+				} ;
+
+
+
+				class FontRenderCache ;
+
+
+
+				/**
+				 * Base of all the clients of a font render cache, i.e. of the
+				 * per-font views onto the shared cache.
+				 *
+				 * Only the cache itself uses this interface.
+				 *
+				 */
+				class OSDL_DLL FontRenderCacheClient
+				{
+
+
+					public:
+
+
+						/// Identifier of an entry in the render cache.
+						typedef Ceylan::Uint32 EntryId ;
+
+
+						/**
+						 * Creates a client of the specified cache.
+						 *
+						 * @param pinned tells whether the renderings of this
+						 * client should never be evicted by the cache.
+						 *
+						 * @param quota the maximum size, in bytes, of the
+						 * renderings of a pinned client; ignored for other
+						 * clients, which are bounded by the budget of the
+						 * cache.
+						 *
+						 */
+						FontRenderCacheClient( FontRenderCache & cache,
+							bool pinned, Ceylan::System::Size quota ) ;
+
+
+						/// Unregisters from the cache, if still registered.
+						virtual ~FontRenderCacheClient() throw() ;
+
+
+						/// Returns the usage statistics of this client.
+						const FontRenderCacheStatistics & getStatistics() const ;
+
+
+						/// Tells whether the renderings of this client are
+						/// never evicted.
+						bool isPinned() const ;
+
+
+						/// Returns the quota of this client, in bytes.
+						Ceylan::System::Size getQuota() const ;
+
+
+						/**
+						 * Returns a textual description of the statistics of
+						 * this client.
+						 *
+						 */
+						virtual const std::string describeStatistics() const ;
+
+
+
+					protected:
+
+
+						/**
+						 * Called by the cache whenever the specified entry
+						 * has been definitively removed from it, so that this
+						 * client forgets about it.
+						 *
+						 */
+						virtual void onEntryDropped( EntryId id ) = 0 ;
+
+
+						/**
+						 * Called by the cache when it is deleted whereas this
+						 * client is still registered.
+						 *
+						 */
+						virtual void onCacheDeleted() ;
+
+
+						/// The cache this client uses, if any.
+						FontRenderCache * _cache ;
+
+
+						/// Tells whether renderings should never be evicted.
+						bool _pinned ;
+
+
+						/// Upper bound for the renderings of a pinned client.
+						Ceylan::System::Size _quota ;
+
+
+						/// The usage statistics of this client.
+						FontRenderCacheStatistics _statistics ;
+
+
+						// The cache updates the client statistics:
+						friend class FontRenderCache ;
+
+
+
+					private:
+
+
+						/**
+						 * Copy constructor made private to ensure that it will
+						 * never be called.
+						 *
+						 * The compiler should complain whenever this undefined
+						 * constructor is called, implicitly or not.
+						 *
+						 */
+						FontRenderCacheClient(
+							const FontRenderCacheClient & source ) ;
+
+
+						/**
+						 * Assignment operator made private to ensure that it
+						 * will be never called.
+						 *
+						 * The compiler should complain whenever this undefined
+						 * operator is called, implicitly or not.
+						 *
+						 */
+						FontRenderCacheClient & operator = (
+							const FontRenderCacheClient & source ) ;
+
+
+				} ;
+
+
+
+				/**
+				 * Cache of renderings (glyphs, words or texts) shared by
+				 * fonts, so that their overall memory footprint is bounded by
+				 * a single byte budget instead of per-font quotas.
+				 *
+				 * Each font accesses the cache through its own view
+				 * (FontRenderCacheView), which maps its keys to cache entries
+				 * and records its own hit, miss and memory statistics.
+				 *
+				 * Two eviction policies are available:
+				 *
+				 * - LeastRecentlyUsed: renderings are dropped from the least
+				 * recently accessed one
+				 *
+				 * - AdaptiveReplacement: ARC, which balances recency and
+				 * frequency; renderings used once are separated from those
+				 * used repeatedly, and the memory given to each list is
+				 * adapted thanks to the recently evicted entries (ghosts),
+				 * whose keys are remembered but whose surfaces are freed
+				 *
+				 * Renderings of pinned clients (fonts created with the
+				 * NeverDrop policy) count in the budget but are never evicted.
+				 *
+				 * @note This cache is not thread-safe: it must be used from
+				 * the thread owning the fonts.
+				 *
+				 * @see GetSharedCache
+				 *
+				 */
+				class OSDL_DLL FontRenderCache : public Ceylan::TextDisplayable
+				{
+
+
+					public:
+
+
+						/// Identifier of an entry in the render cache.
+						typedef FontRenderCacheClient::EntryId EntryId ;
+
+
+						/// The available eviction policies.
+						enum EvictionPolicy {
+							LeastRecentlyUsed, AdaptiveReplacement } ;
+
+
+
+						/**
+						 * Creates a new render cache.
+						 *
+						 * Most users should rely on the shared cache instead.
+						 *
+						 * @param quota the maximum total size, in bytes, of
+						 * the renderings in cache.
+						 *
+						 * @param policy the eviction policy to use.
+						 *
+						 */
+						explicit FontRenderCache(
+							Ceylan::System::Size quota = DefaultQuota,
+							EvictionPolicy policy = AdaptiveReplacement ) ;
+
+
+						/**
+						 * Virtual destructor, freeing all renderings and
+						 * detaching the clients still registered.
+						 *
+						 */
+						virtual ~FontRenderCache() throw() ;
+
+
+
+						/// Returns the total budget of this cache, in bytes.
+						Ceylan::System::Size getQuota() const ;
+
+
+						/**
+						 * Sets the total budget of this cache, in bytes,
+						 * evicting renderings if needed.
+						 *
+						 */
+						void setQuota( Ceylan::System::Size newQuota ) ;
+
+
+						/// Returns the current eviction policy.
+						EvictionPolicy getEvictionPolicy() const ;
+
+
+						/**
+						 * Sets the eviction policy; remembered evicted
+						 * entries are forgotten.
+						 *
+						 */
+						void setEvictionPolicy( EvictionPolicy newPolicy ) ;
+
+
+						/**
+						 * Returns the overall statistics of this cache, summed
+						 * over all its clients (past and present).
+						 *
+						 */
+						const FontRenderCacheStatistics & getStatistics()
+							const ;
+
+
+						/**
+						 * Drops all renderings that can be evicted.
+						 *
+						 * Renderings of pinned clients are kept.
+						 *
+						 */
+						void flush() ;
+
+
+
+						/**
+						 * Returns a user-friendly description of the state of
+						 * this object.
+						 *
+						 * @param level the requested verbosity level.
+						 *
+						 * @note Text output format is determined from
+						 * overall settings.
+						 *
+						 * @see Ceylan::TextDisplayable
+						 *
+						 */
+						virtual const std::string toString(
+							Ceylan::VerbosityLevels level = Ceylan::high )
+								const ;
+
+
+
+						// Section for use by cache clients.
+
+
+						/**
+						 * Registers specified client, so that it can be
+						 * detached should this cache be deleted first.
+						 *
+						 */
+						void registerClient( FontRenderCacheClient & client ) ;
+
+
+						/**
+						 * Unregisters specified client, whose entries must
+						 * have been discarded already.
+						 *
+						 */
+						void unregisterClient(
+							FontRenderCacheClient & client ) ;
+
+
+						/**
+						 * Returns the rendering stored in specified entry,
+						 * and records a hit, or returns null if the entry is
+						 * only remembered (evicted), and records a miss.
+						 *
+						 * @throw FontRenderCacheException if the entry is not
+						 * known.
+						 *
+						 */
+						const Surface * access( FontRenderCacheClient & client,
+							EntryId id ) ;
+
+
+						/**
+						 * Tells whether specified entry currently holds a
+						 * rendering. No statistics are updated.
+						 *
+						 */
+						bool isResident( EntryId id ) const ;
+
+
+						/// Records a miss for specified client.
+						void recordMiss( FontRenderCacheClient & client ) ;
+
+
+						/**
+						 * Stores specified rendering on behalf of specified
+						 * client, evicting other renderings if needed.
+						 *
+						 * @param surface the rendering, whose ownership is
+						 * taken if and only if it is stored.
+						 *
+						 * @param id the identifier of a remembered (evicted)
+						 * entry for the same key, or NoEntry.
+						 *
+						 * @param force tells whether the rendering must be
+						 * stored even if the budget cannot be respected.
+						 *
+						 * @return the identifier of the entry, or NoEntry if
+						 * the rendering could not be stored.
+						 *
+						 */
+						EntryId store( FontRenderCacheClient & client,
+							Surface & surface, EntryId id, bool force ) ;
+
+
+						/**
+						 * Removes specified entry, freeing its rendering if
+						 * any. The owning client is not notified.
+						 *
+						 */
+						void discard( EntryId id ) ;
+
+
+						/// Designates no entry.
+						static const EntryId NoEntry ;
+
+
+						/// The default budget of a render cache, 16 megabytes.
+						static const Ceylan::System::Size DefaultQuota ;
+
+
+						/**
+						 * Returns the render cache shared by all fonts of
+						 * this process, created on first use.
+						 *
+						 * Its budget and policy can be set once for all,
+						 * thanks to setQuota and setEvictionPolicy.
+						 *
+						 */
+						static FontRenderCache & GetSharedCache() ;
+
+
+						/// Returns a textual description of specified policy.
+						static std::string DescribePolicy(
+							EvictionPolicy policy ) ;
+
+
+
+					protected:
+
+
+						/**
+						 * The lists entries may belong to.
+						 *
+						 * With LRU, only RecentList is used. With ARC,
+						 * RecentList and FrequentList hold renderings (T1 and
+						 * T2), while RecentGhostList and FrequentGhostList
+						 * hold the entries evicted from them (B1 and B2).
+						 *
+						 */
+						enum ListIndex { RecentList = 0, FrequentList = 1,
+							RecentGhostList = 2, FrequentGhostList = 3,
+							ListCount = 4 } ;
+
+
+						/// Describes an entry of the cache.
+						struct Entry
+						{
+
+							/// The client this entry belongs to.
+							FontRenderCacheClient * client ;
+
+							/// The rendering, or null for ghost entries.
+							Surface * surface ;
+
+							/// The size of the rendering, in bytes.
+							Ceylan::System::Size size ;
+
+							/// The list this entry belongs to.
+							ListIndex list ;
+
+							/// The position of this entry in its list.
+							std::list<EntryId>::iterator position ;
+
+						} ;
+
+
+						/// Moves specified entry to the front of a list.
+						void moveTo( Entry & entry, EntryId id,
+							ListIndex list ) ;
+
+
+						/**
+						 * Evicts one rendering, if possible.
+						 *
+						 * @param preferRecent tells, for ARC, whether the
+						 * request comes from a hit in the frequent ghost
+						 * list.
+						 *
+						 * @return false iff no rendering could be evicted.
+						 *
+						 */
+						bool evictOne( bool preferRecent ) ;
+
+
+						/**
+						 * Evicts the least recently used evictable rendering
+						 * of specified list.
+						 *
+						 * @return false iff there was none.
+						 *
+						 */
+						bool evictFrom( ListIndex list ) ;
+
+
+						/// Trims ghost lists so that they respect ARC bounds.
+						void trimGhosts() ;
+
+
+						/**
+						 * Removes the last entry of specified ghost list, and
+						 * notifies its client.
+						 *
+						 */
+						void dropGhostFrom( ListIndex list ) ;
+
+
+						/// Removes specified entry, updating statistics.
+						void removeEntry( EntryId id, bool notifyClient ) ;
+
+
+						/// Returns the size of the renderings in cache.
+						Ceylan::System::Size getResidentSize() const ;
+
+
+
+/*
+ * Takes care of the awful issue of Windows DLL with templates.
+ *
+ * @see Ceylan's developer guide and README-build-for-windows.txt
+ * to understand it, and to be aware of the associated risks.
+ *
+ */
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+
+						/// All known entries, including ghosts.
+						std::map<EntryId, Entry> _entries ;
+
+						/// The eviction lists, most recent entries first.
+						std::list<EntryId> _lists[ListCount] ;
+
+						/// The registered clients.
+						std::set<FontRenderCacheClient *> _clients ;
+
+#pragma warning( pop )
+
+
+						/// The sizes of the entries of each list, in bytes.
+						Ceylan::System::Size _listSizes[ListCount] ;
+
+
+						/// The overall budget, in bytes.
+						Ceylan::System::Size _quota ;
+
+
+						/// The size of the renderings never evicted, in bytes.
+						Ceylan::System::Size _pinnedSize ;
+
+
+						/// The current eviction policy.
+						EvictionPolicy _policy ;
+
+
+						/**
+						 * ARC target size, in bytes, for the list of
+						 * renderings used only once.
+						 *
+						 */
+						Ceylan::System::Size _recentTarget ;
+
+
+						/// The next entry identifier to allocate.
+						EntryId _nextId ;
+
+
+						/// Overall statistics.
+						FontRenderCacheStatistics _statistics ;
+
+
+
+					private:
+
+
+						/**
+						 * Copy constructor made private to ensure that it will
+						 * never be called.
+						 *
+						 * The compiler should complain whenever this undefined
+						 * constructor is called, implicitly or not.
+						 *
+						 */
+						FontRenderCache( const FontRenderCache & source ) ;
+
+
+						/**
+						 * Assignment operator made private to ensure that it
+						 * will be never called.
+						 *
+						 * The compiler should complain whenever this undefined
+						 * operator is called, implicitly or not.
+						 *
+						 */
+						FontRenderCache & operator = (
+							const FontRenderCache & source ) ;
+
+
+				} ;
+
+
+
+				/**
+				 * View of a font onto a render cache, mapping its keys (ex:
+				 * characters or strings, with color and quality) to cache
+				 * entries.
+				 *
+				 * Offers the subset of the Ceylan::SmartResourceManager API
+				 * that fonts rely upon.
+				 *
+				 */
+				template <typename Key>
+				class FontRenderCacheView : public FontRenderCacheClient
+				{
+
+
+					public:
+
+
+						/**
+						 * Creates a view onto specified cache.
+						 *
+						 * @see FontRenderCacheClient constructor.
+						 *
+						 */
+						FontRenderCacheView( FontRenderCache & cache,
+								bool pinned, Ceylan::System::Size quota ) :
+							FontRenderCacheClient( cache, pinned, quota ),
+							_entries(),
+							_keys()
+						{
+
+						}
+
+
+
+						/// Virtual destructor, discarding all renderings.
+						virtual ~FontRenderCacheView() throw()
+						{
+
+							if ( _cache != 0 )
+							{
+
+								for ( typename std::map<Key,EntryId>::iterator
+										it = _entries.begin();
+										it != _entries.end(); it++ )
+									_cache->discard( (*it).second ) ;
+
+							}
+
+						}
+
+
+
+						/**
+						 * Returns the rendering associated with specified key,
+						 * still owned by the cache, or null if not in cache.
+						 *
+						 * The returned surface is valid only until the next
+						 * addition to the cache.
+						 *
+						 */
+						const Surface * get( const Key & key )
+						{
+
+							if ( _cache == 0 )
+								return 0 ;
+
+							typename std::map<Key,EntryId>::const_iterator it =
+								_entries.find( key ) ;
+
+							if ( it == _entries.end() )
+							{
+								_cache->recordMiss( * this ) ;
+								return 0 ;
+							}
+
+							return _cache->access( * this, (*it).second ) ;
+
+						}
+
+
+
+						/**
+						 * Returns a clone of the rendering associated with
+						 * specified key, owned by the caller, or null if not
+						 * in cache.
+						 *
+						 */
+						Surface * getClone( const Key & key )
+						{
+
+							const Surface * cached = get( key ) ;
+
+							if ( cached == 0 )
+								return 0 ;
+
+							return & dynamic_cast<Surface &>(
+								cached->clone() ) ;
+
+						}
+
+
+
+						/**
+						 * Stores a clone of specified rendering, if the cache
+						 * can make room for it.
+						 *
+						 * @return true iff the rendering was stored.
+						 *
+						 */
+						bool scanForAddition( const Key & key,
+							const Surface & surface )
+						{
+
+							if ( _cache == 0 )
+								return false ;
+
+							typename std::map<Key,EntryId>::iterator it =
+								_entries.find( key ) ;
+
+							EntryId ghost = FontRenderCache::NoEntry ;
+
+							if ( it != _entries.end() )
+							{
+
+								// Already in cache, unless it is a ghost:
+								if ( _cache->isResident( (*it).second ) )
+									return false ;
+
+								ghost = (*it).second ;
+
+							}
+
+							Surface & copy = dynamic_cast<Surface &>(
+								surface.clone() ) ;
+
+							return record( key, copy, ghost,
+								/* force */ false ) ;
+
+						}
+
+
+
+						/**
+						 * Takes ownership of specified rendering, which
+						 * will be stored even if the budget has to be
+						 * exceeded (it will be the first to be evicted then).
+						 *
+						 * @return true, as the ownership is always taken.
+						 *
+						 * @throw FontRenderCacheException if a rendering is
+						 * already associated with this key.
+						 *
+						 */
+						bool takeOwnershipOf( const Key & key,
+							Surface & surface )
+						{
+
+							if ( _cache == 0 )
+								throw FontRenderCacheException(
+									"FontRenderCacheView::takeOwnershipOf "
+									"failed: no more cache available" ) ;
+
+							typename std::map<Key,EntryId>::iterator it =
+								_entries.find( key ) ;
+
+							EntryId ghost = FontRenderCache::NoEntry ;
+
+							if ( it != _entries.end() )
+							{
+
+								if ( _cache->isResident( (*it).second ) )
+									throw FontRenderCacheException(
+										"FontRenderCacheView::takeOwnershipOf "
+										"failed: key already associated" ) ;
+
+								ghost = (*it).second ;
+
+							}
+
+							return record( key, surface, ghost,
+								/* force */ true ) ;
+
+						}
+
+
+
+						/**
+						 * Returns a user-friendly description of the state of
+						 * this object.
+						 *
+						 */
+						const std::string toString(
+							Ceylan::VerbosityLevels level = Ceylan::high )
+								const
+						{
+
+							return "View onto a render cache, referencing "
+								+ Ceylan::toString(
+									static_cast<Ceylan::Uint32>(
+										_entries.size() ) )
+								+ " entries (including evicted ones). "
+								+ describeStatistics() ;
+
+						}
+
+
+
+					protected:
+
+
+						/// Associates specified rendering with specified key.
+						bool record( const Key & key, Surface & surface,
+							EntryId ghost, bool force )
+						{
+
+							EntryId id = _cache->store( * this, surface, ghost,
+								force ) ;
+
+							if ( id == FontRenderCache::NoEntry )
+							{
+
+								// Not taken, the clone is ours:
+								if ( ! force )
+									delete & surface ;
+
+								return false ;
+
+							}
+
+							if ( id != ghost )
+							{
+								_entries[key] = id ;
+								_keys.insert( std::make_pair( id, key ) ) ;
+							}
+
+							return true ;
+
+						}
+
+
+
+						/// Forgets about specified entry.
+						virtual void onEntryDropped( EntryId id )
+						{
+
+							typename std::map<EntryId,Key>::iterator it =
+								_keys.find( id ) ;
+
+							if ( it == _keys.end() )
+								return ;
+
+							_entries.erase( (*it).second ) ;
+							_keys.erase( it ) ;
+
+						}
+
+
+
+						/// Forgets about all entries.
+						virtual void onCacheDeleted()
+						{
+
+							_entries.clear() ;
+							_keys.clear() ;
+
+							FontRenderCacheClient::onCacheDeleted() ;
+
+						}
+
+
+
+/*
+ * Takes care of the awful issue of Windows DLL with templates.
+ *
+ * @see Ceylan's developer guide and README-build-for-windows.txt
+ * to understand it, and to be aware of the associated risks.
+ *
+ */
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+
+						/// Maps keys to cache entries.
+						std::map<Key,EntryId> _entries ;
+
+						/// Maps cache entries back to keys.
+						std::map<EntryId,Key> _keys ;
+
+#pragma warning( pop )
+
+
+				} ;
+
+
+			}
+
+		}
+
+	}
+
+}
+
+
+
+#endif // OSDL_FONT_RENDER_CACHE_H_
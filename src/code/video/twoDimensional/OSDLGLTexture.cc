@@ -782,6 +782,40 @@ bool GLTexture::unload()
 
 
 
+bool GLTexture::adoptContent( Surface & loadedSurface )
+{
+
+	if ( hasContent() )
+	{
+	
+		delete & loadedSurface ;
+		return false ;
+		
+	}
+	
+	const Pixels::PixelFormat & format = loadedSurface.getPixelFormat() ;
+	
+	// Typically already converted by the worker that decoded it:
+	if ( format.BitsPerPixel == 32 && format.Rmask == RedMask
+		&& format.Gmask == GreenMask && format.Bmask == BlueMask
+		&& format.Amask == AlphaMask 
+		&& ( loadedSurface.getFlags() & Surface::AlphaBlendingBlit ) == 0 )
+	{
+	
+		_content = & loadedSurface ;
+		return true ;
+		
+	}	
+	
+	setUpInternalSurfaceFrom( loadedSurface ) ;
+	
+	return true ;
+	
+}
+
+
+
+
 const string GLTexture::toString( Ceylan::VerbosityLevels level ) const
 {
 
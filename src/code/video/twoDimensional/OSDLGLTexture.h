@@ -343,6 +343,33 @@ namespace OSDL
 					 *
 					 */
 					virtual bool unload() ;
+
+
+
+
+					/**
+					 * Sets the internal texture image to the specified
+					 * surface, already loaded from the file of this texture
+					 * by other means (ex: decoded in the background by an
+					 * AsyncImageLoader), so that load has nothing left to do.
+					 *
+					 * The surface is adopted as is if it already has the
+					 * internal format of textures (32 bits, with the
+					 * OpenGL::RedMask, GreenMask, BlueMask and AlphaMask
+					 * masks, no alpha blending), otherwise it is converted.
+					 *
+					 * @param loadedSurface the surface, whose ownership is
+					 * taken.
+					 *
+					 * @return true iff the surface was adopted; if this
+					 * texture was already loaded, its content is kept, and
+					 * the specified surface is deallocated.
+					 *
+					 * @note Adopting an image does not imply uploading it to
+					 * the video card.
+					 *
+					 */
+					virtual bool adoptContent( Surface & loadedSurface ) ;
 					
 
 
@@ -30,6 +30,11 @@
 #include "OSDLUtils.h"               // for getBackendLastError, DataStream
 #include "OSDLSurface.h"
 #include "OSDLPixel.h"
+#include "OSDLFileTags.h"            // for RawImageTag
+#include "OSDLContentSpan.h"         // for ContentSpan
+
+#include <vector>
+#include <cstring>                   // for memcpy
 
 
 
@@ -74,6 +79,9 @@ using namespace OSDL::Video ;
 using namespace OSDL::Video::Pixels ;
 using namespace OSDL::Video::TwoDimensional ;
 
+using OSDL::Utils::readLittleEndianUint16 ;
+using OSDL::Utils::readLittleEndianUint32 ;
+
 
 
 /// JPG and PNG are the two recommended formats:
@@ -95,6 +103,30 @@ const string Image::XPMTag  = "XPM" ;
 
 
 
+// PNG compression levels (zlib ones):
+
+const Ceylan::Uint8 Image::DefaultPNGCompressionLevel = 6 ;
+const Ceylan::Uint8 Image::FastPNGCompressionLevel    = 1 ;
+
+
+
+// Raw images:
+
+const Ceylan::Uint8  Image::RawImageVersion   = 1 ;
+const Ceylan::Uint32 Image::RawImageAlignment = 64 ;
+
+
+/// Flags stored in raw image headers.
+const Ceylan::Uint8 RawColorkeyFlag   = 1 ;
+const Ceylan::Uint8 RawAlphaFlag      = 2 ;
+const Ceylan::Uint8 RawCompressedFlag = 4 ;
+
+
+/// Size of a raw image header, palette excluded.
+const Ceylan::Uint32 RawHeaderSize = 44 ;
+
+
+
 /**
  * Implementation notes:
  *
@@ -106,6 +138,290 @@ const string Image::XPMTag  = "XPM" ;
 
 
 
+
+/*
+ * LZ4 block codec, used for the payload of raw images.
+ *
+ * Implemented here (following the public LZ4 block format) rather than
+ * adding a dependency, as only the block format is needed, and as decoding
+ * it is mere copying.
+ *
+ * A block is a series of sequences, each made of a token (4 high bits:
+ * literal count, 4 low bits: match length minus 4), extra literal count bytes,
+ * the literals, a little endian 16-bit match offset, then extra match length
+ * bytes. The last sequence has literals only.
+ *
+ */
+
+
+/// Minimum length of a match.
+const Ceylan::Uint32 LZ4MinMatch = 4 ;
+
+/// A block ends with at least this number of literals.
+const Ceylan::Uint32 LZ4LastLiterals = 5 ;
+
+/// No match may start closer than this from the end of a block.
+const Ceylan::Uint32 LZ4MatchFindLimit = 12 ;
+
+/// Base-2 logarithm of the number of entries of the match hash table.
+const Ceylan::Uint32 LZ4HashLog = 12 ;
+
+
+
+/// Returns the maximum size of a block compressing specified size.
+static Ceylan::Uint32 GetLZ4Bound( Ceylan::Uint32 size )
+{
+
+	return size + size / 255 + 16 ;
+
+}
+
+
+
+/// Reads 4 bytes, in any order as only used to compare and hash them.
+static Ceylan::Uint32 ReadLZ4Quad( const Ceylan::Uint8 * p )
+{
+
+	return p[0] | ( p[1] << 8 ) | ( p[2] << 16 )
+		| ( static_cast<Ceylan::Uint32>( p[3] ) << 24 ) ;
+
+}
+
+
+
+/// Writes a length exceeding 15 as a series of extra bytes.
+static Ceylan::Uint8 * WriteLZ4Length( Ceylan::Uint8 * out,
+	Ceylan::Uint32 length )
+{
+
+	while ( length >= 255 )
+	{
+
+		*out++ = 255 ;
+		length -= 255 ;
+
+	}
+
+	*out++ = static_cast<Ceylan::Uint8>( length ) ;
+
+	return out ;
+
+}
+
+
+
+/// Writes a sequence, and returns the new output position.
+static Ceylan::Uint8 * WriteLZ4Sequence( Ceylan::Uint8 * out,
+	const Ceylan::Uint8 * literals, Ceylan::Uint32 literalCount,
+	Ceylan::Uint32 offset, Ceylan::Uint32 matchLength )
+{
+
+	Ceylan::Uint8 * token = out++ ;
+
+	*token = static_cast<Ceylan::Uint8>(
+		( literalCount < 15 ? literalCount : 15 ) << 4 ) ;
+
+	if ( literalCount >= 15 )
+		out = WriteLZ4Length( out, literalCount - 15 ) ;
+
+	::memcpy( out, literals, literalCount ) ;
+	out += literalCount ;
+
+	// Last sequence:
+	if ( matchLength == 0 )
+		return out ;
+
+	*out++ = static_cast<Ceylan::Uint8>( offset ) ;
+	*out++ = static_cast<Ceylan::Uint8>( offset >> 8 ) ;
+
+	Ceylan::Uint32 extra = matchLength - LZ4MinMatch ;
+
+	*token |= static_cast<Ceylan::Uint8>( extra < 15 ? extra : 15 ) ;
+
+	if ( extra >= 15 )
+		out = WriteLZ4Length( out, extra - 15 ) ;
+
+	return out ;
+
+}
+
+
+
+/**
+ * Compresses specified data as one LZ4 block, into a buffer of at least
+ * GetLZ4Bound( size ) bytes, and returns the size of the block.
+ *
+ */
+static Ceylan::Uint32 CompressLZ4( const Ceylan::Uint8 * source,
+	Ceylan::Uint32 size, Ceylan::Uint8 * target )
+{
+
+	Ceylan::Uint8 * out = target ;
+
+	Ceylan::Uint32 anchor = 0 ;
+
+	if ( size > LZ4MatchFindLimit )
+	{
+
+		// Positions are stored plus one, zero meaning no position:
+		std::vector<Ceylan::Uint32> table( 1 << LZ4HashLog, 0 ) ;
+
+		Ceylan::Uint32 limit = size - LZ4MatchFindLimit ;
+		Ceylan::Uint32 matchEnd = size - LZ4LastLiterals ;
+
+		Ceylan::Uint32 current = 0 ;
+
+		while ( current < limit )
+		{
+
+			Ceylan::Uint32 quad = ReadLZ4Quad( source + current ) ;
+
+			Ceylan::Uint32 hash = ( quad * 2654435761U )
+				>> ( 32 - LZ4HashLog ) ;
+
+			Ceylan::Uint32 candidate = table[hash] ;
+			table[hash] = current + 1 ;
+
+			if ( candidate == 0 || current + 1 - candidate > 65535
+				|| ReadLZ4Quad( source + candidate - 1 ) != quad )
+			{
+
+				current++ ;
+				continue ;
+
+			}
+
+			Ceylan::Uint32 reference = candidate - 1 ;
+			Ceylan::Uint32 length = LZ4MinMatch ;
+
+			while ( current + length < matchEnd
+					&& source[ reference + length ] == source[ current + length ] )
+				length++ ;
+
+			out = WriteLZ4Sequence( out, source + anchor, current - anchor,
+				current - reference, length ) ;
+
+			current += length ;
+			anchor = current ;
+
+		}
+
+	}
+
+	out = WriteLZ4Sequence( out, source + anchor, size - anchor,
+		/* offset */ 0, /* matchLength */ 0 ) ;
+
+	return static_cast<Ceylan::Uint32>( out - target ) ;
+
+}
+
+
+
+/**
+ * Decompresses specified LZ4 block, which must expand to exactly targetSize
+ * bytes.
+ *
+ * @return false if the block is corrupted.
+ *
+ */
+static bool DecompressLZ4( const Ceylan::Uint8 * source,
+	Ceylan::Uint32 sourceSize, Ceylan::Uint8 * target,
+	Ceylan::Uint32 targetSize )
+{
+
+	const Ceylan::Uint8 * in = source ;
+	const Ceylan::Uint8 * inEnd = source + sourceSize ;
+
+	Ceylan::Uint8 * out = target ;
+	Ceylan::Uint8 * outEnd = target + targetSize ;
+
+	while ( in < inEnd )
+	{
+
+		Ceylan::Uint8 token = *in++ ;
+
+		Ceylan::Uint32 literalCount = token >> 4 ;
+
+		if ( literalCount == 15 )
+		{
+
+			Ceylan::Uint8 extra ;
+
+			do
+			{
+
+				if ( in == inEnd )
+					return false ;
+
+				extra = *in++ ;
+				literalCount += extra ;
+
+			} while ( extra == 255 ) ;
+
+		}
+
+		if ( literalCount > static_cast<Ceylan::Uint32>( inEnd - in )
+				|| literalCount > static_cast<Ceylan::Uint32>( outEnd - out ) )
+			return false ;
+
+		::memcpy( out, in, literalCount ) ;
+		in  += literalCount ;
+		out += literalCount ;
+
+		// The last sequence has no match:
+		if ( in == inEnd )
+			break ;
+
+		if ( inEnd - in < 2 )
+			return false ;
+
+		Ceylan::Uint32 offset = in[0] | ( in[1] << 8 ) ;
+		in += 2 ;
+
+		if ( offset == 0 || offset > static_cast<Ceylan::Uint32>( out - target ) )
+			return false ;
+
+		Ceylan::Uint32 matchLength = token & 15 ;
+
+		if ( matchLength == 15 )
+		{
+
+			Ceylan::Uint8 extra ;
+
+			do
+			{
+
+				if ( in == inEnd )
+					return false ;
+
+				extra = *in++ ;
+				matchLength += extra ;
+
+			} while ( extra == 255 ) ;
+
+		}
+
+		matchLength += LZ4MinMatch ;
+
+		if ( matchLength > static_cast<Ceylan::Uint32>( outEnd - out ) )
+			return false ;
+
+		// Byte per byte, as the match may overlap its own output:
+		const Ceylan::Uint8 * match = out - offset ;
+
+		for ( Ceylan::Uint32 i = 0; i < matchLength; i++ )
+			out[i] = match[i] ;
+
+		out += matchLength ;
+
+	}
+
+	return ( out == outEnd ) ;
+
+}
+
+
+
 ImageException::ImageException( const std::string & reason ) :
 	VideoException( reason )
 {
@@ -230,6 +546,47 @@ bool Image::unload()
 
 
 
+bool Image::adoptContent( Surface & loadedSurface )
+{
+
+	if ( hasContent() )
+	{
+
+		delete & loadedSurface ;
+		return false ;
+
+	}
+
+	if ( _convertToDisplayFormat )
+	{
+
+		try
+		{
+
+			loadedSurface.convertToDisplay( _convertWithAlpha ) ;
+
+		}
+		catch( const VideoException & e )
+		{
+
+			delete & loadedSurface ;
+
+			throw ImageException( "Image::adoptContent failed: "
+				"unable to convert the surface read from '" + _contentPath
+				+ "' to the display format: " + e.toString() ) ;
+
+		}
+
+	}
+
+	_content = & loadedSurface ;
+
+	return true ;
+
+}
+
+
+
 const std::string Image::toString( Ceylan::VerbosityLevels level ) const
 {
 
@@ -2087,7 +2444,7 @@ void Image::LoadXPM( Surface & targetSurface, const std::string & filename,
 
 
 void Image::SavePNG( Surface & targetSurface, const std::string & filename,
-	bool overwrite )
+	bool overwrite, Ceylan::Uint8 compressionLevel )
 {
 
 #if OSDL_USES_LIBPNG
@@ -2096,9 +2453,37 @@ void Image::SavePNG( Surface & targetSurface, const std::string & filename,
 
 	if ( ! overwrite && Ceylan::System::File::Exists( filename ) )
 		throw TwoDimensional::ImageException(
-			"Surface::SavePNG: target file '" + filename
+			"Image::SavePNG: target file '" + filename
 			+ "' already exists, and overwrite mode is off." ) ;
 
+	if ( compressionLevel > 9 )
+		throw TwoDimensional::ImageException(
+			"Image::SavePNG: invalid compression level ("
+			+ Ceylan::toNumericalString( compressionLevel )
+			+ "), expected to be in [0;9]." ) ;
+
+	// Let's create a file with C-style:
+
+	/*
+	 * Something as:
+
+	std::ifstream outputFile = open( filename.c_str(), ifstream::out ) ;
+
+	 * could not work since functions like png_init_io *wants* a FILE *, except
+	 * maybe with a clumsy ifstream::rdbuf.
+	 *
+	 * ifstream destructor would automatically close the file on any exit
+	 * scheme.
+	 *
+	 */
+
+	FILE * outputFile = ::fopen( filename.c_str(), "wb" ) ;
+
+	if ( outputFile == 0 )
+		throw TwoDimensional::ImageException(
+			"Image::SavePNG: unable to save image '"
+			+ filename + "' (step 1): " + Ceylan::System::explainError() ) ;
+
 	png_structp png_ptr ;
 	png_infop info_ptr ;
 
@@ -2107,11 +2492,11 @@ void Image::SavePNG( Surface & targetSurface, const std::string & filename,
 	if ( png_ptr == 0 )
 	{
 
-	  // Probably useless:
-	  ::png_destroy_write_struct( & png_ptr, (png_infopp) 0 ) ;
-	  throw TwoDimensional::ImageException(
-		"Surface::SavePNG: unable to save image '"
-		+ filename + "' (step 1)" ) ;
+		::fclose( outputFile ) ;
+
+		throw TwoDimensional::ImageException(
+			"Image::SavePNG: unable to save image '"
+			+ filename + "' (step 2)" ) ;
 	}
 
 
@@ -2119,50 +2504,71 @@ void Image::SavePNG( Surface & targetSurface, const std::string & filename,
 
 	if ( info_ptr == 0 )
 	{
-		::png_destroy_write_struct( & png_ptr, (png_infopp) 0 ) ;
-		throw TwoDimensional::ImageException(
-			"Surface::SavePNG: unable to save image '"
-				+ filename + "' (step 2)" ) ;
-	}
-
 
-	if ( ::setjmp( png_jmpbuf( png_ptr ) ) )
-	{
 		::png_destroy_write_struct( & png_ptr, (png_infopp) 0 ) ;
+		::fclose( outputFile ) ;
+
 		throw TwoDimensional::ImageException(
-			"Surface::SavePNG: unable to save image '"
-			+ filename + "' (step 3)" ) ;
+			"Image::SavePNG: unable to save image '"
+				+ filename + "' (step 3)" ) ;
 	}
 
-	// Let's create a file with C-style:
+	const Length width  = targetSurface.getWidth() ;
+	const Length height = targetSurface.getHeight() ;
 
 	/*
-	 * Something as:
+	 * The alpha coordinate is kept only if the surface has one: colorkeyed
+	 * and paletted surfaces are saved as plain RGB.
+	 *
+	 */
+	const bool withAlpha = ( targetSurface.getPixelFormat().Amask != 0 ) ;
 
-	std::ifstream outputFile = open( filename.c_str(), ifstream::out ) ;
+	const Ceylan::Uint8 channelCount = withAlpha ? 4 : 3 ;
 
-	 * could not work since functions like png_init_io *wants* a FILE *, except
-	 * maybe with a clumsy ifstream::rdbuf.
+	/*
+	 * Pixels are converted and written one row at a time, so that saving a
+	 * large surface (ex: a screenshot) needs only a single row buffer, instead
+	 * of a full-size copy of the image.
 	 *
-	 * ifstream destructor would automatically close the file on any exit
-	 * scheme.
+	 * Allocated before setjmp, so that the error path can release it; one
+	 * extra byte is reserved for the (then overwritten) alpha coordinate that
+	 * SDL_GetRGBA returns for the last pixel of an RGB row.
 	 *
 	 */
+	png_bytep row = new png_byte[ channelCount * width + 1 ] ;
 
-	FILE * outputFile = ::fopen( filename.c_str(), "wb" ) ;
+	targetSurface.lock() ;
 
-	if ( outputFile == 0 )
+	if ( ::setjmp( png_jmpbuf( png_ptr ) ) )
 	{
 
-		::png_destroy_write_struct( & png_ptr, (png_infopp) 0 ) ;
+		targetSurface.unlock() ;
+
+		delete [] row ;
+
+		::png_destroy_write_struct( & png_ptr, & info_ptr ) ;
+		::fclose( outputFile ) ;
 
 		throw TwoDimensional::ImageException(
-			"Surface::SavePNG: unable to save image '"
-			+ filename + "' (step 4): " + Ceylan::System::explainError() ) ;
+			"Image::SavePNG: unable to save image '"
+			+ filename + "' (step 4)" ) ;
 	}
 
 	::png_init_io( png_ptr, outputFile ) ;
 
+	/*
+	 * Low compression levels are mostly used for frame sequences, where
+	 * encoding time matters more than file size: filtering is then reduced
+	 * accordingly, as adaptive filtering is a large part of the encoding cost.
+	 *
+	 */
+	::png_set_compression_level( png_ptr, compressionLevel ) ;
+
+	if ( compressionLevel == 0 )
+		::png_set_filter( png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_NONE ) ;
+	else if ( compressionLevel <= FastPNGCompressionLevel )
+		::png_set_filter( png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_SUB ) ;
+
 	/*
 	 * The choice of a 8-bit depth might be not as generic as wished.
 	 *
@@ -2170,12 +2576,10 @@ void Image::SavePNG( Surface & targetSurface, const std::string & filename,
 	 *  - PNG_COLOR_TYPE_GRAY
 	 *  - PNG_COLOR_TYPE_PALETTE
 	 *
-	 * No alpha coordinate seems to be managed.
-	 *
 	 */
-	::png_set_IHDR( png_ptr, info_ptr, targetSurface.getWidth(),
-	  targetSurface.getHeight(), /* bit depth */ 8,
-	  /* color type */ PNG_COLOR_TYPE_RGB,
+	::png_set_IHDR( png_ptr, info_ptr, width, height, /* bit depth */ 8,
+	  /* color type */
+	  withAlpha ? PNG_COLOR_TYPE_RGB_ALPHA : PNG_COLOR_TYPE_RGB,
 	  /* could be PNG_INTERLACE_ADAM7: */ PNG_INTERLACE_NONE,
 	  PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE ) ;
 
@@ -2217,59 +2621,39 @@ void Image::SavePNG( Surface & targetSurface, const std::string & filename,
 
 		default:
 			throw TwoDimensional::ImageException(
-				"Surface::SavePNG: unexpected image type." ) ;
+				"Image::SavePNG: unexpected image type." ) ;
 			break ;
 	 }
 
 	*/
 
-
-	// No palette used:
-	// info_ptr->num_palette = 0 ;
-	// info_ptr->palette     = 0 ;
-
-	// info_ptr->valid = 0 ;
-
-
 	::png_write_info( png_ptr, info_ptr ) ;
 
+	Pixels::PixelFormat & format = targetSurface.getPixelFormat() ;
 
-	// Now, writes the pixels, one by one:
-	targetSurface.lock() ;
-
-	unsigned char ** png_rows =
-		new unsigned char * [ targetSurface.getHeight() ] ;
-
-	for ( Coordinate y = 0; y < targetSurface.getHeight(); y++ )
+	for ( Coordinate y = 0; y < static_cast<Coordinate>( height ); y++ )
 	{
 
-		png_rows[ y ] = new unsigned char[ 3 * targetSurface.getWidth() ] ;
-
-		ColorDefinition readDef ;
+		png_bytep out = row ;
 
-		for ( Coordinate x = 0; x < targetSurface.getWidth(); x++ )
+		for ( Coordinate x = 0; x < static_cast<Coordinate>( width ); x++ )
 		{
 
-			readDef = targetSurface.getColorDefinitionAt( x, y ) ;
+			// Alpha is fully opaque if the format has no alpha channel:
+			::SDL_GetRGBA( Pixels::getPixelColor( targetSurface, x, y ),
+				& format, out, out + 1, out + 2, out + 3 ) ;
+
+			out += channelCount ;
 
-			/*
-			SDL_GetRGB( targetSurface.getPixel( x, y ),
-				& targetSurface.getPixelFormat(), & r, & g, & b ) ;
-			 */
-			png_rows[ y ][ x * 3 + 0 ] = readDef.r ;
-			png_rows[ y ][ x * 3 + 1 ] = readDef.g ;
-			png_rows[ y ][ x * 3 + 2 ] = readDef.b ;
 		}
-	}
 
-	targetSurface.unlock() ;
+		::png_write_row( png_ptr, row ) ;
 
-	::png_write_image( png_ptr, png_rows ) ;
+	}
 
-	for ( Coordinate y = 0; y < targetSurface.getHeight(); y++ )
-		delete [] png_rows[ y ] ;
+	targetSurface.unlock() ;
 
-	delete [] png_rows ;
+	delete [] row ;
 
 	::png_write_end( png_ptr, 0 ) ;
 
@@ -2312,3 +2696,394 @@ void Image::SaveBMP( Surface & targetSurface, const std::string & filename,
 #endif // OSDL_USES_SDL
 
 }
+
+
+
+void Image::LoadRaw( Surface & targetSurface, const std::string & filename,
+	bool blitOnly, bool convertToDisplay, bool convertWithAlpha )
+{
+
+#if OSDL_USES_SDL
+
+	SDL_Surface * image = 0 ;
+
+	try
+	{
+
+		/*
+		 * The whole file is spanned (memory-mapped when possible), so that
+		 * the payload is decompressed or copied directly from it:
+		 *
+		 */
+		ContentSpan rawSpan( filename ) ;
+
+		const Ceylan::Byte * header = rawSpan.getData() ;
+		Size rawSize = rawSpan.getSize() ;
+
+		if ( rawSize < RawHeaderSize )
+			throw ImageException( "file too short for a raw image header" ) ;
+
+		OSDL::FileTag readTag = readLittleEndianUint16( header ) ;
+
+		if ( readTag != OSDL::RawImageTag )
+			throw ImageException( "expected tag for raw images ("
+				+ Ceylan::toString( OSDL::RawImageTag ) + "), read instead "
+				+ Ceylan::toString( readTag ) ) ;
+
+		Ceylan::Uint8 version = header[2] ;
+
+		if ( version != RawImageVersion )
+			throw ImageException( "unsupported raw image version "
+				+ Ceylan::toNumericalString( version ) ) ;
+
+		Ceylan::Uint8 flags = header[3] ;
+
+		Length width  = readLittleEndianUint16( header + 4 ) ;
+		Length height = readLittleEndianUint16( header + 6 ) ;
+
+		BitsPerPixel bitsPerPixel = header[8] ;
+
+		// Bytes per pixel (header[9]) are implied by the bits.
+
+		Ceylan::Uint32 pitch = readLittleEndianUint16( header + 10 ) ;
+
+		ColorMask redMask   = readLittleEndianUint32( header + 12 ) ;
+		ColorMask greenMask = readLittleEndianUint32( header + 16 ) ;
+		ColorMask blueMask  = readLittleEndianUint32( header + 20 ) ;
+		ColorMask alphaMask = readLittleEndianUint32( header + 24 ) ;
+
+		PixelColor colorkey = readLittleEndianUint32( header + 28 ) ;
+
+		ColorElement alpha = header[32] ;
+
+		// Reserved: header[33].
+
+		Ceylan::Uint16 colorCount = readLittleEndianUint16( header + 34 ) ;
+
+		Ceylan::Uint32 storedSize  = readLittleEndianUint32( header + 36 ) ;
+		Ceylan::Uint32 payloadSize = readLittleEndianUint32( header + 40 ) ;
+
+		if ( payloadSize != pitch * height || payloadSize == 0 )
+			throw ImageException( "inconsistent payload size" ) ;
+
+		Ceylan::Uint32 headerSize = RawHeaderSize + 4 * colorCount ;
+
+		Ceylan::Uint32 paddingSize =
+			( RawImageAlignment - headerSize % RawImageAlignment )
+				% RawImageAlignment ;
+
+		// The payload starts aligned, right after the padding:
+		Ceylan::Uint32 payloadOffset = headerSize + paddingSize ;
+
+		if ( rawSize < payloadOffset || rawSize - payloadOffset < storedSize )
+			throw ImageException( "truncated raw image" ) ;
+
+		const Ceylan::Byte * palette = header + RawHeaderSize ;
+
+		std::vector<SDL_Color> colors( colorCount ) ;
+
+		for ( Ceylan::Uint16 i = 0; i < colorCount; i++ )
+		{
+
+			colors[i].r      = palette[ 4 * i ] ;
+			colors[i].g      = palette[ 4 * i + 1 ] ;
+			colors[i].b      = palette[ 4 * i + 2 ] ;
+			colors[i].unused = palette[ 4 * i + 3 ] ;
+
+		}
+
+		const Ceylan::Uint8 * stored = header + payloadOffset ;
+
+		image = SDL_CreateRGBSurface( SDL_SWSURFACE, width, height,
+			bitsPerPixel, redMask, greenMask, blueMask, alphaMask ) ;
+
+		if ( image == 0 )
+			throw ImageException( "surface creation failed: "
+				+ Utils::getBackendLastError() ) ;
+
+		/*
+		 * The pitch of a surface depends only on its width and depth, thus
+		 * rows can be read directly, unless a different padding policy was
+		 * used by the writer:
+		 *
+		 */
+		bool samePitch = ( image->pitch == pitch ) ;
+
+		Ceylan::Uint8 * pixels = static_cast<Ceylan::Uint8 *>( image->pixels ) ;
+
+		std::vector<Ceylan::Uint8> payload ;
+
+		if ( ! samePitch )
+		{
+
+			payload.resize( payloadSize ) ;
+			pixels = & payload[0] ;
+
+		}
+
+		if ( ( flags & RawCompressedFlag ) != 0 )
+		{
+
+			if ( ! DecompressLZ4( stored, storedSize, pixels, payloadSize ) )
+				throw ImageException( "corrupted compressed payload" ) ;
+
+		}
+		else
+		{
+
+			if ( storedSize != payloadSize )
+				throw ImageException( "inconsistent stored size" ) ;
+
+			// The single copy of the pixels:
+			::memcpy( pixels, stored, payloadSize ) ;
+
+		}
+
+		if ( ! samePitch )
+		{
+
+			Ceylan::Uint32 rowSize = ( pitch < image->pitch ) ?
+				pitch : image->pitch ;
+
+			for ( Length y = 0; y < height; y++ )
+				::memcpy( static_cast<Ceylan::Uint8 *>( image->pixels )
+					+ y * image->pitch, pixels + y * pitch, rowSize ) ;
+
+		}
+
+		if ( colorCount > 0 )
+			SDL_SetPalette( image, SDL_LOGPAL | SDL_PHYSPAL, & colors[0], 0,
+				colorCount ) ;
+
+		if ( ( flags & RawColorkeyFlag ) != 0 )
+			SDL_SetColorKey( image, SDL_SRCCOLORKEY, colorkey ) ;
+
+		if ( ( flags & RawAlphaFlag ) != 0 )
+			SDL_SetAlpha( image, SDL_SRCALPHA, alpha ) ;
+		else
+			SDL_SetAlpha( image, 0, alpha ) ;
+
+	}
+	catch( const Ceylan::Exception & e )
+	{
+
+		if ( image != 0 )
+			SDL_FreeSurface( image ) ;
+
+		throw ImageException( "Image::LoadRaw failed for '" + filename
+			+ "': " + e.toString() ) ;
+
+	}
+
+	if ( convertToDisplay )
+	{
+
+		if ( ! VideoModule::IsDisplayInitialized() )
+		{
+
+			SDL_FreeSurface( image ) ;
+
+			throw ImageException( "Image::LoadRaw called with request to "
+				"convert surface to display, whereas display not initialized "
+				"(VideoModule::setMode never called)." ) ;
+
+		}
+
+		const SDL_PixelFormat & screenFormat = * SDL_GetVideoSurface()->format ;
+
+		// Stored images are meant to be already in the display format:
+		bool alreadyConverted = ( image->format->BytesPerPixel
+				== screenFormat.BytesPerPixel
+			&& image->format->Rmask == screenFormat.Rmask
+			&& image->format->Gmask == screenFormat.Gmask
+			&& image->format->Bmask == screenFormat.Bmask
+			&& ( image->format->Amask != 0 ) == convertWithAlpha ) ;
+
+		if ( ! alreadyConverted )
+		{
+
+			SDL_Surface * formattedImage = convertWithAlpha ?
+				SDL_DisplayFormatAlpha( image ) : SDL_DisplayFormat( image ) ;
+
+			SDL_FreeSurface( image ) ;
+
+			if ( formattedImage == 0 )
+				throw ImageException( "Unable to convert to display the raw "
+					"image loaded from " + filename + "." ) ;
+
+			image = formattedImage ;
+
+		}
+
+	}
+
+	if ( blitOnly )
+	{
+
+		int result = SDL_BlitSurface( image, 0,
+			& targetSurface.getSDLSurface(), 0 ) ;
+
+		SDL_FreeSurface( image ) ;
+
+		if ( result == -1 )
+			throw ImageException( "Image::LoadRaw: error in blit: "
+				+ Utils::getBackendLastError() ) ;
+
+		if ( result == -2 )
+			throw ImageException(
+				"Image::LoadRaw: video memory was lost during blit." ) ;
+
+	}
+	else
+	{
+
+		// The target surface takes ownership of the image:
+		targetSurface.setSDLSurface( * image ) ;
+
+	}
+
+#else // OSDL_USES_SDL
+
+	throw ImageException( "Image::LoadRaw failed: "
+		"no SDL support available" ) ;
+
+#endif // OSDL_USES_SDL
+
+}
+
+
+
+void Image::SaveRaw( Surface & targetSurface, const std::string & filename,
+	bool compress, bool overwrite )
+{
+
+#if OSDL_USES_SDL
+
+	if ( ! overwrite && File::Exists( filename ) )
+		throw ImageException( "Image::SaveRaw: target file '" + filename
+			+ "' already exists, and overwrite mode is off." ) ;
+
+	const SDL_Surface & surface = targetSurface.getSDLSurface() ;
+	const SDL_PixelFormat & format = * surface.format ;
+
+	Ceylan::Uint32 pitch = surface.pitch ;
+	Ceylan::Uint32 payloadSize = pitch * surface.h ;
+
+	if ( payloadSize == 0 )
+		throw ImageException( "Image::SaveRaw failed: empty surface." ) ;
+
+	Ceylan::Uint16 colorCount = ( format.palette != 0 ) ?
+		static_cast<Ceylan::Uint16>( format.palette->ncolors ) : 0 ;
+
+	Ceylan::Uint8 flags = 0 ;
+
+	if ( ( surface.flags & SDL_SRCCOLORKEY ) != 0 )
+		flags |= RawColorkeyFlag ;
+
+	if ( ( surface.flags & SDL_SRCALPHA ) != 0 )
+		flags |= RawAlphaFlag ;
+
+	std::vector<Ceylan::Uint8> payload( payloadSize ) ;
+
+	targetSurface.lock() ;
+
+	::memcpy( & payload[0], surface.pixels, payloadSize ) ;
+
+	targetSurface.unlock() ;
+
+	std::vector<Ceylan::Uint8> block ;
+
+	if ( compress )
+	{
+
+		block.resize( GetLZ4Bound( payloadSize ) ) ;
+
+		Ceylan::Uint32 blockSize = CompressLZ4( & payload[0], payloadSize,
+			& block[0] ) ;
+
+		// Compression kept only if it pays off:
+		if ( blockSize < payloadSize )
+		{
+
+			block.resize( blockSize ) ;
+			flags |= RawCompressedFlag ;
+
+		}
+
+	}
+
+	const std::vector<Ceylan::Uint8> & stored =
+		( ( flags & RawCompressedFlag ) != 0 ) ? block : payload ;
+
+	try
+	{
+
+		Ceylan::Holder<File> rawHolder( File::Create( filename ) ) ;
+
+		rawHolder->writeUint16( OSDL::RawImageTag ) ;
+		rawHolder->writeUint8( RawImageVersion ) ;
+		rawHolder->writeUint8( flags ) ;
+
+		rawHolder->writeUint16( static_cast<Ceylan::Uint16>( surface.w ) ) ;
+		rawHolder->writeUint16( static_cast<Ceylan::Uint16>( surface.h ) ) ;
+
+		rawHolder->writeUint8( format.BitsPerPixel ) ;
+		rawHolder->writeUint8( format.BytesPerPixel ) ;
+
+		rawHolder->writeUint16( static_cast<Ceylan::Uint16>( pitch ) ) ;
+
+		rawHolder->writeUint32( format.Rmask ) ;
+		rawHolder->writeUint32( format.Gmask ) ;
+		rawHolder->writeUint32( format.Bmask ) ;
+		rawHolder->writeUint32( format.Amask ) ;
+
+		rawHolder->writeUint32( format.colorkey ) ;
+
+		rawHolder->writeUint8( format.alpha ) ;
+
+		// Reserved:
+		rawHolder->writeUint8( 0 ) ;
+
+		rawHolder->writeUint16( colorCount ) ;
+
+		rawHolder->writeUint32( static_cast<Ceylan::Uint32>( stored.size() ) ) ;
+		rawHolder->writeUint32( payloadSize ) ;
+
+		for ( Ceylan::Uint16 i = 0; i < colorCount; i++ )
+		{
+
+			const SDL_Color & color = format.palette->colors[i] ;
+
+			rawHolder->writeUint8( color.r ) ;
+			rawHolder->writeUint8( color.g ) ;
+			rawHolder->writeUint8( color.b ) ;
+			rawHolder->writeUint8( color.unused ) ;
+
+		}
+
+		Ceylan::Uint32 headerSize = RawHeaderSize + 4 * colorCount ;
+
+		for ( Ceylan::Uint32 i = headerSize % RawImageAlignment;
+				i != 0 && i < RawImageAlignment; i++ )
+			rawHolder->writeUint8( 0 ) ;
+
+		rawHolder->write( reinterpret_cast<const Ceylan::Byte *>( & stored[0] ),
+			static_cast<Size>( stored.size() ) ) ;
+
+	}
+	catch( const Ceylan::Exception & e )
+	{
+
+		throw ImageException( "Image::SaveRaw failed for '" + filename
+			+ "': " + e.toString() ) ;
+
+	}
+
+#else // OSDL_USES_SDL
+
+	throw ImageException( "Image::SaveRaw failed: "
+		"no SDL support available" ) ;
+
+#endif // OSDL_USES_SDL
+
+}
@@ -218,6 +218,30 @@ namespace OSDL
 
 
 
+					/**
+					 * Sets the content of this image to the specified surface,
+					 * already loaded from the file of this image by other
+					 * means (ex: decoded in the background by an
+					 * AsyncImageLoader), so that load has nothing left to do.
+					 *
+					 * The surface is converted to the display format if this
+					 * image was created so.
+					 *
+					 * @param loadedSurface the surface, whose ownership is
+					 * taken.
+					 *
+					 * @return true iff the surface was adopted; if this image
+					 * was already loaded, its content is kept, and the
+					 * specified surface is deallocated.
+					 *
+					 * @throw ImageException if the conversion failed, the
+					 * surface being deallocated then.
+					 *
+					 */
+					virtual bool adoptContent( Surface & loadedSurface ) ;
+
+
+
 					/**
 					 * Returns an user-friendly description of the state of this
 					 * object.
@@ -307,6 +331,8 @@ namespace OSDL
 					 * surface as target surface, since this surface is special
 					 * and should not be deallocated as the others may be.
 					 *
+					 * @see AsyncImageLoader to load images in the background.
+					 *
 					 */
 					static void Load( Surface & targetSurface,
 						const std::string & filename,
@@ -792,19 +818,31 @@ namespace OSDL
 					 * The default is true, if false an exception will be raised
 					 * should a corresponding file be found.
 					 *
+					 * @param compressionLevel the zlib compression level, from
+					 * 0 (no compression) to 9 (smallest files, slowest),
+					 * FastPNGCompressionLevel being convenient when saving
+					 * many frames.
+					 *
 					 * @note This method is especially convenient for
 					 * screenshots.
 					 *
-					 * Transparency is managed.
+					 * Transparency is managed: surfaces having an alpha
+					 * channel are saved with one.
+					 *
+					 * Pixels are converted and written one row at a time, so
+					 * that saving a large surface needs no full-size copy.
 					 *
 					 * @note The PNG format is to be preferred to the BMP one.
 					 *
-					 * @see Surface::savePNG
+					 * @see Surface::savePNG, FrameCapturer to save frames
+					 * without blocking the caller.
 					 *
 					 */
 					static void SavePNG( Surface & targetSurface,
 						const std::string & filename,
-						bool overwrite = true ) ;
+						bool overwrite = true,
+						Ceylan::Uint8 compressionLevel =
+							DefaultPNGCompressionLevel ) ;
 
 
 
@@ -842,6 +880,101 @@ namespace OSDL
 
 
 
+					/**
+					 * Loads an OSDL raw image (see SaveRaw) from specified file
+					 * into target surface.
+					 *
+					 * As the pixels are stored already converted, loading
+					 * them is a single read (or a decompression) directly into
+					 * the pixel buffer of the surface.
+					 *
+					 * @param targetSurface the surface that should contain the
+					 * loaded image.
+					 *
+					 * @param filename the name of the raw image file.
+					 *
+					 * @param blitOnly tells whether the loaded image surface
+					 * should only be blitted into the supposed already existing
+					 * internal surface and then be deallocated, or if this
+					 * loaded surface should simply replace the former one.
+					 *
+					 * @param convertToDisplay tells whether this loaded image
+					 * should have its pixel format converted to the screen's
+					 * format, if it is not already the case. It is not, by
+					 * default, as raw images are meant to be stored in the
+					 * format they are to be used with.
+					 *
+					 * @param convertWithAlpha if the conversion to screen
+					 * format is selected, tells whether the converted surface
+					 * should also have an alpha channel.
+					 *
+					 * @throw ImageException if the file is not a valid raw
+					 * image, or if the loading failed.
+					 *
+					 */
+					static void LoadRaw( Surface & targetSurface,
+						const std::string & filename,
+						bool blitOnly = false,
+						bool convertToDisplay = false,
+						bool convertWithAlpha = true ) ;
+
+
+
+					/**
+					 * Saves specified surface on file, with specified filename,
+					 * as an OSDL raw image, i.e. with its pixels stored in their
+					 * current format.
+					 *
+					 * The file is made of (integers being stored little
+					 * endian):
+					 *  - the RawImageTag (Uint16)
+					 *  - the format version, RawImageVersion (Uint8)
+					 *  - flags (Uint8): 1 if the surface has a colorkey, 2 if
+					 * it uses alpha blending, 4 if the payload is compressed
+					 *  - the width and the height, in pixels (Uint16 each)
+					 *  - the number of bits, then of bytes, per pixel (Uint8
+					 * each)
+					 *  - the pitch, in bytes (Uint16)
+					 *  - the red, green, blue and alpha masks (Uint32 each)
+					 *  - the colorkey (Uint32)
+					 *  - the surface alpha (Uint8), then a reserved byte
+					 *  - the number of palette colors, zero if not color
+					 * indexed (Uint16)
+					 *  - the size of the stored payload, then the size of
+					 * the decompressed one, i.e. pitch * height (Uint32 each)
+					 *  - the palette colors, as red, green, blue and unused
+					 * bytes
+					 *  - zero padding, so that the payload starts at an offset
+					 * multiple of RawImageAlignment (64 bytes) from the
+					 * beginning of the file, allowing it to be mapped and
+					 * accessed efficiently
+					 *  - the payload, i.e. the pixel rows, pitch included, as
+					 * one LZ4 block if compressed.
+					 *
+					 * @param targetSurface the surface that should be saved on
+					 * file. Not 'const' as it may have to be locked.
+					 *
+					 * @param filename the name of the raw image file, whose
+					 * conventional extension is '.osdl.raw'.
+					 *
+					 * @param compress tells whether the payload should be
+					 * LZ4-compressed. It is stored uncompressed anyway if
+					 * compression does not reduce its size.
+					 *
+					 * @param overwrite tells whether an already existing file
+					 * should be overwritten.
+					 *
+					 * @throw ImageException if the operation failed.
+					 *
+					 */
+					static void SaveRaw( Surface & targetSurface,
+						const std::string & filename,
+						bool compress = true,
+						bool overwrite = true ) ;
+
+
+
+
 				protected:
 
 
@@ -982,6 +1115,34 @@ namespace OSDL
 
 
 
+					/// The compression level used by default by SavePNG.
+					static const Ceylan::Uint8 DefaultPNGCompressionLevel ;
+
+
+
+					/**
+					 * A compression level for SavePNG trading file size for
+					 * speed, suitable for frame sequences.
+					 *
+					 */
+					static const Ceylan::Uint8 FastPNGCompressionLevel ;
+
+
+
+					/// The version of the raw image format written by SaveRaw.
+					static const Ceylan::Uint8 RawImageVersion ;
+
+
+
+					/**
+					 * The alignment, in bytes, of the pixel payload in raw
+					 * image files.
+					 *
+					 */
+					static const Ceylan::Uint32 RawImageAlignment ;
+
+
+
 			} ;
 
 
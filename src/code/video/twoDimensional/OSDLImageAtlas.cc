@@ -0,0 +1,654 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDLImageAtlas.h"
+
+#include "OSDLSurface.h"             // for Surface
+#include "OSDLUtils.h"               // for getBackendLastError
+#include "OSDLFileTags.h"            // for AtlasIndexTag
+
+
+
+#ifdef OSDL_USES_CONFIG_H
+#include <OSDLConfig.h>              // for OSDL_USES_SDL and al
+#endif // OSDL_USES_CONFIG_H
+
+#if OSDL_ARCH_NINTENDO_DS
+#include "OSDLConfigForNintendoDS.h" // for OSDL_USES_* and al
+#endif // OSDL_ARCH_NINTENDO_DS
+
+
+
+using std::string ;
+using std::vector ;
+using std::map ;
+
+using namespace Ceylan::Log ;
+using namespace Ceylan::System ;
+
+using namespace OSDL::Video ;
+using namespace OSDL::Video::TwoDimensional ;
+
+
+
+const Ceylan::Uint8 ImageAtlas::IndexVersion   = 1 ;
+const string        ImageAtlas::IndexExtension = ".osdl.atlas" ;
+
+
+
+/// Reads a string stored as its length followed by its characters.
+static string ReadIndexString( File & indexFile )
+{
+
+	Ceylan::Uint16 length = indexFile.readUint16() ;
+
+	if ( length == 0 )
+		return "" ;
+
+	vector<char> characters( length ) ;
+
+	indexFile.readExactLength(
+		reinterpret_cast<Ceylan::Byte *>( & characters[0] ), length ) ;
+
+	return string( & characters[0], length ) ;
+
+}
+
+
+
+/// Writes a string as its length followed by its characters.
+static void WriteIndexString( File & indexFile, const string & toWrite )
+{
+
+	if ( toWrite.size() > 65535 )
+		throw ImageException( "string too long to be stored in an index: '"
+			+ toWrite + "'" ) ;
+
+	indexFile.writeUint16( static_cast<Ceylan::Uint16>( toWrite.size() ) ) ;
+
+	if ( ! toWrite.empty() )
+		indexFile.write( reinterpret_cast<const Ceylan::Byte *>(
+			toWrite.data() ), static_cast<Size>( toWrite.size() ) ) ;
+
+}
+
+
+
+
+// ImageAtlas section.
+
+
+
+ImageAtlas::ImageAtlas( const string & indexFilename,
+		bool convertToDisplayFormat, bool convertWithAlpha ) :
+	_convertToDisplayFormat( convertToDisplayFormat ),
+	_convertWithAlpha( convertWithAlpha ),
+	_indexFilename( indexFilename )
+{
+
+	// Page filenames are relative to the directory of the index:
+	string::size_type slashPos = indexFilename.rfind( '/' ) ;
+
+	string directory = ( slashPos == string::npos ) ?
+		"" : indexFilename.substr( 0, slashPos + 1 ) ;
+
+	try
+	{
+
+		Ceylan::Holder<File> indexHolder( File::Open( indexFilename ) ) ;
+
+		OSDL::FileTag readTag = indexHolder->readUint16() ;
+
+		if ( readTag != OSDL::AtlasIndexTag )
+			throw ImageException( "expected tag for atlas indexes ("
+				+ Ceylan::toString( OSDL::AtlasIndexTag ) + "), read instead "
+				+ Ceylan::toString( readTag ) ) ;
+
+		Ceylan::Uint8 version = indexHolder->readUint8() ;
+
+		if ( version != IndexVersion )
+			throw ImageException( "unsupported atlas index version "
+				+ Ceylan::toNumericalString( version ) ) ;
+
+		// Reserved:
+		indexHolder->readUint8() ;
+
+		Ceylan::Uint16 pageCount  = indexHolder->readUint16() ;
+		Ceylan::Uint32 entryCount = indexHolder->readUint32() ;
+
+		_pages.reserve( pageCount ) ;
+		_pageUsers.resize( pageCount, 0 ) ;
+
+		for ( Ceylan::Uint16 i = 0; i < pageCount; i++ )
+			_pages.push_back( new Image( directory
+				+ ReadIndexString( *indexHolder ), /* preload */ false,
+				convertToDisplayFormat, convertWithAlpha ) ) ;
+
+		_entries.resize( entryCount ) ;
+
+		for ( Ceylan::Uint32 i = 0; i < entryCount; i++ )
+		{
+
+			AtlasEntry & entry = _entries[i] ;
+
+			entry.name           = ReadIndexString( *indexHolder ) ;
+			entry.page           = indexHolder->readUint16() ;
+			entry.x              = indexHolder->readUint16() ;
+			entry.y              = indexHolder->readUint16() ;
+			entry.width          = indexHolder->readUint16() ;
+			entry.height         = indexHolder->readUint16() ;
+			entry.trimX          = indexHolder->readUint16() ;
+			entry.trimY          = indexHolder->readUint16() ;
+			entry.originalWidth  = indexHolder->readUint16() ;
+			entry.originalHeight = indexHolder->readUint16() ;
+
+			if ( entry.page >= pageCount )
+				throw ImageException( "entry '" + entry.name
+					+ "' refers to page #" + Ceylan::toString( entry.page )
+					+ ", whereas there are only "
+					+ Ceylan::toString( pageCount ) + " pages" ) ;
+
+			if ( entry.width == 0 || entry.height == 0 )
+				throw ImageException( "entry '" + entry.name
+					+ "' has an empty area" ) ;
+
+			_entryIndexes[ entry.name ] = i ;
+
+		}
+
+	}
+	catch( const Ceylan::Exception & e )
+	{
+
+		throw ImageException( "ImageAtlas constructor failed for '"
+			+ indexFilename + "': " + e.toString() ) ;
+
+	}
+
+}
+
+
+
+ImageAtlas::~ImageAtlas() throw()
+{
+
+	// Pages are unloaded, if needed, when their counted pointers are dropped.
+
+}
+
+
+
+const string & ImageAtlas::getIndexFilename() const
+{
+
+	return _indexFilename ;
+
+}
+
+
+
+Ceylan::Uint16 ImageAtlas::getPageCount() const
+{
+
+	return static_cast<Ceylan::Uint16>( _pages.size() ) ;
+
+}
+
+
+
+Ceylan::Uint16 ImageAtlas::getLoadedPageCount() const
+{
+
+	Ceylan::Uint16 count = 0 ;
+
+	for ( vector<Ceylan::Uint32>::const_iterator it = _pageUsers.begin();
+			it != _pageUsers.end(); it++ )
+		if ( *it != 0 )
+			count++ ;
+
+	return count ;
+
+}
+
+
+
+Ceylan::Uint32 ImageAtlas::getEntryCount() const
+{
+
+	return static_cast<Ceylan::Uint32>( _entries.size() ) ;
+
+}
+
+
+
+const AtlasEntry & ImageAtlas::getEntry( Ceylan::Uint32 entryIndex ) const
+{
+
+	if ( entryIndex >= _entries.size() )
+		throw ImageException( "ImageAtlas::getEntry failed: index "
+			+ Ceylan::toString( entryIndex ) + " out of bounds, "
+			+ Ceylan::toString( _entries.size() ) + " entries available." ) ;
+
+	return _entries[ entryIndex ] ;
+
+}
+
+
+
+bool ImageAtlas::findEntry( const string & name,
+	Ceylan::Uint32 & entryIndex ) const
+{
+
+	map<string, Ceylan::Uint32>::const_iterator it =
+		_entryIndexes.find( name ) ;
+
+	if ( it == _entryIndexes.end() )
+		return false ;
+
+	entryIndex = (*it).second ;
+
+	return true ;
+
+}
+
+
+
+Surface & ImageAtlas::acquirePage( Ceylan::Uint16 page )
+{
+
+	if ( page >= _pages.size() )
+		throw ImageException( "ImageAtlas::acquirePage failed: no page #"
+			+ Ceylan::toString( page ) + " in atlas '" + _indexFilename
+			+ "'." ) ;
+
+	ImageCountedPtr pagePtr = _pages[ page ] ;
+
+	Surface * pageSurface ;
+
+	try
+	{
+
+		pagePtr->load() ;
+
+		pageSurface = & pagePtr->getExistingContent() ;
+
+	}
+	catch( const Ceylan::LoadableException & e )
+	{
+
+		throw ImageException( "ImageAtlas::acquirePage failed: "
+			+ e.toString() ) ;
+
+	}
+
+#if OSDL_USES_SDL
+
+	/*
+	 * The pixels of a page in video memory are only reachable while the page
+	 * is locked, thus they cannot be shared:
+	 *
+	 */
+	if ( ( pageSurface->getSDLSurface().flags & SDL_HWSURFACE ) != 0 )
+	{
+
+		if ( _pageUsers[ page ] == 0 )
+			pagePtr->unload() ;
+
+		throw ImageException( "ImageAtlas::acquirePage failed: page #"
+			+ Ceylan::toString( page ) + " of atlas '" + _indexFilename
+			+ "' is in video memory, its pixels cannot be shared." ) ;
+
+	}
+
+#endif // OSDL_USES_SDL
+
+	_pageUsers[ page ]++ ;
+
+	return * pageSurface ;
+
+}
+
+
+
+void ImageAtlas::releasePage( Ceylan::Uint16 page )
+{
+
+	if ( page >= _pages.size() || _pageUsers[ page ] == 0 )
+		throw ImageException( "ImageAtlas::releasePage failed: page #"
+			+ Ceylan::toString( page ) + " of atlas '" + _indexFilename
+			+ "' is not in use." ) ;
+
+	_pageUsers[ page ]-- ;
+
+	if ( _pageUsers[ page ] == 0 )
+		_pages[ page ]->unload() ;
+
+}
+
+
+
+const string ImageAtlas::toString( Ceylan::VerbosityLevels level ) const
+{
+
+	string res = "Image atlas read from '" + _indexFilename + "', with "
+		+ Ceylan::toString( _entries.size() ) + " images packed in "
+		+ Ceylan::toString( _pages.size() ) + " page(s), "
+		+ Ceylan::toString( getLoadedPageCount() ) + " of them being loaded" ;
+
+	if ( level == Ceylan::low )
+		return res ;
+
+	std::list<string> pages ;
+
+	for ( Ceylan::Uint16 i = 0; i < _pages.size(); i++ )
+		pages.push_back( "page #" + Ceylan::toString( i ) + ", used by "
+			+ Ceylan::toString( _pageUsers[i] ) + " loaded image(s): "
+			+ _pages[i]->toString( Ceylan::low ) ) ;
+
+	return res + ": " + Ceylan::formatStringList( pages ) ;
+
+}
+
+
+
+void ImageAtlas::SaveIndex( const string & indexFilename,
+	const vector<string> & pageFilenames, const vector<AtlasEntry> & entries )
+{
+
+	if ( pageFilenames.size() > 65535 )
+		throw ImageException( "ImageAtlas::SaveIndex failed: too many pages ("
+			+ Ceylan::toString( pageFilenames.size() ) + ")." ) ;
+
+	try
+	{
+
+		Ceylan::Holder<File> indexHolder( File::Create( indexFilename ) ) ;
+
+		indexHolder->writeUint16( OSDL::AtlasIndexTag ) ;
+		indexHolder->writeUint8( IndexVersion ) ;
+
+		// Reserved:
+		indexHolder->writeUint8( 0 ) ;
+
+		indexHolder->writeUint16(
+			static_cast<Ceylan::Uint16>( pageFilenames.size() ) ) ;
+
+		indexHolder->writeUint32(
+			static_cast<Ceylan::Uint32>( entries.size() ) ) ;
+
+		for ( vector<string>::const_iterator it = pageFilenames.begin();
+				it != pageFilenames.end(); it++ )
+			WriteIndexString( *indexHolder, *it ) ;
+
+		for ( vector<AtlasEntry>::const_iterator it = entries.begin();
+				it != entries.end(); it++ )
+		{
+
+			WriteIndexString( *indexHolder, (*it).name ) ;
+
+			indexHolder->writeUint16( (*it).page ) ;
+			indexHolder->writeUint16( (*it).x ) ;
+			indexHolder->writeUint16( (*it).y ) ;
+			indexHolder->writeUint16( (*it).width ) ;
+			indexHolder->writeUint16( (*it).height ) ;
+			indexHolder->writeUint16( (*it).trimX ) ;
+			indexHolder->writeUint16( (*it).trimY ) ;
+			indexHolder->writeUint16( (*it).originalWidth ) ;
+			indexHolder->writeUint16( (*it).originalHeight ) ;
+
+		}
+
+	}
+	catch( const Ceylan::Exception & e )
+	{
+
+		throw ImageException( "ImageAtlas::SaveIndex failed for '"
+			+ indexFilename + "': " + e.toString() ) ;
+
+	}
+
+}
+
+
+
+
+// AtlasImage section.
+
+
+
+AtlasImage::AtlasImage( ImageAtlasCountedPtr atlas, Ceylan::Uint32 entryIndex,
+		bool preload ) :
+	Image( atlas->getEntry( entryIndex ).name, /* preload */ false,
+		/* convertToDisplayFormat */ false ),
+	_atlas( atlas ),
+	_entryIndex( entryIndex )
+{
+
+	if ( preload )
+	{
+
+		try
+		{
+
+			load() ;
+
+		}
+		catch( const Ceylan::LoadableException & e )
+		{
+
+			throw ImageException( "AtlasImage constructor failed while "
+				"preloading: " + e.toString() ) ;
+
+		}
+
+	}
+
+}
+
+
+
+AtlasImage::~AtlasImage() throw()
+{
+
+	// Must be done here, as the Image destructor knows nothing of pages:
+	try
+	{
+
+		if ( hasContent() )
+			unload() ;
+
+	}
+	catch( const Ceylan::LoadableException & e )
+	{
+
+		LogPlug::error( "AtlasImage destructor failed while unloading: "
+			+ e.toString() ) ;
+
+	}
+
+}
+
+
+
+bool AtlasImage::load()
+{
+
+	if ( hasContent() )
+		return false ;
+
+#if OSDL_USES_SDL
+
+	const AtlasEntry & entry = getEntry() ;
+
+	try
+	{
+
+		Surface & page = _atlas->acquirePage( entry.page ) ;
+
+		LowLevelSurface & pageSurface = page.getSDLSurface() ;
+		const SDL_PixelFormat & format = * pageSurface.format ;
+
+		if ( entry.x + entry.width > pageSurface.w
+				|| entry.y + entry.height > pageSurface.h )
+		{
+
+			_atlas->releasePage( entry.page ) ;
+
+			throw ImageException( "packed area out of the bounds of page #"
+				+ Ceylan::toString( entry.page ) ) ;
+
+		}
+
+		// The view starts at the packed area and keeps the pitch of the page:
+		LowLevelSurface * view = SDL_CreateRGBSurfaceFrom(
+			static_cast<Ceylan::Uint8 *>( pageSurface.pixels )
+				+ entry.y * pageSurface.pitch
+				+ entry.x * format.BytesPerPixel,
+			entry.width, entry.height, format.BitsPerPixel,
+			pageSurface.pitch, format.Rmask, format.Gmask, format.Bmask,
+			format.Amask ) ;
+
+		if ( view == 0 )
+		{
+
+			_atlas->releasePage( entry.page ) ;
+
+			throw ImageException( "view creation failed: "
+				+ Utils::getBackendLastError() ) ;
+
+		}
+
+		if ( format.palette != 0 )
+			SDL_SetPalette( view, SDL_LOGPAL | SDL_PHYSPAL,
+				format.palette->colors, 0, format.palette->ncolors ) ;
+
+		// Blitting the view must behave as blitting the page would:
+		SDL_SetColorKey( view, pageSurface.flags & SDL_SRCCOLORKEY,
+			format.colorkey ) ;
+
+		SDL_SetAlpha( view, pageSurface.flags & SDL_SRCALPHA, format.alpha ) ;
+
+		// The view does not own its pixels, SDL will not free them:
+		_content = new Surface( * view ) ;
+
+	}
+	catch( const Ceylan::Exception & e )
+	{
+
+		throw Ceylan::LoadableException( "AtlasImage::load failed for '"
+			+ _contentPath + "': " + e.toString() ) ;
+
+	}
+
+	return true ;
+
+#else // OSDL_USES_SDL
+
+	throw Ceylan::LoadableException( "AtlasImage::load failed: "
+		"no SDL support available" ) ;
+
+#endif // OSDL_USES_SDL
+
+}
+
+
+
+bool AtlasImage::unload()
+{
+
+	if ( ! hasContent() )
+		return false ;
+
+	// The view must be deleted before its page may be:
+	delete _content ;
+	_content = 0 ;
+
+	try
+	{
+
+		_atlas->releasePage( getEntry().page ) ;
+
+	}
+	catch( const Ceylan::Exception & e )
+	{
+
+		throw Ceylan::LoadableException( "AtlasImage::unload failed for '"
+			+ _contentPath + "': " + e.toString() ) ;
+
+	}
+
+	return true ;
+
+}
+
+
+
+const AtlasEntry & AtlasImage::getEntry() const
+{
+
+	return _atlas->getEntry( _entryIndex ) ;
+
+}
+
+
+
+void AtlasImage::getTrimOffset( Length & x, Length & y ) const
+{
+
+	const AtlasEntry & entry = getEntry() ;
+
+	x = entry.trimX ;
+	y = entry.trimY ;
+
+}
+
+
+
+const string AtlasImage::toString( Ceylan::VerbosityLevels level ) const
+{
+
+	const AtlasEntry & entry = getEntry() ;
+
+	string res = "Image '" + _contentPath + "' packed in page #"
+		+ Ceylan::toString( entry.page ) + " of atlas '"
+		+ _atlas->getIndexFilename() + "', at ["
+		+ Ceylan::toString( entry.x ) + ";" + Ceylan::toString( entry.y )
+		+ "], of size " + Ceylan::toString( entry.width ) + "x"
+		+ Ceylan::toString( entry.height ) ;
+
+	if ( entry.width != entry.originalWidth
+			|| entry.height != entry.originalHeight )
+		res += " (trimmed from " + Ceylan::toString( entry.originalWidth )
+			+ "x" + Ceylan::toString( entry.originalHeight ) + ", at offset ["
+			+ Ceylan::toString( entry.trimX ) + ";"
+			+ Ceylan::toString( entry.trimY ) + "])" ;
+
+	if ( _content == 0 )
+		return res + ". It is not loaded" ;
+
+	return res + ". It is loaded: " + _content->toString( level ) ;
+
+}
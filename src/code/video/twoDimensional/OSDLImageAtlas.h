@@ -0,0 +1,579 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#ifndef OSDL_IMAGE_ATLAS_H_
+#define OSDL_IMAGE_ATLAS_H_
+
+
+#include "OSDLImage.h"           // for Image, ImageCountedPtr, ImageException
+#include "OSDLVideoTypes.h"      // for Length
+
+#include "Ceylan.h"              // for TextDisplayable, CountedPointer
+
+#include <string>
+#include <vector>
+#include <map>
+
+
+
+
+namespace OSDL
+{
+
+
+
+	namespace Video
+	{
+
+
+
+		namespace TwoDimensional
+		{
+
+
+
+			/**
+			 * Describes where an image packed in an atlas lies, and how it
+			 * was trimmed.
+			 *
+			 * Trimming removes the fully transparent borders of an image
+			 * before packing it: only the remaining area is stored in the
+			 * page, and the offset of that area in the original image is
+			 * recorded, so that the image can be blitted at the right place.
+			 *
+			 */
+			typedef struct
+			{
+
+
+				/**
+				 * The name of the packed image, usually the path of its
+				 * original file, as referenced in the resource map.
+				 *
+				 */
+				std::string name ;
+
+
+				/// The index of the page this image is packed in.
+				Ceylan::Uint16 page ;
+
+
+				/// The abscissa of the packed area in its page.
+				Length x ;
+
+
+				/// The ordinate of the packed area in its page.
+				Length y ;
+
+
+				/// The width of the packed area.
+				Length width ;
+
+
+				/// The height of the packed area.
+				Length height ;
+
+
+				/// The abscissa of the packed area in the original image.
+				Length trimX ;
+
+
+				/// The ordinate of the packed area in the original image.
+				Length trimY ;
+
+
+				/// The width of the original image, before trimming.
+				Length originalWidth ;
+
+
+				/// The height of the original image, before trimming.
+				Length originalHeight ;
+
+
+			} AtlasEntry ;
+
+
+
+			class ImageAtlas ;
+
+
+			/// Counted pointer to image atlases, shared by their images.
+			typedef Ceylan::CountedPointer<ImageAtlas> ImageAtlasCountedPtr ;
+
+
+
+			/**
+			 * An image atlas gathers many small images (ex: sprite frames)
+			 * into a few large pages, so that they are loaded as a few large
+			 * surfaces instead of as many separate ones.
+			 *
+			 * An atlas is described by an index file, which lists its pages
+			 * (images, usually PNG files, stored next to the index) and the
+			 * location in these pages of each packed image.
+			 *
+			 * Atlases are produced offline by the imagesToOSDLAtlas tool
+			 * (trunk/tools/media/video/imagesToOSDLAtlas.cc), which packs
+			 * images thanks to the MaxRects algorithm.
+			 *
+			 * The images of an atlas are retrieved as AtlasImage instances,
+			 * whose surfaces are views sharing the pixels of their page, not
+			 * copies. A page is loaded as soon as one of its images is loaded,
+			 * and unloaded once none of them is loaded anymore.
+			 *
+			 * @see ResourceManager::registerImageAtlas
+			 *
+			 */
+			class OSDL_DLL ImageAtlas : public Ceylan::TextDisplayable
+			{
+
+
+				public:
+
+
+
+					/**
+					 * Creates an image atlas from its index file.
+					 *
+					 * Only the index is read here, pages are loaded on
+					 * demand.
+					 *
+					 * @param indexFilename the name of the index file of the
+					 * atlas; the filenames of its pages are relative to the
+					 * directory of that index.
+					 *
+					 * @param convertToDisplayFormat tells whether the pages
+					 * should be converted to the format of the screen when
+					 * loaded (see Image::Image). The display must then be
+					 * set in a software mode, as views into pages stored in
+					 * video memory cannot be made.
+					 *
+					 * @param convertWithAlpha if the pages are converted to
+					 * the display format, tells whether they should have an
+					 * alpha channel as well.
+					 *
+					 * @throw ImageException if the index could not be read.
+					 *
+					 */
+					explicit ImageAtlas( const std::string & indexFilename,
+						bool convertToDisplayFormat = false,
+						bool convertWithAlpha = true ) ;
+
+
+
+					/**
+					 * Virtual destructor.
+					 *
+					 * @note Its pages are unloaded as well, thus no image of
+					 * this atlas should remain loaded; as each AtlasImage
+					 * shares the ownership of its atlas, this cannot happen.
+					 *
+					 */
+					virtual ~ImageAtlas() throw() ;
+
+
+
+					/// Returns the name of the index file of this atlas.
+					virtual const std::string & getIndexFilename() const ;
+
+
+
+					/// Returns the number of pages of this atlas.
+					virtual Ceylan::Uint16 getPageCount() const ;
+
+
+
+					/// Returns the number of pages currently loaded.
+					virtual Ceylan::Uint16 getLoadedPageCount() const ;
+
+
+
+					/// Returns the number of images packed in this atlas.
+					virtual Ceylan::Uint32 getEntryCount() const ;
+
+
+
+					/**
+					 * Returns the description of the packed image of
+					 * specified index.
+					 *
+					 * @throw ImageException if the index is out of bounds.
+					 *
+					 */
+					virtual const AtlasEntry & getEntry(
+						Ceylan::Uint32 entryIndex ) const ;
+
+
+
+					/**
+					 * Tells whether an image of specified name is packed in
+					 * this atlas and, if yes, sets the specified index to
+					 * the one of its entry.
+					 *
+					 */
+					virtual bool findEntry( const std::string & name,
+						Ceylan::Uint32 & entryIndex ) const ;
+
+
+
+					/**
+					 * Returns the surface of specified page, loaded if
+					 * needed, and records one more user of that page.
+					 *
+					 * Each call must be paired with a call to releasePage.
+					 *
+					 * @throw ImageException if the page could not be loaded,
+					 * or if its pixels cannot be shared.
+					 *
+					 */
+					virtual Surface & acquirePage( Ceylan::Uint16 page ) ;
+
+
+
+					/**
+					 * Records that one user of specified page does not need
+					 * it anymore; the page is unloaded once it has no more
+					 * user.
+					 *
+					 * @throw ImageException if the page had no user.
+					 *
+					 */
+					virtual void releasePage( Ceylan::Uint16 page ) ;
+
+
+
+					/**
+					 * Returns an user-friendly description of the state of
+					 * this object.
+					 *
+					 * @param level the requested verbosity level.
+					 *
+					 * @note Text output format is determined from overall
+					 * settings.
+					 *
+					 * @see Ceylan::TextDisplayable
+					 *
+					 */
+					virtual const std::string toString(
+						Ceylan::VerbosityLevels level = Ceylan::high ) const ;
+
+
+
+
+					// Static section.
+
+
+
+					/**
+					 * Writes the index of an atlas in specified file.
+					 *
+					 * The index starts with the AtlasIndexTag file tag, the
+					 * IndexVersion byte and a reserved byte, followed by the
+					 * number of pages and the number of entries (respectively
+					 * a 16-bit and a 32-bit unsigned integer). Then comes the
+					 * filename of each page, then each entry: its name, then
+					 * its page, x, y, width, height, trimX, trimY,
+					 * originalWidth and originalHeight fields, all 16-bit
+					 * unsigned integers. Strings are stored as their 16-bit
+					 * length followed by their characters, with no
+					 * terminating null byte.
+					 *
+					 * @param indexFilename the name of the index file to
+					 * create.
+					 *
+					 * @param pageFilenames the filenames of the pages,
+					 * relative to the directory of the index.
+					 *
+					 * @param entries the images packed in these pages.
+					 *
+					 * @throw ImageException if the operation failed.
+					 *
+					 */
+					static void SaveIndex( const std::string & indexFilename,
+						const std::vector<std::string> & pageFilenames,
+						const std::vector<AtlasEntry> & entries ) ;
+
+
+
+					/// The version of the index format written by SaveIndex.
+					static const Ceylan::Uint8 IndexVersion ;
+
+
+					/// The extension of atlas index files, ".osdl.atlas".
+					static const std::string IndexExtension ;
+
+
+
+				protected:
+
+
+					/// Whether pages are converted to the display format.
+					bool _convertToDisplayFormat ;
+
+
+					/// Whether converted pages have an alpha channel.
+					bool _convertWithAlpha ;
+
+
+
+/*
+ * Takes care of the awful issue of Windows DLL with templates.
+ *
+ * @see Ceylan's developer guide and README-build-for-windows.txt to understand
+ * it, and to be aware of the associated risks.
+ *
+ */
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+
+					/// The name of the index file of this atlas.
+					std::string _indexFilename ;
+
+					/// The pages of this atlas, loaded on demand.
+					std::vector<ImageCountedPtr> _pages ;
+
+					/// The number of users of each page.
+					std::vector<Ceylan::Uint32> _pageUsers ;
+
+					/// The images packed in this atlas, in index order.
+					std::vector<AtlasEntry> _entries ;
+
+					/// Allows to find an entry from the name of its image.
+					std::map<std::string, Ceylan::Uint32> _entryIndexes ;
+
+#pragma warning( pop )
+
+
+
+				private:
+
+
+
+					/**
+					 * Copy constructor made private to ensure that it will be
+					 * never called.
+					 *
+					 * The compiler should complain whenever this undefined
+					 * constructor is called, implicitly or not.
+					 *
+					 */
+					ImageAtlas( const ImageAtlas & source ) ;
+
+
+
+					/**
+					 * Assignment operator made private to ensure that it will
+					 * be never called.
+					 *
+					 * The compiler should complain whenever this undefined
+					 * operator is called, implicitly or not.
+					 *
+					 */
+					ImageAtlas & operator = ( const ImageAtlas & source ) ;
+
+
+			} ;
+
+
+
+
+			/**
+			 * An image packed in an atlas.
+			 *
+			 * Once loaded, its content is a surface whose pixels are the ones
+			 * of the packed area in the atlas page, shared rather than
+			 * copied: the surface has the pitch of the page, and drawing into
+			 * it draws into the page. Blitting it is done as for any other
+			 * surface.
+			 *
+			 * If the image was trimmed, its surface covers only the area that
+			 * was kept; getTrimOffset tells where that area lies in the
+			 * original image.
+			 *
+			 * Such images can be used in place of any Image, notably as
+			 * returned by ResourceManager::getImage.
+			 *
+			 */
+			class OSDL_DLL AtlasImage : public Image
+			{
+
+
+				public:
+
+
+
+					/**
+					 * Creates an image corresponding to an entry of the
+					 * specified atlas.
+					 *
+					 * @param atlas the atlas this image is packed in, whose
+					 * ownership is shared.
+					 *
+					 * @param entryIndex the index of the entry of this image
+					 * in the atlas.
+					 *
+					 * @param preload tells whether the image (hence its page)
+					 * should be loaded directly.
+					 *
+					 * @throw ImageException if the entry does not exist, or
+					 * if the preloading failed.
+					 *
+					 */
+					AtlasImage( ImageAtlasCountedPtr atlas,
+						Ceylan::Uint32 entryIndex, bool preload = false ) ;
+
+
+
+					/// Virtual destructor, releases the page if loaded.
+					virtual ~AtlasImage() throw() ;
+
+
+
+					/**
+					 * Creates the view into the page of this image, loading
+					 * that page if needed.
+					 *
+					 * @return true iff the image had to be actually loaded
+					 * (otherwise it was already loaded and nothing was done).
+					 *
+					 * @throw Ceylan::LoadableException whenever the loading
+					 * fails.
+					 *
+					 */
+					virtual bool load() ;
+
+
+
+					/**
+					 * Removes the view into the page of this image, which is
+					 * unloaded if no other image of that page is loaded.
+					 *
+					 * @return true iff the image had to be actually unloaded
+					 * (otherwise it was not already available and nothing was
+					 * done).
+					 *
+					 * @throw Ceylan::LoadableException whenever the unloading
+					 * fails.
+					 *
+					 */
+					virtual bool unload() ;
+
+
+
+					/// Returns the atlas entry describing this image.
+					virtual const AtlasEntry & getEntry() const ;
+
+
+
+					/**
+					 * Returns the offset of the packed area in the original
+					 * image, i.e. the offset to add to the location where the
+					 * original image would have been blitted.
+					 *
+					 */
+					virtual void getTrimOffset( Length & x, Length & y ) const ;
+
+
+
+					/**
+					 * Returns an user-friendly description of the state of
+					 * this object.
+					 *
+					 * @param level the requested verbosity level.
+					 *
+					 * @note Text output format is determined from overall
+					 * settings.
+					 *
+					 * @see Ceylan::TextDisplayable
+					 *
+					 */
+					virtual const std::string toString(
+						Ceylan::VerbosityLevels level = Ceylan::high ) const ;
+
+
+
+				protected:
+
+
+
+/*
+ * Takes care of the awful issue of Windows DLL with templates.
+ *
+ * @see Ceylan's developer guide and README-build-for-windows.txt to understand
+ * it, and to be aware of the associated risks.
+ *
+ */
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+
+					/// The atlas this image is packed in.
+					ImageAtlasCountedPtr _atlas ;
+
+#pragma warning( pop )
+
+
+					/// The index of the entry of this image in its atlas.
+					Ceylan::Uint32 _entryIndex ;
+
+
+
+				private:
+
+
+
+					/**
+					 * Copy constructor made private to ensure that it will be
+					 * never called.
+					 *
+					 * The compiler should complain whenever this undefined
+					 * constructor is called, implicitly or not.
+					 *
+					 */
+					AtlasImage( const AtlasImage & source ) ;
+
+
+
+					/**
+					 * Assignment operator made private to ensure that it will
+					 * be never called.
+					 *
+					 * The compiler should complain whenever this undefined
+					 * operator is called, implicitly or not.
+					 *
+					 */
+					AtlasImage & operator = ( const AtlasImage & source ) ;
+
+
+			} ;
+
+		}
+
+	}
+
+}
+
+
+
+#endif // OSDL_IMAGE_ATLAS_H_
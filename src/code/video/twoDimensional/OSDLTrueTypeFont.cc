@@ -28,12 +28,15 @@
 
 #include "OSDLSurface.h"             // for Surface
 #include "OSDLPixel.h"               // for ColorDefinition
-#include "OSDLUtils.h"               // for createDataStreamFrom
+#include "OSDLEmbeddedFile.h"        // for EmbeddedFile
+#include "OSDLWorkerPool.h"          // for WorkerPool, Job
 
 #include "Ceylan.h"                  // for Uint32, inheritance
 
 
 #include <list>
+#include <vector>
+#include <cstring>                   // for ::memset
 
 
 
@@ -52,9 +55,37 @@
 #endif // OSDL_USES_SDL_GFX
 
 #if OSDL_USES_SDL_TTF
+
 #include "SDL_ttf.h"                 // for TTF_GlyphMetrics and al
+
+
+/*
+ * SDL_ttf allows to toggle kerning from its 2.0.10 version on, and exposes
+ * the kerning of a pair of characters from its 2.0.14 version on; older
+ * versions kern silently whenever the face defines kerning pairs.
+ *
+ */
+#define OSDL_TTF_VERSION_NUMBER ( SDL_TTF_MAJOR_VERSION * 10000 \
+  + SDL_TTF_MINOR_VERSION * 100 + SDL_TTF_PATCHLEVEL )
+
+#define OSDL_TTF_TOGGLES_KERNING ( OSDL_TTF_VERSION_NUMBER >= 20010 )
+
+#define OSDL_TTF_EXPOSES_KERNING ( OSDL_TTF_VERSION_NUMBER >= 20014 )
+
 #endif // OSDL_USES_SDL_TTF
 
+
+#if ! defined(OSDL_RUNS_ON_WINDOWS) && ! OSDL_ARCH_NINTENDO_DS
+
+// Font files from the standard filesystem are memory-mapped:
+#define OSDL_MAPS_FONT_FILES 1
+
+#include <sys/mman.h>                // for mmap, munmap
+#include <fcntl.h>                   // for open
+#include <unistd.h>                  // for close
+
+#endif // ! defined(OSDL_RUNS_ON_WINDOWS) && ! OSDL_ARCH_NINTENDO_DS
+
 #if OSDL_USES_SDL
 #include "SDL.h"                     // for SDL_Surface
 #endif // OSDL_USES_SDL
@@ -88,11 +119,19 @@ PointSize Text::TrueTypeFont::DefaultPointSize = 20 ;
 const Ceylan::Float32 Text::TrueTypeFont::SpaceWidthFactor = 1 ;
 
 
+PointSize Text::TrueTypeFont::DefaultDistanceFieldPointSize = 48 ;
+
+const Length Text::TrueTypeFont::DistanceFieldSpread = 6 ;
+
+
 
 // Used to know when the SDL_TTF module can be stopped.
 Ceylan::Uint32 TrueTypeFont::FontCounter = 0 ;
 
 
+TrueTypeFont::FontBlobMap TrueTypeFont::FontBlobs ;
+
+
 
 
 TrueTypeFont::TrueTypeFont(
@@ -103,9 +142,25 @@ TrueTypeFont::TrueTypeFont(
   bool preload ) :
   Font( convertToDisplay, cacheSettings ),
   Ceylan::LoadableWithContent<LowLevelTTFFont>( fontFilename ),
-  _pointSize( DefaultPointSize )
+  _pointSize( DefaultPointSize ),
+  _fontHeight( 0 ),
+  _referenceFont( 0 ),
+  _referencePointSize( DefaultDistanceFieldPointSize ),
+  _referenceAscent( 0 ),
+  _referenceDescent( 0 ),
+  _referenceLineSkip( 0 ),
+  _distanceFields( 0 ),
+  _prewarmingFont( 0 ),
+  _prewarmingPool( 0 ),
+  _prewarmingJobs()
 {
 
+  for ( Ceylan::Uint16 page = 0; page < 256; page++ )
+  {
+	_metricsPages[page] = 0 ;
+	_kerningRows[page]  = 0 ;
+  }
+
   if ( preload )
   {
 
@@ -148,6 +203,10 @@ TrueTypeFont::~TrueTypeFont() throw()
 
   }
 
+  stopPrewarming() ;
+  clearDistanceFields() ;
+  closeReferenceFont() ;
+
   //LogPlug::trace( "TrueTypeFont '" + _contentPath + "' deallocated." ) ;
 
 
@@ -176,63 +235,28 @@ bool TrueTypeFont::load()
 	return false ;
 
 
-  if ( ::TTF_WasInit() == 0 )
-  {
-
-	if ( ::TTF_Init()== -1 )
-	  throw FontException(
-		"TrueTypeFont constructor: unable to init font library: "
-		+ DescribeLastError() ) ;
-
-  }
-
   // _content is currently still set to zero here.
 
-  try
-  {
-
-	/*
-	  Ceylan::checkpoint( "TrueTypeFont::load: actual loading for size "
-	  + Ceylan::toString( _pointSize ) ) ;
-	*/
 #if OSDL_DEBUG_FONT
 
-	  LogPlug::debug( "TrueTypeFont::load: loading from file '"
-		+ _contentPath + "' for size " + Ceylan::toString( _pointSize ) ) ;
+  LogPlug::debug( "TrueTypeFont::load: loading from file '"
+	+ _contentPath + "' for size " + Ceylan::toString( _pointSize ) ) ;
 
 #endif // OSDL_DEBUG_FONT
 
-	// Will be deleted by the IMG_Load_RW close callback:
-	Ceylan::System::File & fontFile = File::Open( _contentPath ) ;
-
-	_content = ::TTF_OpenFontRW(
-	  & OSDL::Utils::createDataStreamFrom( fontFile ),
-	  /* automatic free source */ true, _pointSize ) ;
-
-  }
-  catch( const Ceylan::Exception & e )
-  {
-
-	throw FontException(
-	  "TrueTypeFont constructor failed: unable to load from '"
-	  + _contentPath + "': " + e.toString() ) ;
+  // The content of the font file is shared with any other instance:
+  _content = & openBackendFont( _pointSize ) ;
 
-  }
+  _fontHeight = static_cast<Height>( ::TTF_FontHeight( _content ) ) ;
 
-  if ( _content == 0 )
-	throw FontException( "TrueTypeFont constructor: unable to open '"
-	  + _contentPath
-	  + "' with a point size of "
-	  + Ceylan::toString( _pointSize ) + " dots per inch: "
-	  + DescribeLastError() ) ;
+  // Latin-1 metrics are loaded once for all, the others on demand:
+  loadMetricsPage( 0 ) ;
 
   _spaceWidth = static_cast<Width>( SpaceWidthFactor * getWidth( ' ' ) ) ;
 
   // By default, the width of an alinea is a multiple of a space width:
   _alineaWidth = DefaultSpaceBasedAlineaWidth * _spaceWidth ;
 
-  FontCounter++ ;
-
   return true ;
 
 #else // OSDL_USES_SDL_TTF
@@ -254,6 +278,11 @@ bool TrueTypeFont::unload()
   if ( ! hasContent() )
 	return false ;
 
+  // Background renderings must not outlive the font they are based on:
+  stopPrewarming() ;
+
+  clearMetrics() ;
+
   // There is content to unload here:
 #if OSDL_ARCH_NINTENDO_DS
 
@@ -265,22 +294,12 @@ bool TrueTypeFont::unload()
 
 #if OSDL_USES_SDL_TTF
 
-  if ( _content != 0 )
-  {
-
-	/*
-	Ceylan::checkpoint( "TrueTypeFont::unload: actual unloading for '"
-	  + _contentPath + "'." ) ;
-	*/
-
-	::TTF_CloseFont( _content ) ;
-
-  }
-
-  FontCounter-- ;
+  /*
+  Ceylan::checkpoint( "TrueTypeFont::unload: actual unloading for '"
+	+ _contentPath + "'." ) ;
+  */
 
-  if ( FontCounter == 0 && ::TTF_WasInit() != 0 )
-	::TTF_Quit() ;
+  closeBackendFont( _content ) ;
 
 #else // OSDL_USES_SDL_MIXER
 
@@ -382,8 +401,16 @@ void TrueTypeFont::setRenderingStyle( RenderingStyle newStyle )
    */
 
   if ( newStyle != getRenderingStyle() )
+  {
+
 	::TTF_SetFontStyle( _content, newStyle ) ;
 
+	// Some styles (ex: bold) change the glyph metrics:
+	clearMetrics() ;
+	loadMetricsPage( 0 ) ;
+
+  }
+
 #else // OSDL_USES_SDL_TTF
 
   throw FontException( "TrueTypeFont::setRenderingStyle failed: "
@@ -413,15 +440,10 @@ Width TrueTypeFont::getWidth( Ceylan::Latin1Char character ) const
   if ( character == ' ' )
 	return getAdvance( ' ' ) ;
 
-  int minX, maxX ;
-
-  if ( ::TTF_GlyphMetrics( _content,
-	  Ceylan::UnicodeString::ConvertFromLatin1( character),
-	  & minX, & maxX, 0, 0, 0 ) != 0 )
-	throw FontException( "TrueTypeFont::getWidth: "
-	  + DescribeLastError() ) ;
+  const GlyphMetrics & metrics = getMetricsFor(
+	Ceylan::UnicodeString::ConvertFromLatin1( character ) ) ;
 
-  return static_cast<Width>( maxX - minX ) ;
+  return static_cast<Width>( metrics.maxX - metrics.minX ) ;
 
 #else // OSDL_USES_SDL_TTF
 
@@ -443,15 +465,8 @@ SignedWidth TrueTypeFont::getWidthOffset( Ceylan::Latin1Char character ) const
 	throw FontException( "TrueTypeFont::getWidthOffset failed: "
 	  "font not loaded" ) ;
 
-  int minX ;
-
-  if ( ::TTF_GlyphMetrics( _content,
-	  Ceylan::UnicodeString::ConvertFromLatin1( character),
-	  & minX, 0, 0, 0, 0 ) != 0 )
-	throw FontException( "TrueTypeFont::getWidthOffset: "
-	  + DescribeLastError() ) ;
-
-  return static_cast<SignedWidth>( minX ) ;
+  return getMetricsFor(
+	Ceylan::UnicodeString::ConvertFromLatin1( character ) ).minX ;
 
 #else // OSDL_USES_SDL_TTF
 
@@ -474,15 +489,8 @@ SignedHeight TrueTypeFont::getHeightAboveBaseline(
 	throw FontException( "TrueTypeFont::getHeightAboveBaseline failed: "
 	  "font not loaded" ) ;
 
-  int maxY ;
-
-  if ( ::TTF_GlyphMetrics( _content,
-	  Ceylan::UnicodeString::ConvertFromLatin1( character),
-	  0, 0, 0, & maxY, 0 ) != 0 )
-	throw FontException( "TrueTypeFont::getHeightAboveBaseline: "
-	  + DescribeLastError() ) ;
-
-  return static_cast<SignedHeight>( maxY ) ;
+  return getMetricsFor(
+	Ceylan::UnicodeString::ConvertFromLatin1( character ) ).maxY ;
 
 #else // OSDL_USES_SDL_TTF
 
@@ -505,15 +513,8 @@ OSDL::Video::SignedLength TrueTypeFont::getAdvance(
 	throw FontException( "TrueTypeFont::getAdvance failed: "
 	  "font not loaded" ) ;
 
-  int advance ;
-
-  if ( ::TTF_GlyphMetrics( _content,
-	  Ceylan::UnicodeString::ConvertFromLatin1( character),
-	  0, 0, 0, 0, & advance ) != 0 )
-	throw FontException( "TrueTypeFont::getAdvance: "
-	  + DescribeLastError() ) ;
-
-  return static_cast<SignedLength>( advance ) ;
+  return static_cast<SignedLength>( getMetricsFor(
+	  Ceylan::UnicodeString::ConvertFromLatin1( character ) ).advance ) ;
 
 #else // OSDL_USES_SDL_TTF
 
@@ -535,7 +536,7 @@ Text::Height TrueTypeFont::getHeight() const
 	throw FontException( "TrueTypeFont::getHeight failed: "
 	  "font not loaded" ) ;
 
-  return ::TTF_FontHeight( _content ) ;
+  return _fontHeight ;
 
 #else // OSDL_USES_SDL_TTF
 
@@ -694,135 +695,149 @@ string TrueTypeFont::getFaceStyleName() const
 
 
 
-// Bounding boxes section.
+// Metrics section.
 
 
 
-UprightRectangle & TrueTypeFont::getBoundingBoxFor(
-  Ceylan::Unicode glyph, SignedLength & advance ) const
+/**
+ * Decodes the UTF-8 sequence starting at the specified index in the specified
+ * text, and moves that index past it.
+ *
+ * Invalid sequences, and characters outside of the Basic Multilingual Plane,
+ * are decoded as the replacement character (U+FFFD).
+ *
+ */
+static Ceylan::Unicode decodeUTF8( const string & text,
+  string::size_type & index )
 {
 
-#if OSDL_USES_SDL_TTF
-
-  if ( ! hasContent() )
-	throw FontException( "TrueTypeFont::getBoundingBoxFor failed: "
-	  "font not loaded" ) ;
+  const Ceylan::Unicode ReplacementCharacter = 0xFFFD ;
 
-  int minX, maxX, minY, maxY, intAdvance ;
+  Ceylan::Uint8 first = static_cast<Ceylan::Uint8>( text[index++] ) ;
 
-  if ( ::TTF_GlyphMetrics( _content, glyph, & minX, & maxX,
-	  & minY, & maxY, & intAdvance ) != 0 )
-	throw FontException( "TrueTypeFont::getClippingBoxFor (glyph): "
-	  + DescribeLastError() ) ;
+  if ( first < 0x80 )
+	return first ;
 
-  advance = static_cast<SignedLength>( intAdvance ) ;
+  Ceylan::Uint32 value ;
+  Ceylan::Uint8 continuationCount ;
 
-  return * new UprightRectangle(
-	static_cast<Coordinate>( minX ),
-	static_cast<Coordinate>( maxY ),
-	static_cast<Length>( maxX - minX ),
-	static_cast<Length>( maxY - minY ) ) ;
+  if ( first >= 0xF0 )
+  {
+	value = first & 0x07 ;
+	continuationCount = 3 ;
+  }
+  else if ( first >= 0xE0 )
+  {
+	value = first & 0x0F ;
+	continuationCount = 2 ;
+  }
+  else if ( first >= 0xC0 )
+  {
+	value = first & 0x1F ;
+	continuationCount = 1 ;
+  }
+  else
+  {
+	// Stray continuation byte:
+	return ReplacementCharacter ;
+  }
 
-#else // OSDL_USES_SDL_TTF
+  while ( continuationCount > 0 && index < text.size() )
+  {
 
-  throw FontException( "TrueTypeFont::getBoundingBoxFor failed: "
-	"no SDL_ttf support available" ) ;
+	value = ( value << 6 )
+	  | ( static_cast<Ceylan::Uint8>( text[index++] ) & 0x3F ) ;
 
-#endif // OSDL_USES_SDL_TTF
+	continuationCount-- ;
 
-}
+  }
 
+  if ( continuationCount != 0 || value > 0xFFFF )
+	return ReplacementCharacter ;
 
+  return static_cast<Ceylan::Unicode>( value ) ;
 
-UprightRectangle & TrueTypeFont::getBoundingBoxFor( const std::string & text )
-  const
-{
+}
 
-#if OSDL_USES_SDL_TTF
 
-  if ( ! hasContent() )
-	throw FontException( "TrueTypeFont::getBoundingBoxFor failed: "
-	  "font not loaded" ) ;
 
-  int width, height ;
+const TrueTypeFont::GlyphMetrics & TrueTypeFont::getMetricsFor(
+  Ceylan::Unicode glyph ) const
+{
 
-  if ( ::TTF_SizeText( _content, text.c_str(), & width, & height ) != 0 )
-	throw FontException(
-	  "TrueTypeFont::getBoundingBoxFor (Latin-1 string): "
-	  + DescribeLastError() ) ;
+  Ceylan::Uint8 page = static_cast<Ceylan::Uint8>( glyph >> 8 ) ;
 
-  return * new UprightRectangle( 0, 0, static_cast<Length>( width ),
-	static_cast<Length>( height ) ) ;
+  if ( _metricsPages[page] == 0 )
+	loadMetricsPage( page ) ;
 
-#else // OSDL_USES_SDL_TTF
+  const GlyphMetrics & metrics = _metricsPages[page][ glyph & 0xFF ] ;
 
-  throw FontException( "TrueTypeFont::getBoundingBoxFor failed: "
-	"no SDL_ttf support available" ) ;
+  if ( ! metrics.available )
+	throw FontException( "TrueTypeFont::getMetricsFor: "
+	  "no metrics available for glyph #"
+	  + Ceylan::toString( static_cast<Ceylan::Uint32>( glyph ) ) ) ;
 
-#endif // OSDL_USES_SDL_TTF
+  return metrics ;
 
 }
 
 
 
-UprightRectangle & TrueTypeFont::getBoundingBoxForUTF8(
-  const std::string & text ) const
+void TrueTypeFont::loadMetricsPage( Ceylan::Uint8 page ) const
 {
 
 #if OSDL_USES_SDL_TTF
 
   if ( ! hasContent() )
-	throw FontException( "TrueTypeFont::getBoundingBoxForUTF8 failed: "
+	throw FontException( "TrueTypeFont::loadMetricsPage failed: "
 	  "font not loaded" ) ;
 
-  int width, height ;
-
-  if ( ::TTF_SizeUTF8( _content, text.c_str(), & width, & height ) != 0 )
-	throw FontException(
-	  "TrueTypeFont::getBoundingBoxFor (UTF-8 string): "
-	  + DescribeLastError() ) ;
-
-  return * new UprightRectangle( 0, 0, static_cast<Length>( width ),
-	static_cast<Length>( height ) ) ;
+  GlyphMetrics * metrics = new GlyphMetrics[256] ;
 
-#else // OSDL_USES_SDL_TTF
+  Ceylan::Unicode first = static_cast<Ceylan::Unicode>( page << 8 ) ;
 
-  throw FontException( "TrueTypeFont::getBoundingBoxForUTF8 failed: "
-	"no SDL_ttf support available" ) ;
+  int minX, maxX, minY, maxY, advance ;
 
-#endif // OSDL_USES_SDL_TTF
+  for ( Ceylan::Uint16 i = 0; i < 256; i++ )
+  {
 
-}
+	GlyphMetrics & current = metrics[i] ;
 
+	current.available = ( ::TTF_GlyphMetrics( _content,
+	  static_cast<Ceylan::Unicode>( first + i ),
+	  & minX, & maxX, & minY, & maxY, & advance ) == 0 ) ;
 
+	if ( current.available )
+	{
 
-UprightRectangle & TrueTypeFont::getBoundingBoxForUnicode(
-  const Ceylan::Unicode * text ) const
-{
+	  current.minX    = static_cast<SignedWidth>( minX ) ;
+	  current.maxX    = static_cast<SignedWidth>( maxX ) ;
+	  current.minY    = static_cast<SignedHeight>( minY ) ;
+	  current.maxY    = static_cast<SignedHeight>( maxY ) ;
+	  current.advance = static_cast<SignedWidth>( advance ) ;
 
-#if OSDL_USES_SDL_TTF
+	}
+	else
+	{
 
-  if ( ! hasContent() )
-	throw FontException( "TrueTypeFont::getBoundingBoxForUnicode failed: "
-	  "font not loaded" ) ;
+	  current.minX    = 0 ;
+	  current.maxX    = 0 ;
+	  current.minY    = 0 ;
+	  current.maxY    = 0 ;
+	  current.advance = 0 ;
 
-  if ( text == 0 )
-	throw FontException( "TrueTypeFont::getBoundingBoxForUnicode: "
-	  "null pointer for Unicode string." ) ;
+	}
 
-  int width, height ;
+  }
 
-  if ( ::TTF_SizeUNICODE( _content, text, & width, & height ) != 0 )
-	throw FontException(
-	  "TrueTypeFont::getBoundingBoxFor (Unicode string): "
-	  + DescribeLastError() ) ;
+  if ( _metricsPages[page] != 0 )
+	delete [] _metricsPages[page] ;
 
-  return * new UprightRectangle( 0, 0, static_cast<Length>( width ),
-	static_cast<Length>( height ) ) ;
+  _metricsPages[page] = metrics ;
 
 #else // OSDL_USES_SDL_TTF
 
-  throw FontException( "TrueTypeFont::getBoundingBoxForUnicode failed: "
+  throw FontException( "TrueTypeFont::loadMetricsPage failed: "
 	"no SDL_ttf support available" ) ;
 
 #endif // OSDL_USES_SDL_TTF
@@ -831,347 +846,2236 @@ UprightRectangle & TrueTypeFont::getBoundingBoxForUnicode(
 
 
 
+void TrueTypeFont::clearMetrics()
+{
 
-// Render section.
-
+  for ( Ceylan::Uint16 page = 0; page < 256; page++ )
+  {
 
+	if ( _metricsPages[page] != 0 )
+	{
+	  delete [] _metricsPages[page] ;
+	  _metricsPages[page] = 0 ;
+	}
 
-OSDL::Video::Surface & TrueTypeFont::renderLatin1Glyph(
-  Ceylan::Latin1Char character,
-  RenderQuality quality,
-  Pixels::ColorDefinition glyphColor )
-{
+	if ( _kerningRows[page] != 0 )
+	{
+	  delete [] _kerningRows[page] ;
+	  _kerningRows[page] = 0 ;
+	}
 
-  return renderUnicodeGlyph(
-	Ceylan::UnicodeString::ConvertFromLatin1( character ),
-	quality, glyphColor ) ;
+  }
 
 }
 
 
 
-void TrueTypeFont::blitLatin1Glyph(
-  Surface & targetSurface, Coordinate x, Coordinate y,
-  Ceylan::Latin1Char character, RenderQuality quality,
-  Pixels::ColorDefinition glyphColor )
+bool TrueTypeFont::isSizedByTables() const
 {
 
-#if OSDL_DEBUG_FONT
+#if OSDL_USES_SDL_TTF
 
-	LogPlug::debug( "TrueTypeFont::blitLatin1Glyph: "
-	  "rendering Latin-1 character '"
-	  + Ceylan::toString( character ) + "', whose Unicode is '"
-	  + Ceylan::toString(
-		Ceylan::UnicodeString::ConvertFromLatin1( character ) )
-	  + "'." ) ;
+#if OSDL_TTF_EXPOSES_KERNING
 
-	/*
-	std::cout << "--> " << character << " ("
-			  << Ceylan::UnicodeString::ConvertFromLatin1( character )
-			  << ")" << std::endl ;
-	*/
+  return true ;
 
-#endif // OSDL_DEBUG_FONT
+#elif OSDL_TTF_TOGGLES_KERNING
 
-  // Could be easily optimized (even though Freetype has a cache feature):
+  // Without kerning, the glyph metrics are enough:
+  return ( ::TTF_GetFontKerning( _content ) == 0 ) ;
 
-  Surface & res = renderUnicodeGlyph(
-	Ceylan::UnicodeString::ConvertFromLatin1( character ),
-	quality, glyphColor ) ;
+#else // OSDL_TTF_EXPOSES_KERNING
 
-  res.blitTo( targetSurface, x, y ) ;
+  return false ;
 
-  delete & res ;
+#endif // OSDL_TTF_EXPOSES_KERNING
+
+#else // OSDL_USES_SDL_TTF
+
+  return false ;
+
+#endif // OSDL_USES_SDL_TTF
 
 }
 
 
 
-OSDL::Video::Surface & TrueTypeFont::renderUnicodeGlyph(
-  Ceylan::Unicode character,
-  RenderQuality quality,
-  Pixels::ColorDefinition glyphColor )
+SignedLength TrueTypeFont::getKerningFor( Ceylan::Unicode previous,
+  Ceylan::Unicode glyph ) const
 {
 
-  // Two different cases, depending on a glyph cache being used or not:
-
-  if ( _cacheSettings == GlyphCached )
-  {
+#if OSDL_USES_SDL_TTF && OSDL_TTF_EXPOSES_KERNING
 
-	/*
-	 * First check that the character-quality-color combination is not already
-	 * available in cache:
-	 *
-	 * @note 'character' is in Unicode, conversion to Latin1 is somewhat
-	 * abusive...
-	 *
-	 */
-	CharColorQualityKey renderKey(
-	  static_cast<Ceylan::Latin1Char>( character ),
-	  glyphColor, quality ) ;
+  // The backend does not kern after the start of a line:
+  if ( previous == 0 || ::TTF_GetFontKerning( _content ) == 0 )
+	return 0 ;
 
-	SmartResource * res = _glyphCache->getClone( renderKey ) ;
+  if ( previous > 0xFF || glyph > 0xFF )
+	return static_cast<SignedLength>( ::TTF_GetFontKerningSizeGlyphs(
+	  _content, previous, glyph ) ) ;
 
-	if ( res != 0 )
-	{
+  // Latin-1 pairs are looked up in rows computed on first use:
+  SignedWidth * row = _kerningRows[previous] ;
 
-	  Surface * returned = dynamic_cast<Surface *>( res ) ;
+  if ( row == 0 )
+  {
 
-#if OSDL_DEBUG_FONT
+	if ( _metricsPages[0] == 0 )
+	  loadMetricsPage( 0 ) ;
 
-	  LogPlug::debug( "TrueTypeFont::renderUnicodeGlyph: cache hit, "
-		"returning clone of prerendered glyph." ) ;
+	row = new SignedWidth[256] ;
 
-	  if ( returned == 0 )
-		Ceylan::emergencyShutdown( "TrueTypeFont::renderUnicodeGlyph: "
-		  "clone is not a Surface." ) ;
+	const GlyphMetrics * metrics = _metricsPages[0] ;
 
-#endif // OSDL_DEBUG_FONT
+	for ( Ceylan::Uint16 i = 0; i < 256; i++ )
+	{
 
-	  return * returned ;
+	  // Missing glyphs would be reported as errors:
+	  if ( metrics[previous].available && metrics[i].available )
+		row[i] = static_cast<SignedWidth>( ::TTF_GetFontKerningSizeGlyphs(
+		  _content, previous, static_cast<Ceylan::Unicode>( i ) ) ) ;
+	  else
+		row[i] = 0 ;
 
 	}
 
-#if OSDL_DEBUG_FONT
+	_kerningRows[previous] = row ;
 
-	LogPlug::debug( "TrueTypeFont::renderUnicodeGlyph: "
-	  "cache miss, creating new glyph rendering for character '"
-	  + Ceylan::toString( character ) + "'." ) ;
+  }
 
-#endif // OSDL_DEBUG_FONT
+  return static_cast<SignedLength>( row[glyph] ) ;
 
-	// Here it its a cache miss, we therefore have to generate the glyph:
-	Surface & newSurface = basicRenderUnicodeGlyph( character, quality,
-	  glyphColor ) ;
+#else // OSDL_USES_SDL_TTF && OSDL_TTF_EXPOSES_KERNING
 
-	// Give the cache a chance of being fed:
-	_glyphCache->scanForAddition( renderKey, newSurface ) ;
+  return 0 ;
 
+#endif // OSDL_USES_SDL_TTF && OSDL_TTF_EXPOSES_KERNING
 
-	return newSurface ;
+}
 
-  }
 
-  /*
-   * Here we are not using a glyph cache, we have simply to generate the glyph:
-   *
-   */
-  return basicRenderUnicodeGlyph( character, quality, glyphColor ) ;
 
-}
+void TrueTypeFont::extendLineWith( Ceylan::Unicode glyph,
+  Ceylan::Unicode & previous, SignedLength & penX, SignedLength & minX,
+  SignedLength & maxX ) const
+{
 
+  const GlyphMetrics & metrics = getMetricsFor( glyph ) ;
 
+  penX += getKerningFor( previous, glyph ) ;
 
+  previous = glyph ;
 
-OSDL::Video::Surface & TrueTypeFont::renderLatin1Text(
-  const std::string & text,
-  RenderQuality quality, Pixels::ColorDefinition textColor )
+  SignedLength edge = penX + metrics.minX ;
+
+  if ( edge < minX )
+	minX = edge ;
+
+  // The advance may go beyond the right edge of the glyph (ex: for spaces):
+  edge = penX + ( ( metrics.advance > metrics.maxX ) ?
+	metrics.advance : metrics.maxX ) ;
+
+  if ( edge > maxX )
+	maxX = edge ;
+
+  penX += metrics.advance ;
+
+}
+
+
+
+
+// Bounding boxes section.
+
+
+
+UprightRectangle & TrueTypeFont::getBoundingBoxFor(
+  Ceylan::Unicode glyph, SignedLength & advance ) const
 {
 
 #if OSDL_USES_SDL_TTF
 
   if ( ! hasContent() )
-	throw FontException( "TrueTypeFont::renderLatin1Text failed: "
+	throw FontException( "TrueTypeFont::getBoundingBoxFor failed: "
 	  "font not loaded" ) ;
 
-  /*
-   * Test to compare both implementations (OSDL glyph-based versus SDL_ttf whole
-   * string):
-   *
-   *  - next line uncommented: OSDL glyph-based
-   *  - next line commented: SDL_ttf whole string
-   *
-   * Whole string (this actual method) may be preferred since rendering is maybe
-   * a bit better (maybe kerning better supported, alpha specifically managed
-   * for each quality, etc.).
-   *
-   * However both methods look most of the time the same, pixel-perfect wise.
-   *
-   * Default selected implementation (when next line not commented) is the
-   * OSDL's one:
-   *
-   */
-  return Font::renderLatin1Text( text, quality, textColor ) ;
+  const GlyphMetrics & metrics = getMetricsFor( glyph ) ;
 
+  advance = static_cast<SignedLength>( metrics.advance ) ;
 
-  /*
-   * Following SDL_ttf whole string rendering deactivated if previous line not
-   * commented:
-   *
-   */
+  return * new UprightRectangle(
+	static_cast<Coordinate>( metrics.minX ),
+	static_cast<Coordinate>( metrics.maxY ),
+	static_cast<Length>( metrics.maxX - metrics.minX ),
+	static_cast<Length>( metrics.maxY - metrics.minY ) ) ;
 
-  SDL_Surface * textSurface ;
-  Surface * res ;
+#else // OSDL_USES_SDL_TTF
 
-  switch( quality )
+  throw FontException( "TrueTypeFont::getBoundingBoxFor failed: "
+	"no SDL_ttf support available" ) ;
+
+#endif // OSDL_USES_SDL_TTF
+
+}
+
+
+
+UprightRectangle & TrueTypeFont::getBoundingBoxFor( const std::string & text )
+  const
+{
+
+#if OSDL_USES_SDL_TTF
+
+  if ( ! hasContent() )
+	throw FontException( "TrueTypeFont::getBoundingBoxFor failed: "
+	  "font not loaded" ) ;
+
+  if ( ! isSizedByTables() )
   {
 
-  case Solid:
-	textSurface = ::TTF_RenderText_Solid( _content,
-	  text.c_str(), textColor ) ;
-	if ( textSurface == 0 )
+	int width, height ;
+
+	if ( ::TTF_SizeText( _content, text.c_str(), & width, & height ) != 0 )
 	  throw FontException(
-		"TrueTypeFont::renderLatin1Text (solid): "
-		"unable to render text '" + text
-		+ "': " + DescribeLastError() ) ;
-	res = new Surface( *textSurface,
-	  /* display type */ Surface::BackBuffer ) ;
-	// No colorkey added, since already there.
-	break ;
+		"TrueTypeFont::getBoundingBoxFor (Latin-1 string): "
+		+ DescribeLastError() ) ;
 
+	return * new UprightRectangle( 0, 0, static_cast<Length>( width ),
+	  static_cast<Length>( height ) ) ;
 
-  case Shaded:
-	textSurface = ::TTF_RenderText_Shaded( _content,
-	  text.c_str(), textColor, _backgroundColor ) ;
-	if ( textSurface == 0 )
-	  throw FontException(
-		"TrueTypeFont::renderLatin1Text (shaded): "
-		"unable to render text '" + text
-		+ "': " + DescribeLastError() ) ;
+  }
 
-	/*
-	 * We have to create a new surface so that the surface returned by
-	 * '::TTF_RenderText_Shaded' will no more be palettized: we need a color key
-	 * to have transparent blits.
-	 *
-	 */
-	ColorMask redMask, greenMask, blueMask ;
-	Pixels::getRecommendedColorMasks( redMask, greenMask, blueMask ) ;
+  SignedLength penX = 0, minX = 0, maxX = 0 ;
 
-	res = new Surface( Surface::Hardware | Surface::ColorkeyBlit,
-	  textSurface->w, textSurface->h, /* bpp */ 32,
-	  redMask, greenMask, blueMask, /* no alpha wanted */ 0 ) ;
+  Ceylan::Unicode previous = 0 ;
 
-	// Avoid messing text color with color key:
-	Pixels::ColorDefinition colorKey ;
+  for ( string::const_iterator it = text.begin(); it != text.end(); it++ )
+	extendLineWith( Ceylan::UnicodeString::ConvertFromLatin1( *it ),
+	  previous, penX, minX, maxX ) ;
 
-	if ( Pixels::areEqual( textColor, Pixels::Black,
-		/* use alpha */ false ) )
-	{
-	  colorKey = Pixels::White ;
-	  res->fill( colorKey ) ;
-	}
-	else
-	{
-	  colorKey = Pixels::Black ;
-	  /*
-	   * No need to fill 'res' with black, since new RGB surfaces come all black
-	   * already.
-	   *
-	   */
-	}
+  return * new UprightRectangle( 0, 0, static_cast<Length>( maxX - minX ),
+	_fontHeight ) ;
 
-	try
-	{
-	  res->setColorKey(
-		Surface::ColorkeyBlit | Surface::RLEColorkeyBlit,
-		Pixels::convertColorDefinitionToPixelColor(
-		  res->getPixelFormat(), colorKey ) ) ;
-	}
-	catch( const Video::VideoException & e )
-	{
+#else // OSDL_USES_SDL_TTF
+
+  throw FontException( "TrueTypeFont::getBoundingBoxFor failed: "
+	"no SDL_ttf support available" ) ;
+
+#endif // OSDL_USES_SDL_TTF
+
+}
+
+
+
+UprightRectangle & TrueTypeFont::getBoundingBoxForUTF8(
+  const std::string & text ) const
+{
+
+#if OSDL_USES_SDL_TTF
+
+  if ( ! hasContent() )
+	throw FontException( "TrueTypeFont::getBoundingBoxForUTF8 failed: "
+	  "font not loaded" ) ;
+
+  if ( ! isSizedByTables() )
+  {
+
+	int width, height ;
+
+	if ( ::TTF_SizeUTF8( _content, text.c_str(), & width, & height ) != 0 )
 	  throw FontException(
-		"TrueTypeFont::renderLatin1Text (shaded): "
-		"color keying failed: " + e.toString() ) ;
-	}
-	SDL_BlitSurface( textSurface, 0, & res->getSDLSurface(), 0 ) ;
-	SDL_FreeSurface( textSurface ) ;
-	textSurface = 0 ;
-	break ;
+		"TrueTypeFont::getBoundingBoxFor (UTF-8 string): "
+		+ DescribeLastError() ) ;
 
+	return * new UprightRectangle( 0, 0, static_cast<Length>( width ),
+	  static_cast<Length>( height ) ) ;
 
-  case Blended:
-	textSurface = ::TTF_RenderText_Blended( _content,
-	  text.c_str(), textColor ) ;
-	if ( textSurface == 0 )
+  }
+
+  SignedLength penX = 0, minX = 0, maxX = 0 ;
+
+  Ceylan::Unicode previous = 0 ;
+
+  string::size_type index = 0 ;
+
+  while ( index < text.size() )
+	extendLineWith( decodeUTF8( text, index ), previous, penX, minX, maxX ) ;
+
+  return * new UprightRectangle( 0, 0, static_cast<Length>( maxX - minX ),
+	_fontHeight ) ;
+
+#else // OSDL_USES_SDL_TTF
+
+  throw FontException( "TrueTypeFont::getBoundingBoxForUTF8 failed: "
+	"no SDL_ttf support available" ) ;
+
+#endif // OSDL_USES_SDL_TTF
+
+}
+
+
+
+UprightRectangle & TrueTypeFont::getBoundingBoxForUnicode(
+  const Ceylan::Unicode * text ) const
+{
+
+#if OSDL_USES_SDL_TTF
+
+  if ( ! hasContent() )
+	throw FontException( "TrueTypeFont::getBoundingBoxForUnicode failed: "
+	  "font not loaded" ) ;
+
+  if ( text == 0 )
+	throw FontException( "TrueTypeFont::getBoundingBoxForUnicode: "
+	  "null pointer for Unicode string." ) ;
+
+  if ( ! isSizedByTables() )
+  {
+
+	int width, height ;
+
+	if ( ::TTF_SizeUNICODE( _content, text, & width, & height ) != 0 )
 	  throw FontException(
-		"TrueTypeFont::renderLatin1Text (blended): "
-		"unable to render text '" + text
-		+ "': " + DescribeLastError() ) ;
+		"TrueTypeFont::getBoundingBoxFor (Unicode string): "
+		+ DescribeLastError() ) ;
 
-	res = new Surface( * textSurface,
-	  /* display type */ Surface::BackBuffer ) ;
+	return * new UprightRectangle( 0, 0, static_cast<Length>( width ),
+	  static_cast<Length>( height ) ) ;
 
-	// Not defined by default:
-#ifdef OSDL_ADDS_COLOR_KEY
+  }
 
-	/*
-	 * Alpha should be preserved since the blending is the point of this
-	 * quality, but adding a color key should not harm:
-	 *
-	 */
+  SignedLength penX = 0, minX = 0, maxX = 0 ;
 
-	// Avoid messing text color with color key:
-	Pixels::ColorDefinition colorKey ;
+  Ceylan::Unicode previous = 0 ;
 
-	if ( Pixels::areEqual( textColor, Pixels::Black,
-		/* use alpha */ false ) )
+  // Byte order marks are interpreted as the backend does:
+  bool swapped = false ;
+
+  for ( const Ceylan::Unicode * current = text; *current != 0; current++ )
+  {
+
+	Ceylan::Unicode glyph = *current ;
+
+	if ( glyph == 0xFEFF )
 	{
-	  colorKey = Pixels::White ;
-	  res->fill( colorKey ) ;
+	  swapped = false ;
+	  continue ;
 	}
-	else
-	{
-	  colorKey = Pixels::Black ;
 
-	  /*
-	   * No need to fill 'res' with black, since new RGB surfaces come all black
-	   * already.
-	   *
-	   */
+	if ( glyph == 0xFFFE )
+	{
+	  swapped = true ;
+	  continue ;
 	}
 
-	try
-	{
-	  res->setColorKey(
-		Surface::ColorkeyBlit | Surface::RLEColorkeyBlit,
-		Pixels::convertColorDefinitionToPixelColor(
-		  res->getPixelFormat(), colorKey ) ) ;
+	if ( swapped )
+	  glyph = static_cast<Ceylan::Unicode>( ( glyph << 8 ) | ( glyph >> 8 ) ) ;
+
+	extendLineWith( glyph, previous, penX, minX, maxX ) ;
+
+  }
+
+  return * new UprightRectangle( 0, 0, static_cast<Length>( maxX - minX ),
+	_fontHeight ) ;
+
+#else // OSDL_USES_SDL_TTF
+
+  throw FontException( "TrueTypeFont::getBoundingBoxForUnicode failed: "
+	"no SDL_ttf support available" ) ;
+
+#endif // OSDL_USES_SDL_TTF
+
+}
+
+
+
+
+// Render section.
+
+
+
+OSDL::Video::Surface & TrueTypeFont::renderLatin1Glyph(
+  Ceylan::Latin1Char character,
+  RenderQuality quality,
+  Pixels::ColorDefinition glyphColor )
+{
+
+  return renderUnicodeGlyph(
+	Ceylan::UnicodeString::ConvertFromLatin1( character ),
+	quality, glyphColor ) ;
+
+}
+
+
+
+void TrueTypeFont::blitLatin1Glyph(
+  Surface & targetSurface, Coordinate x, Coordinate y,
+  Ceylan::Latin1Char character, RenderQuality quality,
+  Pixels::ColorDefinition glyphColor )
+{
+
+#if OSDL_DEBUG_FONT
+
+	LogPlug::debug( "TrueTypeFont::blitLatin1Glyph: "
+	  "rendering Latin-1 character '"
+	  + Ceylan::toString( character ) + "', whose Unicode is '"
+	  + Ceylan::toString(
+		Ceylan::UnicodeString::ConvertFromLatin1( character ) )
+	  + "'." ) ;
+
+	/*
+	std::cout << "--> " << character << " ("
+			  << Ceylan::UnicodeString::ConvertFromLatin1( character )
+			  << ")" << std::endl ;
+	*/
+
+#endif // OSDL_DEBUG_FONT
+
+  // Could be easily optimized (even though Freetype has a cache feature):
+
+  Surface & res = renderUnicodeGlyph(
+	Ceylan::UnicodeString::ConvertFromLatin1( character ),
+	quality, glyphColor ) ;
+
+  res.blitTo( targetSurface, x, y ) ;
+
+  delete & res ;
+
+}
+
+
+
+OSDL::Video::Surface & TrueTypeFont::renderUnicodeGlyph(
+  Ceylan::Unicode character,
+  RenderQuality quality,
+  Pixels::ColorDefinition glyphColor )
+{
+
+  // Two different cases, depending on a glyph cache being used or not:
+
+  if ( _cacheSettings == GlyphCached )
+  {
+
+	/*
+	 * First check that the character-quality-color combination is not already
+	 * available in cache:
+	 *
+	 * @note 'character' is in Unicode, conversion to Latin1 is somewhat
+	 * abusive...
+	 *
+	 */
+	CharColorQualityKey renderKey(
+	  static_cast<Ceylan::Latin1Char>( character ),
+	  glyphColor, quality ) ;
+
+	SmartResource * res = _glyphCache->getClone( renderKey ) ;
+
+	if ( res != 0 )
+	{
+
+	  Surface * returned = dynamic_cast<Surface *>( res ) ;
+
+#if OSDL_DEBUG_FONT
+
+	  LogPlug::debug( "TrueTypeFont::renderUnicodeGlyph: cache hit, "
+		"returning clone of prerendered glyph." ) ;
+
+	  if ( returned == 0 )
+		Ceylan::emergencyShutdown( "TrueTypeFont::renderUnicodeGlyph: "
+		  "clone is not a Surface." ) ;
+
+#endif // OSDL_DEBUG_FONT
+
+	  return * returned ;
+
+	}
+
+#if OSDL_DEBUG_FONT
+
+	LogPlug::debug( "TrueTypeFont::renderUnicodeGlyph: "
+	  "cache miss, creating new glyph rendering for character '"
+	  + Ceylan::toString( character ) + "'." ) ;
+
+#endif // OSDL_DEBUG_FONT
+
+	// Here it its a cache miss, we therefore have to generate the glyph:
+	Surface & newSurface = basicRenderUnicodeGlyph( character, quality,
+	  glyphColor ) ;
+
+	// Give the cache a chance of being fed:
+	_glyphCache->scanForAddition( renderKey, newSurface ) ;
+
+
+	return newSurface ;
+
+  }
+
+  /*
+   * Here we are not using a glyph cache, we have simply to generate the glyph:
+   *
+   */
+  return basicRenderUnicodeGlyph( character, quality, glyphColor ) ;
+
+}
+
+
+
+
+OSDL::Video::Surface & TrueTypeFont::renderLatin1Text(
+  const std::string & text,
+  RenderQuality quality, Pixels::ColorDefinition textColor )
+{
+
+#if OSDL_USES_SDL_TTF
+
+  if ( ! hasContent() )
+	throw FontException( "TrueTypeFont::renderLatin1Text failed: "
+	  "font not loaded" ) ;
+
+  /*
+   * Test to compare both implementations (OSDL glyph-based versus SDL_ttf whole
+   * string):
+   *
+   *  - next line uncommented: OSDL glyph-based
+   *  - next line commented: SDL_ttf whole string
+   *
+   * Whole string (this actual method) may be preferred since rendering is maybe
+   * a bit better (maybe kerning better supported, alpha specifically managed
+   * for each quality, etc.).
+   *
+   * However both methods look most of the time the same, pixel-perfect wise.
+   *
+   * Default selected implementation (when next line not commented) is the
+   * OSDL's one:
+   *
+   */
+  return Font::renderLatin1Text( text, quality, textColor ) ;
+
+
+  /*
+   * Following SDL_ttf whole string rendering deactivated if previous line not
+   * commented:
+   *
+   */
+
+  SDL_Surface * textSurface ;
+  Surface * res ;
+
+  switch( quality )
+  {
+
+  case Solid:
+	textSurface = ::TTF_RenderText_Solid( _content,
+	  text.c_str(), textColor ) ;
+	if ( textSurface == 0 )
+	  throw FontException(
+		"TrueTypeFont::renderLatin1Text (solid): "
+		"unable to render text '" + text
+		+ "': " + DescribeLastError() ) ;
+	res = new Surface( *textSurface,
+	  /* display type */ Surface::BackBuffer ) ;
+	// No colorkey added, since already there.
+	break ;
+
+
+  case Shaded:
+	textSurface = ::TTF_RenderText_Shaded( _content,
+	  text.c_str(), textColor, _backgroundColor ) ;
+	if ( textSurface == 0 )
+	  throw FontException(
+		"TrueTypeFont::renderLatin1Text (shaded): "
+		"unable to render text '" + text
+		+ "': " + DescribeLastError() ) ;
+
+	/*
+	 * We have to create a new surface so that the surface returned by
+	 * '::TTF_RenderText_Shaded' will no more be palettized: we need a color key
+	 * to have transparent blits.
+	 *
+	 */
+	ColorMask redMask, greenMask, blueMask ;
+	Pixels::getRecommendedColorMasks( redMask, greenMask, blueMask ) ;
+
+	res = new Surface( Surface::Hardware | Surface::ColorkeyBlit,
+	  textSurface->w, textSurface->h, /* bpp */ 32,
+	  redMask, greenMask, blueMask, /* no alpha wanted */ 0 ) ;
+
+	// Avoid messing text color with color key:
+	Pixels::ColorDefinition colorKey ;
+
+	if ( Pixels::areEqual( textColor, Pixels::Black,
+		/* use alpha */ false ) )
+	{
+	  colorKey = Pixels::White ;
+	  res->fill( colorKey ) ;
+	}
+	else
+	{
+	  colorKey = Pixels::Black ;
+	  /*
+	   * No need to fill 'res' with black, since new RGB surfaces come all black
+	   * already.
+	   *
+	   */
+	}
+
+	try
+	{
+	  res->setColorKey(
+		Surface::ColorkeyBlit | Surface::RLEColorkeyBlit,
+		Pixels::convertColorDefinitionToPixelColor(
+		  res->getPixelFormat(), colorKey ) ) ;
+	}
+	catch( const Video::VideoException & e )
+	{
+	  throw FontException(
+		"TrueTypeFont::renderLatin1Text (shaded): "
+		"color keying failed: " + e.toString() ) ;
+	}
+	SDL_BlitSurface( textSurface, 0, & res->getSDLSurface(), 0 ) ;
+	SDL_FreeSurface( textSurface ) ;
+	textSurface = 0 ;
+	break ;
+
+
+  case Blended:
+	textSurface = ::TTF_RenderText_Blended( _content,
+	  text.c_str(), textColor ) ;
+	if ( textSurface == 0 )
+	  throw FontException(
+		"TrueTypeFont::renderLatin1Text (blended): "
+		"unable to render text '" + text
+		+ "': " + DescribeLastError() ) ;
+
+	res = new Surface( * textSurface,
+	  /* display type */ Surface::BackBuffer ) ;
+
+	// Not defined by default:
+#ifdef OSDL_ADDS_COLOR_KEY
+
+	/*
+	 * Alpha should be preserved since the blending is the point of this
+	 * quality, but adding a color key should not harm:
+	 *
+	 */
+
+	// Avoid messing text color with color key:
+	Pixels::ColorDefinition colorKey ;
+
+	if ( Pixels::areEqual( textColor, Pixels::Black,
+		/* use alpha */ false ) )
+	{
+	  colorKey = Pixels::White ;
+	  res->fill( colorKey ) ;
+	}
+	else
+	{
+	  colorKey = Pixels::Black ;
+
+	  /*
+	   * No need to fill 'res' with black, since new RGB surfaces come all black
+	   * already.
+	   *
+	   */
+	}
+
+	try
+	{
+	  res->setColorKey(
+		Surface::ColorkeyBlit | Surface::RLEColorkeyBlit,
+		Pixels::convertColorDefinitionToPixelColor(
+		  res->getPixelFormat(), colorKey ) ) ;
+	}
+	catch( const Video::VideoException & e )
+	{
+	  throw FontException(
+		"TrueTypeFont::renderLatin1Text (blended): "
+		"color keying failed: " + e.toString() ) ;
+	}
+
+#endif // OSDL_ADDS_COLOR_KEY
+
+	break ;
+
+
+  default:
+	throw FontException( "TrueTypeFont::renderLatin1Text: "
+	  "unknown quality requested: "
+	  + Ceylan::toString( quality ) + "." ) ;
+	break ;
+
+  }
+
+
+  if ( _convertToDisplay )
+  {
+
+	/*
+	 * We want to keep our colorkey (if any), so we choose to add alpha only if
+	 * no colorkey is used.
+	 *
+	 * Surface will be RLE encoded here:
+	 *
+	 */
+	if ( quality == Blended )
+	  res->convertToDisplay( /* alphaChannelWanted */ true ) ;
+	else
+	  res->convertToDisplay( /* alphaChannelWanted */ false ) ;
+
+  }
+
+  return * res ;
+
+#else // OSDL_USES_SDL_TTF
+
+  throw FontException( "TrueTypeFont::renderLatin1Text failed: "
+	"no SDL_ttf support available" ) ;
+
+#endif // OSDL_USES_SDL_TTF
+
+}
+
+
+
+OSDL::Video::Surface & TrueTypeFont::renderUTF8Text(
+  const std::string & text,
+  RenderQuality quality,
+  Pixels::ColorDefinition textColor )
+{
+
+#if OSDL_USES_SDL_TTF
+
+  if ( ! hasContent() )
+	throw FontException( "TrueTypeFont::renderUTF8Text failed: "
+	  "font not loaded" ) ;
+
+  SDL_Surface * textSurface ;
+  Surface * res ;
+
+  switch( quality )
+  {
+
+
+  case Solid:
+	textSurface = ::TTF_RenderUTF8_Solid( _content, text.c_str(),
+	  textColor ) ;
+
+	if ( textSurface == 0 )
+	  throw FontException( "TrueTypeFont::renderUTF8Text (solid): "
+		"unable to render text '" + text
+		+ "': " + DescribeLastError() ) ;
+
+	res = new Surface( * textSurface,
+	  /* display type */ Surface::BackBuffer ) ;
+	break ;
+
+
+  case Shaded:
+	textSurface = ::TTF_RenderUTF8_Shaded( _content, text.c_str(),
+	  textColor, _backgroundColor ) ;
+
+	if ( textSurface == 0 )
+	  throw FontException( "TrueTypeFont::renderUTF8Text (shaded): "
+		"unable to render text '" + text
+		+ "': " + DescribeLastError() ) ;
+
+	/*
+	 * We have to create a new surface so that the surface returned by
+	 * '::TTF_RenderUTF8_Shaded' will no more be palettized: we need a color key
+	 * to have transparent blits.
+	 *
+	 */
+	ColorMask redMask, greenMask, blueMask ;
+	Pixels::getRecommendedColorMasks( redMask, greenMask, blueMask ) ;
+
+	res = new Surface( Surface::Hardware | Surface::ColorkeyBlit,
+	  textSurface->w, textSurface->h, 32,
+	  redMask, greenMask, blueMask, /* no alpha wanted */ 0 ) ;
+
+	// Avoid messing text color with color key:
+	Pixels::ColorDefinition colorKey ;
+
+	if ( Pixels::areEqual( textColor, Pixels::Black,
+		/* use alpha */ false ) )
+	{
+
+	  colorKey = Pixels::White ;
+	  res->fill( colorKey ) ;
+
+	}
+	else
+	{
+
+	  colorKey = Pixels::Black ;
+	  /*
+	   * No need to fill 'res' with black, since new RGB surfaces come all black
+	   * already.
+	   *
+	   */
+
+	}
+
+	try
+	{
+
+	  res->setColorKey(
+		Surface::ColorkeyBlit | Surface::RLEColorkeyBlit,
+		Pixels::convertColorDefinitionToPixelColor(
+		  res->getPixelFormat(), colorKey ) ) ;
+
+	}
+	catch( const Video::VideoException & e )
+	{
+	  throw FontException( "TrueTypeFont::renderUTF8Text (shaded): "
+		"color keying failed: " + e.toString() ) ;
+	}
+
+	SDL_BlitSurface( textSurface, 0, & res->getSDLSurface(), 0 ) ;
+	SDL_FreeSurface( textSurface ) ;
+	textSurface = 0 ;
+	break ;
+
+
+  case Blended:
+	textSurface = ::TTF_RenderUTF8_Blended( _content, text.c_str(),
+	  textColor ) ;
+
+	if ( textSurface == 0 )
+	  throw FontException(
+		"TrueTypeFont::renderUTF8Text (blended): "
+		"unable to render text '" + text
+		+ "': " + DescribeLastError() ) ;
+
+	res = new Surface( * textSurface,
+	  /* display type */ Surface::BackBuffer ) ;
+
+
+	// Not defined by default:
+#ifdef OSDL_ADDS_COLOR_KEY
+
+	/*
+	 * Alpha should be preserved since the blending is the point of this
+	 * quality, but adding a color key should not harm:
+	 *
+	 */
+
+	// Avoid messing text color with color key:
+	Pixels::ColorDefinition colorKey ;
+
+	if ( Pixels::areEqual( textColor, Pixels::Black,
+		/* use alpha */ false ) )
+	{
+
+	  colorKey = Pixels::White ;
+	  res->fill( colorKey ) ;
+
+	}
+	else
+	{
+
+	  colorKey = Pixels::Black ;
+	  /*
+	   * No need to fill 'res' with black, since new RGB surfaces come all black
+	   * already.
+	   *
+	   */
+	}
+
+	try
+	{
+	  res->setColorKey(
+		Surface::ColorkeyBlit | Surface::RLEColorkeyBlit,
+		Pixels::convertColorDefinitionToPixelColor(
+		  res->getPixelFormat(), colorKey ) ) ;
+	}
+	catch( const Video::VideoException & e )
+	{
+
+	  throw FontException( "TrueTypeFont::renderUTF8Text (blended): "
+		"color keying failed: " + e.toString() ) ;
+
+	}
+
+#endif // OSDL_ADDS_COLOR_KEY
+
+	break ;
+
+
+  default:
+	throw FontException( "TrueTypeFont::renderUTF8Text: "
+	  "unknown quality requested: "
+	  + Ceylan::toString( quality ) + "." ) ;
+	break ;
+
+  }
+
+
+  if ( _convertToDisplay )
+  {
+
+	/*
+	 * We want to keep our colorkey (if any), so we choose to add alpha only if
+	 * no colorkey is used.
+	 *
+	 * Surface will be RLE encoded here:
+	 *
+	 */
+	if ( quality == Blended )
+	  res->convertToDisplay( /* alphaChannelWanted */ true ) ;
+	else
+	  res->convertToDisplay( /* alphaChannelWanted */ false ) ;
+
+  }
+
+  return * res ;
+
+#else // OSDL_USES_SDL_TTF
+
+  throw FontException( "TrueTypeFont::renderUTF8Text failed: "
+	"no SDL_ttf support available" ) ;
+
+#endif // OSDL_USES_SDL_TTF
+
+}
+
+
+
+OSDL::Video::Surface & TrueTypeFont::renderUnicodeText(
+  const Ceylan::Unicode * text,
+  RenderQuality quality,
+  Pixels::ColorDefinition textColor )
+{
+
+#if OSDL_USES_SDL_TTF
+
+  if ( ! hasContent() )
+	throw FontException( "TrueTypeFont::renderUnicodeText failed: "
+	  "font not loaded" ) ;
+
+  if ( text == 0 )
+	throw FontException(
+	  "TrueTypeFont::renderUnicode: null pointer for Unicode string." ) ;
+
+  SDL_Surface * textSurface ;
+  Surface * res ;
+
+  switch( quality )
+  {
+
+  case Solid:
+	textSurface = ::TTF_RenderUNICODE_Solid( _content, text,
+	  textColor ) ;
+
+	if ( textSurface == 0 )
+	  throw FontException(
+		"TrueTypeFont::renderUnicodeText (solid): "
+		"unable to render text: " + DescribeLastError() ) ;
+	res = new Surface( * textSurface,
+	  /* display type */ Surface::BackBuffer ) ;
+	break ;
+
+
+  case Shaded:
+	textSurface = ::TTF_RenderUNICODE_Shaded( _content, text,
+	  textColor, _backgroundColor ) ;
+
+	if ( textSurface == 0 )
+	  throw FontException(
+		"TrueTypeFont::renderUnicodeText (shaded): "
+		"unable to render text: " + DescribeLastError() ) ;
+
+	/*
+	 * We have to create a new surface so that the surface returned by
+	 * '::TTF_RenderUNICODE_Shaded' will no more be palettized: we need a color
+	 * key to have transparent blits.
+	 *
+	 */
+	ColorMask redMask, greenMask, blueMask ;
+	Pixels::getRecommendedColorMasks( redMask, greenMask, blueMask ) ;
+
+	res = new Surface( Surface::Hardware | Surface::ColorkeyBlit,
+	  textSurface->w, textSurface->h, 32,
+	  redMask, greenMask, blueMask, /* no alpha wanted */ 0 ) ;
+
+	// Avoid messing text color with color key:
+	Pixels::ColorDefinition colorKey ;
+
+	if ( Pixels::areEqual( textColor, Pixels::Black,
+		/* use alpha */ false ) )
+	{
+
+	  colorKey = Pixels::White ;
+	  res->fill( colorKey ) ;
+
+	}
+	else
+	{
+
+	  colorKey = Pixels::Black ;
+
+	  /*
+	   * No need to fill 'res' with black, since new RGB surfaces come all black
+	   * already.
+	   *
+	   */
+	}
+
+	try
+	{
+	  res->setColorKey(
+		Surface::ColorkeyBlit | Surface::RLEColorkeyBlit,
+		Pixels::convertColorDefinitionToPixelColor(
+		  res->getPixelFormat(), colorKey ) ) ;
+	}
+	catch( const Video::VideoException & e )
+	{
+	  throw FontException(
+		"TrueTypeFont::renderUnicodeText (shaded): "
+		"color keying failed: " + e.toString() ) ;
+	}
+	SDL_BlitSurface( textSurface, 0, & res->getSDLSurface(), 0 ) ;
+	SDL_FreeSurface( textSurface ) ;
+	textSurface = 0 ;
+	break ;
+
+
+  case Blended:
+	textSurface = ::TTF_RenderUNICODE_Blended( _content, text,
+	  textColor ) ;
+
+	if ( textSurface == 0 )
+	  throw FontException(
+		"TrueTypeFont::renderUnicodeText (blended): "
+		"unable to render text: " + DescribeLastError() ) ;
+
+	res = new Surface( * textSurface,
+	  /* display type */ Surface::BackBuffer ) ;
+
+
+	// Not defined by default:
+#ifdef OSDL_ADDS_COLOR_KEY
+
+	/*
+	 * Alpha should be preserved since the blending is the point of this
+	 * quality, but adding a color key should not harm:
+	 *
+	 */
+
+	// Avoid messing text color with color key:
+	Pixels::ColorDefinition colorKey ;
+
+	if ( Pixels::areEqual( textColor, Pixels::Black,
+		/* use alpha */ false ) )
+	{
+
+	  colorKey = Pixels::White ;
+	  res->fill( colorKey ) ;
+
+	}
+	else
+	{
+
+	  colorKey = Pixels::Black ;
+
+	  /*
+	   * No need to fill 'res' with black, since new RGB surfaces come all black
+	   * already.
+	   *
+	   */
+	}
+
+
+	/*
+	 * Alpha should be preserved since the blending is the point of this
+	 * quality, but adding a color key should not harm:
+	 *
+	 */
+	try
+	{
+
+	  res->setColorKey(
+		Surface::ColorkeyBlit | Surface::RLEColorkeyBlit,
+		Pixels::convertColorDefinitionToPixelColor(
+		  res->getPixelFormat(), colorKey ) ) ;
+
+	}
+	catch( const Video::VideoException & e )
+	{
+	  throw FontException(
+		"TrueTypeFont::renderUnicodeText (blended): "
+		"color keying failed: " + e.toString() ) ;
+	}
+
+#endif // OSDL_ADDS_COLOR_KEY
+
+	break ;
+
+
+  default:
+	throw FontException( "TrueTypeFont::renderUnicodeText: "
+	  "unknown quality requested: "
+	  + Ceylan::toString( quality ) + "." ) ;
+	break ;
+
+  }
+
+
+  if ( _convertToDisplay )
+  {
+
+	/*
+	 * We want to keep our colorkey (if any), so we choose to add alpha only if
+	 *  no colorkey is used.
+	 *
+	 * Surface will be RLE encoded here:
+	 *
+	 */
+	if ( quality == Blended )
+	  res->convertToDisplay( /* alphaChannelWanted */ true ) ;
+	else
+	  res->convertToDisplay( /* alphaChannelWanted */ false ) ;
+
+  }
+
+  return * res ;
+
+#else // OSDL_USES_SDL_TTF
+
+  throw FontException( "TrueTypeFont::renderUnicodeText failed: "
+	"no SDL_ttf support available" ) ;
+
+#endif // OSDL_USES_SDL_TTF
+
+}
+
+
+
+
+// Distance field section.
+
+
+
+#if OSDL_USES_SDL_TTF
+
+
+/**
+ * Describes the signed distance field of a glyph, as generated at the
+ * reference point size.
+ *
+ * The field is padded with DistanceFieldSpread texels on each side of the ink
+ * box of the glyph, whose upper-left corner is located at (offsetX, offsetY)
+ * in the referential of the pen, the ordinate axis pointing upward from the
+ * baseline.
+ *
+ */
+struct TrueTypeFont::DistanceFieldGlyph
+{
+
+  /// The dimensions of the ink box of the glyph, at the reference size.
+  Length inkWidth ;
+  Length inkHeight ;
+
+  /// The dimensions of the whole field, padding included.
+  Length width ;
+  Length height ;
+
+  /// The width offset of the glyph, at the reference size.
+  SignedLength offsetX ;
+
+  /// The height above baseline of the glyph, at the reference size.
+  SignedLength offsetY ;
+
+  /// The advance of the glyph, at the reference size.
+  SignedLength advance ;
+
+  /**
+   * The encoded distances, row after row, 128 corresponding to the outline
+   * (null if the glyph has no ink, like the space).
+   *
+   */
+  Ceylan::Uint8 * values ;
+
+} ;
+
+
+
+// Marks a texel whose nearest seed is not known yet:
+const Ceylan::Sint32 NoSeedOffset = 9999 ;
+
+
+
+static inline Ceylan::Sint32 squaredNorm( Ceylan::Sint32 x, Ceylan::Sint32 y )
+{
+
+  return x * x + y * y ;
+
+}
+
+
+
+/*
+ * Helper for the distance transform: updates the offset to the nearest seed of
+ * the (x,y) texel, should its neighbour at (x+stepX,y+stepY) know a nearer one.
+ *
+ * Offsets are stored as (x,y) pairs, row after row.
+ *
+ */
+static inline void compareWithNeighbour( Ceylan::Sint32 * offsets,
+  Ceylan::Sint32 width, Ceylan::Sint32 height, Ceylan::Sint32 x,
+  Ceylan::Sint32 y, Ceylan::Sint32 stepX, Ceylan::Sint32 stepY )
+{
+
+  Ceylan::Sint32 neighbourX = x + stepX ;
+  Ceylan::Sint32 neighbourY = y + stepY ;
+
+  if ( neighbourX < 0 || neighbourY < 0 || neighbourX >= width
+	  || neighbourY >= height )
+	return ;
+
+  const Ceylan::Sint32 * neighbour =
+	offsets + 2 * ( neighbourY * width + neighbourX ) ;
+
+  Ceylan::Sint32 candidateX = neighbour[0] + stepX ;
+  Ceylan::Sint32 candidateY = neighbour[1] + stepY ;
+
+  Ceylan::Sint32 * current = offsets + 2 * ( y * width + x ) ;
+
+  if ( squaredNorm( candidateX, candidateY )
+	  < squaredNorm( current[0], current[1] ) )
+  {
+
+	current[0] = candidateX ;
+	current[1] = candidateY ;
+
+  }
+
+}
+
+
+
+/*
+ * Computes, for each texel, the offset to its nearest seed (a texel whose
+ * offset is initially null), thanks to the two passes of the 8-points
+ * sequential Euclidean distance transform (8SSEDT).
+ *
+ */
+static void propagateDistances( Ceylan::Sint32 * offsets,
+  Ceylan::Sint32 width, Ceylan::Sint32 height )
+{
+
+  // Forward pass:
+  for ( Ceylan::Sint32 y = 0; y < height; y++ )
+  {
+
+	for ( Ceylan::Sint32 x = 0; x < width; x++ )
+	{
+
+	  compareWithNeighbour( offsets, width, height, x, y, -1,  0 ) ;
+	  compareWithNeighbour( offsets, width, height, x, y,  0, -1 ) ;
+	  compareWithNeighbour( offsets, width, height, x, y, -1, -1 ) ;
+	  compareWithNeighbour( offsets, width, height, x, y,  1, -1 ) ;
+
+	}
+
+	for ( Ceylan::Sint32 x = width - 1; x >= 0; x-- )
+	  compareWithNeighbour( offsets, width, height, x, y, 1, 0 ) ;
+
+  }
+
+  // Backward pass:
+  for ( Ceylan::Sint32 y = height - 1; y >= 0; y-- )
+  {
+
+	for ( Ceylan::Sint32 x = width - 1; x >= 0; x-- )
+	{
+
+	  compareWithNeighbour( offsets, width, height, x, y,  1, 0 ) ;
+	  compareWithNeighbour( offsets, width, height, x, y,  0, 1 ) ;
+	  compareWithNeighbour( offsets, width, height, x, y, -1, 1 ) ;
+	  compareWithNeighbour( offsets, width, height, x, y,  1, 1 ) ;
+
+	}
+
+	for ( Ceylan::Sint32 x = 0; x < width; x++ )
+	  compareWithNeighbour( offsets, width, height, x, y, -1, 0 ) ;
+
+  }
+
+}
+
+
+
+/*
+ * The software sampling kernel of the distance field mode: bilinearly samples
+ * the specified field, scaled by the specified factor and whose upper-left
+ * corner is at (originX,originY) in the coverage buffer, and converts the
+ * distances into coverage values (the outline lying at 128, with a one-pixel
+ * wide antialiasing ramp whatever the scale).
+ *
+ * Coverage values are merged with the ones already in the buffer (keeping the
+ * highest), so that overlapping glyphs can be sampled in turn. Pixels out of
+ * the buffer are clipped.
+ *
+ */
+static void sampleDistanceField( const Ceylan::Uint8 * values,
+  Length fieldWidth, Length fieldHeight, Ceylan::Float32 scale,
+  Ceylan::Float32 spread, Ceylan::Float32 originX, Ceylan::Float32 originY,
+  Ceylan::Uint8 * coverage, Length coverageWidth, Length coverageHeight )
+{
+
+  if ( values == 0 || fieldWidth == 0 || fieldHeight == 0 )
+	return ;
+
+  // Converts an encoded distance difference into target pixels:
+  const Ceylan::Float32 edgeFactor = spread * scale / 127.0f ;
+
+  Ceylan::Sint32 firstX = Ceylan::Maths::Max<Ceylan::Sint32>( 0,
+	static_cast<Ceylan::Sint32>( Ceylan::Maths::Floor( originX ) ) ) ;
+
+  Ceylan::Sint32 lastX = Ceylan::Maths::Min<Ceylan::Sint32>(
+	coverageWidth - 1, static_cast<Ceylan::Sint32>(
+	  Ceylan::Maths::Ceil( originX + fieldWidth * scale ) ) ) ;
+
+  Ceylan::Sint32 firstY = Ceylan::Maths::Max<Ceylan::Sint32>( 0,
+	static_cast<Ceylan::Sint32>( Ceylan::Maths::Floor( originY ) ) ) ;
+
+  Ceylan::Sint32 lastY = Ceylan::Maths::Min<Ceylan::Sint32>(
+	coverageHeight - 1, static_cast<Ceylan::Sint32>(
+	  Ceylan::Maths::Ceil( originY + fieldHeight * scale ) ) ) ;
+
+  const Ceylan::Sint32 maxFieldX = fieldWidth - 1 ;
+  const Ceylan::Sint32 maxFieldY = fieldHeight - 1 ;
+
+  for ( Ceylan::Sint32 y = firstY; y <= lastY; y++ )
+  {
+
+	// Texel centers are at half-integer coordinates:
+	Ceylan::Float32 sourceY = ( y + 0.5f - originY ) / scale - 0.5f ;
+
+	if ( sourceY < 0 )
+	  sourceY = 0 ;
+	else if ( sourceY > maxFieldY )
+	  sourceY = static_cast<Ceylan::Float32>( maxFieldY ) ;
+
+	Ceylan::Sint32 topY = static_cast<Ceylan::Sint32>( sourceY ) ;
+	Ceylan::Sint32 bottomY = Ceylan::Maths::Min<Ceylan::Sint32>( topY + 1,
+	  maxFieldY ) ;
+	Ceylan::Float32 weightY = sourceY - topY ;
+
+	const Ceylan::Uint8 * topRow = values + topY * fieldWidth ;
+	const Ceylan::Uint8 * bottomRow = values + bottomY * fieldWidth ;
+
+	Ceylan::Uint8 * target = coverage + y * coverageWidth ;
+
+	for ( Ceylan::Sint32 x = firstX; x <= lastX; x++ )
+	{
+
+	  Ceylan::Float32 sourceX = ( x + 0.5f - originX ) / scale - 0.5f ;
+
+	  if ( sourceX < 0 )
+		sourceX = 0 ;
+	  else if ( sourceX > maxFieldX )
+		sourceX = static_cast<Ceylan::Float32>( maxFieldX ) ;
+
+	  Ceylan::Sint32 leftX = static_cast<Ceylan::Sint32>( sourceX ) ;
+	  Ceylan::Sint32 rightX = Ceylan::Maths::Min<Ceylan::Sint32>( leftX + 1,
+		maxFieldX ) ;
+	  Ceylan::Float32 weightX = sourceX - leftX ;
+
+	  Ceylan::Float32 top = topRow[leftX]
+		+ ( topRow[rightX] - topRow[leftX] ) * weightX ;
+
+	  Ceylan::Float32 bottom = bottomRow[leftX]
+		+ ( bottomRow[rightX] - bottomRow[leftX] ) * weightX ;
+
+	  Ceylan::Float32 distance = top + ( bottom - top ) * weightY ;
+
+	  Ceylan::Float32 alpha = 0.5f + ( distance - 128.0f ) * edgeFactor ;
+
+	  if ( alpha <= 0 )
+		continue ;
+
+	  Ceylan::Uint8 value = ( alpha >= 1 ) ? 255 :
+		static_cast<Ceylan::Uint8>( alpha * 255.0f + 0.5f ) ;
+
+	  if ( value > target[x] )
+		target[x] = value ;
+
+	}
+
+  }
+
+}
+
+
+
+/*
+ * Returns a newly allocated 32-bit surface with an alpha channel, whose pixels
+ * are of the specified color, their alpha coming from the specified coverage
+ * buffer.
+ *
+ */
+static OSDL::Video::Surface & createSurfaceFromCoverage(
+  const Ceylan::Uint8 * coverage, Length width, Length height,
+  Pixels::ColorDefinition color )
+{
+
+  ColorMask redMask, greenMask, blueMask, alphaMask ;
+  Pixels::getRecommendedColorMasks( redMask, greenMask, blueMask,
+	alphaMask ) ;
+
+  Surface * res = new Surface(
+	Surface::Software | Surface::AlphaBlendingBlit, width, height,
+	/* bpp */ 32, redMask, greenMask, blueMask, alphaMask ) ;
+
+  res->lock() ;
+
+  Ceylan::Uint8 * pixels = static_cast<Ceylan::Uint8 *>( res->getPixels() ) ;
+  Pitch pitch = res->getPitch() ;
+
+  const Pixels::PixelFormat & format = res->getPixelFormat() ;
+
+  for ( Length y = 0; y < height; y++ )
+  {
+
+	Pixels::PixelColor * row =
+	  reinterpret_cast<Pixels::PixelColor *>( pixels + y * pitch ) ;
+
+	const Ceylan::Uint8 * alphas = coverage + y * width ;
+
+	for ( Length x = 0; x < width; x++ )
+	  row[x] = Pixels::convertRGBAToPixelColor( format, color.r, color.g,
+		color.b, alphas[x] ) ;
+
+  }
+
+  res->unlock() ;
+
+  return * res ;
+
+}
+
+
+#endif // OSDL_USES_SDL_TTF
+
+
+
+void TrueTypeFont::setDistanceFieldMode( bool enabled,
+  PointSize referencePointSize )
+{
+
+#if OSDL_USES_SDL_TTF
+
+  if ( ! enabled )
+  {
+
+	clearDistanceFields() ;
+	closeReferenceFont() ;
+
+	return ;
+
+  }
+
+  if ( referencePointSize == 0 )
+	throw FontException( "TrueTypeFont::setDistanceFieldMode failed: "
+	  "null reference point size" ) ;
+
+  // Nothing to do if already enabled with the same reference size:
+  if ( _distanceFields != 0 && referencePointSize == _referencePointSize )
+	return ;
+
+  clearDistanceFields() ;
+  closeReferenceFont() ;
+
+  _referencePointSize = referencePointSize ;
+
+  // Opening it now allows to report any error as soon as possible:
+  openReferenceFont() ;
+
+  _distanceFields = new DistanceFieldMap() ;
+
+#else // OSDL_USES_SDL_TTF
+
+  throw FontException( "TrueTypeFont::setDistanceFieldMode failed: "
+	"no SDL_ttf support available" ) ;
+
+#endif // OSDL_USES_SDL_TTF
+
+}
+
+
+
+bool TrueTypeFont::isInDistanceFieldMode() const
+{
+
+  return ( _distanceFields != 0 ) ;
+
+}
+
+
+
+Ceylan::System::Size TrueTypeFont::getDistanceFieldSize() const
+{
+
+  System::Size res = 0 ;
+
+#if OSDL_USES_SDL_TTF
+
+  if ( _distanceFields == 0 )
+	return res ;
+
+  for ( DistanceFieldMap::const_iterator it = _distanceFields->begin();
+	  it != _distanceFields->end(); it++ )
+	if ( (*it).second->values != 0 )
+	  res += (*it).second->width * (*it).second->height ;
+
+#endif // OSDL_USES_SDL_TTF
+
+  return res ;
+
+}
+
+
+
+OSDL::Video::Surface & TrueTypeFont::renderUnicodeGlyphAtSize(
+  Ceylan::Unicode character,
+  PointSize targetPointSize,
+  Pixels::ColorDefinition glyphColor )
+{
+
+#if OSDL_USES_SDL_TTF
+
+  if ( _distanceFields == 0 )
+	throw FontException( "TrueTypeFont::renderUnicodeGlyphAtSize failed: "
+	  "distance field mode not enabled" ) ;
+
+  if ( targetPointSize == 0 )
+	throw FontException( "TrueTypeFont::renderUnicodeGlyphAtSize failed: "
+	  "null point size specified" ) ;
+
+  const DistanceFieldGlyph & glyph = getDistanceFieldFor( character ) ;
+
+  Ceylan::Float32 scale =
+	static_cast<Ceylan::Float32>( targetPointSize ) / _referencePointSize ;
+
+  // Only the (scaled) ink box is returned, as with regular renderings:
+  Length width = Ceylan::Maths::Max<Length>( 1, static_cast<Length>(
+		Ceylan::Maths::Ceil( glyph.inkWidth * scale ) ) ) ;
+
+  Length height = Ceylan::Maths::Max<Length>( 1, static_cast<Length>(
+		Ceylan::Maths::Ceil( glyph.inkHeight * scale ) ) ) ;
+
+  Ceylan::Uint8 * coverage = new Ceylan::Uint8[ width * height ] ;
+  ::memset( coverage, 0, width * height ) ;
+
+  Ceylan::Float32 padding = DistanceFieldSpread * scale ;
+
+  sampleDistanceField( glyph.values, glyph.width, glyph.height, scale,
+	DistanceFieldSpread, /* originX */ -padding, /* originY */ -padding,
+	coverage, width, height ) ;
+
+  Surface * res ;
+
+  try
+  {
+
+	res = & createSurfaceFromCoverage( coverage, width, height,
+	  glyphColor ) ;
+
+  }
+  catch( const VideoException & e )
+  {
+
+	delete [] coverage ;
+
+	throw FontException( "TrueTypeFont::renderUnicodeGlyphAtSize: "
+	  "surface creation failed: " + e.toString() ) ;
+
+  }
+
+  delete [] coverage ;
+
+  if ( _convertToDisplay )
+	res->convertToDisplay( /* alphaChannelWanted */ true ) ;
+
+  return * res ;
+
+#else // OSDL_USES_SDL_TTF
+
+  throw FontException( "TrueTypeFont::renderUnicodeGlyphAtSize failed: "
+	"no SDL_ttf support available" ) ;
+
+#endif // OSDL_USES_SDL_TTF
+
+}
+
+
+
+OSDL::Video::Surface & TrueTypeFont::renderLatin1TextAtSize(
+  const std::string & text,
+  PointSize targetPointSize,
+  Pixels::ColorDefinition textColor )
+{
+
+#if OSDL_USES_SDL_TTF
+
+  if ( _distanceFields == 0 )
+	throw FontException( "TrueTypeFont::renderLatin1TextAtSize failed: "
+	  "distance field mode not enabled" ) ;
+
+  if ( text.empty() )
+	throw FontException( "TrueTypeFont::renderLatin1TextAtSize failed: "
+	  "empty text specified" ) ;
+
+  if ( targetPointSize == 0 )
+	throw FontException( "TrueTypeFont::renderLatin1TextAtSize failed: "
+	  "null point size specified" ) ;
+
+  Ceylan::Float32 scale =
+	static_cast<Ceylan::Float32>( targetPointSize ) / _referencePointSize ;
+
+  System::Size textSize = text.size() ;
+
+  const DistanceFieldGlyph ** glyphs =
+	new const DistanceFieldGlyph *[ textSize ] ;
+
+  Ceylan::Float32 * penAbscissas = new Ceylan::Float32[ textSize ] ;
+
+  /*
+   * First pass: lays out the glyphs at the reference size, as the regular
+   * rendering does, and determines the horizontal extent of their ink.
+   *
+   */
+  SignedLength pen = 0 ;
+  SignedLength leftmost = 0 ;
+  SignedLength rightmost = 0 ;
+
+  try
+  {
+
+	for ( System::Size i = 0; i < textSize; i++ )
+	{
+
+	  glyphs[i] = & getDistanceFieldFor(
+		Ceylan::UnicodeString::ConvertFromLatin1(
+		  static_cast<Ceylan::Latin1Char>( text[i] ) ) ) ;
+
+	  penAbscissas[i] = static_cast<Ceylan::Float32>( pen ) ;
+
+	  if ( glyphs[i]->offsetX + pen < leftmost )
+		leftmost = glyphs[i]->offsetX + pen ;
+
+	  SignedLength right = pen + Ceylan::Maths::Max<SignedLength>(
+		glyphs[i]->offsetX + glyphs[i]->inkWidth, glyphs[i]->advance ) ;
+
+	  if ( right > rightmost )
+		rightmost = right ;
+
+	  pen += glyphs[i]->advance ;
+
+	}
+
+  }
+  catch( const FontException & )
+  {
+
+	delete [] penAbscissas ;
+	delete [] glyphs ;
+
+	throw ;
+
+  }
+
+  Length width = Ceylan::Maths::Max<Length>( 1, static_cast<Length>(
+		Ceylan::Maths::Ceil( ( rightmost - leftmost ) * scale ) ) ) ;
+
+  // Same height as basicRenderLatin1Text, scaled:
+  Length height = Ceylan::Maths::Max<Length>( 1, static_cast<Length>(
+		Ceylan::Maths::Ceil(
+		  ( _referenceLineSkip - _referenceDescent ) * scale ) ) ) ;
+
+  Ceylan::Float32 ascent = _referenceAscent * scale ;
+  Ceylan::Float32 padding = DistanceFieldSpread * scale ;
+
+  Ceylan::Uint8 * coverage = new Ceylan::Uint8[ width * height ] ;
+  ::memset( coverage, 0, width * height ) ;
+
+  // Second pass: samples each field directly into the coverage buffer.
+  for ( System::Size i = 0; i < textSize; i++ )
+	sampleDistanceField( glyphs[i]->values, glyphs[i]->width,
+	  glyphs[i]->height, scale, DistanceFieldSpread,
+	  ( penAbscissas[i] + glyphs[i]->offsetX - leftmost ) * scale - padding,
+	  ascent - glyphs[i]->offsetY * scale - padding,
+	  coverage, width, height ) ;
+
+  delete [] penAbscissas ;
+  delete [] glyphs ;
+
+  Surface * res ;
+
+  try
+  {
+
+	res = & createSurfaceFromCoverage( coverage, width, height, textColor ) ;
+
+  }
+  catch( const VideoException & e )
+  {
+
+	delete [] coverage ;
+
+	throw FontException( "TrueTypeFont::renderLatin1TextAtSize: "
+	  "surface creation failed: " + e.toString() ) ;
+
+  }
+
+  delete [] coverage ;
+
+  if ( _convertToDisplay )
+	res->convertToDisplay( /* alphaChannelWanted */ true ) ;
+
+  return * res ;
+
+#else // OSDL_USES_SDL_TTF
+
+  throw FontException( "TrueTypeFont::renderLatin1TextAtSize failed: "
+	"no SDL_ttf support available" ) ;
+
+#endif // OSDL_USES_SDL_TTF
+
+}
+
+
+
+
+// Prewarming section.
+
+
+
+#if OSDL_USES_SDL_TTF
+
+
+/**
+ * Job rendering a set of glyphs in the background, thanks to a font backend
+ * instance dedicated to prewarming.
+ *
+ * Only the backend rendering is done by the worker: conversions to OSDL
+ * surfaces (including to the display format) and cache insertions are to be
+ * performed afterwards by the thread using the font, as they are not
+ * thread-safe.
+ *
+ */
+class GlyphPrewarmingJob : public OSDL::Job
+{
+
+public:
+
+
+  GlyphPrewarmingJob( LowLevelTTFFont & font, const string & glyphs,
+	  Font::RenderQuality quality, Pixels::ColorDefinition glyphColor,
+	  Pixels::ColorDefinition backgroundColor ) :
+	OSDL::Job( "glyph prewarming" ),
+	_font( & font ),
+	_glyphs( glyphs ),
+	_renderings( glyphs.size(), static_cast<SDL_Surface *>( 0 ) ),
+	_quality( quality ),
+	_glyphColor( glyphColor ),
+	_backgroundColor( backgroundColor )
+  {
+
+  }
+
+
+  virtual ~GlyphPrewarmingJob() throw()
+  {
+
+	// Renderings not taken by the font are deallocated:
+	for ( std::vector<SDL_Surface *>::iterator it = _renderings.begin();
+		it != _renderings.end(); it++ )
+	  if ( *it != 0 )
+		SDL_FreeSurface( *it ) ;
+
+  }
+
+
+  virtual void execute()
+  {
+
+	for ( System::Size i = 0; i < _glyphs.size(); i++ )
+	{
+
+	  Ceylan::Unicode character = Ceylan::UnicodeString::ConvertFromLatin1(
+		static_cast<Ceylan::Latin1Char>( _glyphs[i] ) ) ;
+
+	  // Same backend calls as basicRenderUnicodeGlyph:
+	  if ( _quality == Font::Blended )
+		_renderings[i] = ::TTF_RenderGlyph_Blended( _font, character,
+		  _glyphColor ) ;
+	  else
+		_renderings[i] = ::TTF_RenderGlyph_Shaded( _font, character,
+		  _glyphColor, _backgroundColor ) ;
+
+	  // A null rendering will result in a cache miss later, nothing more.
+
+	}
+
+  }
+
+
+  /// The backend font instance dedicated to prewarming.
+  LowLevelTTFFont * _font ;
+
+  /// The Latin-1 characters to render.
+  string _glyphs ;
+
+  /// The backend rendering of each character, if any.
+  std::vector<SDL_Surface *> _renderings ;
+
+  Font::RenderQuality _quality ;
+
+  Pixels::ColorDefinition _glyphColor ;
+
+  Pixels::ColorDefinition _backgroundColor ;
+
+
+} ;
+
+
+#endif // OSDL_USES_SDL_TTF
+
+
+
+void TrueTypeFont::prewarmLatin1Glyphs( const std::string & glyphs,
+  RenderQuality quality, Pixels::ColorDefinition glyphColor )
+{
+
+#if OSDL_USES_SDL_TTF
+
+  if ( ! hasContent() )
+	throw FontException( "TrueTypeFont::prewarmLatin1Glyphs failed: "
+	  "font not loaded" ) ;
+
+  if ( _cacheSettings != GlyphCached )
+	throw FontException( "TrueTypeFont::prewarmLatin1Glyphs failed: "
+	  "prewarming requires a glyph-cached font" ) ;
+
+  // Removes duplicates, while preserving the request order:
+  string toRender ;
+  bool requested[256] = { false } ;
+
+  for ( string::const_iterator it = glyphs.begin(); it != glyphs.end(); it++ )
+  {
+
+	Ceylan::Uint8 index = static_cast<Ceylan::Uint8>( *it ) ;
+
+	if ( ! requested[index] )
+	{
+
+	  requested[index] = true ;
+	  toRender += *it ;
+
+	}
+
+  }
+
+  if ( toRender.empty() )
+	return ;
+
+  if ( _prewarmingPool == 0 )
+  {
+
+	try
+	{
+
+	  // A single worker, as a backend font instance is not reentrant:
+	  _prewarmingPool = new OSDL::WorkerPool( /* workerCount */ 1,
+		"glyph prewarming pool" ) ;
+
+	}
+	catch( const OSDL::WorkerPoolException & e )
+	{
+
+	  throw FontException( "TrueTypeFont::prewarmLatin1Glyphs failed: "
+		+ e.toString() ) ;
+
+	}
+
+  }
+
+  if ( _prewarmingFont == 0 )
+	_prewarmingFont = & openBackendFont( _pointSize ) ;
+
+  RenderingStyle currentStyle = ::TTF_GetFontStyle( _content ) ;
+
+  if ( ::TTF_GetFontStyle( _prewarmingFont ) != currentStyle )
+  {
+
+	// The worker must not be using the prewarming font meanwhile:
+	_prewarmingPool->waitForAll() ;
+	::TTF_SetFontStyle( _prewarmingFont, currentStyle ) ;
+
+  }
+
+  GlyphPrewarmingJob * job = new GlyphPrewarmingJob( * _prewarmingFont,
+	toRender, quality, glyphColor, _backgroundColor ) ;
+
+  try
+  {
+
+	_prewarmingPool->submit( * job ) ;
+
+  }
+  catch( const OSDL::WorkerPoolException & e )
+  {
+
+	delete job ;
+
+	throw FontException( "TrueTypeFont::prewarmLatin1Glyphs failed: "
+	  + e.toString() ) ;
+
+  }
+
+  _prewarmingJobs.push_back( job ) ;
+
+#else // OSDL_USES_SDL_TTF
+
+  throw FontException( "TrueTypeFont::prewarmLatin1Glyphs failed: "
+	"no SDL_ttf support available" ) ;
+
+#endif // OSDL_USES_SDL_TTF
+
+}
+
+
+
+void TrueTypeFont::prewarmLatin1Texts( const std::list<std::string> & texts,
+  RenderQuality quality, Pixels::ColorDefinition glyphColor )
+{
+
+  string glyphs ;
+
+  for ( std::list<string>::const_iterator it = texts.begin();
+	  it != texts.end(); it++ )
+	glyphs += *it ;
+
+  // Duplicates will be removed there:
+  prewarmLatin1Glyphs( glyphs, quality, glyphColor ) ;
+
+}
+
+
+
+Ceylan::Uint32 TrueTypeFont::integratePrewarmedGlyphs()
+{
+
+  Ceylan::Uint32 integratedCount = 0 ;
+
+#if OSDL_USES_SDL_TTF
+
+  // Jobs are executed in order by a single worker:
+  while ( ! _prewarmingJobs.empty()
+	&& _prewarmingPool->isCompleted( * _prewarmingJobs.front() ) )
+  {
+
+	GlyphPrewarmingJob * job =
+	  static_cast<GlyphPrewarmingJob *>( _prewarmingJobs.front() ) ;
+
+	_prewarmingJobs.pop_front() ;
+
+	for ( System::Size i = 0; i < job->_glyphs.size(); i++ )
+	{
+
+	  SDL_Surface * rendering = job->_renderings[i] ;
+
+	  if ( rendering == 0 )
+		continue ;
+
+	  // Ownership of the backend surface is transferred here:
+	  job->_renderings[i] = 0 ;
+
+	  Surface * glyphSurface ;
+
+	  try
+	  {
+
+		glyphSurface = & createGlyphSurfaceFrom( * rendering, job->_quality,
+		  job->_glyphColor ) ;
+
+	  }
+	  catch( const Ceylan::Exception & e )
+	  {
+
+		LogPlug::warning( "TrueTypeFont::integratePrewarmedGlyphs: "
+		  "skipping a glyph: " + e.toString() ) ;
+
+		continue ;
+
+	  }
+
+	  CharColorQualityKey renderKey(
+		static_cast<Ceylan::Latin1Char>( job->_glyphs[i] ),
+		job->_glyphColor, job->_quality ) ;
+
+	  bool takenByCache ;
+
+	  try
+	  {
+
+		takenByCache = _glyphCache->takeOwnershipOf( renderKey,
+		  * glyphSurface ) ;
+
+	  }
+	  catch( const Ceylan::ResourceManagerException & )
+	  {
+
+		// Already in cache (ex: rendered meanwhile), hence no more needed:
+		takenByCache = false ;
+
+	  }
+
+	  if ( takenByCache )
+		integratedCount++ ;
+	  else
+		delete glyphSurface ;
+
+	}
+
+	delete job ;
+
+  }
+
+#endif // OSDL_USES_SDL_TTF
+
+  return integratedCount ;
+
+}
+
+
+
+bool TrueTypeFont::isPrewarmingDone()
+{
+
+  integratePrewarmedGlyphs() ;
+
+  return _prewarmingJobs.empty() ;
+
+}
+
+
+
+bool TrueTypeFont::waitForPrewarming( Ceylan::Uint32 timeout )
+{
+
+  if ( _prewarmingPool != 0 )
+	_prewarmingPool->waitForAll( timeout ) ;
+
+  return isPrewarmingDone() ;
+
+}
+
+
+
+const string TrueTypeFont::toString( Ceylan::VerbosityLevels level ) const
+{
+
+#if OSDL_USES_SDL_TTF
+
+  string res = "Truetype font, whose point size is "
+	+ Ceylan::toString( _pointSize ) + " pixel height" ;
+
+  if ( _distanceFields != 0 )
+	res += " (in signed distance field mode, with a reference point size of "
+	  + Ceylan::toString( _referencePointSize ) + ", "
+	  + Ceylan::toString(
+		static_cast<Ceylan::Uint32>( _distanceFields->size() ) )
+	  + " glyph field(s) generated so far, for a total of "
+	  + Ceylan::toString(
+		static_cast<Ceylan::Uint32>( getDistanceFieldSize() ) )
+	  + " bytes)" ;
+
+  if ( ! hasContent() )
+	return res + ", and which is not loaded" ;
+
+  if ( level == Ceylan::low )
+	return res ;
+
+  Ceylan::Uint16 faceCount = getFacesCount() ;
+
+  res += ". This font has " ;
+
+  switch( faceCount )
+  {
+
+  case 0:
+	res += "no available face (abnormal)" ;
+	break ;
+
+  case 1:
+	res += "exactly one face" ;
+	break ;
+
+  default:
+	res += Ceylan::toString( faceCount ) + " faces" ;
+	break ;
+
+  }
+
+  if ( isFixedWidth() )
+	res +=", and is fixed width" ;
+  else
+	res +=", and is not fixed width" ;
+
+  res +=". The family name of the current face is '" + getFaceFamilyName()
+	+ "', and its style name is '" + getFaceStyleName() + "'" ;
+
+  if ( level == Ceylan::medium )
+	return res ;
+
+  SDL_version compileVersion ;
+
+  TTF_VERSION( & compileVersion ) ;
+
+  const SDL_version * linkedVersion = ::TTF_Linked_Version() ;
+
+  res += ". The OSDL font module is compiled with SDL_ttf version "
+	+ Ceylan::toNumericalString( compileVersion.major ) + "."
+	+ Ceylan::toNumericalString( compileVersion.minor ) + "."
+	+ Ceylan::toNumericalString( compileVersion.patch )
+	+ ", linked with version "
+	+ Ceylan::toNumericalString( linkedVersion->major ) + "."
+	+ Ceylan::toNumericalString( linkedVersion->minor ) + "."
+	+ Ceylan::toNumericalString( linkedVersion->patch ) ;
+  + ". Rendering style is "
+	+ InterpretRenderingStyle( ::TTF_GetFontStyle( _content ) ) ;
+
+
+  return res ;
+
+#else // OSDL_USES_SDL_TTF
+
+  return "" ;
+
+#endif // OSDL_USES_SDL_TTF
+
+}
+
+
+
+
+// Static section.
+
+
+
+Font::RenderQuality TrueTypeFont::GetObtainedQualityFor(
+  Font::RenderQuality targetedQuality )
+{
+
+  return targetedQuality ;
+
+}
+
+
+
+void TrueTypeFont::SetUnicodeSwapStatus( bool newStatus )
+{
+
+#if OSDL_USES_SDL_TTF
+
+  if ( newStatus )
+	::TTF_ByteSwappedUNICODE( 1 ) ;
+  else
+	::TTF_ByteSwappedUNICODE( 0 ) ;
+
+#endif // OSDL_USES_SDL_TTF
+
+}
+
+
+
+std::string TrueTypeFont::FindPathFor( const std::string & fontFilename )
+{
+
+  // Searches directly in the current working directory:
+  if ( System::File::ExistsAsFileOrSymbolicLink( fontFilename ) )
+  {
+
+	return fontFilename ;
+
+  }
+  else
+  {
+
+	// On failure use the dedicated TrueType font locator:
+	try
+	{
+
+	  return TrueTypeFont::TrueTypeFontFileLocator.find( fontFilename ) ;
+
 	}
-	catch( const Video::VideoException & e )
+	catch( const System::FileLocatorException & e )
 	{
-	  throw FontException(
-		"TrueTypeFont::renderLatin1Text (blended): "
-		"color keying failed: " + e.toString() ) ;
-	}
 
-#endif // OSDL_ADDS_COLOR_KEY
+	  // Last hope is the general font locator:
+	  try
+	  {
 
-	break ;
+		return Font::FontFileLocator.find( fontFilename ) ;
 
+	  }
+	  catch( const System::FileLocatorException & ex )
+	  {
 
-  default:
-	throw FontException( "TrueTypeFont::renderLatin1Text: "
-	  "unknown quality requested: "
-	  + Ceylan::toString( quality ) + "." ) ;
-	break ;
+		// Not found!
+
+		string currentDir ;
+
+		try
+		{
+		  currentDir = Directory::GetCurrentWorkingDirectoryPath() ;
+		}
+		catch( const DirectoryException & exc )
+		{
+		  throw FontException(
+			"TrueTypeFont constructor: unable to load '"
+			+ fontFilename
+			+ "', exception generation triggered another failure: "
+			+ exc.toString() + "." ) ;
+		}
+
+		throw FontException( "TrueTypeFont constructor: '"
+		  + fontFilename
+		  + "' is not a regular file or a symbolic link "
+		  "relative to the current directory (" + currentDir
+		  + ") and cannot be found through TrueType font locator ("
+		  + TrueTypeFont::TrueTypeFontFileLocator.toString()
+		  + ") nor through general font locator based on "
+		  "font path environment variable ("
+		  + Font::FontPathEnvironmentVariable + "): "
+		  + Font::FontFileLocator.toString() + "." ) ;
 
+	  }
+	}
   }
 
+}
 
-  if ( _convertToDisplay )
-  {
 
-	/*
-	 * We want to keep our colorkey (if any), so we choose to add alpha only if
-	 * no colorkey is used.
-	 *
-	 * Surface will be RLE encoded here:
-	 *
-	 */
-	if ( quality == Blended )
-	  res->convertToDisplay( /* alphaChannelWanted */ true ) ;
-	else
-	  res->convertToDisplay( /* alphaChannelWanted */ false ) ;
 
-  }
+string TrueTypeFont::DescribeLastError()
+{
 
-  return * res ;
+#if OSDL_USES_SDL_TTF
+
+  string error = string( ::TTF_GetError() ) ;
+
+  if ( error.empty() )
+	return "(no SDL_ttf error detected)" ;
+  else
+	return ::TTF_GetError() ;
 
 #else // OSDL_USES_SDL_TTF
 
-  throw FontException( "TrueTypeFont::renderLatin1Text failed: "
-	"no SDL_ttf support available" ) ;
+  return "(no SDL_ttf support available)" ;
 
 #endif // OSDL_USES_SDL_TTF
 
@@ -1179,132 +3083,135 @@ OSDL::Video::Surface & TrueTypeFont::renderLatin1Text(
 
 
 
-OSDL::Video::Surface & TrueTypeFont::renderUTF8Text(
-  const std::string & text,
-  RenderQuality quality,
-  Pixels::ColorDefinition textColor )
+OSDL::Video::Surface & TrueTypeFont::basicRenderUnicodeGlyph(
+  Ceylan::Unicode character, RenderQuality quality,
+  Pixels::ColorDefinition glyphColor )
 {
 
 #if OSDL_USES_SDL_TTF
 
   if ( ! hasContent() )
-	throw FontException( "TrueTypeFont::renderUTF8Text failed: "
+	throw FontException( "TrueTypeFont::basicRenderUnicodeGlyph failed: "
 	  "font not loaded" ) ;
 
+  // Render unconditionnally here:
+
   SDL_Surface * textSurface ;
-  Surface * res ;
 
   switch( quality )
   {
 
+	/* Apparently TTF_RenderGlyph_Solid may fail and return a null pointer while
+	   not setting any TTF error, ex:
+		 - for Latin-1 character 'o', Unicode 111, with iomanoid.ttf
+		 - for Latin-1 character 'n', Unicode 110, with neurochr.ttf
 
-  case Solid:
-	textSurface = ::TTF_RenderUTF8_Solid( _content, text.c_str(),
-	  textColor ) ;
+		 Thus we had to comment out the Solid code, and use the Shaded one
+		 instead:
+	*/
+
+  // case Solid:
+
+  //	textSurface = ::TTF_RenderGlyph_Solid( _content, character,
+  //	  glyphColor ) ;
+
+  //	if ( textSurface == 0 )
+  //	  throw FontException(
+  //		"TrueTypeFont::basicRenderUnicodeGlyph (solid): "
+  //		"unable to render character '"
+  //		+ Ceylan::toString( character )
+  //		+ "': " + DescribeLastError() ) ;
+
+  //	res = new Surface( *textSurface,
+  //	  /* display type */ Surface::BackBuffer ) ;
+
+  //	// No colorkey added, since already there.
+  //	break ;
+
+ case Solid:
+ case Shaded:
+	textSurface = ::TTF_RenderGlyph_Shaded( _content, character,
+	  glyphColor, _backgroundColor ) ;
 
 	if ( textSurface == 0 )
-	  throw FontException( "TrueTypeFont::renderUTF8Text (solid): "
-		"unable to render text '" + text
+	  throw FontException(
+		"TrueTypeFont::basicRenderUnicodeGlyph (shaded): "
+		"unable to render character '"
+		+ Ceylan::toString( character )
 		+ "': " + DescribeLastError() ) ;
 
-	res = new Surface( * textSurface,
-	  /* display type */ Surface::BackBuffer ) ;
 	break ;
 
 
-  case Shaded:
-	textSurface = ::TTF_RenderUTF8_Shaded( _content, text.c_str(),
-	  textColor, _backgroundColor ) ;
+  case Blended:
+	textSurface = ::TTF_RenderGlyph_Blended( _content, character,
+	  glyphColor ) ;
 
 	if ( textSurface == 0 )
-	  throw FontException( "TrueTypeFont::renderUTF8Text (shaded): "
-		"unable to render text '" + text
+	  throw FontException(
+		"TrueTypeFont::basicRenderUnicodeGlyph (blended): "
+		"unable to render character '"
+		+ Ceylan::toString( character )
 		+ "': " + DescribeLastError() ) ;
 
-	/*
-	 * We have to create a new surface so that the surface returned by
-	 * '::TTF_RenderUTF8_Shaded' will no more be palettized: we need a color key
-	 * to have transparent blits.
-	 *
-	 */
-	ColorMask redMask, greenMask, blueMask ;
-	Pixels::getRecommendedColorMasks( redMask, greenMask, blueMask ) ;
-
-	res = new Surface( Surface::Hardware | Surface::ColorkeyBlit,
-	  textSurface->w, textSurface->h, 32,
-	  redMask, greenMask, blueMask, /* no alpha wanted */ 0 ) ;
-
-	// Avoid messing text color with color key:
-	Pixels::ColorDefinition colorKey ;
+	break ;
 
-	if ( Pixels::areEqual( textColor, Pixels::Black,
-		/* use alpha */ false ) )
-	{
 
-	  colorKey = Pixels::White ;
-	  res->fill( colorKey ) ;
+  default:
+	throw FontException( "TrueTypeFont::basicRenderUnicodeGlyph: "
+	  "unknown quality requested: "
+	  + Ceylan::toString( quality ) + "." ) ;
+	break ;
 
-	}
-	else
-	{
+  }
 
-	  colorKey = Pixels::Black ;
-	  /*
-	   * No need to fill 'res' with black, since new RGB surfaces come all black
-	   * already.
-	   *
-	   */
+  return createGlyphSurfaceFrom( * textSurface, quality, glyphColor ) ;
 
-	}
+#else // OSDL_USES_SDL_TTF
 
-	try
-	{
+  throw FontException( "TrueTypeFont::basicRenderUnicodeGlyph failed: "
+	"no SDL_ttf support available" ) ;
 
-	  res->setColorKey(
-		Surface::ColorkeyBlit | Surface::RLEColorkeyBlit,
-		Pixels::convertColorDefinitionToPixelColor(
-		  res->getPixelFormat(), colorKey ) ) ;
+#endif // OSDL_USES_SDL_TTF
 
-	}
-	catch( const Video::VideoException & e )
-	{
-	  throw FontException( "TrueTypeFont::renderUTF8Text (shaded): "
-		"color keying failed: " + e.toString() ) ;
-	}
+}
 
-	SDL_BlitSurface( textSurface, 0, & res->getSDLSurface(), 0 ) ;
-	SDL_FreeSurface( textSurface ) ;
-	textSurface = 0 ;
-	break ;
 
 
-  case Blended:
-	textSurface = ::TTF_RenderUTF8_Blended( _content, text.c_str(),
-	  textColor ) ;
+OSDL::Video::Surface & TrueTypeFont::createGlyphSurfaceFrom(
+  LowLevelSurface & renderedGlyph, RenderQuality quality,
+  Pixels::ColorDefinition glyphColor )
+{
 
-	if ( textSurface == 0 )
-	  throw FontException(
-		"TrueTypeFont::renderUTF8Text (blended): "
-		"unable to render text '" + text
-		+ "': " + DescribeLastError() ) ;
+#if OSDL_USES_SDL_TTF
 
-	res = new Surface( * textSurface,
-	  /* display type */ Surface::BackBuffer ) ;
+  SDL_Surface * textSurface = & renderedGlyph ;
+  Surface * res ;
 
+  switch( quality )
+  {
 
-	// Not defined by default:
-#ifdef OSDL_ADDS_COLOR_KEY
+  case Solid:
+  case Shaded:
 
 	/*
-	 * Alpha should be preserved since the blending is the point of this
-	 * quality, but adding a color key should not harm:
+	 * We have to create a new surface so that the surface returned by
+	 * '::TTF_RenderGlyph_Shaded' will no more be palettized: we need a color
+	 * key to have transparent blits.
 	 *
 	 */
 
+	ColorMask redMask, greenMask, blueMask ;
+	Pixels::getRecommendedColorMasks( redMask, greenMask, blueMask ) ;
+
+	res = new Surface( Surface::Hardware | Surface::ColorkeyBlit,
+	  textSurface->w, textSurface->h, /* bpp */ 32,
+	  redMask, greenMask, blueMask, /* no alpha wanted */ 0 ) ;
+
 	// Avoid messing text color with color key:
 	Pixels::ColorDefinition colorKey ;
 
-	if ( Pixels::areEqual( textColor, Pixels::Black,
+	if ( Pixels::areEqual( glyphColor, Pixels::Black,
 		/* use alpha */ false ) )
 	{
 
@@ -1316,11 +3223,13 @@ OSDL::Video::Surface & TrueTypeFont::renderUTF8Text(
 	{
 
 	  colorKey = Pixels::Black ;
+
 	  /*
 	   * No need to fill 'res' with black, since new RGB surfaces come all black
 	   * already.
 	   *
 	   */
+
 	}
 
 	try
@@ -1333,18 +3242,32 @@ OSDL::Video::Surface & TrueTypeFont::renderUTF8Text(
 	catch( const Video::VideoException & e )
 	{
 
-	  throw FontException( "TrueTypeFont::renderUTF8Text (blended): "
+	  SDL_FreeSurface( textSurface ) ;
+	  delete res ;
+
+	  throw FontException(
+		"TrueTypeFont::createGlyphSurfaceFrom (shaded): "
 		"color keying failed: " + e.toString() ) ;
 
 	}
+	SDL_BlitSurface( textSurface, 0, & res->getSDLSurface(), 0 ) ;
+	SDL_FreeSurface( textSurface ) ;
+	textSurface = 0 ;
+	break ;
 
-#endif // OSDL_ADDS_COLOR_KEY
+
+  case Blended:
+	res = new Surface( *textSurface,
+	  /* display type */ Surface::BackBuffer ) ;
+
+	// No color key enforced.
 
 	break ;
 
 
   default:
-	throw FontException( "TrueTypeFont::renderUTF8Text: "
+	SDL_FreeSurface( textSurface ) ;
+	throw FontException( "TrueTypeFont::createGlyphSurfaceFrom: "
 	  "unknown quality requested: "
 	  + Ceylan::toString( quality ) + "." ) ;
 	break ;
@@ -1369,11 +3292,14 @@ OSDL::Video::Surface & TrueTypeFont::renderUTF8Text(
 
   }
 
+  // Uncomment next line to debug character bounding-box:
+  //res->drawEdges() ;
+
   return * res ;
 
 #else // OSDL_USES_SDL_TTF
 
-  throw FontException( "TrueTypeFont::renderUTF8Text failed: "
+  throw FontException( "TrueTypeFont::createGlyphSurfaceFrom failed: "
 	"no SDL_ttf support available" ) ;
 
 #endif // OSDL_USES_SDL_TTF
@@ -1382,208 +3308,199 @@ OSDL::Video::Surface & TrueTypeFont::renderUTF8Text(
 
 
 
-OSDL::Video::Surface & TrueTypeFont::renderUnicodeText(
-  const Ceylan::Unicode * text,
-  RenderQuality quality,
-  Pixels::ColorDefinition textColor )
+const TrueTypeFont::DistanceFieldGlyph & TrueTypeFont::getDistanceFieldFor(
+  Ceylan::Unicode character )
 {
 
 #if OSDL_USES_SDL_TTF
 
-  if ( ! hasContent() )
-	throw FontException( "TrueTypeFont::renderUnicodeText failed: "
-	  "font not loaded" ) ;
+  DistanceFieldMap::const_iterator it = _distanceFields->find( character ) ;
 
-  if ( text == 0 )
-	throw FontException(
-	  "TrueTypeFont::renderUnicode: null pointer for Unicode string." ) ;
+  if ( it != _distanceFields->end() )
+	return * (*it).second ;
 
-  SDL_Surface * textSurface ;
-  Surface * res ;
+  if ( _referenceFont == 0 )
+	openReferenceFont() ;
 
-  switch( quality )
+  int minX, maxX, minY, maxY, advance ;
+
+  if ( ::TTF_GlyphMetrics( _referenceFont, character, & minX, & maxX,
+	  & minY, & maxY, & advance ) != 0 )
+	throw FontException( "TrueTypeFont::getDistanceFieldFor: "
+	  + DescribeLastError() ) ;
+
+  DistanceFieldGlyph * glyph = new DistanceFieldGlyph() ;
+
+  glyph->inkWidth  = 0 ;
+  glyph->inkHeight = 0 ;
+  glyph->width     = 0 ;
+  glyph->height    = 0 ;
+  glyph->offsetX   = static_cast<SignedLength>( minX ) ;
+  glyph->offsetY   = static_cast<SignedLength>( maxY ) ;
+  glyph->advance   = static_cast<SignedLength>( advance ) ;
+  glyph->values    = 0 ;
+
+  // Glyphs with no ink (ex: space) just need their metrics:
+  if ( maxX <= minX || maxY <= minY )
   {
 
-  case Solid:
-	textSurface = ::TTF_RenderUNICODE_Solid( _content, text,
-	  textColor ) ;
+	_distanceFields->insert( std::make_pair( character, glyph ) ) ;
+	return * glyph ;
 
-	if ( textSurface == 0 )
-	  throw FontException(
-		"TrueTypeFont::renderUnicodeText (solid): "
-		"unable to render text: " + DescribeLastError() ) ;
-	res = new Surface( * textSurface,
-	  /* display type */ Surface::BackBuffer ) ;
-	break ;
+  }
 
+  /*
+   * Rendered in shaded quality from black to white, so that each pixel of the
+   * 8-bit palettized surface is directly the coverage of the glyph:
+   *
+   */
+  SDL_Surface * glyphSurface = ::TTF_RenderGlyph_Shaded( _referenceFont,
+	character, Pixels::White, Pixels::Black ) ;
 
-  case Shaded:
-	textSurface = ::TTF_RenderUNICODE_Shaded( _content, text,
-	  textColor, _backgroundColor ) ;
+  if ( glyphSurface == 0 )
+  {
 
-	if ( textSurface == 0 )
-	  throw FontException(
-		"TrueTypeFont::renderUnicodeText (shaded): "
-		"unable to render text: " + DescribeLastError() ) ;
+	delete glyph ;
 
-	/*
-	 * We have to create a new surface so that the surface returned by
-	 * '::TTF_RenderUNICODE_Shaded' will no more be palettized: we need a color
-	 * key to have transparent blits.
-	 *
-	 */
-	ColorMask redMask, greenMask, blueMask ;
-	Pixels::getRecommendedColorMasks( redMask, greenMask, blueMask ) ;
+	throw FontException( "TrueTypeFont::getDistanceFieldFor: "
+	  "unable to render character '" + Ceylan::toString( character )
+	  + "': " + DescribeLastError() ) ;
 
-	res = new Surface( Surface::Hardware | Surface::ColorkeyBlit,
-	  textSurface->w, textSurface->h, 32,
-	  redMask, greenMask, blueMask, /* no alpha wanted */ 0 ) ;
+  }
 
-	// Avoid messing text color with color key:
-	Pixels::ColorDefinition colorKey ;
+  const Ceylan::Sint32 spread = DistanceFieldSpread ;
 
-	if ( Pixels::areEqual( textColor, Pixels::Black,
-		/* use alpha */ false ) )
-	{
+  glyph->inkWidth  = static_cast<Length>( glyphSurface->w ) ;
+  glyph->inkHeight = static_cast<Length>( glyphSurface->h ) ;
+  glyph->width     = glyph->inkWidth  + 2 * spread ;
+  glyph->height    = glyph->inkHeight + 2 * spread ;
 
-	  colorKey = Pixels::White ;
-	  res->fill( colorKey ) ;
+  const Ceylan::Sint32 width  = glyph->width ;
+  const Ceylan::Sint32 height = glyph->height ;
+  const System::Size count = width * height ;
 
-	}
-	else
-	{
+  /*
+   * Two transforms are needed: one whose seeds are the outside texels (giving,
+   * for inside texels, their distance to the outline), and one whose seeds are
+   * the inside texels.
+   *
+   */
+  Ceylan::Sint32 * insideOffsets  = new Ceylan::Sint32[ 2 * count ] ;
+  Ceylan::Sint32 * outsideOffsets = new Ceylan::Sint32[ 2 * count ] ;
 
-	  colorKey = Pixels::Black ;
+  if ( SDL_MUSTLOCK( glyphSurface ) )
+	SDL_LockSurface( glyphSurface ) ;
 
-	  /*
-	   * No need to fill 'res' with black, since new RGB surfaces come all black
-	   * already.
-	   *
-	   */
-	}
+  const Ceylan::Uint8 * coverage =
+	static_cast<const Ceylan::Uint8 *>( glyphSurface->pixels ) ;
 
-	try
+  for ( Ceylan::Sint32 y = 0; y < height; y++ )
+	for ( Ceylan::Sint32 x = 0; x < width; x++ )
 	{
-	  res->setColorKey(
-		Surface::ColorkeyBlit | Surface::RLEColorkeyBlit,
-		Pixels::convertColorDefinitionToPixelColor(
-		  res->getPixelFormat(), colorKey ) ) ;
-	}
-	catch( const Video::VideoException & e )
-	{
-	  throw FontException(
-		"TrueTypeFont::renderUnicodeText (shaded): "
-		"color keying failed: " + e.toString() ) ;
+
+	  Ceylan::Sint32 glyphX = x - spread ;
+	  Ceylan::Sint32 glyphY = y - spread ;
+
+	  bool inside = ( glyphX >= 0 && glyphY >= 0
+		&& glyphX < glyphSurface->w && glyphY < glyphSurface->h
+		&& coverage[ glyphY * glyphSurface->pitch + glyphX ] >= 128 ) ;
+
+	  System::Size index = 2 * ( y * width + x ) ;
+
+	  Ceylan::Sint32 insideOffset = inside ? NoSeedOffset : 0 ;
+	  Ceylan::Sint32 outsideOffset = inside ? 0 : NoSeedOffset ;
+
+	  insideOffsets[index]      = insideOffset ;
+	  insideOffsets[index+1]    = insideOffset ;
+	  outsideOffsets[index]     = outsideOffset ;
+	  outsideOffsets[index+1]   = outsideOffset ;
+
 	}
-	SDL_BlitSurface( textSurface, 0, & res->getSDLSurface(), 0 ) ;
-	SDL_FreeSurface( textSurface ) ;
-	textSurface = 0 ;
-	break ;
 
+  if ( SDL_MUSTLOCK( glyphSurface ) )
+	SDL_UnlockSurface( glyphSurface ) ;
 
-  case Blended:
-	textSurface = ::TTF_RenderUNICODE_Blended( _content, text,
-	  textColor ) ;
+  SDL_FreeSurface( glyphSurface ) ;
 
-	if ( textSurface == 0 )
-	  throw FontException(
-		"TrueTypeFont::renderUnicodeText (blended): "
-		"unable to render text: " + DescribeLastError() ) ;
+  propagateDistances( insideOffsets, width, height ) ;
+  propagateDistances( outsideOffsets, width, height ) ;
 
-	res = new Surface( * textSurface,
-	  /* display type */ Surface::BackBuffer ) ;
+  glyph->values = new Ceylan::Uint8[ count ] ;
 
+  // Distances are clamped to the spread, and stored as 128 +/- 127:
+  const Ceylan::Float32 encodingFactor = 127.0f / spread ;
 
-	// Not defined by default:
-#ifdef OSDL_ADDS_COLOR_KEY
+  for ( System::Size i = 0; i < count; i++ )
+  {
 
-	/*
-	 * Alpha should be preserved since the blending is the point of this
-	 * quality, but adding a color key should not harm:
-	 *
-	 */
+	Ceylan::Sint32 insideSquared = squaredNorm( insideOffsets[2*i],
+	  insideOffsets[2*i+1] ) ;
 
-	// Avoid messing text color with color key:
-	Pixels::ColorDefinition colorKey ;
+	Ceylan::Float32 distance ;
 
-	if ( Pixels::areEqual( textColor, Pixels::Black,
-		/* use alpha */ false ) )
-	{
+	// The outline lies half a texel away from the centers of border texels:
+	if ( insideSquared != 0 )
+	  distance = Ceylan::Maths::Sqrt(
+		static_cast<Ceylan::Float32>( insideSquared ) ) - 0.5f ;
+	else
+	  distance = 0.5f - Ceylan::Maths::Sqrt( static_cast<Ceylan::Float32>(
+		  squaredNorm( outsideOffsets[2*i], outsideOffsets[2*i+1] ) ) ) ;
 
-	  colorKey = Pixels::White ;
-	  res->fill( colorKey ) ;
+	Ceylan::Float32 encoded = 128.0f + distance * encodingFactor ;
 
-	}
+	if ( encoded <= 0 )
+	  glyph->values[i] = 0 ;
+	else if ( encoded >= 255 )
+	  glyph->values[i] = 255 ;
 	else
-	{
+	  glyph->values[i] = static_cast<Ceylan::Uint8>( encoded + 0.5f ) ;
 
-	  colorKey = Pixels::Black ;
+  }
 
-	  /*
-	   * No need to fill 'res' with black, since new RGB surfaces come all black
-	   * already.
-	   *
-	   */
-	}
+  delete [] insideOffsets ;
+  delete [] outsideOffsets ;
 
+#if OSDL_DEBUG_FONT
 
-	/*
-	 * Alpha should be preserved since the blending is the point of this
-	 * quality, but adding a color key should not harm:
-	 *
-	 */
-	try
-	{
+  LogPlug::debug( "TrueTypeFont::getDistanceFieldFor: generated a "
+	+ Ceylan::toString( glyph->width ) + "x"
+	+ Ceylan::toString( glyph->height ) + " field for character '"
+	+ Ceylan::toString( character ) + "'." ) ;
 
-	  res->setColorKey(
-		Surface::ColorkeyBlit | Surface::RLEColorkeyBlit,
-		Pixels::convertColorDefinitionToPixelColor(
-		  res->getPixelFormat(), colorKey ) ) ;
+#endif // OSDL_DEBUG_FONT
 
-	}
-	catch( const Video::VideoException & e )
-	{
-	  throw FontException(
-		"TrueTypeFont::renderUnicodeText (blended): "
-		"color keying failed: " + e.toString() ) ;
-	}
+  _distanceFields->insert( std::make_pair( character, glyph ) ) ;
 
-#endif // OSDL_ADDS_COLOR_KEY
+  return * glyph ;
 
-	break ;
+#else // OSDL_USES_SDL_TTF
 
+  throw FontException( "TrueTypeFont::getDistanceFieldFor failed: "
+	"no SDL_ttf support available" ) ;
 
-  default:
-	throw FontException( "TrueTypeFont::renderUnicodeText: "
-	  "unknown quality requested: "
-	  + Ceylan::toString( quality ) + "." ) ;
-	break ;
+#endif // OSDL_USES_SDL_TTF
 
-  }
+}
 
 
-  if ( _convertToDisplay )
-  {
 
-	/*
-	 * We want to keep our colorkey (if any), so we choose to add alpha only if
-	 *  no colorkey is used.
-	 *
-	 * Surface will be RLE encoded here:
-	 *
-	 */
-	if ( quality == Blended )
-	  res->convertToDisplay( /* alphaChannelWanted */ true ) ;
-	else
-	  res->convertToDisplay( /* alphaChannelWanted */ false ) ;
+void TrueTypeFont::openReferenceFont()
+{
 
-  }
+#if OSDL_USES_SDL_TTF
 
-  return * res ;
+  if ( _referenceFont != 0 )
+	return ;
+
+  _referenceFont = & openBackendFont( _referencePointSize ) ;
+
+  _referenceAscent   = ::TTF_FontAscent( _referenceFont ) ;
+  _referenceDescent  = ::TTF_FontDescent( _referenceFont ) ;
+  _referenceLineSkip = ::TTF_FontLineSkip( _referenceFont ) ;
 
 #else // OSDL_USES_SDL_TTF
 
-  throw FontException( "TrueTypeFont::renderUnicodeText failed: "
+  throw FontException( "TrueTypeFont::openReferenceFont failed: "
 	"no SDL_ttf support available" ) ;
 
 #endif // OSDL_USES_SDL_TTF
@@ -1592,376 +3509,372 @@ OSDL::Video::Surface & TrueTypeFont::renderUnicodeText(
 
 
 
-const string TrueTypeFont::toString( Ceylan::VerbosityLevels level ) const
+void TrueTypeFont::closeReferenceFont()
+{
+
+  closeBackendFont( _referenceFont ) ;
+
+}
+
+
+
+void TrueTypeFont::clearDistanceFields()
 {
 
 #if OSDL_USES_SDL_TTF
 
-  string res = "Truetype font, whose point size is "
-	+ Ceylan::toString( _pointSize ) + " pixel height" ;
+  if ( _distanceFields == 0 )
+	return ;
 
-  if ( ! hasContent() )
-	return res + ", and which is not loaded" ;
+  for ( DistanceFieldMap::iterator it = _distanceFields->begin();
+	  it != _distanceFields->end(); it++ )
+  {
 
-  if ( level == Ceylan::low )
-	return res ;
+	delete [] (*it).second->values ;
+	delete (*it).second ;
 
-  Ceylan::Uint16 faceCount = getFacesCount() ;
+  }
 
-  res += ". This font has " ;
+  delete _distanceFields ;
+  _distanceFields = 0 ;
 
-  switch( faceCount )
+#endif // OSDL_USES_SDL_TTF
+
+}
+
+
+
+void TrueTypeFont::stopPrewarming()
+{
+
+  if ( _prewarmingPool != 0 )
   {
 
-  case 0:
-	res += "no available face (abnormal)" ;
-	break ;
+	// Pending results are dropped, they may not match the font anymore:
+	_prewarmingPool->waitForAll() ;
 
-  case 1:
-	res += "exactly one face" ;
-	break ;
+	for ( std::list<OSDL::Job *>::iterator it = _prewarmingJobs.begin();
+		it != _prewarmingJobs.end(); it++ )
+	  delete *it ;
 
-  default:
-	res += Ceylan::toString( faceCount ) + " faces" ;
-	break ;
+	_prewarmingJobs.clear() ;
+
+	delete _prewarmingPool ;
+	_prewarmingPool = 0 ;
 
   }
 
-  if ( isFixedWidth() )
-	res +=", and is fixed width" ;
-  else
-	res +=", and is not fixed width" ;
+  closeBackendFont( _prewarmingFont ) ;
 
-  res +=". The family name of the current face is '" + getFaceFamilyName()
-	+ "', and its style name is '" + getFaceStyleName() + "'" ;
+}
 
-  if ( level == Ceylan::medium )
-	return res ;
 
-  SDL_version compileVersion ;
 
-  TTF_VERSION( & compileVersion ) ;
+/// Describes the in-memory content of a font file.
+struct TrueTypeFont::FontBlob
+{
 
-  const SDL_version * linkedVersion = ::TTF_Linked_Version() ;
+  /// The content of the font file, deciphered if needed.
+  const Ceylan::Byte * content ;
 
-  res += ". The OSDL font module is compiled with SDL_ttf version "
-	+ Ceylan::toNumericalString( compileVersion.major ) + "."
-	+ Ceylan::toNumericalString( compileVersion.minor ) + "."
-	+ Ceylan::toNumericalString( compileVersion.patch )
-	+ ", linked with version "
-	+ Ceylan::toNumericalString( linkedVersion->major ) + "."
-	+ Ceylan::toNumericalString( linkedVersion->minor ) + "."
-	+ Ceylan::toNumericalString( linkedVersion->patch ) ;
-  + ". Rendering style is "
-	+ InterpretRenderingStyle( ::TTF_GetFontStyle( _content ) ) ;
+  /// The size of this content, in bytes.
+  Ceylan::System::Size size ;
 
+  /// Tells whether the content is memory-mapped, rather than allocated.
+  bool mapped ;
 
-  return res ;
+  /// The number of backend instances currently using this content.
+  Ceylan::Uint32 referenceCount ;
 
-#else // OSDL_USES_SDL_TTF
+} ;
 
-  return "" ;
 
-#endif // OSDL_USES_SDL_TTF
 
-}
+#if OSDL_MAPS_FONT_FILES
 
+/**
+ * Maps in memory, read-only, the specified file of the standard filesystem.
+ *
+ * @return the mapped content, or null if the file could not be mapped.
+ *
+ */
+static const Ceylan::Byte * mapFontFile( const string & path,
+  Ceylan::System::Size size )
+{
 
+  if ( size == 0 )
+	return 0 ;
 
+  int descriptor = ::open( path.c_str(), O_RDONLY ) ;
 
-// Static section.
+  if ( descriptor == -1 )
+	return 0 ;
 
+  void * mapped = ::mmap( 0, size, PROT_READ, MAP_PRIVATE, descriptor, 0 ) ;
 
+  // The mapping remains valid once the descriptor is closed:
+  ::close( descriptor ) ;
 
-Font::RenderQuality TrueTypeFont::GetObtainedQualityFor(
-  Font::RenderQuality targetedQuality )
-{
+  if ( mapped == MAP_FAILED )
+	return 0 ;
 
-  return targetedQuality ;
+  return static_cast<const Ceylan::Byte *>( mapped ) ;
 
 }
 
+#endif // OSDL_MAPS_FONT_FILES
 
 
-void TrueTypeFont::SetUnicodeSwapStatus( bool newStatus )
+
+TrueTypeFont::FontBlob & TrueTypeFont::AcquireFontBlob(
+  const string & fontPath )
 {
 
-#if OSDL_USES_SDL_TTF
+  FontBlobMap::iterator it = FontBlobs.find( fontPath ) ;
 
-  if ( newStatus )
-	::TTF_ByteSwappedUNICODE( 1 ) ;
-  else
-	::TTF_ByteSwappedUNICODE( 0 ) ;
+  if ( it != FontBlobs.end() )
+  {
 
-#endif // OSDL_USES_SDL_TTF
+	(*it).second->referenceCount++ ;
+	return * (*it).second ;
 
-}
+  }
 
+  FontBlob * blob = new FontBlob() ;
 
+  blob->content        = 0 ;
+  blob->size           = 0 ;
+  blob->mapped         = false ;
+  blob->referenceCount = 1 ;
 
-std::string TrueTypeFont::FindPathFor( const std::string & fontFilename )
-{
+  Ceylan::Byte * buffer = 0 ;
 
-  // Searches directly in the current working directory:
-  if ( System::File::ExistsAsFileOrSymbolicLink( fontFilename ) )
+  try
   {
 
-	return fontFilename ;
-
-  }
-  else
-  {
+	Ceylan::System::File & fontFile = File::Open( fontPath ) ;
 
-	// On failure use the dedicated TrueType font locator:
 	try
 	{
 
-	  return TrueTypeFont::TrueTypeFontFileLocator.find( fontFilename ) ;
+	  blob->size = fontFile.size() ;
 
-	}
-	catch( const System::FileLocatorException & e )
-	{
+#if OSDL_MAPS_FONT_FILES
 
-	  // Last hope is the general font locator:
-	  try
+	  /*
+	   * Embedded files may be cyphered, and are most often members of an
+	   * archive: they are read (and deciphered) once in memory instead.
+	   *
+	   */
+	  if ( dynamic_cast<OSDL::EmbeddedFile *>( & fontFile ) == 0 )
 	  {
 
-		return Font::FontFileLocator.find( fontFilename ) ;
+		blob->content = mapFontFile( fontPath, blob->size ) ;
+		blob->mapped = ( blob->content != 0 ) ;
 
 	  }
-	  catch( const System::FileLocatorException & ex )
-	  {
 
-		// Not found!
+#endif // OSDL_MAPS_FONT_FILES
 
-		string currentDir ;
+	  if ( blob->content == 0 )
+	  {
 
-		try
-		{
-		  currentDir = Directory::GetCurrentWorkingDirectoryPath() ;
-		}
-		catch( const DirectoryException & exc )
-		{
-		  throw FontException(
-			"TrueTypeFont constructor: unable to load '"
-			+ fontFilename
-			+ "', exception generation triggered another failure: "
-			+ exc.toString() + "." ) ;
-		}
+		buffer = new Ceylan::Byte[ blob->size ] ;
+		fontFile.readExactLength( buffer, blob->size ) ;
 
-		throw FontException( "TrueTypeFont constructor: '"
-		  + fontFilename
-		  + "' is not a regular file or a symbolic link "
-		  "relative to the current directory (" + currentDir
-		  + ") and cannot be found through TrueType font locator ("
-		  + TrueTypeFont::TrueTypeFontFileLocator.toString()
-		  + ") nor through general font locator based on "
-		  "font path environment variable ("
-		  + Font::FontPathEnvironmentVariable + "): "
-		  + Font::FontFileLocator.toString() + "." ) ;
+		blob->content = buffer ;
 
 	  }
+
 	}
-  }
+	catch( ... )
+	{
 
-}
+	  delete & fontFile ;
+	  throw ;
 
+	}
 
+	delete & fontFile ;
 
-string TrueTypeFont::DescribeLastError()
-{
+  }
+  catch( const Ceylan::Exception & e )
+  {
 
-#if OSDL_USES_SDL_TTF
+	if ( buffer != 0 )
+	  delete [] buffer ;
 
-  string error = string( ::TTF_GetError() ) ;
+	delete blob ;
 
-  if ( error.empty() )
-	return "(no SDL_ttf error detected)" ;
-  else
-	return ::TTF_GetError() ;
+	throw FontException( "TrueTypeFont::AcquireFontBlob failed: "
+	  "unable to read '" + fontPath + "': " + e.toString() ) ;
 
-#else // OSDL_USES_SDL_TTF
+  }
 
-  return "(no SDL_ttf support available)" ;
+  FontBlobs[ fontPath ] = blob ;
 
-#endif // OSDL_USES_SDL_TTF
+#if OSDL_DEBUG_FONT
+
+  LogPlug::debug( "TrueTypeFont::AcquireFontBlob: "
+	+ string( blob->mapped ? "mapped" : "read" ) + " "
+	+ Ceylan::toString( static_cast<Ceylan::Uint32>( blob->size ) )
+	+ " bytes from '" + fontPath + "'." ) ;
+
+#endif // OSDL_DEBUG_FONT
+
+  return * blob ;
 
 }
 
 
 
-OSDL::Video::Surface & TrueTypeFont::basicRenderUnicodeGlyph(
-  Ceylan::Unicode character, RenderQuality quality,
-  Pixels::ColorDefinition glyphColor )
+void TrueTypeFont::ReleaseFontBlob( const string & fontPath )
 {
 
-#if OSDL_USES_SDL_TTF
+  FontBlobMap::iterator it = FontBlobs.find( fontPath ) ;
 
-  if ( ! hasContent() )
-	throw FontException( "TrueTypeFont::basicRenderUnicodeGlyph failed: "
-	  "font not loaded" ) ;
+  if ( it == FontBlobs.end() )
+	return ;
 
-  // Render unconditionnally here:
+  FontBlob * blob = (*it).second ;
 
-  SDL_Surface * textSurface ;
-  Surface * res ;
+  blob->referenceCount-- ;
 
-  switch( quality )
-  {
+  if ( blob->referenceCount != 0 )
+	return ;
 
-	/* Apparently TTF_RenderGlyph_Solid may fail and return a null pointer while
-	   not setting any TTF error, ex:
-		 - for Latin-1 character 'o', Unicode 111, with iomanoid.ttf
-		 - for Latin-1 character 'n', Unicode 110, with neurochr.ttf
+#if OSDL_MAPS_FONT_FILES
 
-		 Thus we had to comment out the Solid code, and use the Shaded one
-		 instead:
-	*/
+  if ( blob->mapped )
+	::munmap( const_cast<Ceylan::Byte *>( blob->content ), blob->size ) ;
+  else
+	delete [] blob->content ;
 
-  // case Solid:
+#else // OSDL_MAPS_FONT_FILES
 
-  //	textSurface = ::TTF_RenderGlyph_Solid( _content, character,
-  //	  glyphColor ) ;
+  delete [] blob->content ;
 
-  //	if ( textSurface == 0 )
-  //	  throw FontException(
-  //		"TrueTypeFont::basicRenderUnicodeGlyph (solid): "
-  //		"unable to render character '"
-  //		+ Ceylan::toString( character )
-  //		+ "': " + DescribeLastError() ) ;
+#endif // OSDL_MAPS_FONT_FILES
 
-  //	res = new Surface( *textSurface,
-  //	  /* display type */ Surface::BackBuffer ) ;
+  delete blob ;
 
-  //	// No colorkey added, since already there.
-  //	break ;
+  FontBlobs.erase( it ) ;
 
- case Solid:
- case Shaded:
-	textSurface = ::TTF_RenderGlyph_Shaded( _content, character,
-	  glyphColor, _backgroundColor ) ;
+}
 
-	if ( textSurface == 0 )
-	  throw FontException(
-		"TrueTypeFont::basicRenderUnicodeGlyph (shaded): "
-		"unable to render character '"
-		+ Ceylan::toString( character )
-		+ "': " + DescribeLastError() ) ;
 
-	/*
-	 * We have to create a new surface so that the surface returned by
-	 * '::TTF_RenderGlyph_Shaded' will no more be palettized: we need a color
-	 * key to have transparent blits.
-	 *
-	 */
 
-	ColorMask redMask, greenMask, blueMask ;
-	Pixels::getRecommendedColorMasks( redMask, greenMask, blueMask ) ;
+void TrueTypeFont::AdoptFontContent( const string & fontPath,
+  Ceylan::Byte * content, Ceylan::System::Size size )
+{
 
-	res = new Surface( Surface::Hardware | Surface::ColorkeyBlit,
-	  textSurface->w, textSurface->h, /* bpp */ 32,
-	  redMask, greenMask, blueMask, /* no alpha wanted */ 0 ) ;
+  FontBlobMap::iterator it = FontBlobs.find( fontPath ) ;
 
-	// Avoid messing text color with color key:
-	Pixels::ColorDefinition colorKey ;
+  if ( it != FontBlobs.end() )
+  {
 
-	if ( Pixels::areEqual( glyphColor, Pixels::Black,
-		/* use alpha */ false ) )
-	{
+	delete [] content ;
 
-	  colorKey = Pixels::White ;
-	  res->fill( colorKey ) ;
+	(*it).second->referenceCount++ ;
+	return ;
 
-	}
-	else
-	{
+  }
 
-	  colorKey = Pixels::Black ;
+  FontBlob * blob = new FontBlob() ;
 
-	  /*
-	   * No need to fill 'res' with black, since new RGB surfaces come all black
-	   * already.
-	   *
-	   */
+  blob->content        = content ;
+  blob->size           = size ;
+  blob->mapped         = false ;
+  blob->referenceCount = 1 ;
 
-	}
+  FontBlobs[ fontPath ] = blob ;
 
-	try
-	{
-	  res->setColorKey(
-		Surface::ColorkeyBlit | Surface::RLEColorkeyBlit,
-		Pixels::convertColorDefinitionToPixelColor(
-		  res->getPixelFormat(), colorKey ) ) ;
-	}
-	catch( const Video::VideoException & e )
-	{
+}
 
-	  throw FontException(
-		"TrueTypeFont::basicRenderUnicodeGlyph (shaded): "
-		"color keying failed: " + e.toString() ) ;
 
-	}
-	SDL_BlitSurface( textSurface, 0, & res->getSDLSurface(), 0 ) ;
-	SDL_FreeSurface( textSurface ) ;
-	textSurface = 0 ;
-	break ;
 
+void TrueTypeFont::ReleaseFontContent( const string & fontPath )
+{
 
-  case Blended:
-	textSurface = ::TTF_RenderGlyph_Blended( _content, character,
-	  glyphColor ) ;
+  ReleaseFontBlob( fontPath ) ;
 
-	if ( textSurface == 0 )
-	  throw FontException(
-		"TrueTypeFont::basicRenderUnicodeGlyph (blended): "
-		"unable to render character '"
-		+ Ceylan::toString( character )
-		+ "': " + DescribeLastError() ) ;
+}
 
-	res = new Surface( *textSurface,
-	  /* display type */ Surface::BackBuffer ) ;
 
-	// No color key enforced.
 
-	break ;
+LowLevelTTFFont & TrueTypeFont::openBackendFont( PointSize pointSize )
+{
 
+#if OSDL_USES_SDL_TTF
 
-  default:
-	throw FontException( "TrueTypeFont::basicRenderUnicodeGlyph: "
-	  "unknown quality requested: "
-	  + Ceylan::toString( quality ) + "." ) ;
-	break ;
+  if ( ::TTF_WasInit() == 0 )
+  {
+
+	if ( ::TTF_Init()== -1 )
+	  throw FontException(
+		"TrueTypeFont::openBackendFont: unable to init font library: "
+		+ DescribeLastError() ) ;
 
   }
 
+  // The file is read (or mapped) only once for all instances:
+  FontBlob & blob = AcquireFontBlob( _contentPath ) ;
 
-  if ( _convertToDisplay )
+  /*
+   * The memory stream does not own the blob, which is thus kept as long as
+   * this instance uses it:
+   *
+   */
+  LowLevelTTFFont * res = ::TTF_OpenFontRW(
+	::SDL_RWFromConstMem( blob.content, static_cast<int>( blob.size ) ),
+	/* automatic free source */ true, pointSize ) ;
+
+  if ( res == 0 )
   {
 
-	/*
-	 * We want to keep our colorkey (if any), so we choose to add alpha only if
-	 * no colorkey is used.
-	 *
-	 * Surface will be RLE encoded here:
-	 *
-	 */
-	if ( quality == Blended )
-	  res->convertToDisplay( /* alphaChannelWanted */ true ) ;
-	else
-	  res->convertToDisplay( /* alphaChannelWanted */ false ) ;
+	ReleaseFontBlob( _contentPath ) ;
+
+	throw FontException( "TrueTypeFont::openBackendFont: unable to open '"
+	  + _contentPath + "' with a point size of "
+	  + Ceylan::toString( pointSize ) + " dots per inch: "
+	  + DescribeLastError() ) ;
 
   }
 
-  // Uncomment next line to debug character bounding-box:
-  //res->drawEdges() ;
+  // Any opened instance prevents the back-end from being stopped:
+  FontCounter++ ;
 
   return * res ;
 
 #else // OSDL_USES_SDL_TTF
 
-  throw FontException( "TrueTypeFont::basicRenderUnicodeGlyph failed: "
+  throw FontException( "TrueTypeFont::openBackendFont failed: "
 	"no SDL_ttf support available" ) ;
 
 #endif // OSDL_USES_SDL_TTF
 
 }
+
+
+
+void TrueTypeFont::closeBackendFont( LowLevelTTFFont * & font )
+{
+
+#if OSDL_USES_SDL_TTF
+
+  if ( font == 0 )
+	return ;
+
+  ::TTF_CloseFont( font ) ;
+  font = 0 ;
+
+  ReleaseFontBlob( _contentPath ) ;
+
+  FontCounter-- ;
+
+  if ( FontCounter == 0 && ::TTF_WasInit() != 0 )
+	::TTF_Quit() ;
+
+#endif // OSDL_USES_SDL_TTF
+
+}
@@ -30,12 +30,15 @@
 
 
 #include "OSDLFont.h"           // for inheritance
+#include "OSDLWorkerPool.h"     // for WorkerPool, Job
 
 
 #include "Ceylan.h"             // for LoadableWithContent
 
 
 #include <string>
+#include <list>
+#include <map>
 
 #if ! defined(OSDL_USES_SDL_TTF) || OSDL_USES_SDL_TTF
 
@@ -578,7 +581,11 @@ namespace OSDL
 			 * Returns a rectangular bounding box corresponding to the rendering
 			 * of specified text, encoded in Latin-1.
 			 *
-			 * Correct kerning is done to get the actual width.
+			 * The width is computed from the precomputed glyph metrics and
+			 * kerning pairs, with no call to the font backend, unless the
+			 * backend kerns without exposing its kerning pairs (SDL_ttf
+			 * older than 2.0.14), in which case it sizes the text itself.
+			 * Either way the width matches the one of the rendered text.
 			 *
 			 * The height returned is the same as you can get using the
 			 * getHeight method.
@@ -608,8 +615,14 @@ namespace OSDL
 			 * Returns a rectangular bounding box corresponding to the rendering
 			 * of specified text, encoded in UTF-8.
 			 *
-			 * Correct kerning is done to get the actual width.  The height
-			 * returned is the same as you can get using the getHeight method.
+			 * The width is computed from the precomputed glyph metrics and
+			 * kerning pairs, with no call to the font backend, unless the
+			 * backend kerns without exposing its kerning pairs (SDL_ttf
+			 * older than 2.0.14), in which case it sizes the text itself.
+			 * Either way the width matches the one of the rendered text.
+			 *
+			 * The height returned is the same as you can get using the
+			 * getHeight method.
 			 *
 			 * The upright rectangle has its lower left corner set to the
 			 * origin.
@@ -636,8 +649,14 @@ namespace OSDL
 			 * Returns a rectangular bounding box corresponding to the rendering
 			 * of specified text, encoded in Unicode.
 			 *
-			 * Correct kerning is done to get the actual width.  The height
-			 * returned is the same as you can get using the getHeight method.
+			 * The width is computed from the precomputed glyph metrics and
+			 * kerning pairs, with no call to the font backend, unless the
+			 * backend kerns without exposing its kerning pairs (SDL_ttf
+			 * older than 2.0.14), in which case it sizes the text itself.
+			 * Either way the width matches the one of the rendered text.
+			 *
+			 * The height returned is the same as you can get using the
+			 * getHeight method.
 			 *
 			 * The upright rectangle has its lower left corner set to the
 			 * origin.
@@ -853,6 +872,222 @@ namespace OSDL
 
 
 
+			// Distance field section.
+
+
+
+			/**
+			 * Switches this font to, or from, the signed distance field (SDF)
+			 * glyph mode.
+			 *
+			 * In this mode, each glyph is rasterized only once, at the
+			 * specified reference point size, and converted into a distance
+			 * field, i.e. an 8-bit map telling for each texel how far it lies
+			 * from the glyph outline (inside values being above 128, outside
+			 * ones below).
+			 *
+			 * Any point size can then be obtained from that single field thanks
+			 * to a software sampling kernel, see renderUnicodeGlyphAtSize and
+			 * renderLatin1TextAtSize, so that the memory used by this font
+			 * does not depend on the number of sizes being displayed.
+			 *
+			 * @param enabled tells whether the distance field mode should be
+			 * used. Disabling it releases all generated fields.
+			 *
+			 * @param referencePointSize the point size at which glyphs are
+			 * rasterized before being converted. Larger sizes lead to sharper
+			 * results when magnifying, at the expense of memory. Changing the
+			 * reference size of an already enabled mode flushes the fields.
+			 *
+			 * @note This mode does not depend on the current point size of
+			 * this font (see setPointSize), nor on its being loaded: the
+			 * regular rendering methods are left unchanged.
+			 *
+			 * @throw FontException if the operation failed.
+			 *
+			 */
+			virtual void setDistanceFieldMode( bool enabled,
+			  PointSize referencePointSize = DefaultDistanceFieldPointSize ) ;
+
+
+
+			/**
+			 * Returns true iff this font is in signed distance field mode.
+			 *
+			 */
+			virtual bool isInDistanceFieldMode() const ;
+
+
+
+			/**
+			 * Returns the total size, in bytes, of the distance fields
+			 * generated so far for this font.
+			 *
+			 */
+			virtual Ceylan::System::Size getDistanceFieldSize() const ;
+
+
+
+			/**
+			 * Renders specified glyph (Unicode character) in specified color,
+			 * at specified point size, based on its distance field.
+			 *
+			 * The field of this glyph is generated on first use, then kept
+			 * for all later renderings, whatever their size.
+			 *
+			 * The returned surface is a 32-bit one with an alpha channel, the
+			 * same way as with the Blended quality, and it is to be placed as
+			 * glyphs returned by renderUnicodeGlyph are (i.e. its upper-left
+			 * corner corresponds to the width offset and height above baseline
+			 * of the glyph, scaled accordingly).
+			 *
+			 * The caller is responsible for deleting the returned surface.
+			 *
+			 * @param character the character, encoded in Unicode, to render.
+			 *
+			 * @param targetPointSize the point size the glyph should be
+			 * rendered at.
+			 *
+			 * @param glyphColor the color definition for the glyph.
+			 *
+			 * @return a newly allocated Surface, whose ownership is transferred
+			 * to the caller.
+			 *
+			 * @throw FontException on error, including if the distance field
+			 * mode is not enabled, or if the point size is null.
+			 *
+			 */
+			virtual Surface & renderUnicodeGlyphAtSize(
+			  Ceylan::Unicode character,
+			  PointSize targetPointSize,
+			  Pixels::ColorDefinition glyphColor = Pixels::White ) ;
+
+
+
+			/**
+			 * Renders specified text, encoded in Latin-1, in specified color,
+			 * at specified point size, based on the distance fields of its
+			 * glyphs.
+			 *
+			 * The layout of the text follows the one of the regular rendering
+			 * (advances and ascent of the reference size, scaled to the target
+			 * one), all glyphs being sampled directly in the returned surface.
+			 *
+			 * The caller is responsible for deleting the returned surface.
+			 *
+			 * @param text the text, encoded in Latin-1, to render.
+			 *
+			 * @param targetPointSize the point size the text should be
+			 * rendered at.
+			 *
+			 * @param textColor the color definition for the text.
+			 *
+			 * @return a newly allocated 32-bit Surface with an alpha channel,
+			 * whose ownership is transferred to the caller.
+			 *
+			 * @throw FontException on error, including if the distance field
+			 * mode is not enabled, or if the point size is null.
+			 *
+			 */
+			virtual Surface & renderLatin1TextAtSize(
+			  const std::string & text,
+			  PointSize targetPointSize,
+			  Pixels::ColorDefinition textColor = Pixels::White ) ;
+
+
+
+
+			// Prewarming section.
+
+
+
+			/**
+			 * Requests the specified glyphs (Latin-1 characters) to be
+			 * rendered in the background, so that their later renderings,
+			 * with the same quality and color, are glyph cache hits.
+			 *
+			 * This method returns immediately: the glyphs are rendered by a
+			 * worker thread, through a backend font instance dedicated to
+			 * prewarming (so that regular renderings can go on meanwhile),
+			 * then they are handed over to the glyph cache by the thread
+			 * using this font, as soon as it calls integratePrewarmedGlyphs
+			 * (ex: once per frame), isPrewarmingDone or waitForPrewarming.
+			 *
+			 * Typically used by loading screens, to warm the cache up
+			 * before the glyphs are actually needed.
+			 *
+			 * @param glyphs the set of characters to render; duplicates are
+			 * rendered only once.
+			 *
+			 * @param quality the rendering quality to prepare.
+			 *
+			 * @param glyphColor the glyph color to prepare.
+			 *
+			 * @throw FontException if the font is not loaded, if it is not
+			 * glyph-cached, or if the request could not be submitted.
+			 *
+			 * @note Unloading this font, including when changing its point
+			 * size, waits for the prewarming requests and drops their
+			 * results.
+			 *
+			 */
+			virtual void prewarmLatin1Glyphs( const std::string & glyphs,
+			  RenderQuality quality = Solid,
+			  Pixels::ColorDefinition glyphColor = Pixels::White ) ;
+
+
+
+			/**
+			 * Requests all the glyphs needed by the specified texts (encoded
+			 * in Latin-1) to be rendered in the background.
+			 *
+			 * @see prewarmLatin1Glyphs
+			 *
+			 * @throw FontException if the operation failed.
+			 *
+			 */
+			virtual void prewarmLatin1Texts(
+			  const std::list<std::string> & texts,
+			  RenderQuality quality = Solid,
+			  Pixels::ColorDefinition glyphColor = Pixels::White ) ;
+
+
+
+			/**
+			 * Hands over to the glyph cache the glyphs whose background
+			 * rendering is over, without blocking.
+			 *
+			 * @return the number of glyphs added to the cache.
+			 *
+			 */
+			virtual Ceylan::Uint32 integratePrewarmedGlyphs() ;
+
+
+
+			/**
+			 * Returns true iff all prewarming requests have been completed
+			 * (polling); integrates as well the glyphs already rendered.
+			 *
+			 */
+			virtual bool isPrewarmingDone() ;
+
+
+
+			/**
+			 * Blocks until all prewarming requests have been completed, or
+			 * until the timeout expires, then integrates the rendered glyphs.
+			 *
+			 * @param timeout the maximum duration to wait, in milliseconds.
+			 *
+			 * @return true iff all requests have been completed.
+			 *
+			 */
+			virtual bool waitForPrewarming(
+			  Ceylan::Uint32 timeout = OSDL::WorkerPool::WaitIndefinitely ) ;
+
+
+
+
 			/**
 			 * Returns an user-friendly description of the state of this object.
 			 *
@@ -937,6 +1172,39 @@ namespace OSDL
 			static std::string FindPathFor( const std::string & fontFilename ) ;
 
 
+
+			/**
+			 * Installs the specified content, read beforehand from the
+			 * specified font file by other means (ex: by a prefetching
+			 * worker), as the content shared by the fonts opened from that
+			 * file, and records one user of it, so that it remains available
+			 * until ReleaseFontContent is called.
+			 *
+			 * If a content is already shared for that file, one more user of
+			 * it is recorded and the specified content is deallocated.
+			 *
+			 * @param fontPath the path of the font file, as it will be given
+			 * to the TrueTypeFont constructor.
+			 *
+			 * @param content the content of that file, allocated with new [],
+			 * whose ownership is taken.
+			 *
+			 * @param size the size of this content, in bytes.
+			 *
+			 */
+			static void AdoptFontContent( const std::string & fontPath,
+			  Ceylan::Byte * content, Ceylan::System::Size size ) ;
+
+
+
+			/**
+			 * Records one less user of the content shared for the specified
+			 * font file, as recorded by AdoptFontContent.
+			 *
+			 */
+			static void ReleaseFontContent( const std::string & fontPath ) ;
+
+
 			/**
 			 * The default point size all TrueType font will be created with.
 			 *
@@ -970,6 +1238,25 @@ namespace OSDL
 
 
 
+			/**
+			 * The default reference point size at which glyphs are rasterized
+			 * in signed distance field mode.
+			 *
+			 */
+			static PointSize DefaultDistanceFieldPointSize ;
+
+
+
+			/**
+			 * The spread, in pixels at the reference point size, of distance
+			 * fields: distances are clamped to it, and fields are padded by it
+			 * on each side of their glyph.
+			 *
+			 */
+			static const Length DistanceFieldSpread ;
+
+
+
 
 
 		  protected:
@@ -1000,6 +1287,242 @@ namespace OSDL
 
 
 
+			/**
+			 * Converts the specified backend rendering of a glyph into a
+			 * surface, enforcing colorkeys and conversion to display, as
+			 * basicRenderUnicodeGlyph does.
+			 *
+			 * @param renderedGlyph the backend rendering, whose ownership is
+			 * taken by this method.
+			 *
+			 * @param quality the quality the glyph was rendered with.
+			 *
+			 * @param glyphColor the color the glyph was rendered with.
+			 *
+			 * @throw FontException if the operation failed.
+			 *
+			 */
+			virtual Surface & createGlyphSurfaceFrom(
+			  LowLevelSurface & renderedGlyph,
+			  RenderQuality quality,
+			  Pixels::ColorDefinition glyphColor ) ;
+
+
+
+			/**
+			 * Opens a new backend instance of this font, at the specified
+			 * point size, taking it into account in the font counter.
+			 *
+			 * @throw FontException if the operation failed.
+			 *
+			 */
+			LowLevelTTFFont & openBackendFont( PointSize pointSize ) ;
+
+
+
+			/**
+			 * Closes the specified backend instance, if any, and sets it to
+			 * null.
+			 *
+			 */
+			void closeBackendFont( LowLevelTTFFont * & font ) ;
+
+
+
+			/**
+			 * Describes the in-memory content of a font file, shared by all
+			 * the backend instances opened from it, whatever their point
+			 * size and their TrueTypeFont owner.
+			 *
+			 */
+			struct FontBlob ;
+
+
+			/// Stores the shared font contents, by font path.
+			typedef std::map<std::string, FontBlob *> FontBlobMap ;
+
+
+
+			/**
+			 * Returns the shared content of the specified font file, and
+			 * records one more user of it.
+			 *
+			 * The file is read (and deciphered, for embedded files) only if
+			 * no content is shared for it yet. Files from the standard
+			 * filesystem are memory-mapped when possible.
+			 *
+			 * @throw FontException if the file could not be read.
+			 *
+			 */
+			static FontBlob & AcquireFontBlob( const std::string & fontPath ) ;
+
+
+
+			/**
+			 * Records one less user of the shared content of the specified
+			 * font file, deallocating it when no more used.
+			 *
+			 */
+			static void ReleaseFontBlob( const std::string & fontPath ) ;
+
+
+
+			/// Metrics of a glyph, as reported by the font backend.
+			struct GlyphMetrics
+			{
+
+			  /// Abscissa of the left edge of the glyph, from the pen.
+			  SignedWidth minX ;
+
+			  /// Abscissa of the right edge of the glyph, from the pen.
+			  SignedWidth maxX ;
+
+			  /// Ordinate of the bottom edge of the glyph, from the baseline.
+			  SignedHeight minY ;
+
+			  /// Ordinate of the top edge of the glyph, from the baseline.
+			  SignedHeight maxY ;
+
+			  /// Horizontal offset to the pen position of the next glyph.
+			  SignedWidth advance ;
+
+			  /// Tells whether the backend could provide these metrics.
+			  bool available ;
+
+			} ;
+
+
+
+			/**
+			 * Returns the metrics of the specified glyph, loading first, if
+			 * needed, the metrics of the whole page of 256 code points it
+			 * belongs to.
+			 *
+			 * The font must be loaded.
+			 *
+			 * @throw FontException if the metrics of this glyph are not
+			 * available.
+			 *
+			 */
+			const GlyphMetrics & getMetricsFor( Ceylan::Unicode glyph ) const ;
+
+
+
+			/**
+			 * Loads from the backend the metrics of all the glyphs of the
+			 * specified page (code points from 256*page to 256*page+255).
+			 *
+			 */
+			void loadMetricsPage( Ceylan::Uint8 page ) const ;
+
+
+
+			/// Deallocates all the glyph metrics and kernings loaded so far.
+			void clearMetrics() ;
+
+
+
+			/**
+			 * Tells whether the extent of a text can be computed from the
+			 * glyph metrics and kerning pairs, rather than by the backend.
+			 *
+			 * It is the case if the backend exposes its kerning pairs, or
+			 * if kerning is disabled.
+			 *
+			 */
+			bool isSizedByTables() const ;
+
+
+
+			/**
+			 * Returns the horizontal offset applied by the backend between
+			 * the two specified glyphs, zero if kerning is disabled or if
+			 * there is no previous glyph (null character).
+			 *
+			 * Latin-1 pairs are precomputed, by rows of the previous glyph.
+			 *
+			 */
+			SignedLength getKerningFor( Ceylan::Unicode previous,
+			  Ceylan::Unicode glyph ) const ;
+
+
+
+			/**
+			 * Extends the horizontal extent of a line being measured with
+			 * the specified glyph, as the backend would do.
+			 *
+			 * @param glyph the next glyph of the line.
+			 *
+			 * @param previous the previous glyph of the line (null character
+			 * if none), updated by this method.
+			 *
+			 * @param penX the pen abscissa, updated by this method.
+			 *
+			 * @param minX the leftmost abscissa reached so far.
+			 *
+			 * @param maxX the rightmost abscissa reached so far.
+			 *
+			 */
+			void extendLineWith( Ceylan::Unicode glyph,
+			  Ceylan::Unicode & previous, SignedLength & penX,
+			  SignedLength & minX, SignedLength & maxX ) const ;
+
+
+
+			/**
+			 * Waits for all prewarming requests, drops their results, and
+			 * releases the prewarming resources.
+			 *
+			 */
+			void stopPrewarming() ;
+
+
+
+			/// Describes the distance field of a glyph.
+			struct DistanceFieldGlyph ;
+
+
+			/// Stores the distance fields generated so far, by character.
+			typedef std::map<Ceylan::Unicode, DistanceFieldGlyph *>
+			  DistanceFieldMap ;
+
+
+
+			/**
+			 * Returns the distance field of the specified glyph, generating
+			 * it first if needed.
+			 *
+			 * The distance field mode must be enabled.
+			 *
+			 * @throw FontException if the field could not be generated.
+			 *
+			 */
+			const DistanceFieldGlyph & getDistanceFieldFor(
+			  Ceylan::Unicode character ) ;
+
+
+
+			/**
+			 * Opens the font used to generate distance fields, at the
+			 * reference point size, and records its metrics.
+			 *
+			 * @throw FontException if the operation failed.
+			 *
+			 */
+			void openReferenceFont() ;
+
+
+
+			/// Closes the reference font, if opened.
+			void closeReferenceFont() ;
+
+
+
+			/// Deallocates all distance fields, and leaves that mode.
+			void clearDistanceFields() ;
+
+
+
 
 			// Font filename is not kept currently.
 
@@ -1008,6 +1531,92 @@ namespace OSDL
 			PointSize _pointSize ;
 
 
+			/**
+			 * The glyph metrics loaded so far, by page of 256 code points
+			 * (indexed by the high byte of a code point), so that a metric
+			 * lookup is a mere array access.
+			 *
+			 * The first page (Latin-1) is loaded with the font, the others
+			 * on demand; pages are dropped when the font is unloaded or when
+			 * its rendering style changes.
+			 *
+			 */
+			mutable GlyphMetrics * _metricsPages[256] ;
+
+
+			/**
+			 * The kerning offsets between Latin-1 glyphs computed so far,
+			 * indexed by the previous glyph then by the next one; a row is
+			 * computed on first use, and dropped with the glyph metrics.
+			 *
+			 */
+			mutable SignedWidth * _kerningRows[256] ;
+
+
+			/// The height of the font, as recorded when loaded.
+			Height _fontHeight ;
+
+
+			/**
+			 * The font from which distance fields are generated (if in that
+			 * mode), opened at the reference point size.
+			 *
+			 */
+			LowLevelTTFFont * _referenceFont ;
+
+
+			/// The point size at which distance fields are generated.
+			PointSize _referencePointSize ;
+
+
+			/// The ascent of the font, at the reference point size.
+			SignedHeight _referenceAscent ;
+
+
+			/// The descent of the font, at the reference point size.
+			SignedHeight _referenceDescent ;
+
+
+			/// The line skip of the font, at the reference point size.
+			Height _referenceLineSkip ;
+
+
+			/**
+			 * The distance fields generated so far, if in distance field mode,
+			 * otherwise null.
+			 *
+			 */
+			DistanceFieldMap * _distanceFields ;
+
+
+			/**
+			 * The backend font instance used by the prewarming worker, if
+			 * any.
+			 *
+			 */
+			LowLevelTTFFont * _prewarmingFont ;
+
+
+			/// The pool whose worker renders prewarmed glyphs, if any.
+			OSDL::WorkerPool * _prewarmingPool ;
+
+
+			/*
+			 * Takes care of the awful issue of Windows DLL with templates.
+			 *
+			 * @see Ceylan's developer guide and README-build-for-windows.txt
+			 * to understand it, and to be aware of the associated risks.
+			 *
+			 */
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+
+			/// The prewarming requests not integrated yet, in order.
+			std::list<OSDL::Job *> _prewarmingJobs ;
+
+#pragma warning( pop )
+
+
 			/**
 			 * The actual TTF font (LowLevelTTFFont) is kept in the _content
 			 * attribute inherited from the template.
@@ -1024,6 +1633,27 @@ namespace OSDL
 
 
 
+			/*
+			 * Takes care of the awful issue of Windows DLL with templates.
+			 *
+			 * @see Ceylan's developer guide and README-build-for-windows.txt
+			 * to understand it, and to be aware of the associated risks.
+			 *
+			 */
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+
+			/**
+			 * The font contents shared by the backend instances currently
+			 * opened, by font path.
+			 *
+			 */
+			static FontBlobMap FontBlobs ;
+
+#pragma warning( pop )
+
+
+
 
 		  private:
 
@@ -37,13 +37,16 @@
  *
  */
  
+#include "OSDLAsyncImageLoader.h"
 #include "OSDLBackBufferedWidget.h"
 #include "OSDLBezier.h"
 #include "OSDLConic.h"
 #include "OSDLFixedFont.h"
 #include "OSDLFont.h"
+#include "OSDLFontRenderCache.h"
 #include "OSDLGLTexture.h"
 #include "OSDLImage.h"
+#include "OSDLImageAtlas.h"
 #include "OSDLLine.h"
 #include "OSDLMouseCursor.h"
 #include "OSDLPoint2D.h"
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDL.h"
+using namespace OSDL ;
+
+using namespace Ceylan::Log ;
+using namespace Ceylan::System ;
+
+using namespace std ;
+
+
+#include <string>
+
+
+
+// No mmap on Windows, nor on the DS:
+#if ! defined(OSDL_RUNS_ON_WINDOWS) && ! OSDL_ARCH_NINTENDO_DS
+const bool SpansAreMapped = true ;
+#else // ! defined(OSDL_RUNS_ON_WINDOWS) && ! OSDL_ARCH_NINTENDO_DS
+const bool SpansAreMapped = false ;
+#endif // ! defined(OSDL_RUNS_ON_WINDOWS) && ! OSDL_ARCH_NINTENDO_DS
+
+
+
+/// Checks that the span of the specified file holds the expected content.
+void CheckSpan( const string & filename, const string & expected )
+{
+
+  ContentSpan span( filename ) ;
+
+  LogPlug::info( span.toString() ) ;
+
+  if ( span.getSize() != expected.size()
+	  || string( reinterpret_cast<const char *>( span.getData() ),
+		span.getSize() ) != expected )
+	throw TestException( "Wrong content spanned for '" + filename + "'." ) ;
+
+  if ( span.isMapped() != SpansAreMapped )
+	throw TestException( "Content of '" + filename + "' "
+	  + ( SpansAreMapped ? "not mapped." : "unexpectedly mapped." ) ) ;
+
+}
+
+
+
+/**
+ * Test of the content spans provided by the OSDL basic module.
+ *
+ * @note A standard file, then an uncyphered embedded file found in a mounted
+ * directory (the write directory) are spanned: both must be mapped, and their
+ * bytes must match the ones written.
+ *
+ */
+int main( int argc, char * argv[] )
+{
+
+  {
+
+	LogHolder myLog( argc, argv ) ;
+
+
+	try
+	{
+
+	  LogPlug::info( "Testing OSDL content spans." ) ;
+
+	  const string filename = "testOSDLContentSpan.dat" ;
+
+	  const string content = "Spanned content, from the very first byte "
+		"to the very last one." ;
+
+
+	  LogPlug::info( "Spanning standard file '" + filename + "'." ) ;
+
+	  File & standardFile = File::Create( filename ) ;
+	  standardFile.write( content ) ;
+	  delete & standardFile ;
+
+	  CheckSpan( filename, content ) ;
+
+	  File::Remove( filename ) ;
+
+
+	  LogPlug::info( "Spanning uncyphered embedded file '" + filename
+		+ "'." ) ;
+
+	  // No need to start general OSDL services:
+	  EmbeddedFileSystemManager & myFSManager =
+		EmbeddedFileSystemManager::GetEmbeddedFileSystemManager(
+		  /* cypher */ false ) ;
+
+	  myFSManager.chooseBasicSettings( /* organization name */ "OSDL",
+		/* application name */ "testOSDLContentSpan" ) ;
+
+	  File & embeddedFile = myFSManager.createFile( filename ) ;
+	  embeddedFile.write( content ) ;
+	  delete & embeddedFile ;
+
+	  // Spans open their file through the default filesystem manager:
+	  FileSystemManager::SetDefaultFileSystemManager( myFSManager,
+		/* deallocatePreviousIfAny */ false ) ;
+
+	  CheckSpan( filename, content ) ;
+
+	  FileSystemManager::SetDefaultFileSystemManagerToPlatformDefault() ;
+
+	  myFSManager.removeFile( filename ) ;
+
+	  delete & myFSManager ;
+
+	  LogPlug::info( "End of OSDL content span test." ) ;
+
+
+	}
+
+	catch ( const OSDL::Exception & e )
+	{
+
+	  LogPlug::error( "OSDL exception caught: "
+		+ e.toString( Ceylan::high ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const Ceylan::Exception & e )
+	{
+
+	  LogPlug::error( "Ceylan exception caught: "
+		+ e.toString( Ceylan::high ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const std::exception & e )
+	{
+
+	  LogPlug::error( "Standard exception caught: "
+		+ std::string( e.what() ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( ... )
+	{
+
+	  LogPlug::error( "Unknown exception caught" ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+  }
+
+  OSDL::shutdown() ;
+
+  return Ceylan::ExitSuccess ;
+
+}
@@ -34,6 +34,64 @@ using namespace std ;
 
 
 
+/**
+ * Creates, in the standard filesystem, the specified element to mount: a
+ * directory with a 'common' subdirectory containing a file of specified name,
+ * and a 'shared.txt' file, names being encoded as in the virtual tree.
+ *
+ */
+void CreateTreeElement( FileSystemManager & standardManager,
+  const string & element, const string & ownName )
+{
+
+  delete & standardManager.createDirectory( element ) ;
+
+  string commonPath = standardManager.joinPath( element,
+	Ceylan::encodeToROT13( "common" ) ) ;
+
+  delete & standardManager.createDirectory( commonPath ) ;
+
+  File & ownFile = standardManager.createFile( standardManager.joinPath(
+	  commonPath, Ceylan::encodeToROT13( ownName ) ) ) ;
+
+  ownFile.write( "Read from " + element + "." ) ;
+
+  delete & ownFile ;
+
+  File & sharedFile = standardManager.createFile( standardManager.joinPath(
+	  element, Ceylan::encodeToROT13( "shared.txt" ) ) ) ;
+
+  sharedFile.write( "Read from " + element + "." ) ;
+
+  delete & sharedFile ;
+
+}
+
+
+
+/**
+ * Checks that the index of the virtual tree knows the specified entry (whose
+ * path is not encoded yet) as expected.
+ *
+ */
+void CheckIndexedEntry( EmbeddedFileSystemManager & manager,
+  const string & entryPath,
+  EmbeddedFileSystemManager::IndexedEntryKind expected )
+{
+
+  EmbeddedFileSystemManager::IndexedEntryKind kind =
+	manager.lookupIndexedEntry( Ceylan::encodeToROT13( entryPath ) ) ;
+
+  if ( kind != expected )
+	throw TestException( "Entry '" + entryPath + "' is indexed as "
+	  + Ceylan::toString( static_cast<Ceylan::Uint32>( kind ) )
+	  + " instead of "
+	  + Ceylan::toString( static_cast<Ceylan::Uint32>( expected ) ) + "." ) ;
+
+}
+
+
+
 /**
  * Test of the embedded filesystem layer provided by the OSDL basic module.
  *
@@ -167,6 +225,176 @@ int main( int argc, char * argv[] )
 	  delete & myOtherFile ;
 
 
+	  LogPlug::info( "Checking and benchmarking the cyphering kernels "
+		"against the byte-per-byte transformation." ) ;
+
+	  const Ceylan::Byte XORByte = EmbeddedFileSystemManager::GetXORByte() ;
+
+	  // Odd size and offset, to exercise the unaligned heads and tails:
+	  const Size BenchSize = 8 * 1024 * 1024 + 13 ;
+
+	  Ceylan::Byte * benchBuffer = new Ceylan::Byte[BenchSize + 1] ;
+	  Ceylan::Byte * clearBuffer = benchBuffer + 1 ;
+
+	  for ( Size i = 0; i < BenchSize; i++ )
+		clearBuffer[i] = static_cast<Ceylan::Byte>( ( i * 31 ) ^ ( i >> 9 ) ) ;
+
+	  EmbeddedFile::CypherBuffer( clearBuffer, BenchSize ) ;
+
+	  for ( Size i = 0; i < BenchSize; i++ )
+	  {
+
+		Ceylan::Byte expected = static_cast<Ceylan::Byte>(
+		  ( static_cast<Ceylan::Byte>( ( i * 31 ) ^ ( i >> 9 ) ) ^ XORByte )
+		  + 117 ) ;
+
+		if ( clearBuffer[i] != expected )
+		  throw TestException( "CypherBuffer produced a wrong byte at offset "
+			+ Ceylan::toString( i ) + "." ) ;
+
+	  }
+
+	  const Ceylan::Uint32 BenchRounds = 16 ;
+
+	  Second startSecond, stopSecond ;
+	  Microsecond startMicrosecond, stopMicrosecond ;
+
+	  getPreciseTime( startSecond, startMicrosecond ) ;
+
+	  // Decyphering and cyphering back, round after round:
+	  for ( Ceylan::Uint32 r = 0; r < BenchRounds; r++ )
+	  {
+
+		EmbeddedFile::DecypherBuffer( clearBuffer, BenchSize ) ;
+		EmbeddedFile::CypherBuffer( clearBuffer, BenchSize ) ;
+
+	  }
+
+	  getPreciseTime( stopSecond, stopMicrosecond ) ;
+
+	  Microsecond kernelDuration = getDurationBetween( startSecond,
+		startMicrosecond, stopSecond, stopMicrosecond ) ;
+
+	  EmbeddedFile::DecypherBuffer( clearBuffer, BenchSize ) ;
+
+	  for ( Size i = 0; i < BenchSize; i++ )
+		if ( clearBuffer[i] !=
+			static_cast<Ceylan::Byte>( ( i * 31 ) ^ ( i >> 9 ) ) )
+		  throw TestException( "DecypherBuffer produced a wrong byte at "
+			"offset " + Ceylan::toString( i ) + "." ) ;
+
+	  getPreciseTime( startSecond, startMicrosecond ) ;
+
+	  // The former implementation, as a reference:
+	  for ( Ceylan::Uint32 r = 0; r < BenchRounds; r++ )
+	  {
+
+		for ( Size i = 0; i < BenchSize; i++ )
+		  clearBuffer[i] = ( clearBuffer[i] - 117 ) ^ XORByte ;
+
+		for ( Size i = 0; i < BenchSize; i++ )
+		  clearBuffer[i] = ( clearBuffer[i] ^ XORByte ) + 117 ;
+
+	  }
+
+	  getPreciseTime( stopSecond, stopMicrosecond ) ;
+
+	  Microsecond referenceDuration = getDurationBetween( startSecond,
+		startMicrosecond, stopSecond, stopMicrosecond ) ;
+
+	  delete [] benchBuffer ;
+
+	  // In megabytes per second, each round processing the buffer twice:
+	  Ceylan::Float64 processedMegabytes =
+		2.0 * BenchRounds * BenchSize / ( 1024 * 1024 ) ;
+
+	  LogPlug::info( "Cyphering throughput: "
+		+ Ceylan::toString( processedMegabytes * 1000000
+		  / ( kernelDuration + 1 ), /* precision */ 1 )
+		+ " MB/s, versus "
+		+ Ceylan::toString( processedMegabytes * 1000000
+		  / ( referenceDuration + 1 ), /* precision */ 1 )
+		+ " MB/s byte per byte." ) ;
+
+
+	  LogPlug::info( "Testing the index of the virtual tree, "
+		"as elements are mounted and unmounted." ) ;
+
+	  FileSystemManager & standardManager =
+		StandardFileSystemManager::GetStandardFileSystemManager() ;
+
+	  const string firstElement  = "test-tree-index-first" ;
+	  const string secondElement = "test-tree-index-second" ;
+
+	  CreateTreeElement( standardManager, firstElement, "first.txt" ) ;
+	  CreateTreeElement( standardManager, secondElement, "second.txt" ) ;
+
+	  // The writes above made the index out of date:
+	  myFSManager.refreshTreeIndex() ;
+
+	  const string mountPoint = Ceylan::encodeToROT13( "tree-index" ) ;
+
+	  myFSManager.mount( firstElement, mountPoint ) ;
+
+	  CheckIndexedEntry( myFSManager, "tree-index",
+		EmbeddedFileSystemManager::IndexedDirectory ) ;
+
+	  CheckIndexedEntry( myFSManager, "tree-index/common",
+		EmbeddedFileSystemManager::IndexedDirectory ) ;
+
+	  CheckIndexedEntry( myFSManager, "tree-index/common/first.txt",
+		EmbeddedFileSystemManager::IndexedFile ) ;
+
+	  CheckIndexedEntry( myFSManager, "tree-index/common/second.txt",
+		EmbeddedFileSystemManager::NoEntry ) ;
+
+	  // Put first in the search path, it overrides the entries of the first:
+	  myFSManager.mount( secondElement, mountPoint, /* append */ false ) ;
+
+	  list<string> commonEntries ;
+
+	  if ( ! myFSManager.getIndexedEntries(
+		  Ceylan::encodeToROT13( "tree-index/common" ), commonEntries ) )
+		throw TestException( "Index not available after a mount." ) ;
+
+	  // Sorted as by PhysicsFS, i.e. according to their encoded names:
+	  list<string> expectedEntries ;
+	  expectedEntries.push_back( Ceylan::encodeToROT13( "second.txt" ) ) ;
+	  expectedEntries.push_back( Ceylan::encodeToROT13( "first.txt" ) ) ;
+
+	  if ( commonEntries != expectedEntries )
+		throw TestException( "Unexpected indexed entries: "
+		  + Ceylan::formatStringList( commonEntries ) ) ;
+
+	  if ( myFSManager.getActualLocationFor( "tree-index/shared.txt" )
+		  != secondElement )
+		throw TestException( "Shared entry not read from the element "
+		  "put first in the search path." ) ;
+
+	  myFSManager.umount( secondElement ) ;
+
+	  CheckIndexedEntry( myFSManager, "tree-index/common/second.txt",
+		EmbeddedFileSystemManager::NoEntry ) ;
+
+	  CheckIndexedEntry( myFSManager, "tree-index/common/first.txt",
+		EmbeddedFileSystemManager::IndexedFile ) ;
+
+	  if ( myFSManager.getActualLocationFor( "tree-index/shared.txt" )
+		  != firstElement )
+		throw TestException( "Shared entry not read again from the "
+		  "remaining element." ) ;
+
+	  myFSManager.umount( firstElement ) ;
+
+	  CheckIndexedEntry( myFSManager, "tree-index",
+		EmbeddedFileSystemManager::NoEntry ) ;
+
+	  standardManager.removeDirectory( firstElement, /* recursive */ true ) ;
+	  standardManager.removeDirectory( secondElement, /* recursive */ true ) ;
+
+	  LogPlug::info( "Index of the virtual tree: " + myFSManager.toString() ) ;
+
+
 	  LogPlug::info( "Now testing reading from archives services." ) ;
 
 	  const string archiveFilename =
@@ -262,6 +490,85 @@ int main( int argc, char * argv[] )
 	  else
 		LogPlug::info( "Could tell test position." ) ;
 
+	  // Reads of archived files are buffered ahead by default:
+	  EmbeddedFile * embeddedReadFile =
+		dynamic_cast<EmbeddedFile *>( & otherReadFile ) ;
+
+	  if ( embeddedReadFile == 0 )
+		throw TestException( "Archived file not read as an embedded one." ) ;
+
+	  const EmbeddedFile::IOStatistics & ioStats =
+		embeddedReadFile->getIOStatistics() ;
+
+	  // The whole file was read at once, the seek staying in the buffer:
+	  if ( ioStats.readCount != 2 || ioStats.backendReadCount != 1
+		  || ioStats.seekCount != 1 || ioStats.bytesRead != toRead.size() + 1 )
+		throw TestException( "Unexpected I/O statistics: "
+		  + otherReadFile.toString() ) ;
+
+	  Ceylan::Uint32 resizeCount = ioStats.resizeCount ;
+
+	  // The 9 bytes not read yet fit in the new buffer, kept as they are:
+	  embeddedReadFile->setReadAheadSize( 16 ) ;
+
+	  if ( embeddedReadFile->getReadAheadSize() != 16
+		  || ioStats.resizeCount != resizeCount + 1 )
+		throw TestException( "Read-ahead buffer not resized at once." ) ;
+
+	  otherReadFile.read( buffer, 1 ) ;
+
+	  if ( buffer[0] != 's' || otherReadFile.tell() != 9 )
+		throw TestException( "Could not read after a resize." ) ;
+
+	  // The 8 remaining bytes do not fit, the resize waits for their read:
+	  embeddedReadFile->setReadAheadSize( 4 ) ;
+
+	  if ( embeddedReadFile->getReadAheadSize() != 16 )
+		throw TestException( "Buffered data lost by a resize." ) ;
+
+	  Size lastRead = otherReadFile.read( buffer, 8 ) ;
+
+	  if ( lastRead != 8 || string( buffer, 8 ) != toRead.substr( 9 ) )
+		throw TestException( "Could not read the end of '"
+		  + targetArchivedFilename + "' after a deferred resize." ) ;
+
+	  // Applied once drained, PhysicsFS having never been read again:
+	  if ( embeddedReadFile->getReadAheadSize() != 4
+		  || ioStats.resizeCount != resizeCount + 2
+		  || ioStats.backendReadCount != 1 )
+		throw TestException( "Deferred resize not applied as expected: "
+		  + otherReadFile.toString() ) ;
+
+	  // A read larger than the buffer bypasses it, then seek back before it:
+	  otherReadFile.seek( 0 ) ;
+	  otherReadFile.read( buffer, 2 ) ;
+
+	  lastRead = otherReadFile.read( buffer, 10 ) ;
+
+	  if ( lastRead != 10 || string( buffer, 10 ) != toRead.substr( 2, 10 ) )
+		throw TestException( "Could not read directly past the buffer: "
+		  + otherReadFile.toString() ) ;
+
+	  otherReadFile.seek( 9 ) ;
+	  lastRead = otherReadFile.read( buffer, 3 ) ;
+
+	  if ( lastRead != 3 || string( buffer, 3 ) != toRead.substr( 9, 3 )
+		  || otherReadFile.tell() != 12 )
+		throw TestException( "Could not seek back after a direct read: "
+		  + otherReadFile.toString() ) ;
+
+	  LogPlug::info( "Read-ahead and I/O statistics: "
+		+ otherReadFile.toString() ) ;
+
+	  // The allocations of PhysicsFS are pooled by default:
+	  PooledAllocator::Counters counters =
+		myFSManager.getAllocationCounters() ;
+
+	  if ( counters.pooledAllocations == 0 || counters.liveBlocks == 0 )
+		throw TestException( "Allocations of PhysicsFS not pooled." ) ;
+
+	  LogPlug::info( "Allocation statistics: " + myFSManager.toString() ) ;
+
 	  myFSManager.umount( archiveFilename ) ;
 
 	  delete & myFSManager ;
@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDL.h"
+using namespace OSDL ;
+
+using namespace Ceylan::Log ;
+using namespace Ceylan::System ;
+
+using namespace std ;
+
+
+#include <algorithm>  // for min
+#include <list>
+#include <vector>
+
+
+
+/// Small chunks, so that reads and seeks cross chunk boundaries.
+const Ceylan::Uint32 TestChunkSize = 16 ;
+
+
+
+/// Returns the expected byte at the specified offset of the first member.
+Ceylan::Byte GetPatternByte( Size offset )
+{
+
+  return static_cast<Ceylan::Byte>( ( offset * 37 + 11 ) % 251 ) ;
+
+}
+
+
+
+/**
+ * Reads, from the specified position of the specified stream, up to the
+ * specified length, and checks the bytes read against the pattern.
+ *
+ */
+void CheckReadAt( ArchiveMemberStream & stream, Size position, Size length )
+{
+
+  if ( ! stream.seek( position ) )
+	throw TestException( "Could not seek to position "
+	  + Ceylan::toString( position ) + "." ) ;
+
+  vector<Ceylan::Byte> buffer( length ) ;
+
+  Size expected = std::min<Size>( length, stream.size() - position ) ;
+
+  Size readCount = stream.read( & buffer[0], length ) ;
+
+  if ( readCount != expected )
+	throw TestException( "Read " + Ceylan::toString( readCount )
+	  + " bytes from position " + Ceylan::toString( position )
+	  + ", expected " + Ceylan::toString( expected ) + "." ) ;
+
+  for ( Size i = 0; i < readCount; i++ )
+	if ( buffer[i] != GetPatternByte( position + i ) )
+	  throw TestException( "Wrong byte read at offset "
+		+ Ceylan::toString( position + i ) + "." ) ;
+
+  if ( stream.tell() != position + readCount )
+	throw TestException( "Wrong position after a read from "
+	  + Ceylan::toString( position ) + "." ) ;
+
+}
+
+
+
+/**
+ * Test of the indexed archives provided by the OSDL basic module.
+ *
+ * @note Corresponds to the test of IndexedArchive and ArchiveMemberStream: a
+ * small archive is built, then read back, notably from positions crossing
+ * chunk boundaries, forward and backward.
+ *
+ */
+int main( int argc, char * argv[] )
+{
+
+  {
+
+	LogHolder myLog( argc, argv ) ;
+
+
+	try
+	{
+
+	  LogPlug::info( "Testing OSDL indexed archives." ) ;
+
+	  const string archiveFilename = "testOSDLIndexedArchive.oar" ;
+
+	  // A content hardly compressible, then a very compressible one:
+	  vector<Ceylan::Byte> patterned( 100 ) ;
+
+	  for ( Size i = 0; i < patterned.size(); i++ )
+		patterned[i] = GetPatternByte( i ) ;
+
+	  vector<Ceylan::Byte> zeros( 50, 0 ) ;
+
+	  // Sorted names; the last member shares the content of the first one:
+	  vector<string> names ;
+	  names.push_back( "alpha" ) ;
+	  names.push_back( "beta/gamma" ) ;
+	  names.push_back( "delta" ) ;
+
+	  vector<Size> sizes ;
+	  sizes.push_back( patterned.size() ) ;
+	  sizes.push_back( zeros.size() ) ;
+	  sizes.push_back( patterned.size() ) ;
+
+	  vector<Ceylan::Uint32> sharedWith ;
+	  sharedWith.push_back( 0 ) ;
+	  sharedWith.push_back( 1 ) ;
+	  sharedWith.push_back( 0 ) ;
+
+	  vector<Ceylan::Byte> compressed ;
+	  vector< vector<Ceylan::Uint32> > chunkLengths( names.size() ) ;
+
+	  IndexedArchive::CompressChunks( & patterned[0], patterned.size(),
+		TestChunkSize, compressed, chunkLengths[0] ) ;
+
+	  IndexedArchive::CompressChunks( & zeros[0], zeros.size(),
+		TestChunkSize, compressed, chunkLengths[1] ) ;
+
+	  LogPlug::info( "Building archive '" + archiveFilename + "' of "
+		+ Ceylan::toString( names.size() ) + " members, in "
+		+ Ceylan::toString( chunkLengths[0].size() + chunkLengths[1].size() )
+		+ " chunks of " + Ceylan::toString( TestChunkSize ) + " bytes." ) ;
+
+	  File & archiveFile = StandardFile::Create( archiveFilename ) ;
+
+	  // Header, written last by WriteDirectory:
+	  vector<Ceylan::Byte> header( IndexedArchive::HeaderSize, 0 ) ;
+	  archiveFile.write( & header[0], header.size() ) ;
+
+	  archiveFile.write( & compressed[0], compressed.size() ) ;
+
+	  IndexedArchive::WriteDirectory( archiveFile, TestChunkSize, names,
+		sizes, chunkLengths, sharedWith ) ;
+
+	  delete & archiveFile ;
+
+
+	  LogPlug::info( "Reading the archive back." ) ;
+
+	  FileArchiveSource source( archiveFilename ) ;
+
+	  IndexedArchive archive( source ) ;
+
+	  LogPlug::info( archive.toString() ) ;
+
+	  if ( archive.getMemberCount() != names.size()
+		  || archive.getChunkSize() != TestChunkSize )
+		throw TestException( "Unexpected archive description: "
+		  + archive.toString() ) ;
+
+	  Ceylan::Uint32 index ;
+
+	  for ( Ceylan::Uint32 i = 0; i < names.size(); i++ )
+		if ( ! archive.findMember( names[i], index ) || index != i
+			|| archive.getMemberSize( i ) != sizes[i] )
+		  throw TestException( "Member '" + names[i]
+			+ "' not found as expected." ) ;
+
+	  if ( archive.findMember( "beta", index ) )
+		throw TestException( "A directory was found as a member." ) ;
+
+	  if ( ! archive.isDirectory( "beta" ) || archive.isDirectory( "alpha" ) )
+		throw TestException( "Directories not told apart from members." ) ;
+
+	  list<string> entries ;
+	  archive.getEntries( "", entries ) ;
+
+	  if ( entries.size() != 3 )
+		throw TestException( "Unexpected root entries: "
+		  + Ceylan::formatStringList( entries ) ) ;
+
+
+	  LogPlug::info( "Seeking and reading across chunk boundaries." ) ;
+
+	  ArchiveMemberStream stream( archive, 0, source ) ;
+
+	  // Within a chunk, then across one and several boundaries:
+	  CheckReadAt( stream, 3, 5 ) ;
+	  CheckReadAt( stream, 14, 4 ) ;
+	  CheckReadAt( stream, 20, 40 ) ;
+
+	  // Backward, to an earlier chunk, then to the cached one:
+	  CheckReadAt( stream, 1, 17 ) ;
+	  CheckReadAt( stream, 17, 3 ) ;
+
+	  // Up to the end of the last (partial) chunk, and past it:
+	  CheckReadAt( stream, 90, 30 ) ;
+	  CheckReadAt( stream, 100, 10 ) ;
+
+	  if ( stream.seek( 101 ) )
+		throw TestException( "Could seek past the end of a member." ) ;
+
+	  // The shared member reads the same chunks:
+	  ArchiveMemberStream sharedStream( archive, 2, source ) ;
+
+	  CheckReadAt( sharedStream, 0, 100 ) ;
+
+	  ArchiveMemberStream zeroStream( archive, 1, source ) ;
+
+	  zeroStream.seek( 30 ) ;
+
+	  vector<Ceylan::Byte> buffer( 30, 1 ) ;
+
+	  if ( zeroStream.read( & buffer[0], buffer.size() ) != 20 )
+		throw TestException( "Could not read the end of '" + names[1]
+		  + "'." ) ;
+
+	  for ( Size i = 0; i < 20; i++ )
+		if ( buffer[i] != 0 )
+		  throw TestException( "Wrong byte read from '" + names[1] + "'." ) ;
+
+	  File::Remove( archiveFilename ) ;
+
+	  LogPlug::info( "End of OSDL indexed archive test." ) ;
+
+
+	}
+
+	catch ( const OSDL::Exception & e )
+	{
+
+	  LogPlug::error( "OSDL exception caught: "
+		+ e.toString( Ceylan::high ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const Ceylan::Exception & e )
+	{
+
+	  LogPlug::error( "Ceylan exception caught: "
+		+ e.toString( Ceylan::high ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const std::exception & e )
+	{
+
+	  LogPlug::error( "Standard exception caught: "
+		+ std::string( e.what() ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( ... )
+	{
+
+	  LogPlug::error( "Unknown exception caught" ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+  }
+
+  OSDL::shutdown() ;
+
+  return Ceylan::ExitSuccess ;
+
+}
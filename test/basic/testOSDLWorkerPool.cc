@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+#include "OSDL.h"
+using namespace OSDL ;
+
+using namespace Ceylan::Log ;
+
+
+#include <vector>
+
+
+
+/// Job summing the integers of a range, storing the result.
+class SummingJob : public OSDL::Job
+{
+
+public:
+
+  SummingJob( Ceylan::Uint32 first, Ceylan::Uint32 last ) :
+	OSDL::Job( "summing job" ),
+	_first( first ),
+	_last( last ),
+	_sum( 0 )
+  {
+
+  }
+
+
+  virtual void execute()
+  {
+
+	for ( Ceylan::Uint32 i = _first; i <= _last; i++ )
+	  _sum += i ;
+
+  }
+
+
+  Ceylan::Uint32 _first ;
+  Ceylan::Uint32 _last ;
+  Ceylan::Uint64 _sum ;
+
+} ;
+
+
+
+/// Job whose execution always fails.
+class FailingJob : public OSDL::Job
+{
+
+public:
+
+  FailingJob() :
+	OSDL::Job( "failing job" )
+  {
+
+  }
+
+
+  virtual void execute()
+  {
+
+	throw OSDL::TestException( "FailingJob: failure on purpose" ) ;
+
+  }
+
+} ;
+
+
+
+
+/**
+ * Test of the background execution of jobs by a worker pool.
+ *
+ */
+int main( int argc, char * argv[] )
+{
+
+
+  {
+
+	LogHolder myLog( argc, argv ) ;
+
+
+	try
+	{
+
+
+	  LogPlug::info( "Testing OSDL worker pool" ) ;
+
+	  WorkerPool pool( /* workerCount */ 0, "test pool" ) ;
+
+	  LogPlug::info( "Created pool: " + pool.toString() ) ;
+
+	  const Ceylan::Uint32 jobCount = 16 ;
+	  const Ceylan::Uint32 rangeSize = 100000 ;
+
+	  std::vector<SummingJob *> jobs ;
+
+	  for ( Ceylan::Uint32 i = 0; i < jobCount; i++ )
+	  {
+
+		SummingJob * job = new SummingJob( i * rangeSize + 1,
+		  ( i + 1 ) * rangeSize ) ;
+
+		jobs.push_back( job ) ;
+		pool.submit( * job ) ;
+
+	  }
+
+	  // Jobs owned by the pool must be managed as well:
+	  for ( Ceylan::Uint32 i = 0; i < jobCount; i++ )
+		pool.submit( * new SummingJob( 1, rangeSize ),
+		  /* transferOwnership */ true ) ;
+
+	  FailingJob failingJob ;
+	  pool.submit( failingJob ) ;
+
+	  if ( ! pool.waitFor( * jobs.back() ) )
+		throw OSDL::TestException( "Waiting for last job failed." ) ;
+
+	  if ( ! pool.waitForAll( /* timeout, in milliseconds */ 10000 ) )
+		throw OSDL::TestException( "Jobs not executed in time." ) ;
+
+	  if ( pool.getPendingCount() != 0 )
+		throw OSDL::TestException( "Pending jobs remain." ) ;
+
+	  // The sum of 1..N is N(N+1)/2:
+	  Ceylan::Uint64 total = 0 ;
+
+	  for ( Ceylan::Uint32 i = 0; i < jobCount; i++ )
+	  {
+
+		if ( pool.getStateOf( * jobs[i] ) != Job::Completed )
+		  throw OSDL::TestException( "Job #" + Ceylan::toString( i )
+			+ " not completed." ) ;
+
+		total += jobs[i]->_sum ;
+		delete jobs[i] ;
+
+	  }
+
+	  Ceylan::Uint64 last = static_cast<Ceylan::Uint64>( jobCount )
+		* rangeSize ;
+
+	  if ( total != last * ( last + 1 ) / 2 )
+		throw OSDL::TestException( "Wrong sum computed." ) ;
+
+	  if ( pool.getStateOf( failingJob ) != Job::Failed )
+		throw OSDL::TestException( "Failing job not detected as such." ) ;
+
+	  LogPlug::info( "Failing job reported: "
+		+ pool.getFailureReasonFor( failingJob ) ) ;
+
+	  LogPlug::info( "End of OSDL worker pool test." ) ;
+
+
+	}
+
+	catch ( const OSDL::Exception & e )
+	{
+
+	  LogPlug::error( "OSDL exception caught: "
+		+ e.toString( Ceylan::high ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const Ceylan::Exception & e )
+	{
+
+	  LogPlug::error( "Ceylan exception caught: "
+		+ e.toString( Ceylan::high ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const std::exception & e )
+	{
+
+	  LogPlug::error( "Standard exception caught: "
+		+ std::string( e.what() ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( ... )
+	{
+
+	  LogPlug::error( "Unknown exception caught" ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+  }
+
+  OSDL::shutdown() ;
+
+  return Ceylan::ExitSuccess ;
+
+}
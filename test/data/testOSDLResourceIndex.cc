@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDL.h"
+using namespace OSDL ;
+using namespace OSDL::Data ;
+
+
+using namespace Ceylan::Log ;
+using namespace Ceylan::System ;
+
+#include <string>
+using std::string ;
+
+#include <list>
+using std::list ;
+
+
+
+/// Two files of identical contents, then the one of a different content.
+const string FirstData  = "testOSDLResourceIndex-first.dat" ;
+const string SecondData = "testOSDLResourceIndex-second.dat" ;
+const string OtherData  = "testOSDLResourceIndex-other.dat" ;
+
+
+
+/// Creates the specified file, with the specified content.
+void WriteFile( const string & filename, const string & content )
+{
+
+  File & file = File::Create( filename ) ;
+
+  file.write( content ) ;
+
+  delete & file ;
+
+}
+
+
+
+/// Writes a resource map entry for the specified data, in the specified group.
+string GetDataEntry( Ceylan::ResourceID id, const string & path,
+  const string & groupName )
+{
+
+  return "  <resource id=\"" + Ceylan::toString( id ) + "\">\n"
+	"    <resource_path>" + path + "</resource_path>\n"
+	"    <content_type>data</content_type>\n"
+	"    <group>" + groupName + "</group>\n"
+	"  </resource>\n" ;
+
+}
+
+
+
+/// Checks that the specified index lists the specified entry.
+ResourceIndex::Entry CheckEntry( const ResourceIndex & index,
+  Ceylan::ResourceID id, const string & path )
+{
+
+  ResourceIndex::Entry entry ;
+
+  if ( ! index.findEntryFor( id, entry ) || entry.id != id
+	  || entry.path != path || entry.contentType != Data::data
+	  || entry.contentHash == 0 )
+	throw TestException( "Entry #" + Ceylan::toString( id )
+	  + " not listed as expected: " + index.toString() ) ;
+
+  Ceylan::ResourceID foundID ;
+
+  if ( ! index.findIDFor( path, foundID ) || foundID != id )
+	throw TestException( "Path '" + path + "' not hashed as expected." ) ;
+
+  string foundPath ;
+
+  if ( ! index.findPathFor( id, foundPath ) || foundPath != path )
+	throw TestException( "No path found for entry #"
+	  + Ceylan::toString( id ) + "." ) ;
+
+  return entry ;
+
+}
+
+
+
+/**
+ * Testing OSDL resource indexes: an XML resource map is compiled, with the
+ * hashes of the contents it lists, then the index is read back and looked-up
+ * by identifier, by path, by content type and by group.
+ *
+ */
+int main( int argc, char * argv[] )
+{
+
+  {
+
+
+	LogHolder myLog( argc, argv ) ;
+
+
+	try
+	{
+
+
+	  LogPlug::info( "Testing OSDL resource indexes." ) ;
+
+	  WriteFile( FirstData,  "Shared content." ) ;
+	  WriteFile( SecondData, "Shared content." ) ;
+	  WriteFile( OtherData,  "Content of its own." ) ;
+
+	  const string mapFilename = "testOSDLResourceIndex.xml" ;
+
+	  // Listed in no particular order:
+	  WriteFile( mapFilename,
+		"<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n"
+		"<resources>\n"
+		+ GetDataEntry( 9, SecondData, "level-2" )
+		+ GetDataEntry( 2, OtherData,  "level-1" )
+		+ GetDataEntry( 5, FirstData,  "level-1" )
+		+ "</resources>\n" ) ;
+
+	  const string indexFilename = "testOSDLResourceIndex"
+		+ ResourceIndex::FileExtension ;
+
+	  // Contents are hashed from the current directory:
+	  Ceylan::Uint32 compiledCount = ResourceManager::CompileResourceMap(
+		mapFilename, indexFilename, /* contentDirectory */ "." ) ;
+
+	  if ( compiledCount != 3 )
+		throw TestException( "Compiled "
+		  + Ceylan::toString( compiledCount ) + " resources, expected 3." ) ;
+
+	  LogPlug::info( "Reading back index '" + indexFilename + "'." ) ;
+
+	  {
+
+		ResourceIndex index( indexFilename ) ;
+
+		LogPlug::info( index.toString() ) ;
+
+		if ( index.getEntryCount() != 3 || index.getMaxID() != 9
+			|| index.getEntryAt( 0 ).id != 2 || index.getEntryAt( 2 ).id != 9 )
+		  throw TestException( "Entries not sorted by identifier: "
+			+ index.toString() ) ;
+
+		ResourceIndex::Entry first  = CheckEntry( index, 5, FirstData ) ;
+		ResourceIndex::Entry second = CheckEntry( index, 9, SecondData ) ;
+		ResourceIndex::Entry other  = CheckEntry( index, 2, OtherData ) ;
+
+		if ( first.contentHash != second.contentHash
+			|| first.contentHash == other.contentHash )
+		  throw TestException( "Contents not hashed as expected." ) ;
+
+		ResourceIndex::Entry entry ;
+		Ceylan::ResourceID id ;
+
+		if ( index.findEntryFor( 4, entry )
+			|| index.findIDFor( "testOSDLResourceIndex-none.dat", id ) )
+		  throw TestException( "Unlisted resource found." ) ;
+
+		if ( index.getEntriesOfType( Data::data ).size() != 3
+			|| ! index.getEntriesOfType( Data::image ).empty() )
+		  throw TestException( "Entries not selected by type." ) ;
+
+		ResourceIndex::GroupMap groups = index.getGroups() ;
+
+		if ( groups.size() != 2 || groups["level-1"].size() != 2
+			|| groups["level-2"].size() != 1
+			|| groups["level-2"].front() != 9 )
+		  throw TestException( "Groups not listed as expected." ) ;
+
+	  }
+
+	  File::Remove( indexFilename ) ;
+	  File::Remove( mapFilename ) ;
+
+	  File::Remove( FirstData ) ;
+	  File::Remove( SecondData ) ;
+	  File::Remove( OtherData ) ;
+
+	  LogPlug::info( "End of OSDL resource index test." ) ;
+
+
+	}
+
+	catch ( const OSDL::Exception & e )
+	{
+
+	  LogPlug::error( "OSDL exception caught: "
+		+ e.toString( Ceylan::high ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const Ceylan::Exception & e )
+	{
+
+	  LogPlug::error( "Ceylan exception caught: "
+		+ e.toString( Ceylan::high ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const std::exception & e )
+	{
+
+	  LogPlug::error( "Standard exception caught: "
+		+ std::string( e.what() ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( ... )
+	{
+
+	  LogPlug::error( "Unknown exception caught" ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+  }
+
+  OSDL::shutdown() ;
+
+  return Ceylan::ExitSuccess ;
+
+}
@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDL.h"
+using namespace OSDL ;
+using namespace OSDL::Data ;
+using namespace OSDL::Video ;
+
+
+using namespace Ceylan::Log ;
+using namespace Ceylan::System ;
+
+#include <string>
+using std::string ;
+
+
+
+/// The two images of identical contents, then the one of a different content.
+const string FirstImage  = "testOSDLResourceSharing-first.bmp" ;
+const string SecondImage = "testOSDLResourceSharing-second.bmp" ;
+const string OtherImage  = "testOSDLResourceSharing-other.bmp" ;
+
+
+
+/// Saves a small image, whose pixels depend on the specified seed.
+void SaveImage( const string & filename, Ceylan::Uint8 seed )
+{
+
+  Surface & image = * new Surface( Surface::Software, /* width */ 8,
+	/* height */ 8, /* depth */ 32 ) ;
+
+  for ( Length y = 0; y < 8; y++ )
+	for ( Length x = 0; x < 8; x++ )
+	  image.putRGBAPixelAt( x, y,
+		/* red */ static_cast<Pixels::ColorElement>( x * 32 ),
+		/* green */ static_cast<Pixels::ColorElement>( y * 32 ),
+		/* blue */ seed, Pixels::AlphaOpaque, /* blending */ false ) ;
+
+  image.saveBMP( filename ) ;
+
+  delete & image ;
+
+}
+
+
+
+/// Writes a resource map entry for the specified 2D texture.
+string GetTextureEntry( Ceylan::ResourceID id, const string & path )
+{
+
+  return "  <resource id=\"" + Ceylan::toString( id ) + "\">\n"
+	"    <resource_path>" + path + "</resource_path>\n"
+	"    <content_type>texture_2D</content_type>\n"
+	"  </resource>\n" ;
+
+}
+
+
+
+/**
+ * Testing the sharing of resources of identical contents, as listed in a
+ * resource index compiled with content hashes.
+ *
+ * Textures #1 and #2 have identical contents, hence share a single instance,
+ * whereas #3 has a content of its own. Discarding #2 discards #1 as well, and
+ * both can be fetched again afterwards.
+ *
+ * @note Textures are loaded but never uploaded, no OpenGL context is needed.
+ *
+ */
+int main( int argc, char * argv[] )
+{
+
+  {
+
+
+	LogHolder myLog( argc, argv ) ;
+
+
+	try
+	{
+
+
+	  LogPlug::info( "Testing OSDL resource sharing." ) ;
+
+	  // Needed to save and load images:
+	  getCommonModule( CommonModule::UseVideo ) ;
+
+	  SaveImage( FirstImage,  /* seed */ 10 ) ;
+	  SaveImage( SecondImage, /* seed */ 10 ) ;
+	  SaveImage( OtherImage,  /* seed */ 20 ) ;
+
+	  const string mapFilename = "testOSDLResourceSharing.xml" ;
+
+	  File & mapFile = File::Create( mapFilename ) ;
+
+	  mapFile.write( "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n"
+		"<resources>\n"
+		+ GetTextureEntry( 1, FirstImage )
+		+ GetTextureEntry( 2, SecondImage )
+		+ GetTextureEntry( 3, OtherImage )
+		+ "</resources>\n" ) ;
+
+	  delete & mapFile ;
+
+	  const string indexFilename = "testOSDLResourceSharing"
+		+ ResourceIndex::FileExtension ;
+
+	  // Contents are hashed from the current directory:
+	  ResourceManager::CompileResourceMap( mapFilename, indexFilename,
+		/* contentDirectory */ "." ) ;
+
+	  ResourceManager * myResourceManager =
+		new ResourceManager( indexFilename ) ;
+
+	  {
+
+		// Held by the manager and by these two pointers if shared:
+		Video::OpenGL::TextureCountedPtr first =
+		  myResourceManager->getTexture( 1, /* uploadWanted */ false ) ;
+
+		Video::OpenGL::TextureCountedPtr second =
+		  myResourceManager->getTexture( 2, /* uploadWanted */ false ) ;
+
+		Video::OpenGL::TextureCountedPtr other =
+		  myResourceManager->getTexture( 3, /* uploadWanted */ false ) ;
+
+		if ( first.getReferenceCount() != 3
+			|| other.getReferenceCount() != 2 )
+		  throw TestException( "Textures of identical contents not shared: "
+			+ myResourceManager->toString() ) ;
+
+	  }
+
+	  LogPlug::info( "Discarding texture #2, which shares texture #1." ) ;
+
+	  myResourceManager->discardTexture( 2 ) ;
+
+	  if ( myResourceManager->isReady( 1 ) )
+		throw TestException( "Shared texture #1 not discarded." ) ;
+
+	  {
+
+		// The owner is created again, then shared again:
+		Video::OpenGL::TextureCountedPtr first =
+		  myResourceManager->getTexture( 1, /* uploadWanted */ false ) ;
+
+		Video::OpenGL::TextureCountedPtr second =
+		  myResourceManager->getTexture( 2, /* uploadWanted */ false ) ;
+
+		if ( ! first->hasContent() || first.getReferenceCount() != 3 )
+		  throw TestException( "Discarded texture not fetched again: "
+			+ myResourceManager->toString() ) ;
+
+	  }
+
+	  delete myResourceManager ;
+
+	  File::Remove( indexFilename ) ;
+	  File::Remove( mapFilename ) ;
+
+	  File::Remove( FirstImage ) ;
+	  File::Remove( SecondImage ) ;
+	  File::Remove( OtherImage ) ;
+
+	  LogPlug::info( "End of OSDL resource sharing test." ) ;
+
+	  OSDL::stop() ;
+
+
+	}
+
+	catch ( const OSDL::Exception & e )
+	{
+
+	  LogPlug::error( "OSDL exception caught: "
+		+ e.toString( Ceylan::high ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const Ceylan::Exception & e )
+	{
+
+	  LogPlug::error( "Ceylan exception caught: "
+		+ e.toString( Ceylan::high ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const std::exception & e )
+	{
+
+	  LogPlug::error( "Standard exception caught: "
+		+ std::string( e.what() ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( ... )
+	{
+
+	  LogPlug::error( "Unknown exception caught" ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+  }
+
+  OSDL::shutdown() ;
+
+  return Ceylan::ExitSuccess ;
+
+}
@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDL.h"
+using namespace OSDL ;
+using namespace OSDL::Video ;
+
+
+using namespace Ceylan::Log ;
+
+
+#include <string>
+using std::string ;
+
+
+
+/**
+ * Creates a 32-bit surface whose colors vary along both axes, with a noise
+ * term so that dithering errors are not uniform, and whose corners and a
+ * central block are magenta, to be guessed as the colorkey.
+ *
+ * Dimensions are deliberately not multiples of the band height.
+ *
+ */
+Surface & createSourceSurface( Length width, Length height )
+{
+
+  Surface & source = * new Surface( Surface::Software, width, height,
+	/* depth */ 32 ) ;
+
+  Ceylan::Uint32 seed = 7 ;
+
+  for ( Length y = 0; y < height; y++ )
+	for ( Length x = 0; x < width; x++ )
+	{
+
+	  seed = seed * 1103515245 + 12345 ;
+
+	  source.putRGBAPixelAt( x, y,
+		/* red */ static_cast<Pixels::ColorElement>( x * 255 / width ),
+		/* green */ static_cast<Pixels::ColorElement>( y * 255 / height ),
+		/* blue */ static_cast<Pixels::ColorElement>(
+		  ( ( x + y ) * 2 + ( seed >> 24 ) ) & 0xff ),
+		Pixels::AlphaOpaque, /* blending */ false ) ;
+
+	}
+
+  for ( Length y = height / 3; y < height / 2; y++ )
+	for ( Length x = width / 3; x < width / 2; x++ )
+	  source.putRGBAPixelAt( x, y, 255, 0, 255, Pixels::AlphaOpaque,
+		/* blending */ false ) ;
+
+  source.putRGBAPixelAt( 0, 0, 255, 0, 255, Pixels::AlphaOpaque,
+	/* blending */ false ) ;
+
+  source.putRGBAPixelAt( width - 1, height - 1, 255, 0, 255,
+	Pixels::AlphaOpaque, /* blending */ false ) ;
+
+  return source ;
+
+}
+
+
+
+/**
+ * Checks that the two specified 8-bit surfaces have the same pixels.
+ *
+ * @throw TestException if a pixel differs.
+ *
+ */
+void checkSameIndexes( const Surface & expected, const Surface & actual,
+  const string & context )
+{
+
+  if ( expected.getWidth() != actual.getWidth()
+	  || expected.getHeight() != actual.getHeight() )
+	throw Ceylan::TestException( context + ": surface dimensions differ" ) ;
+
+  const Ceylan::Uint8 * expectedPixels =
+	static_cast<const Ceylan::Uint8 *>( expected.getPixels() ) ;
+
+  const Ceylan::Uint8 * actualPixels =
+	static_cast<const Ceylan::Uint8 *>( actual.getPixels() ) ;
+
+  for ( Length y = 0; y < expected.getHeight(); y++ )
+	for ( Length x = 0; x < expected.getWidth(); x++ )
+	{
+
+	  Ceylan::Uint8 expectedIndex = expectedPixels[
+		y * expected.getPitch() + x ] ;
+
+	  Ceylan::Uint8 actualIndex = actualPixels[ y * actual.getPitch() + x ] ;
+
+	  if ( expectedIndex != actualIndex )
+		throw Ceylan::TestException( context + ": pixel at ["
+		  + Ceylan::toString( x ) + ";" + Ceylan::toString( y )
+		  + "] has index #" + Ceylan::toNumericalString( actualIndex )
+		  + ", whereas the single-threaded reduction chose #"
+		  + Ceylan::toNumericalString( expectedIndex ) ) ;
+
+	}
+
+}
+
+
+
+/**
+ * Test of the color reduction of surfaces, checking that the reductions
+ * split into jobs executed by worker pools are identical to the ones
+ * performed by the calling thread, for each dithering mode.
+ *
+ */
+int main( int argc, char * argv[] )
+{
+
+  {
+
+	LogHolder myLog( argc, argv ) ;
+
+
+	try
+	{
+
+
+	  LogPlug::info( "Testing OSDL color reducer." ) ;
+
+	  OSDL::CommonModule & myOSDL = OSDL::getCommonModule(
+		CommonModule::UseVideo ) ;
+
+	  LogPlug::info( "Common module: " + myOSDL.toString() ) ;
+
+	  Surface & source = createSourceSurface( 203, 149 ) ;
+
+	  Palette & palette = Palette::CreateMasterPalette() ;
+
+	  // The single worker checks that diffusion jobs cannot deadlock:
+	  WorkerPool * pools[2] ;
+
+	  pools[0] = new WorkerPool( /* workerCount */ 1, "single worker pool" ) ;
+	  pools[1] = new WorkerPool( /* workerCount */ 0, "default pool" ) ;
+
+	  const ColorReducer::DitheringMode modes[3] = {
+		ColorReducer::NoDithering,
+		ColorReducer::FloydSteinbergDithering,
+		ColorReducer::OrderedDithering } ;
+
+	  for ( Ceylan::Uint8 colorkeyed = 0; colorkeyed < 2; colorkeyed++ )
+	  {
+
+		// The colorkey is elected only in the second pass:
+		if ( colorkeyed == 1 )
+		  palette.setColorKeyIndex( 0 ) ;
+
+		for ( Ceylan::Uint8 m = 0; m < 3; m++ )
+		{
+
+		  ColorReducer sequentialReducer( palette, modes[m] ) ;
+
+		  Surface & expected = sequentialReducer.reduce( source,
+			/* manageColorkey */ colorkeyed == 1 ) ;
+
+		  for ( Ceylan::Uint8 p = 0; p < 2; p++ )
+		  {
+
+			ColorReducer parallelReducer( palette, modes[m], pools[p] ) ;
+
+			Surface & actual = parallelReducer.reduce( source,
+			  /* manageColorkey */ colorkeyed == 1 ) ;
+
+			string context = ColorReducer::DescribeDitheringMode( modes[m] )
+			  + ( colorkeyed == 1 ? ", with colorkey" : ", without colorkey" )
+			  + ", " + pools[p]->toString( Ceylan::low ) ;
+
+			try
+			{
+
+			  checkSameIndexes( expected, actual, context ) ;
+
+			}
+			catch( ... )
+			{
+
+			  delete & actual ;
+			  delete & expected ;
+			  throw ;
+
+			}
+
+			LogPlug::info( "Same reduction obtained for " + context ) ;
+
+			delete & actual ;
+
+		  }
+
+		  delete & expected ;
+
+		}
+
+	  }
+
+	  // Pools must be stopped before OSDL:
+	  delete pools[0] ;
+	  delete pools[1] ;
+
+	  delete & palette ;
+	  delete & source ;
+
+	  LogPlug::info( "Stopping OSDL." ) ;
+	  OSDL::stop() ;
+
+	  LogPlug::info( "End of OSDL color reducer test." ) ;
+
+	}
+
+	catch ( const OSDL::Exception & e )
+	{
+
+	  LogPlug::error( "OSDL exception caught: "
+		+ e.toString( Ceylan::high ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const Ceylan::Exception & e )
+	{
+
+	  LogPlug::error( "Ceylan exception caught: "
+		+ e.toString( Ceylan::high ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const std::exception & e )
+	{
+
+	  LogPlug::error( "Standard exception caught: "
+		+ std::string( e.what() ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( ... )
+	{
+
+	  LogPlug::error( "Unknown exception caught" ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+  }
+
+  OSDL::shutdown() ;
+
+  return Ceylan::ExitSuccess ;
+
+}
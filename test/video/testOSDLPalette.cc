@@ -37,6 +37,94 @@ using std::string ;
 
 
 
+/**
+ * Checks that the closest colors found thanks to the inverse colormap of
+ * specified palette agree with the ones found by an exhaustive scan of its
+ * color definitions.
+ *
+ * Cell centers must be matched exactly, whereas any other color must be
+ * matched as the center of the 5/6/5 cell it belongs to.
+ *
+ * @throw TestException if a disagreement is found.
+ *
+ */
+void checkClosestColors( const Palette & palette, const string & name )
+{
+
+  Pixels::ColorDefinition color ;
+  color.unused = Pixels::AlphaOpaque ;
+
+  ColorCount closest, exact ;
+
+  for ( Ceylan::Uint32 red = 0; red < 32; red++ )
+	for ( Ceylan::Uint32 green = 0; green < 64; green++ )
+	  for ( Ceylan::Uint32 blue = 0; blue < 32; blue++ )
+	  {
+
+		color.r = static_cast<Pixels::ColorElement>( ( red << 3 ) | 0x04 ) ;
+		color.g = static_cast<Pixels::ColorElement>( ( green << 2 ) | 0x02 ) ;
+		color.b = static_cast<Pixels::ColorElement>( ( blue << 3 ) | 0x04 ) ;
+
+		closest = palette.getClosestColorIndexTo( color ) ;
+		exact   = palette.getExactClosestColorIndexTo( color ) ;
+
+		if ( closest != exact )
+		  throw Ceylan::TestException( "For the " + name
+			+ " palette, the closest color to the cell center "
+			+ Pixels::toString( color ) + " is #"
+			+ Ceylan::toString( closest ) + ", whereas the exact scan "
+			"returns #" + Ceylan::toString( exact ) ) ;
+
+		if ( palette.hasColorKey() && closest == palette.getColorKeyIndex() )
+		  throw Ceylan::TestException( "For the " + name
+			+ " palette, the colorkey was returned as the closest color to "
+			+ Pixels::toString( color ) ) ;
+
+	  }
+
+  // Then colors anywhere in their cell, drawn from a fixed sequence:
+  Ceylan::Uint32 seed = 1 ;
+
+  Pixels::ColorDefinition center ;
+  center.unused = Pixels::AlphaOpaque ;
+
+  Ceylan::Uint32 differentFromExact = 0 ;
+
+  for ( Ceylan::Uint32 i = 0; i < 20000; i++ )
+  {
+
+	seed = seed * 1103515245 + 12345 ;
+
+	color.r = static_cast<Pixels::ColorElement>( ( seed >> 8 )  & 0xff ) ;
+	color.g = static_cast<Pixels::ColorElement>( ( seed >> 16 ) & 0xff ) ;
+	color.b = static_cast<Pixels::ColorElement>( ( seed >> 24 ) & 0xff ) ;
+
+	center.r = static_cast<Pixels::ColorElement>( ( color.r & 0xf8 ) | 0x04 ) ;
+	center.g = static_cast<Pixels::ColorElement>( ( color.g & 0xfc ) | 0x02 ) ;
+	center.b = static_cast<Pixels::ColorElement>( ( color.b & 0xf8 ) | 0x04 ) ;
+
+	closest = palette.getClosestColorIndexTo( color ) ;
+
+	if ( closest != palette.getExactClosestColorIndexTo( center ) )
+	  throw Ceylan::TestException( "For the " + name
+		+ " palette, the closest color to " + Pixels::toString( color )
+		+ " is #" + Ceylan::toString( closest )
+		+ ", which is not the closest one to the center of its cell" ) ;
+
+	if ( closest != palette.getExactClosestColorIndexTo( color ) )
+	  differentFromExact++ ;
+
+  }
+
+  LogPlug::info( "For the " + name + " palette, the closest colors agree "
+	"with the exact scan on all cell centers, and differ from it for "
+	+ Ceylan::toString( differentFromExact )
+	+ " colors out of 20000 arbitrary ones." ) ;
+
+}
+
+
+
 /**
  * Testing the OSDL palette-oriented services.
  *
@@ -136,6 +224,8 @@ int main( int argc, char * argv[] )
 
 	  greyPal.draw( screen ) ;
 
+	  checkClosestColors( greyPal, "greyscale" ) ;
+
 
 	  screen.update() ;
 
@@ -152,6 +242,8 @@ int main( int argc, char * argv[] )
 
 	  colorPal.draw( screen ) ;
 
+	  checkClosestColors( colorPal, "gradation" ) ;
+
 	  screen.update() ;
 
 	  if ( ! isBatch )
@@ -196,6 +288,16 @@ int main( int argc, char * argv[] )
 
 	  screen.update() ;
 
+	  // Computed once for all here, lazily for the other palettes:
+	  masterPal.computeInverseColormap() ;
+
+	  checkClosestColors( masterPal, "master" ) ;
+
+	  // The colorkey must never be elected:
+	  masterPal.setColorKeyIndex( 0 ) ;
+
+	  checkClosestColors( masterPal, "color-keyed master" ) ;
+
 	  masterPal.quantize( /* quantizeMaxCoordinate */ 31,
 		/* scaleUp */ false ) ;
 
@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDL.h"
+using namespace OSDL ;
+using namespace OSDL::Video ;
+using namespace OSDL::Video::TwoDimensional::Text ;
+
+
+using namespace Ceylan::Log ;
+
+
+#include <string>
+
+
+
+/// The view fonts would have onto the cache, keyed here by integers.
+typedef FontRenderCacheView<Ceylan::Uint32> TestView ;
+
+
+
+/**
+ * Stores, on behalf of specified view, a copy of specified rendering for each
+ * of the keys in [first;last].
+ *
+ */
+void addRenderings( TestView & view, Ceylan::Uint32 first,
+  Ceylan::Uint32 last, const Surface & rendering )
+{
+
+  for ( Ceylan::Uint32 key = first; key <= last; key++ )
+	if ( ! view.scanForAddition( key, rendering ) )
+	  throw TestException( "Rendering #" + Ceylan::toString( key )
+		+ " could not be stored." ) ;
+
+}
+
+
+
+/// Checks that specified key is (or is not) in cache, thus counting a hit
+/// (or a miss).
+void checkResident( TestView & view, Ceylan::Uint32 key, bool expected )
+{
+
+  bool resident = ( view.get( key ) != 0 ) ;
+
+  if ( resident != expected )
+	throw TestException( "Rendering #" + Ceylan::toString( key )
+	  + ( expected ? " should" : " should not" ) + " be in cache." ) ;
+
+}
+
+
+
+/// Checks the statistics of specified view.
+void checkStatistics( const TestView & view, Ceylan::Uint32 hits,
+  Ceylan::Uint32 misses, Ceylan::Uint32 evictions, Ceylan::Uint32 entryCount,
+  Ceylan::System::Size bytes )
+{
+
+  const FontRenderCacheStatistics & stats = view.getStatistics() ;
+
+  LogPlug::info( view.describeStatistics() ) ;
+
+  if ( stats.hits != hits || stats.misses != misses
+	  || stats.evictions != evictions || stats.entryCount != entryCount
+	  || stats.bytes != bytes )
+	throw TestException( "Unexpected statistics: expected "
+	  + Ceylan::toString( hits ) + " hit(s), "
+	  + Ceylan::toString( misses ) + " miss(es), "
+	  + Ceylan::toString( evictions ) + " eviction(s), "
+	  + Ceylan::toString( entryCount ) + " entries and "
+	  + Ceylan::toString( bytes ) + " bytes, got "
+	  + Ceylan::toString( stats.hits ) + ", "
+	  + Ceylan::toString( stats.misses ) + ", "
+	  + Ceylan::toString( stats.evictions ) + ", "
+	  + Ceylan::toString( stats.entryCount ) + " and "
+	  + Ceylan::toString( stats.bytes ) + "." ) ;
+
+}
+
+
+
+/**
+ * Tests the budget, the eviction order and the statistics of the render cache
+ * shared by fonts, with both eviction policies.
+ *
+ * No font is needed, as any surface can be cached.
+ *
+ */
+int main( int argc, char * argv[] )
+{
+
+  {
+
+	LogHolder myLog( argc, argv ) ;
+
+
+	try
+	{
+
+
+	  LogPlug::info( "Testing OSDL font render cache." ) ;
+
+	  // All renderings take the same room:
+	  Surface rendering( Surface::Software, /* width */ 16, /* height */ 16 ) ;
+
+	  Ceylan::System::Size size = rendering.getSizeInMemory() ;
+
+	  LogPlug::info( "Each rendering takes " + Ceylan::toString( size )
+		+ " bytes." ) ;
+
+
+	  LogPlug::info( "Testing the LRU policy, with room for 3 renderings." ) ;
+
+	  {
+
+		FontRenderCache cache( /* quota */ 3 * size + size / 2,
+		  FontRenderCache::LeastRecentlyUsed ) ;
+
+		TestView view( cache, /* pinned */ false, /* quota */ 0 ) ;
+
+		addRenderings( view, 1, 3, rendering ) ;
+		checkStatistics( view, 0, 0, 0, 3, 3 * size ) ;
+
+		// Makes #2 the least recently used:
+		checkResident( view, 1, true ) ;
+		checkResident( view, 3, true ) ;
+
+		addRenderings( view, 4, 4, rendering ) ;
+
+		checkResident( view, 2, false ) ;
+		checkResident( view, 1, true ) ;
+		checkResident( view, 3, true ) ;
+		checkResident( view, 4, true ) ;
+
+		checkStatistics( view, 5, 1, 1, 3, 3 * size ) ;
+
+		// Too large for the budget:
+		Surface huge( Surface::Software, /* width */ 64, /* height */ 64 ) ;
+
+		if ( view.scanForAddition( 5, huge ) )
+		  throw TestException( "A rendering larger than the budget "
+			"should not be stored." ) ;
+
+		checkStatistics( view, 5, 1, 1, 3, 3 * size ) ;
+
+		if ( cache.getStatistics().bytes > cache.getQuota() )
+		  throw TestException( "Budget exceeded: " + cache.toString() ) ;
+
+		// Halving the budget evicts the least recently used renderings:
+		cache.setQuota( size + size / 2 ) ;
+
+		checkResident( view, 1, false ) ;
+		checkResident( view, 3, false ) ;
+		checkResident( view, 4, true ) ;
+
+		checkStatistics( view, 6, 3, 3, 1, size ) ;
+
+		LogPlug::info( cache.toString() ) ;
+
+	  }
+
+
+	  LogPlug::info( "Testing the ARC policy, with room for 4 renderings." ) ;
+
+	  {
+
+		FontRenderCache cache( /* quota */ 4 * size + size / 2,
+		  FontRenderCache::AdaptiveReplacement ) ;
+
+		TestView view( cache, /* pinned */ false, /* quota */ 0 ) ;
+
+		// #1 and #2 are used repeatedly:
+		addRenderings( view, 1, 2, rendering ) ;
+		checkResident( view, 1, true ) ;
+		checkResident( view, 2, true ) ;
+
+		// A scan of renderings used once must not evict them:
+		addRenderings( view, 10, 19, rendering ) ;
+
+		checkResident( view, 1, true ) ;
+		checkResident( view, 2, true ) ;
+
+		// Only the latest renderings of the scan remain:
+		checkResident( view, 18, true ) ;
+		checkResident( view, 19, true ) ;
+		checkResident( view, 10, false ) ;
+
+		checkStatistics( view, 6, 1, 8, 4, 4 * size ) ;
+
+		// #10 is remembered, hence now deemed used repeatedly:
+		addRenderings( view, 10, 10, rendering ) ;
+		checkResident( view, 10, true ) ;
+
+		if ( cache.getStatistics().bytes > cache.getQuota() )
+		  throw TestException( "Budget exceeded: " + cache.toString() ) ;
+
+		LogPlug::info( cache.toString() ) ;
+
+	  }
+
+
+	  LogPlug::info( "Testing pinned clients." ) ;
+
+	  {
+
+		FontRenderCache cache( /* quota */ 2 * size + size / 2,
+		  FontRenderCache::LeastRecentlyUsed ) ;
+
+		TestView pinnedView( cache, /* pinned */ true, /* quota */ 2 * size ) ;
+		TestView otherView( cache, /* pinned */ false, /* quota */ 0 ) ;
+
+		addRenderings( pinnedView, 1, 1, rendering ) ;
+		addRenderings( otherView, 1, 3, rendering ) ;
+
+		// The pinned rendering is never evicted, only one other fits:
+		checkResident( pinnedView, 1, true ) ;
+		checkResident( otherView, 3, true ) ;
+		checkResident( otherView, 1, false ) ;
+
+		cache.flush() ;
+
+		checkResident( pinnedView, 1, true ) ;
+		checkResident( otherView, 3, false ) ;
+
+		LogPlug::info( cache.toString() ) ;
+
+	  }
+
+
+	  LogPlug::info( "End of OSDL font render cache test." ) ;
+
+	}
+
+	catch ( const OSDL::Exception & e )
+	{
+
+	  LogPlug::error( "OSDL exception caught: "
+		+ e.toString( Ceylan::high ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const Ceylan::Exception & e )
+	{
+
+	  LogPlug::error( "Ceylan exception caught: "
+		+ e.toString( Ceylan::high ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const std::exception & e )
+	{
+
+	  LogPlug::error( "Standard exception caught: "
+		+ std::string( e.what() ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( ... )
+	{
+
+	  LogPlug::error( "Unknown exception caught" ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+  }
+
+  OSDL::shutdown() ;
+
+  return Ceylan::ExitSuccess ;
+
+}
@@ -0,0 +1,415 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDL.h"
+using namespace OSDL ;
+using namespace OSDL::Video ;
+using namespace OSDL::Video::TwoDimensional ;
+
+
+using namespace Ceylan::Log ;
+using namespace Ceylan::System ;
+
+
+#include <string>
+#include <vector>
+#include <cstring>     // for memcmp
+
+
+
+/// The offset of the flags in a raw image file.
+const Ceylan::Uint32 FlagsOffset = 3 ;
+
+/// The offset of the stored payload size in a raw image file.
+const Ceylan::Uint32 StoredSizeOffset = 36 ;
+
+/// The offset of the payload, for images without palette.
+const Ceylan::Uint32 PayloadOffset = 64 ;
+
+/// The flag telling that the payload is compressed.
+const Ceylan::Uint8 CompressedFlag = 4 ;
+
+
+
+/// Reads the whole specified file into specified buffer.
+void readWholeFile( const std::string & filename,
+  std::vector<Ceylan::Byte> & content )
+{
+
+  Ceylan::Holder<File> file( File::Open( filename ) ) ;
+
+  content.resize( file->size() ) ;
+
+  file->readExactLength( & content[0], content.size() ) ;
+
+}
+
+
+
+/// Writes specified buffer as the whole content of specified file.
+void writeWholeFile( const std::string & filename,
+  const std::vector<Ceylan::Byte> & content )
+{
+
+  Ceylan::Holder<File> file( File::Create( filename ) ) ;
+
+  file->write( & content[0], content.size() ) ;
+
+}
+
+
+
+/// Reads the little-endian 32-bit integer at specified offset.
+Ceylan::Uint32 readUint32At( const std::vector<Ceylan::Byte> & content,
+  Ceylan::Uint32 offset )
+{
+
+  return static_cast<Ceylan::Uint8>( content[offset] )
+	| ( static_cast<Ceylan::Uint8>( content[offset+1] ) << 8 )
+	| ( static_cast<Ceylan::Uint8>( content[offset+2] ) << 16 )
+	| ( static_cast<Ceylan::Uint32>(
+	  static_cast<Ceylan::Uint8>( content[offset+3] ) ) << 24 ) ;
+
+}
+
+
+
+/// Checks that both surfaces have the same dimensions and pixel rows.
+void checkSameSurfaces( Surface & expected, Surface & actual,
+  const std::string & context )
+{
+
+  if ( actual.getWidth() != expected.getWidth()
+	  || actual.getHeight() != expected.getHeight()
+	  || actual.getBitsPerPixel() != expected.getBitsPerPixel() )
+	throw Ceylan::TestException( context + ": loaded surface is "
+	  + Ceylan::toString( actual.getWidth() ) + "x"
+	  + Ceylan::toString( actual.getHeight() ) + " with "
+	  + Ceylan::toNumericalString( actual.getBitsPerPixel() )
+	  + " bits per pixel, whereas "
+	  + Ceylan::toString( expected.getWidth() ) + "x"
+	  + Ceylan::toString( expected.getHeight() ) + " with "
+	  + Ceylan::toNumericalString( expected.getBitsPerPixel() )
+	  + " were expected." ) ;
+
+  expected.lock() ;
+  actual.lock() ;
+
+  Ceylan::Uint32 rowSize = expected.getWidth()
+	* expected.getBytesPerPixel() ;
+
+  const Ceylan::Uint8 * expectedPixels =
+	static_cast<const Ceylan::Uint8 *>( expected.getPixels() ) ;
+
+  const Ceylan::Uint8 * actualPixels =
+	static_cast<const Ceylan::Uint8 *>( actual.getPixels() ) ;
+
+  Length differingRow = expected.getHeight() ;
+
+  for ( Length y = 0; y < expected.getHeight(); y++ )
+  {
+
+	if ( ::memcmp( expectedPixels + y * expected.getPitch(),
+		actualPixels + y * actual.getPitch(), rowSize ) != 0 )
+	{
+	  differingRow = y ;
+	  break ;
+	}
+
+  }
+
+  actual.unlock() ;
+  expected.unlock() ;
+
+  if ( differingRow != expected.getHeight() )
+	throw Ceylan::TestException( context + ": row #"
+	  + Ceylan::toString( differingRow )
+	  + " of the loaded surface differs from the saved one." ) ;
+
+}
+
+
+
+/**
+ * Saves specified surface, checks whether its payload was stored compressed
+ * as expected, then loads it back and checks it is unchanged.
+ *
+ */
+void checkRoundTrip( Surface & source, const std::string & filename,
+  bool compress, bool expectCompressed )
+{
+
+  Image::SaveRaw( source, filename, compress ) ;
+
+  std::vector<Ceylan::Byte> content ;
+  readWholeFile( filename, content ) ;
+
+  Ceylan::Uint32 payloadSize = source.getPitch() * source.getHeight() ;
+  Ceylan::Uint32 storedSize = readUint32At( content, StoredSizeOffset ) ;
+
+  bool compressed = ( ( content[FlagsOffset] & CompressedFlag ) != 0 ) ;
+
+  LogPlug::info( "'" + filename + "' stores " + Ceylan::toString( storedSize )
+	+ " bytes for a payload of " + Ceylan::toString( payloadSize )
+	+ " bytes" + ( compressed ? " (compressed)." : " (uncompressed)." ) ) ;
+
+  if ( compressed != expectCompressed )
+	throw Ceylan::TestException( "'" + filename + "' should"
+	  + ( expectCompressed ? "" : " not" ) + " be compressed." ) ;
+
+  if ( compressed )
+  {
+
+	if ( storedSize >= payloadSize
+		|| content.size() != PayloadOffset + storedSize )
+	  throw Ceylan::TestException( "'" + filename
+		+ "' is not smaller than its uncompressed payload." ) ;
+
+  }
+  else
+  {
+
+	if ( storedSize != payloadSize
+		|| content.size() != PayloadOffset + payloadSize )
+	  throw Ceylan::TestException( "'" + filename
+		+ "' does not store its payload as is." ) ;
+
+  }
+
+  Surface * loaded = new Surface( Surface::Software, 1, 1 ) ;
+
+  try
+  {
+
+	Image::LoadRaw( *loaded, filename ) ;
+	checkSameSurfaces( source, *loaded, filename ) ;
+
+  }
+  catch( ... )
+  {
+
+	delete loaded ;
+	throw ;
+
+  }
+
+  delete loaded ;
+
+}
+
+
+
+/// Checks that loading the specified (corrupted) raw image fails cleanly.
+void checkRejected( const std::string & filename,
+  const std::vector<Ceylan::Byte> & content, const std::string & corruption )
+{
+
+  writeWholeFile( filename, content ) ;
+
+  Surface * loaded = new Surface( Surface::Software, 1, 1 ) ;
+
+  bool rejected = false ;
+
+  try
+  {
+
+	Image::LoadRaw( *loaded, filename ) ;
+
+  }
+  catch( const ImageException & e )
+  {
+
+	LogPlug::info( "Raw image with " + corruption + " rejected as expected: "
+	  + e.toString() ) ;
+	rejected = true ;
+
+  }
+
+  delete loaded ;
+
+  if ( ! rejected )
+	throw Ceylan::TestException( "Raw image with " + corruption
+	  + " should have been rejected." ) ;
+
+}
+
+
+
+/**
+ * Tests the saving and loading of OSDL raw images, with compressible,
+ * incompressible and corrupted payloads.
+ *
+ */
+int main( int argc, char * argv[] )
+{
+
+  {
+
+	LogHolder myLog( argc, argv ) ;
+
+
+	try
+	{
+
+
+	  LogPlug::info( "Testing OSDL raw images." ) ;
+
+	  OSDL::getCommonModule( CommonModule::UseVideo ) ;
+
+	  const Length width  = 120 ;
+	  const Length height = 90 ;
+
+
+	  LogPlug::info( "Round trips of a compressible surface "
+		"(horizontal bands)." ) ;
+
+	  Surface bands( Surface::Software, width, height, 32 ) ;
+
+	  bands.lock() ;
+
+	  for ( Length y = 0; y < height; y++ )
+		for ( Length x = 0; x < width; x++ )
+		  bands.putRGBAPixelAt( x, y, /* red */ ( y / 8 ) * 20,
+			/* green */ 255 - ( y / 8 ) * 20, /* blue */ 128,
+			Pixels::AlphaOpaque ) ;
+
+	  bands.unlock() ;
+
+	  checkRoundTrip( bands, "bands-compressed.osdl.raw",
+		/* compress */ true, /* expectCompressed */ true ) ;
+
+	  checkRoundTrip( bands, "bands-uncompressed.osdl.raw",
+		/* compress */ false, /* expectCompressed */ false ) ;
+
+
+	  LogPlug::info( "Round trip of an incompressible surface "
+		"(white noise)." ) ;
+
+	  Surface noise( Surface::Software, width, height, 32 ) ;
+
+	  noise.lock() ;
+
+	  Ceylan::Uint32 seed = 12345 ;
+
+	  for ( Length y = 0; y < height; y++ )
+		for ( Length x = 0; x < width; x++ )
+		{
+
+		  // A linear congruential generator, for reproducibility:
+		  seed = seed * 1664525 + 1013904223 ;
+
+		  noise.putRGBAPixelAt( x, y, ( seed >> 24 ) & 0xff,
+			( seed >> 16 ) & 0xff, ( seed >> 8 ) & 0xff,
+			Pixels::AlphaOpaque ) ;
+
+		}
+
+	  noise.unlock() ;
+
+	  checkRoundTrip( noise, "noise.osdl.raw", /* compress */ true,
+		/* expectCompressed */ false ) ;
+
+
+	  LogPlug::info( "Loading of corrupted raw images." ) ;
+
+	  std::vector<Ceylan::Byte> reference ;
+	  readWholeFile( "bands-compressed.osdl.raw", reference ) ;
+
+	  std::vector<Ceylan::Byte> corrupted( reference ) ;
+
+	  for ( Ceylan::Uint32 i = PayloadOffset; i < corrupted.size(); i++ )
+		corrupted[i] = static_cast<Ceylan::Byte>( 0xff ) ;
+
+	  checkRejected( "corrupted.osdl.raw", corrupted,
+		"a scrambled compressed payload" ) ;
+
+	  corrupted = reference ;
+	  corrupted.resize( reference.size() - 10 ) ;
+
+	  checkRejected( "corrupted.osdl.raw", corrupted, "a truncated payload" ) ;
+
+	  corrupted = reference ;
+	  corrupted[FlagsOffset] = static_cast<Ceylan::Byte>(
+		corrupted[FlagsOffset] & ~CompressedFlag ) ;
+
+	  checkRejected( "corrupted.osdl.raw", corrupted,
+		"a compressed payload flagged as uncompressed" ) ;
+
+	  corrupted = reference ;
+	  corrupted[0] = static_cast<Ceylan::Byte>( ~corrupted[0] ) ;
+
+	  checkRejected( "corrupted.osdl.raw", corrupted, "a wrong tag" ) ;
+
+
+	  LogPlug::info( "End of OSDL raw image test." ) ;
+
+	  OSDL::stop() ;
+
+
+	}
+
+	catch ( const OSDL::Exception & e )
+	{
+
+	  LogPlug::error( "OSDL exception caught: "
+		+ e.toString( Ceylan::high ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const Ceylan::Exception & e )
+	{
+
+	  LogPlug::error( "Ceylan exception caught: "
+		+ e.toString( Ceylan::high ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const std::exception & e )
+	{
+
+	  LogPlug::error( "Standard exception caught: "
+		+ std::string( e.what() ) ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( ... )
+	{
+
+	  LogPlug::error( "Unknown exception caught" ) ;
+	  return Ceylan::ExitFailure ;
+
+	}
+
+  }
+
+  OSDL::shutdown() ;
+
+  return Ceylan::ExitSuccess ;
+
+}
@@ -0,0 +1,584 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDL.h"
+using namespace OSDL ;
+
+
+using namespace Ceylan ;
+using namespace Ceylan::Log ;
+using namespace Ceylan::System ;
+
+using namespace std ;
+
+
+
+#include <iostream>  // for cout
+#include <algorithm> // for sort
+#include <deque>
+#include <map>
+
+
+
+const std::string Usage = " [--check-mountable] | [--jobs <count>] [--chunk-size <bytes>] [--no-cypher] <content directory> <archive filename>\nBuilds an OSDL indexed archive (*.oar) from all the files found in the specified directory (not included itself), whose names and contents are cyphered, unless --no-cypher is specified, as the embedded filesystem expects them. Each file is compressed per chunk (by default of " + Ceylan::toString( IndexedArchive::DefaultChunkSize ) + " bytes), so that it can be read from any position without decompressing it from its start. Files of identical contents are stored once. Files are prepared by as many workers as there are cores, unless a job count is specified. Empty directories are not stored. With --check-mountable, no archive is built: the exit status tells whether this OSDL build can mount indexed archives (it must be linked to PhysicsFS 3.0 or later)." ;
+
+
+
+std::string getUsage( const std::string & execName ) throw()
+{
+
+	return "Usage: " + execName + Usage ;
+
+}
+
+
+
+/// The maximum number of prepared members waiting to be written, per worker.
+const Ceylan::Uint32 PendingMembersPerWorker = 4 ;
+
+
+
+/**
+ * Prepares a member of the archive: reads, hashes, cyphers and compresses it.
+ *
+ */
+class MemberJob : public Job
+{
+
+	public:
+
+
+		MemberJob( const string & sourcePath, Ceylan::Uint32 chunkSize,
+				bool cypher ) :
+			Job( sourcePath ),
+			_sourcePath( sourcePath ),
+			_chunkSize( chunkSize ),
+			_cypher( cypher ),
+			_size( 0 ),
+			_contentHash( 0 )
+		{
+
+		}
+
+
+		virtual void execute()
+		{
+
+			File & inputFile = StandardFile::Open( _sourcePath ) ;
+
+			vector<Ceylan::Byte> content ;
+
+			try
+			{
+
+				_size = inputFile.size() ;
+
+				content.resize( _size ) ;
+
+				if ( _size != 0 )
+					inputFile.readExactLength( & content[0], _size ) ;
+
+			}
+			catch( ... )
+			{
+
+				delete & inputFile ;
+				throw ;
+
+			}
+
+			delete & inputFile ;
+
+			if ( _size == 0 )
+				return ;
+
+			_contentHash = Utils::hashContent( & content[0], _size ) ;
+
+			if ( _cypher )
+				EmbeddedFile::CypherBuffer( & content[0], _size ) ;
+
+			IndexedArchive::CompressChunks( & content[0], _size, _chunkSize,
+				_compressed, _chunkLengths ) ;
+
+		}
+
+
+		Size getSize() const
+		{
+
+			return _size ;
+
+		}
+
+
+		/// Returns the hash of the (clear) content, null if empty.
+		Ceylan::Uint64 getContentHash() const
+		{
+
+			return _contentHash ;
+
+		}
+
+
+		const vector<Ceylan::Byte> & getCompressed() const
+		{
+
+			return _compressed ;
+
+		}
+
+
+		const vector<Ceylan::Uint32> & getChunkLengths() const
+		{
+
+			return _chunkLengths ;
+
+		}
+
+
+	private:
+
+		string _sourcePath ;
+
+		Ceylan::Uint32 _chunkSize ;
+
+		bool _cypher ;
+
+		Size _size ;
+
+		Ceylan::Uint64 _contentHash ;
+
+		vector<Ceylan::Byte> _compressed ;
+
+		vector<Ceylan::Uint32> _chunkLengths ;
+
+} ;
+
+
+
+/**
+ * Adds to the specified list the paths, relative to the specified root, of all
+ * files found in the specified directory, recursively.
+ *
+ */
+void listFiles( const string & root, const string & relativePath,
+	list<string> & files )
+{
+
+	string path = relativePath.empty() ? root : root + "/" + relativePath ;
+
+	Directory & directory = StandardDirectory::Open( path ) ;
+
+	list<string> entries ;
+	list<string> subdirectories ;
+
+	try
+	{
+
+		directory.getFiles( entries ) ;
+		directory.getSubdirectories( subdirectories ) ;
+
+	}
+	catch( ... )
+	{
+
+		delete & directory ;
+		throw ;
+
+	}
+
+	delete & directory ;
+
+	string prefix = relativePath.empty() ? string() : relativePath + "/" ;
+
+	for ( list<string>::const_iterator it = entries.begin();
+		it != entries.end(); it++ )
+		files.push_back( prefix + *it ) ;
+
+	for ( list<string>::const_iterator it = subdirectories.begin();
+			it != subdirectories.end(); it++ )
+		listFiles( root, prefix + *it, files ) ;
+
+}
+
+
+
+int main( int argc, char * argv[] )
+{
+
+	LogHolder myLog( argc, argv ) ;
+
+
+	try
+	{
+
+
+		LogPlug::info( "Building an OSDL indexed archive." ) ;
+
+		std::string executableName ;
+		std::list<std::string> options ;
+
+		Ceylan::parseCommandLineOptions( executableName, options, argc, argv ) ;
+
+		std::string token ;
+
+		string contentDirectory ;
+		string archiveFilename ;
+
+		Ceylan::Uint32 jobCount = 0 ;
+		Ceylan::Uint32 chunkSize = IndexedArchive::DefaultChunkSize ;
+		bool cypher = true ;
+
+		while ( ! options.empty() )
+		{
+
+			token = options.front() ;
+			options.pop_front() ;
+
+			if ( LogHolder::IsAKnownPlugOption( token ) )
+			{
+				// Ignores log-related (argument-less) options.
+				continue ;
+			}
+
+			if ( token == "--jobs" || token == "--chunk-size" )
+			{
+
+				if ( options.empty() )
+				{
+
+					cerr << "Error, no value specified for option '" + token
+						+ "'.\n" + getUsage( argv[0] ) << endl ;
+					exit( 2 ) ;
+
+				}
+
+				Ceylan::Uint32 value = static_cast<Ceylan::Uint32>(
+					Ceylan::stringToUnsignedLong( options.front() ) ) ;
+
+				options.pop_front() ;
+
+				if ( token == "--jobs" )
+					jobCount = value ;
+				else
+					chunkSize = value ;
+
+				continue ;
+
+			}
+
+			if ( token == "--no-cypher" )
+			{
+
+				cypher = false ;
+				continue ;
+
+			}
+
+			if ( token == "--check-mountable" )
+			{
+
+				if ( IndexedArchive::IsMountable() )
+				{
+
+					cout << "Indexed archives can be mounted." << endl ;
+					exit( 0 ) ;
+
+				}
+
+				cerr << "Indexed archives cannot be mounted by this OSDL "
+					"build, which requires PhysicsFS 3.0 or later." << endl ;
+				exit( 9 ) ;
+
+			}
+
+			if ( contentDirectory.empty() )
+			{
+
+				contentDirectory = token ;
+
+			}
+			else if ( archiveFilename.empty() )
+			{
+
+				archiveFilename = token ;
+
+			}
+			else
+			{
+
+				cerr << "Unexpected command line argument: '" + token
+					+ "'.\n" + getUsage( argv[0] ) << endl ;
+				exit( 1 ) ;
+
+			}
+
+		} // while
+
+
+		if ( archiveFilename.empty() )
+		{
+
+			cerr << "Error, content directory and archive filename expected.\n"
+				+ getUsage( argv[0] ) << endl ;
+			exit( 4 ) ;
+
+		}
+
+		if ( ! Directory::Exists( contentDirectory ) )
+		{
+
+			cerr << "Error, content directory '" << contentDirectory
+				<< "' not found.\n" + getUsage( argv[0] ) << endl ;
+			exit( 5 ) ;
+
+		}
+
+		if ( chunkSize == 0 || chunkSize > IndexedArchive::MaximumChunkSize )
+		{
+
+			cerr << "Error, chunk size must be in [1;"
+				+ Ceylan::toString( IndexedArchive::MaximumChunkSize )
+				+ "].\n" + getUsage( argv[0] ) << endl ;
+			exit( 6 ) ;
+
+		}
+
+		list<string> files ;
+		listFiles( contentDirectory, "", files ) ;
+
+		/*
+		 * Members are sorted by their name as stored (ROT13-encoded if
+		 * cyphering), and written in that order:
+		 *
+		 */
+		vector< pair<string,string> > members ;
+
+		for ( list<string>::const_iterator it = files.begin();
+				it != files.end(); it++ )
+			members.push_back( make_pair(
+				cypher ? Ceylan::encodeToROT13( *it ) : *it, *it ) ) ;
+
+		sort( members.begin(), members.end() ) ;
+
+		Ceylan::Uint32 memberCount =
+			static_cast<Ceylan::Uint32>( members.size() ) ;
+
+		WorkerPool pool( jobCount, "archive builder" ) ;
+
+		Ceylan::Uint32 maxPending =
+			pool.getWorkerCount() * PendingMembersPerWorker ;
+
+		cout << "Building '" << archiveFilename << "' from " << memberCount
+			<< " file(s) of '" << contentDirectory << "', with "
+			<< pool.getWorkerCount() << " worker(s)." << endl ;
+
+		vector<string> names( memberCount ) ;
+		vector<Size> sizes( memberCount ) ;
+		vector< vector<Ceylan::Uint32> > chunkLengths( memberCount ) ;
+		vector<Ceylan::Uint32> sharedWith( memberCount ) ;
+
+		/*
+		 * The members stored for each content hash and size; more than one
+		 * only if different contents collide:
+		 *
+		 */
+		multimap< pair<Ceylan::Uint64,Size>, Ceylan::Uint32 > storedContents ;
+
+		Ceylan::Uint32 sharedCount = 0 ;
+
+		File & archiveFile = StandardFile::Create( archiveFilename ) ;
+
+		// Header, written last:
+		vector<Ceylan::Byte> header( IndexedArchive::HeaderSize, 0 ) ;
+		archiveFile.write( & header[0], header.size() ) ;
+
+		// Offsets are 32-bit:
+		Ceylan::Uint64 archiveSize = IndexedArchive::HeaderSize ;
+
+		deque<MemberJob *> pending ;
+
+		Ceylan::Uint32 nextSubmitted = 0 ;
+
+		for ( Ceylan::Uint32 i = 0; i < memberCount; i++ )
+		{
+
+			// Keeps the workers busy, while bounding memory use:
+			while ( nextSubmitted < memberCount
+				&& pending.size() < maxPending )
+			{
+
+				MemberJob * job = new MemberJob( contentDirectory + "/"
+					+ members[nextSubmitted].second, chunkSize, cypher ) ;
+
+				pool.submit( * job ) ;
+				pending.push_back( job ) ;
+
+				nextSubmitted++ ;
+
+			}
+
+			MemberJob * job = pending.front() ;
+			pending.pop_front() ;
+
+			pool.waitFor( * job ) ;
+
+			if ( pool.getStateOf( * job ) != Job::Completed )
+			{
+
+				string reason = pool.getFailureReasonFor( * job ) ;
+
+				// Lets the workers finish before deleting their jobs:
+				pool.waitForAll() ;
+
+				delete job ;
+
+				for ( deque<MemberJob *>::iterator it = pending.begin();
+						it != pending.end(); it++ )
+					delete *it ;
+
+				cerr << "Error, unable to prepare '" << members[i].second
+					<< "': " << reason << endl ;
+				exit( 7 ) ;
+
+			}
+
+			names[i]      = members[i].first ;
+			sizes[i]      = job->getSize() ;
+			sharedWith[i] = i ;
+
+			/*
+			 * Identical contents are stored once; equal hashes and sizes are
+			 * not enough to tell, bytes are compared as well:
+			 *
+			 */
+			if ( job->getContentHash() != 0 )
+			{
+
+				pair<Ceylan::Uint64,Size> key( job->getContentHash(),
+					job->getSize() ) ;
+
+				typedef multimap< pair<Ceylan::Uint64,Size>,
+					Ceylan::Uint32 >::const_iterator StoredIterator ;
+
+				pair<StoredIterator,StoredIterator> candidates =
+					storedContents.equal_range( key ) ;
+
+				for ( StoredIterator it = candidates.first;
+						it != candidates.second; it++ )
+					if ( Utils::haveSameContent(
+							contentDirectory + "/" + members[i].second,
+							contentDirectory + "/"
+								+ members[(*it).second].second ) )
+					{
+
+						sharedWith[i] = (*it).second ;
+						break ;
+
+					}
+
+				if ( sharedWith[i] != i )
+				{
+
+					sharedCount++ ;
+
+					delete job ;
+					continue ;
+
+				}
+
+				storedContents.insert( make_pair( key, i ) ) ;
+
+			}
+
+			archiveSize += job->getCompressed().size() ;
+
+			if ( archiveSize > 0xffffffff )
+			{
+
+				cerr << "Error, archive '" << archiveFilename
+					<< "' would exceed 4 GiB." << endl ;
+				exit( 8 ) ;
+
+			}
+
+			if ( ! job->getCompressed().empty() )
+				archiveFile.write( & job->getCompressed()[0],
+					job->getCompressed().size() ) ;
+
+			chunkLengths[i] = job->getChunkLengths() ;
+
+			delete job ;
+
+		}
+
+		IndexedArchive::WriteDirectory( archiveFile, chunkSize, names, sizes,
+			chunkLengths, sharedWith ) ;
+
+		delete & archiveFile ;
+
+		cout << "Successfully built '" << archiveFilename << "', "
+			<< memberCount << " files stored in " << archiveSize
+			<< " bytes (directory excluded), " << sharedCount
+			<< " of them sharing the content of another one." << endl ;
+
+
+   }
+
+	catch ( const OSDL::Exception & e )
+	{
+		LogPlug::error( "OSDL exception caught: "
+			 + e.toString( Ceylan::high ) ) ;
+		return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const Ceylan::Exception & e )
+	{
+		LogPlug::error( "Ceylan exception caught: "
+			 + e.toString( Ceylan::high ) ) ;
+		return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const std::exception & e )
+	{
+		LogPlug::error( "Standard exception caught: "
+			 + std::string( e.what() ) ) ;
+		return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( ... )
+	{
+		LogPlug::error( "Unknown exception caught" ) ;
+		return Ceylan::ExitFailure ;
+
+	}
+
+	return Ceylan::ExitSuccess ;
+
+}
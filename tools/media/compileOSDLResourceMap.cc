@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDL.h"
+using namespace OSDL ;
+
+
+using namespace Ceylan ;
+using namespace Ceylan::Log ;
+using namespace Ceylan::System ;
+
+using namespace std ;
+
+
+
+#include <iostream>  // for cout
+
+
+const std::string Usage = " [--hash-from <content directory>] <an OSDL XML resource map> [<index filename>]\nCompiles the specified resource map (as produced by create-OSDL-archive.sh) into a binary resource index, which a ResourceManager can load without parsing XML. By default the index is written next to the map, with the same basename and the '" + Data::ResourceIndex::FileExtension + "' extension. If a content directory is specified, the resources, whose paths are relative to it, are hashed, so that the ResourceManager shares a single instance between the resources of identical contents." ;
+
+
+
+std::string getUsage( const std::string & execName ) throw()
+{
+
+	return "Usage: " + execName + Usage ;
+
+}
+
+
+
+int main( int argc, char * argv[] )
+{
+
+	LogHolder myLog( argc, argv ) ;
+
+
+	try
+	{
+
+
+		LogPlug::info( "Compiling an OSDL resource map." ) ;
+
+		std::string executableName ;
+		std::list<std::string> options ;
+
+		Ceylan::parseCommandLineOptions( executableName, options, argc, argv ) ;
+
+		std::string token ;
+
+		string mapFilename ;
+		string indexFilename ;
+		string contentDirectory ;
+
+		while ( ! options.empty() )
+		{
+
+			token = options.front() ;
+			options.pop_front() ;
+
+			if ( LogHolder::IsAKnownPlugOption( token ) )
+			{
+				// Ignores log-related (argument-less) options.
+				continue ;
+			}
+
+			if ( token == "--hash-from" )
+			{
+
+				if ( options.empty() )
+				{
+
+					cerr << "Error, no content directory specified.\n"
+						+ getUsage( argv[0] ) << endl ;
+					exit( 2 ) ;
+
+				}
+
+				contentDirectory = options.front() ;
+				options.pop_front() ;
+
+				continue ;
+
+			}
+
+			if ( mapFilename.empty() )
+			{
+
+				mapFilename = token ;
+
+			}
+			else if ( indexFilename.empty() )
+			{
+
+				indexFilename = token ;
+
+			}
+			else
+			{
+
+				cerr << "Unexpected command line argument: '" + token
+					+ "'.\n" + getUsage( argv[0] ) << endl ;
+				exit( 1 ) ;
+
+			}
+
+		} // while
+
+
+		if ( mapFilename.empty() )
+		{
+
+			cerr << "Error, no resource map specified.\n"
+				+ getUsage( argv[0] ) << endl ;
+			exit( 4 ) ;
+
+		}
+
+		if ( ! File::ExistsAsFileOrSymbolicLink( mapFilename ) )
+		{
+
+			cerr << "Error, resource map '" << mapFilename << "' not found.\n"
+				+ getUsage( argv[0] ) << endl ;
+			exit( 5 ) ;
+
+		}
+
+		if ( indexFilename.empty() )
+		{
+
+			string::size_type dotPos = mapFilename.rfind( '.' ) ;
+
+			indexFilename = mapFilename.substr( 0, dotPos )
+				+ Data::ResourceIndex::FileExtension ;
+
+		}
+
+		Ceylan::Uint32 count = Data::ResourceManager::CompileResourceMap(
+			mapFilename, indexFilename, contentDirectory ) ;
+
+		cout << "Successfully compiled '" << mapFilename << "' into '"
+			<< indexFilename << "', " << count << " resources indexed."
+			<< endl ;
+
+
+   }
+
+	catch ( const OSDL::Exception & e )
+	{
+		LogPlug::error( "OSDL exception caught: "
+			 + e.toString( Ceylan::high ) ) ;
+		return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const Ceylan::Exception & e )
+	{
+		LogPlug::error( "Ceylan exception caught: "
+			 + e.toString( Ceylan::high ) ) ;
+		return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const std::exception & e )
+	{
+		LogPlug::error( "Standard exception caught: "
+			 + std::string( e.what() ) ) ;
+		return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( ... )
+	{
+		LogPlug::error( "Unknown exception caught" ) ;
+		return Ceylan::ExitFailure ;
+
+	}
+
+	return Ceylan::ExitSuccess ;
+
+}
@@ -153,6 +153,126 @@ void interpretFrameFile( File & inputFile )
 
 
 
+void interpretRawImageFile( File & inputFile )
+{
+
+	cout << "  + Format version: "
+		<< Ceylan::toNumericalString( inputFile.readUint8() ) << "." << endl ;
+
+	Ceylan::Uint8 flags = inputFile.readUint8() ;
+
+	Ceylan::Uint16 width  = inputFile.readUint16() ;
+	Ceylan::Uint16 height = inputFile.readUint16() ;
+
+	cout << "  + Dimensions: " << width << "x" << height << " pixels." << endl ;
+
+	cout << "  + Color depth: "
+		<< Ceylan::toNumericalString( inputFile.readUint8() )
+		<< " bits per pixel." << endl ;
+
+	// Skips the bytes per pixel:
+	inputFile.readUint8() ;
+
+	cout << "  + Pitch: " << inputFile.readUint16() << " bytes." << endl ;
+
+	// Skips the red, green, blue and alpha masks:
+	for ( Ceylan::Uint8 i = 0; i < 4; i++ )
+		inputFile.readUint32() ;
+
+	Ceylan::Uint32 colorkey = inputFile.readUint32() ;
+
+	if ( flags & 1 )
+		cout << "  + Color key defined, to pixel value " << colorkey << "."
+			<< endl ;
+	else
+		cout << "  + No color key defined." << endl ;
+
+	Ceylan::Uint8 alpha = inputFile.readUint8() ;
+
+	if ( flags & 2 )
+		cout << "  + Per-surface alpha set to "
+			<< Ceylan::toNumericalString( alpha ) << "." << endl ;
+
+	// Reserved byte:
+	inputFile.readUint8() ;
+
+	cout << "  + Palette: " << inputFile.readUint16() << " colors." << endl ;
+
+	Ceylan::Uint32 storedSize  = inputFile.readUint32() ;
+	Ceylan::Uint32 payloadSize = inputFile.readUint32() ;
+
+	if ( flags & 4 )
+		cout << "  + Pixels stored LZ4-compressed, " << storedSize
+			<< " bytes for " << payloadSize << " bytes." << endl ;
+	else
+		cout << "  + Pixels stored uncompressed, " << payloadSize
+			<< " bytes." << endl ;
+
+}
+
+
+
+void interpretAtlasIndexFile( File & inputFile )
+{
+
+	cout << "  + Format version: "
+		<< Ceylan::toNumericalString( inputFile.readUint8() ) << "." << endl ;
+
+	// Reserved byte:
+	inputFile.readUint8() ;
+
+	cout << "  + Number of pages: " << inputFile.readUint16() << "." << endl ;
+
+	cout << "  + Number of packed images: " << inputFile.readUint32() << "."
+		<< endl ;
+
+}
+
+
+
+void interpretResourceIndexFile( File & inputFile )
+{
+
+	cout << "  + Format version: "
+		<< Ceylan::toNumericalString( inputFile.readUint8() ) << "." << endl ;
+
+	// Reserved byte:
+	inputFile.readUint8() ;
+
+	cout << "  + Number of resources: " << inputFile.readUint32() << "."
+		<< endl ;
+
+	cout << "  + Number of hash buckets: " << inputFile.readUint32() << "."
+		<< endl ;
+
+	cout << "  + Number of groups: " << inputFile.readUint32() << "." << endl ;
+
+}
+
+
+
+void interpretArchiveFile( File & inputFile )
+{
+
+	cout << "  + Format version: "
+		<< Ceylan::toNumericalString( inputFile.readUint8() ) << "." << endl ;
+
+	// Reserved byte:
+	inputFile.readUint8() ;
+
+	cout << "  + Chunk size: " << inputFile.readUint32() << " bytes." << endl ;
+
+	cout << "  + Number of members: " << inputFile.readUint32() << "."
+		<< endl ;
+
+	cout << "  + Number of chunks: " << inputFile.readUint32() << "." << endl ;
+
+	cout << "  + Directory offset: " << inputFile.readUint32() << "." << endl ;
+
+}
+
+
+
 int main( int argc, char * argv[] )
 {
 
@@ -267,6 +387,14 @@ int main( int argc, char * argv[] )
 			interpretPaletteFile( inputFile ) ;
 		else if ( tag == OSDL::FrameTag )
 			interpretFrameFile( inputFile ) ;
+		else if ( tag == OSDL::RawImageTag )
+			interpretRawImageFile( inputFile ) ;
+		else if ( tag == OSDL::AtlasIndexTag )
+			interpretAtlasIndexFile( inputFile ) ;
+		else if ( tag == OSDL::ResourceIndexTag )
+			interpretResourceIndexFile( inputFile ) ;
+		else if ( tag == OSDL::ArchiveTag )
+			interpretArchiveFile( inputFile ) ;
 
 		delete & inputFile ;
 
@@ -44,6 +44,8 @@ using namespace std ;
 
 
 #include <iostream>  // for cout
+#include <fstream>   // for ifstream
+#include <vector>
 
 
 const string paletteFilePrefix = "master-palette" ;
@@ -77,18 +79,94 @@ const string gammaPalFilename = paletteFilePrefix + quantizedFileSuffix
 	+ gammaFileSuffix + palExtension ;
 
 
+const string optimizedFileSuffix = "-optimized" ;
+
+const string optimizedPaletteFilename = paletteFilePrefix
+	+ optimizedFileSuffix + osdlPaletteExtension ;
+
+const string optimizedPalFilename = paletteFilePrefix + optimizedFileSuffix
+	+ palExtension ;
+
+const string optimizedQuantizedPaletteFilename = paletteFilePrefix
+	+ optimizedFileSuffix + quantizedFileSuffix + osdlPaletteExtension ;
+
+const string optimizedQuantizedPalFilename = paletteFilePrefix
+	+ optimizedFileSuffix + quantizedFileSuffix + palExtension ;
+
+
 Pixels::GammaFactor gamma = 2.3 ;
 
 
-const std::string Usage = " [ -h ]: generates a 256-color quantized non-gamma corrected main master palette and saves it under a file named '"
+const std::string Usage = " [ -h ] [ -n color_count ] [ -m median-cut|k-means ] [ -w worker_count ] [ -l image_list_file ] [ X.png ... ]: generates a 256-color quantized non-gamma corrected main master palette and saves it under a file named '"
 	+ quantizedPaletteFilename + "'. For documentary purpose, saves under a file named '" + originalFileSuffix + "' the original (non-quantized) palette and under a file named '" + gammaPaletteFilename + "' a quantized then gamma-corrected version of the original palette as well."
 "\n\t-h: displays this help"
+"\n\t-n: the number of colors of the optimized palette, colorkey included (default: 256)"
+"\n\t-m: the method used to generate the optimized palette (default: k-means)"
+"\n\t-w: the number of worker threads used to generate the optimized palette (default: one per processor)"
+"\n\t-l: a file listing, one per line, the images to generate the optimized palette from (in addition to the ones specified on the command line)"
+"\nIf images are specified, an optimized palette is generated instead, from the colors they actually use, and saved under a file named '" + optimizedPaletteFilename + "', together with its quantized version, '" + optimizedQuantizedPaletteFilename + "'. Images are read one at a time by each worker, and their colors are counted in fixed-size histograms, thus any number of images can be processed in bounded memory."
 "\nThe main palette ('" + quantizedPaletteFilename + "') is dedicated to color-reduction of any frame image. It stores all the color definitions of the palette in an unencoded form (8 bits per color component, but quantized as it would be in 5 bits, and not gamma-corrected), in RGB order. A default colorkey is defined, Magenta, in index #0." 
 "\nPalette files can be converted into palette images thanks to: 'make master-palette-original.png' (in trunk/tools/media/video/animation-management)";
 
 
 
 
+/**
+ * Counts the colors of a series of images in its own histogram.
+ *
+ * Images are loaded and counted one at a time, as plain SDL surfaces, as
+ * Surface::LoadImage must not be called from worker threads.
+ *
+ */
+class HistogramJob : public OSDL::Job
+{
+
+	public:
+
+
+		HistogramJob( const string & name ) :
+			OSDL::Job( name )
+		{
+
+		}
+
+
+		void addImage( const string & imageFilename )
+		{
+
+			_imageFilenames.push_back( imageFilename ) ;
+
+		}
+
+
+		const ColorHistogram & getHistogram() const
+		{
+
+			return _histogram ;
+
+		}
+
+
+		virtual void execute()
+		{
+
+			for ( list<string>::const_iterator it = _imageFilenames.begin();
+					it != _imageFilenames.end(); it++ )
+				_histogram.addImage( *it ) ;
+
+		}
+
+
+	protected:
+
+		list<string> _imageFilenames ;
+
+		ColorHistogram _histogram ;
+
+} ;
+
+
+
 std::string getUsage( const std::string & execName ) throw()
 {
 
@@ -117,7 +195,14 @@ int main( int argc, char * argv[] )
 		std::string token ;
 		bool tokenEaten ;
 		
-		string inputFilename ;
+		list<string> imageFilenames ;
+
+		ColorCount colorCount = 256 ;
+
+		Palette::GenerationMethod method = Palette::KMeans ;
+
+		// Zero means one worker per processor:
+		Ceylan::Uint32 workerCount = 0 ;
 		
 		while ( ! options.empty() )
 		{
@@ -147,13 +232,98 @@ int main( int argc, char * argv[] )
 			}
 			
 			
+			if ( token == "-n" || token == "-m" || token == "-w"
+				|| token == "-l" )
+			{
+
+				if ( options.empty() )
+				{
+
+					cerr << "Error, parameter lacking for option " + token
+						+ ".\n" + getUsage( argv[0] ) << endl ;
+					exit( 2 ) ;
+
+				}
+
+				string value = options.front() ;
+				options.pop_front() ;
+
+				if ( token == "-n" )
+				{
+
+					colorCount = static_cast<ColorCount>(
+						Ceylan::stringToUnsignedLong( value ) ) ;
+
+				}
+				else if ( token == "-m" )
+				{
+
+					if ( value == "median-cut" )
+					{
+						method = Palette::MedianCut ;
+					}
+					else if ( value == "k-means" )
+					{
+						method = Palette::KMeans ;
+					}
+					else
+					{
+
+						cerr << "Error, unknown generation method: '" + value
+							+ "'.\n" + getUsage( argv[0] ) << endl ;
+						exit( 3 ) ;
+
+					}
+
+				}
+				else if ( token == "-w" )
+				{
+
+					workerCount = static_cast<Ceylan::Uint32>(
+						Ceylan::stringToUnsignedLong( value ) ) ;
+
+				}
+				else
+				{
+
+					ifstream listFile( value.c_str() ) ;
+
+					if ( ! listFile )
+					{
+
+						cerr << "Error, image list file '" + value
+							+ "' could not be read.\n" << endl ;
+						exit( 4 ) ;
+
+					}
+
+					string line ;
+
+					while ( getline( listFile, line ) )
+						if ( ! line.empty() )
+							imageFilenames.push_back( line ) ;
+
+				}
+
+				tokenEaten = true ;
+
+			}
+
+
 			if ( ! tokenEaten )
 			{
-					
-				cerr << "Unexpected command line argument: '" + token 
-					+ "'.\n" + getUsage( argv[0] ) << endl ;
-				exit( 1 ) ;	
-					
+
+				if ( token[0] == '-' )
+				{
+
+					cerr << "Unexpected command line argument: '" + token
+						+ "'.\n" + getUsage( argv[0] ) << endl ;
+					exit( 1 ) ;
+
+				}
+
+				imageFilenames.push_back( token ) ;
+
 			}
 		
 		
@@ -162,6 +332,95 @@ int main( int argc, char * argv[] )
 		
 		
 		
+		if ( ! imageFilenames.empty() )
+		{
+
+			WorkerPool pool( workerCount, "palette generation pool" ) ;
+
+			cout << endl << "Generating the '" << optimizedPaletteFilename
+				<< "' optimized palette of " << colorCount
+				<< " colors from " << imageFilenames.size()
+				<< " image(s), with " << pool.getWorkerCount()
+				<< " worker(s)." << endl << endl ;
+
+			// One histogram job per worker, images being dealt in turn:
+			vector<HistogramJob *> jobs ;
+
+			for ( Ceylan::Uint32 i = 0; i < pool.getWorkerCount(); i++ )
+				jobs.push_back( new HistogramJob( "histogram job #"
+					+ Ceylan::toString( i ) ) ) ;
+
+			Ceylan::Uint32 imageIndex = 0 ;
+
+			for ( list<string>::const_iterator it = imageFilenames.begin();
+					it != imageFilenames.end(); it++ )
+				jobs[ imageIndex++ % jobs.size() ]->addImage( *it ) ;
+
+			for ( vector<HistogramJob *>::iterator it = jobs.begin();
+					it != jobs.end(); it++ )
+				pool.submit( **it ) ;
+
+			pool.waitForAll() ;
+
+			ColorHistogram histogram ;
+
+			string failureReason ;
+
+			// All jobs are deallocated, even once one is known to have failed:
+			for ( vector<HistogramJob *>::iterator it = jobs.begin();
+				it != jobs.end(); it++ )
+			{
+
+				if ( pool.getStateOf( **it ) == Job::Failed )
+				{
+
+					if ( failureReason.empty() )
+						failureReason = pool.getFailureReasonFor( **it ) ;
+
+				}
+				else if ( failureReason.empty() )
+				{
+
+					histogram.merge( (*it)->getHistogram() ) ;
+
+				}
+
+				delete *it ;
+
+			}
+
+			if ( ! failureReason.empty() )
+				throw OSDL::Exception( "Palette generation failed: "
+					+ failureReason ) ;
+
+			LogPlug::info( histogram.toString() ) ;
+
+			Palette & optimizedPalette = Palette::CreateOptimizedPalette(
+				histogram, colorCount, method, /* addColorkey */ true,
+				& pool ) ;
+
+			optimizedPalette.save( optimizedPaletteFilename,
+				/* encoded */ false ) ;
+			optimizedPalette.save( optimizedPalFilename,
+				/* encoded */ true ) ;
+
+			optimizedPalette.quantize( /* quantizeMaxCoordinate */ 31,
+				/* scaleUp */ true ) ;
+
+			optimizedPalette.save( optimizedQuantizedPaletteFilename,
+				/* encoded */ false ) ;
+			optimizedPalette.save( optimizedQuantizedPalFilename,
+				/* encoded */ true ) ;
+
+			delete & optimizedPalette ;
+
+			cout << "Generation of optimized palette succeeded !" << endl ;
+
+			return Ceylan::ExitSuccess ;
+
+		}
+
+
 		cout << endl << "Generating the '" << quantizedPaletteFilename << 
 			"' quantized master palette. "
 			"The original (non-quantized) palette will be stored in '" 
@@ -43,9 +43,11 @@ using namespace std ;
 #include <iostream>  // for cout
 
 
-const std::string Usage = " [ -o abscissa ordinate ] [ -p palette_identifier ] X.png\nConverts a PNG file (X.png) into a OSDL frame file (X.osdl.frame), containing a header, then a tile map, then the corresponding set of tiles. The header references the palette being used, the type of the tile map, and the offset for frame coordinates."
+const std::string Usage = " [ -o abscissa ordinate ] [ -p palette_identifier ] [ -d dithering_mode ] [ -w worker_count ] X.png\nConverts a PNG file (X.png) into a OSDL frame file (X.osdl.frame), containing a header, then a tile map, then the corresponding set of tiles. The header references the palette being used, the type of the tile map, and the offset for frame coordinates."
 	"\n\t -o: specifies the offset of the local referential of this frame to the global referential of the animation it is a part of (default: (0,0) offset)."
 	"\n\t -p: specifies the palette identifier to be used (default: palette #1, i.e. the OSDL default master palette, as generated by 'generateMasterPalette.exe')."
+	"\n\t -d: specifies the dithering mode to be used for the color-reduction, among 'none', 'floyd-steinberg' and 'ordered' (default: none)."
+	"\n\t -w: specifies the number of worker threads the color-reduction is spread over (default: one per processor)."
 	"\nThe source PNG is expected to have been transformed, directly or not, by our 'process-reiner-individual-archive.sh' script: converted, scaled, sharpened, renamed (ex: 18-16-3-1-0.png), gamma-corrected, etc."
 	"\nA palette file named <palette identifier>.osdl.palette is expected to be found: it contains the target palette used for the color-reduction of the PNG file to the OSDL frame."
 	"\nThis program will color-reduce the frame so that it uses the specified palette, and encode the result as appropriate for the Nintendo DS."
@@ -76,6 +78,11 @@ int main( int argc, char * argv[] )
 
 	PaletteIdentifier paletteId = 1 ;
 
+	ColorReducer::DitheringMode dithering = ColorReducer::NoDithering ;
+
+	// Zero means one worker per processor:
+	Ceylan::Uint32 workerCount = 0 ;
+
 	LogHolder myLog( argc, argv ) ;
 
 
@@ -154,6 +161,78 @@ int main( int argc, char * argv[] )
 			}
 
 
+			if ( token == "-d" )
+			{
+
+				if ( options.empty() )
+				{
+
+					cerr << "Error, parameter lacking for dithering mode.\n"
+						+ getUsage( argv[0] ) << endl ;
+
+					exit( 10 ) ;
+
+				}
+
+				string mode = options.front() ;
+				options.pop_front() ;
+
+				if ( mode == "none" )
+				{
+					dithering = ColorReducer::NoDithering ;
+				}
+				else if ( mode == "floyd-steinberg" )
+				{
+					dithering = ColorReducer::FloydSteinbergDithering ;
+				}
+				else if ( mode == "ordered" )
+				{
+					dithering = ColorReducer::OrderedDithering ;
+				}
+				else
+				{
+
+					cerr << "Error, unknown dithering mode: '" + mode
+						+ "'.\n" + getUsage( argv[0] ) << endl ;
+
+					exit( 11 ) ;
+
+				}
+
+				LogPlug::info( "Dithering mode set to "
+					+ ColorReducer::DescribeDitheringMode( dithering ) + "." ) ;
+
+				tokenEaten = true ;
+
+			}
+
+
+			if ( token == "-w" )
+			{
+
+				if ( options.empty() )
+				{
+
+					cerr << "Error, parameter lacking for worker count.\n"
+						+ getUsage( argv[0] ) << endl ;
+
+					exit( 12 ) ;
+
+				}
+
+				workerCount = static_cast<Ceylan::Uint32>(
+					Ceylan::stringToUnsignedLong( options.front() ) ) ;
+
+				options.pop_front() ;
+
+				LogPlug::info( "Worker count set to "
+					+ Ceylan::toString( workerCount ) + "." ) ;
+
+				tokenEaten = true ;
+
+			}
+
+
 			if ( LogHolder::IsAKnownPlugOption( token ) )
 			{
 				// Ignores log-related (argument-less) options.
@@ -265,9 +344,14 @@ int main( int argc, char * argv[] )
 		LogPlug::info( "Palette '" + paletteFilename + "' loaded in: "
 			+ sourcePalette.toString() ) ;
 
-		LogPlug::info( "Color-reducing the source image with this palette." ) ;
-		Surface & colorReducedSurface =
-			sourceSurface.createColorReducedSurfaceFor( sourcePalette ) ;
+		WorkerPool reductionPool( workerCount, "color-reduction pool" ) ;
+
+		ColorReducer reducer( sourcePalette, dithering, & reductionPool ) ;
+
+		LogPlug::info( "Color-reducing the source image with this palette: "
+			+ reducer.toString() ) ;
+
+		Surface & colorReducedSurface = reducer.reduce( sourceSurface ) ;
 
 
 		UprightRectangle & trimmedRect = colorReducedSurface.getContentArea() ;
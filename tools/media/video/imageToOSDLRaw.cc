@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDL.h"
+using namespace OSDL ;
+using namespace OSDL::Video ;
+using namespace OSDL::Video::TwoDimensional ;
+
+
+using namespace Ceylan ;
+using namespace Ceylan::Log ;
+using namespace Ceylan::System ;
+
+using namespace std ;
+
+
+
+#include <iostream>  // for cout
+
+
+const std::string Usage = " [ -f depth ] [ -n ] [ -k ] [ -u ] X.png [ Y.jpg ... ]\nConverts image files (any format supported by OSDL, ex: X.png) into OSDL raw image files (X.osdl.raw), whose pixels are stored already converted, so that loading them (see Image::LoadRaw) involves no decoding nor conversion."
+	"\n\t -f: specifies the color depth of the stored pixels, among 16, 24 and 32 (default: 32). It should be the one of the display the images will be used with."
+	"\n\t -n: stores no alpha channel, for 32-bit images (default: with an alpha channel, as SDL_DisplayFormatAlpha would do)."
+	"\n\t -k: keeps the pixel format of the decoded images, ex: 8-bit color indexed images stay so, to be blitted through IndexedBlitTable instances (default: converted)."
+	"\n\t -u: stores the pixels uncompressed (default: LZ4-compressed whenever it reduces their size)."
+	"\nColorkeyed images should be stored with an alpha channel, or with their own format, as otherwise their transparency is lost."
+	;
+
+
+
+std::string getUsage( const std::string & execName ) throw()
+{
+
+	return "Usage: " + execName + Usage ;
+
+}
+
+
+
+/// Returns the name of the raw image file corresponding to specified image.
+std::string getRawFilenameFor( const std::string & imageFilename )
+{
+
+	string::size_type dotPos = imageFilename.rfind( '.' ) ;
+
+	string::size_type slashPos = imageFilename.find_last_of( "/\\" ) ;
+
+	if ( dotPos == string::npos
+			|| ( slashPos != string::npos && dotPos < slashPos ) )
+		return imageFilename + ".osdl.raw" ;
+
+	return imageFilename.substr( 0, dotPos ) + ".osdl.raw" ;
+
+}
+
+
+
+int main( int argc, char * argv[] )
+{
+
+
+	BitsPerPixel depth = 32 ;
+
+	bool withAlpha = true ;
+
+	bool keepFormat = false ;
+
+	bool compress = true ;
+
+	LogHolder myLog( argc, argv ) ;
+
+
+	try
+	{
+
+
+		LogPlug::info( "Converting images into OSDL raw images." ) ;
+
+
+		std::string executableName ;
+		std::list<std::string> options ;
+
+		Ceylan::parseCommandLineOptions( executableName, options, argc, argv ) ;
+
+		std::string token ;
+		bool tokenEaten ;
+
+		list<string> inputFilenames ;
+
+		while ( ! options.empty() )
+		{
+
+			token = options.front() ;
+			options.pop_front() ;
+
+			tokenEaten = false ;
+
+
+			if ( token == "-f" )
+			{
+
+				if ( options.empty() )
+				{
+
+					cerr << "Error, parameter lacking for color depth.\n"
+						+ getUsage( argv[0] ) << endl ;
+
+					exit( 9 ) ;
+
+				}
+
+				depth = static_cast<BitsPerPixel>(
+					Ceylan::stringToUnsignedLong( options.front() ) ) ;
+
+				options.pop_front() ;
+
+				if ( depth != 16 && depth != 24 && depth != 32 )
+				{
+
+					cerr << "Error, unsupported color depth: "
+						+ Ceylan::toNumericalString( depth ) + ".\n"
+						+ getUsage( argv[0] ) << endl ;
+
+					exit( 10 ) ;
+
+				}
+
+				LogPlug::info( "Color depth set to "
+					+ Ceylan::toNumericalString( depth ) + " bits." ) ;
+
+				tokenEaten = true ;
+
+			}
+
+
+			if ( token == "-n" )
+			{
+
+				LogPlug::info( "No alpha channel will be stored." ) ;
+				withAlpha = false ;
+				tokenEaten = true ;
+
+			}
+
+
+			if ( token == "-k" )
+			{
+
+				LogPlug::info( "Pixel formats of images will be kept." ) ;
+				keepFormat = true ;
+				tokenEaten = true ;
+
+			}
+
+
+			if ( token == "-u" )
+			{
+
+				LogPlug::info( "Pixels will be stored uncompressed." ) ;
+				compress = false ;
+				tokenEaten = true ;
+
+			}
+
+
+			if ( LogHolder::IsAKnownPlugOption( token ) )
+			{
+				// Ignores log-related (argument-less) options.
+				tokenEaten = true ;
+			}
+
+
+			if ( ! tokenEaten )
+			{
+
+				if ( token.empty() || token[0] == '-' )
+				{
+
+					cerr << "Unexpected command line argument: '" + token
+						+ "'.\n" + getUsage( argv[0] ) << endl ;
+					exit( 1 ) ;
+
+				}
+
+				inputFilenames.push_back( token ) ;
+
+			}
+
+		}
+
+
+		if ( inputFilenames.empty() )
+		{
+
+			cerr << "Error, no image file specified.\n"
+				+ getUsage( argv[0] ) << endl ;
+
+			exit( 2 ) ;
+
+		}
+
+
+		// Same masks as the ones SDL_DisplayFormat* would choose by default:
+		Pixels::ColorMask redMask   = 0x00ff0000 ;
+		Pixels::ColorMask greenMask = 0x0000ff00 ;
+		Pixels::ColorMask blueMask  = 0x000000ff ;
+		Pixels::ColorMask alphaMask = 0 ;
+
+		if ( depth == 16 )
+		{
+
+			redMask   = 0xf800 ;
+			greenMask = 0x07e0 ;
+			blueMask  = 0x001f ;
+
+		}
+		else if ( depth == 32 && withAlpha )
+		{
+
+			alphaMask = 0xff000000 ;
+
+		}
+
+
+		for ( list<string>::const_iterator it = inputFilenames.begin();
+			it != inputFilenames.end(); it++ )
+		{
+
+			string outputFilename = getRawFilenameFor( *it ) ;
+
+			Surface & source = Surface::LoadImage( *it,
+				/* convertToDisplayFormat */ false ) ;
+
+			if ( keepFormat )
+			{
+
+				Image::SaveRaw( source, outputFilename, compress ) ;
+
+			}
+			else
+			{
+
+				// Zero-filled, hence transparent where the source has holes:
+				Surface converted( Surface::Software, source.getWidth(),
+					source.getHeight(), depth, redMask, greenMask, blueMask,
+					alphaMask ) ;
+
+				// The alpha coordinates of the source are copied, not blended:
+				source.setAlpha( /* flags */ 0, Pixels::AlphaOpaque ) ;
+
+				source.blitTo( converted ) ;
+
+				Image::SaveRaw( converted, outputFilename, compress ) ;
+
+			}
+
+			cout << "Generation of '" << outputFilename << "' from '" << *it
+				<< "' succeeded (" << File::GetSize( *it ) << " bytes, "
+				<< File::GetSize( outputFilename ) << " bytes once converted)."
+				<< endl ;
+
+			delete & source ;
+
+		}
+
+	}
+
+	catch ( const OSDL::Exception & e )
+	{
+		LogPlug::error( "OSDL exception caught: "
+			 + e.toString( Ceylan::high ) ) ;
+		return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const Ceylan::Exception & e )
+	{
+		LogPlug::error( "Ceylan exception caught: "
+			 + e.toString( Ceylan::high ) ) ;
+		return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const std::exception & e )
+	{
+		LogPlug::error( "Standard exception caught: "
+			 + std::string( e.what() ) ) ;
+		return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( ... )
+	{
+		LogPlug::error( "Unknown exception caught" ) ;
+		return Ceylan::ExitFailure ;
+
+	}
+
+	return Ceylan::ExitSuccess ;
+
+}
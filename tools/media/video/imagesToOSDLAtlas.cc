@@ -0,0 +1,851 @@
+/*
+ * Copyright (C) 2003-2013 Olivier Boudeville
+ *
+ * This file is part of the OSDL library.
+ *
+ * The OSDL library is free software: you can redistribute it and/or modify
+ * it under the terms of either the GNU Lesser General Public License or
+ * the GNU General Public License, as they are published by the Free Software
+ * Foundation, either version 3 of these Licenses, or (at your option)
+ * any later version.
+ *
+ * The OSDL library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License and the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License and of the GNU General Public License along with the OSDL library.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Olivier Boudeville (olivier.boudeville@esperide.com)
+ *
+ */
+
+
+#include "OSDL.h"
+using namespace OSDL ;
+using namespace OSDL::Video ;
+using namespace OSDL::Video::TwoDimensional ;
+
+
+using namespace Ceylan ;
+using namespace Ceylan::Log ;
+using namespace Ceylan::System ;
+
+using namespace std ;
+
+
+
+#include <iostream>  // for cout
+#include <vector>
+#include <algorithm> // for sort
+
+
+const std::string Usage = " [ -o basename ] [ -s size ] [ -e extrusion ] [ -t ] X.png [ Y.png ... ]\nPacks the specified images into the pages of an OSDL image atlas: the pages are PNG images (basename-0.png, basename-1.png, etc.) and the atlas index (basename.osdl.atlas) tells where each image lies (see ImageAtlas and ResourceManager::registerImageAtlas). Images are packed thanks to the MaxRects algorithm (best short side fit), larger ones first."
+	"\n\t -o: specifies the base name of the generated files, possibly with a directory (default: 'atlas')."
+	"\n\t -s: specifies the maximum width and height of pages, in pixels (default: 1024). Each page is then shrunk to the area actually used."
+	"\n\t -e: specifies how many pixels the borders of each image are repeated around it, to avoid bleeding when filtering (default: 1)."
+	"\n\t -t: trims the fully transparent borders of images, so that they take less room in pages (default: not trimmed). The surface of a trimmed image is then smaller than the original one, and offset by the trimmed borders; such images are registered by ResourceManager::registerImageAtlas only if explicitly accepted."
+	"\nImages are referenced in the index by the path they are given here, which should be the one they have in the resource map."
+	;
+
+
+
+std::string getUsage( const std::string & execName ) throw()
+{
+
+	return "Usage: " + execName + Usage ;
+
+}
+
+
+
+/// A rectangle of a page, in pixels.
+struct PackedArea
+{
+
+	Length x ;
+	Length y ;
+	Length width ;
+	Length height ;
+
+} ;
+
+
+
+/**
+ * Packs rectangles in a page thanks to the MaxRects algorithm.
+ *
+ * The free space of the page is described by the list of the maximal free
+ * rectangles, which may overlap. A new rectangle is placed where it leaves the
+ * shortest leftover side (best short side fit), then each free rectangle it
+ * intersects is split into up to four maximal ones, and the free rectangles
+ * contained in others are pruned.
+ *
+ * @see "A Thousand Ways to Pack the Bin", Jukka Jylanki, 2010.
+ *
+ */
+class MaxRectsPage
+{
+
+	public:
+
+
+		MaxRectsPage( Length width, Length height ) :
+			_usedWidth( 0 ),
+			_usedHeight( 0 )
+		{
+
+			PackedArea whole = { 0, 0, width, height } ;
+			_free.push_back( whole ) ;
+
+		}
+
+
+
+		/**
+		 * Places a rectangle of specified size, and returns true iff it could
+		 * be placed, then setting its location.
+		 *
+		 */
+		bool insert( Length width, Length height, PackedArea & placed )
+		{
+
+			Ceylan::Uint32 bestShortSide = 0xffffffff ;
+			Ceylan::Uint32 bestLongSide  = 0xffffffff ;
+
+			bool found = false ;
+
+			for ( vector<PackedArea>::const_iterator it = _free.begin();
+				it != _free.end(); it++ )
+			{
+
+				if ( (*it).width < width || (*it).height < height )
+					continue ;
+
+				Ceylan::Uint32 leftoverX = (*it).width - width ;
+				Ceylan::Uint32 leftoverY = (*it).height - height ;
+
+				Ceylan::Uint32 shortSide = min( leftoverX, leftoverY ) ;
+				Ceylan::Uint32 longSide  = max( leftoverX, leftoverY ) ;
+
+				if ( shortSide < bestShortSide
+					|| ( shortSide == bestShortSide && longSide < bestLongSide ) )
+				{
+
+					placed.x      = (*it).x ;
+					placed.y      = (*it).y ;
+					placed.width  = width ;
+					placed.height = height ;
+
+					bestShortSide = shortSide ;
+					bestLongSide  = longSide ;
+
+					found = true ;
+
+				}
+
+			}
+
+			if ( ! found )
+				return false ;
+
+			vector<PackedArea> stillFree ;
+
+			for ( vector<PackedArea>::const_iterator it = _free.begin();
+				it != _free.end(); it++ )
+				split( *it, placed, stillFree ) ;
+
+			_free.swap( stillFree ) ;
+
+			prune() ;
+
+			_usedWidth  = max<Length>( _usedWidth, placed.x + placed.width ) ;
+			_usedHeight = max<Length>( _usedHeight, placed.y + placed.height ) ;
+
+			return true ;
+
+		}
+
+
+
+		/// Returns the width actually used by placed rectangles.
+		Length getUsedWidth() const
+		{
+
+			return _usedWidth ;
+
+		}
+
+
+
+		/// Returns the height actually used by placed rectangles.
+		Length getUsedHeight() const
+		{
+
+			return _usedHeight ;
+
+		}
+
+
+
+	private:
+
+
+
+		/**
+		 * Adds to specified list the maximal free rectangles remaining from
+		 * the free one once the placed one is removed from it.
+		 *
+		 */
+		static void split( const PackedArea & free, const PackedArea & placed,
+			vector<PackedArea> & result )
+		{
+
+			Ceylan::Uint32 freeRight    = free.x + free.width ;
+			Ceylan::Uint32 freeBottom   = free.y + free.height ;
+			Ceylan::Uint32 placedRight  = placed.x + placed.width ;
+			Ceylan::Uint32 placedBottom = placed.y + placed.height ;
+
+			// No intersection, kept as is:
+			if ( placed.x >= freeRight || placedRight <= free.x
+				|| placed.y >= freeBottom || placedBottom <= free.y )
+			{
+
+				result.push_back( free ) ;
+				return ;
+
+			}
+
+			if ( placed.x > free.x )
+			{
+
+				PackedArea left = { free.x, free.y,
+					static_cast<Length>( placed.x - free.x ), free.height } ;
+
+				result.push_back( left ) ;
+
+			}
+
+			if ( placedRight < freeRight )
+			{
+
+				PackedArea right = { static_cast<Length>( placedRight ), free.y,
+					static_cast<Length>( freeRight - placedRight ),
+					free.height } ;
+
+				result.push_back( right ) ;
+
+			}
+
+			if ( placed.y > free.y )
+			{
+
+				PackedArea top = { free.x, free.y, free.width,
+					static_cast<Length>( placed.y - free.y ) } ;
+
+				result.push_back( top ) ;
+
+			}
+
+			if ( placedBottom < freeBottom )
+			{
+
+				PackedArea bottom = { free.x,
+					static_cast<Length>( placedBottom ), free.width,
+					static_cast<Length>( freeBottom - placedBottom ) } ;
+
+				result.push_back( bottom ) ;
+
+			}
+
+		}
+
+
+
+		/// Tells whether the first rectangle is contained in the second.
+		static bool isContainedIn( const PackedArea & inner,
+			const PackedArea & outer )
+		{
+
+			return inner.x >= outer.x && inner.y >= outer.y
+				&& inner.x + inner.width <= outer.x + outer.width
+				&& inner.y + inner.height <= outer.y + outer.height ;
+
+		}
+
+
+
+		/// Removes the free rectangles contained in other ones.
+		void prune()
+		{
+
+			vector<bool> removed( _free.size(), false ) ;
+
+			for ( vector<PackedArea>::size_type i = 0; i < _free.size(); i++ )
+			{
+
+				if ( removed[i] )
+					continue ;
+
+				for ( vector<PackedArea>::size_type j = 0; j < _free.size();
+					j++ )
+				{
+
+					if ( i == j || removed[j] )
+						continue ;
+
+					if ( isContainedIn( _free[j], _free[i] ) )
+						removed[j] = true ;
+
+				}
+
+			}
+
+			vector<PackedArea> kept ;
+
+			for ( vector<PackedArea>::size_type i = 0; i < _free.size(); i++ )
+				if ( ! removed[i] )
+					kept.push_back( _free[i] ) ;
+
+			_free.swap( kept ) ;
+
+		}
+
+
+
+		/// The maximal free rectangles.
+		vector<PackedArea> _free ;
+
+		Length _usedWidth ;
+		Length _usedHeight ;
+
+} ;
+
+
+
+/// An image to pack, once converted and trimmed.
+struct ImageToPack
+{
+
+	string filename ;
+
+	// 32-bit, with an alpha channel:
+	Surface * converted ;
+
+	// The area of the converted image to pack:
+	Length trimX ;
+	Length trimY ;
+	Length width ;
+	Length height ;
+
+	Ceylan::Uint16 page ;
+	PackedArea slot ;
+
+} ;
+
+
+
+/// Larger images are packed first, as they are the hardest to place.
+bool isLargerThan( const ImageToPack * first, const ImageToPack * second )
+{
+
+	Length firstSide  = max( first->width, first->height ) ;
+	Length secondSide = max( second->width, second->height ) ;
+
+	if ( firstSide != secondSide )
+		return firstSide > secondSide ;
+
+	return first->width * first->height > second->width * second->height ;
+
+}
+
+
+
+/// Returns the 32-bit pixel at specified location of a locked surface.
+inline Ceylan::Uint32 getPixel32( const Surface & surface, Length x, Length y )
+{
+
+	return static_cast<const Ceylan::Uint32 *>( surface.getPixels() )[
+		y * ( surface.getPitch() / 4 ) + x ] ;
+
+}
+
+
+
+/**
+ * Determines the smallest area of specified image holding all its pixels that
+ * are not fully transparent.
+ *
+ */
+void trim( ImageToPack & image, Pixels::ColorMask alphaMask )
+{
+
+	Surface & surface = * image.converted ;
+
+	Length width  = surface.getWidth() ;
+	Length height = surface.getHeight() ;
+
+	Length minX = width ;
+	Length minY = height ;
+	Length maxX = 0 ;
+	Length maxY = 0 ;
+
+	surface.lock() ;
+
+	for ( Length y = 0; y < height; y++ )
+		for ( Length x = 0; x < width; x++ )
+			if ( ( getPixel32( surface, x, y ) & alphaMask ) != 0 )
+			{
+
+				minX = min( minX, x ) ;
+				maxX = max( maxX, x ) ;
+				minY = min( minY, y ) ;
+				maxY = max( maxY, y ) ;
+
+			}
+
+	surface.unlock() ;
+
+	// Fully transparent images still need a (single pixel) area:
+	if ( minX > maxX )
+	{
+
+		minX = 0 ;
+		maxX = 0 ;
+		minY = 0 ;
+		maxY = 0 ;
+
+	}
+
+	image.trimX  = minX ;
+	image.trimY  = minY ;
+	image.width  = maxX - minX + 1 ;
+	image.height = maxY - minY + 1 ;
+
+}
+
+
+
+/**
+ * Copies the area to pack of specified image in its slot of specified page,
+ * repeating its borders over the extrusion.
+ *
+ */
+void copyToPage( const ImageToPack & image, Surface & page, Length extrusion )
+{
+
+	const Surface & source = * image.converted ;
+
+	Ceylan::Uint32 * target = static_cast<Ceylan::Uint32 *>( page.getPixels() ) ;
+
+	Ceylan::Uint32 targetStride = page.getPitch() / 4 ;
+
+	for ( Length slotY = 0; slotY < image.slot.height; slotY++ )
+	{
+
+		// Clamped to the area, so that borders are repeated:
+		Length y = ( slotY < extrusion ) ? 0 : slotY - extrusion ;
+
+		if ( y >= image.height )
+			y = image.height - 1 ;
+
+		Ceylan::Uint32 * targetRow = target
+			+ ( image.slot.y + slotY ) * targetStride + image.slot.x ;
+
+		for ( Length slotX = 0; slotX < image.slot.width; slotX++ )
+		{
+
+			Length x = ( slotX < extrusion ) ? 0 : slotX - extrusion ;
+
+			if ( x >= image.width )
+				x = image.width - 1 ;
+
+			targetRow[ slotX ] = getPixel32( source, image.trimX + x,
+				image.trimY + y ) ;
+
+		}
+
+	}
+
+}
+
+
+
+int main( int argc, char * argv[] )
+{
+
+
+	string basename = "atlas" ;
+
+	Length pageSize = 1024 ;
+
+	Length extrusion = 1 ;
+
+	bool trimmed = false ;
+
+	LogHolder myLog( argc, argv ) ;
+
+	vector<ImageToPack> images ;
+
+
+	try
+	{
+
+
+		LogPlug::info( "Packing images into an OSDL image atlas." ) ;
+
+
+		std::string executableName ;
+		std::list<std::string> options ;
+
+		Ceylan::parseCommandLineOptions( executableName, options, argc, argv ) ;
+
+		std::string token ;
+		bool tokenEaten ;
+
+		list<string> inputFilenames ;
+
+		while ( ! options.empty() )
+		{
+
+			token = options.front() ;
+			options.pop_front() ;
+
+			tokenEaten = false ;
+
+
+			if ( token == "-o" || token == "-s" || token == "-e" )
+			{
+
+				if ( options.empty() )
+				{
+
+					cerr << "Error, parameter lacking for option " + token
+						+ ".\n" + getUsage( argv[0] ) << endl ;
+
+					exit( 9 ) ;
+
+				}
+
+				string value = options.front() ;
+				options.pop_front() ;
+
+				if ( token == "-o" )
+				{
+
+					basename = value ;
+
+				}
+				else
+				{
+
+					unsigned long number = Ceylan::stringToUnsignedLong(
+						value ) ;
+
+					if ( number > 16384 || ( token == "-s" && number == 0 ) )
+					{
+
+						cerr << "Error, invalid value for option " + token
+							+ ": " + value + ".\n" + getUsage( argv[0] )
+							<< endl ;
+
+						exit( 10 ) ;
+
+					}
+
+					if ( token == "-s" )
+						pageSize = static_cast<Length>( number ) ;
+					else
+						extrusion = static_cast<Length>( number ) ;
+
+				}
+
+				tokenEaten = true ;
+
+			}
+
+
+			if ( token == "-t" )
+			{
+
+				LogPlug::info( "Images will be trimmed." ) ;
+				trimmed = true ;
+				tokenEaten = true ;
+
+			}
+
+
+			if ( LogHolder::IsAKnownPlugOption( token ) )
+			{
+				// Ignores log-related (argument-less) options.
+				tokenEaten = true ;
+			}
+
+
+			if ( ! tokenEaten )
+			{
+
+				if ( token.empty() || token[0] == '-' )
+				{
+
+					cerr << "Unexpected command line argument: '" + token
+						+ "'.\n" + getUsage( argv[0] ) << endl ;
+					exit( 1 ) ;
+
+				}
+
+				inputFilenames.push_back( token ) ;
+
+			}
+
+		}
+
+
+		if ( inputFilenames.empty() )
+		{
+
+			cerr << "Error, no image file specified.\n"
+				+ getUsage( argv[0] ) << endl ;
+
+			exit( 2 ) ;
+
+		}
+
+
+		// All pages are 32-bit, with an alpha channel:
+		const Pixels::ColorMask redMask   = 0x00ff0000 ;
+		const Pixels::ColorMask greenMask = 0x0000ff00 ;
+		const Pixels::ColorMask blueMask  = 0x000000ff ;
+		const Pixels::ColorMask alphaMask = 0xff000000 ;
+
+		images.reserve( inputFilenames.size() ) ;
+
+		for ( list<string>::const_iterator it = inputFilenames.begin();
+			it != inputFilenames.end(); it++ )
+		{
+
+			Surface & source = Surface::LoadImage( *it,
+				/* convertToDisplayFormat */ false ) ;
+
+			ImageToPack image ;
+
+			image.filename  = *it ;
+			image.converted = new Surface( Surface::Software,
+				source.getWidth(), source.getHeight(), 32, redMask, greenMask,
+				blueMask, alphaMask ) ;
+
+			images.push_back( image ) ;
+
+			// Alpha coordinates are copied, colorkeyed pixels left transparent:
+			source.setAlpha( /* flags */ 0, Pixels::AlphaOpaque ) ;
+			source.blitTo( * image.converted ) ;
+
+			delete & source ;
+
+			ImageToPack & added = images.back() ;
+
+			if ( trimmed )
+			{
+
+				trim( added, alphaMask ) ;
+
+			}
+			else
+			{
+
+				added.trimX  = 0 ;
+				added.trimY  = 0 ;
+				added.width  = added.converted->getWidth() ;
+				added.height = added.converted->getHeight() ;
+
+			}
+
+			if ( added.width + 2 * extrusion > pageSize
+				|| added.height + 2 * extrusion > pageSize )
+			{
+
+				cerr << "Error, image '" << *it << "' does not fit in a "
+					<< pageSize << "x" << pageSize << " page." << endl ;
+
+				exit( 11 ) ;
+
+			}
+
+		}
+
+
+		vector<ImageToPack *> packingOrder ;
+
+		for ( vector<ImageToPack>::iterator it = images.begin();
+			it != images.end(); it++ )
+			packingOrder.push_back( & (*it) ) ;
+
+		sort( packingOrder.begin(), packingOrder.end(), isLargerThan ) ;
+
+		vector<MaxRectsPage> pages ;
+
+		for ( vector<ImageToPack *>::iterator it = packingOrder.begin();
+			it != packingOrder.end(); it++ )
+		{
+
+			ImageToPack & image = * (*it) ;
+
+			Length slotWidth  = image.width + 2 * extrusion ;
+			Length slotHeight = image.height + 2 * extrusion ;
+
+			bool placed = false ;
+
+			for ( vector<MaxRectsPage>::size_type i = 0; i < pages.size(); i++ )
+			{
+
+				if ( pages[i].insert( slotWidth, slotHeight, image.slot ) )
+				{
+
+					image.page = static_cast<Ceylan::Uint16>( i ) ;
+					placed = true ;
+					break ;
+
+				}
+
+			}
+
+			if ( ! placed )
+			{
+
+				pages.push_back( MaxRectsPage( pageSize, pageSize ) ) ;
+
+				pages.back().insert( slotWidth, slotHeight, image.slot ) ;
+
+				image.page = static_cast<Ceylan::Uint16>( pages.size() - 1 ) ;
+
+			}
+
+		}
+
+
+		// Page filenames are stored relative to the directory of the index:
+		string::size_type slashPos = basename.rfind( '/' ) ;
+
+		string relativeBasename = ( slashPos == string::npos ) ?
+			basename : basename.substr( slashPos + 1 ) ;
+
+		vector<string> pageFilenames ;
+
+		for ( vector<MaxRectsPage>::size_type i = 0; i < pages.size(); i++ )
+		{
+
+			// Zero-filled, hence transparent between slots:
+			Surface page( Surface::Software, pages[i].getUsedWidth(),
+				pages[i].getUsedHeight(), 32, redMask, greenMask, blueMask,
+				alphaMask ) ;
+
+			page.lock() ;
+
+			for ( vector<ImageToPack>::const_iterator it = images.begin();
+				it != images.end(); it++ )
+			{
+
+				if ( (*it).page != i )
+					continue ;
+
+				(*it).converted->lock() ;
+				copyToPage( *it, page, extrusion ) ;
+				(*it).converted->unlock() ;
+
+			}
+
+			page.unlock() ;
+
+			string pageSuffix = "-" + Ceylan::toString( i ) + ".png" ;
+
+			Image::SavePNG( page, basename + pageSuffix ) ;
+
+			pageFilenames.push_back( relativeBasename + pageSuffix ) ;
+
+			cout << "Page '" << basename + pageSuffix << "' generated ("
+				<< page.getWidth() << "x" << page.getHeight() << ")." << endl ;
+
+		}
+
+
+		// Entries are listed in the order the images were specified:
+		vector<AtlasEntry> entries ;
+
+		Ceylan::Uint32 packedPixels = 0 ;
+
+		for ( vector<ImageToPack>::const_iterator it = images.begin();
+			it != images.end(); it++ )
+		{
+
+			AtlasEntry entry ;
+
+			entry.name           = (*it).filename ;
+			entry.page           = (*it).page ;
+			entry.x              = (*it).slot.x + extrusion ;
+			entry.y              = (*it).slot.y + extrusion ;
+			entry.width          = (*it).width ;
+			entry.height         = (*it).height ;
+			entry.trimX          = (*it).trimX ;
+			entry.trimY          = (*it).trimY ;
+			entry.originalWidth  = (*it).converted->getWidth() ;
+			entry.originalHeight = (*it).converted->getHeight() ;
+
+			entries.push_back( entry ) ;
+
+			packedPixels += (*it).width * (*it).height ;
+
+		}
+
+		string indexFilename = basename + ImageAtlas::IndexExtension ;
+
+		ImageAtlas::SaveIndex( indexFilename, pageFilenames, entries ) ;
+
+		cout << "Atlas index '" << indexFilename << "' generated: "
+			<< images.size() << " images (" << packedPixels
+			<< " pixels" << ( trimmed ? " once trimmed" : "" )
+			<< ") packed in " << pages.size()
+			<< " page(s)." << endl ;
+
+		for ( vector<ImageToPack>::iterator it = images.begin();
+			it != images.end(); it++ )
+			delete (*it).converted ;
+
+	}
+
+	catch ( const OSDL::Exception & e )
+	{
+		LogPlug::error( "OSDL exception caught: "
+			 + e.toString( Ceylan::high ) ) ;
+		return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const Ceylan::Exception & e )
+	{
+		LogPlug::error( "Ceylan exception caught: "
+			 + e.toString( Ceylan::high ) ) ;
+		return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( const std::exception & e )
+	{
+		LogPlug::error( "Standard exception caught: "
+			 + std::string( e.what() ) ) ;
+		return Ceylan::ExitFailure ;
+
+	}
+
+	catch ( ... )
+	{
+		LogPlug::error( "Unknown exception caught" ) ;
+		return Ceylan::ExitFailure ;
+
+	}
+
+	return Ceylan::ExitSuccess ;
+
+}